@@ -0,0 +1,104 @@
+/**
+ *  \file       bmpImage.h
+ *  \brief      Random access to a BMP image on the SDcard through an open image handle.
+ *  The helpers of bitmap.h open the file and seek from its start on every call. An image handle keeps
+ *  the file open and, when the caller gives a buffer for it, the cluster link map of the file, so reading
+ *  a pixel or a part of a row seeks without walking the FAT.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup BMP_IMAGE_API BMP Image API
+ * @{
+ */
+
+#include "fatFs.h"
+#include "bitmap.h"
+
+#define BMP_IMAGE_READ_SIZE         48    /**< Bytes read from the file at once by bmpImageReadPixels(), multiple of 2 and 3 */
+#define BMP_IMAGE_LINK_MAP_SIZE(n)  (2 * (n) + 2) /**< Link map items for a file with n fragments */
+
+/** Open image handle */
+typedef struct
+{
+    FsFile file;                            /**< Image file */
+    BmpHeader header;                       /**< Header of the image */
+    PFdword* linkMap;                       /**< Cluster link map of the file, NULL to seek through the FAT */
+    PFword bytesPerPixel;                   /**< Bytes per pixel in the file, 2 or 3 */
+    PFdword rowSize;                        /**< Bytes per row in the file including padding */
+    PFEnBoolean topDown;                    /**< Rows stored top row first, the header height is made positive */
+}BmpImage;
+
+/**
+ * To open an image. A 16 or 24 bit uncompressed image can be opened, stored bottom row first or, with
+ * a negative height in the header, top row first.
+ *
+ * \param image     pointer to image handle
+ * \param fileName  path of the bmp image file
+ * \param linkMap   buffer for the cluster link map of the file, NULL to seek without it
+ * \param mapSize   size of the link map buffer in items, see BMP_IMAGE_LINK_MAP_SIZE
+ *
+ * \return status:
+ *       enStatusSuccess      - image opened, if the file has more fragments than the link map can
+ *                              hold the image is opened without a link map
+ *       enStatusNotSupported - pixel format is not supported
+ *       other                - error in accessing the file
+ */
+PFEnStatus bmpImageOpen(BmpImage* image, const PFchar* fileName, PFdword* linkMap, PFdword mapSize);
+
+/**
+ * To read pixels from a row of an image, converted to RGB format like bmpPickColor().
+ *
+ * \param image     pointer to open image handle
+ * \param x         x coordinate of the first pixel, counted from the left of the image
+ * \param y         y coordinate of the row, counted from the top of the image
+ * \param count     number of pixels to read, they should lie in the row
+ * \param pixels    pointer to an array to load the pixels
+ *
+ * \return status
+ */
+PFEnStatus bmpImageReadPixels(BmpImage* image, PFword x, PFword y, PFword count, PFword* pixels);
+
+/**
+ * To read a pixel of an image, same as bmpPickColor() on an open image
+ *
+ * \param image     pointer to open image handle
+ * \param x         x coordinate of the pixel
+ * \param y         y coordinate of the pixel
+ * \param color     pointer to load the pixel color in RGB format
+ *
+ * \return status
+ */
+PFEnStatus bmpImagePickColor(BmpImage* image, PFword x, PFword y, PFword* color);
+
+/**
+ * To draw an image on the LCD screen. The pixel data is forwarded from the file system window to the
+ * LCD as it is read, without a row buffer. For an image stored bottom row first the LCD address counter
+ * is set to run upwards, so the rows are written in file order. The image should fit on the screen.
+ *
+ * \param image     pointer to open image handle
+ * \param x         x coordinate on LCD screen to draw the image
+ * \param y         y coordinate on LCD screen to draw the image
+ *
+ * \return status, enStatusNotSupported if the screen orientation is not enGfxOrientation_0
+ */
+PFEnStatus bmpImageDraw(BmpImage* image, PFword x, PFword y);
+
+/**
+ * To close an image
+ *
+ * \param image     pointer to open image handle
+ *
+ * \return status
+ */
+PFEnStatus bmpImageClose(BmpImage* image);
+
+/** @} */
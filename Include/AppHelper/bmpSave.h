@@ -0,0 +1,128 @@
+/**
+ *  \file       bmpSave.h
+ *  \brief      Incremental BMP save of a screen area to the SDcard.
+ *  The area is read back from the LCD, or from another copy of the screen such as the shadow canvas,
+ *  one row at a time, bottom row first, and written with
+ *  the same 16 bit BMP layout as saveImage(). Each call to bmpSaveStep() captures a few rows, so the
+ *  application can handle touch input between steps. Data is written in chunks of whole sectors at
+ *  sector aligned file offsets, which lets the file system write them directly as multiple block writes.
+ *  A step which fails keeps its position and can be called again to retry.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup BMP_SAVE_API BMP Save API
+ * @{
+ */
+
+#include "fatFs.h"
+
+#define BMP_SAVE_CHUNK_SIZE         1024  /**< Bytes written per file write, should be a multiple of the sector size */
+#define BMP_SAVE_MAX_WIDTH          240   /**< Maximum width of the saved area in pixels */
+#define BMP_SAVE_BITS_PER_PIXEL     16    /**< Pixel format of the file, same as saveImage() */
+#define BMP_SAVE_HEADER_SIZE        54    /**< Size of the file and info headers */
+#define BMP_SAVE_NAME_SIZE          16    /**< Size of the file name buffer */
+
+/** State of a save job */
+typedef enum
+{
+    enBmpSaveIdle = 0,                      /**< No save started */
+    enBmpSaveRunning,                       /**< Rows are being captured and written */
+    enBmpSaveDone,                          /**< File is complete and closed */
+    enBmpSaveFailed,                        /**< Save was aborted */
+}BmpSaveState;
+
+/** Configuration structure for a save job */
+typedef struct
+{
+    PFword x;                               /**< X-coordinate of left-top pixel of the area */
+    PFword y;                               /**< Y-coordinate of left-top pixel of the area */
+    PFword width;                           /**< Width of the area, up to BMP_SAVE_MAX_WIDTH */
+    PFword height;                          /**< Height of the area */
+    PFword rowsPerStep;                     /**< Rows captured by one call to bmpSaveStep() */
+    const PFchar* fileName;                 /**< File name, NULL to use the first free image_<n>.bmp as saveImage() does */
+    PFEnStatus (*readPixels)(PFword x, PFword y, PFword count, PFword* pixels);   /**< Source of the rows, NULL to read back the LCD */
+}CfgBmpSave;
+
+/** pointer to structure CfgBmpSave */
+typedef CfgBmpSave* pCfgBmpSave;
+
+/** Progress of a save job */
+typedef struct
+{
+    PFword rowsDone;                        /**< Rows written to the chunk buffer */
+    PFword rowsTotal;                       /**< Rows in the area */
+    PFbyte percent;                         /**< Rows done in percent */
+    PFdword bytesWritten;                   /**< Bytes written to the file */
+    PFdword fileSize;                       /**< Size of the complete file */
+    PFdword elapsedTicks;                   /**< Tick module ticks since the save was started */
+    PFdword bytesPerSecond;                 /**< Average throughput, tick period of 1 ms assumed */
+}BmpSaveProgress;
+
+/** Save job state, about 1.6 KB. Place it in AHB RAM to let the SDcard driver write the chunks by DMA. */
+typedef struct
+{
+    CfgBmpSave config;                      /**< Configuration of the job */
+    BmpSaveState state;                     /**< State of the job */
+    PFchar fileName[BMP_SAVE_NAME_SIZE];    /**< Name of the file being written */
+    FsFile file;                            /**< File being written */
+    PFword rowSize;                         /**< Bytes per row in the file including padding */
+    PFword rowsDone;                        /**< Rows completely copied to the chunk buffer */
+    PFword rowBytes;                        /**< Bytes of the current row already copied */
+    PFdword chunkFill;                      /**< Bytes in the chunk buffer */
+    PFdword chunkOffset;                    /**< File offset of the chunk buffer */
+    PFdword startTick;                      /**< Tick at which the save was started */
+    PFdword endTick;                        /**< Tick at which the save was completed */
+    PFword row[BMP_SAVE_MAX_WIDTH + 1];     /**< Pixels of the current row, one extra for the LCD readback */
+    PFbyte chunk[BMP_SAVE_CHUNK_SIZE];      /**< Data waiting to be written */
+}BmpSaveJob;
+
+/**
+ * To start a save job. The file is created and the header is prepared.
+ *
+ * \param job       pointer to job state
+ * \param config    pointer to configuration of the job, copied to the job
+ *
+ * \return status whether the file is created or not
+ */
+PFEnStatus bmpSaveStart(BmpSaveJob* job, pCfgBmpSave config);
+
+/**
+ * To capture and write the next rows of a save job. When a step fails, calling it again
+ * retries the failed write and continues from the same position.
+ *
+ * \param job       pointer to job state
+ *
+ * \return enStatusBusy while rows remain, enStatusSuccess when the file is complete,
+ *         other status if a step failed
+ */
+PFEnStatus bmpSaveStep(BmpSaveJob* job);
+
+/**
+ * To abort a save job. The incomplete file is deleted.
+ *
+ * \param job       pointer to job state
+ *
+ * \return status of abort
+ */
+PFEnStatus bmpSaveAbort(BmpSaveJob* job);
+
+/**
+ * To get the progress of a save job
+ *
+ * \param job       pointer to job state
+ * \param progress  pointer to structure to load the progress
+ *
+ * \return status
+ */
+PFEnStatus bmpSaveGetProgress(BmpSaveJob* job, BmpSaveProgress* progress);
+
+/** @} */
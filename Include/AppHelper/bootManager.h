@@ -0,0 +1,158 @@
+/**
+ *  \file       bootManager.h
+ *  \brief      Boot manager running the initialization of the devices in stages.
+ *  The application describes its devices in a table of stages. Foreground stages are run in order by
+ *  bootRunForeground() before the first frame is drawn. Background stages are run afterwards one per
+ *  call of bootRunBackground(), for example from a scheduler task, so that slow devices such as the
+ *  SDcard do not delay the first frame. Lazy stages are only run when the application needs the device
+ *  and calls bootRequire(), which also runs a background stage that has not run yet.
+ *  A required stage which fails stops the foreground boot. An optional stage which fails is only
+ *  recorded, the application checks bootRequire() before using the device and works without it.
+ *  The start and duration of every stage are recorded, as well as the time of the first frame.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup BOOT_MANAGER_API Boot Manager API
+ * @{
+ */
+
+#define BOOT_MAX_STAGES             16    /**< Maximum number of stages in the table */
+
+/** When a stage is run */
+typedef enum
+{
+    enBootModeForeground = 0,               /**< By bootRunForeground(), in table order */
+    enBootModeBackground,                   /**< By bootRunBackground() after the foreground stages, or bootRequire() */
+    enBootModeLazy                          /**< By bootRequire() only */
+}BootMode;
+
+/** State of a stage */
+typedef enum
+{
+    enBootStatePending = 0,                 /**< Not run yet */
+    enBootStateReady,                       /**< Run with success */
+    enBootStateFailed                       /**< Run with an error, it is not run again */
+}BootState;
+
+/** Description of a stage */
+typedef struct
+{
+    PFEnStatus (*init)(void);               /**< Initializes the devices of the stage */
+    BootMode mode;                          /**< When the stage is run */
+    PFEnBoolean required;                   /**< enBooleanTrue if the application cannot run without the stage */
+}BootStage;
+
+/** Configuration structure for the boot manager */
+typedef struct
+{
+    const BootStage* stages;                /**< Array of stages, the index of a stage is its id */
+    PFbyte stageCount;                      /**< Number of stages in the array, at most BOOT_MAX_STAGES */
+    PFdword (*timestamp)(void);             /**< Gives the time of a stage, for example pfIdleGetCycles. NULL to use the DWT cycle counter, which stops while the CPU sleeps */
+    void (*stageDone)(PFbyte stage, PFEnStatus status, PFdword duration);  /**< Called after each stage, may be NULL */
+}CfgBoot;
+
+/** pointer to structure CfgBoot */
+typedef CfgBoot* pCfgBoot;
+
+/** Record of a stage, times are timestamps counted from bootOpen() */
+typedef struct
+{
+    BootState state;                        /**< State of the stage */
+    PFEnStatus status;                      /**< Status returned by the init function */
+    PFdword start;                          /**< Time at which the stage was started */
+    PFdword duration;                       /**< Time taken by the init function */
+}BootStageInfo;
+
+/** Boot times, counted from bootOpen(), 0 until reached */
+typedef struct
+{
+    PFdword foreground;                     /**< End of the foreground stages */
+    PFdword firstFrame;                     /**< First frame, see bootMarkFirstFrame() */
+    PFdword background;                     /**< End of the background stages */
+}BootTimes;
+
+/**
+ * To initialize the boot manager. With the DWT cycle counter as timestamp the times are awake time
+ * only: they do not count the time the CPU sleeps in the idle function of the scheduler, so the
+ * background times, taken while the main loop runs, are short of the real time. The cycle counter is
+ * started when it gives the timestamps.
+ *
+ * \param config pointer to the configuration structure
+ *
+ * \return initialization status
+ */
+PFEnStatus bootOpen(pCfgBoot config);
+
+/**
+ * This function runs the foreground stages in table order. It stops at the first required stage which
+ * fails, optional stages which fail are skipped.
+ *
+ * \param failedStage loaded with the id of the required stage which failed, may be NULL
+ *
+ * \return status of the required stage which failed, otherwise enStatusSuccess
+ */
+PFEnStatus bootRunForeground(PFbyte* failedStage);
+
+/**
+ * This function runs the next background stage which has not run yet.
+ *
+ * \return return status:
+ *  enStatusBusy          - a stage was run and others are left, call again
+ *  enStatusSuccess       - all background stages have run
+ *  enStatusNotConfigured - boot manager is not initialized
+ */
+PFEnStatus bootRunBackground(void);
+
+/**
+ * This function makes sure a stage has run, it runs it if it is pending. It should be called before
+ * using the device of a lazy or background stage.
+ *
+ * \param stage id of the stage
+ *
+ * \return enStatusSuccess if the stage is ready, the status of its init function if it failed
+ */
+PFEnStatus bootRequire(PFbyte stage);
+
+/**
+ * This function tells whether a stage has run with success, without running it.
+ *
+ * \param stage id of the stage
+ *
+ * \return enBooleanTrue if the stage is ready
+ */
+PFEnBoolean bootIsReady(PFbyte stage);
+
+/**
+ * This function records the time of the first frame. Only the first call is recorded.
+ */
+void bootMarkFirstFrame(void);
+
+/**
+ * This function is used to get the record of a stage.
+ *
+ * \param stage id of the stage
+ * \param info pointer to structure to load the record
+ *
+ * \return return status
+ */
+PFEnStatus bootGetStageInfo(PFbyte stage, BootStageInfo* info);
+
+/**
+ * This function is used to get the boot times.
+ *
+ * \param times pointer to structure to load the times
+ *
+ * \return return status
+ */
+PFEnStatus bootGetTimes(BootTimes* times);
+
+/** @} */
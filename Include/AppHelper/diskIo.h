@@ -10,14 +10,27 @@
 /** Maximum disks supported for file system		*/
 #define MAX_DISK_SUPPORTED				4
 
+/** Sector size of the disks, the cache works on sectors of this size	*/
+#define DISK_SECTOR_SIZE				512
+
+/** Set to 1 to enable the write-back sector cache between the file system and the devices	*/
+#define DISK_USE_CACHE					1
+
+#if (DISK_USE_CACHE == 1)
+/** Number of sectors held by the cache, shared by all disks. The buffers are placed in AHB RAM	*/
+#define DISK_CACHE_SECTORS				8
+/** Maximum cache entries which may hold pinned (FAT) sectors, should be less than DISK_CACHE_SECTORS	*/
+#define DISK_CACHE_PIN_MAX				4
+#endif	// #if (DISK_USE_CACHE == 1)
+
 /** Disk configuration structure			*/
 typedef struct
 {
 	void* devConfig;																	/**< Device configuration structure			*/
 	PFEnStatus (*devOpen)(PFbyte* deviceId, pCfgMmc cfg);										/**< Pointer to device open function		*/
 	PFEnStatus (*devGetStatus)(PFbyte deviceId);												/**< Pointer to device get status function	*/
-	PFEnStatus (*devRead)(PFbyte deviceId, PFbyte* data, PFdword sector, PFbyte count);		/**< Pointer to device read function		*/
-	PFEnStatus (*devWrite)(PFbyte deviceId, const PFbyte* data, PFdword sector, PFbyte count);	/**< Pointer to device write function		*/
+	PFEnStatus (*devRead)(PFbyte deviceId, PFbyte* data, PFdword sector, PFdword count);		/**< Pointer to device read function		*/
+	PFEnStatus (*devWrite)(PFbyte deviceId, const PFbyte* data, PFdword sector, PFdword count);	/**< Pointer to device write function		*/
 	PFEnStatus (*devIoCtrl)(PFbyte deviceId, PFbyte cmd, void* arg);							/**< Pointer to device control function		*/
 	PFEnBoolean allowWrite;																/**< Set device write permission			*/
 	PFEnBoolean allowIoCtrl;															/**< Set device IO control permission		*/
@@ -26,6 +39,20 @@ typedef struct
 /** Pointer to CfgDisk structure		*/
 typedef CfgDisk*	pCfgDisk;
 
+/** Sector cache statistics of a disk	*/
+typedef struct
+{
+	PFdword readHits;					/**< Single sector reads served from the cache		*/
+	PFdword readMisses;					/**< Single sector reads which went to the device	*/
+	PFdword writeHits;					/**< Single sector writes to a cached sector		*/
+	PFdword writeMisses;				/**< Single sector writes which took a new cache entry	*/
+	PFdword devReads;					/**< Read requests made to the device				*/
+	PFdword devWrites;					/**< Write requests made to the device				*/
+	PFdword devSectorsRead;				/**< Sectors read from the device					*/
+	PFdword devSectorsWritten;			/**< Sectors written to the device					*/
+	PFdword evictions;					/**< Dirty sectors written back to make room		*/
+}DiskCacheStats;
+
 
 /*---------------------------------------*/
 /* Prototypes for disk control functions */
@@ -40,7 +67,8 @@ typedef CfgDisk*	pCfgDisk;
 PFEnStatus diskOpen(PFbyte* drive, pCfgDisk config);
 
 /**
- * Initialized the disk
+ * Initialized the disk. Dirty cached sectors are written back first if the device is ready,
+ * then the cache is emptied as the medium may have changed.
  *
  * \param drv Physical drive number (0, ...)
  *
@@ -63,11 +91,11 @@ PFEnStatus diskGetStatus(PFbyte drive);
  * \param drive Physical drive number (0, ...)
  * \param buff Data buffer to store read data
  * \param sector Sector address (LBA)
- * \param count Number of sectors to read (1..128) 
+ * \param count Number of sectors to read, transferred as one multiple block read
  *
  * \return status
  */
-PFEnStatus diskRead(PFbyte drive, PFbyte* buff, PFdword sector, PFbyte count);
+PFEnStatus diskRead(PFbyte drive, PFbyte* buff, PFdword sector, PFdword count);
 
 /**
  * Writes data to disk
@@ -75,14 +103,14 @@ PFEnStatus diskRead(PFbyte drive, PFbyte* buff, PFdword sector, PFbyte count);
  * \param drive Physical drive number (0, ...)
  * \param buff Data to write
  * \param sector Sector address (LBA)
- * \param count Number of sectors to write (1..128) 
+ * \param count Number of sectors to write, transferred as one multiple block write
  *
  * \return status
  */
-PFEnStatus diskWrite(PFbyte drive, const PFbyte *buff, PFdword sector, PFbyte count);
+PFEnStatus diskWrite(PFbyte drive, const PFbyte *buff, PFdword sector, PFdword count);
 
 /**
- * Disk configuration control
+ * Disk configuration control. CTRL_SYNC writes back the cache even if allowIoCtrl is not set.
  * \param drive	Physical drive number (0..)
  * \param cmd Control command
  * \param buff Buffer to send/receive control data
@@ -91,6 +119,49 @@ PFEnStatus diskWrite(PFbyte drive, const PFbyte *buff, PFdword sector, PFbyte co
  */
 PFEnStatus diskIoCtrl(PFbyte drive, PFbyte cmd, void* buff);
 
+#if (DISK_USE_CACHE == 1)
+/**
+ * Sets the sectors which are preferred to stay in the cache. diskInit() sets the range to the
+ * FAT area found in the boot sector, so this is needed only to override it.
+ *
+ * \param drive Physical drive number (0..)
+ * \param firstSector First sector of the range
+ * \param count Number of sectors in the range, 0 to clear
+ *
+ * \return status
+ */
+PFEnStatus diskCacheSetPinRange(PFbyte drive, PFdword firstSector, PFdword count);
+
+/**
+ * Writes the dirty cached sectors of a disk to the device. Consecutive sectors are
+ * written with one multiple block write. Also done on CTRL_SYNC.
+ *
+ * \param drive Physical drive number (0..)
+ *
+ * \return status
+ */
+PFEnStatus diskCacheFlush(PFbyte drive);
+
+/**
+ * Drops all cached sectors of a disk, dirty sectors are lost
+ *
+ * \param drive Physical drive number (0..)
+ *
+ * \return status
+ */
+PFEnStatus diskCacheInvalidate(PFbyte drive);
+
+/**
+ * Gets the cache statistics of a disk
+ *
+ * \param drive Physical drive number (0..)
+ * \param stats Pointer to structure to copy the statistics to
+ *
+ * \return status
+ */
+PFEnStatus diskCacheGetStats(PFbyte drive, DiskCacheStats* stats);
+#endif	// #if (DISK_USE_CACHE == 1)
+
 
 /* Command code for disk_ioctrl function */
 #define CTRL_SYNC			0	/* Mandatory for write functions */
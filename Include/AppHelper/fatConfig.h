@@ -45,8 +45,9 @@
 /** To enable fsFilePrint function, set FS_USE_MKFS to 1 and set FS_READONLY to 0 */
 #define	FS_USE_MKFS	0		/**< 0 or 1 */
 
-#define	FS_USE_FORWARD	0	/* 0 or 1 */
-/* To enable f_forward function, set FS_USE_FORWARD to 1 and set FS_TINY to 1. */
+#define	FS_USE_FORWARD	1	/* 0 or 1 */
+/* To enable f_forward function, set FS_USE_FORWARD to 1 and set FS_TINY to 1.
+   fsFileForward is not part of the prebuilt module, it is implemented in fatFsExt.c. */
 
 
 /*---------------------------------------------------------------------------/
@@ -594,6 +594,61 @@ PFEnStatus fsGetFreeClusters(const XCHAR *path, PFdword* nclst, FatFs** fatfs);
 PFEnStatus fsFileTruncate(FsFile* fp);
 #endif	// #if ((FS_READONLY == 0) && (FS_MINIMIZE == 0))
 
+/**
+ * The fsFileExpand function allocates a contiguous run of clusters to an empty file and sets the file size.
+ * Data written afterwards goes to consecutive sectors, so whole sectors are passed to the disk as multiple
+ * block writes and no cluster is allocated while writing. The FAT entries of the run are linked in one pass
+ * and the directory entry is updated by fsFileSync or fsFileClose.
+ * The data area of the file is not initialized.
+ *
+ * \param fp Pointer to the open file object, opened with write access and having size 0.
+ * \param size Size of the file in bytes.
+ *
+ * \return Status, enStatusAccessDenied if no contiguous run of free clusters is large enough
+ *
+ * \note Available when FS_READONLY = 0 and FS_MINIMIZE = 0. Implemented in fatFsExt.c.
+ */
+#if ((FS_READONLY == 0) && (FS_MINIMIZE == 0))
+PFEnStatus fsFileExpand(FsFile* fp, PFdword size);
+#endif	// #if ((FS_READONLY == 0) && (FS_MINIMIZE == 0))
+
+/**
+ * The fsFileLinkMap function builds the cluster link map of an open file in a buffer given by the caller.
+ * The map lists the fragments of the cluster chain, so fsFileSeekFast can find the cluster of any file offset
+ * without reading the FAT. The map is valid until the cluster chain of the file is changed.
+ * Layout of the buffer: map[0] is the number of PFdword items in the buffer, followed by one pair of
+ * (fragment length in clusters, first cluster) for each fragment and a 0 which ends the list.
+ * A file with N fragments needs 2 * N + 2 items.
+ *
+ * \param fp Pointer to the open file object.
+ * \param map Pointer to the map buffer, map[0] set to the size of the buffer in items.
+ * 			On return map[0] holds the number of items required.
+ *
+ * \return Status, enStatusNoMem if the buffer is too small
+ *
+ * \note Available when FS_READONLY = 0, FS_MINIMIZE = 0 and FS_TINY = 1. Implemented in fatFsExt.c.
+ */
+#if ((FS_READONLY == 0) && (FS_MINIMIZE == 0) && (FS_TINY == 1))
+PFEnStatus fsFileLinkMap(FsFile* fp, PFdword* map);
+#endif	// #if ((FS_READONLY == 0) && (FS_MINIMIZE == 0) && (FS_TINY == 1))
+
+/**
+ * The fsFileSeekFast function moves the file read/write pointer like fsFileSeek, using a map built by
+ * fsFileLinkMap to find the cluster instead of following the cluster chain from the start of the file.
+ * The file can not be expanded with this function, an offset beyond the end of the file is set to the end.
+ *
+ * \param fp Pointer to the open file object.
+ * \param map Pointer to the link map of the file.
+ * \param ofs Byte offset from top of the file.
+ *
+ * \return Status
+ *
+ * \note Available when FS_READONLY = 0, FS_MINIMIZE = 0 and FS_TINY = 1. Implemented in fatFsExt.c.
+ */
+#if ((FS_READONLY == 0) && (FS_MINIMIZE == 0) && (FS_TINY == 1))
+PFEnStatus fsFileSeekFast(FsFile* fp, const PFdword* map, PFdword ofs);
+#endif	// #if ((FS_READONLY == 0) && (FS_MINIMIZE == 0) && (FS_TINY == 1))
+
 /**
  * The fsFileDelete function removes a file or directory.
  * The object to be removed should satisfy the terms mentioned below:
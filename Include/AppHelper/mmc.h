@@ -43,11 +43,25 @@ typedef struct
     PFEnStatus (*spiExchangeByte)(PFbyte *id, PFbyte data, PFbyte* rxData);                  /**< Pointer to SPI exchange byte function */
 	PFEnStatus (*spiWrite)(PFbyte* id, PFbyte* data, PFdword size,  PFcallback delayCallback); /**< Function pointer to SPI write */
 	PFEnStatus (*spiRead)(PFbyte* id, PFbyte* data, PFdword size, PFdword* readBytes,   PFcallback delayCallback); /**< Function pointer to SPI read */
+	PFEnStatus (*spiYield)(PFbyte* id);                                                  /**< Pointer to SPI yield function, called between data blocks. May be NULL */
+	PFEnStatus (*spiDmaTransfer)(PFbyte* id, PFbyte* txData, PFbyte* rxData, PFdword size); /**< Pointer to SPI DMA block transfer function, used for sector data. May be NULL */
 }CfgMmc;
 
 /** \brief Pointer to CfgMmc structure */
 typedef CfgMmc* pCfgMmc;
 
+/** \brief MMC card transfer statistics */
+typedef struct
+{
+    PFdword commands;                   /**< Commands sent to the card, ACMD counted as two */
+    PFdword blocksRead;                 /**< Data blocks read */
+    PFdword blocksWritten;              /**< Data blocks written */
+    PFdword multiReads;                 /**< Multiple block read transactions (CMD18) */
+    PFdword multiWrites;                /**< Multiple block write transactions (CMD25) */
+    PFdword busyPolls;                  /**< Bytes clocked while waiting for the card to be ready */
+    PFdword tokenPolls;                 /**< Bytes clocked while waiting for a data start token */
+}MmcStats;
+
 /**
  * \brief Initialize mmc card with the given configuration.
  *
@@ -80,7 +94,7 @@ PFEnStatus mmcGetStatus(PFbyte deviceId);
  *
  * \return Status
  */
-PFEnStatus mmcRead(PFbyte deviceId, PFbyte *pBuf, PFdword sector, PFbyte uCount);
+PFEnStatus mmcRead(PFbyte deviceId, PFbyte *pBuf, PFdword sector, PFdword uCount);
 
 /**
  * \brief The function writes data to mmc card. Data from \a pBuf buffer is written to \a uCount sectors
@@ -93,7 +107,7 @@ PFEnStatus mmcRead(PFbyte deviceId, PFbyte *pBuf, PFdword sector, PFbyte uCount)
  *
  * \return Status
  */
-PFEnStatus mmcWrite (PFbyte deviceId, const PFbyte *pBuf, PFdword sector, PFbyte uCount);
+PFEnStatus mmcWrite (PFbyte deviceId, const PFbyte *pBuf, PFdword sector, PFdword uCount);
 
 /**
  * \brief Control function for device specific features.
@@ -106,6 +120,16 @@ PFEnStatus mmcWrite (PFbyte deviceId, const PFbyte *pBuf, PFdword sector, PFbyte
  */
 PFEnStatus mmcIoCtrl(PFbyte deviceId, PFbyte ctrl,    void *pBuf);
 
+/**
+ * \brief The function copies the transfer statistics of the mmc card.
+ *
+ * \param deviceId DeviceId of the mmc card
+ * \param stats Pointer to structure to copy the statistics to
+ *
+ * \return Status
+ */
+PFEnStatus mmcGetStats(PFbyte deviceId, MmcStats* stats);
+
 /** @} */
 
 
@@ -0,0 +1,184 @@
+/**
+ *  \file       pntImage.h
+ *  \brief      Native canvas image format (.pnt) with run-length and palette encoding.
+ *
+ *  A .pnt file holds a 12 byte header, an optional palette and the rows of the image from top to bottom.
+ *  Header: "PNT1", width (16 bit), height (16 bit), format (8 bit), palette size (8 bit), 2 reserved bytes,
+ *  all little endian. The palette holds palette size RGB565 colors.
+ *  Each row is coded on its own as packets. A packet starts with a control byte: bit 7 set is a run of
+ *  (control & 0x7F) + 1 pixels of one color, bit 7 clear is a literal of control + 1 pixels.
+ *  In enPntRle565 format a color is a 16 bit pixel; in enPntPalette format it is a palette index, one byte
+ *  for a run and two indices per byte, high nibble first, for a literal.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup PNT_IMAGE_API PNT Image API
+ * @{
+ */
+
+#include "fatFs.h"
+
+#define PNT_HEADER_SIZE             12    /**< Size of the file header */
+#define PNT_MAX_PALETTE             16    /**< Maximum colors of a palette image */
+#define PNT_MAX_PACKET              128   /**< Maximum pixels in one packet */
+#define PNT_BUFFER_SIZE             512   /**< Size of the encoder output buffer */
+#define PNT_READ_SIZE               64    /**< Bytes read from the file at once by the decoder */
+
+/** Pixel coding of a .pnt image */
+typedef enum
+{
+    enPntRle565 = 0,                        /**< Runs and literals of RGB565 pixels */
+    enPntPalette,                           /**< Runs and literals of palette indices */
+}PntFormat;
+
+/** Header of a .pnt image */
+typedef struct
+{
+    PFword width;                           /**< Width of the image */
+    PFword height;                          /**< Height of the image */
+    PntFormat format;                       /**< Pixel coding */
+    PFbyte paletteSize;                     /**< Colors in the palette, 0 for enPntRle565 */
+    PFword palette[PNT_MAX_PALETTE];        /**< Palette of the image */
+}PntHeader;
+
+/** Encoder state */
+typedef struct
+{
+    FsFile* file;                           /**< File being written */
+    PntHeader header;                       /**< Header of the image */
+    PFword rowsDone;                        /**< Rows encoded */
+    PFbyte lastIndex;                       /**< Palette index found last, checked first */
+    PFword outFill;                         /**< Bytes in the output buffer */
+    PFbyte out[PNT_BUFFER_SIZE];            /**< Encoded data waiting to be written */
+}PntEncoder;
+
+/**
+ * Callback which receives the decoded pixels in row order, top row first.
+ *
+ * \param context   context pointer passed to pntDecode()
+ * \param color     color of the span
+ * \param length    number of pixels of the span
+ *
+ * \return status, decoding stops if it is not success
+ */
+typedef PFEnStatus (*PntSpanWriter)(void* context, PFword color, PFword length);
+
+/**
+ * To collect the colors of some pixels into a palette
+ *
+ * \param pixels        pointer to pixels
+ * \param count         number of pixels
+ * \param palette       palette to add the colors to, PNT_MAX_PALETTE entries
+ * \param paletteSize   pointer to number of colors in the palette, updated
+ *
+ * \return status, enStatusNoMem if the pixels have more colors than the palette can hold
+ */
+PFEnStatus pntBuildPalette(const PFword* pixels, PFdword count, PFword* palette, PFbyte* paletteSize);
+
+/**
+ * To start encoding an image. The header is written to the file.
+ *
+ * \param encoder       pointer to encoder state
+ * \param file          pointer to file opened for writing
+ * \param width         width of the image
+ * \param height        height of the image
+ * \param palette       palette of the image for enPntPalette format, NULL for enPntRle565 format
+ * \param paletteSize   number of colors in the palette
+ *
+ * \return status
+ */
+PFEnStatus pntEncodeStart(PntEncoder* encoder, FsFile* file, PFword width, PFword height, const PFword* palette, PFbyte paletteSize);
+
+/**
+ * To encode the next rows of an image
+ *
+ * \param encoder       pointer to encoder state
+ * \param pixels        pointer to pixels of the rows, width pixels per row
+ * \param rows          number of rows
+ *
+ * \return status, enStatusInvArgs if a pixel is not in the palette
+ */
+PFEnStatus pntEncodeRows(PntEncoder* encoder, const PFword* pixels, PFword rows);
+
+/**
+ * To write the rest of the encoded data to the file. All the rows should have been encoded.
+ *
+ * \param encoder       pointer to encoder state
+ *
+ * \return status
+ */
+PFEnStatus pntEncodeFinish(PntEncoder* encoder);
+
+/**
+ * To read the header of an image
+ *
+ * \param file          pointer to file opened for reading, positioned at the start of the file
+ * \param header        pointer to structure to load the header
+ *
+ * \return status, enStatusNotSupported if the file is not a .pnt image
+ */
+PFEnStatus pntReadHeader(FsFile* file, PntHeader* header);
+
+/**
+ * To decode the pixels of an image. The file should be positioned after the header.
+ *
+ * \param file          pointer to file opened for reading
+ * \param header        pointer to header of the image
+ * \param writer        callback which receives the pixels
+ * \param context       context pointer passed to the callback
+ *
+ * \return status
+ */
+PFEnStatus pntDecode(FsFile* file, PntHeader* header, PntSpanWriter writer, void* context);
+
+/**
+ * To save an area of the LCD screen as a .pnt image. The area is read back in bands of rows.
+ * It is read twice when it has few enough colors for a palette image: once to collect the palette
+ * and once to encode it.
+ *
+ * \param x             x coordinate of the area
+ * \param y             y coordinate of the area
+ * \param width         width of the area
+ * \param height        height of the area
+ * \param fileName      path of the image file, an existing file is replaced
+ * \param encoder       pointer to encoder state
+ * \param band          pointer to an array for the pixels read back
+ * \param bandSize      size of the array in pixels, at least width
+ *
+ * \return status
+ */
+PFEnStatus pntSaveImage(PFword x, PFword y, PFword width, PFword height, const PFchar* fileName,
+                        PntEncoder* encoder, PFword* band, PFdword bandSize);
+
+/**
+ * To draw a .pnt image on the LCD screen
+ *
+ * \param fileName      path of the image file
+ * \param x             x coordinate on LCD screen to draw the image
+ * \param y             y coordinate on LCD screen to draw the image
+ *
+ * \return status
+ */
+PFEnStatus pntDrawImage(const PFchar* fileName, PFword x, PFword y);
+
+/**
+ * To load the pixels of a .pnt image into an array
+ *
+ * \param fileName      path of the image file
+ * \param buffer        pointer to an array of width * height pixels
+ * \param size          pointer to load the number of bytes loaded, NULL if not needed
+ *
+ * \return status
+ */
+PFEnStatus pntLoadImage(const PFchar* fileName, PFword* buffer, PFdword* size);
+
+/** @} */
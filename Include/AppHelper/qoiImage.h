@@ -0,0 +1,163 @@
+/**
+ *  \file       qoiImage.h
+ *  \brief      Streaming encoder and decoder for images in the QOI format.
+ *
+ *  QOI ("Quite OK Image") codes each pixel as a run, a reference into a 64 entry table of recently seen
+ *  colors, a small difference to the previous pixel or a full RGB value. Both directions need a fixed
+ *  amount of state and no row buffer, so images are streamed between the SDcard and the LCD.
+ *  Pixels are RGB565 on the application side; the encoder expands them to RGB888 by bit replication,
+ *  which the decoder truncates back, so an image saved from the screen is restored exactly.
+ *
+ *  A pixel which is neither a run, in the table nor close to the previous one takes 4 bytes against the
+ *  2 of RGB565, so noise and single pixel columns encode to about twice the raw size. qoiSaveImage() does
+ *  not fall back to another format, use pntSaveImage() or a BMP for such images.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup QOI_IMAGE_API QOI Image API
+ * @{
+ */
+
+#include "fatFs.h"
+
+#define QOI_HEADER_SIZE             14    /**< Size of the file header */
+#define QOI_END_MARKER_SIZE         8     /**< Size of the marker which ends the file */
+#define QOI_INDEX_SIZE              64    /**< Entries of the color table */
+#define QOI_BUFFER_SIZE             512   /**< Size of the encoder output buffer */
+#define QOI_READ_SIZE               64    /**< Bytes read from the file at once by the decoder */
+
+/** Header of a QOI image */
+typedef struct
+{
+    PFword width;                           /**< Width of the image */
+    PFword height;                          /**< Height of the image */
+    PFbyte channels;                        /**< 3 for RGB, 4 for RGBA; alpha is ignored when decoding */
+}QoiHeader;
+
+/** Encoder state */
+typedef struct
+{
+    FsFile* file;                           /**< File being written */
+    QoiHeader header;                       /**< Header of the image */
+    PFdword pixelsLeft;                     /**< Pixels still to be encoded */
+    PFdword previous;                       /**< Previous pixel as RGBA */
+    PFbyte run;                             /**< Length of the pending run */
+    PFword outFill;                         /**< Bytes in the output buffer */
+    PFdword index[QOI_INDEX_SIZE];          /**< Recently seen colors as RGBA */
+    PFbyte out[QOI_BUFFER_SIZE];            /**< Encoded data waiting to be written */
+}QoiEncoder;
+
+/**
+ * Callback which receives the decoded pixels in row order, top row first.
+ *
+ * \param context   context pointer passed to qoiDecode()
+ * \param color     RGB565 color of the span
+ * \param length    number of pixels of the span
+ *
+ * \return status, decoding stops if it is not success
+ */
+typedef PFEnStatus (*QoiSpanWriter)(void* context, PFword color, PFword length);
+
+/**
+ * To start encoding an image. The header is written to the file.
+ *
+ * \param encoder       pointer to encoder state
+ * \param file          pointer to file opened for writing
+ * \param width         width of the image
+ * \param height        height of the image
+ *
+ * \return status
+ */
+PFEnStatus qoiEncodeStart(QoiEncoder* encoder, FsFile* file, PFword width, PFword height);
+
+/**
+ * To encode the next pixels of an image, in row order
+ *
+ * \param encoder       pointer to encoder state
+ * \param pixels        pointer to RGB565 pixels
+ * \param count         number of pixels
+ *
+ * \return status
+ */
+PFEnStatus qoiEncodePixels(QoiEncoder* encoder, const PFword* pixels, PFdword count);
+
+/**
+ * To write the rest of the encoded data and the end marker to the file. All the pixels should have been encoded.
+ *
+ * \param encoder       pointer to encoder state
+ *
+ * \return status
+ */
+PFEnStatus qoiEncodeFinish(QoiEncoder* encoder);
+
+/**
+ * To read the header of an image
+ *
+ * \param file          pointer to file opened for reading, positioned at the start of the file
+ * \param header        pointer to structure to load the header
+ *
+ * \return status, enStatusNotSupported if the file is not a QOI image or is larger than 65535 pixels in a direction
+ */
+PFEnStatus qoiReadHeader(FsFile* file, QoiHeader* header);
+
+/**
+ * To decode the pixels of an image. The file should be positioned after the header.
+ *
+ * \param file          pointer to file opened for reading
+ * \param header        pointer to header of the image
+ * \param writer        callback which receives the pixels
+ * \param context       context pointer passed to the callback
+ *
+ * \return status
+ */
+PFEnStatus qoiDecode(FsFile* file, QoiHeader* header, QoiSpanWriter writer, void* context);
+
+/**
+ * To save an area of the LCD screen as a QOI image. The area is read back in bands of rows.
+ *
+ * \param x             x coordinate of the area
+ * \param y             y coordinate of the area
+ * \param width         width of the area
+ * \param height        height of the area
+ * \param fileName      path of the image file, an existing file is replaced
+ * \param encoder       pointer to encoder state
+ * \param band          pointer to an array for the pixels read back
+ * \param bandSize      size of the array in pixels, at least width
+ *
+ * \return status
+ */
+PFEnStatus qoiSaveImage(PFword x, PFword y, PFword width, PFword height, const PFchar* fileName,
+                        QoiEncoder* encoder, PFword* band, PFdword bandSize);
+
+/**
+ * To draw a QOI image on the LCD screen
+ *
+ * \param fileName      path of the image file
+ * \param x             x coordinate on LCD screen to draw the image
+ * \param y             y coordinate on LCD screen to draw the image
+ *
+ * \return status
+ */
+PFEnStatus qoiDrawImage(const PFchar* fileName, PFword x, PFword y);
+
+/**
+ * To load the pixels of a QOI image into an array
+ *
+ * \param fileName      path of the image file
+ * \param buffer        pointer to an array of width * height pixels
+ * \param size          pointer to load the number of bytes loaded, NULL if not needed
+ *
+ * \return status
+ */
+PFEnStatus qoiLoadImage(const PFchar* fileName, PFword* buffer, PFdword* size);
+
+/** @} */
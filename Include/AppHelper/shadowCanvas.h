@@ -0,0 +1,150 @@
+/**
+ *  \file       shadowCanvas.h
+ *  \brief      Indexed color copy of the drawing area kept in RAM alongside the LCD.
+ *  The drawing functions draw on the LCD through the graphics library and rasterize the same
+ *  pixels, with the same algorithms and the current pen size, into the shadow canvas. The canvas
+ *  stores a palette index per pixel, so the drawing area can be redrawn, restored after it is
+ *  covered, and read for saving without the slow LCD readback.
+ *  The first SHADOW_RAM1_ROWS rows are placed in RAM1, the rest in RAM2.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup SHADOW_CANVAS_API Shadow Canvas API
+ * @{
+ */
+
+#define SHADOW_WIDTH                240   /**< Width of the canvas in pixels */
+#define SHADOW_HEIGHT               275   /**< Height of the canvas in pixels */
+#define SHADOW_BITS_PER_PIXEL       2     /**< 2 for 4 colors (16.5 KB) or 4 for 16 colors (33 KB) */
+#define SHADOW_PALETTE_SIZE         (1 << SHADOW_BITS_PER_PIXEL)    /**< Maximum colors of the palette */
+#define SHADOW_ROW_SIZE             (SHADOW_WIDTH * SHADOW_BITS_PER_PIXEL / 8)  /**< Bytes per row */
+#define SHADOW_RAM1_ROWS            (SHADOW_HEIGHT / 2)     /**< Rows placed in RAM1 */
+
+/** Configuration structure for the shadow canvas */
+typedef struct
+{
+    PFword x;                               /**< X-coordinate on LCD of left-top pixel of the canvas */
+    PFword y;                               /**< Y-coordinate on LCD of left-top pixel of the canvas */
+    const PFword* palette;                  /**< Colors which can be drawn */
+    PFbyte paletteSize;                     /**< Colors in the palette, up to SHADOW_PALETTE_SIZE */
+    PFbyte background;                      /**< Palette index of the cleared canvas */
+}CfgShadow;
+
+/** pointer to structure CfgShadow */
+typedef CfgShadow* pCfgShadow;
+
+/**
+ * To initialize the shadow canvas. The canvas is cleared to the background color, the LCD is not drawn.
+ *
+ * \param config    pointer to configuration of the canvas, should remain valid while the canvas is used
+ *
+ * \return status
+ */
+PFEnStatus shadowOpen(pCfgShadow config);
+
+/**
+ * To load the canvas from the LCD, for a drawing area which was drawn by other means than the
+ * functions of this module, such as the border of the canvas widget. The LCD is read back one row at a time.
+ *
+ * \return status, enStatusInvState if the drawing area has a color which is not in the palette
+ */
+PFEnStatus shadowCapture(void);
+
+/**
+ * To fill an area on the LCD and in the canvas, same as gfxFillArea(). The function can be
+ * used as the fill function of the stroke engine. Filling the whole canvas makes it valid again.
+ *
+ * \param xStart    x coordinate of left-top pixel
+ * \param yStart    y coordinate of left-top pixel
+ * \param xEnd      x coordinate of right-bottom pixel
+ * \param yEnd      y coordinate of right-bottom pixel
+ * \param color     fill color
+ *
+ * \return status of gfxFillArea()
+ */
+PFEnStatus shadowFillArea(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color);
+
+/**
+ * To draw a line with the current color and pen size, same as gfxDrawLine()
+ *
+ * \param x1        x coordinate of start point
+ * \param y1        y coordinate of start point
+ * \param x2        x coordinate of end point
+ * \param y2        y coordinate of end point
+ *
+ * \return status of gfxDrawLine()
+ */
+PFEnStatus shadowDrawLine(PFsdword x1, PFsdword y1, PFsdword x2, PFsdword y2);
+
+/**
+ * To draw a rectangle with the current color and pen size, same as gfxDrawRectangle()
+ *
+ * \param x1        x coordinate of a corner
+ * \param y1        y coordinate of a corner
+ * \param x2        x coordinate of the opposite corner
+ * \param y2        y coordinate of the opposite corner
+ *
+ * \return status of gfxDrawRectangle()
+ */
+PFEnStatus shadowDrawRectangle(PFdword x1, PFdword y1, PFdword x2, PFdword y2);
+
+/**
+ * To draw a circle with the current color and pen size, same as gfxDrawCircle()
+ *
+ * \param xc        x coordinate of the center
+ * \param yc        y coordinate of the center
+ * \param radius    radius of the circle
+ *
+ * \return status of gfxDrawCircle()
+ */
+PFEnStatus shadowDrawCircle(PFsdword xc, PFsdword yc, PFsdword radius);
+
+/**
+ * To read pixels of a row of the canvas. The signature matches the row reader of the BMP save job.
+ *
+ * \param x         x coordinate on LCD of the first pixel
+ * \param y         y coordinate on LCD of the row
+ * \param count     number of pixels to read, they should lie in the canvas
+ * \param pixels    pointer to an array to load the pixels
+ *
+ * \return status, enStatusInvState if the canvas is not valid
+ */
+PFEnStatus shadowReadPixels(PFword x, PFword y, PFword count, PFword* pixels);
+
+/**
+ * To draw an area of the LCD again from the canvas
+ *
+ * \param xStart    x coordinate of left-top pixel
+ * \param yStart    y coordinate of left-top pixel
+ * \param xEnd      x coordinate of right-bottom pixel
+ * \param yEnd      y coordinate of right-bottom pixel
+ *
+ * \return status, enStatusInvState if the canvas is not valid
+ */
+PFEnStatus shadowRedraw(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd);
+
+/**
+ * To mark the canvas as out of date, after the drawing area is changed by other means than the
+ * functions of this module. Drawing with a color which is not in the palette does the same.
+ *
+ * \return status
+ */
+PFEnStatus shadowInvalidate(void);
+
+/**
+ * To check whether the canvas holds the same pixels as the drawing area on the LCD
+ *
+ * \return enBooleanTrue if the canvas is valid
+ */
+PFEnBoolean shadowIsValid(void);
+
+/** @} */
@@ -0,0 +1,205 @@
+/**
+ *  \file       spiBus.h
+ *  \brief      SPI0 bus arbiter shared by the touch controller and the SD card.
+ *  The functions have the same signatures as the SPI0 driver functions so they can be placed
+ *  directly in the CfgTouch and CfgMmc configuration structures. On every chip select the clock
+ *  rate and mode of the selected device profile are applied to the SSP0 channel.
+ *  Short transactions can be queued, also from interrupt context, and are executed when the bus is
+ *  released or when the device holding the bus reaches a safe point and calls spiBusYield().
+ *  Block transfers of the selected device can be made with the SPI0 DMA mode through spiBusDmaTransfer().
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup SPI_BUS_API SPI Bus Arbiter API
+ * @{
+ */
+
+#include "prime_spi0.h"
+
+#define SPI_BUS_MAX_DEVICES         8     /**< Maximum devices, same as the SPI0 driver device list */
+#define SPI_BUS_QUEUE_SIZE          8     /**< Maximum transactions waiting for the bus, should be power of 2 */
+
+/** Clock and mode profile of a device on the bus */
+typedef struct
+{
+    PFGpioPortPin chipSelect;               /**< Chip select pin, used to match the profile when the device registers */
+    PFdword baudrate;                       /**< Clock rate in bits/second used while the device is selected */
+    PFEnSpi0Mode mode;                      /**< SPI mode used while the device is selected */
+    PFEnBoolean urgent;                     /**< Transactions of the device may preempt other devices at their yield points */
+}SpiBusProfile;
+
+/** Configuration structure for the SPI bus arbiter */
+typedef struct
+{
+    SpiBusProfile* profiles;                /**< Array of device profiles */
+    PFbyte profileCount;                    /**< Number of profiles in the array */
+    PFcallback dmaWaitCallback;             /**< Called repeatedly while a DMA block transfer runs, if NULL the core sleeps until the transfer ends */
+}CfgSpiBus;
+
+/** pointer to structure CfgSpiBus */
+typedef CfgSpiBus* pCfgSpiBus;
+
+/** Statistics collected per device */
+typedef struct
+{
+    PFdword transactions;                   /**< Number of chip select cycles */
+    PFdword bytes;                          /**< Bytes transferred */
+    PFdword holdTicks;                      /**< Total ticks the device held the bus */
+    PFdword maxHoldTicks;                   /**< Longest time the device held the bus in ticks */
+    PFdword maxWaitTicks;                   /**< Longest time a queued transaction waited for the bus in ticks */
+    PFdword busyRejects;                    /**< Chip select requests rejected because the bus was held */
+    PFdword preemptions;                    /**< Times the device gave up the bus in spiBusYield() */
+}SpiBusStats;
+
+typedef struct SpiBusTransaction SpiBusTransaction;
+
+/** Descriptor of a queued transaction. The descriptor must stay valid until done is set. */
+struct SpiBusTransaction
+{
+    PFbyte* id;                             /**< Pointer to id of the device, as returned by the register function */
+    PFbyte* txData;                         /**< Data to send, 0xFF is sent if NULL */
+    PFbyte* rxData;                         /**< Buffer for received data, received data is discarded if NULL */
+    PFdword size;                           /**< Number of bytes to exchange */
+    void (*callback)(SpiBusTransaction* transaction); /**< Called after the transaction completes, may be NULL */
+    volatile PFEnStatus status;             /**< Status of the transaction */
+    volatile PFEnBoolean done;              /**< Set when the transaction is complete */
+    PFdword submitTick;                     /**< Tick at which the transaction was submitted, set by spiBusSubmit() */
+};
+
+/**
+ * To initialize the SPI bus arbiter. SPI0 should be opened before calling this function.
+ *
+ * \param config    pointer to configuration structure of the arbiter
+ *
+ * \return status of initialization
+ */
+PFEnStatus spiBusOpen(pCfgSpiBus config);
+
+/**
+ * To register a device on the bus. The device profile is selected by its chip select pin.
+ *
+ * \param id            pointer to load the id of the device
+ * \param chipSelect    pointer to chip select pin of the device
+ *
+ * \return status of registration
+ */
+PFEnStatus spiBusRegisterDevice(PFbyte* id, PFpGpioPortPin chipSelect);
+
+/**
+ * To unregister a device from the bus
+ *
+ * \param id    pointer to id of the device
+ *
+ * \return status of unregistration
+ */
+PFEnStatus spiBusUnregisterDevice(PFbyte* id);
+
+/**
+ * To select or deselect a device. On select the device profile is applied to the channel.
+ * On deselect the queued transactions are executed.
+ *
+ * \param id            pointer to id of the device
+ * \param pinStatus     0 to select the device, 1 to deselect it
+ *
+ * \return status of chip select operation, enStatusBusy if another device holds the bus
+ */
+PFEnStatus spiBusChipSelect(PFbyte* id, PFbyte pinStatus);
+
+/**
+ * To exchange one byte with the selected device
+ *
+ * \param id        pointer to id of the device
+ * \param data      byte to send
+ * \param rxData    pointer to load the received byte
+ *
+ * \return status of exchange
+ */
+PFEnStatus spiBusExchangeByte(PFbyte* id, PFbyte data, PFbyte* rxData);
+
+/**
+ * To write bytes to the selected device
+ *
+ * \param id                pointer to id of the device
+ * \param data              pointer to data to send
+ * \param size              number of bytes to send
+ * \param delayCallback     delay between bytes, may be NULL
+ *
+ * \return status of write
+ */
+PFEnStatus spiBusWrite(PFbyte* id, PFbyte* data, PFdword size, PFcallback delayCallback);
+
+/**
+ * To read bytes from the selected device
+ *
+ * \param id                pointer to id of the device
+ * \param data              pointer to buffer for received data
+ * \param size              number of bytes to read
+ * \param readBytes         pointer to load the number of bytes read
+ * \param delayCallback     delay between bytes, may be NULL
+ *
+ * \return status of read
+ */
+PFEnStatus spiBusRead(PFbyte* id, PFbyte* data, PFdword size, PFdword* readBytes, PFcallback delayCallback);
+
+/**
+ * To exchange a block of data with the selected device using the SPI0 DMA mode.
+ * The dmaWaitCallback of the configuration is called while the transfer runs, without it the core
+ * sleeps until the DMA interrupt ends the transfer.
+ *
+ * \param id        pointer to id of the device
+ * \param txData    pointer to data to send, 0xFF is sent if NULL
+ * \param rxData    pointer to buffer for received data, received data is discarded if NULL
+ * \param size      number of bytes to exchange
+ *
+ * \return status of transfer, enStatusNotSupported if a buffer is not accessible to the DMA controller
+ *         and enStatusNotConfigured if the SPI0 DMA mode is not opened
+ */
+PFEnStatus spiBusDmaTransfer(PFbyte* id, PFbyte* txData, PFbyte* rxData, PFdword size);
+
+/**
+ * To queue a transaction. The function can be called from interrupt context.
+ *
+ * \param transaction   pointer to transaction descriptor
+ *
+ * \return status of submission, enStatusNoMem if the queue is full
+ */
+PFEnStatus spiBusSubmit(SpiBusTransaction* transaction);
+
+/**
+ * To execute the queued transactions if the bus is free. Call it periodically from the main loop.
+ *
+ * \return status of service
+ */
+PFEnStatus spiBusService(void);
+
+/**
+ * To give the bus to queued transactions of urgent devices. A device holding the bus calls this
+ * at a point where its chip select can be released, e.g. between data blocks of a multi block transfer.
+ * The device is selected again with its own profile before the function returns.
+ *
+ * \param id    pointer to id of the device holding the bus
+ *
+ * \return status of yield
+ */
+PFEnStatus spiBusYield(PFbyte* id);
+
+/**
+ * To get the statistics of a device
+ *
+ * \param id        pointer to id of the device
+ * \param stats     pointer to structure to copy the statistics to
+ *
+ * \return status
+ */
+PFEnStatus spiBusGetStats(PFbyte* id, SpiBusStats* stats);
+
+/** @} */
@@ -0,0 +1,129 @@
+/**
+ *  \file       stroke.h
+ *  \brief      Stroke engine which turns raw touch samples into a drawn freehand stroke.
+ *  Consecutive samples are joined with Bresenham segments stamped at the current pen size,
+ *  near-collinear and jitter samples are dropped by a streaming Douglas-Peucker simplifier and
+ *  the surviving vertices are drawn as a polyline in small batches.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup STROKE_API Stroke Engine API
+ * @{
+ */
+
+#define STROKE_BATCH_SIZE           4     /**< Number of simplified vertices buffered before the polyline is drawn */
+#define STROKE_WINDOW_SIZE          8     /**< Maximum number of samples held by the simplifier before a vertex is forced */
+#define STROKE_DEFAULT_TOLERANCE    1     /**< Default perpendicular tolerance of the simplifier in pixels */
+#define STROKE_DEFAULT_MIN_DISTANCE 2     /**< Default minimum motion in pixels for a sample to be accepted */
+
+/** Point of a stroke in screen coordinates */
+typedef struct
+{
+    PFsword x;                              /**< X-coordinate */
+    PFsword y;                              /**< Y-coordinate */
+}StrokePoint;
+
+/** Configuration structure for the stroke engine */
+typedef struct
+{
+    PFword clipX1;                          /**< X-coordinate of left-top pixel of the drawing area */
+    PFword clipY1;                          /**< Y-coordinate of left-top pixel of the drawing area */
+    PFword clipX2;                          /**< X-coordinate of right-bottom pixel of the drawing area */
+    PFword clipY2;                          /**< Y-coordinate of right-bottom pixel of the drawing area */
+    PFword tolerance;                       /**< Maximum distance in pixels of a dropped sample from the drawn polyline */
+    PFword minDistance;                     /**< Samples which moved less than this many pixels are treated as jitter */
+    PFEnStatus (*fillArea)(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color); /**< Function pointer to fill a rectangle, gfxFillArea() if NULL */
+}CfgStroke;
+
+/** pointer to structure CfgStroke */
+typedef CfgStroke* pCfgStroke;
+
+/** Statistics collected for a stroke */
+typedef struct
+{
+    PFdword samples;                        /**< Raw samples passed to the engine */
+    PFdword dropped;                        /**< Samples dropped as jitter */
+    PFdword vertices;                       /**< Polyline vertices drawn */
+    PFdword fills;                          /**< Calls made to the fill function */
+    PFdword pixelsWritten;                  /**< Pixels written to the display */
+}StrokeStats;
+
+/** Stroke state, one instance per stroke in progress */
+typedef struct
+{
+    pCfgStroke config;                      /**< Configuration of the stroke */
+    PFword color;                           /**< Pen color latched at strokeBegin() */
+    PFword penSize;                         /**< Pen size latched at strokeBegin() */
+    StrokePoint pen;                        /**< Last point stamped on the display */
+    StrokePoint anchor;                     /**< Last vertex chosen by the simplifier */
+    StrokePoint lastSample;                 /**< Last raw sample, accepted or not */
+    StrokePoint window[STROKE_WINDOW_SIZE]; /**< Samples following the anchor which are not yet decided */
+    PFbyte windowCount;                     /**< Number of samples in window */
+    StrokePoint batch[STROKE_BATCH_SIZE];   /**< Vertices waiting to be drawn */
+    PFbyte batchCount;                      /**< Number of vertices in batch */
+    PFEnBoolean active;                     /**< enBooleanTrue between strokeBegin() and strokeEnd() */
+    StrokeStats stats;                      /**< Statistics of the stroke */
+}Stroke;
+
+/**
+ * To start a new stroke at the given point. The pen color and size are read from the graphics driver.
+ *
+ * \param stroke    pointer to stroke state
+ * \param config    pointer to configuration structure of the stroke engine
+ * \param x         X-coordinate of the first sample
+ * \param y         Y-coordinate of the first sample
+ *
+ * \return status whether stroke is started or not
+ */
+PFEnStatus strokeBegin(Stroke* stroke, pCfgStroke config, PFdword x, PFdword y);
+
+/**
+ * To add a touch sample to a stroke. The sample may be dropped, buffered, or cause a part of
+ * the stroke to be drawn.
+ *
+ * \param stroke    pointer to stroke state
+ * \param x         X-coordinate of the sample
+ * \param y         Y-coordinate of the sample
+ *
+ * \return status whether sample is added or not
+ */
+PFEnStatus strokeAddPoint(Stroke* stroke, PFdword x, PFdword y);
+
+/**
+ * To draw the vertices buffered in the current batch.
+ *
+ * \param stroke    pointer to stroke state
+ *
+ * \return status whether batch is drawn or not
+ */
+PFEnStatus strokeFlush(Stroke* stroke);
+
+/**
+ * To finish a stroke. The stroke is drawn up to the last sample received.
+ *
+ * \param stroke    pointer to stroke state
+ *
+ * \return status whether stroke is finished or not
+ */
+PFEnStatus strokeEnd(Stroke* stroke);
+
+/**
+ * To get statistics of a stroke
+ *
+ * \param stroke    pointer to stroke state
+ * \param stats     pointer to structure to copy the statistics to
+ *
+ * \return status whether statistics are copied or not
+ */
+PFEnStatus strokeGetStats(Stroke* stroke, StrokeStats* stats);
+
+/** @} */
@@ -0,0 +1,147 @@
+/**
+ *  \file       thumbnail.h
+ *  \brief      Downscaled thumbnails of images on the SDcard and a gallery of them.
+ *  An image is decoded as a stream, top row first, and reduced by an integer factor with a box filter:
+ *  each thumbnail pixel is the average of factor x factor image pixels. Only one row of accumulators is
+ *  kept, so the image is never held in memory. Right and bottom edges which do not fill a whole box are
+ *  dropped. BMP, .pnt and QOI images are recognized by their signature.
+ *
+ *  A drawn thumbnail is stored next to the image in a sidecar file with the extension .THM, which is
+ *  drawn instead of the image as long as the factor and the size of the image match. The sidecar is
+ *  an 8 byte header, "THM", the factor and the size of the image (32 bit, little endian), followed by
+ *  the thumbnail as a .pnt image.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup THUMBNAIL_API Thumbnail API
+ * @{
+ */
+
+#include "fatFs.h"
+
+#define THUMB_MAX_WIDTH             80    /**< Maximum width of a thumbnail in pixels */
+#define THUMB_MAX_FACTOR            8     /**< Maximum reduction factor */
+#define THUMB_SIDECAR_HEADER_SIZE   8     /**< Size of the sidecar header before the .pnt image */
+#define THUMB_NAME_SIZE             32    /**< Size of the path buffers, including the directory */
+
+typedef struct ThumbDecoder ThumbDecoder;
+
+/**
+ * Callback which receives the rows of a thumbnail, top row first.
+ *
+ * \param thumb     pointer to decoder state, thumb->rowsDone is the index of the row
+ * \param pixels    pointer to thumb->width pixels of the row
+ *
+ * \return status, decoding stops if it is not success
+ */
+typedef PFEnStatus (*ThumbRowWriter)(ThumbDecoder* thumb, const PFword* pixels);
+
+/** Decoder state */
+struct ThumbDecoder
+{
+    PFbyte factor;                          /**< Reduction factor */
+    PFword width;                           /**< Width of the thumbnail */
+    PFword height;                          /**< Height of the thumbnail */
+    PFword rowsDone;                        /**< Rows of the thumbnail passed to the writer */
+    ThumbRowWriter writer;                  /**< Callback which receives the rows */
+    void* context;                          /**< Context pointer for the writer */
+    PFword imageWidth;                      /**< Width of the image */
+    PFword x;                               /**< Position of the next image pixel in its row */
+    PFword boxRows;                         /**< Image rows added to the accumulators */
+    PFword red[THUMB_MAX_WIDTH];            /**< Accumulated red of each thumbnail pixel of the row */
+    PFword green[THUMB_MAX_WIDTH];          /**< Accumulated green of each thumbnail pixel of the row */
+    PFword blue[THUMB_MAX_WIDTH];           /**< Accumulated blue of each thumbnail pixel of the row */
+    PFword row[THUMB_MAX_WIDTH];            /**< Averaged row passed to the writer */
+};
+
+/** Configuration structure for a gallery */
+typedef struct
+{
+    const PFchar* path;                     /**< Directory with the images, "" for the current directory */
+    PFword x;                               /**< X-coordinate of left-top pixel of the gallery */
+    PFword y;                               /**< Y-coordinate of left-top pixel of the gallery */
+    PFword cellWidth;                       /**< Width of a cell */
+    PFword cellHeight;                      /**< Height of a cell */
+    PFbyte columns;                         /**< Cells in a row */
+    PFbyte rows;                            /**< Rows of cells */
+    PFbyte factor;                          /**< Reduction factor of the thumbnails */
+    PFword background;                      /**< Color around the thumbnails */
+}CfgThumbGallery;
+
+/** pointer to structure CfgThumbGallery */
+typedef CfgThumbGallery* pCfgThumbGallery;
+
+/**
+ * To decode an image into thumbnail rows.
+ *
+ * \param fileName  path of the image file
+ * \param factor    reduction factor, 1 to THUMB_MAX_FACTOR
+ * \param thumb     pointer to decoder state
+ * \param writer    callback which receives the rows
+ * \param context   context pointer for the writer, stored in thumb->context
+ *
+ * \return status:
+ *       enStatusSuccess      - all rows passed to the writer
+ *       enStatusInvArgs      - factor out of range or the thumbnail wider than THUMB_MAX_WIDTH
+ *       enStatusNotSupported - file is not a supported image
+ *       other                - error in accessing the file or returned by the writer
+ */
+PFEnStatus thumbDecode(const PFchar* fileName, PFbyte factor, ThumbDecoder* thumb, ThumbRowWriter writer, void* context);
+
+/**
+ * To draw the thumbnail of an image on the LCD screen. The sidecar is drawn if it is up to date,
+ * otherwise the image is decoded and the sidecar is written while drawing.
+ *
+ * \param fileName  path of the image file
+ * \param factor    reduction factor, 1 to THUMB_MAX_FACTOR
+ * \param x         x coordinate on LCD screen to draw the thumbnail
+ * \param y         y coordinate on LCD screen to draw the thumbnail
+ * \param width     pointer to load the width of the thumbnail, may be NULL
+ * \param height    pointer to load the height of the thumbnail, may be NULL
+ *
+ * \return status, the sidecar is optional and failing to write it is not reported
+ */
+PFEnStatus thumbDraw(const PFchar* fileName, PFbyte factor, PFword x, PFword y, PFword* width, PFword* height);
+
+/**
+ * To delete the sidecar of an image, after the image is rewritten with the same size
+ *
+ * \param fileName  path of the image file
+ *
+ * \return status of deleting the sidecar
+ */
+PFEnStatus thumbInvalidate(const PFchar* fileName);
+
+/**
+ * To draw a page of a gallery. The images of the directory are taken in directory order, the
+ * thumbnail of each is drawn centered in its cell, and unused cells are cleared.
+ *
+ * \param config    pointer to configuration of the gallery
+ * \param first     index of the image in the first cell
+ * \param total     pointer to load the number of images in the directory, may be NULL
+ *
+ * \return status
+ */
+PFEnStatus thumbGalleryDraw(pCfgThumbGallery config, PFword first, PFword* total);
+
+/**
+ * To get the path of an image of a gallery
+ *
+ * \param config    pointer to configuration of the gallery
+ * \param index     index of the image in the directory, as counted by thumbGalleryDraw()
+ * \param fileName  buffer of THUMB_NAME_SIZE bytes to load the path
+ *
+ * \return status, enStatusNotExist if there are not so many images
+ */
+PFEnStatus thumbGalleryGetImage(pCfgThumbGallery config, PFword index, PFchar* fileName);
+
+/** @} */
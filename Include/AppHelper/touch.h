@@ -8,6 +8,15 @@
  *
  * \brief Prime Framework Touch Driver
  *
+ * The panel controller shares SPI0 with the SD card through the SPI bus arbiter. A sample of the
+ * panel is one queued transaction of the arbiter: the touch interrupt can start it with
+ * touchSampleStart() while another device holds the bus, and it is read at the next point where
+ * that device yields, between the data blocks of an SD card write.
+ *
+ * The driver is built from Source/AppHelper/touch.c. Its CfgTouch takes the submit and service
+ * functions of the bus arbiter in place of the spiWrite and spiRead functions of the prebuilt
+ * driver, configurations made for the prebuilt driver have to be updated.
+ *
  * Review status: NO
  *
  */
@@ -16,6 +25,10 @@
  * \defgroup TOUCH_DRIVER_API TOUCH Driver API
  * @{
  */
+
+#include "spiBus.h"
+
+#define TOUCH_SAMPLES	5		/**< Conversions of each channel in a sample, the median is taken */
   
  /**	Enumeration for the reference select of touch panel driver		*/
 typedef enum{
@@ -36,11 +49,11 @@ typedef struct
 	 PFGpioPortPin gpioTouchBusyPin;	 			/**< Touch busy pin*/
 	 PFGpioPortPin gpioTouchCsGpio;	 				/**< Touch chip select pin */
 	 EnTouchReferenceSelect refsel; 				/**< Touch reference pin */
-	 EnTouchPrecision precsel; 					/**< Touch precision pin */
+	 EnTouchPrecision precsel; 					/**< Touch conversion precision, 8 bit results are scaled to 12 bit codes */
 	 PFEnStatus (*spiRegisterDevice)(PFbyte* id, PFpGpioPortPin chipSelect); /**< Function pointer to SPI register device */
 	 PFEnStatus (*spiChipSelect)(PFbyte* id, PFbyte pinStatus); /**< Function pointer to SPI chip select */
-	 PFEnStatus (*spiWrite)(PFbyte* id, PFbyte* data, PFdword size,  PFcallback delayCallback); /**< Function pointer to SPI write */
-	 PFEnStatus (*spiRead)(PFbyte* id, PFbyte* data, PFdword size, PFdword* readBytes,   PFcallback delayCallback); /**< Function pointer to SPI read */
+	 PFEnStatus (*spiSubmit)(SpiBusTransaction* transaction); /**< Function pointer to SPI transaction submit, a sample is one transaction */
+	 PFEnStatus (*spiService)(void); /**< Function pointer to SPI service, runs the submitted transactions if the bus is free */
 }CfgTouch;
 
 /** pointer to structure CgfTouch */
@@ -51,16 +64,18 @@ typedef CfgTouch*	pCfgTouch;
  *
  * \param TouchConfig, pointer to config structure to configure touch driver 
  *
- * \return status of initialize
+ * \return status of initialize, enStatusInvArgs for a missing function or an unknown precision
  * 
  */
 PFEnStatus touchOpen(pCfgTouch touchConfig);
 /**
- * To get the coordinates from touch module
+ * To get the coordinates from touch module. A sample started by touchSampleStart() is given if there
+ * is one, otherwise a new sample is read.
  *
  * \param pointer to x and y to store the coordinates from touch driver
  *
- * \return status of whether the user got coordinates from touch driver
+ * \return status of whether the user got coordinates from touch driver, enStatusError if the pressure
+ *         of the touch is too light for a position and enStatusBusy if the bus is held
  * 
  */
 PFEnStatus touchGetCoordinates(PFdword* x_pos, PFdword* y_pos);
@@ -76,7 +91,9 @@ PFEnStatus touchDataAvailable(PFEnBoolean *data);
 
 
 /**
- * To detect touch instantaneously and get coordinates of touch
+ * To detect touch instantaneously and get coordinates of touch. A sample started by touchSampleStart()
+ * is given even if the panel has been released since, so that a short touch during a long SD card
+ * transfer is not lost.
  *
  * \param pointer to x and y to store the coordinates from touch driver
  *
@@ -92,6 +109,16 @@ PFEnStatus touchDataAvailable(PFEnBoolean *data);
  */
 PFEnStatus touchClose(void);
 
+/**
+ * To start a sample of the touch panel. The function can be called from the touch interrupt. The sample
+ * is an urgent transaction of the SPI bus arbiter, run at once by spiService() if the bus is free, or
+ * at the next yield point of the device holding the bus. It is kept for touchAvailable().
+ *
+ * \return status of submission, enStatusBusy if a sample is already waiting for the bus
+ * 
+ */
+PFEnStatus touchSampleStart(void);
+
 /** } */
 
 
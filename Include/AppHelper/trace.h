@@ -0,0 +1,104 @@
+/**
+ *  \file       trace.h
+ *  \brief      Binary trace logger.
+ *  Events are recorded as fixed size binary records holding a timestamp, an event id and two arguments,
+ *  in a ring in RAM. Recording an event takes a few cycles and never blocks, so traceEvent() can be
+ *  called from any context, including interrupt handlers of any priority. The ring is drained to the
+ *  transmit buffer of a serial driver by traceDrain(), and the driver transmit interrupt sends the bytes.
+ *  The event ids are defined by the application; the records are decoded on the host by matching the
+ *  ids with the same event table.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup TRACE_API Trace Logger API
+ * @{
+ */
+
+#define TRACE_BUFFER_SIZE           64          /**< Records in the ring, should be power of 2 */
+#define TRACE_SYNC                  0xA5        /**< First byte of every record */
+#define TRACE_ID_DROPPED            0xFFFF      /**< Id of the record sent when events were dropped, arg1 is the number dropped */
+
+/** Trace record, as stored in the ring and sent over the serial line, little endian */
+typedef struct
+{
+    volatile PFbyte sync;                   /**< TRACE_SYNC once the record is complete */
+    PFbyte sequence;                        /**< Low byte of the record number, to find lost records */
+    PFword id;                              /**< Event id */
+    PFdword timestamp;                      /**< Timestamp of the event */
+    PFdword arg1;                           /**< First argument of the event */
+    PFdword arg2;                           /**< Second argument of the event */
+}TraceRecord;
+
+/** Configuration structure for the trace logger */
+typedef struct
+{
+    PFEnStatus (*write)(PFbyte* data, PFdword size);        /**< Writes to the transmit buffer of the serial driver, for example pfUart0Write */
+    PFEnStatus (*getTxBufferSize)(PFdword* size);           /**< Gives the size of the transmit buffer, for example pfUart0GetTxBufferSize */
+    PFEnStatus (*getTxBufferCount)(PFdword* count);         /**< Gives the bytes in the transmit buffer, for example pfUart0GetTxBufferCount */
+    PFdword (*timestamp)(void);             /**< Gives the timestamp of an event, for example pfIdleGetCycles. NULL to use the DWT cycle counter, which stops while the CPU sleeps */
+}CfgTrace;
+
+/** pointer to structure CfgTrace */
+typedef CfgTrace* pCfgTrace;
+
+/** Statistics of the trace logger */
+typedef struct
+{
+    PFdword events;                         /**< Events recorded */
+    PFdword dropped;                        /**< Events dropped because the ring was full */
+    PFdword drained;                        /**< Records written to the serial driver */
+    PFdword maxUsed;                        /**< Most records found in the ring by traceDrain() */
+}TraceStats;
+
+/**
+ * To initialize the trace logger. The serial driver should be opened with the transmit interrupt
+ * enabled before calling this function. The DWT cycle counter is started, and reset when the
+ * timestamps are taken from it.
+ *
+ * \param config pointer to the configuration structure
+ *
+ * \return initialization status
+ */
+PFEnStatus traceOpen(pCfgTrace config);
+
+/**
+ * This function records an event. It can be called from any context.
+ *
+ * \param id   event id
+ * \param arg1 first argument of the event
+ * \param arg2 second argument of the event
+ *
+ * \return return status:
+ *  enStatusSuccess       - event recorded
+ *  enStatusNoMem         - ring is full, event dropped
+ *  enStatusNotConfigured - logger is not initialized
+ */
+PFEnStatus traceEvent(PFword id, PFdword arg1, PFdword arg2);
+
+/**
+ * This function writes the complete records of the ring to the serial driver, as many as fit in its
+ * transmit buffer. It should be called periodically from one context only, for example the main loop.
+ *
+ * \return drain status, enStatusBusy if the serial driver was busy
+ */
+PFEnStatus traceDrain(void);
+
+/**
+ * This function is used to get the statistics of the trace logger.
+ *
+ * \param stats pointer to structure to load the statistics
+ *
+ * \return return status
+ */
+PFEnStatus traceGetStats(TraceStats* stats);
+
+/** @} */
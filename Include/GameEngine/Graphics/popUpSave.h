@@ -0,0 +1,111 @@
+/**
+ *  \file       popUpSave.h
+ *  \brief      Background save of PopUps for Phi Game Engine
+ *  drawPopUp() keeps the background of a PopUp in a buffer of READ_BG_BUFFER_SIZE pixels, which limits
+ *  the size of a PopUp. This module saves the background as runs of equal pixels instead, each run
+ *  being a count and a color which never crosses a row. Runs which do not fit the buffer in RAM are
+ *  spilled to a temporary file on the SDcard, so the size of a PopUp is not limited.
+ *  When the background is restored, pixels which the PopUp did not change are skipped: runs of the
+ *  PopUp background color outside the text and the border are not written again.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#ifndef _POPUP_SAVE_H_
+#define _POPUP_SAVE_H_
+
+#include "gui.h"
+
+/** PopUp background save configuration */
+#define POPUP_SAVE_BUFFER_SIZE      512         /**< Runs kept in RAM, 4 bytes each */
+#define POPUP_SAVE_MAX_WIDTH        240         /**< Maximum width of a saved area */
+#define POPUP_SAVE_FILE_NAME        ((const PFchar*)"POPUP.TMP") /**< Temporary file for the runs which do not fit in RAM */
+
+/** Pixels drawn by a PopUp over its area, all other pixels are left as filled by the PopUp */
+typedef struct
+{
+    PFword fillColor;               /**< Color the area was filled with */
+    PFword textX1;                  /**< X-coordinate of left-top pixel of the text */
+    PFword textY1;                  /**< Y-coordinate of left-top pixel of the text */
+    PFword textX2;                  /**< X-coordinate of right-bottom pixel of the text */
+    PFword textY2;                  /**< Y-coordinate of right-bottom pixel of the text */
+    PFEnBoolean border;             /**< Outline of the area drawn over the fill */
+}PopUpDrawn;
+
+/** Statistics of the last save and restore */
+typedef struct
+{
+    PFdword pixels;                 /**< Pixels in the saved area */
+    PFdword runs;                   /**< Runs the area was encoded to */
+    PFdword spilledBytes;           /**< Bytes of runs written to the temporary file */
+    PFdword pixelsRestored;         /**< Pixels written back to the LCD */
+    PFdword saveTicks;              /**< Tick module ticks taken by the save */
+    PFdword restoreTicks;           /**< Tick module ticks taken by the restore */
+}PopUpSaveStats;
+
+/**
+ * This function reads back an area of the LCD screen and saves it as runs.
+ * A new save discards the previous one.
+ *
+ * \param x         x coordinate of left-top pixel of the area
+ * \param y         y coordinate of left-top pixel of the area
+ * \param width     width of the area, up to POPUP_SAVE_MAX_WIDTH
+ * \param height    height of the area
+ *
+ * \return return status:
+ *  enStatusSuccess - area saved
+ *  enStatusInvArgs - area is empty or too wide
+ *  other           - error in writing the temporary file
+ */
+PFEnStatus popUpSaveArea(PFword x, PFword y, PFword width, PFword height);
+
+/**
+ * This function draws the saved area back on the LCD screen and deletes the temporary file.
+ *
+ * \param drawn     pixels drawn over the area since it was saved, NULL to restore every pixel
+ *
+ * \return return status:
+ *  enStatusSuccess  - area restored
+ *  enStatusInvState - no area saved
+ *  other            - error in reading the temporary file
+ */
+PFEnStatus popUpRestoreArea(const PopUpDrawn* drawn);
+
+/**
+ * This function is used to display a PopUp like drawPopUp(), without a limit on the size of the PopUp.
+ * The PopUp is drawn with the configuration given instead of an id returned by createPopUp().
+ * The text is drawn at the left of the PopUp and centered vertically, as drawPopUp() does.
+ * It returns once the PopUp is drawn and the background is restored by a software timer, so
+ * pfTimerProcess() must be called while the PopUp is shown. A PopUp still shown is taken down
+ * before the next one is drawn. If the timer service is not initialized, it waits for the duration.
+ *
+ * \param config        pointer of the PopUpCfg structure
+ * \param displayString Notification message to be displayed
+ * \param duration      Duration of the PopUp message in milliseconds
+ * \param fontType      Font type of the message string
+ * \param fontColor     Font color of the message string
+ *
+ * \return return status:
+ *  enStatusSuccess - PopUp successfully drawn
+ *  enStatusNoMem   - Size of the string is greater than the size of the PopUp window
+ *  other           - error in saving the background, or in restoring it without the timer service
+ */
+PFEnStatus drawPopUpSaved(PopUpCfg* config, char* displayString, PFword duration, PFword fontType, PFword fontColor);
+
+/**
+ * This function is used to get the statistics of the last save and restore.
+ *
+ * \param stats pointer to structure to load the statistics
+ *
+ * \return return status
+ */
+PFEnStatus popUpSaveGetStats(PopUpSaveStats* stats);
+
+#endif
@@ -26,8 +26,7 @@
 #ifndef _OBJECT_MANAGER_H_
 #define _OBJECT_MANAGER_H_
 
-/** \brief Maximum number of objects supported            */
-#define MAX_OBJECT_NUM                         20
+#include "gameEngineConfig.h"
 
 /** Enumeration for the Shape of a 2D object            */
 typedef enum
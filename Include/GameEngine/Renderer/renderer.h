@@ -30,6 +30,7 @@
 #define _RENDERER_H_
 
 #include "gameGraphics.h"
+#include "gameEngineConfig.h"
 
 /** EduARM LCD specification MACROS. */
 #define LCD_TOP_LEFT_X                0            //LCD Top Left X Coordinate
@@ -53,9 +54,6 @@ typedef enum
     enFillArea
 }EnGfxWrapper;
 
-/** Maximum number of commands supported by Renderer Manager for 1 Frame     */
-#define RENDERER_COMMAND_INSTANCES        20
-
 /**
  * This function is used to initialize the Renderer Manager. This function
  * should be called in the beginning before using the services
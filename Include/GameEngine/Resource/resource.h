@@ -3,7 +3,7 @@
  *  \brief      Resource Manager for Phi Game Engine
  *  Resource Manager manages resources required to design a game.
  *  A Game requires resources like image, sound and text files.
- *    Our Resource manager only support images in bmp format 
+ *    Our Resource manager supports images in bmp, native pnt and qoi format
  *  stored on the SDcard and a piezo buzzer to play sound.
  *
  *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
@@ -28,7 +28,9 @@ typedef enum
 /**Enum to select image format        */
 typedef enum
 {
-    enImageBmpFormat = 0			/**	It only supports 16-bit and 24-bit bitmap images	*/
+    enImageBmpFormat = 0,			/**	It only supports 16-bit and 24-bit bitmap images	*/
+    enImagePntFormat,				/**	Native canvas image, see pntImage.h	*/
+    enImageQoiFormat				/**	QOI image, see qoiImage.h	*/
 }EnImageFormat;
 
 /** Configuration structure to specify attributes of an image*/
@@ -42,9 +44,25 @@ typedef struct
 
 typedef ImageCfg* pImageCfg;
 
+/** Image cache configuration. The cache keeps loaded images in AHB RAM (RAM2), see PF_AHB_NOINIT. */
+#define RESOURCE_USE_IMAGE_CACHE    1       /**< Set to 0 to load every image from the SDcard */
+#define RESOURCE_CACHE_POOL_SIZE    8192    /**< Bytes of pixel data held by the cache */
+#define RESOURCE_CACHE_ENTRIES      8       /**< Maximum images held by the cache */
+#define RESOURCE_CACHE_PATH_SIZE    24      /**< Longest cached path including the terminating zero */
+
+/** Image cache statistics */
+typedef struct
+{
+    PFdword hits;                   /**< Images copied from the cache */
+    PFdword misses;                 /**< Images loaded from the SDcard */
+    PFdword evictions;              /**< Images removed to make room for another one */
+    PFdword uncached;               /**< Images loaded which could not be cached, too large or path too long */
+    PFdword bytesUsed;              /**< Bytes of the pool in use */
+}ResourceCacheStats;
+
 /**
  * This function reads the image file from specified storage location, extracts actual image 
- * data and then saves it in an array.
+ * data and then saves it in an array. Images already loaded are copied from the image cache.
  *
  * \param imageConfig  Pointer to configuration structure, which contains the attributes of the image.
  *
@@ -57,8 +75,31 @@ typedef ImageCfg* pImageCfg;
  */
 PFEnStatus getImage(pImageCfg imageConfig);
 
+/**
+ * This function removes an image from the image cache, so that the next getImage() call loads it
+ * from the SDcard again. It should be called after an image file is changed.
+ *
+ * \param imagePath path of the image to remove, NULL to empty the cache.
+ *
+ * \return return status:
+ *  enStatusSucess          - image removed
+ *  enStatusNotExist        - image is not in the cache
+ */
+PFEnStatus resourceCacheInvalidate(const PFbyte* imagePath);
+
+/**
+ * This function reads the image cache statistics.
+ *
+ * \param stats pointer to structure to load the statistics.
+ *
+ * \return return status
+ */
+PFEnStatus resourceCacheGetStats(ResourceCacheStats* stats);
+
 /**
  * This function is used to play the buzzer for a specified duration.
+ * It returns at once and the buzzer is turned off by a software timer, so pfTimerProcess() must be called
+ * while it plays. If the timer service is not initialized, it waits for the duration.
  *
  * \param duration time duration in milliseconds to play the buzzer.
  *
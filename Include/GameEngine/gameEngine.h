@@ -41,6 +41,7 @@
 #include "renderer.h"
 #include "gameGraphics.h"
 #include "resource.h"
+#include "popUpSave.h"
 
 /** return status check        */
 #define CHECK_SUCCESS_STATUS    if(status != enStatusSuccess)        return enStatusError;
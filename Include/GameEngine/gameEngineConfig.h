@@ -0,0 +1,34 @@
+/**
+ *  \file       gameEngineConfig.h
+ *  \brief      Table sizes of the Phi Game Engine
+ *  The Game Engine keeps its objects and renderer commands in static tables. Their sizes are set here
+ *  and can be changed per application by defining the macros on the compiler command line, for example
+ *  -DMAX_OBJECT_NUM=8, so no engine source has to be edited.
+ *
+ *  The limits of the GUI (MAX_WINDOWS, MAX_WIDGETS_PER_WINDOW, MAX_CANVAS_PER_WINDOW and
+ *  MAX_NO_OF_POP_UPS in gui.h) are compiled into the GUI library and cannot be changed here.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#ifndef _GAME_ENGINE_CONFIG_H_
+#define _GAME_ENGINE_CONFIG_H_
+
+/** \brief Maximum number of objects supported, at most 255 as Ids are bytes            */
+#ifndef MAX_OBJECT_NUM
+#define MAX_OBJECT_NUM                         20
+#endif
+
+/** Maximum number of commands supported by Renderer Manager for 1 Frame, at most 255     */
+#ifndef RENDERER_COMMAND_INSTANCES
+#define RENDERER_COMMAND_INSTANCES             20
+#endif
+
+#endif /* _GAME_ENGINE_CONFIG_H_ */
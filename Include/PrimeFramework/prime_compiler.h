@@ -34,6 +34,9 @@
     #define PF_C_TYPEOF                         0                                   /**< No keyword is defined Keil ARMCC compiler  */
     #define PF_C_TYPEOF_OR_PGENERIC(type)       PFpgeneric                          /**< This defines PFpgeneric keyword for Keil ARMCC compiler    */
     #define PF_WARNING                          #warning                            /**< warning preprocessor               */
+    #define PF_RAMFUNC                          __attribute__((section(".ramfunc")))     /**< Places a function in RAM1, copied from flash by ResetHandler, to run it without flash wait states */
+    #define PF_AHB_BSS                          __attribute__((section(".ahbbss"), aligned(4)))  /**< Places a variable in AHB RAM (RAM2), cleared by ResetHandler */
+    #define PF_AHB_NOINIT                       __attribute__((section(".ahbram"), aligned(4)))  /**< Places a variable in AHB RAM (RAM2), not cleared by ResetHandler */
 /**  
  *  \brief      No Operation
  *  \details    No Operation does nothing. This instruction can be used for code alignment
@@ -140,6 +143,9 @@
     #define PF_C_PACKED                         __attribute__((packed))                             /**< This sets the alignment of any valid type to 1 for GNU compiler*/
     #define PF_C_TYPEOF_OR_PGENERIC(type)       typeof(type)                                        /**< This defines typeof keyword for GNU compiler */
     #define PF_WARNING                          #warning                                        /**< warning preprocessor       */
+    #define PF_RAMFUNC                          __attribute__((section(".ramfunc"), long_call, noinline))    /**< Places a function in RAM1, copied from flash by ResetHandler, to run it without flash wait states. Calls to it are long calls as RAM1 is out of the range of BL from flash. */
+    #define PF_AHB_BSS                          __attribute__((section(".ahbbss"), aligned(4)))                  /**< Places a variable in AHB RAM (RAM2), cleared by ResetHandler */
+    #define PF_AHB_NOINIT                       __attribute__((section(".ahbram"), aligned(4)))                  /**< Places a variable in AHB RAM (RAM2), not cleared by ResetHandler */
 
 /** 
  *  \brief      No Operation
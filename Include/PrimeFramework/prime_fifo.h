@@ -21,21 +21,32 @@
  *  @{
  *  
  *  \brief      Prime Fifo Description
- *  \details
+ *  \details    The FIFO is safe for one producer and one consumer running concurrently, for example
+ *              an interrupt handler and the main loop, without disabling interrupts. Only the producer
+ *              moves pTail and only the consumer moves pHead, so one byte of the storage buffer is
+ *              always kept free to tell a full FIFO from an empty one.
  */
  
-/** \brief Macro to enable overwriting FIFO when buffer is full */
+/** \brief Macro to enable overwriting FIFO when buffer is full: pfFifoPush() drops the oldest byte, as the
+ *  drivers expect for their receive FIFOs. Both sides then move pHead by compare and swap. The block
+ *  functions pfFifoWrite() and pfFifoCommit() never overwrite, they push as many bytes as there is space for. */
 #define PF_FIFO_OVERWRITE_ENABLE		1 
 
+/** \brief Macro to keep the count field of the FIFO descriptor up to date. The prebuilt UART0, UART2, SPI0,
+ *  SPI1 and CAN1 drivers read it in their Get*BufferCount functions, so it must stay 1 while they are
+ *  linked. With 0 the producer and the consumer share no variable which both of them write. */
+#define PF_FIFO_COUNT_ENABLE			1
+
 /** \brief FIFO descriptor */
 typedef struct
 {
 	PFbyte* pBegin; 		    /**< pointer to the beginning of storage buffer */
-	PFbyte* volatile pHead; 	/**< pointer to the first element 				*/
-	PFbyte* volatile pTail; 	/**< pointer to the last element 				*/
+	PFbyte* volatile pHead; 	/**< pointer to the first element, moved by the consumer only	*/
+	PFbyte* volatile pTail; 	/**< pointer past the last element, moved by the producer only	*/
 	PFbyte* pEnd;				/**< pointer to the end of storage buffer 		*/
 	PFdword size;				/**< fifo buffer size in bytes					*/
-	PFdword count;  			/**< count of the elements in buffer 			*/
+	PFdword volatile count;		/**< count of the elements in buffer if PF_FIFO_COUNT_ENABLE is 1, for the
+								     prebuilt drivers. It is never used to tell full from empty */
 }PFFifo;
 
 /** \brief Pointer to PFFifo structure		*/
@@ -63,7 +74,8 @@ PFEnStatus pfFifoInit(PFpFifo pFifo, PFbyte* pBuf, PFdword uSize);
 PFdword pfFifoLength(PFpFifo pFifo);
 
 /**
- * This function pushes byte into the FIFO.
+ * This function pushes byte into the FIFO. If the FIFO is full, the oldest byte is dropped with
+ * PF_FIFO_OVERWRITE_ENABLE, otherwise the byte is not pushed.
  *
  * \param pFifo pointer to FIFO descriptor.
  * \param c byte to be pushed.
@@ -114,6 +126,58 @@ PFEnBoolean pfFifoIsEmpty(const PFpFifo pFifo);
  */
 PFEnBoolean pfFifoIsFull(const PFpFifo pFifo);
 
+/**
+ * This function pushes a block of bytes into the FIFO.
+ * The bytes are copied in at most two chunks, as many as there is free space for.
+ * It is to be called by the producer only.
+ *
+ * \param pFifo pointer to FIFO descriptor.
+ * \param pData pointer to the bytes to push.
+ * \param size number of bytes to push.
+ * \param pWritten pointer to load the number of bytes pushed, which is less than size when the FIFO fills.
+ *
+ * \return push status
+ */
+PFEnStatus pfFifoWrite(PFpFifo pFifo, const PFbyte* pData, PFdword size, PFdword* pWritten);
+
+/**
+ * This function pops a block of bytes from the FIFO.
+ * The bytes are copied out in at most two chunks, as many as there are in the FIFO.
+ * It is to be called by the consumer only.
+ *
+ * \param pFifo pointer to FIFO descriptor.
+ * \param pData pointer to the buffer to load the bytes to.
+ * \param size number of bytes to pop.
+ * \param pRead pointer to load the number of bytes popped, which is less than size when the FIFO empties.
+ *
+ * \return pop status
+ */
+PFEnStatus pfFifoRead(PFpFifo pFifo, PFbyte* pData, PFdword size, PFdword* pRead);
+
+/**
+ * This function gives the free space following the last element of the FIFO, without pushing anything.
+ * A producer such as a DMA channel can fill this space directly and then push the bytes with pfFifoCommit().
+ * It is to be called by the producer only.
+ *
+ * \param pFifo pointer to FIFO descriptor.
+ * \param ppData pointer to load the address of the free space.
+ * \param pSize pointer to load the number of contiguous free bytes, zero when the FIFO is full.
+ *
+ * \return peek status
+ */
+PFEnStatus pfFifoPeekContiguous(PFpFifo pFifo, PFbyte** ppData, PFdword* pSize);
+
+/**
+ * This function pushes bytes already written to the space given by pfFifoPeekContiguous().
+ * It is to be called by the producer only.
+ *
+ * \param pFifo pointer to FIFO descriptor.
+ * \param size number of bytes written, not more than the size given by pfFifoPeekContiguous().
+ *
+ * \return commit status
+ */
+PFEnStatus pfFifoCommit(PFpFifo pFifo, PFdword size);
+
 
 /**@}*/
 
@@ -0,0 +1,219 @@
+/**
+ *  \file       prime_gpdma.h
+ *  \brief      General Purpose DMA Controller Driver Discription for LPC1768.
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \defgroup    PF_GPDMA GPDMA
+ * @{
+ *
+ *  \brief      GPDMA driver
+ *  \details    Driver for the 8 channel onchip General Purpose DMA controller of LPC1768.
+ *              Channels are allocated by the drivers which use them, a transfer may be extended
+ *              by a chain of linked list descriptors and the owner of the channel is notified
+ *              through a callback from the DMA interrupt when the chain is complete.
+ *
+ *  \note       The DMA controller can not access the local SRAM at 0x10000000, where the .bss section is placed.
+ *              Buffers and linked list descriptors used by the DMA controller should be placed in the
+ *              AHB SRAM using PF_GPDMA_BUFFER. Constant source data may be placed in flash.
+ */
+
+/** \brief Configuration macros for GPDMA       */
+#define GPDMA_CHANNEL               PERIPH_GPDMA
+#define GPDMA_INT_HANDLER           DMA_IRQHandler
+#define GPDMA_MAX_CHANNELS          8           /**< Number of channels of the controller                  */
+#define GPDMA_MAX_TRANSFER_SIZE     4095        /**< Maximum transfers per descriptor                      */
+
+/** \brief Places a variable in the AHB SRAM so that it is accessible to the DMA controller */
+#define PF_GPDMA_BUFFER             PF_AHB_NOINIT
+
+/** \brief Enumeration for GPDMA transfer types    */
+typedef enum
+{
+    enGpdmaMemToMem = 0,        /**< Memory to memory transfer, flow controlled by DMA      */
+    enGpdmaMemToPeriph,         /**< Memory to peripheral transfer, flow controlled by DMA  */
+    enGpdmaPeriphToMem,         /**< Peripheral to memory transfer, flow controlled by DMA  */
+    enGpdmaPeriphToPeriph,      /**< Peripheral to peripheral transfer, flow controlled by DMA  */
+}PFEnGpdmaTransferType;
+
+/** \brief Enumeration for GPDMA peripheral request connections     */
+typedef enum
+{
+    enGpdmaConnSsp0Tx = 0,      /**< SSP0 transmit          */
+    enGpdmaConnSsp0Rx,          /**< SSP0 receive           */
+    enGpdmaConnSsp1Tx,          /**< SSP1 transmit          */
+    enGpdmaConnSsp1Rx,          /**< SSP1 receive           */
+    enGpdmaConnAdc,             /**< ADC                    */
+    enGpdmaConnI2sCh0,          /**< I2S channel 0          */
+    enGpdmaConnI2sCh1,          /**< I2S channel 1          */
+    enGpdmaConnDac,             /**< DAC                    */
+    enGpdmaConnUart0Tx,         /**< UART0 transmit         */
+    enGpdmaConnUart0Rx,         /**< UART0 receive          */
+    enGpdmaConnUart1Tx,         /**< UART1 transmit         */
+    enGpdmaConnUart1Rx,         /**< UART1 receive          */
+    enGpdmaConnUart2Tx,         /**< UART2 transmit         */
+    enGpdmaConnUart2Rx,         /**< UART2 receive          */
+    enGpdmaConnUart3Tx,         /**< UART3 transmit         */
+    enGpdmaConnUart3Rx,         /**< UART3 receive          */
+    enGpdmaConnMemory = 0xFF,   /**< Memory, no request line */
+}PFEnGpdmaConnection;
+
+/** \brief Enumeration for GPDMA transfer width     */
+typedef enum
+{
+    enGpdmaWidth_8 = 0,         /**< Byte transfers         */
+    enGpdmaWidth_16,            /**< Halfword transfers     */
+    enGpdmaWidth_32,            /**< Word transfers         */
+}PFEnGpdmaWidth;
+
+/** \brief Enumeration for GPDMA burst size     */
+typedef enum
+{
+    enGpdmaBurst_1 = 0,         /**< 1 transfer per burst   */
+    enGpdmaBurst_4,             /**< 4 transfers per burst  */
+    enGpdmaBurst_8,             /**< 8 transfers per burst  */
+    enGpdmaBurst_16,            /**< 16 transfers per burst */
+    enGpdmaBurst_32,            /**< 32 transfers per burst */
+    enGpdmaBurst_64,            /**< 64 transfers per burst */
+    enGpdmaBurst_128,           /**< 128 transfers per burst */
+    enGpdmaBurst_256,           /**< 256 transfers per burst */
+}PFEnGpdmaBurst;
+
+/** \brief GPDMA linked list descriptor, same layout as the channel registers loaded by the controller */
+typedef struct PFGpdmaLli
+{
+    PFdword srcAddr;            /**< Source address                                     */
+    PFdword destAddr;           /**< Destination address                                */
+    PFdword nextLli;            /**< Address of next descriptor, 0 for the last one     */
+    PFdword control;            /**< Channel control word                               */
+}PFGpdmaLli;
+
+/** \brief Callback called from DMA interrupt when the transfer of a channel is complete or has failed */
+typedef void (*PFGpdmaCallback)(PFbyte channel, PFEnStatus status);
+
+/** \brief GPDMA transfer structure      */
+typedef struct
+{
+    PFdword                 srcAddr;        /**< Source address                                     */
+    PFdword                 destAddr;       /**< Destination address                                */
+    PFdword                 size;           /**< Number of transfers, up to GPDMA_MAX_TRANSFER_SIZE  */
+    PFEnGpdmaTransferType   transferType;   /**< Type of transfer                                   */
+    PFEnGpdmaConnection     srcConn;        /**< Source request connection, used for peripheral source          */
+    PFEnGpdmaConnection     destConn;       /**< Destination request connection, used for peripheral destination */
+    PFEnGpdmaWidth          srcWidth;       /**< Source transfer width                              */
+    PFEnGpdmaWidth          destWidth;      /**< Destination transfer width                         */
+    PFEnGpdmaBurst          srcBurst;       /**< Source burst size                                  */
+    PFEnGpdmaBurst          destBurst;      /**< Destination burst size                             */
+    PFEnBoolean             srcIncrement;   /**< Increment source address after each transfer       */
+    PFEnBoolean             destIncrement;  /**< Increment destination address after each transfer  */
+    PFGpdmaLli*             lli;            /**< First descriptor executed after this transfer, NULL if none */
+    PFGpdmaCallback         callback;       /**< Called when the whole chain is complete, may be NULL */
+}PFGpdmaTransfer;
+
+/** \brief Pointer to PFGpdmaTransfer structure         */
+typedef PFGpdmaTransfer* PFpGpdmaTransfer;
+
+/**
+ *  Initializes the GPDMA controller and enables its interrupt
+ *
+ *  \return     GPDMA initialization status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaOpen(void);
+
+/**
+ *  Stops all channels and turns off the GPDMA controller
+ *
+ *  \return     GPDMA close status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaClose(void);
+
+/**
+ *  Allocates a free channel. Lower channel numbers have higher priority,
+ *  so a driver which needs two channels should allocate the more urgent one first.
+ *
+ *  \param      channel     Pointer to load the number of the allocated channel.
+ *
+ *  \return     Allocation status, enStatusNoMem if all channels are in use.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaChannelAlloc(PFbyte* channel);
+
+/**
+ *  Stops a channel and returns it to the free channels
+ *
+ *  \param      channel     Number of the channel.
+ *
+ *  \return     Free status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaChannelFree(PFbyte channel);
+
+/**
+ *  Fills a linked list descriptor from the transfer settings.
+ *  The descriptor continues with transfer->lli, the terminal count interrupt is requested only for the last descriptor.
+ *  Connection, type and callback of the transfer are taken from the transfer passed to pfGpdmaStart().
+ *
+ *  \param      lli         Pointer to descriptor to fill, should be placed in memory accessible to the controller.
+ *  \param      transfer    Pointer to transfer settings of the descriptor.
+ *
+ *  \return     Descriptor setup status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaLliSetup(PFGpdmaLli* lli, PFpGpdmaTransfer transfer);
+
+/**
+ *  Starts a transfer on an allocated channel
+ *
+ *  \param      channel     Number of the channel.
+ *  \param      transfer    Pointer to transfer settings.
+ *
+ *  \return     Start status, enStatusBusy if the channel is still running.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaStart(PFbyte channel, PFpGpdmaTransfer transfer);
+
+/**
+ *  Stops a channel, data in the channel FIFO is lost
+ *
+ *  \param      channel     Number of the channel.
+ *
+ *  \return     Stop status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfGpdmaStop(PFbyte channel);
+
+/**
+ *  Checks if a channel is running
+ *
+ *  \param      channel     Number of the channel.
+ *
+ *  \return     enBooleanTrue if the channel is enabled.
+ */
+PFEnBoolean pfGpdmaIsBusy(PFbyte channel);
+
+/**
+ *  Checks if a memory area can be accessed by the controller
+ *
+ *  \param      address     Start of the memory area.
+ *  \param      size        Size of the memory area in bytes.
+ *
+ *  \return     enBooleanTrue if the area is in AHB SRAM or flash.
+ */
+PFEnBoolean pfGpdmaIsAccessible(const void* address, PFdword size);
+
+/**
+ *  GPDMA interrupt handler, dispatches terminal count and error interrupts to the channel callbacks
+ */
+void GPDMA_INT_HANDLER(void);
+
+/** @} */
@@ -0,0 +1,100 @@
+/**
+ * \file	    prime_idle.h
+ * \brief       Tickless idle sleep.
+ * \copyright   Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module
+ *
+ * Review status: NO
+ *
+ */
+#pragma once
+
+/**
+ *  \ingroup    core
+ *  \defgroup   PF_IDLE Idle sleep
+ *  @{
+ *
+ *  \brief      Sleep with WFI while nothing is to be done, without the periodic tick interrupts
+ *  \details    The tick module is updated by pfTickUpdate() in the RIT interrupt. pfIdleSleep() moves the RIT
+ *              compare value to the end of the given number of ticks and stops the CPU with WFI, so the tick
+ *              interrupts in between do not wake it. When it wakes up, at that match or earlier by any
+ *              other interrupt, such as the touch panel EINT1, the ticks which were not counted are added to
+ *              the tick module with pfTickAdd() and the RIT is given back its period, so the tick value is
+ *              the same as if the CPU had not slept.
+ *
+ *              It is meant for pfSchedSetIdle(), which calls it with interrupts disabled when no task is
+ *              ready, with the ticks left to the nearest task timeout. The RIT must be opened with
+ *              resetOnMatch, started, and the tick module must count one tick per RIT match.
+ *
+ *              The time asleep is counted in RIT clocks, which gives the duty cycle of the CPU.
+ *
+ *              The DWT cycle counter stops during the sleep. pfIdleGetCycles() gives it with the time
+ *              asleep added, a cycle count which goes on at the CPU clock rate through the sleeps.
+ */
+
+/** \brief Idle configuration */
+typedef struct
+{
+	PFdword maxSleepTicks;			/**< longest sleep in ticks, 0 for no limit			*/
+	PFcallback suspend;				/**< called before the sleep, for example to mask periodic interrupts which are not needed, may be NULL	*/
+	PFcallback resume;				/**< called after the sleep, to undo suspend, may be NULL	*/
+}PFCfgIdle;
+
+/** \brief Pointer to PFCfgIdle structure */
+typedef PFCfgIdle* PFpCfgIdle;
+
+/** \brief Idle statistics */
+typedef struct
+{
+	PFdword sleeps;					/**< calls of pfIdleSleep() which slept				*/
+	PFdword earlyWakes;				/**< sleeps ended by another interrupt than the RIT	*/
+	PFdword sleptTicks;				/**< ticks spent asleep								*/
+	PFdword totalTicks;				/**< ticks since pfIdleOpen(), awake time is totalTicks - sleptTicks	*/
+}PFIdleStats;
+
+/**
+ * Initializes the idle module for the running RIT.
+ *
+ * \param config pointer to the configuration structure.
+ *
+ * \return enStatusNotSupported if the RIT does not reset on match, enStatusNotConfigured if it is not
+ *         running, otherwise enStatusSuccess.
+ */
+PFEnStatus pfIdleOpen(PFpCfgIdle config);
+
+/**
+ * Sleeps until an interrupt is pending or the given number of ticks has passed. It must be called with
+ * interrupts disabled, and returns with interrupts disabled; the pending interrupt is taken when they
+ * are enabled again. It returns at once if the tick interrupt is already pending.
+ *
+ * \param ticks ticks to sleep at most, PF_SCHED_NO_TIMEOUT or any large value sleeps up to maxSleepTicks.
+ */
+void pfIdleSleep(PFdword ticks);
+
+/**
+ * Gives the DWT cycle counter plus the CPU cycles spent asleep in pfIdleSleep(), for timestamps which
+ * must not stop while the CPU sleeps, for example those of the trace logger. Before pfIdleOpen() it is
+ * the cycle counter alone. The counter must be started, and it wraps like the cycle counter.
+ *
+ * \return cycles since the cycle counter was started.
+ */
+PFdword pfIdleGetCycles(void);
+
+/**
+ * Reads the statistics.
+ *
+ * \param stats pointer to the structure to fill.
+ *
+ * \return enStatusNotConfigured if the module is not opened, otherwise enStatusSuccess.
+ */
+PFEnStatus pfIdleGetStats(PFIdleStats* stats);
+
+/**
+ * Clears the statistics.
+ */
+void pfIdleResetStats(void);
+
+/**@}*/
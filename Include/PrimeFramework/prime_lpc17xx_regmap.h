@@ -208,6 +208,34 @@ typedef struct
   _RW PFdword DEMCR;                   /*!< Offset: 0x00C (R/W)  Debug Exception and Monitor Control Register */
 } CoreDebug_Type;
 
+/**	\brief  Structure type to access the Data Watchpoint and Trace Register (DWT).	*/
+typedef struct
+{
+  _RW PFdword CTRL;                    /*!< Offset: 0x000 (R/W)  Control Register                          */
+  _RW PFdword CYCCNT;                  /*!< Offset: 0x004 (R/W)  Cycle Count Register                      */
+  _RW PFdword CPICNT;                  /*!< Offset: 0x008 (R/W)  CPI Count Register                        */
+  _RW PFdword EXCCNT;                  /*!< Offset: 0x00C (R/W)  Exception Overhead Count Register         */
+  _RW PFdword SLEEPCNT;                /*!< Offset: 0x010 (R/W)  Sleep Count Register                      */
+  _RW PFdword LSUCNT;                  /*!< Offset: 0x014 (R/W)  LSU Count Register                        */
+  _RW PFdword FOLDCNT;                 /*!< Offset: 0x018 (R/W)  Folded-instruction Count Register         */
+  _R  PFdword PCSR;                    /*!< Offset: 0x01C (R/ )  Program Counter Sample Register           */
+  _RW PFdword COMP0;                   /*!< Offset: 0x020 (R/W)  Comparator Register 0                     */
+  _RW PFdword MASK0;                   /*!< Offset: 0x024 (R/W)  Mask Register 0                           */
+  _RW PFdword FUNCTION0;               /*!< Offset: 0x028 (R/W)  Function Register 0                       */
+       PFdword RESERVED0;
+  _RW PFdword COMP1;                   /*!< Offset: 0x030 (R/W)  Comparator Register 1                     */
+  _RW PFdword MASK1;                   /*!< Offset: 0x034 (R/W)  Mask Register 1                           */
+  _RW PFdword FUNCTION1;               /*!< Offset: 0x038 (R/W)  Function Register 1                       */
+       PFdword RESERVED1;
+  _RW PFdword COMP2;                   /*!< Offset: 0x040 (R/W)  Comparator Register 2                     */
+  _RW PFdword MASK2;                   /*!< Offset: 0x044 (R/W)  Mask Register 2                           */
+  _RW PFdword FUNCTION2;               /*!< Offset: 0x048 (R/W)  Function Register 2                       */
+       PFdword RESERVED2;
+  _RW PFdword COMP3;                   /*!< Offset: 0x050 (R/W)  Comparator Register 3                     */
+  _RW PFdword MASK3;                   /*!< Offset: 0x054 (R/W)  Mask Register 3                           */
+  _RW PFdword FUNCTION3;               /*!< Offset: 0x058 (R/W)  Function Register 3                       */
+} DWT_Type;
+
 // includeing the core reg map Address Macro
 #include "prime_cm3.h"       /* Cortex-M3 processor and core peripherals           */
 
@@ -0,0 +1,148 @@
+/**
+ * \file	    prime_pool.h
+ * \brief       Fixed-block memory pool.
+ * \copyright   Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module
+ *
+ * Review status: NO
+ *
+ */
+#pragma once
+
+/**
+ *  \ingroup    core
+ *  \defgroup   PF_POOL Memory pool
+ *  @{
+ *
+ *  \brief      Blocks of one size taken from a static buffer
+ *  \details    The pool cuts a buffer provided by the application into blockCount blocks of blockSize bytes.
+ *              The free blocks are linked through their first word, so a block is allocated and freed in
+ *              constant time and no heap is needed.
+ *
+ *              pfPoolAlloc() and pfPoolFree() are for pools used by the main loop only. A pool also used by
+ *              interrupt handlers must only be used through pfPoolAllocIsr() and pfPoolFreeIsr(), which take
+ *              and give back blocks with LDREX/STREX. An interrupt taken between the two clears the exclusive
+ *              monitor, so the store fails and the free list is read again.
+ *
+ *              Only the LDREX/STREX path, built for Thumb-2 with GCC, is safe from interrupt handlers. Other
+ *              builds, such as the host tests, fall back to a compare and swap of the head, which is prone to
+ *              ABA: a block allocated and freed again by an interrupt between the read of the head and the swap
+ *              makes the swap succeed with a stale next pointer.
+ *
+ *              The pool is a library API: the framework and the engine do not allocate from a pool themselves.
+ *              The renderer queues its commands in an array in the order they are drawn, and the object Ids
+ *              are handed out from a free bitmap, so neither has a use for blocks freed in any order.
+ */
+
+/** \brief Size of a block holding an object of the given size, rounded up to keep the blocks word aligned */
+#define PF_POOL_BLOCK_SIZE(size)	((((size) < sizeof(void*) ? sizeof(void*) : (size)) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+/** \brief Pool descriptor */
+typedef struct
+{
+	PFbyte* pBegin;					/**< pointer to the beginning of storage buffer	*/
+	PFbyte* pEnd;					/**< pointer past the last block				*/
+	PFdword blockSize;				/**< size of a block in bytes					*/
+	PFdword blockCount;				/**< number of blocks							*/
+	void* volatile pFree;			/**< first free block, NULL when all are used	*/
+	volatile PFdword used;			/**< blocks allocated							*/
+	PFdword highWater;				/**< most blocks allocated at the same time		*/
+	volatile PFdword failures;		/**< allocations which found no free block		*/
+}PFPool;
+
+/** \brief Pointer to PFPool structure		*/
+typedef PFPool *PFpPool;
+
+/** \brief Pool statistics */
+typedef struct
+{
+	PFdword blockCount;				/**< number of blocks							*/
+	PFdword used;					/**< blocks allocated							*/
+	PFdword highWater;				/**< most blocks allocated at the same time		*/
+	PFdword failures;				/**< allocations which found no free block		*/
+}PFPoolStats;
+
+/**
+ * Initializes a pool, all blocks are free. The blocks are allocated in the order of the buffer first.
+ *
+ * \param pPool pointer to pool descriptor to initialize.
+ * \param pBuf pointer to storage buffer of blockSize * blockCount bytes, word aligned.
+ * \param blockSize size of a block, at least the size of a pointer and a multiple of it, see PF_POOL_BLOCK_SIZE().
+ * \param blockCount number of blocks.
+ *
+ * \return pool initialization status
+ */
+PFEnStatus pfPoolInit(PFpPool pPool, void* pBuf, PFdword blockSize, PFdword blockCount);
+
+/**
+ * Allocates a block.
+ *
+ * \param pPool pointer to pool descriptor.
+ *
+ * \return pointer to the block, NULL if no block is free.
+ */
+void* pfPoolAlloc(PFpPool pPool);
+
+/**
+ * Gives a block back to the pool.
+ *
+ * \param pPool pointer to pool descriptor.
+ * \param pBlock pointer to a block allocated from the pool.
+ *
+ * \return enStatusInvArgs if the pointer is not a block of the pool, otherwise enStatusSuccess.
+ */
+PFEnStatus pfPoolFree(PFpPool pPool, void* pBlock);
+
+/**
+ * Allocates a block, it can be called from interrupt handlers.
+ *
+ * \param pPool pointer to pool descriptor.
+ *
+ * \return pointer to the block, NULL if no block is free.
+ */
+void* pfPoolAllocIsr(PFpPool pPool);
+
+/**
+ * Gives a block back to the pool, it can be called from interrupt handlers.
+ *
+ * \param pPool pointer to pool descriptor.
+ * \param pBlock pointer to a block allocated from the pool.
+ *
+ * \return enStatusInvArgs if the pointer is not a block of the pool, otherwise enStatusSuccess.
+ */
+PFEnStatus pfPoolFreeIsr(PFpPool pPool, void* pBlock);
+
+/**
+ * Returns the index of a block in the storage buffer.
+ *
+ * \param pPool pointer to pool descriptor.
+ * \param pBlock pointer to a block of the pool.
+ *
+ * \return index of the block.
+ */
+PFdword pfPoolIndex(PFpPool pPool, const void* pBlock);
+
+/**
+ * Returns the block at an index of the storage buffer, whether it is allocated or not.
+ *
+ * \param pPool pointer to pool descriptor.
+ * \param index index of the block.
+ *
+ * \return pointer to the block, NULL if the index is out of the pool.
+ */
+void* pfPoolBlock(PFpPool pPool, PFdword index);
+
+/**
+ * Reads the statistics of a pool.
+ *
+ * \param pPool pointer to pool descriptor.
+ * \param pStats pointer to the structure to fill.
+ *
+ * \return enStatusInvArgs if a pointer is NULL, otherwise enStatusSuccess.
+ */
+PFEnStatus pfPoolGetStats(PFpPool pPool, PFPoolStats* pStats);
+
+/**@}*/
@@ -0,0 +1,168 @@
+/**
+ * \file	    prime_prof.h
+ * \brief       Cycle counting profiler.
+ * \copyright   Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module
+ *
+ * Review status: NO
+ *
+ */
+#pragma once
+
+/**
+ *  \ingroup    core
+ *  \defgroup   PF_PROF Profiler
+ *  @{
+ *
+ *  \brief      Time spent in sections of code
+ *  \details    A section is measured between PF_PROF_BEGIN() and PF_PROF_END(), or from PF_PROF_SCOPE() to
+ *              the end of the enclosing block. Each section gets an entry of a static table on its first
+ *              run, which keeps the number of runs and the minimum, maximum and total duration, and with
+ *              PF_PROF_HISTOGRAM a histogram of the durations. pfProfDump() writes the table as text,
+ *              for example to pfUart0Write().
+ *
+ *              On the Cortex-M3 the durations are CPU cycles counted by the DWT cycle counter. The counter
+ *              stops while the CPU sleeps with WFI, so they are awake time only: a section which sleeps, in
+ *              pfIdleSleep() or waiting for an interrupt, is shorter than the time it takes. On other
+ *              targets, such as a Linux host running the same code, they are nanoseconds from
+ *              clock_gettime().
+ *
+ *              The macros compile to nothing unless PF_PROF_ENABLE is 1, so the sections can stay in the
+ *              code. An entry is updated without disabling interrupts, so a section must not be run both
+ *              from an interrupt handler and from the code it interrupts.
+ */
+
+/** \brief Macro to enable the measurement macros */
+#ifndef PF_PROF_ENABLE
+#define PF_PROF_ENABLE				0
+#endif
+
+/** \brief Macro to enable the histogram of the durations of each entry */
+#ifndef PF_PROF_HISTOGRAM
+#define PF_PROF_HISTOGRAM			0
+#endif
+
+/** \brief Size of the entry table */
+#define PF_PROF_MAX_ENTRIES			16
+
+/** \brief Histogram bins. Bin 0 counts durations below 2^PF_PROF_HIST_SHIFT, bin n durations of
+ *  n + PF_PROF_HIST_SHIFT bits, and the last bin the longer ones. */
+#define PF_PROF_HIST_BINS			16
+#define PF_PROF_HIST_SHIFT			6
+
+/** \brief Id of a section which has no entry yet */
+#define PF_PROF_NO_ENTRY			0xFF
+
+/** \brief Profiler entry */
+typedef struct
+{
+	const char* name;				/**< name of the section						*/
+	PFdword count;					/**< runs of the section						*/
+	PFdword min;					/**< shortest duration							*/
+	PFdword max;					/**< longest duration							*/
+	PFqword total;					/**< sum of the durations						*/
+#if PF_PROF_HISTOGRAM
+	PFdword histogram[PF_PROF_HIST_BINS];	/**< runs per duration bin				*/
+#endif
+}PFProfEntry;
+
+/** \brief Section measured up to the end of a block, used by PF_PROF_SCOPE() */
+typedef struct
+{
+	PFbyte* pId;					/**< entry id of the section					*/
+	const char* name;				/**< name of the section						*/
+	PFdword start;					/**< counter at the beginning					*/
+}PFProfScope;
+
+/** \brief Function writing the text of pfProfDump(), for example pfUart0Write */
+typedef PFEnStatus (*PFProfWrite)(PFbyte* data, PFdword size);
+
+#if defined(__arm__)
+/**
+ * Returns the cycle counter.
+ */
+PF_C_STATIC_INLINE PFdword pfProfCounter(void)
+{
+	return DWT->CYCCNT;
+}
+#else
+/**
+ * Returns a counter of nanoseconds.
+ */
+PFdword pfProfCounter(void);
+#endif
+
+#if PF_PROF_ENABLE
+/** \brief Starts the section of the given name, an identifier unique in the function */
+#define PF_PROF_BEGIN(name)			static PFbyte pfProfId_##name = PF_PROF_NO_ENTRY; \
+									PFdword pfProfStart_##name = pfProfCounter()
+
+/** \brief Ends the section of the given name, in the same block as PF_PROF_BEGIN() */
+#define PF_PROF_END(name)			pfProfRecord(&pfProfId_##name, #name, pfProfCounter() - pfProfStart_##name)
+
+/** \brief Starts a section of the given name which ends with the enclosing block */
+#define PF_PROF_SCOPE(name)			static PFbyte pfProfId_##name = PF_PROF_NO_ENTRY; \
+									PFProfScope pfProfScope_##name __attribute__((cleanup(pfProfScopeEnd))) = \
+										{ &pfProfId_##name, #name, pfProfCounter() }
+#else
+#define PF_PROF_BEGIN(name)
+#define PF_PROF_END(name)
+#define PF_PROF_SCOPE(name)
+#endif
+
+/**
+ * Enables the counter and measures the time taken by reading it, which is removed from the durations.
+ */
+void pfProfInit(void);
+
+/**
+ * Adds a duration to the entry of a section, used by the macros.
+ *
+ * \param pId entry id of the section, PF_PROF_NO_ENTRY to take a free entry.
+ * \param name name of the section.
+ * \param duration duration of the run, in counter units.
+ *
+ * \return enStatusNoMem if the table is full, otherwise enStatusSuccess.
+ */
+PFEnStatus pfProfRecord(PFbyte* pId, const char* name, PFdword duration);
+
+/**
+ * Ends a section started by PF_PROF_SCOPE(), called at the end of the block.
+ *
+ * \param scope pointer to the section.
+ */
+void pfProfScopeEnd(PFProfScope* scope);
+
+/**
+ * Clears the measurements of all entries, the sections keep their entries.
+ */
+void pfProfReset(void);
+
+/**
+ * Reads an entry.
+ *
+ * \param index index of the entry, from 0 to pfProfGetCount() - 1.
+ * \param entry pointer to the structure to fill.
+ *
+ * \return enStatusInvArgs if there is no such entry, otherwise enStatusSuccess.
+ */
+PFEnStatus pfProfGetEntry(PFbyte index, PFProfEntry* entry);
+
+/**
+ * Returns the number of entries in use.
+ */
+PFbyte pfProfGetCount(void);
+
+/**
+ * Writes the table as text, one line per entry: name, runs, minimum, average, maximum and total.
+ *
+ * \param write function writing a line.
+ *
+ * \return status of the first write which failed, otherwise enStatusSuccess.
+ */
+PFEnStatus pfProfDump(PFProfWrite write);
+
+/**@}*/
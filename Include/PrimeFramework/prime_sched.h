@@ -0,0 +1,179 @@
+/**
+ * \file	    prime_sched.h
+ * \brief       Cooperative task scheduler.
+ * \copyright   Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ * 
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module
+ * 
+ * Review status: NO
+ *
+ */
+#pragma once
+
+/**
+ *  \ingroup    core
+ *  \defgroup   PF_SCHED Scheduler
+ *  @{
+ *  
+ *  \brief      Run-to-yield tasks on a single stack
+ *  \details    A task is a function which is called again and again by the scheduler. The PF_TASK_ macros make
+ *              the function a stackless coroutine: a wait or yield returns to the scheduler, and the next call
+ *              resumes after it. Local variables of the function are not kept across a wait, state which must be
+ *              kept goes in the context of the task or in static variables. A switch statement cannot be used
+ *              around a wait.
+ *
+ *              A waiting task is called again when one of its wake conditions holds: its tick timeout expired,
+ *              its FIFO is not empty, or one of its event flags was set, for example by an interrupt handler with
+ *              pfSchedSetFlags(). Timeouts use the tick module, which is updated by pfTickUpdate().
+ *
+ *              The task descriptors are provided by the application and the scheduler keeps PF_SCHED_MAX_TASKS
+ *              pointers, so the memory used is known at compile time.
+ *
+ *              When a round of pfSchedRun() calls no task, the idle function set by pfSchedSetIdle() is called
+ *              with interrupts disabled and the ticks left to the nearest timeout, for example pfIdleSleep().
+ *              As the wake conditions are checked again with interrupts disabled, a flag set by a handler just
+ *              before the sleep is not missed: its interrupt ends the sleep at once.
+ */
+
+#include "prime_fifo.h"
+
+/** \brief Maximum number of tasks added at the same time */
+#define PF_SCHED_MAX_TASKS			8
+
+/** \brief Wake conditions of a waiting task */
+#define PF_SCHED_WAIT_TIMEOUT		0x01	/**< tick timeout 				*/
+#define PF_SCHED_WAIT_FIFO			0x02	/**< FIFO not empty 			*/
+#define PF_SCHED_WAIT_FLAGS			0x04	/**< event flag set 			*/
+
+/** \brief Ticks given to the idle function when no task waits with a timeout */
+#define PF_SCHED_NO_TIMEOUT			0xFFFFFFFF
+
+/** \brief Value returned by a task function, given by the PF_TASK_ macros */
+typedef enum
+{
+	enSchedTaskWaiting = 0,			/**< task waits for a wake condition		*/
+	enSchedTaskYielded,				/**< task is ready to run again				*/
+	enSchedTaskDone					/**< task ended, it is removed				*/
+}PFEnSchedTaskState;
+
+typedef struct PFSchedTask PFSchedTask;
+
+/** \brief Task function */
+typedef PFEnSchedTaskState (*PFSchedTaskFunction)(PFSchedTask* task);
+
+/** \brief Idle function, called with interrupts disabled and the ticks to the nearest timeout */
+typedef void (*PFSchedIdleFunction)(PFdword ticks);
+
+/** \brief Task descriptor */
+struct PFSchedTask
+{
+	PFSchedTaskFunction function;	/**< task function								*/
+	void* context;					/**< pointer given to pfSchedAdd() for the task	*/
+	PFword resume;					/**< resume point of the task function			*/
+	PFbyte wait;					/**< wake conditions, PF_SCHED_WAIT_ flags		*/
+	PFdword wakeTick;				/**< tick of the timeout						*/
+	PFpFifo wakeFifo;				/**< FIFO waited for							*/
+	PFdword wakeFlags;				/**< event flags waited for						*/
+	volatile PFdword flags;			/**< event flags set by pfSchedSetFlags()		*/
+	PFdword runs;					/**< times the task function was called			*/
+	PFdword maxLateTicks;			/**< longest delay between a timeout and the call of the task	*/
+};
+
+/** \brief Starts the task function, must be the first statement of the function */
+#define PF_TASK_BEGIN(task)				switch ((task)->resume) { case 0:
+
+/** \brief Ends the task function, must be the last statement of the function. The task is removed. */
+#define PF_TASK_END(task)				} (task)->resume = 0; return enSchedTaskDone
+
+/** \brief Returns to the scheduler, the task is called again in the next round */
+#define PF_TASK_YIELD(task)				do { (task)->wait = 0; (task)->resume = __LINE__; return enSchedTaskYielded; \
+											 case __LINE__: ; } while (0)
+
+/** \brief Returns to the scheduler until the condition is true. The condition is checked in every round. */
+#define PF_TASK_WAIT_UNTIL(task, cond)	do { (task)->wait = 0; (task)->resume = __LINE__; case __LINE__: \
+											 if (!(cond)) { return enSchedTaskYielded; } } while (0)
+
+/** \brief Returns to the scheduler for the given time in milliseconds */
+#define PF_TASK_SLEEP_MS(task, ms)		do { pfSchedWait((task), PF_SCHED_WAIT_TIMEOUT, (ms)); (task)->resume = __LINE__; \
+											 return enSchedTaskWaiting; case __LINE__: ; } while (0)
+
+/** \brief Returns to the scheduler until the FIFO is not empty, or the timeout in milliseconds if not 0 expires */
+#define PF_TASK_WAIT_FIFO(task, fifo, ms)	do { (task)->wakeFifo = (fifo); \
+											 pfSchedWait((task), PF_SCHED_WAIT_FIFO | (((ms) != 0) ? PF_SCHED_WAIT_TIMEOUT : 0), (ms)); \
+											 (task)->resume = __LINE__; return enSchedTaskWaiting; case __LINE__: ; } while (0)
+
+/** \brief Returns to the scheduler until one of the event flags is set, or the timeout in milliseconds if not 0 expires.
+ *  The flags are not cleared, see pfSchedTakeFlags(). */
+#define PF_TASK_WAIT_FLAGS(task, mask, ms)	do { (task)->wakeFlags = (mask); \
+											 pfSchedWait((task), PF_SCHED_WAIT_FLAGS | (((ms) != 0) ? PF_SCHED_WAIT_TIMEOUT : 0), (ms)); \
+											 (task)->resume = __LINE__; return enSchedTaskWaiting; case __LINE__: ; } while (0)
+
+/**
+ * Adds a task to the scheduler. Tasks are called in the order they were added.
+ *
+ * \param task pointer to the task descriptor, it must stay valid while the task is added.
+ * \param function task function.
+ * \param context pointer which the task function gets in its descriptor.
+ *
+ * \return add status, enStatusNoMem if PF_SCHED_MAX_TASKS tasks are added
+ */
+PFEnStatus pfSchedAdd(PFSchedTask* task, PFSchedTaskFunction function, void* context);
+
+/**
+ * Removes a task from the scheduler.
+ *
+ * \param task pointer to the task descriptor.
+ *
+ * \return remove status, enStatusInvArgs if the task is not added
+ */
+PFEnStatus pfSchedRemove(PFSchedTask* task);
+
+/**
+ * Sets the wake conditions of a task. It is used by the PF_TASK_ wait macros.
+ *
+ * \param task pointer to the task descriptor.
+ * \param wait wake conditions, PF_SCHED_WAIT_ flags.
+ * \param timeoutMs timeout in milliseconds with PF_SCHED_WAIT_TIMEOUT.
+ */
+void pfSchedWait(PFSchedTask* task, PFbyte wait, PFdword timeoutMs);
+
+/**
+ * Sets event flags of a task. It can be called from interrupt handlers.
+ *
+ * \param task pointer to the task descriptor.
+ * \param mask flags to set.
+ */
+void pfSchedSetFlags(PFSchedTask* task, PFdword mask);
+
+/**
+ * Clears event flags of a task and returns the ones which were set.
+ *
+ * \param task pointer to the task descriptor.
+ * \param mask flags to clear.
+ *
+ * \return flags of the mask which were set.
+ */
+PFdword pfSchedTakeFlags(PFSchedTask* task, PFdword mask);
+
+/**
+ * Calls every task which is ready once.
+ *
+ * \return enBooleanTrue if a task was called, otherwise enBooleanFalse.
+ */
+PFEnBoolean pfSchedRunOnce(void);
+
+/**
+ * Sets the function called by pfSchedRun() when no task is ready.
+ *
+ * \param idle idle function, NULL to keep calling pfSchedRunOnce().
+ */
+void pfSchedSetIdle(PFSchedIdleFunction idle);
+
+/**
+ * Calls the tasks for ever, and the idle function when none is ready.
+ */
+PF_C_NORETURN void pfSchedRun(void);
+
+/**@}*/
@@ -0,0 +1,90 @@
+/**
+ *  \file       prime_spi0Dma.h
+ *  \brief      DMA transfer mode of the SPI 0 Driver for LPC1768.
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+/**
+ * \ingroup     PF_SPI0
+ * \defgroup    PF_SPI0_DMA SPI0 DMA
+ * @{
+ *
+ *  \brief      SPI0 DMA transfer mode
+ *  \details    Moves blocks of 8 bit frames between memory and the SSP0 channel with two GPDMA channels,
+ *              one for receive and one for transmit. The receive channel has the higher priority so that
+ *              the receive FIFO never overruns. A transfer is complete when the last frame is received.
+ *
+ *  \note       SPI0 and GPDMA should be opened before calling pfSpi0DmaOpen(). The chip select of the device
+ *              should be asserted with pfSpi0ChipSelect() before a transfer and no other SPI0 function should be
+ *              called while a transfer is running.
+ */
+
+#include "prime_gpdma.h"
+
+/**
+ *  Allocates the GPDMA channels used by SPI0
+ *
+ *  \return     SPI0 DMA initialization status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfSpi0DmaOpen(void);
+
+/**
+ *  Frees the GPDMA channels used by SPI0
+ *
+ *  \return     SPI0 DMA close status.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfSpi0DmaClose(void);
+
+/**
+ *  Starts a transfer and returns without waiting for it
+ *
+ *  \param      txData      Pointer to data to send, 0xFF is sent for every frame if NULL.
+ *  \param      rxData      Pointer to buffer for received data, received data is discarded if NULL.
+ *  \param      size        Number of bytes to exchange, up to GPDMA_MAX_TRANSFER_SIZE.
+ *  \param      callback    Called from DMA interrupt when the transfer is complete, may be NULL.
+ *
+ *  \return     Start status, enStatusNotSupported if a buffer is not accessible to the DMA controller,
+ *              enStatusBusy if a transfer is running.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfSpi0DmaStart(PFbyte* txData, PFbyte* rxData, PFdword size, PFcallback callback);
+
+/**
+ *  Checks if a transfer is running
+ *
+ *  \return     enBooleanTrue if a transfer is running.
+ */
+PFEnBoolean pfSpi0DmaIsBusy(void);
+
+/**
+ *  Gets the status of the last transfer
+ *
+ *  \return     enStatusBusy while the transfer is running, enStatusSuccess or enStatusError when it is over.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfSpi0DmaGetStatus(void);
+
+/**
+ *  Exchanges a block of data and waits for the transfer to complete
+ *
+ *  \param      txData          Pointer to data to send, 0xFF is sent for every frame if NULL.
+ *  \param      rxData          Pointer to buffer for received data, received data is discarded if NULL.
+ *  \param      size            Number of bytes to exchange, up to GPDMA_MAX_TRANSFER_SIZE.
+ *  \param      waitCallback    Called repeatedly while the transfer runs. If NULL, the core sleeps until the
+ *                              DMA interrupt ends the transfer, it should not be called with interrupts masked.
+ *
+ *  \return     Transfer status, enStatusNotSupported if a buffer is not accessible to the DMA controller.
+ *  \see        PFEnStatus
+ */
+PFEnStatus pfSpi0DmaTransfer(PFbyte* txData, PFbyte* rxData, PFdword size, PFcallback waitCallback);
+
+/** @} */
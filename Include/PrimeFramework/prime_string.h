@@ -23,6 +23,7 @@
 
 /**
  * Copies the values of \a num bytes from the location pointed by \a src directly to the memory block pointed by \a dest.
+ * The blocks should not overlap, see pfMemMove().
  *
  * \param dest Pointer to the destination array where the content is to be copied.
  * \param src Pointer to the source of data to be copied. 
@@ -43,6 +44,41 @@ PFEnStatus pfMemCopy(void* dest, const void* src, PFdword num);
  */
 PFEnStatus pfMemSet(void* ptr, PFbyte value, PFdword num); 
 
+/**
+ * Copies the values of \a num bytes from the location pointed by \a src to the memory block pointed by \a dest.
+ * The blocks may overlap.
+ *
+ * \param dest Pointer to the destination array where the content is to be copied.
+ * \param src Pointer to the source of data to be copied.
+ * \param num Number of bytes to copy.
+ *
+ * \return Status for memory move
+ */
+PFEnStatus pfMemMove(void* dest, const void* src, PFdword num);
+
+/**
+ * Sets the first \a num halfwords of the block of memory pointed by \a ptr to the specified \a value,
+ * for instance to fill a buffer of RGB565 pixels.
+ *
+ * \param ptr Pointer to the block of memory to fill, aligned to 2 bytes.
+ * \param value Value to be set.
+ * \param num Number of halfwords to be set to the \a value.
+ *
+ * \return Status for memory set
+ */
+PFEnStatus pfMemSet16(void* ptr, PFword value, PFdword num);
+
+/**
+ * Sets the first \a num words of the block of memory pointed by \a ptr to the specified \a value.
+ *
+ * \param ptr Pointer to the block of memory to fill, aligned to 4 bytes.
+ * \param value Value to be set.
+ * \param num Number of words to be set to the \a value.
+ *
+ * \return Status for memory set
+ */
+PFEnStatus pfMemSet32(void* ptr, PFdword value, PFdword num);
+
 /**
  * Compares the first \a num bytes of the block of memory pointed by \a ptr1 to the first \a num bytes pointed by \a ptr2, 
  * and returns \a enBooleanTrue if all values are equal else \a enBooleanFalse.
@@ -40,11 +40,35 @@ void pfTickSetTimerPeriod(PFdword timerPeriod);
  */
 void pfTickUpdate(void);
 
+/**
+ * Adds ticks to the tick value, for the periods the timer interrupt did not count, for example
+ * while the idle module slept with the interrupt held off. Call it with interrupts disabled.
+ *
+ * \param ticks number of periods to add
+ */
+void pfTickAdd(PFdword ticks);
+
 /**
  * Resets tick value to zero
  */
 void pfTickReset(void);
 
+/**
+ * Returns the current tick value.
+ *
+ * \return number of timer periods counted since the last reset
+ */
+PFdword pfTickGet(void);
+
+/**
+ * Converts a time in milli seconds to a number of ticks, as pfTickSetTimeoutMs() does.
+ *
+ * \param time time in milli seconds.
+ *
+ * \return number of ticks, at least 1, or 0 if the timer period is not set
+ */
+PFdword pfTickMsToTicks(PFdword time);
+
 /**
  * Set timeout value. 
  * This will calculate the number ticks required depending on the timer period set 
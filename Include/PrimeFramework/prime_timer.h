@@ -0,0 +1,122 @@
+/**
+ * \file	    prime_timer.h
+ * \brief       Software timers.
+ * \copyright   Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module
+ *
+ * Review status: NO
+ *
+ */
+#pragma once
+
+/**
+ *  \ingroup    core
+ *  \defgroup   PF_TIMER Software timers
+ *  @{
+ *
+ *  \brief      Callbacks called after a time, once or periodically
+ *  \details    The timers are kept in a hierarchical timing wheel of PF_TIMER_LEVELS levels of
+ *              PF_TIMER_SLOTS slots. A timer is put in the slot of its expiry tick on the lowest level
+ *              which reaches it, and moved one level down each time the level below goes round, so
+ *              starting, stopping and advancing the wheel by one tick take a constant time whatever the
+ *              number of timers.
+ *
+ *              The wheel follows the tick module, updated by pfTickUpdate() in the timer interrupt, but it
+ *              is advanced by pfTimerProcess() from the main loop or a scheduler task, which also calls the
+ *              callbacks. A late call of pfTimerProcess() catches up tick by tick, so timers fire late but
+ *              in order. The timer functions must not be called from interrupt handlers; a handler can
+ *              wake a task with pfSchedSetFlags() instead.
+ *
+ *              The timer descriptors are provided by the application, so their number is only limited
+ *              by memory. Timeouts longer than PF_TIMER_LEVELS * PF_TIMER_SLOT_BITS bits of ticks are
+ *              supported, the timer is then moved down from the top level more than once.
+ */
+
+/** \brief Slots of a level of the wheel, as a power of 2 */
+#define PF_TIMER_SLOT_BITS			6
+#define PF_TIMER_SLOTS				(1UL << PF_TIMER_SLOT_BITS)
+
+/** \brief Levels of the wheel, the wheel reaches PF_TIMER_SLOT_BITS * PF_TIMER_LEVELS bits of ticks */
+#define PF_TIMER_LEVELS				4
+
+/** \brief Value of pfTimerGetIdleTicks() when no timer runs */
+#define PF_TIMER_NO_EXPIRY			0xFFFFFFFF
+
+typedef struct PFTimer PFTimer;
+
+/** \brief Timer callback */
+typedef void (*PFTimerCallback)(PFTimer* timer);
+
+/** \brief Timer descriptor */
+struct PFTimer
+{
+	PFTimer* pNext;					/**< next timer of the slot						*/
+	PFTimer** ppPrev;				/**< link pointing to the timer, NULL when stopped	*/
+	PFTimerCallback callback;		/**< function called at expiry					*/
+	void* context;					/**< pointer given to pfTimerStart() for the timer	*/
+	PFdword expires;				/**< tick of the expiry							*/
+	PFdword period;					/**< period in ticks, 0 for a one shot timer	*/
+};
+
+/**
+ * Initializes the timer service. The tick period must be set with pfTickSetTimerPeriod() before.
+ */
+void pfTimerInit(void);
+
+/**
+ * Starts a timer, or restarts it if it is running.
+ *
+ * \param timer pointer to the timer descriptor, which must stay valid while the timer runs. It must be zero
+ *        filled before its first start, as static variables are.
+ * \param callback function called at expiry.
+ * \param context pointer kept in the descriptor for the callback.
+ * \param timeMs time to the expiry in milli seconds, rounded down to ticks with at least one tick.
+ * \param periodic enBooleanTrue to start the timer again at each expiry, timeMs after the last one.
+ *
+ * \return enStatusNotConfigured if the tick period is not set, otherwise enStatusSuccess.
+ */
+PFEnStatus pfTimerStart(PFTimer* timer, PFTimerCallback callback, void* context, PFdword timeMs, PFEnBoolean periodic);
+
+/**
+ * Stops a timer. It can be called from a callback, for any timer.
+ *
+ * \param timer pointer to the timer descriptor.
+ */
+void pfTimerStop(PFTimer* timer);
+
+/**
+ * Tells whether a timer is running.
+ *
+ * \param timer pointer to the timer descriptor.
+ *
+ * \return enBooleanTrue if the timer is started and has not expired.
+ */
+PFEnBoolean pfTimerIsRunning(const PFTimer* timer);
+
+/**
+ * Advances the wheel up to the current tick and calls the callbacks of the expired timers.
+ *
+ * \return number of callbacks called.
+ */
+PFdword pfTimerProcess(void);
+
+/**
+ * Gives the ticks from now to the next tick at which pfTimerProcess() has work to do, so that the
+ * caller can sleep until then. The tick of a cascade from an upper level counts as work.
+ *
+ * \return ticks to wait, 0 if pfTimerProcess() is late, PF_TIMER_NO_EXPIRY if no timer runs.
+ */
+PFdword pfTimerGetIdleTicks(void);
+
+/**
+ * Sets a function called by pfTimerStart(), for example to wake the task sleeping until the time
+ * given by pfTimerGetIdleTicks(), which may be later than the new expiry.
+ *
+ * \param notify function to call, NULL for none.
+ */
+void pfTimerSetNotify(PFcallback notify);
+
+/**@}*/
@@ -43,10 +43,18 @@ typedef unsigned char       PFuint8;
 typedef unsigned short      PFuint16;
 /** Architecture independent signed 16-bit integer type */
 typedef short               PFint16;
+/* long is 64-bit on 64-bit hosts, where the host tests are built */
+#if defined(__LP64__)
+/** Architecture independent unsigned 32-bit integer type */
+typedef unsigned int        PFuint32;
+/** Architecture independent signed 32-bit integer type */
+typedef int                 PFint32;
+#else
 /** Architecture independent unsigned 32-bit integer type */
 typedef unsigned long       PFuint32;
 /** Architecture independent signed 32-bit integer type */
 typedef long                PFint32;
+#endif
 /** Architecture independent signed 64-bit integer type */
 typedef long long           PFint64;
 /** Architecture independent unsigned 64-bit integer type */
@@ -61,10 +69,17 @@ typedef unsigned char       PFbyte;
 typedef short               PFsword;
 /** Architecture independent unsigned 16-bit integer type */
 typedef unsigned short      PFword;
+#if defined(__LP64__)
+/** Architecture independent signed 32-bit integer type */
+typedef int                 PFsdword;
+/** Architecture independent unsigned 32-bit integer type */
+typedef unsigned int        PFdword;
+#else
 /** Architecture independent signed 32-bit integer type */
 typedef long                PFsdword;
 /** Architecture independent unsigned 32-bit integer type */
 typedef unsigned long       PFdword;
+#endif
 /** Architecture independent signed 64-bit integer type */
 typedef long long           PFsqword;
 /** Architecture independent unsigned 64-bit integer type */
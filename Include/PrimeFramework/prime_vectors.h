@@ -1,5 +1,6 @@
 #pragma once
 
+void ResetHandler (void);
 void NMI_Handler (void);
 void HardFault_Handler (void);
 void MemManage_Handler (void);
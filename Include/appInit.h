@@ -5,6 +5,8 @@
  *  Include this file in the application program in the beginning. This file provides a DEBUG_WRITE MACRO which
  *  can be used to print debug messages over UART channel.
  *  Set PRIME_DEBUG MACRO equal to 1 in the project's makefile to use the DEBUG_WRITE MACRO.
+ *  The DEBUG_TRACE MACRO records an event of traceEvents.h in the trace logger instead, which does not
+ *  block the caller and can be used in interrupt handlers. Tools/traceDecode.py prints the events on the host.
  *
  */
 
@@ -14,10 +16,15 @@
 #include "prime_sysClk.h"
 #include "prime_gpio.h"
 #include "prime_tick.h"
+#include "prime_timer.h"
+#include "prime_idle.h"
+#include "prime_prof.h"
 #include "prime_uart0.h"
 #include "prime_rit.h"
 #include "prime_timer0.h"
 #include "prime_spi0.h"
+#include "prime_gpdma.h"
+#include "prime_spi0Dma.h"
 #include "prime_i2c0.h"
 #include "prime_eint1.h"
 #include "graphics.h"
@@ -27,21 +34,49 @@
 #include "buzzer.h"
 #include "diskIo.h"
 #include "mmc.h"
+#include "spiBus.h"
 #include "fatFs.h"
+#include "trace.h"
+#include "traceEvents.h"
+#include "bootManager.h"
 
 #include "eduarmBoardDefs.h"
 #include "eduarmBoardConfig.h"
 
 #ifdef PRIME_DEBUG
 	#define DEBUG_WRITE(x) pfUart0WriteString(x) 
+	#define DEBUG_TRACE(id, arg1, arg2) traceEvent(id, arg1, arg2)
 #else
 	#define DEBUG_WRITE(x)
+	#define DEBUG_TRACE(id, arg1, arg2)
 #endif
 
+/** Boot stages of appInit(), ids for bootRequire() */
+typedef enum
+{
+	enAppBootTick = 0,		/**< RIT, tick module, software timers and idle sleep */
+	enAppBootLcd,			/**< LCD */
+	enAppBootTimer0,		/**< Timer0 of the Renderer Manager */
+	enAppBootSpi,			/**< SPI0, SPI0 bus arbiter, GPDMA and SPI0 DMA */
+	enAppBootTouch,			/**< Touch panel and its external interrupt */
+	enAppBootSdcard,		/**< SDcard and Fat file system, in the background */
+	enAppBootAccel,			/**< I2C0 and accelerometer, in the background */
+	enAppBootKeypad,		/**< Keypad */
+	enAppBootBuzzer,		/**< Buzzer */
+	enAppBootCount
+}AppBootStage;
+
 /** 
   * \brief This function initializes all the peripherals needed in the application.
+  * The stages of the SDcard and the accelerometer are left to bootRunBackground().
   * 
   * \param none 
   * \return none
   */
 void appInit(void);
+
+/**
+  * \brief Function called from the touch panel interrupt, set by the application before it enables
+  * the interrupt with pfEint1Enable(). It must be short, for example waking the task reading the touches.
+  */
+extern PFcallback appTouchHook;
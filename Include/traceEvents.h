@@ -0,0 +1,44 @@
+/**
+ *  \file       traceEvents.h
+ *  \brief      Trace events of the application.
+ *  Each TRACE_EVENT() line gives the name of an event and the format its two arguments are printed with
+ *  on the host. The ids are numbered in the order of the lines, and Tools/traceDecode.py builds its
+ *  table from this file, so new events should be added at the end.
+ *
+ */
+
+#pragma once
+
+#define TRACE_EVENT_TABLE                                                                   \
+    TRACE_EVENT(enTraceBoot,            "boot, cpu clock %u Hz")                            \
+    TRACE_EVENT(enTraceRitInit,         "RIT initialized")                                  \
+    TRACE_EVENT(enTraceTimer0Init,      "Timer0 initialized")                               \
+    TRACE_EVENT(enTraceSpi0Init,        "SPI0 initialized")                                 \
+    TRACE_EVENT(enTraceSpiBusInit,      "SPI0 bus arbiter initialized")                     \
+    TRACE_EVENT(enTraceGpdmaInit,       "GPDMA initialized")                                \
+    TRACE_EVENT(enTraceSpi0DmaInit,     "SPI0 DMA initialized")                             \
+    TRACE_EVENT(enTraceI2c0Init,        "I2C0 initialized")                                 \
+    TRACE_EVENT(enTraceBuzzerInit,      "Buzzer initialized")                               \
+    TRACE_EVENT(enTraceLcdInit,         "LCD initialized")                                  \
+    TRACE_EVENT(enTraceTouchInit,       "Touch panel initialized")                          \
+    TRACE_EVENT(enTraceAccelInit,       "Accelerometer initialized")                        \
+    TRACE_EVENT(enTraceEint1Init,       "Touch External interrupt initialized")             \
+    TRACE_EVENT(enTraceKeypadInit,      "Keypad initialized")                               \
+    TRACE_EVENT(enTraceDiskInit,        "DiskIO initialized")                               \
+    TRACE_EVENT(enTraceFatInit,         "FatFS initialized")                                \
+    TRACE_EVENT(enTraceBootDone,        "boot done in %u ms")                               \
+    TRACE_EVENT(enTraceTouch,           "touch x %u y %u")                                  \
+    TRACE_EVENT(enTraceSaveDone,        "image saved, %u bytes/s")                          \
+    TRACE_EVENT(enTraceGallery,         "gallery page %u drawn in %u ms")                   \
+    TRACE_EVENT(enTraceBootStage,       "boot stage %u done in %u cycles")                  \
+    TRACE_EVENT(enTraceBootFailed,      "boot stage %u failed, status %u")                  \
+    TRACE_EVENT(enTraceBootFrame,       "first frame at %u cycles, boot done at %u cycles")
+
+/** Trace event ids */
+typedef enum
+{
+#define TRACE_EVENT(name, format)   name,
+    TRACE_EVENT_TABLE
+#undef TRACE_EVENT
+    enTraceEventCount
+}TraceEventId;
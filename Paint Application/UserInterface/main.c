@@ -1,11 +1,39 @@
 
 #include "app.h"
 #include "gameEngine.h"
-
-PFbyte windowID, canvasID, widget1ID, widget2ID, widget3ID, widget4ID, widget5ID, widget6ID;
+#include "stroke.h"
+#include "bmpSave.h"
+#include "bmpImage.h"
+#include "thumbnail.h"
+#include "shadowCanvas.h"
+#include "prime_sched.h"
+
+PFbyte windowID, canvasID, widget1ID, widget2ID, widget3ID, widget4ID, widget5ID, widget6ID, widget7ID;
 PFdword i, j, a1, b1, a2, b2;
 char shape = 'f';
 int cnt = 0;
+Stroke freeHandStroke;
+static BmpSaveJob saveJob PF_GPDMA_BUFFER;   // In AHB RAM so the SDcard driver writes its chunks by DMA
+PFEnBoolean saveRunning = enBooleanFalse;
+PFbyte saveFailures = 0;
+#define SAVE_MAX_RETRIES 3
+#define SAVE_TEXT_X 175
+#define SAVED_POPUP_MS 2000
+PFEnBoolean galleryOpen = enBooleanFalse;
+char canvasGesture = 0;     // Shape drawn by the touch going on, 'g' for a gallery cell, 0 if none
+PFword galleryFirst = 0;
+#define GALLERY_CELLS 9
+static PFSchedTask touchTask, saveTask, traceTask, timerTask, bootTask;
+#if PF_PROF_ENABLE
+static PFSchedTask profTask;
+#endif
+#define SAVE_START_FLAG 0x01
+#define TOUCH_FLAG 0x01
+#define TOUCH_POLL_MS 500   // In case a touch edge was missed
+#define TIMER_START_FLAG 0x01
+#define TRACE_DRAIN_MS 5
+#define TRACE_IDLE_MS 100   // Nothing left to drain, the next events are written a bit later
+#define PROF_DUMP_MS 10000
 
 PFdword sqroot(PFdword r); // Function to find square root of a PFdword type variable
 void freeHandBtnEventHandler(void);
@@ -16,6 +44,19 @@ void saveBtnEventHandler(void);
 void homeScreen(void);
 void clearscreenBtnEventHandler(void);
 void canvasEventHandler(void);
+void canvasTouchMove(PFdword x, PFdword y);
+void canvasTouchEnd(void);
+void saveStep(void);
+void galleryBtnEventHandler(void);
+void galleryOpenImage(void);
+PFEnSchedTaskState touchTaskFunction(PFSchedTask* task);
+PFEnSchedTaskState saveTaskFunction(PFSchedTask* task);
+PFEnSchedTaskState traceTaskFunction(PFSchedTask* task);
+PFEnSchedTaskState timerTaskFunction(PFSchedTask* task);
+PFEnSchedTaskState profTaskFunction(PFSchedTask* task);
+PFEnSchedTaskState bootTaskFunction(PFSchedTask* task);
+void touchWake(void);
+void timerWake(void);
 
 static WindowCfg window1 =
     {
@@ -39,15 +80,57 @@ static CanvasCfg Canvas =
         WHITE,
         0};
 
+// Name of the saved file, shown over the toolbar where touches do not draw on the canvas
+static PopUpCfg savedPopUp =
+    {
+        {"Saved popup",
+         {0, 0},
+         {240, 43},
+         WHITE,
+         enBooleanTrue}};
+
+static CfgBmpSave saveConfig =
+    {
+        0, 45, 240, 275,
+        4,
+        NULL,
+        NULL};
+
+// 3x3 thumbnails of the saved 240x275 canvas, reduced by 3 to 80x91
+static CfgThumbGallery galleryConfig =
+    {
+        (const PFchar*)"",
+        0, 45, 80, 91,
+        3, 3,
+        3,
+        WHITE};
+
+static CfgStroke strokeConfig =
+    {
+        2, 45, 238, 318,
+        STROKE_DEFAULT_TOLERANCE,
+        STROKE_DEFAULT_MIN_DISTANCE,
+        shadowFillArea};
+
+// Colors the canvas is drawn with, anything else drawn on it invalidates the shadow copy
+static const PFword shadowPalette[SHADOW_PALETTE_SIZE] = {WHITE, BLACK, RED, BLUE};
+
+static CfgShadow shadowConfig =
+    {
+        0, 45,
+        shadowPalette,
+        4,
+        0};
+
 static WidgetCfg freeHandBtnWidget =
     {
         {"Freehand button widget",
          {0, 0},
-         {40, 43},
+         {34, 43},
          WHITE,
          enBooleanTrue},
         freeHandBtnEventHandler,
-        "  FH",
+        " FH",
         enGfxFont_8X16,
         BLACK,
         0};
@@ -55,8 +138,8 @@ static WidgetCfg freeHandBtnWidget =
 static WidgetCfg lineBtnWidget =
     {
         {"Line button widget",
-         {40, 0},
-         {40, 43},
+         {34, 0},
+         {34, 43},
          WHITE,
          enBooleanTrue},
         lineBtnEventHandler,
@@ -68,8 +151,8 @@ static WidgetCfg lineBtnWidget =
 static WidgetCfg circleBtnWidget =
     {
         {"Circle button widget",
-         {80, 0},
-         {40, 43},
+         {68, 0},
+         {34, 43},
          WHITE,
          enBooleanTrue},
         circleBtnEventHandler,
@@ -81,8 +164,8 @@ static WidgetCfg circleBtnWidget =
 static WidgetCfg rectangleBtnWidget =
     {
         {"Rectangle button widget",
-         {120, 0},
-         {40, 43},
+         {102, 0},
+         {34, 43},
          WHITE,
          enBooleanTrue},
         rectangleBtnEventHandler,
@@ -94,7 +177,7 @@ static WidgetCfg rectangleBtnWidget =
 static WidgetCfg clearscreenBtnWidget =
     {
         {"Clearscreen button widget",
-         {160, 0},
+         {136, 0},
          {36, 43},
          WHITE,
          enBooleanTrue},
@@ -107,8 +190,8 @@ static WidgetCfg clearscreenBtnWidget =
 static WidgetCfg saveBtnWidget =
     {
         {"Save button widget",
-         {196, 0},
-         {44, 43},
+         {172, 0},
+         {36, 43},
          WHITE,
          enBooleanTrue},
         saveBtnEventHandler,
@@ -117,6 +200,19 @@ static WidgetCfg saveBtnWidget =
         BLACK,
         0};
 
+static WidgetCfg galleryBtnWidget =
+    {
+        {"Gallery button widget",
+         {208, 0},
+         {32, 43},
+         WHITE,
+         enBooleanTrue},
+        galleryBtnEventHandler,
+        "",
+        enGfxFont_8X16,
+        BLACK,
+        0};
+
 int main()
 {
 
@@ -134,17 +230,159 @@ int main()
     createWidget(windowID, &widget4ID, &rectangleBtnWidget);
     createWidget(windowID, &widget5ID, &clearscreenBtnWidget);
     createWidget(windowID, &widget6ID, &saveBtnWidget);
+    createWidget(windowID, &widget7ID, &galleryBtnWidget);
 
     homeScreen();
+    shadowOpen(&shadowConfig);
+    shadowCapture();    // Border of the canvas
+    bootMarkFirstFrame();
+
+    pfSchedAdd(&bootTask, bootTaskFunction, NULL);
+    pfSchedAdd(&touchTask, touchTaskFunction, NULL);
+    pfSchedAdd(&saveTask, saveTaskFunction, NULL);
+    pfSchedAdd(&traceTask, traceTaskFunction, NULL);
+    pfSchedAdd(&timerTask, timerTaskFunction, NULL);
+#if PF_PROF_ENABLE
+    pfSchedAdd(&profTask, profTaskFunction, NULL);
+#endif
+    pfTimerSetNotify(timerWake);
+    appTouchHook = touchWake;
+    pfEint1Enable();
+    // Sleeps with WFI when all the tasks wait, a touch or the next timeout wakes the CPU
+    pfSchedSetIdle(pfIdleSleep);
+    pfSchedRun();
+    return 0;
+}
+
+// Initializes the SDcard and the accelerometer after the first frame, one stage per round
+PFEnSchedTaskState bootTaskFunction(PFSchedTask* task)
+{
+    BootTimes times;
+
+    PF_TASK_BEGIN(task);
+    while (bootRunBackground() == enStatusBusy)
+    {
+        PF_TASK_YIELD(task);
+    }
+    bootGetTimes(&times);
+    DEBUG_TRACE(enTraceBootFrame, times.firstFrame, times.background);
+    PF_TASK_END(task);
+}
 
+// Called from the touch panel interrupt, the sample is read between two blocks if the SDcard holds the bus
+void touchWake(void)
+{
+    touchSampleStart();
+    pfSchedSetFlags(&touchTask, TOUCH_FLAG);
+}
+
+// Called when a software timer is started, its expiry may be before the time the timer task sleeps to
+void timerWake(void)
+{
+    pfSchedSetFlags(&timerTask, TIMER_START_FLAG);
+}
+
+// Passes touches to the window. A touch starting on the canvas starts a gesture, which gets the
+// following points of the touch and ends when the panel is released; the other tasks run in between.
+PFEnSchedTaskState touchTaskFunction(PFSchedTask* task)
+{
+    PF_TASK_BEGIN(task);
     while (1)
     {
-        if (touchAvailable(&i, &j) == enBooleanTrue)
+        PF_TASK_WAIT_FLAGS(task, TOUCH_FLAG, TOUCH_POLL_MS);
+        pfSchedTakeFlags(task, TOUCH_FLAG);
+        // The interrupt comes at the beginning of a touch, read until the panel is released
+        while (touchAvailable(&a2, &b2) == enBooleanTrue)
         {
-            windowEventHandler(windowID, i, j);
+            DEBUG_TRACE(enTraceTouch, a2, b2);
+            if (canvasGesture != 0)
+            {
+                canvasTouchMove(a2, b2);
+            }
+            else
+            {
+                i = a2;
+                j = b2;
+                windowEventHandler(windowID, i, j);
+            }
+            PF_TASK_YIELD(task);
         }
+        canvasTouchEnd();
     }
-    return 0;
+    PF_TASK_END(task);
+}
+
+// Runs a save started by the save button one step per round
+PFEnSchedTaskState saveTaskFunction(PFSchedTask* task)
+{
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        PF_TASK_WAIT_FLAGS(task, SAVE_START_FLAG, 0);
+        pfSchedTakeFlags(task, SAVE_START_FLAG);
+        while (saveRunning == enBooleanTrue)
+        {
+            saveStep();
+            PF_TASK_YIELD(task);
+        }
+    }
+    PF_TASK_END(task);
+}
+
+PFEnSchedTaskState traceTaskFunction(PFSchedTask* task)
+{
+    TraceStats stats;
+
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        traceDrain();
+        if (traceGetStats(&stats) == enStatusSuccess && stats.events != stats.drained)
+        {
+            PF_TASK_SLEEP_MS(task, TRACE_DRAIN_MS);
+        }
+        else
+        {
+            PF_TASK_SLEEP_MS(task, TRACE_IDLE_MS);
+        }
+    }
+    PF_TASK_END(task);
+}
+
+// Calls the callbacks of the software timers, and sleeps up to the next expiry. The tick period is 1ms,
+// so ticks are milliseconds.
+PFEnSchedTaskState timerTaskFunction(PFSchedTask* task)
+{
+    PFdword ticks;
+
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        pfTimerProcess();
+        ticks = pfTimerGetIdleTicks();
+        if (ticks == 0)
+        {
+            PF_TASK_YIELD(task);
+        }
+        else
+        {
+            PF_TASK_WAIT_FLAGS(task, TIMER_START_FLAG, (ticks == PF_TIMER_NO_EXPIRY) ? 0 : ticks);
+            pfSchedTakeFlags(task, TIMER_START_FLAG);
+        }
+    }
+    PF_TASK_END(task);
+}
+
+// Writes the profiler table to the serial port, with the trace records
+PFEnSchedTaskState profTaskFunction(PFSchedTask* task)
+{
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        PF_TASK_SLEEP_MS(task, PROF_DUMP_MS);
+        pfProfDump(pfUart0Write);
+    }
+    PF_TASK_END(task);
 }
 
 PFdword sqroot(PFdword r)
@@ -202,61 +440,220 @@ void rectangleBtnEventHandler(void)
 
 void saveBtnEventHandler(void)
 {
-    gfxDrawString(10, 54, "SAVED", enGfxFont_8X16, BLACK, WHITE);
+    if (saveRunning == enBooleanTrue || galleryOpen == enBooleanTrue)
+    {
+        return;
+    }
+    // Mounts the SDcard now if the boot task has not done it yet
+    if (bootRequire(enAppBootSdcard) != enStatusSuccess)
+    {
+        gfxDrawString(SAVE_TEXT_X, 14, "NOSD", enGfxFont_8X16, BLACK, WHITE);
+        return;
+    }
+    // The shadow copy is read much faster than the LCD, and is not disturbed by drawing during the save
+    saveConfig.readPixels = (shadowIsValid() == enBooleanTrue) ? shadowReadPixels : NULL;
+    if (bmpSaveStart(&saveJob, &saveConfig) != enStatusSuccess)
+    {
+        gfxDrawString(SAVE_TEXT_X, 14, "FAIL", enGfxFont_8X16, BLACK, WHITE);
+        return;
+    }
+    saveRunning = enBooleanTrue;
+    saveFailures = 0;
+    pfSchedSetFlags(&saveTask, SAVE_START_FLAG);
+}
+
+// Saves a few rows of the canvas between touches, progress is shown on the save button
+void saveStep(void)
+{
+    PFEnStatus status;
+    BmpSaveProgress progress;
+    char text[40];
+
+    status = bmpSaveStep(&saveJob);
+    bmpSaveGetProgress(&saveJob, &progress);
+    if (status == enStatusBusy)
+    {
+        pfSprintf((PFchar*)text, (const PFchar*)"%3u%%", progress.percent);
+        gfxDrawString(SAVE_TEXT_X, 14, text, enGfxFont_8X16, BLACK, WHITE);
+        saveFailures = 0;
+        return;
+    }
+
+    if (status != enStatusSuccess)
+    {
+        // The step resumes from the failed write when called again
+        if (++saveFailures < SAVE_MAX_RETRIES)
+        {
+            return;
+        }
+        bmpSaveAbort(&saveJob);
+        gfxDrawString(SAVE_TEXT_X, 14, "FAIL", enGfxFont_8X16, BLACK, WHITE);
+    }
+    else
+    {
+        gfxDrawString(SAVE_TEXT_X, 14, "SAVE", enGfxFont_8X16, BLACK, WHITE);
+        DEBUG_TRACE(enTraceSaveDone, progress.bytesPerSecond, 0);
+        pfSprintf((PFchar*)text, (const PFchar*)"Saved %s", saveJob.fileName);
+        drawPopUpSaved(&savedPopUp, text, SAVED_POPUP_MS, enGfxFont_8X16, BLACK);
+        // A thumbnail left by an older file of the same name and size would be taken as current
+        thumbInvalidate(saveJob.fileName);
+    }
+    saveRunning = enBooleanFalse;
 }
 
 void homeScreen(void)
 {
     setWindow(windowID);
-    gfxDrawLine(76, 5, 44, 39);
-    gfxDrawCircle(100, 21, 17);
-    gfxDrawRectangle(124, 4, 156, 39);
-    gfxDrawString(201, 14, "SAVE", enGfxFont_8X16, BLACK, WHITE);
+    gfxDrawLine(64, 5, 38, 39);
+    gfxDrawCircle(85, 21, 15);
+    gfxDrawRectangle(106, 4, 131, 39);
+    gfxDrawString(SAVE_TEXT_X, 14, "SAVE", enGfxFont_8X16, BLACK, WHITE);
+    gfxDrawString(212, 14, "GAL", enGfxFont_8X16, BLACK, WHITE);
 }
 
 void clearscreenBtnEventHandler(void)
 {
-    gfxFillArea(2, 45, 238, 318, WHITE);
+    galleryOpen = enBooleanFalse;
+    shadowFillArea(2, 45, 238, 318, WHITE);
+    if (shadowIsValid() == enBooleanFalse)
+    {
+        // After an image was opened
+        shadowCapture();
+    }
 }
 
-void canvasEventHandler(void)
+// Shows the thumbnails of the saved images on the canvas, each press shows the next page
+void galleryBtnEventHandler(void)
 {
+    PFword total = 0;
+    PFdword startTick;
 
-    switch (shape)
+    if (saveRunning == enBooleanTrue)
     {
-    case 'f':
-        gfxDrawPixels(i, j);
-        while (touchAvailable(&a1, &b1) == enBooleanTrue)
+        return;
+    }
+    if (bootRequire(enAppBootSdcard) != enStatusSuccess)
+    {
+        gfxDrawString(212, 14, "ERR", enGfxFont_8X16, BLACK, WHITE);
+        return;
+    }
+
+    galleryFirst = (galleryOpen == enBooleanTrue) ? galleryFirst + GALLERY_CELLS : 0;
+    startTick = pfTickSetTimeoutMs(0);
+    if (thumbGalleryDraw(&galleryConfig, galleryFirst, &total) != enStatusSuccess)
+    {
+        gfxDrawString(212, 14, "ERR", enGfxFont_8X16, BLACK, WHITE);
+        return;
+    }
+    if (galleryFirst != 0 && galleryFirst >= total)
+    {
+        galleryFirst = 0;
+        thumbGalleryDraw(&galleryConfig, galleryFirst, &total);
+    }
+    galleryOpen = enBooleanTrue;
+    gfxDrawString(212, 14, "GAL", enGfxFont_8X16, BLACK, WHITE);
+
+    DEBUG_TRACE(enTraceGallery, galleryFirst / GALLERY_CELLS + 1, pfTickSetTimeoutMs(0) - startTick);
+}
+
+// Opens the image of the thumbnail touched at i, j on the canvas and closes the gallery
+void galleryOpenImage(void)
+{
+    PFchar fileName[THUMB_NAME_SIZE];
+    BmpImage image;
+    PFword cell;
+
+    if (j < galleryConfig.y)
+    {
+        return;
+    }
+    cell = (PFword)((i - galleryConfig.x) / galleryConfig.cellWidth +
+                    ((j - galleryConfig.y) / galleryConfig.cellHeight) * galleryConfig.columns);
+    if (cell >= GALLERY_CELLS ||
+        thumbGalleryGetImage(&galleryConfig, galleryFirst + cell, fileName) != enStatusSuccess)
+    {
+        // An empty cell closes the gallery and brings back the drawing
+        if (shadowRedraw(0, 45, 239, 319) == enStatusSuccess)
         {
-            if (b1 >= 45)
-            {
-                gfxDrawPixels(a1, b1);
-            }
+            galleryOpen = enBooleanFalse;
         }
+        return;
+    }
+
+    galleryOpen = enBooleanFalse;
+    shadowFillArea(0, 45, 239, 319, WHITE);
+    if (bmpImageOpen(&image, fileName, NULL, 0) == enStatusSuccess)
+    {
+        bmpImageDraw(&image, 0, 45);
+        bmpImageClose(&image);
+        // The image has colors outside the palette, the shadow copy is loaded again by the next CLS
+        shadowInvalidate();
+    }
+}
+
+// Starts the gesture of a touch on the canvas at i, j
+void canvasEventHandler(void)
+{
+    if (galleryOpen == enBooleanTrue)
+    {
+        // The image is opened when the panel is released
+        canvasGesture = 'g';
+        return;
+    }
+
+    canvasGesture = shape;
+    a1 = i;
+    b1 = j;
+    if (shape == 'f')
+    {
+        strokeBegin(&freeHandStroke, &strokeConfig, i, j);
+    }
+}
+
+// Next point of the touch of the gesture
+void canvasTouchMove(PFdword x, PFdword y)
+{
+    switch (canvasGesture)
+    {
+    case 'f':
+        strokeAddPoint(&freeHandStroke, x, y);
         break;
     case 'l':
-        while (touchAvailable(&a2, &b2) == enBooleanTrue)
+    case 'c':
+    case 'r':
+        // The shape ends at the last point on the canvas
+        if (y >= 45)
         {
-            if (b2 >= 45)
-            {
-                a1 = a2;
-                b1 = b2;
-            }
+            a1 = x;
+            b1 = y;
         }
+        break;
+    default:
+        break;
+    }
+}
+
+// Ends the gesture when the panel is released
+void canvasTouchEnd(void)
+{
+    char gesture = canvasGesture;
+
+    canvasGesture = 0;
+    switch (gesture)
+    {
+    case 'g':
+        galleryOpenImage();
+        break;
+    case 'f':
+        strokeEnd(&freeHandStroke);
+        break;
+    case 'l':
         if ((i != a1 || j != b1) && b1 >= 45)
         {
-            gfxDrawLine(i, j, a1, b1);
+            shadowDrawLine(i, j, a1, b1);
         }
         break;
     case 'c':
-        while (touchAvailable(&a2, &b2) == enBooleanTrue)
-        {
-            if (b2 >= 45)
-            {
-                a1 = a2;
-                b1 = b2;
-            }
-        }
         if ((i != a1 || j != b1) && b1 >= 45)
         {
             PFdword radius, tmp = ((i - a1) * (i - a1)) + ((j - b1) * (j - b1));
@@ -264,26 +661,17 @@ void canvasEventHandler(void)
             // if (i - radius >= 0 && i + radius >= 249 && j - radius >= 42 && j + radius <= 320) {}
             if (j - radius >= 45)
             {
-                gfxDrawCircle(i, j, radius);
+                shadowDrawCircle(i, j, radius);
             }
         }
-
         break;
     case 'r':
-        while (touchAvailable(&a2, &b2) == enBooleanTrue)
-        {
-            if (b2 >= 45)
-            {
-                a1 = a2;
-                b1 = b2;
-            }
-        }
         if ((i != a1 && j != b1) && b1 >= 45)
         {
-            gfxDrawRectangle(i, j, a1, b1);
+            shadowDrawRectangle(i, j, a1, b1);
         }
         break;
     default:
         break;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,292 @@
+/**
+ *  \file       bmpImage.c
+ *  \brief      Random access to a BMP image on the SDcard through an open image handle.
+ *
+ *  Pixels are addressed the same way as by bmpPickColor(): rows are stored bottom row first,
+ *  each padded to a multiple of 4 bytes. An image with a negative height is stored top row first.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "bitmap.h"
+#include "bmpImage.h"
+
+#define BMP_IMAGE_LCD_ENTRY_MODE    0x03    /* Entry mode register of the LCD controller */
+#define BMP_IMAGE_LCD_GRAM_WRITE    0x22    /* GRAM write register of the LCD controller */
+#define BMP_IMAGE_ENTRY_NORMAL      0x1030  /* Entry mode set by gfxOpen(), address counter runs right and down */
+#define BMP_IMAGE_ENTRY_BOTTOM_UP   0x1010  /* Address counter runs right and up */
+
+/* State of the stream fed by fsFileForward(), which has no context argument */
+static struct
+{
+    PFword bytesPerPixel;
+    PFdword pixelBytes;
+    PFdword rowSize;
+    PFdword rowPos;
+    PFbyte carry[3];
+    PFword carryCount;
+}bmpImageStream;
+
+/* Converts a pixel of the file to RGB format, same as bmpPickColor() */
+static PFword bmpImageConvert(const PFbyte* data, PFword bytesPerPixel)
+{
+    if (bytesPerPixel == 2)
+    {
+        return bgrToRgb((PFword)(((PFword)data[1] << 8) | data[0]));
+    }
+    return (PFword)(((PFword)(data[2] >> 3) << 11) | ((PFword)(data[1] >> 2) << 5) | (data[0] >> 3));
+}
+
+/* Writes the pixel data passed by fsFileForward() to the LCD, skipping the row padding */
+static PFdword bmpImageStreamData(const PFbyte* data, PFdword count)
+{
+    PFdword index = 0, size;
+
+    // The stream is always ready
+    if (count == 0)
+    {
+        return 1;
+    }
+
+    while (index < count)
+    {
+        if (bmpImageStream.rowPos >= bmpImageStream.pixelBytes)
+        {
+            size = bmpImageStream.rowSize - bmpImageStream.rowPos;
+            if (size > count - index)
+            {
+                size = count - index;
+            }
+            index += size;
+            bmpImageStream.rowPos += size;
+            if (bmpImageStream.rowPos == bmpImageStream.rowSize)
+            {
+                bmpImageStream.rowPos = 0;
+            }
+        }
+        else if (bmpImageStream.carryCount != 0 || count - index < bmpImageStream.bytesPerPixel)
+        {
+            // A pixel split between two sectors
+            bmpImageStream.carry[bmpImageStream.carryCount++] = data[index++];
+            bmpImageStream.rowPos++;
+            if (bmpImageStream.carryCount == bmpImageStream.bytesPerPixel)
+            {
+                gfxWriteData(bmpImageConvert(bmpImageStream.carry, bmpImageStream.bytesPerPixel));
+                bmpImageStream.carryCount = 0;
+            }
+        }
+        else
+        {
+            size = bmpImageStream.pixelBytes - bmpImageStream.rowPos;
+            if (size > count - index)
+            {
+                size = count - index;
+            }
+            size -= size % bmpImageStream.bytesPerPixel;
+            bmpImageStream.rowPos += size;
+            for (size += index; index < size; index += bmpImageStream.bytesPerPixel)
+            {
+                gfxWriteData(bmpImageConvert(&data[index], bmpImageStream.bytesPerPixel));
+            }
+        }
+    }
+    return count;
+}
+
+static PFEnStatus bmpImageSeek(BmpImage* image, PFdword offset)
+{
+    if (image->linkMap != NULL)
+    {
+        return fsFileSeekFast(&image->file, image->linkMap, offset);
+    }
+    return fsFileSeek(&image->file, offset);
+}
+
+PFEnStatus bmpImageOpen(BmpImage* image, const PFchar* fileName, PFdword* linkMap, PFdword mapSize)
+{
+    PFEnStatus status;
+    PFdword read = 0;
+
+    if (image == NULL || fileName == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    image->linkMap = NULL;
+    status = fsFileOpen(&image->file, fileName, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    status = fsFileRead(&image->file, &image->header, sizeof(BmpHeader), &read);
+    if (status == enStatusSuccess && read != sizeof(BmpHeader))
+    {
+        status = enStatusError;
+    }
+    if (status == enStatusSuccess && (image->header.signature[0] != 'B' || image->header.signature[1] != 'M' ||
+        (image->header.pixelBitSize != 16 && image->header.pixelBitSize != 24) ||
+        image->header.imageHeight == 0))
+    {
+        status = enStatusNotSupported;
+    }
+    if (status != enStatusSuccess)
+    {
+        fsFileClose(&image->file);
+        return status;
+    }
+
+    // A negative height is a top down image, the rest of the module works with the row count
+    image->topDown = ((PFsdword)image->header.imageHeight < 0) ? enBooleanTrue : enBooleanFalse;
+    if (image->topDown == enBooleanTrue)
+    {
+        image->header.imageHeight = (PFdword)(-(PFsdword)image->header.imageHeight);
+    }
+    image->bytesPerPixel = image->header.pixelBitSize / 8;
+    image->rowSize = ((image->header.imageWidth * image->bytesPerPixel) + 3) & ~3UL;
+
+    // The image is still usable without the map, seeks just walk the FAT
+    if (linkMap != NULL && mapSize != 0)
+    {
+        linkMap[0] = mapSize;
+        if (fsFileLinkMap(&image->file, linkMap) == enStatusSuccess)
+        {
+            image->linkMap = linkMap;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus bmpImageReadPixels(BmpImage* image, PFword x, PFword y, PFword count, PFword* pixels)
+{
+    PFEnStatus status;
+    PFbyte data[BMP_IMAGE_READ_SIZE];
+    PFdword size, read, index, row;
+
+    if (image == NULL || pixels == NULL || x >= image->header.imageWidth || y >= image->header.imageHeight ||
+        count > image->header.imageWidth - x)
+    {
+        return enStatusInvArgs;
+    }
+
+    row = (image->topDown == enBooleanTrue) ? y : image->header.imageHeight - 1 - y;
+    status = bmpImageSeek(image, image->header.offset + row * image->rowSize + (PFdword)x * image->bytesPerPixel);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    while (count != 0)
+    {
+        size = (PFdword)count * image->bytesPerPixel;
+        if (size > BMP_IMAGE_READ_SIZE)
+        {
+            size = BMP_IMAGE_READ_SIZE;
+        }
+        status = fsFileRead(&image->file, data, size, &read);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        if (read != size)
+        {
+            return enStatusError;
+        }
+
+        for (index = 0; index < size; index += image->bytesPerPixel)
+        {
+            *pixels++ = bmpImageConvert(&data[index], image->bytesPerPixel);
+        }
+        count -= size / image->bytesPerPixel;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus bmpImagePickColor(BmpImage* image, PFword x, PFword y, PFword* color)
+{
+    return bmpImageReadPixels(image, x, y, 1, color);
+}
+
+PFEnStatus bmpImageDraw(BmpImage* image, PFword x, PFword y)
+{
+    PFEnStatus status;
+    EnGfxOrientation orientation;
+    PFword lcdWidth, lcdHeight;
+    PFdword size, forwarded = 0;
+
+    if (image == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    // The scan direction is set in panel coordinates
+    gfxGetOrientation(&orientation);
+    if (orientation != enGfxOrientation_0)
+    {
+        return enStatusNotSupported;
+    }
+    gfxGetWidth(&lcdWidth);
+    gfxGetHeight(&lcdHeight);
+    if (x >= lcdWidth || y >= lcdHeight || image->header.imageWidth > (PFdword)(lcdWidth - x) ||
+        image->header.imageHeight > (PFdword)(lcdHeight - y))
+    {
+        return enStatusInvArgs;
+    }
+
+    status = bmpImageSeek(image, image->header.offset);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    bmpImageStream.bytesPerPixel = image->bytesPerPixel;
+    bmpImageStream.pixelBytes = image->header.imageWidth * image->bytesPerPixel;
+    bmpImageStream.rowSize = image->rowSize;
+    bmpImageStream.rowPos = 0;
+    bmpImageStream.carryCount = 0;
+
+    // Start at the bottom left corner of the window and fill it upwards, or top down in the normal mode
+    gfxSetWindow(x, y, x + image->header.imageWidth - 1, y + image->header.imageHeight - 1);
+    if (image->topDown == enBooleanTrue)
+    {
+        gfxSetCursor(x, y);
+    }
+    else
+    {
+        gfxCommand(BMP_IMAGE_LCD_ENTRY_MODE, BMP_IMAGE_ENTRY_BOTTOM_UP);
+        gfxSetCursor(x, y + image->header.imageHeight - 1);
+    }
+    gfxWriteCmd(BMP_IMAGE_LCD_GRAM_WRITE);
+
+    size = image->rowSize * image->header.imageHeight;
+    status = fsFileForward(&image->file, bmpImageStreamData, size, &forwarded);
+    if (status == enStatusSuccess && forwarded != size)
+    {
+        status = enStatusError;
+    }
+
+    gfxCommand(BMP_IMAGE_LCD_ENTRY_MODE, BMP_IMAGE_ENTRY_NORMAL);
+    gfxSetAreaMax();
+    return status;
+}
+
+PFEnStatus bmpImageClose(BmpImage* image)
+{
+    if (image == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    image->linkMap = NULL;
+    return fsFileClose(&image->file);
+}
@@ -0,0 +1,305 @@
+/**
+ *  \file       bmpSave.c
+ *  \brief      Incremental BMP save of a screen area to the SDcard.
+ *
+ *  The file is written as a sequence of BMP_SAVE_CHUNK_SIZE writes starting at offset 0, the first
+ *  one carrying the header. Every write therefore covers whole sectors at a sector boundary except
+ *  the last one, and the file system passes it to the disk as a multiple block write without going
+ *  through its sector window.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_tick.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "bmpSave.h"
+
+#define BMP_SAVE_MAX_INDEX          1000    /* image_<n>.bmp names tried before giving up */
+
+static PFdword bmpSaveNow(void)
+{
+    return pfTickSetTimeoutMs(0);
+}
+
+static void bmpSaveStore32(PFbyte* ptr, PFdword value)
+{
+    ptr[0] = (PFbyte)value;
+    ptr[1] = (PFbyte)(value >> 8);
+    ptr[2] = (PFbyte)(value >> 16);
+    ptr[3] = (PFbyte)(value >> 24);
+}
+
+/* Same header as written by saveImage() */
+static void bmpSaveHeader(BmpSaveJob* job, PFbyte* header)
+{
+    PFdword imageSize = (PFdword)job->rowSize * job->config.height;
+
+    pfMemSet(header, 0, BMP_SAVE_HEADER_SIZE);
+    header[0] = 'B';
+    header[1] = 'M';
+    bmpSaveStore32(&header[2], imageSize + BMP_SAVE_HEADER_SIZE);
+    bmpSaveStore32(&header[10], BMP_SAVE_HEADER_SIZE);
+    bmpSaveStore32(&header[14], 40);
+    bmpSaveStore32(&header[18], job->config.width);
+    bmpSaveStore32(&header[22], job->config.height);
+    header[26] = 1;
+    header[28] = BMP_SAVE_BITS_PER_PIXEL;
+    bmpSaveStore32(&header[34], imageSize);
+}
+
+static PFEnStatus bmpSaveCreate(BmpSaveJob* job)
+{
+    PFEnStatus status;
+    PFdword index, length;
+
+    if (job->config.fileName != NULL)
+    {
+        pfMemSet(job->fileName, 0, BMP_SAVE_NAME_SIZE);
+        length = pfStrLen((const char*)job->config.fileName);
+        pfMemCopy(job->fileName, job->config.fileName, length < BMP_SAVE_NAME_SIZE ? length : BMP_SAVE_NAME_SIZE - 1);
+        return fsFileOpen(&job->file, job->fileName, FA_CREATE_ALWAYS | FA_WRITE);
+    }
+
+    // First name which does not exist or is empty, as saveImage() does
+    for (index = 0; index < BMP_SAVE_MAX_INDEX; index++)
+    {
+        pfSprintf(job->fileName, (const PFchar*)"image_%u.bmp", index);
+        status = fsFileOpen(&job->file, job->fileName, FA_OPEN_ALWAYS | FA_WRITE);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        if (job->file.fsize == 0)
+        {
+            return enStatusSuccess;
+        }
+        fsFileClose(&job->file);
+    }
+    return enStatusError;
+}
+
+static PFEnStatus bmpSaveFlush(BmpSaveJob* job)
+{
+    PFEnStatus status;
+    PFdword written = 0;
+
+    if (job->chunkFill == 0)
+    {
+        return enStatusSuccess;
+    }
+
+    // A failed write may have moved the file pointer
+    if (job->file.fptr != job->chunkOffset)
+    {
+        status = fsFileSeek(&job->file, job->chunkOffset);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+    }
+
+    status = fsFileWrite(&job->file, job->chunk, job->chunkFill, &written);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    if (written != job->chunkFill)
+    {
+        return enStatusError;
+    }
+
+    job->chunkOffset += job->chunkFill;
+    job->chunkFill = 0;
+    return enStatusSuccess;
+}
+
+/* Copies the rest of the current row to the chunk buffer, writing the buffer out each time it is full */
+static PFEnStatus bmpSaveCopyRow(BmpSaveJob* job)
+{
+    PFEnStatus status;
+    PFdword pixelBytes = (PFdword)job->config.width * 2;
+    PFdword count;
+
+    while (job->rowBytes < job->rowSize)
+    {
+        if (job->chunkFill == BMP_SAVE_CHUNK_SIZE)
+        {
+            status = bmpSaveFlush(job);
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+        }
+
+        count = BMP_SAVE_CHUNK_SIZE - job->chunkFill;
+        if (job->rowBytes < pixelBytes)
+        {
+            if (count > pixelBytes - job->rowBytes)
+            {
+                count = pixelBytes - job->rowBytes;
+            }
+            pfMemCopy(&job->chunk[job->chunkFill], (PFbyte*)job->row + job->rowBytes, count);
+        }
+        else
+        {
+            // Row padding up to a multiple of 4 bytes
+            if (count > (PFdword)(job->rowSize - job->rowBytes))
+            {
+                count = job->rowSize - job->rowBytes;
+            }
+            pfMemSet(&job->chunk[job->chunkFill], 0, count);
+        }
+        job->chunkFill += count;
+        job->rowBytes += count;
+    }
+
+    return enStatusSuccess;
+}
+
+PFEnStatus bmpSaveStart(BmpSaveJob* job, pCfgBmpSave config)
+{
+    PFEnStatus status;
+
+    if (job == NULL || config == NULL || config->width == 0 || config->width > BMP_SAVE_MAX_WIDTH ||
+        config->height == 0 || config->rowsPerStep == 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfMemCopy(&job->config, config, sizeof(CfgBmpSave));
+    job->state = enBmpSaveFailed;
+    job->rowSize = (PFword)((((PFdword)config->width * BMP_SAVE_BITS_PER_PIXEL + 31) / 32) * 4);
+    job->rowsDone = 0;
+    job->rowBytes = 0;
+    job->chunkOffset = 0;
+    job->startTick = bmpSaveNow();
+    job->endTick = job->startTick;
+
+    status = bmpSaveCreate(job);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    // A contiguous file is written without allocating clusters on the way; a fragmented free
+    // space only makes the save slower, so the file is grown while writing if this fails
+    fsFileExpand(&job->file, (PFdword)job->rowSize * config->height + BMP_SAVE_HEADER_SIZE);
+
+    bmpSaveHeader(job, job->chunk);
+    job->chunkFill = BMP_SAVE_HEADER_SIZE;
+    job->state = enBmpSaveRunning;
+    return enStatusSuccess;
+}
+
+PFEnStatus bmpSaveStep(BmpSaveJob* job)
+{
+    PFEnStatus status;
+    PFword rows = 0;
+
+    if (job == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (job->state == enBmpSaveDone)
+    {
+        return enStatusSuccess;
+    }
+    if (job->state != enBmpSaveRunning)
+    {
+        return enStatusInvState;
+    }
+
+    while (job->rowsDone < job->config.height)
+    {
+        if (job->rowBytes == 0)
+        {
+            if (rows == job->config.rowsPerStep)
+            {
+                return enStatusBusy;
+            }
+            // Bottom row first; same readback call as saveImage()
+            if (job->config.readPixels != NULL)
+            {
+                status = job->config.readPixels(job->config.x, job->config.y + job->config.height - 1 - job->rowsDone,
+                                                job->config.width, job->row);
+                if (status != enStatusSuccess)
+                {
+                    return status;
+                }
+            }
+            else
+            {
+                readBackground(job->config.x + 1, job->config.y + job->config.height - 1 - job->rowsDone,
+                               job->config.width, 0, job->row, job->config.width);
+            }
+        }
+
+        status = bmpSaveCopyRow(job);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        job->rowBytes = 0;
+        job->rowsDone++;
+        rows++;
+    }
+
+    status = bmpSaveFlush(job);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = fsFileClose(&job->file);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    job->endTick = bmpSaveNow();
+    job->state = enBmpSaveDone;
+    return enStatusSuccess;
+}
+
+PFEnStatus bmpSaveAbort(BmpSaveJob* job)
+{
+    if (job == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (job->state != enBmpSaveRunning)
+    {
+        return enStatusInvState;
+    }
+
+    fsFileClose(&job->file);
+    job->state = enBmpSaveFailed;
+    return fsFileDelete(job->fileName);
+}
+
+PFEnStatus bmpSaveGetProgress(BmpSaveJob* job, BmpSaveProgress* progress)
+{
+    if (job == NULL || progress == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    progress->rowsDone = job->rowsDone;
+    progress->rowsTotal = job->config.height;
+    progress->percent = (PFbyte)(((PFdword)job->rowsDone * 100) / job->config.height);
+    progress->bytesWritten = job->chunkOffset;
+    progress->fileSize = (PFdword)job->rowSize * job->config.height + BMP_SAVE_HEADER_SIZE;
+    progress->elapsedTicks = ((job->state == enBmpSaveDone) ? job->endTick : bmpSaveNow()) - job->startTick;
+    progress->bytesPerSecond = (progress->elapsedTicks != 0) ?
+                               (PFdword)(((PFqword)progress->bytesWritten * 1000) / progress->elapsedTicks) : 0;
+    return enStatusSuccess;
+}
@@ -0,0 +1,194 @@
+/**
+ *  \file       bootManager.c
+ *  \brief      Boot manager running the initialization of the devices in stages.
+ *
+ *  Each stage is run at most once, whatever calls it first: bootRunForeground(), bootRunBackground()
+ *  or bootRequire(). Stages are run from the main context only, so no locking is needed. The times are
+ *  differences of timestamps from bootOpen(), so a 32 bit cycle counter covers about 42 seconds of
+ *  boot at 100 MHz.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_string.h"
+#include "bootManager.h"
+
+static CfgBoot bootConfig;
+static BootStageInfo bootStages[BOOT_MAX_STAGES];
+static BootTimes bootTimes;
+static PFdword bootOrigin = 0;
+static PFbyte bootNextBackground = 0;
+static PFEnBoolean bootInit = enBooleanFalse;
+
+PF_C_STATIC_INLINE PFdword bootTimestamp(void)
+{
+    return ((bootConfig.timestamp != NULL) ? bootConfig.timestamp() : DWT->CYCCNT) - bootOrigin;
+}
+
+/* Runs a stage if it has not run yet */
+static PFEnStatus bootRunStage(PFbyte stage)
+{
+    BootStageInfo* info = &bootStages[stage];
+
+    if (info->state == enBootStatePending)
+    {
+        info->start = bootTimestamp();
+        info->status = bootConfig.stages[stage].init();
+        info->duration = bootTimestamp() - info->start;
+        info->state = (info->status == enStatusSuccess) ? enBootStateReady : enBootStateFailed;
+        if (bootConfig.stageDone != NULL)
+        {
+            bootConfig.stageDone(stage, info->status, info->duration);
+        }
+    }
+    return info->status;
+}
+
+PFEnStatus bootOpen(pCfgBoot config)
+{
+    PFbyte stage;
+
+    if (config == NULL || config->stages == NULL || config->stageCount > BOOT_MAX_STAGES)
+    {
+        return enStatusInvArgs;
+    }
+    for (stage = 0; stage < config->stageCount; stage++)
+    {
+        if (config->stages[stage].init == NULL)
+        {
+            return enStatusInvArgs;
+        }
+    }
+
+    bootConfig = *config;
+    if (bootConfig.timestamp == NULL)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    bootOrigin = 0;
+    bootOrigin = bootTimestamp();
+
+    pfMemSet(bootStages, 0, sizeof(bootStages));
+    pfMemSet(&bootTimes, 0, sizeof(bootTimes));
+    bootNextBackground = 0;
+    bootInit = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus bootRunForeground(PFbyte* failedStage)
+{
+    PFEnStatus status;
+    PFbyte stage;
+
+    if (bootInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    for (stage = 0; stage < bootConfig.stageCount; stage++)
+    {
+        if (bootConfig.stages[stage].mode != enBootModeForeground)
+        {
+            continue;
+        }
+        status = bootRunStage(stage);
+        if (status != enStatusSuccess && bootConfig.stages[stage].required == enBooleanTrue)
+        {
+            if (failedStage != NULL)
+            {
+                *failedStage = stage;
+            }
+            return status;
+        }
+    }
+    bootTimes.foreground = bootTimestamp();
+    return enStatusSuccess;
+}
+
+PFEnStatus bootRunBackground(void)
+{
+    if (bootInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    // Stages already run by bootRequire() are passed over
+    while (bootNextBackground < bootConfig.stageCount &&
+           (bootConfig.stages[bootNextBackground].mode != enBootModeBackground ||
+            bootStages[bootNextBackground].state != enBootStatePending))
+    {
+        bootNextBackground++;
+    }
+    if (bootNextBackground == bootConfig.stageCount)
+    {
+        if (bootTimes.background == 0)
+        {
+            bootTimes.background = bootTimestamp();
+        }
+        return enStatusSuccess;
+    }
+
+    bootRunStage(bootNextBackground++);
+    return enStatusBusy;
+}
+
+PFEnStatus bootRequire(PFbyte stage)
+{
+    if (bootInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+    if (stage >= bootConfig.stageCount)
+    {
+        return enStatusInvArgs;
+    }
+    return bootRunStage(stage);
+}
+
+PFEnBoolean bootIsReady(PFbyte stage)
+{
+    if (bootInit != enBooleanTrue || stage >= bootConfig.stageCount)
+    {
+        return enBooleanFalse;
+    }
+    return (bootStages[stage].state == enBootStateReady) ? enBooleanTrue : enBooleanFalse;
+}
+
+void bootMarkFirstFrame(void)
+{
+    if (bootInit == enBooleanTrue && bootTimes.firstFrame == 0)
+    {
+        bootTimes.firstFrame = bootTimestamp();
+    }
+}
+
+PFEnStatus bootGetStageInfo(PFbyte stage, BootStageInfo* info)
+{
+    if (info == NULL || stage >= bootConfig.stageCount)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfMemCopy(info, &bootStages[stage], sizeof(BootStageInfo));
+    return enStatusSuccess;
+}
+
+PFEnStatus bootGetTimes(BootTimes* times)
+{
+    if (times == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfMemCopy(times, &bootTimes, sizeof(BootTimes));
+    return enStatusSuccess;
+}
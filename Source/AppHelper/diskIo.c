@@ -0,0 +1,563 @@
+/*-----------------------------------------------------------------------
+/  Low level disk interface modlue   (C)ChaN, 2012
+/------------------------------------------------------------------------
+/  Dispatches the FatFs disk functions to the device driver registered
+/  with diskOpen(). Sector counts are passed through unchanged, so a
+/  cluster sized request reaches the device as one multiple block transfer.
+/
+/  With DISK_USE_CACHE, single sector requests (FAT, directory and the
+/  shared sector window of FS_TINY) go through a write-back cache with
+/  LRU replacement. Sectors of the FAT area are pinned so that file data
+/  passing through the window does not push them out. Multiple sector
+/  requests bypass the cache and are kept coherent with it.
+/-----------------------------------------------------------------------*/
+
+#include "prime_framework.h"
+#include "prime_gpdma.h"
+#include "diskIo.h"
+
+static CfgDisk diskConfig[MAX_DISK_SUPPORTED];
+static PFbyte diskStatus[MAX_DISK_SUPPORTED];
+static PFbyte diskId[MAX_DISK_SUPPORTED];
+
+#if (DISK_USE_CACHE == 1)
+
+#define DISK_CACHE_VALID		0x01
+#define DISK_CACHE_DIRTY		0x02
+#define DISK_CACHE_PINNED		0x04
+#define DISK_CACHE_NONE			0xFF
+
+#define DISK_LD_WORD(ptr)		((PFword)(((PFword)(ptr)[1] << 8) | (ptr)[0]))
+#define DISK_LD_DWORD(ptr)		((((PFdword)(ptr)[3]) << 24) | (((PFdword)(ptr)[2]) << 16) | (((PFdword)(ptr)[1]) << 8) | (ptr)[0])
+
+typedef struct
+{
+	PFdword sector;
+	PFdword lastUse;
+	PFbyte drive;
+	PFbyte flags;
+}DiskCacheEntry;
+
+static DiskCacheEntry diskCacheEntry[DISK_CACHE_SECTORS];
+static PFbyte diskCacheData[DISK_CACHE_SECTORS][DISK_SECTOR_SIZE] PF_GPDMA_BUFFER;
+static PFdword diskCacheClock = 0;
+static PFdword diskPinFirst[MAX_DISK_SUPPORTED];
+static PFdword diskPinCount[MAX_DISK_SUPPORTED];
+static DiskCacheStats diskCacheStats[MAX_DISK_SUPPORTED];
+
+static PFEnStatus diskDevRead(PFbyte drive, PFbyte* buff, PFdword sector, PFdword count)
+{
+	diskCacheStats[drive].devReads++;
+	diskCacheStats[drive].devSectorsRead += count;
+	return diskConfig[drive].devRead(diskId[drive], buff, sector, count);
+}
+
+static PFEnStatus diskDevWrite(PFbyte drive, const PFbyte* buff, PFdword sector, PFdword count)
+{
+	diskCacheStats[drive].devWrites++;
+	diskCacheStats[drive].devSectorsWritten += count;
+	return diskConfig[drive].devWrite(diskId[drive], buff, sector, count);
+}
+
+static PFbyte diskCacheFind(PFbyte drive, PFdword sector)
+{
+	PFbyte index;
+
+	for(index = 0; index < DISK_CACHE_SECTORS; index++)
+	{
+		if((diskCacheEntry[index].flags & DISK_CACHE_VALID) != 0 &&
+			diskCacheEntry[index].drive == drive && diskCacheEntry[index].sector == sector)
+		{
+			return index;
+		}
+	}
+	return DISK_CACHE_NONE;
+}
+
+static PFbyte diskCacheIsPinned(PFbyte drive, PFdword sector)
+{
+	return (sector - diskPinFirst[drive] < diskPinCount[drive]) ? DISK_CACHE_PINNED : 0;
+}
+
+/* Least recently used entry among those whose pinned flag equals pinned */
+static PFbyte diskCacheLru(PFbyte pinned)
+{
+	PFbyte index, victim = DISK_CACHE_NONE;
+
+	for(index = 0; index < DISK_CACHE_SECTORS; index++)
+	{
+		if((diskCacheEntry[index].flags & DISK_CACHE_PINNED) != pinned)
+		{
+			continue;
+		}
+		if(victim == DISK_CACHE_NONE || diskCacheClock - diskCacheEntry[index].lastUse > diskCacheClock - diskCacheEntry[victim].lastUse)
+		{
+			victim = index;
+		}
+	}
+	return victim;
+}
+
+/* Frees an entry for a new sector, writing it back if it is dirty */
+static PFEnStatus diskCacheAlloc(PFbyte drive, PFdword sector, PFbyte* entry)
+{
+	PFbyte index, victim = DISK_CACHE_NONE, pinned, pinnedCount = 0;
+	PFEnStatus status;
+
+	for(index = 0; index < DISK_CACHE_SECTORS; index++)
+	{
+		if((diskCacheEntry[index].flags & DISK_CACHE_VALID) == 0)
+		{
+			victim = index;
+			break;
+		}
+		if((diskCacheEntry[index].flags & DISK_CACHE_PINNED) != 0)
+		{
+			pinnedCount++;
+		}
+	}
+
+	if(victim == DISK_CACHE_NONE)
+	{
+		pinned = diskCacheIsPinned(drive, sector);
+		// Pinned sectors replace each other once they hold their share of the cache
+		if(pinned != 0 && pinnedCount >= DISK_CACHE_PIN_MAX)
+		{
+			victim = diskCacheLru(DISK_CACHE_PINNED);
+		}
+		else
+		{
+			victim = diskCacheLru(0);
+			if(victim == DISK_CACHE_NONE)
+			{
+				victim = diskCacheLru(DISK_CACHE_PINNED);
+			}
+		}
+
+		if((diskCacheEntry[victim].flags & DISK_CACHE_DIRTY) != 0)
+		{
+			status = diskDevWrite(diskCacheEntry[victim].drive, diskCacheData[victim], diskCacheEntry[victim].sector, 1);
+			if(status != enStatusSuccess)
+			{
+				return status;
+			}
+			diskCacheStats[diskCacheEntry[victim].drive].evictions++;
+		}
+	}
+
+	diskCacheEntry[victim].flags = 0;
+	diskCacheEntry[victim].drive = drive;
+	diskCacheEntry[victim].sector = sector;
+	*entry = victim;
+	return enStatusSuccess;
+}
+
+static void diskCacheTouch(PFbyte entry)
+{
+	diskCacheEntry[entry].lastUse = ++diskCacheClock;
+}
+
+/* Brings a sector into the cache */
+static PFEnStatus diskCacheLoad(PFbyte drive, PFdword sector, PFbyte* entry)
+{
+	PFEnStatus status;
+
+	*entry = diskCacheFind(drive, sector);
+	if(*entry != DISK_CACHE_NONE)
+	{
+		diskCacheStats[drive].readHits++;
+		diskCacheTouch(*entry);
+		return enStatusSuccess;
+	}
+
+	diskCacheStats[drive].readMisses++;
+	status = diskCacheAlloc(drive, sector, entry);
+	if(status != enStatusSuccess)
+	{
+		return status;
+	}
+	status = diskDevRead(drive, diskCacheData[*entry], sector, 1);
+	if(status != enStatusSuccess)
+	{
+		return status;
+	}
+	diskCacheEntry[*entry].flags = DISK_CACHE_VALID | diskCacheIsPinned(drive, sector);
+	diskCacheTouch(*entry);
+	return enStatusSuccess;
+}
+
+static void diskCacheSwap(PFbyte a, PFbyte b)
+{
+	DiskCacheEntry entry;
+	PFdword* pa = (PFdword*)diskCacheData[a];
+	PFdword* pb = (PFdword*)diskCacheData[b];
+	PFdword k, word;
+
+	if(a == b)
+	{
+		return;
+	}
+
+	entry = diskCacheEntry[a];
+	diskCacheEntry[a] = diskCacheEntry[b];
+	diskCacheEntry[b] = entry;
+	for(k = 0; k < DISK_SECTOR_SIZE / sizeof(PFdword); k++)
+	{
+		word = pa[k];
+		pa[k] = pb[k];
+		pb[k] = word;
+	}
+}
+
+/* Finds the FAT area of the volume in the boot sector and pins it */
+static void diskCachePinFat(PFbyte drive)
+{
+	PFbyte entry;
+	PFbyte* data;
+	PFdword base = 0, fatSize;
+
+	diskPinCount[drive] = 0;
+
+	if(diskCacheLoad(drive, 0, &entry) != enStatusSuccess)
+	{
+		return;
+	}
+	data = diskCacheData[entry];
+	if(DISK_LD_WORD(&data[510]) != 0xAA55)
+	{
+		return;
+	}
+
+	// Sector 0 is an MBR when it has no FAT boot record, use the first partition
+	if(pfMemCompare(&data[54], "FAT", 3) != enBooleanTrue && pfMemCompare(&data[82], "FAT", 3) != enBooleanTrue)
+	{
+		base = DISK_LD_DWORD(&data[446 + 8]);
+		if(diskCacheLoad(drive, base, &entry) != enStatusSuccess)
+		{
+			return;
+		}
+		data = diskCacheData[entry];
+		if(DISK_LD_WORD(&data[510]) != 0xAA55 ||
+			(pfMemCompare(&data[54], "FAT", 3) != enBooleanTrue && pfMemCompare(&data[82], "FAT", 3) != enBooleanTrue))
+		{
+			return;
+		}
+	}
+
+	fatSize = DISK_LD_WORD(&data[22]);
+	if(fatSize == 0)
+	{
+		fatSize = DISK_LD_DWORD(&data[36]);
+	}
+	diskCacheSetPinRange(drive, base + DISK_LD_WORD(&data[14]), fatSize * data[16]);
+}
+
+static PFEnStatus diskCacheRead(PFbyte drive, PFbyte* buff, PFdword sector, PFdword count)
+{
+	PFEnStatus status;
+	PFbyte entry;
+
+	if(count == 1)
+	{
+		status = diskCacheLoad(drive, sector, &entry);
+		if(status == enStatusSuccess)
+		{
+			pfMemCopy(buff, diskCacheData[entry], DISK_SECTOR_SIZE);
+		}
+		return status;
+	}
+
+	status = diskDevRead(drive, buff, sector, count);
+	if(status != enStatusSuccess)
+	{
+		return status;
+	}
+	// Cached copies of dirty sectors are newer than the device
+	for(entry = 0; entry < DISK_CACHE_SECTORS; entry++)
+	{
+		if((diskCacheEntry[entry].flags & DISK_CACHE_DIRTY) != 0 && diskCacheEntry[entry].drive == drive &&
+			diskCacheEntry[entry].sector - sector < count)
+		{
+			pfMemCopy(buff + (diskCacheEntry[entry].sector - sector) * DISK_SECTOR_SIZE, diskCacheData[entry], DISK_SECTOR_SIZE);
+		}
+	}
+	return enStatusSuccess;
+}
+
+static PFEnStatus diskCacheWrite(PFbyte drive, const PFbyte* buff, PFdword sector, PFdword count)
+{
+	PFEnStatus status;
+	PFbyte entry;
+
+	if(count == 1)
+	{
+		entry = diskCacheFind(drive, sector);
+		if(entry != DISK_CACHE_NONE)
+		{
+			diskCacheStats[drive].writeHits++;
+		}
+		else
+		{
+			diskCacheStats[drive].writeMisses++;
+			status = diskCacheAlloc(drive, sector, &entry);
+			if(status != enStatusSuccess)
+			{
+				return status;
+			}
+		}
+		pfMemCopy(diskCacheData[entry], buff, DISK_SECTOR_SIZE);
+		diskCacheEntry[entry].flags = DISK_CACHE_VALID | DISK_CACHE_DIRTY | diskCacheIsPinned(drive, sector);
+		diskCacheTouch(entry);
+		return enStatusSuccess;
+	}
+
+	status = diskDevWrite(drive, buff, sector, count);
+	if(status != enStatusSuccess)
+	{
+		return status;
+	}
+	// Cached copies now match the device
+	for(entry = 0; entry < DISK_CACHE_SECTORS; entry++)
+	{
+		if((diskCacheEntry[entry].flags & DISK_CACHE_VALID) != 0 && diskCacheEntry[entry].drive == drive &&
+			diskCacheEntry[entry].sector - sector < count)
+		{
+			pfMemCopy(diskCacheData[entry], buff + (diskCacheEntry[entry].sector - sector) * DISK_SECTOR_SIZE, DISK_SECTOR_SIZE);
+			diskCacheEntry[entry].flags &= ~DISK_CACHE_DIRTY;
+		}
+	}
+	return enStatusSuccess;
+}
+
+PFEnStatus diskCacheSetPinRange(PFbyte drive, PFdword firstSector, PFdword count)
+{
+	PFbyte index;
+
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+
+	diskPinFirst[drive] = firstSector;
+	diskPinCount[drive] = count;
+	for(index = 0; index < DISK_CACHE_SECTORS; index++)
+	{
+		if((diskCacheEntry[index].flags & DISK_CACHE_VALID) != 0 && diskCacheEntry[index].drive == drive)
+		{
+			diskCacheEntry[index].flags = (diskCacheEntry[index].flags & ~DISK_CACHE_PINNED) |
+											diskCacheIsPinned(drive, diskCacheEntry[index].sector);
+		}
+	}
+	return enStatusSuccess;
+}
+
+PFEnStatus diskCacheFlush(PFbyte drive)
+{
+	PFEnStatus status;
+	PFbyte index, first, runLength, next;
+
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+
+	while(1)
+	{
+		// Lowest dirty sector starts the next run
+		first = DISK_CACHE_NONE;
+		for(index = 0; index < DISK_CACHE_SECTORS; index++)
+		{
+			if((diskCacheEntry[index].flags & DISK_CACHE_DIRTY) != 0 && diskCacheEntry[index].drive == drive &&
+				(first == DISK_CACHE_NONE || diskCacheEntry[index].sector < diskCacheEntry[first].sector))
+			{
+				first = index;
+			}
+		}
+		if(first == DISK_CACHE_NONE)
+		{
+			return enStatusSuccess;
+		}
+
+		// Gather the run of consecutive dirty sectors at the start of the cache so it is written as one block
+		diskCacheSwap(0, first);
+		runLength = 1;
+		while(runLength < DISK_CACHE_SECTORS)
+		{
+			next = diskCacheFind(drive, diskCacheEntry[0].sector + runLength);
+			if(next == DISK_CACHE_NONE || next < runLength || (diskCacheEntry[next].flags & DISK_CACHE_DIRTY) == 0)
+			{
+				break;
+			}
+			diskCacheSwap(runLength, next);
+			runLength++;
+		}
+
+		status = diskDevWrite(drive, diskCacheData[0], diskCacheEntry[0].sector, runLength);
+		if(status != enStatusSuccess)
+		{
+			return status;
+		}
+		for(index = 0; index < runLength; index++)
+		{
+			diskCacheEntry[index].flags &= ~DISK_CACHE_DIRTY;
+		}
+	}
+}
+
+PFEnStatus diskCacheInvalidate(PFbyte drive)
+{
+	PFbyte index;
+
+	if(drive >= MAX_DISK_SUPPORTED)
+	{
+		return enStatusInvalidDrive;
+	}
+
+	for(index = 0; index < DISK_CACHE_SECTORS; index++)
+	{
+		if(diskCacheEntry[index].drive == drive)
+		{
+			diskCacheEntry[index].flags = 0;
+		}
+	}
+	return enStatusSuccess;
+}
+
+PFEnStatus diskCacheGetStats(PFbyte drive, DiskCacheStats* stats)
+{
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+	if(stats == NULL)
+	{
+		return enStatusInvArgs;
+	}
+
+	*stats = diskCacheStats[drive];
+	return enStatusSuccess;
+}
+#endif	// #if (DISK_USE_CACHE == 1)
+
+PFEnStatus diskOpen(PFbyte* drive, pCfgDisk config)
+{
+	PFbyte index;
+
+	if(config == NULL || drive == NULL)
+	{
+		return enStatusInvArgs;
+	}
+
+	for(index = 0; index < MAX_DISK_SUPPORTED; index++)
+	{
+		if(diskStatus[index] == 0)
+		{
+			*drive = index;
+			pfMemCopy(&diskConfig[index], config, sizeof(CfgDisk));
+			diskStatus[index] = 1;
+#if (DISK_USE_CACHE == 1)
+			diskCacheInvalidate(index);
+			diskPinCount[index] = 0;
+			pfMemSet(&diskCacheStats[index], 0, sizeof(DiskCacheStats));
+#endif
+			return enStatusSuccess;
+		}
+	}
+
+	return enStatusNoMem;
+}
+
+PFEnStatus diskInit(PFbyte drive)
+{
+	PFEnStatus status;
+
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+
+#if (DISK_USE_CACHE == 1)
+	// The medium may have changed, dirty sectors are written back while the device still takes them
+	if(diskConfig[drive].devGetStatus(diskId[drive]) == enStatusSuccess)
+	{
+		diskCacheFlush(drive);
+	}
+	diskCacheInvalidate(drive);
+#endif
+	status = diskConfig[drive].devOpen(&diskId[drive], (pCfgMmc)diskConfig[drive].devConfig);
+#if (DISK_USE_CACHE == 1)
+	if(status == enStatusSuccess)
+	{
+		diskCachePinFat(drive);
+	}
+#endif
+	return status;
+}
+
+PFEnStatus diskGetStatus(PFbyte drive)
+{
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+
+	return diskConfig[drive].devGetStatus(diskId[drive]);
+}
+
+PFEnStatus diskRead(PFbyte drive, PFbyte* buff, PFdword sector, PFdword count)
+{
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+
+#if (DISK_USE_CACHE == 1)
+	return diskCacheRead(drive, buff, sector, count);
+#else
+	return diskConfig[drive].devRead(diskId[drive], buff, sector, count);
+#endif
+}
+
+PFEnStatus diskWrite(PFbyte drive, const PFbyte *buff, PFdword sector, PFdword count)
+{
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+	if(diskConfig[drive].allowWrite != enBooleanTrue)
+	{
+		return enStatusWriteProtected;
+	}
+
+#if (DISK_USE_CACHE == 1)
+	return diskCacheWrite(drive, buff, sector, count);
+#else
+	return diskConfig[drive].devWrite(diskId[drive], buff, sector, count);
+#endif
+}
+
+PFEnStatus diskIoCtrl(PFbyte drive, PFbyte cmd, void* buff)
+{
+	if(drive >= MAX_DISK_SUPPORTED || diskStatus[drive] == 0)
+	{
+		return enStatusInvalidDrive;
+	}
+
+#if (DISK_USE_CACHE == 1)
+	// The file system syncs its files with CTRL_SYNC, the cache is written back whatever the permission
+	if(cmd == CTRL_SYNC)
+	{
+		PFEnStatus status = diskCacheFlush(drive);
+		if(status != enStatusSuccess || diskConfig[drive].allowIoCtrl != enBooleanTrue)
+		{
+			return status;
+		}
+	}
+#endif
+	if(diskConfig[drive].allowIoCtrl != enBooleanTrue)
+	{
+		return enStatusNotSupported;
+	}
+
+	return diskConfig[drive].devIoCtrl(diskId[drive], cmd, buff);
+}
@@ -0,0 +1,496 @@
+/**
+ *  \file       fatFsExt.c
+ *  \brief      Extensions to the FatFs module.
+ *
+ *  These functions work on the FatFs structures directly and share the FAT window of the
+ *  file system object with the module, so the window is kept in the same state as the module
+ *  keeps it: winsect always names the sector in win[] and wflag marks it for write back.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "diskIo.h"
+#include "fatFs.h"
+
+#if ((FS_READONLY == 0) && (FS_MINIMIZE == 0))
+
+#define FAT_ERROR_CLUSTER           0xFFFFFFFF
+
+/* Writes back the window if it is dirty and loads another sector, same as move_window() of the module */
+static PFEnStatus fsExtMoveWindow(FatFs* fs, PFdword sector)
+{
+    PFdword wsect = fs->winsect;
+    PFbyte n;
+
+    if (wsect == sector)
+    {
+        return enStatusSuccess;
+    }
+
+    if (fs->wflag)
+    {
+        if (diskWrite(fs->drive, fs->win, wsect, 1) != enStatusSuccess)
+        {
+            return enStatusDiskError;
+        }
+        fs->wflag = 0;
+        // Mirror FAT sectors to the other FAT copies
+        if (wsect < (fs->fatbase + fs->sects_fat))
+        {
+            for (n = fs->n_fats; n >= 2; n--)
+            {
+                wsect += fs->sects_fat;
+                diskWrite(fs->drive, fs->win, wsect, 1);
+            }
+        }
+    }
+
+    if (sector != 0)
+    {
+        if (diskRead(fs->drive, fs->win, sector, 1) != enStatusSuccess)
+        {
+            return enStatusDiskError;
+        }
+        fs->winsect = sector;
+    }
+    return enStatusSuccess;
+}
+
+/* Reads a FAT entry, FAT_ERROR_CLUSTER on disk error */
+static PFdword fsExtGetFat(FatFs* fs, PFdword clust)
+{
+    PFdword bc, fsect;
+    PFword wc;
+
+    fsect = fs->fatbase;
+    switch (fs->fs_type)
+    {
+        case FS_FAT12:
+            bc = clust;
+            bc += bc / 2;
+            if (fsExtMoveWindow(fs, fsect + (bc / SS(fs))) != enStatusSuccess)
+            {
+                break;
+            }
+            wc = fs->win[bc & (SS(fs) - 1)];
+            bc++;
+            if (fsExtMoveWindow(fs, fsect + (bc / SS(fs))) != enStatusSuccess)
+            {
+                break;
+            }
+            wc |= (PFword)fs->win[bc & (SS(fs) - 1)] << 8;
+            return (clust & 1) ? (wc >> 4) : (wc & 0xFFF);
+
+        case FS_FAT16:
+            if (fsExtMoveWindow(fs, fsect + (clust / (SS(fs) / 2))) != enStatusSuccess)
+            {
+                break;
+            }
+            return LD_WORD(&fs->win[((PFword)clust * 2) & (SS(fs) - 1)]);
+
+        case FS_FAT32:
+            if (fsExtMoveWindow(fs, fsect + (clust / (SS(fs) / 4))) != enStatusSuccess)
+            {
+                break;
+            }
+            return LD_DWORD(&fs->win[((PFword)clust * 4) & (SS(fs) - 1)]) & 0x0FFFFFFF;
+
+        default:
+            break;
+    }
+
+    return FAT_ERROR_CLUSTER;
+}
+
+/* Writes a FAT entry */
+static PFEnStatus fsExtPutFat(FatFs* fs, PFdword clust, PFdword val)
+{
+    PFdword bc, fsect;
+    PFbyte* ptr;
+    PFEnStatus status;
+
+    fsect = fs->fatbase;
+    switch (fs->fs_type)
+    {
+        case FS_FAT12:
+            bc = clust;
+            bc += bc / 2;
+            status = fsExtMoveWindow(fs, fsect + (bc / SS(fs)));
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            ptr = &fs->win[bc & (SS(fs) - 1)];
+            *ptr = (clust & 1) ? ((*ptr & 0x0F) | ((PFbyte)val << 4)) : (PFbyte)val;
+            bc++;
+            fs->wflag = 1;
+            status = fsExtMoveWindow(fs, fsect + (bc / SS(fs)));
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            ptr = &fs->win[bc & (SS(fs) - 1)];
+            *ptr = (clust & 1) ? (PFbyte)(val >> 4) : ((*ptr & 0xF0) | ((PFbyte)(val >> 8) & 0x0F));
+            break;
+
+        case FS_FAT16:
+            status = fsExtMoveWindow(fs, fsect + (clust / (SS(fs) / 2)));
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            ST_WORD(&fs->win[((PFword)clust * 2) & (SS(fs) - 1)], (PFword)val);
+            break;
+
+        case FS_FAT32:
+            status = fsExtMoveWindow(fs, fsect + (clust / (SS(fs) / 4)));
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            ST_DWORD(&fs->win[((PFword)clust * 4) & (SS(fs) - 1)], val);
+            break;
+
+        default:
+            return enStatusInternalError;
+    }
+
+    fs->wflag = 1;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileExpand(FsFile* fp, PFdword size)
+{
+    FatFs* fs;
+    PFdword clustSize, count, found, start, clust, first, val;
+    PFEnBoolean wrapped = enBooleanFalse;
+    PFEnStatus status;
+
+    if (fp == NULL || fp->fs == NULL || fp->fs->fs_type == 0 || fp->id != fp->fs->id)
+    {
+        return enStatusInvalidObject;
+    }
+    if ((fp->flag & FA__ERROR) != 0)
+    {
+        return enStatusInternalError;
+    }
+    if ((fp->flag & FA_WRITE) == 0)
+    {
+        return enStatusAccessDenied;
+    }
+    // Only an empty file without a cluster chain can be expanded
+    if (fp->fsize != 0 || fp->org_clust != 0)
+    {
+        return enStatusInvState;
+    }
+    if (size == 0)
+    {
+        return enStatusSuccess;
+    }
+
+    fs = fp->fs;
+    clustSize = (PFdword)fs->csize * SS(fs);
+    count = (size + clustSize - 1) / clustSize;
+    if (count > fs->max_clust - 2 || (fs->free_clust <= fs->max_clust - 2 && count > fs->free_clust))
+    {
+        return enStatusAccessDenied;
+    }
+
+    // Search a run of free clusters, starting next to the last allocated one
+    start = fs->last_clust + 1;
+    if (start < 2 || start >= fs->max_clust)
+    {
+        start = 2;
+    }
+    first = clust = start;
+    found = 0;
+    for (;;)
+    {
+        val = fsExtGetFat(fs, clust);
+        if (val == FAT_ERROR_CLUSTER)
+        {
+            return enStatusDiskError;
+        }
+        if (val == 0)
+        {
+            if (++found == count)
+            {
+                break;
+            }
+        }
+        else
+        {
+            first = clust + 1;
+            found = 0;
+        }
+        clust++;
+        if (clust >= fs->max_clust)
+        {
+            // A run can not wrap around the end of the FAT
+            if (wrapped == enBooleanTrue)
+            {
+                return enStatusAccessDenied;
+            }
+            first = clust = 2;
+            found = 0;
+            wrapped = enBooleanTrue;
+        }
+        // After the wrap a run may still start before the start cluster and end after it
+        if (wrapped == enBooleanTrue && clust == start + count - 1)
+        {
+            return enStatusAccessDenied;
+        }
+    }
+
+    // Link the run into a chain; the entries are consecutive, so each FAT sector is written once
+    for (clust = first; clust < first + count - 1; clust++)
+    {
+        status = fsExtPutFat(fs, clust, clust + 1);
+        if (status != enStatusSuccess)
+        {
+            fp->flag |= FA__ERROR;
+            return status;
+        }
+    }
+    status = fsExtPutFat(fs, clust, 0x0FFFFFFF);
+    if (status != enStatusSuccess)
+    {
+        fp->flag |= FA__ERROR;
+        return status;
+    }
+
+    fs->last_clust = clust;
+    if (fs->free_clust <= fs->max_clust - 2)
+    {
+        fs->free_clust -= count;
+    }
+    if (fs->fs_type == FS_FAT32)
+    {
+        fs->fsi_flag = 1;
+    }
+
+    // The directory entry is updated with the new chain and size by fsFileSync() or fsFileClose()
+    fp->org_clust = first;
+    fp->fsize = size;
+    fp->flag |= FA__WRITTEN;
+    return enStatusSuccess;
+}
+
+#if (FS_TINY == 1)
+PFEnStatus fsFileLinkMap(FsFile* fp, PFdword* map)
+{
+    FatFs* fs;
+    PFdword* entry;
+    PFdword size, used, clust, prev, start, count;
+
+    if (fp == NULL || fp->fs == NULL || fp->fs->fs_type == 0 || fp->id != fp->fs->id || map == NULL)
+    {
+        return enStatusInvalidObject;
+    }
+    if ((fp->flag & FA__ERROR) != 0)
+    {
+        return enStatusInternalError;
+    }
+
+    fs = fp->fs;
+    size = map[0];
+    entry = &map[1];
+    used = 2;
+    clust = fp->org_clust;
+
+    // Each fragment is stored as its length in clusters followed by its first cluster
+    if (clust != 0)
+    {
+        do
+        {
+            start = clust;
+            count = 0;
+            do
+            {
+                prev = clust;
+                count++;
+                clust = fsExtGetFat(fs, clust);
+                if (clust == FAT_ERROR_CLUSTER)
+                {
+                    return enStatusDiskError;
+                }
+                if (clust <= 1)
+                {
+                    return enStatusInternalError;
+                }
+            } while (clust == prev + 1);
+
+            used += 2;
+            if (used <= size)
+            {
+                *entry++ = count;
+                *entry++ = start;
+            }
+        } while (clust < fs->max_clust);
+    }
+
+    map[0] = used;
+    if (used > size)
+    {
+        return enStatusNoMem;
+    }
+    *entry = 0;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeekFast(FsFile* fp, const PFdword* map, PFdword ofs)
+{
+    FatFs* fs;
+    const PFdword* entry;
+    PFdword clustSize, index, rest;
+
+    if (fp == NULL || fp->fs == NULL || fp->fs->fs_type == 0 || fp->id != fp->fs->id || map == NULL)
+    {
+        return enStatusInvalidObject;
+    }
+    if ((fp->flag & FA__ERROR) != 0)
+    {
+        return enStatusInternalError;
+    }
+
+    // The map only covers the clusters already in the chain
+    if (ofs > fp->fsize)
+    {
+        ofs = fp->fsize;
+    }
+
+    fp->fptr = ofs;
+    fp->csect = 255;
+    if (ofs == 0)
+    {
+        return enStatusSuccess;
+    }
+
+    // Same file state as left by fsFileSeek: the current cluster holds the byte before the
+    // pointer, csect is the next sector to access and dsect the sector holding the pointer
+    fs = fp->fs;
+    clustSize = (PFdword)fs->csize * SS(fs);
+    index = (ofs - 1) / clustSize;
+    rest = ofs - index * clustSize;
+
+    entry = &map[1];
+    for (;;)
+    {
+        if (entry[0] == 0)
+        {
+            fp->flag |= FA__ERROR;
+            return enStatusInternalError;
+        }
+        if (index < entry[0])
+        {
+            break;
+        }
+        index -= entry[0];
+        entry += 2;
+    }
+
+    fp->curr_clust = entry[1] + index;
+    fp->csect = (PFbyte)(rest / SS(fs));
+    if ((rest % SS(fs)) != 0)
+    {
+        fp->dsect = (fp->curr_clust - 2) * fs->csize + fs->database + fp->csect;
+        fp->csect++;
+    }
+    return enStatusSuccess;
+}
+#endif  // #if (FS_TINY == 1)
+
+#if ((FS_USE_FORWARD == 1) && (FS_TINY == 1))
+PFEnStatus fsFileForward(FsFile *fp, PFdword (*func)(const PFbyte*,PFdword), PFdword btr, PFdword *bf)
+{
+    FatFs* fs;
+    PFdword remain, clust, sect, count;
+    PFEnStatus status;
+
+    if (bf == NULL || func == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    *bf = 0;
+    if (fp == NULL || fp->fs == NULL || fp->fs->fs_type == 0 || fp->id != fp->fs->id)
+    {
+        return enStatusInvalidObject;
+    }
+    if ((fp->flag & FA__ERROR) != 0)
+    {
+        return enStatusInternalError;
+    }
+    if ((fp->flag & FA_READ) == 0)
+    {
+        return enStatusAccessDenied;
+    }
+
+    fs = fp->fs;
+    remain = fp->fsize - fp->fptr;
+    if (btr > remain)
+    {
+        btr = remain;
+    }
+
+    // The data is passed to the stream straight from the sector window of the file system
+    while (btr != 0 && func(NULL, 0) != 0)
+    {
+        if ((fp->fptr % SS(fs)) == 0)
+        {
+            if (fp->csect >= fs->csize)
+            {
+                clust = (fp->fptr == 0) ? fp->org_clust : fsExtGetFat(fs, fp->curr_clust);
+                if (clust == FAT_ERROR_CLUSTER)
+                {
+                    fp->flag |= FA__ERROR;
+                    return enStatusDiskError;
+                }
+                if (clust <= 1 || clust >= fs->max_clust)
+                {
+                    fp->flag |= FA__ERROR;
+                    return enStatusInternalError;
+                }
+                fp->curr_clust = clust;
+                fp->csect = 0;
+            }
+            fp->csect++;
+        }
+
+        sect = (fp->curr_clust - 2) * fs->csize + fs->database + fp->csect - 1;
+        status = fsExtMoveWindow(fs, sect);
+        if (status != enStatusSuccess)
+        {
+            fp->flag |= FA__ERROR;
+            return status;
+        }
+        fp->dsect = sect;
+
+        count = SS(fs) - (fp->fptr % SS(fs));
+        if (count > btr)
+        {
+            count = btr;
+        }
+        count = func(&fs->win[fp->fptr % SS(fs)], count);
+        if (count == 0)
+        {
+            fp->flag |= FA__ERROR;
+            return enStatusInternalError;
+        }
+
+        fp->fptr += count;
+        *bf += count;
+        btr -= count;
+    }
+    return enStatusSuccess;
+}
+#endif  // #if ((FS_USE_FORWARD == 1) && (FS_TINY == 1))
+
+#endif  // #if ((FS_READONLY == 0) && (FS_MINIMIZE == 0))
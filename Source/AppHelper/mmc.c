@@ -0,0 +1,709 @@
+/**
+ * \file    mmc.c
+ * \brief   MMC/SDC Card Driver over SPI, based on the generic MMC driver by ChaN.
+ *
+ * Transfers of more than one sector use the multiple block commands:
+ * reads are one CMD18 followed by CMD12, writes are ACMD23 (pre-erase, SDC only) and
+ * one CMD25 closed by the stop token. Data blocks are moved with the SPI block read/write
+ * functions and, if configured, the SPI yield function is called between blocks of a write so
+ * that other devices on the bus can be serviced without aborting the transfer.
+ *
+ * In SPI mode the chip select may only be released in the middle of a transfer while the card is
+ * busy programming a written block, the card then keeps the busy state until it is selected again.
+ * A CMD18 read has no such point, the card sends the next block whatever the chip select, so reads
+ * are not interrupted.
+ *
+ * \copyright Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module.
+ *
+ * Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "mmc.h"
+#include "diskIo.h"
+
+/* MMC/SD command */
+#define CMD0        (0)             /* GO_IDLE_STATE */
+#define CMD1        (1)             /* SEND_OP_COND (MMC) */
+#define ACMD41      (0x80 + 41)     /* SEND_OP_COND (SDC) */
+#define CMD8        (8)             /* SEND_IF_COND */
+#define CMD9        (9)             /* SEND_CSD */
+#define CMD10       (10)            /* SEND_CID */
+#define CMD12       (12)            /* STOP_TRANSMISSION */
+#define ACMD13      (0x80 + 13)     /* SD_STATUS (SDC) */
+#define CMD16       (16)            /* SET_BLOCKLEN */
+#define CMD17       (17)            /* READ_SINGLE_BLOCK */
+#define CMD18       (18)            /* READ_MULTIPLE_BLOCK */
+#define CMD23       (23)            /* SET_BLOCK_COUNT (MMC) */
+#define ACMD23      (0x80 + 23)     /* SET_WR_BLK_ERASE_COUNT (SDC) */
+#define CMD24       (24)            /* WRITE_BLOCK */
+#define CMD25       (25)            /* WRITE_MULTIPLE_BLOCK */
+#define CMD55       (55)            /* APP_CMD */
+#define CMD58       (58)            /* READ_OCR */
+
+/* Data tokens */
+#define MMC_TOKEN_SINGLE_BLOCK      0xFE    /* Start token of CMD17/18/24 data block */
+#define MMC_TOKEN_MULTI_WRITE       0xFC    /* Start token of CMD25 data block */
+#define MMC_TOKEN_STOP_TRAN         0xFD    /* Stop token of CMD25 */
+
+#define MMC_SECTOR_SIZE             512
+#define MMC_READY_TIMEOUT_MS        500
+#define MMC_INIT_TIMEOUT_MS         1000
+
+static CfgMmc mmcConfig[MMC_MAX_DEVICE_SUPPORTED];
+static MmcStats mmcStats[MMC_MAX_DEVICE_SUPPORTED];
+static PFbyte mmcInit[MMC_MAX_DEVICE_SUPPORTED];
+static PFbyte mmcSpiId[MMC_MAX_DEVICE_SUPPORTED];
+static PFEnBoolean mmcRegistered[MMC_MAX_DEVICE_SUPPORTED];
+static PFbyte CardType[MMC_MAX_DEVICE_SUPPORTED];
+
+static void mmcSpiSend(PFbyte deviceId, PFbyte data)
+{
+    PFbyte rxData;
+    mmcConfig[deviceId].spiExchangeByte(&mmcSpiId[deviceId], data, &rxData);
+}
+
+static PFbyte mmcSpiRcv(PFbyte deviceId)
+{
+    PFbyte rxData = 0xFF;
+    mmcConfig[deviceId].spiExchangeByte(&mmcSpiId[deviceId], 0xFF, &rxData);
+    return rxData;
+}
+
+/* Wait for card ready, returns 0xFF when ready */
+static PFbyte mmcWaitReady(PFbyte deviceId)
+{
+    PFbyte res;
+    PFdword timeout = pfTickSetTimeoutMs(MMC_READY_TIMEOUT_MS);
+
+    mmcSpiRcv(deviceId);
+    do
+    {
+        res = mmcSpiRcv(deviceId);
+        mmcStats[deviceId].busyPolls++;
+    } while (res != 0xFF && pfTickCheckTimeout(timeout) == enBooleanFalse);
+
+    return res;
+}
+
+static void mmcDeselect(PFbyte deviceId)
+{
+    mmcConfig[deviceId].spiChipSelect(&mmcSpiId[deviceId], 1);
+    mmcSpiRcv(deviceId);            /* Dummy clock to release DO */
+}
+
+static PFEnBoolean mmcSelect(PFbyte deviceId)
+{
+    if (mmcConfig[deviceId].spiChipSelect(&mmcSpiId[deviceId], 0) != enStatusSuccess)
+    {
+        return enBooleanFalse;
+    }
+    if (mmcWaitReady(deviceId) != 0xFF)
+    {
+        mmcDeselect(deviceId);
+        return enBooleanFalse;
+    }
+    return enBooleanTrue;
+}
+
+/* Hands the bus to other devices between data blocks of a multiple block write, while the card is busy */
+static void mmcYield(PFbyte deviceId)
+{
+    if (mmcConfig[deviceId].spiYield != NULL)
+    {
+        mmcConfig[deviceId].spiYield(&mmcSpiId[deviceId]);
+    }
+}
+
+/* Moves a sector of data with the SPI DMA mode. enStatusNotSupported and enStatusNotConfigured
+ * are returned untouched when the DMA mode can not be used, so the caller falls back to byte transfers. */
+static PFEnStatus mmcDmaTransfer(PFbyte deviceId, PFbyte* txData, PFbyte* rxData)
+{
+    if (mmcConfig[deviceId].spiDmaTransfer == NULL)
+    {
+        return enStatusNotSupported;
+    }
+    return mmcConfig[deviceId].spiDmaTransfer(&mmcSpiId[deviceId], txData, rxData, MMC_SECTOR_SIZE);
+}
+
+static PFbyte mmcCheckPower(void)
+{
+    /* Card power is not switched on this board */
+    return 1;
+}
+
+static PFEnBoolean mmcReceiveDatablock(PFbyte deviceId, PFbyte *pBuf, PFdword size)
+{
+    PFbyte token;
+    PFdword readBytes = 0;
+    PFEnStatus status = enStatusNotSupported;
+    PFdword timeout = pfTickSetTimeoutMs(MMC_READY_TIMEOUT_MS);
+
+    do
+    {
+        token = mmcSpiRcv(deviceId);
+        mmcStats[deviceId].tokenPolls++;
+    } while (token == 0xFF && pfTickCheckTimeout(timeout) == enBooleanFalse);
+
+    if (token != MMC_TOKEN_SINGLE_BLOCK)
+    {
+        return enBooleanFalse;
+    }
+
+    if (size == MMC_SECTOR_SIZE)
+    {
+        status = mmcDmaTransfer(deviceId, NULL, pBuf);
+        if (status != enStatusSuccess && status != enStatusNotSupported && status != enStatusNotConfigured)
+        {
+            return enBooleanFalse;
+        }
+    }
+    if (status != enStatusSuccess &&
+        (mmcConfig[deviceId].spiRead(&mmcSpiId[deviceId], pBuf, size, &readBytes, NULL) != enStatusSuccess ||
+         readBytes != size))
+    {
+        return enBooleanFalse;
+    }
+    mmcSpiRcv(deviceId);            /* Discard CRC */
+    mmcSpiRcv(deviceId);
+
+    return enBooleanTrue;
+}
+
+#if (MMC_READONLY == 0)
+static PFEnBoolean mmcWriteDatablock(PFbyte deviceId, const PFbyte *pBuf, PFbyte token)
+{
+    PFbyte resp;
+    PFEnStatus status;
+
+    if (mmcWaitReady(deviceId) != 0xFF)
+    {
+        return enBooleanFalse;
+    }
+
+    mmcSpiSend(deviceId, token);
+    if (token != MMC_TOKEN_STOP_TRAN)
+    {
+        status = mmcDmaTransfer(deviceId, (PFbyte*)pBuf, NULL);
+        if (status == enStatusNotSupported || status == enStatusNotConfigured)
+        {
+            status = mmcConfig[deviceId].spiWrite(&mmcSpiId[deviceId], (PFbyte*)pBuf, MMC_SECTOR_SIZE, NULL);
+        }
+        if (status != enStatusSuccess)
+        {
+            return enBooleanFalse;
+        }
+        mmcSpiSend(deviceId, 0xFF);     /* Dummy CRC */
+        mmcSpiSend(deviceId, 0xFF);
+        resp = mmcSpiRcv(deviceId);
+        if ((resp & 0x1F) != 0x05)      /* Data accepted? */
+        {
+            return enBooleanFalse;
+        }
+    }
+
+    return enBooleanTrue;
+}
+#endif  // #if (MMC_READONLY == 0)
+
+static PFbyte mmcSendCommand(PFbyte deviceId, PFbyte cmd, PFdword arg)
+{
+    PFbyte n, res;
+
+    if (cmd & 0x80)
+    {
+        /* ACMD<n> is the command sequence of CMD55-CMD<n> */
+        cmd &= 0x7F;
+        res = mmcSendCommand(deviceId, CMD55, 0);
+        if (res > 1)
+        {
+            return res;
+        }
+    }
+
+    /* Select the card and wait for ready except to stop multiple block read */
+    if (cmd != CMD12)
+    {
+        mmcDeselect(deviceId);
+        if (mmcSelect(deviceId) != enBooleanTrue)
+        {
+            return 0xFF;
+        }
+    }
+
+    mmcStats[deviceId].commands++;
+    mmcSpiSend(deviceId, 0x40 | cmd);
+    mmcSpiSend(deviceId, (PFbyte)(arg >> 24));
+    mmcSpiSend(deviceId, (PFbyte)(arg >> 16));
+    mmcSpiSend(deviceId, (PFbyte)(arg >> 8));
+    mmcSpiSend(deviceId, (PFbyte)arg);
+    n = 0x01;                       /* Dummy CRC + Stop */
+    if (cmd == CMD0)
+    {
+        n = 0x95;                   /* Valid CRC for CMD0(0) */
+    }
+    if (cmd == CMD8)
+    {
+        n = 0x87;                   /* Valid CRC for CMD8(0x1AA) */
+    }
+    mmcSpiSend(deviceId, n);
+
+    if (cmd == CMD12)
+    {
+        mmcSpiRcv(deviceId);        /* Skip a stuff byte */
+    }
+    n = 10;
+    do
+    {
+        res = mmcSpiRcv(deviceId);
+    } while ((res & 0x80) && --n);
+
+    return res;
+}
+
+static PFEnStatus mmcSoftInit(PFbyte deviceId)
+{
+    PFbyte n, cmd, ty, ocr[4];
+    PFdword timeout;
+
+    mmcInit[deviceId] = 0;
+    if (mmcCheckPower() == 0)
+    {
+        return enStatusNotConfigured;
+    }
+
+    /* 80 dummy clocks with the card deselected */
+    mmcConfig[deviceId].spiChipSelect(&mmcSpiId[deviceId], 1);
+    for (n = 10; n; n--)
+    {
+        mmcSpiRcv(deviceId);
+    }
+
+    ty = 0;
+    if (mmcSendCommand(deviceId, CMD0, 0) == 1)
+    {
+        timeout = pfTickSetTimeoutMs(MMC_INIT_TIMEOUT_MS);
+        if (mmcSendCommand(deviceId, CMD8, 0x1AA) == 1)
+        {
+            /* SDv2 */
+            for (n = 0; n < 4; n++)
+            {
+                ocr[n] = mmcSpiRcv(deviceId);
+            }
+            if (ocr[2] == 0x01 && ocr[3] == 0xAA)
+            {
+                /* Wait for leaving idle state (ACMD41 with HCS bit) */
+                while (pfTickCheckTimeout(timeout) == enBooleanFalse && mmcSendCommand(deviceId, ACMD41, 1UL << 30));
+                if (pfTickCheckTimeout(timeout) == enBooleanFalse && mmcSendCommand(deviceId, CMD58, 0) == 0)
+                {
+                    for (n = 0; n < 4; n++)
+                    {
+                        ocr[n] = mmcSpiRcv(deviceId);
+                    }
+                    ty = (ocr[0] & 0x40) ? CT_SD2 | CT_BLOCK : CT_SD2;
+                }
+            }
+        }
+        else
+        {
+            /* SDv1 or MMCv3 */
+            if (mmcSendCommand(deviceId, ACMD41, 0) <= 1)
+            {
+                ty = CT_SD1;
+                cmd = ACMD41;
+            }
+            else
+            {
+                ty = CT_MMC;
+                cmd = CMD1;
+            }
+            while (pfTickCheckTimeout(timeout) == enBooleanFalse && mmcSendCommand(deviceId, cmd, 0));
+            if (pfTickCheckTimeout(timeout) == enBooleanTrue || mmcSendCommand(deviceId, CMD16, MMC_SECTOR_SIZE) != 0)
+            {
+                ty = 0;
+            }
+        }
+    }
+    CardType[deviceId] = ty;
+    mmcDeselect(deviceId);
+
+    if (ty == 0)
+    {
+        return enStatusDiskNotReady;
+    }
+    mmcInit[deviceId] = 1;
+    return enStatusSuccess;
+}
+
+/* Gives back the SPI bus device and the slot of a card which could not be initialized */
+static PFEnStatus mmcRelease(PFbyte deviceId, PFEnStatus status)
+{
+    if (status != enStatusSuccess)
+    {
+        if (mmcConfig[deviceId].spiUnregister != NULL)
+        {
+            mmcConfig[deviceId].spiUnregister(&mmcSpiId[deviceId]);
+        }
+        mmcRegistered[deviceId] = enBooleanFalse;
+    }
+    return status;
+}
+
+PFEnStatus mmcOpen(PFbyte* deviceId, pCfgMmc config)
+{
+    PFbyte index, freeIndex = 0xFF;
+    PFEnStatus status;
+
+    if (config == NULL || deviceId == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    for (index = 0; index < MMC_MAX_DEVICE_SUPPORTED; index++)
+    {
+        if (mmcRegistered[index] == enBooleanTrue)
+        {
+            /* Card already opened, initialize it again */
+            if (mmcConfig[index].gpioChipSelect.port == config->gpioChipSelect.port &&
+                mmcConfig[index].gpioChipSelect.pin == config->gpioChipSelect.pin)
+            {
+                *deviceId = index;
+                return mmcRelease(index, mmcSoftInit(index));
+            }
+        }
+        else if (freeIndex == 0xFF)
+        {
+            freeIndex = index;
+        }
+    }
+    if (freeIndex == 0xFF)
+    {
+        return enStatusNoMem;
+    }
+
+    *deviceId = freeIndex;
+    pfMemCopy(&mmcConfig[freeIndex], config, sizeof(CfgMmc));
+    pfMemSet(&mmcStats[freeIndex], 0, sizeof(MmcStats));
+    status = mmcConfig[freeIndex].spiRegister(&mmcSpiId[freeIndex], &mmcConfig[freeIndex].gpioChipSelect);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    mmcRegistered[freeIndex] = enBooleanTrue;
+
+    return mmcRelease(freeIndex, mmcSoftInit(freeIndex));
+}
+
+PFEnStatus mmcGetStatus(PFbyte deviceId)
+{
+    if (deviceId >= MMC_MAX_DEVICE_SUPPORTED)
+    {
+        return enStatusInvArgs;
+    }
+
+    if (mmcConfig[deviceId].useCardDetect == enBooleanTrue &&
+        (PF_GPIO_PORT_READ(mmcConfig[deviceId].gpioCardDetect.port) & mmcConfig[deviceId].gpioCardDetect.pin) != 0)
+    {
+        mmcInit[deviceId] = 0;
+        return enStatusNotExist;
+    }
+
+    return (mmcInit[deviceId] == 1) ? enStatusSuccess : enStatusNotConfigured;
+}
+
+PFEnStatus mmcRead(PFbyte deviceId, PFbyte *pBuf, PFdword sector, PFdword uCount)
+{
+    if (pBuf == NULL || uCount == 0)
+    {
+        return enStatusInvArgs;
+    }
+    if (mmcGetStatus(deviceId) != enStatusSuccess)
+    {
+        return enStatusDiskNotReady;
+    }
+
+    if (!(CardType[deviceId] & CT_BLOCK))
+    {
+        sector *= MMC_SECTOR_SIZE;      /* Byte addressing */
+    }
+
+    if (uCount == 1)
+    {
+        if (mmcSendCommand(deviceId, CMD17, sector) == 0 &&
+            mmcReceiveDatablock(deviceId, pBuf, MMC_SECTOR_SIZE) == enBooleanTrue)
+        {
+            uCount = 0;
+            mmcStats[deviceId].blocksRead++;
+        }
+    }
+    else
+    {
+        if (mmcSendCommand(deviceId, CMD18, sector) == 0)
+        {
+            mmcStats[deviceId].multiReads++;
+            do
+            {
+                if (mmcReceiveDatablock(deviceId, pBuf, MMC_SECTOR_SIZE) != enBooleanTrue)
+                {
+                    break;
+                }
+                mmcStats[deviceId].blocksRead++;
+                pBuf += MMC_SECTOR_SIZE;
+            } while (--uCount);
+            mmcSendCommand(deviceId, CMD12, 0);
+        }
+    }
+    mmcDeselect(deviceId);
+
+    return (uCount == 0) ? enStatusSuccess : enStatusDiskError;
+}
+
+PFEnStatus mmcWrite(PFbyte deviceId, const PFbyte *pBuf, PFdword sector, PFdword uCount)
+{
+#if (MMC_READONLY == 0)
+    if (pBuf == NULL || uCount == 0)
+    {
+        return enStatusInvArgs;
+    }
+    if (mmcGetStatus(deviceId) != enStatusSuccess)
+    {
+        return enStatusDiskNotReady;
+    }
+
+    if (!(CardType[deviceId] & CT_BLOCK))
+    {
+        sector *= MMC_SECTOR_SIZE;      /* Byte addressing */
+    }
+
+    if (uCount == 1)
+    {
+        if (mmcSendCommand(deviceId, CMD24, sector) == 0 &&
+            mmcWriteDatablock(deviceId, pBuf, MMC_TOKEN_SINGLE_BLOCK) == enBooleanTrue)
+        {
+            uCount = 0;
+            mmcStats[deviceId].blocksWritten++;
+        }
+    }
+    else
+    {
+        if (CardType[deviceId] & CT_SDC)
+        {
+            mmcSendCommand(deviceId, ACMD23, uCount);   /* Pre-erase the blocks to be written */
+        }
+        if (mmcSendCommand(deviceId, CMD25, sector) == 0)
+        {
+            mmcStats[deviceId].multiWrites++;
+            do
+            {
+                if (mmcWriteDatablock(deviceId, pBuf, MMC_TOKEN_MULTI_WRITE) != enBooleanTrue)
+                {
+                    break;
+                }
+                mmcStats[deviceId].blocksWritten++;
+                pBuf += MMC_SECTOR_SIZE;
+                if (uCount > 1)
+                {
+                    // The card programs the block just accepted, its chip select may be released
+                    mmcYield(deviceId);
+                }
+            } while (--uCount);
+            if (mmcWriteDatablock(deviceId, 0, MMC_TOKEN_STOP_TRAN) != enBooleanTrue)
+            {
+                uCount = 1;
+            }
+        }
+    }
+    mmcDeselect(deviceId);
+
+    return (uCount == 0) ? enStatusSuccess : enStatusDiskError;
+#else
+    return enStatusWriteProtected;
+#endif  // #if (MMC_READONLY == 0)
+}
+
+PFEnStatus mmcIoCtrl(PFbyte deviceId, PFbyte ctrl, void *pBuf)
+{
+#if (MMC_USE_IOCTL == 1)
+    PFEnStatus res = enStatusDiskError;
+    PFbyte n, csd[16], *ptr = pBuf;
+    PFword csize;
+
+    if (deviceId >= MMC_MAX_DEVICE_SUPPORTED)
+    {
+        return enStatusInvArgs;
+    }
+
+    switch (ctrl)
+    {
+    case CTRL_POWER:
+        switch (*ptr)
+        {
+        case 0:                     /* Power off */
+        case 1:                     /* Power on */
+            return enStatusSuccess;
+        case 2:                     /* Get power status */
+            *(ptr + 1) = mmcCheckPower();
+            return enStatusSuccess;
+        default:
+            return enStatusInvArgs;
+        }
+
+    case CTRL_GET_STATE:
+        *ptr = mmcGetStatus(deviceId);
+        return enStatusSuccess;
+
+    case CTRL_DISK_INIT:
+        n = mmcSoftInit(deviceId);
+        if (ptr != NULL)
+        {
+            *ptr = n;
+        }
+        return enStatusSuccess;
+
+    default:
+        break;
+    }
+
+    if (mmcGetStatus(deviceId) != enStatusSuccess)
+    {
+        return enStatusDiskNotReady;
+    }
+
+    switch (ctrl)
+    {
+    case CTRL_SYNC:
+        if (mmcSelect(deviceId) == enBooleanTrue)
+        {
+            res = enStatusSuccess;
+        }
+        break;
+
+    case GET_SECTOR_COUNT:
+        if (mmcSendCommand(deviceId, CMD9, 0) == 0 && mmcReceiveDatablock(deviceId, csd, 16) == enBooleanTrue)
+        {
+            if ((csd[0] >> 6) == 1)
+            {
+                /* SDC ver 2.00 */
+                csize = csd[9] + ((PFword)csd[8] << 8) + 1;
+                *(PFdword*)pBuf = (PFdword)csize << 10;
+            }
+            else
+            {
+                /* SDC ver 1.XX or MMC */
+                n = (csd[5] & 15) + ((csd[10] & 128) >> 7) + ((csd[9] & 3) << 1) + 2;
+                csize = (csd[8] >> 6) + ((PFword)csd[7] << 2) + ((PFword)(csd[6] & 3) << 10) + 1;
+                *(PFdword*)pBuf = (PFdword)csize << (n - 9);
+            }
+            res = enStatusSuccess;
+        }
+        break;
+
+    case GET_SECTOR_SIZE:
+        *(PFword*)pBuf = MMC_SECTOR_SIZE;
+        res = enStatusSuccess;
+        break;
+
+    case GET_BLOCK_SIZE:
+        if (CardType[deviceId] & CT_SD2)
+        {
+            /* Read partial block of SD status */
+            if (mmcSendCommand(deviceId, ACMD13, 0) == 0)
+            {
+                mmcSpiRcv(deviceId);
+                if (mmcReceiveDatablock(deviceId, csd, 16) == enBooleanTrue)
+                {
+                    for (n = 64 - 16; n; n--)
+                    {
+                        mmcSpiRcv(deviceId);
+                    }
+                    *(PFdword*)pBuf = 16UL << (csd[10] >> 4);
+                    res = enStatusSuccess;
+                }
+            }
+        }
+        else
+        {
+            if (mmcSendCommand(deviceId, CMD9, 0) == 0 && mmcReceiveDatablock(deviceId, csd, 16) == enBooleanTrue)
+            {
+                if (CardType[deviceId] & CT_SD1)
+                {
+                    *(PFdword*)pBuf = (((csd[10] & 63) << 1) + ((PFword)(csd[11] & 128) >> 7) + 1) << ((csd[13] >> 6) - 1);
+                }
+                else
+                {
+                    *(PFdword*)pBuf = ((PFword)((csd[10] & 124) >> 2) + 1) * (((csd[11] & 3) << 3) + ((csd[11] & 224) >> 5) + 1);
+                }
+                res = enStatusSuccess;
+            }
+        }
+        break;
+
+    case MMC_GET_TYPE:
+        *ptr = CardType[deviceId];
+        res = enStatusSuccess;
+        break;
+
+    case MMC_GET_CSD:
+        if (mmcSendCommand(deviceId, CMD9, 0) == 0 && mmcReceiveDatablock(deviceId, ptr, 16) == enBooleanTrue)
+        {
+            res = enStatusSuccess;
+        }
+        break;
+
+    case MMC_GET_CID:
+        if (mmcSendCommand(deviceId, CMD10, 0) == 0 && mmcReceiveDatablock(deviceId, ptr, 16) == enBooleanTrue)
+        {
+            res = enStatusSuccess;
+        }
+        break;
+
+    case MMC_GET_OCR:
+        if (mmcSendCommand(deviceId, CMD58, 0) == 0)
+        {
+            for (n = 4; n; n--)
+            {
+                *ptr++ = mmcSpiRcv(deviceId);
+            }
+            res = enStatusSuccess;
+        }
+        break;
+
+    case MMC_GET_SDSTAT:
+        if (mmcSendCommand(deviceId, ACMD13, 0) == 0)
+        {
+            mmcSpiRcv(deviceId);
+            if (mmcReceiveDatablock(deviceId, ptr, 64) == enBooleanTrue)
+            {
+                res = enStatusSuccess;
+            }
+        }
+        break;
+
+    default:
+        res = enStatusInvArgs;
+        break;
+    }
+    mmcDeselect(deviceId);
+
+    return res;
+#else
+    return enStatusNotSupported;
+#endif  // #if (MMC_USE_IOCTL == 1)
+}
+
+PFEnStatus mmcGetStats(PFbyte deviceId, MmcStats* stats)
+{
+    if (deviceId >= MMC_MAX_DEVICE_SUPPORTED || stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    *stats = mmcStats[deviceId];
+    return enStatusSuccess;
+}
@@ -0,0 +1,623 @@
+/**
+ *  \file       pntImage.c
+ *  \brief      Native canvas image format (.pnt) with run-length and palette encoding.
+ *
+ *  Canvas drawings are mostly long runs of one color with few colors in total. Each row is coded
+ *  greedily: a run is emitted wherever two or more equal pixels follow each other, the pixels in
+ *  between are collected into literals.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "pntImage.h"
+
+#define PNT_RUN_FLAG                0x80
+#define PNT_MAX_PACKET_BYTES        (1 + 2 * PNT_MAX_PACKET)
+#define PNT_LCD_GRAM_WRITE          0x22    /* GRAM write register of the LCD controller */
+
+static const PFbyte pntMagic[4] = {'P', 'N', 'T', '1'};
+
+/* Buffered reader used by the decoder */
+typedef struct
+{
+    FsFile* file;
+    PFdword fill;
+    PFdword pos;
+    PFbyte data[PNT_READ_SIZE];
+}PntReader;
+
+/* Target of pntLoadImage() */
+typedef struct
+{
+    PFword* next;
+    PFword* end;
+}PntBufferWriter;
+
+static PFbyte pntFindIndex(PntEncoder* encoder, PFword color)
+{
+    PFbyte index;
+
+    if (encoder->header.palette[encoder->lastIndex] == color)
+    {
+        return encoder->lastIndex;
+    }
+    for (index = 0; index < encoder->header.paletteSize; index++)
+    {
+        if (encoder->header.palette[index] == color)
+        {
+            encoder->lastIndex = index;
+            return index;
+        }
+    }
+    return 0xFF;
+}
+
+static PFEnStatus pntFlush(PntEncoder* encoder)
+{
+    PFEnStatus status;
+    PFdword written = 0;
+
+    if (encoder->outFill == 0)
+    {
+        return enStatusSuccess;
+    }
+    status = fsFileWrite(encoder->file, encoder->out, encoder->outFill, &written);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    if (written != encoder->outFill)
+    {
+        return enStatusError;
+    }
+    encoder->outFill = 0;
+    return enStatusSuccess;
+}
+
+/* Appends a run or literal packet of count pixels to the output buffer */
+static PFEnStatus pntEmit(PntEncoder* encoder, const PFword* pixels, PFword count, PFEnBoolean run)
+{
+    PFEnStatus status;
+    PFbyte* out;
+    PFbyte index;
+    PFword pos;
+
+    if (encoder->outFill + PNT_MAX_PACKET_BYTES > PNT_BUFFER_SIZE)
+    {
+        status = pntFlush(encoder);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+    }
+
+    out = &encoder->out[encoder->outFill];
+    *out++ = (PFbyte)((count - 1) | (run ? PNT_RUN_FLAG : 0));
+
+    if (encoder->header.format == enPntRle565)
+    {
+        for (pos = 0; pos < (run ? 1 : count); pos++)
+        {
+            *out++ = (PFbyte)pixels[pos];
+            *out++ = (PFbyte)(pixels[pos] >> 8);
+        }
+    }
+    else if (run)
+    {
+        index = pntFindIndex(encoder, pixels[0]);
+        if (index == 0xFF)
+        {
+            return enStatusInvArgs;
+        }
+        *out++ = index;
+    }
+    else
+    {
+        for (pos = 0; pos < count; pos++)
+        {
+            index = pntFindIndex(encoder, pixels[pos]);
+            if (index == 0xFF)
+            {
+                return enStatusInvArgs;
+            }
+            if ((pos & 1) == 0)
+            {
+                *out = (PFbyte)(index << 4);
+            }
+            else
+            {
+                *out++ |= index;
+            }
+        }
+        if ((count & 1) != 0)
+        {
+            out++;
+        }
+    }
+
+    encoder->outFill = (PFword)(out - encoder->out);
+    return enStatusSuccess;
+}
+
+static PFEnStatus pntEncodeRow(PntEncoder* encoder, const PFword* pixels)
+{
+    PFEnStatus status;
+    PFword width = encoder->header.width;
+    PFword pos = 0, start, count;
+
+    while (pos < width)
+    {
+        count = 1;
+        while (pos + count < width && count < PNT_MAX_PACKET && pixels[pos + count] == pixels[pos])
+        {
+            count++;
+        }
+        if (count > 1)
+        {
+            status = pntEmit(encoder, &pixels[pos], count, enBooleanTrue);
+            pos += count;
+        }
+        else
+        {
+            // Literal up to the start of the next run
+            start = pos;
+            count = 0;
+            while (pos < width && count < PNT_MAX_PACKET)
+            {
+                if (pos + 1 < width && pixels[pos + 1] == pixels[pos])
+                {
+                    break;
+                }
+                pos++;
+                count++;
+            }
+            status = pntEmit(encoder, &pixels[start], count, enBooleanFalse);
+        }
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pntBuildPalette(const PFword* pixels, PFdword count, PFword* palette, PFbyte* paletteSize)
+{
+    PFdword pos;
+    PFbyte index;
+    PFword last = 0;
+
+    if (pixels == NULL || palette == NULL || paletteSize == NULL || *paletteSize > PNT_MAX_PALETTE)
+    {
+        return enStatusInvArgs;
+    }
+
+    for (pos = 0; pos < count; pos++)
+    {
+        if (pos != 0 && pixels[pos] == last)
+        {
+            continue;
+        }
+        last = pixels[pos];
+        for (index = 0; index < *paletteSize; index++)
+        {
+            if (palette[index] == last)
+            {
+                break;
+            }
+        }
+        if (index == *paletteSize)
+        {
+            if (*paletteSize == PNT_MAX_PALETTE)
+            {
+                return enStatusNoMem;
+            }
+            palette[(*paletteSize)++] = last;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pntEncodeStart(PntEncoder* encoder, FsFile* file, PFword width, PFword height, const PFword* palette, PFbyte paletteSize)
+{
+    PFbyte* out;
+    PFbyte index;
+
+    if (encoder == NULL || file == NULL || width == 0 || height == 0 ||
+        (palette != NULL && (paletteSize == 0 || paletteSize > PNT_MAX_PALETTE)))
+    {
+        return enStatusInvArgs;
+    }
+
+    encoder->file = file;
+    encoder->header.width = width;
+    encoder->header.height = height;
+    encoder->header.format = (palette != NULL) ? enPntPalette : enPntRle565;
+    encoder->header.paletteSize = (palette != NULL) ? paletteSize : 0;
+    encoder->rowsDone = 0;
+    encoder->lastIndex = 0;
+
+    out = encoder->out;
+    pfMemCopy(out, pntMagic, sizeof(pntMagic));
+    out += sizeof(pntMagic);
+    *out++ = (PFbyte)width;
+    *out++ = (PFbyte)(width >> 8);
+    *out++ = (PFbyte)height;
+    *out++ = (PFbyte)(height >> 8);
+    *out++ = (PFbyte)encoder->header.format;
+    *out++ = encoder->header.paletteSize;
+    *out++ = 0;
+    *out++ = 0;
+    for (index = 0; index < encoder->header.paletteSize; index++)
+    {
+        encoder->header.palette[index] = palette[index];
+        *out++ = (PFbyte)palette[index];
+        *out++ = (PFbyte)(palette[index] >> 8);
+    }
+    encoder->outFill = (PFword)(out - encoder->out);
+    return enStatusSuccess;
+}
+
+PFEnStatus pntEncodeRows(PntEncoder* encoder, const PFword* pixels, PFword rows)
+{
+    PFEnStatus status;
+
+    if (encoder == NULL || pixels == NULL || rows > encoder->header.height - encoder->rowsDone)
+    {
+        return enStatusInvArgs;
+    }
+
+    while (rows-- != 0)
+    {
+        status = pntEncodeRow(encoder, pixels);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        pixels += encoder->header.width;
+        encoder->rowsDone++;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pntEncodeFinish(PntEncoder* encoder)
+{
+    if (encoder == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (encoder->rowsDone != encoder->header.height)
+    {
+        return enStatusInvState;
+    }
+    return pntFlush(encoder);
+}
+
+static PFEnStatus pntRead(PntReader* reader, PFbyte* data, PFdword count)
+{
+    PFEnStatus status;
+
+    while (count-- != 0)
+    {
+        if (reader->pos == reader->fill)
+        {
+            status = fsFileRead(reader->file, reader->data, PNT_READ_SIZE, &reader->fill);
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            if (reader->fill == 0)
+            {
+                return enStatusError;
+            }
+            reader->pos = 0;
+        }
+        *data++ = reader->data[reader->pos++];
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pntReadHeader(FsFile* file, PntHeader* header)
+{
+    PFEnStatus status;
+    PFbyte data[PNT_HEADER_SIZE];
+    PFdword read = 0;
+    PFbyte index;
+
+    if (file == NULL || header == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileRead(file, data, PNT_HEADER_SIZE, &read);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    if (read != PNT_HEADER_SIZE || pfMemCompare(data, pntMagic, sizeof(pntMagic)) != enBooleanTrue)
+    {
+        return enStatusNotSupported;
+    }
+
+    header->width = (PFword)(data[4] | (data[5] << 8));
+    header->height = (PFword)(data[6] | (data[7] << 8));
+    header->format = (PntFormat)data[8];
+    header->paletteSize = data[9];
+    if (header->width == 0 || header->height == 0 || header->format > enPntPalette ||
+        (header->format == enPntPalette && (header->paletteSize == 0 || header->paletteSize > PNT_MAX_PALETTE)) ||
+        (header->format == enPntRle565 && header->paletteSize != 0))
+    {
+        return enStatusNotSupported;
+    }
+
+    for (index = 0; index < header->paletteSize; index++)
+    {
+        status = fsFileRead(file, data, 2, &read);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        if (read != 2)
+        {
+            return enStatusError;
+        }
+        header->palette[index] = (PFword)(data[0] | (data[1] << 8));
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pntDecode(FsFile* file, PntHeader* header, PntSpanWriter writer, void* context)
+{
+    PFEnStatus status;
+    PntReader reader;
+    PFbyte data[2];
+    PFword row, remain, count, pos;
+    PFword color;
+
+    if (file == NULL || header == NULL || writer == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    reader.file = file;
+    reader.fill = 0;
+    reader.pos = 0;
+
+    for (row = 0; row < header->height; row++)
+    {
+        remain = header->width;
+        while (remain != 0)
+        {
+            status = pntRead(&reader, data, 1);
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            count = (data[0] & ~PNT_RUN_FLAG) + 1;
+            if (count > remain)
+            {
+                return enStatusError;
+            }
+            remain -= count;
+
+            if ((data[0] & PNT_RUN_FLAG) != 0)
+            {
+                status = pntRead(&reader, data, (header->format == enPntRle565) ? 2 : 1);
+                if (status != enStatusSuccess)
+                {
+                    return status;
+                }
+                if (header->format == enPntRle565)
+                {
+                    color = (PFword)(data[0] | (data[1] << 8));
+                }
+                else if (data[0] < header->paletteSize)
+                {
+                    color = header->palette[data[0]];
+                }
+                else
+                {
+                    return enStatusError;
+                }
+                status = writer(context, color, count);
+                if (status != enStatusSuccess)
+                {
+                    return status;
+                }
+                continue;
+            }
+
+            for (pos = 0; pos < count; pos++)
+            {
+                if (header->format == enPntRle565)
+                {
+                    status = pntRead(&reader, data, 2);
+                    color = (PFword)(data[0] | (data[1] << 8));
+                }
+                else
+                {
+                    // Two indices per byte, high nibble first
+                    if ((pos & 1) == 0)
+                    {
+                        status = pntRead(&reader, data, 1);
+                    }
+                    data[1] = ((pos & 1) == 0) ? (data[0] >> 4) : (data[0] & 0x0F);
+                    if (data[1] >= header->paletteSize)
+                    {
+                        return enStatusError;
+                    }
+                    color = header->palette[data[1]];
+                }
+                if (status != enStatusSuccess)
+                {
+                    return status;
+                }
+                status = writer(context, color, 1);
+                if (status != enStatusSuccess)
+                {
+                    return status;
+                }
+            }
+        }
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus pntLcdWriter(void* context, PFword color, PFword length)
+{
+    (void)context;
+    while (length-- != 0)
+    {
+        gfxWriteData(color);
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus pntBufferWriter(void* context, PFword color, PFword length)
+{
+    PntBufferWriter* target = (PntBufferWriter*)context;
+
+    if (length > target->end - target->next)
+    {
+        return enStatusNoMem;
+    }
+    while (length-- != 0)
+    {
+        *target->next++ = color;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pntSaveImage(PFword x, PFword y, PFword width, PFword height, const PFchar* fileName,
+                        PntEncoder* encoder, PFword* band, PFdword bandSize)
+{
+    PFEnStatus status;
+    FsFile file;
+    PFword palette[PNT_MAX_PALETTE];
+    PFbyte paletteSize = 0;
+    PFword rows, row;
+
+    if (fileName == NULL || encoder == NULL || band == NULL || width == 0 || height == 0 || bandSize < width)
+    {
+        return enStatusInvArgs;
+    }
+    rows = (bandSize / width < height) ? (PFword)(bandSize / width) : height;
+
+    // First pass to find out whether the area fits in a palette
+    for (row = 0; row < height; row += rows)
+    {
+        if (rows > height - row)
+        {
+            rows = height - row;
+        }
+        readBackground(x, y + row, width - 1, rows - 1, band, (PFword)bandSize);
+        if (pntBuildPalette(band, (PFdword)width * rows, palette, &paletteSize) != enStatusSuccess)
+        {
+            paletteSize = 0;
+            break;
+        }
+    }
+
+    status = fsFileOpen(&file, fileName, FA_CREATE_ALWAYS | FA_WRITE);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    status = pntEncodeStart(encoder, &file, width, height, (paletteSize != 0) ? palette : NULL, paletteSize);
+    rows = (bandSize / width < height) ? (PFword)(bandSize / width) : height;
+    for (row = 0; row < height && status == enStatusSuccess; row += rows)
+    {
+        if (rows > height - row)
+        {
+            rows = height - row;
+        }
+        readBackground(x, y + row, width - 1, rows - 1, band, (PFword)bandSize);
+        status = pntEncodeRows(encoder, band, rows);
+    }
+    if (status == enStatusSuccess)
+    {
+        status = pntEncodeFinish(encoder);
+    }
+
+    if (status != enStatusSuccess)
+    {
+        fsFileClose(&file);
+        fsFileDelete(fileName);
+        return status;
+    }
+    return fsFileClose(&file);
+}
+
+PFEnStatus pntDrawImage(const PFchar* fileName, PFword x, PFword y)
+{
+    PFEnStatus status;
+    FsFile file;
+    PntHeader header;
+
+    if (fileName == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileOpen(&file, fileName, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = pntReadHeader(&file, &header);
+    if (status == enStatusSuccess)
+    {
+        // Rows are decoded top row first, the order in which the LCD fills a window
+        gfxSetWindow(x, y, x + header.width - 1, y + header.height - 1);
+        gfxSetCursor(x, y);
+        gfxWriteCmd(PNT_LCD_GRAM_WRITE);
+        status = pntDecode(&file, &header, pntLcdWriter, NULL);
+        gfxSetAreaMax();
+    }
+    fsFileClose(&file);
+    return status;
+}
+
+PFEnStatus pntLoadImage(const PFchar* fileName, PFword* buffer, PFdword* size)
+{
+    PFEnStatus status;
+    FsFile file;
+    PntHeader header;
+    PntBufferWriter target;
+
+    if (fileName == NULL || buffer == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileOpen(&file, fileName, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = pntReadHeader(&file, &header);
+    if (status == enStatusSuccess)
+    {
+        target.next = buffer;
+        target.end = buffer + (PFdword)header.width * header.height;
+        status = pntDecode(&file, &header, pntBufferWriter, &target);
+        if (status == enStatusSuccess && size != NULL)
+        {
+            *size = (PFdword)(target.next - buffer) * sizeof(PFword);
+        }
+    }
+    fsFileClose(&file);
+    return status;
+}
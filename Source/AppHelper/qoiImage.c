@@ -0,0 +1,519 @@
+/**
+ *  \file       qoiImage.c
+ *  \brief      Streaming encoder and decoder for images in the QOI format.
+ *
+ *  The chunk layout follows the QOI specification 1.0. Pixels are kept as RGBA packed into a
+ *  PFdword, red in the lowest byte.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "qoiImage.h"
+
+#define QOI_OP_INDEX                0x00
+#define QOI_OP_DIFF                 0x40
+#define QOI_OP_LUMA                 0x80
+#define QOI_OP_RUN                  0xC0
+#define QOI_OP_RGB                  0xFE
+#define QOI_OP_RGBA                 0xFF
+#define QOI_MASK_2                  0xC0
+#define QOI_MAX_RUN                 62
+#define QOI_MAX_CHUNK               5
+#define QOI_START_PIXEL             0xFF000000
+#define QOI_LCD_GRAM_WRITE          0x22    /* GRAM write register of the LCD controller */
+
+#define QOI_RED(px)                 ((PFbyte)(px))
+#define QOI_GREEN(px)               ((PFbyte)((px) >> 8))
+#define QOI_BLUE(px)                ((PFbyte)((px) >> 16))
+#define QOI_ALPHA(px)               ((PFbyte)((px) >> 24))
+#define QOI_HASH(px)                ((QOI_RED(px) * 3 + QOI_GREEN(px) * 5 + QOI_BLUE(px) * 7 + QOI_ALPHA(px) * 11) % QOI_INDEX_SIZE)
+#define QOI_RGBA(r, g, b, a)        ((PFdword)(PFbyte)(r) | ((PFdword)(PFbyte)(g) << 8) | ((PFdword)(PFbyte)(b) << 16) | ((PFdword)(PFbyte)(a) << 24))
+
+static const PFbyte qoiMagic[4] = {'q', 'o', 'i', 'f'};
+
+/* Buffered reader used by the decoder */
+typedef struct
+{
+    FsFile* file;
+    PFdword fill;
+    PFdword pos;
+    PFbyte data[QOI_READ_SIZE];
+}QoiReader;
+
+/* Target of qoiLoadImage() */
+typedef struct
+{
+    PFword* next;
+    PFword* end;
+}QoiBufferWriter;
+
+static PFdword qoiFromRgb565(PFword color)
+{
+    PFbyte red = (PFbyte)(color >> 11), green = (PFbyte)((color >> 5) & 0x3F), blue = (PFbyte)(color & 0x1F);
+
+    return QOI_RGBA((red << 3) | (red >> 2), (green << 2) | (green >> 4), (blue << 3) | (blue >> 2), 0xFF);
+}
+
+static PFword qoiToRgb565(PFdword px)
+{
+    return (PFword)(((PFword)(QOI_RED(px) >> 3) << 11) | ((PFword)(QOI_GREEN(px) >> 2) << 5) | (QOI_BLUE(px) >> 3));
+}
+
+static void qoiStore32(PFbyte* ptr, PFdword value)
+{
+    ptr[0] = (PFbyte)(value >> 24);
+    ptr[1] = (PFbyte)(value >> 16);
+    ptr[2] = (PFbyte)(value >> 8);
+    ptr[3] = (PFbyte)value;
+}
+
+static PFEnStatus qoiFlush(QoiEncoder* encoder)
+{
+    PFEnStatus status;
+    PFdword written = 0;
+
+    if (encoder->outFill == 0)
+    {
+        return enStatusSuccess;
+    }
+    status = fsFileWrite(encoder->file, encoder->out, encoder->outFill, &written);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    if (written != encoder->outFill)
+    {
+        return enStatusError;
+    }
+    encoder->outFill = 0;
+    return enStatusSuccess;
+}
+
+PFEnStatus qoiEncodeStart(QoiEncoder* encoder, FsFile* file, PFword width, PFword height)
+{
+    PFbyte* out;
+
+    if (encoder == NULL || file == NULL || width == 0 || height == 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    encoder->file = file;
+    encoder->header.width = width;
+    encoder->header.height = height;
+    encoder->header.channels = 3;
+    encoder->pixelsLeft = (PFdword)width * height;
+    encoder->previous = QOI_START_PIXEL;
+    encoder->run = 0;
+    pfMemSet(encoder->index, 0, sizeof(encoder->index));
+
+    out = encoder->out;
+    pfMemCopy(out, qoiMagic, sizeof(qoiMagic));
+    qoiStore32(&out[4], width);
+    qoiStore32(&out[8], height);
+    out[12] = encoder->header.channels;
+    out[13] = 0;
+    encoder->outFill = QOI_HEADER_SIZE;
+    return enStatusSuccess;
+}
+
+PFEnStatus qoiEncodePixels(QoiEncoder* encoder, const PFword* pixels, PFdword count)
+{
+    PFEnStatus status;
+    PFbyte* out;
+    PFdword px, previous;
+    PFbyte hash;
+    PFchar dr, dg, db, dgr, dgb;
+
+    if (encoder == NULL || pixels == NULL || count > encoder->pixelsLeft)
+    {
+        return enStatusInvArgs;
+    }
+
+    previous = encoder->previous;
+    while (count-- != 0)
+    {
+        if (encoder->outFill + QOI_MAX_CHUNK > QOI_BUFFER_SIZE)
+        {
+            status = qoiFlush(encoder);
+            if (status != enStatusSuccess)
+            {
+                encoder->previous = previous;
+                return status;
+            }
+        }
+        out = &encoder->out[encoder->outFill];
+
+        px = qoiFromRgb565(*pixels++);
+        encoder->pixelsLeft--;
+        if (px == previous)
+        {
+            encoder->run++;
+            if (encoder->run == QOI_MAX_RUN || encoder->pixelsLeft == 0)
+            {
+                *out++ = QOI_OP_RUN | (encoder->run - 1);
+                encoder->run = 0;
+            }
+            encoder->outFill = (PFword)(out - encoder->out);
+            continue;
+        }
+
+        if (encoder->run != 0)
+        {
+            *out++ = QOI_OP_RUN | (encoder->run - 1);
+            encoder->run = 0;
+        }
+
+        hash = QOI_HASH(px);
+        if (encoder->index[hash] == px)
+        {
+            *out++ = QOI_OP_INDEX | hash;
+        }
+        else
+        {
+            encoder->index[hash] = px;
+
+            // Alpha is always opaque, so only the color channels are compared
+            dr = (PFchar)(QOI_RED(px) - QOI_RED(previous));
+            dg = (PFchar)(QOI_GREEN(px) - QOI_GREEN(previous));
+            db = (PFchar)(QOI_BLUE(px) - QOI_BLUE(previous));
+            dgr = (PFchar)(dr - dg);
+            dgb = (PFchar)(db - dg);
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+            {
+                *out++ = QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+            }
+            else if (dgr >= -8 && dgr <= 7 && dg >= -32 && dg <= 31 && dgb >= -8 && dgb <= 7)
+            {
+                *out++ = QOI_OP_LUMA | (dg + 32);
+                *out++ = (PFbyte)(((dgr + 8) << 4) | (dgb + 8));
+            }
+            else
+            {
+                *out++ = QOI_OP_RGB;
+                *out++ = QOI_RED(px);
+                *out++ = QOI_GREEN(px);
+                *out++ = QOI_BLUE(px);
+            }
+        }
+        previous = px;
+        encoder->outFill = (PFword)(out - encoder->out);
+    }
+
+    encoder->previous = previous;
+    return enStatusSuccess;
+}
+
+PFEnStatus qoiEncodeFinish(QoiEncoder* encoder)
+{
+    PFEnStatus status;
+
+    if (encoder == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (encoder->pixelsLeft != 0)
+    {
+        return enStatusInvState;
+    }
+
+    if (encoder->outFill + QOI_END_MARKER_SIZE > QOI_BUFFER_SIZE)
+    {
+        status = qoiFlush(encoder);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+    }
+    pfMemSet(&encoder->out[encoder->outFill], 0, QOI_END_MARKER_SIZE - 1);
+    encoder->out[encoder->outFill + QOI_END_MARKER_SIZE - 1] = 1;
+    encoder->outFill += QOI_END_MARKER_SIZE;
+    return qoiFlush(encoder);
+}
+
+static PFEnStatus qoiRead(QoiReader* reader, PFbyte* data, PFdword count)
+{
+    PFEnStatus status;
+
+    while (count-- != 0)
+    {
+        if (reader->pos == reader->fill)
+        {
+            status = fsFileRead(reader->file, reader->data, QOI_READ_SIZE, &reader->fill);
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            if (reader->fill == 0)
+            {
+                return enStatusError;
+            }
+            reader->pos = 0;
+        }
+        *data++ = reader->data[reader->pos++];
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus qoiReadHeader(FsFile* file, QoiHeader* header)
+{
+    PFEnStatus status;
+    PFbyte data[QOI_HEADER_SIZE];
+    PFdword read = 0;
+
+    if (file == NULL || header == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileRead(file, data, QOI_HEADER_SIZE, &read);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    if (read != QOI_HEADER_SIZE || pfMemCompare(data, qoiMagic, sizeof(qoiMagic)) != enBooleanTrue)
+    {
+        return enStatusNotSupported;
+    }
+
+    // Width and height are big endian 32 bit values
+    if (data[4] != 0 || data[5] != 0 || data[8] != 0 || data[9] != 0 || (data[12] != 3 && data[12] != 4))
+    {
+        return enStatusNotSupported;
+    }
+    header->width = (PFword)((data[6] << 8) | data[7]);
+    header->height = (PFword)((data[10] << 8) | data[11]);
+    header->channels = data[12];
+    if (header->width == 0 || header->height == 0)
+    {
+        return enStatusNotSupported;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus qoiDecode(FsFile* file, QoiHeader* header, QoiSpanWriter writer, void* context)
+{
+    PFEnStatus status;
+    QoiReader reader;
+    PFdword index[QOI_INDEX_SIZE];
+    PFdword px = QOI_START_PIXEL, left, run;
+    PFbyte data[4];
+    PFbyte vg;
+
+    if (file == NULL || header == NULL || writer == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    reader.file = file;
+    reader.fill = 0;
+    reader.pos = 0;
+    pfMemSet(index, 0, sizeof(index));
+    left = (PFdword)header->width * header->height;
+
+    while (left != 0)
+    {
+        status = qoiRead(&reader, data, 1);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+
+        if (data[0] == QOI_OP_RGB)
+        {
+            status = qoiRead(&reader, data, 3);
+            px = QOI_RGBA(data[0], data[1], data[2], QOI_ALPHA(px));
+        }
+        else if (data[0] == QOI_OP_RGBA)
+        {
+            status = qoiRead(&reader, data, 4);
+            px = QOI_RGBA(data[0], data[1], data[2], data[3]);
+        }
+        else if ((data[0] & QOI_MASK_2) == QOI_OP_INDEX)
+        {
+            px = index[data[0]];
+        }
+        else if ((data[0] & QOI_MASK_2) == QOI_OP_DIFF)
+        {
+            px = QOI_RGBA(QOI_RED(px) + ((data[0] >> 4) & 0x03) - 2, QOI_GREEN(px) + ((data[0] >> 2) & 0x03) - 2,
+                          QOI_BLUE(px) + (data[0] & 0x03) - 2, QOI_ALPHA(px));
+        }
+        else if ((data[0] & QOI_MASK_2) == QOI_OP_LUMA)
+        {
+            vg = (data[0] & 0x3F) - 32;
+            status = qoiRead(&reader, &data[1], 1);
+            px = QOI_RGBA(QOI_RED(px) + vg - 8 + ((data[1] >> 4) & 0x0F), QOI_GREEN(px) + vg,
+                          QOI_BLUE(px) + vg - 8 + (data[1] & 0x0F), QOI_ALPHA(px));
+        }
+        else
+        {
+            // A run repeats the previous pixel, which is already in the index
+            run = (data[0] & 0x3F) + 1;
+            if (run > left)
+            {
+                return enStatusError;
+            }
+            status = writer(context, qoiToRgb565(px), (PFword)run);
+            if (status != enStatusSuccess)
+            {
+                return status;
+            }
+            left -= run;
+            continue;
+        }
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+
+        index[QOI_HASH(px)] = px;
+        status = writer(context, qoiToRgb565(px), 1);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        left--;
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus qoiLcdWriter(void* context, PFword color, PFword length)
+{
+    (void)context;
+    while (length-- != 0)
+    {
+        gfxWriteData(color);
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus qoiBufferWriter(void* context, PFword color, PFword length)
+{
+    QoiBufferWriter* target = (QoiBufferWriter*)context;
+
+    if (length > target->end - target->next)
+    {
+        return enStatusNoMem;
+    }
+    while (length-- != 0)
+    {
+        *target->next++ = color;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus qoiSaveImage(PFword x, PFword y, PFword width, PFword height, const PFchar* fileName,
+                        QoiEncoder* encoder, PFword* band, PFdword bandSize)
+{
+    PFEnStatus status;
+    FsFile file;
+    PFword rows, row;
+
+    if (fileName == NULL || encoder == NULL || band == NULL || width == 0 || height == 0 || bandSize < width)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileOpen(&file, fileName, FA_CREATE_ALWAYS | FA_WRITE);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    status = qoiEncodeStart(encoder, &file, width, height);
+    rows = (bandSize / width < height) ? (PFword)(bandSize / width) : height;
+    for (row = 0; row < height && status == enStatusSuccess; row += rows)
+    {
+        if (rows > height - row)
+        {
+            rows = height - row;
+        }
+        readBackground(x, y + row, width - 1, rows - 1, band, (PFword)bandSize);
+        status = qoiEncodePixels(encoder, band, (PFdword)width * rows);
+    }
+    if (status == enStatusSuccess)
+    {
+        status = qoiEncodeFinish(encoder);
+    }
+
+    if (status != enStatusSuccess)
+    {
+        fsFileClose(&file);
+        fsFileDelete(fileName);
+        return status;
+    }
+    return fsFileClose(&file);
+}
+
+PFEnStatus qoiDrawImage(const PFchar* fileName, PFword x, PFword y)
+{
+    PFEnStatus status;
+    FsFile file;
+    QoiHeader header;
+
+    if (fileName == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileOpen(&file, fileName, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = qoiReadHeader(&file, &header);
+    if (status == enStatusSuccess)
+    {
+        gfxSetWindow(x, y, x + header.width - 1, y + header.height - 1);
+        gfxSetCursor(x, y);
+        gfxWriteCmd(QOI_LCD_GRAM_WRITE);
+        status = qoiDecode(&file, &header, qoiLcdWriter, NULL);
+        gfxSetAreaMax();
+    }
+    fsFileClose(&file);
+    return status;
+}
+
+PFEnStatus qoiLoadImage(const PFchar* fileName, PFword* buffer, PFdword* size)
+{
+    PFEnStatus status;
+    FsFile file;
+    QoiHeader header;
+    QoiBufferWriter target;
+
+    if (fileName == NULL || buffer == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileOpen(&file, fileName, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = qoiReadHeader(&file, &header);
+    if (status == enStatusSuccess)
+    {
+        target.next = buffer;
+        target.end = buffer + (PFdword)header.width * header.height;
+        status = qoiDecode(&file, &header, qoiBufferWriter, &target);
+        if (status == enStatusSuccess && size != NULL)
+        {
+            *size = (PFdword)(target.next - buffer) * sizeof(PFword);
+        }
+    }
+    fsFileClose(&file);
+    return status;
+}
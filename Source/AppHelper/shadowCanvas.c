@@ -0,0 +1,415 @@
+/**
+ *  \file       shadowCanvas.c
+ *  \brief      Indexed color copy of the drawing area kept in RAM alongside the LCD.
+ *
+ *  The rasterizers follow the graphics library pixel for pixel: gfxDrawLine() fills horizontal and
+ *  vertical lines as a rectangle widened by the pen size and stamps a pen size square at each
+ *  Bresenham step otherwise, gfxDrawCircle() stamps the same square along a midpoint circle and
+ *  gfxDrawRectangle() is four lines. Pixels outside the canvas are not stored.
+ *  Pixels are packed into bytes starting from the least significant bits.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "shadowCanvas.h"
+
+#define SHADOW_LCD_GRAM_WRITE       0x22    /* GRAM write register of the LCD controller */
+#define SHADOW_PIXELS_PER_BYTE      (8 / SHADOW_BITS_PER_PIXEL)
+#define SHADOW_INDEX_MASK           ((1 << SHADOW_BITS_PER_PIXEL) - 1)
+#define SHADOW_FILL_PATTERN         ((SHADOW_BITS_PER_PIXEL == 2) ? 0x55 : 0x11)    /* Index 1 in every pixel of a byte */
+
+static PFbyte shadowRam1[SHADOW_RAM1_ROWS * SHADOW_ROW_SIZE];
+static PFbyte shadowRam2[(SHADOW_HEIGHT - SHADOW_RAM1_ROWS) * SHADOW_ROW_SIZE] PF_AHB_NOINIT;
+static pCfgShadow shadowConfig = NULL;
+static PFEnBoolean shadowValid = enBooleanFalse;
+
+static PFbyte* shadowRow(PFword y)
+{
+    if (y < SHADOW_RAM1_ROWS)
+    {
+        return &shadowRam1[(PFdword)y * SHADOW_ROW_SIZE];
+    }
+    return &shadowRam2[(PFdword)(y - SHADOW_RAM1_ROWS) * SHADOW_ROW_SIZE];
+}
+
+static PFbyte shadowGet(PFword x, PFword y)
+{
+    return (shadowRow(y)[x / SHADOW_PIXELS_PER_BYTE] >> ((x % SHADOW_PIXELS_PER_BYTE) * SHADOW_BITS_PER_PIXEL)) &
+           SHADOW_INDEX_MASK;
+}
+
+/* Stores a pixel given in LCD coordinates, pixels outside the canvas are dropped */
+static void shadowPlot(PFword x, PFword y, PFbyte index)
+{
+    PFbyte* data;
+    PFbyte shift;
+
+    if (x < shadowConfig->x || y < shadowConfig->y)
+    {
+        return;
+    }
+    x -= shadowConfig->x;
+    y -= shadowConfig->y;
+    if (x >= SHADOW_WIDTH || y >= SHADOW_HEIGHT)
+    {
+        return;
+    }
+
+    data = &shadowRow(y)[x / SHADOW_PIXELS_PER_BYTE];
+    shift = (x % SHADOW_PIXELS_PER_BYTE) * SHADOW_BITS_PER_PIXEL;
+    *data = (PFbyte)((*data & ~(SHADOW_INDEX_MASK << shift)) | (index << shift));
+}
+
+/* Fills a rectangle given in LCD coordinates, whole bytes of a row are set at once. It runs from RAM
+   as every stroke goes through it */
+PF_RAMFUNC static void shadowFillRect(PFword x1, PFword y1, PFword x2, PFword y2, PFbyte index)
+{
+    PFbyte* data;
+    PFword x, y, first, last;
+
+    x1 = (x1 > shadowConfig->x) ? x1 - shadowConfig->x : 0;
+    y1 = (y1 > shadowConfig->y) ? y1 - shadowConfig->y : 0;
+    if (x2 < shadowConfig->x || y2 < shadowConfig->y)
+    {
+        return;
+    }
+    x2 -= shadowConfig->x;
+    y2 -= shadowConfig->y;
+    if (x2 >= SHADOW_WIDTH)
+    {
+        x2 = SHADOW_WIDTH - 1;
+    }
+    if (y2 >= SHADOW_HEIGHT)
+    {
+        y2 = SHADOW_HEIGHT - 1;
+    }
+    if (x1 > x2 || y1 > y2)
+    {
+        return;
+    }
+
+    // Bytes completely inside the span
+    first = (x1 + SHADOW_PIXELS_PER_BYTE - 1) / SHADOW_PIXELS_PER_BYTE;
+    last = (x2 + 1) / SHADOW_PIXELS_PER_BYTE;
+
+    for (y = y1; y <= y2; y++)
+    {
+        data = shadowRow(y);
+        if (first < last)
+        {
+            pfMemSet(&data[first], SHADOW_FILL_PATTERN * index, last - first);
+            for (x = x1; x < first * SHADOW_PIXELS_PER_BYTE; x++)
+            {
+                shadowPlot(x + shadowConfig->x, y + shadowConfig->y, index);
+            }
+            for (x = last * SHADOW_PIXELS_PER_BYTE; x <= x2; x++)
+            {
+                shadowPlot(x + shadowConfig->x, y + shadowConfig->y, index);
+            }
+        }
+        else
+        {
+            for (x = x1; x <= x2; x++)
+            {
+                shadowPlot(x + shadowConfig->x, y + shadowConfig->y, index);
+            }
+        }
+    }
+}
+
+/* Palette index of a color, the canvas can no longer follow the LCD if it is not in the palette */
+static PFEnStatus shadowIndex(PFword color, PFbyte* index)
+{
+    PFbyte entry;
+
+    if (shadowConfig == NULL)
+    {
+        return enStatusNotConfigured;
+    }
+    for (entry = 0; entry < shadowConfig->paletteSize; entry++)
+    {
+        if (shadowConfig->palette[entry] == color)
+        {
+            *index = entry;
+            return enStatusSuccess;
+        }
+    }
+    shadowValid = enBooleanFalse;
+    return enStatusNotSupported;
+}
+
+/* Palette index of the current color and the current pen size */
+static PFEnStatus shadowPen(PFbyte* index, PFdword* size)
+{
+    PFword color = 0, penSize = 1;
+
+    gfxGetColor(&color);
+    gfxGetPenSize(&penSize);
+    *size = (penSize != 0) ? penSize : 1;
+    return shadowIndex(color, index);
+}
+
+/* Same square as gfxPixels() */
+static void shadowPixels(PFdword x, PFdword y, PFdword size, PFbyte index)
+{
+    PFdword offset = size - 1;
+    PFdword px, py;
+
+    for (px = x - offset / 2; px <= x + (offset - offset / 2); px++)
+    {
+        for (py = y - offset / 2; py <= y + (offset - offset / 2); py++)
+        {
+            shadowPlot((PFword)px, (PFword)py, index);
+        }
+    }
+}
+
+/* Same pixels as gfxDrawLine() */
+static void shadowLine(PFsdword x1, PFsdword y1, PFsdword x2, PFsdword y2, PFdword size, PFbyte index)
+{
+    PFdword offset = size - 1;
+    PFsdword dx, dy, sx, sy, err, e2;
+
+    if (x1 == x2)
+    {
+        shadowFillRect((PFword)(x1 - offset / 2), (PFword)(((PFdword)y2 < (PFdword)y1) ? y2 : y1),
+                       (PFword)(x2 + (offset - offset / 2)), (PFword)(((PFdword)y2 < (PFdword)y1) ? y1 : y2), index);
+        return;
+    }
+    if (y1 == y2)
+    {
+        shadowFillRect((PFword)(((PFdword)x2 < (PFdword)x1) ? x2 : x1), (PFword)(y1 - offset / 2),
+                       (PFword)(((PFdword)x2 < (PFdword)x1) ? x1 : x2), (PFword)(y2 + (offset - offset / 2)), index);
+        return;
+    }
+
+    dx = (x2 > x1) ? x2 - x1 : x1 - x2;
+    sx = (x1 < x2) ? 1 : -1;
+    dy = -((y2 > y1) ? y2 - y1 : y1 - y2);
+    sy = (y1 < y2) ? 1 : -1;
+    err = dx + dy;
+    for (;;)
+    {
+        shadowPixels(x1, y1, size, index);
+        if (x1 == x2 && y1 == y2)
+        {
+            break;
+        }
+        e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x1 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y1 += sy;
+        }
+    }
+}
+
+PFEnStatus shadowOpen(pCfgShadow config)
+{
+    if (config == NULL || config->palette == NULL || config->paletteSize == 0 ||
+        config->paletteSize > SHADOW_PALETTE_SIZE || config->background >= config->paletteSize)
+    {
+        return enStatusInvArgs;
+    }
+
+    shadowConfig = config;
+    shadowFillRect(config->x, config->y, config->x + SHADOW_WIDTH - 1, config->y + SHADOW_HEIGHT - 1, config->background);
+    shadowValid = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus shadowCapture(void)
+{
+    PFword row[SHADOW_WIDTH + 1];
+    PFword x, y;
+    PFbyte index;
+
+    if (shadowConfig == NULL)
+    {
+        return enStatusNotConfigured;
+    }
+
+    for (y = 0; y < SHADOW_HEIGHT; y++)
+    {
+        // Same readback call as saveImage(), one extra pixel for the dummy read
+        readBackground(shadowConfig->x + 1, shadowConfig->y + y, SHADOW_WIDTH, 0, row, SHADOW_WIDTH);
+        for (x = 0; x < SHADOW_WIDTH; x++)
+        {
+            if (shadowIndex(row[x], &index) != enStatusSuccess)
+            {
+                return enStatusInvState;
+            }
+            shadowPlot(shadowConfig->x + x, shadowConfig->y + y, index);
+        }
+    }
+    shadowValid = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus shadowFillArea(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color)
+{
+    PFEnStatus status;
+    PFbyte index;
+
+    status = gfxFillArea(xStart, yStart, xEnd, yEnd, color);
+    if (shadowIndex(color, &index) == enStatusSuccess)
+    {
+        shadowFillRect(xStart, yStart, xEnd, yEnd, index);
+        if (xStart <= shadowConfig->x && yStart <= shadowConfig->y &&
+            xEnd >= shadowConfig->x + SHADOW_WIDTH - 1 && yEnd >= shadowConfig->y + SHADOW_HEIGHT - 1)
+        {
+            shadowValid = enBooleanTrue;
+        }
+    }
+    return status;
+}
+
+PFEnStatus shadowDrawLine(PFsdword x1, PFsdword y1, PFsdword x2, PFsdword y2)
+{
+    PFEnStatus status;
+    PFdword size;
+    PFbyte index;
+
+    status = gfxDrawLine(x1, y1, x2, y2);
+    if (shadowPen(&index, &size) == enStatusSuccess)
+    {
+        shadowLine(x1, y1, x2, y2, size, index);
+    }
+    return status;
+}
+
+PFEnStatus shadowDrawRectangle(PFdword x1, PFdword y1, PFdword x2, PFdword y2)
+{
+    PFEnStatus status;
+    PFdword size;
+    PFbyte index;
+
+    status = gfxDrawRectangle(x1, y1, x2, y2);
+    if (shadowPen(&index, &size) == enStatusSuccess)
+    {
+        shadowLine(x1, y1, x2, y1, size, index);
+        shadowLine(x2, y1, x2, y2, size, index);
+        shadowLine(x1, y2, x2, y2, size, index);
+        shadowLine(x1, y1, x1, y2, size, index);
+    }
+    return status;
+}
+
+PFEnStatus shadowDrawCircle(PFsdword xc, PFsdword yc, PFsdword radius)
+{
+    PFEnStatus status;
+    PFdword size;
+    PFsdword x, y, err, step;
+    PFbyte index;
+
+    status = gfxDrawCircle(xc, yc, radius);
+    if (shadowPen(&index, &size) != enStatusSuccess)
+    {
+        return status;
+    }
+
+    x = -radius;
+    y = 0;
+    err = 2 - 2 * radius;
+    do
+    {
+        shadowPixels(xc - x, yc + y, size, index);
+        shadowPixels(xc - y, yc - x, size, index);
+        shadowPixels(xc + x, yc - y, size, index);
+        shadowPixels(xc + y, yc + x, size, index);
+        step = err;
+        if (step <= y)
+        {
+            y++;
+            err += y * 2 + 1;
+        }
+        if (step > x || err > y)
+        {
+            x++;
+            err += x * 2 + 1;
+        }
+    } while (x < 0);
+    return status;
+}
+
+PFEnStatus shadowReadPixels(PFword x, PFword y, PFword count, PFword* pixels)
+{
+    if (shadowConfig == NULL)
+    {
+        return enStatusNotConfigured;
+    }
+    if (pixels == NULL || x < shadowConfig->x || y < shadowConfig->y || x - shadowConfig->x + count > SHADOW_WIDTH ||
+        y - shadowConfig->y >= SHADOW_HEIGHT)
+    {
+        return enStatusInvArgs;
+    }
+    if (shadowValid != enBooleanTrue)
+    {
+        return enStatusInvState;
+    }
+
+    x -= shadowConfig->x;
+    y -= shadowConfig->y;
+    while (count-- != 0)
+    {
+        *pixels++ = shadowConfig->palette[shadowGet(x++, y)];
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus shadowRedraw(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd)
+{
+    PFword x, y;
+
+    if (shadowConfig == NULL)
+    {
+        return enStatusNotConfigured;
+    }
+    if (xStart < shadowConfig->x || yStart < shadowConfig->y || xStart > xEnd || yStart > yEnd ||
+        xEnd - shadowConfig->x >= SHADOW_WIDTH || yEnd - shadowConfig->y >= SHADOW_HEIGHT)
+    {
+        return enStatusInvArgs;
+    }
+    if (shadowValid != enBooleanTrue)
+    {
+        return enStatusInvState;
+    }
+
+    gfxSetWindow(xStart, yStart, xEnd, yEnd);
+    gfxSetCursor(xStart, yStart);
+    gfxWriteCmd(SHADOW_LCD_GRAM_WRITE);
+    for (y = yStart - shadowConfig->y; y <= yEnd - shadowConfig->y; y++)
+    {
+        for (x = xStart - shadowConfig->x; x <= xEnd - shadowConfig->x; x++)
+        {
+            gfxWriteData(shadowConfig->palette[shadowGet(x, y)]);
+        }
+    }
+    return gfxSetAreaMax();
+}
+
+PFEnStatus shadowInvalidate(void)
+{
+    shadowValid = enBooleanFalse;
+    return enStatusSuccess;
+}
+
+PFEnBoolean shadowIsValid(void)
+{
+    return (shadowConfig != NULL) ? shadowValid : enBooleanFalse;
+}
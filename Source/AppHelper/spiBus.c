@@ -0,0 +1,439 @@
+/**
+ *  \file       spiBus.c
+ *  \brief      SPI0 bus arbiter shared by the touch controller and the SD card.
+ *
+ *  The SPI0 driver already refuses to select a device while another one is selected. This layer adds:
+ *  1.  Device profiles: SSP0 CR0/CPSR are reprogrammed on every select so that each device runs
+ *      at its own clock rate and mode.
+ *  2.  A transaction queue: descriptors can be submitted from interrupt context and are executed when
+ *      the bus is released, from spiBusService(), or from spiBusYield() of the device holding the bus.
+ *  3.  Per device statistics measured in tick module ticks.
+ *  4.  Block transfers through the SPI0 DMA mode for the device holding the bus.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_gpio.h"
+#include "prime_spi0.h"
+#include "prime_spi0Dma.h"
+#include "spiBus.h"
+
+#define SPI_BUS_NO_OWNER            0xFF
+#define SPI_BUS_QUEUE_MASK          (SPI_BUS_QUEUE_SIZE - 1)
+
+#define SSP_CR0_FORMAT_MASK         0x3F    /* DSS and FRF fields, kept from pfSpi0Open() */
+#define SSP_CR0_MODE_SHIFT          6       /* CPOL and CPHA, same bit order as PFEnSpi0Mode */
+#define SSP_CR0_SCR_SHIFT           8
+#define SSP_SR_BSY                  0x10
+
+/** Register values applied while a device is selected */
+typedef struct
+{
+    PFdword cr0;                            /* CR0 bits above the frame format */
+    PFdword cpsr;
+    PFEnBoolean useProfile;
+    PFEnBoolean urgent;
+}SpiBusDevice;
+
+static pCfgSpiBus spiBusConfig = NULL;
+static SpiBusDevice spiBusDevice[SPI_BUS_MAX_DEVICES];
+static SpiBusStats spiBusStats[SPI_BUS_MAX_DEVICES];
+static PFdword spiBusDefaultCr0, spiBusDefaultCpsr;
+static volatile PFbyte spiBusOwner = SPI_BUS_NO_OWNER;
+static PFdword spiBusSelectTick;
+static SpiBusTransaction* spiBusQueue[SPI_BUS_QUEUE_SIZE];
+static volatile PFbyte spiBusQueueHead = 0, spiBusQueueTail = 0;
+static PFEnBoolean spiBusInService = enBooleanFalse;
+
+static PFdword spiBusNow(void)
+{
+    return pfTickSetTimeoutMs(0);
+}
+
+static void spiBusApplyProfile(PFbyte id)
+{
+    PFdword cr0 = spiBusDefaultCr0, cpsr = spiBusDefaultCpsr;
+
+    if (spiBusDevice[id].useProfile == enBooleanTrue)
+    {
+        cr0 = spiBusDevice[id].cr0;
+        cpsr = spiBusDevice[id].cpsr;
+    }
+
+    // Clock settings must not change in the middle of a frame
+    while ((SPI0_CHANNEL->SR & SSP_SR_BSY) != 0);
+    SPI0_CHANNEL->CR0 = (SPI0_CHANNEL->CR0 & SSP_CR0_FORMAT_MASK) | cr0;
+    SPI0_CHANNEL->CPSR = cpsr;
+}
+
+static PFEnStatus spiBusSelect(PFbyte* id)
+{
+    PFEnStatus status;
+
+    if (spiBusOwner != SPI_BUS_NO_OWNER && spiBusOwner != *id)
+    {
+        spiBusStats[*id].busyRejects++;
+        return enStatusBusy;
+    }
+
+    spiBusApplyProfile(*id);
+    status = pfSpi0ChipSelect(id, 0);
+    if (status == enStatusSuccess)
+    {
+        spiBusOwner = *id;
+        spiBusSelectTick = spiBusNow();
+        spiBusStats[*id].transactions++;
+    }
+    return status;
+}
+
+static PFEnStatus spiBusDeselect(PFbyte* id)
+{
+    PFEnStatus status;
+    PFdword hold;
+
+    status = pfSpi0ChipSelect(id, 1);
+    if (spiBusOwner == *id)
+    {
+        hold = spiBusNow() - spiBusSelectTick;
+        spiBusStats[*id].holdTicks += hold;
+        if (hold > spiBusStats[*id].maxHoldTicks)
+        {
+            spiBusStats[*id].maxHoldTicks = hold;
+        }
+        spiBusOwner = SPI_BUS_NO_OWNER;
+    }
+    return status;
+}
+
+static void spiBusExecute(SpiBusTransaction* transaction)
+{
+    PFbyte id = *transaction->id;
+    PFbyte rx;
+    PFdword wait, k;
+    PFEnStatus status;
+
+    wait = spiBusNow() - transaction->submitTick;
+    if (wait > spiBusStats[id].maxWaitTicks)
+    {
+        spiBusStats[id].maxWaitTicks = wait;
+    }
+
+    status = spiBusSelect(transaction->id);
+    if (status == enStatusSuccess)
+    {
+        for (k = 0; k < transaction->size && status == enStatusSuccess; k++)
+        {
+            status = pfSpi0ExchangeByte(transaction->id,
+                        (transaction->txData != NULL) ? transaction->txData[k] : 0xFF, &rx);
+            if (transaction->rxData != NULL)
+            {
+                transaction->rxData[k] = rx;
+            }
+        }
+        spiBusStats[id].bytes += k;
+        spiBusDeselect(transaction->id);
+    }
+
+    transaction->status = status;
+    transaction->done = enBooleanTrue;
+    if (transaction->callback != NULL)
+    {
+        transaction->callback(transaction);
+    }
+}
+
+/* Runs queued transactions, stops at the first one not allowed by urgentOnly */
+static void spiBusRunQueue(PFEnBoolean urgentOnly)
+{
+    SpiBusTransaction* transaction;
+
+    spiBusInService = enBooleanTrue;
+    while (spiBusQueueHead != spiBusQueueTail)
+    {
+        transaction = spiBusQueue[spiBusQueueHead];
+        if (urgentOnly == enBooleanTrue && spiBusDevice[*transaction->id].urgent != enBooleanTrue)
+        {
+            break;
+        }
+        spiBusQueueHead = (spiBusQueueHead + 1) & SPI_BUS_QUEUE_MASK;
+        spiBusExecute(transaction);
+    }
+    spiBusInService = enBooleanFalse;
+}
+
+PFEnStatus spiBusOpen(pCfgSpiBus config)
+{
+    PFbyte k;
+
+    if (config == NULL || (config->profileCount != 0 && config->profiles == NULL))
+    {
+        return enStatusInvArgs;
+    }
+
+    spiBusConfig = config;
+    spiBusDefaultCr0 = SPI0_CHANNEL->CR0 & ~SSP_CR0_FORMAT_MASK;
+    spiBusDefaultCpsr = SPI0_CHANNEL->CPSR;
+    spiBusOwner = SPI_BUS_NO_OWNER;
+    spiBusQueueHead = 0;
+    spiBusQueueTail = 0;
+    for (k = 0; k < SPI_BUS_MAX_DEVICES; k++)
+    {
+        spiBusDevice[k].useProfile = enBooleanFalse;
+        spiBusDevice[k].urgent = enBooleanFalse;
+    }
+
+    return enStatusSuccess;
+}
+
+PFEnStatus spiBusRegisterDevice(PFbyte* id, PFpGpioPortPin chipSelect)
+{
+    PFEnStatus status;
+    SpiBusProfile* profile;
+    PFdword pclk, div, cpsr, scr;
+    PFbyte k;
+
+    if (spiBusConfig == NULL)
+    {
+        return enStatusNotConfigured;
+    }
+
+    status = pfSpi0RegisterDevice(id, chipSelect);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    spiBusDevice[*id].useProfile = enBooleanFalse;
+    spiBusDevice[*id].urgent = enBooleanFalse;
+    pfMemSet(&spiBusStats[*id], 0, sizeof(SpiBusStats));
+
+    for (k = 0; k < spiBusConfig->profileCount; k++)
+    {
+        profile = &spiBusConfig->profiles[k];
+        if (profile->chipSelect.port != chipSelect->port || profile->chipSelect.pin != chipSelect->pin)
+        {
+            continue;
+        }
+
+        // SSP clock = PCLK / (CPSR * (SCR + 1)), CPSR even in 2..254, rounded so the rate does not exceed the profile
+        pclk = pfSysGetPclk(PCLK_DIV_SSP0);
+        div = (pclk + profile->baudrate - 1) / profile->baudrate;
+        scr = 256;
+        for (cpsr = 2; cpsr <= 254; cpsr += 2)
+        {
+            scr = (div + cpsr - 1) / cpsr;
+            if (scr <= 256)
+            {
+                break;
+            }
+        }
+        if (cpsr > 254)
+        {
+            cpsr = 254;
+            scr = 256;
+        }
+        if (scr == 0)
+        {
+            scr = 1;
+        }
+
+        spiBusDevice[*id].cr0 = ((PFdword)profile->mode << SSP_CR0_MODE_SHIFT) | ((scr - 1) << SSP_CR0_SCR_SHIFT);
+        spiBusDevice[*id].cpsr = cpsr;
+        spiBusDevice[*id].useProfile = enBooleanTrue;
+        spiBusDevice[*id].urgent = profile->urgent;
+        break;
+    }
+
+    return enStatusSuccess;
+}
+
+PFEnStatus spiBusUnregisterDevice(PFbyte* id)
+{
+    if (id == NULL || *id >= SPI_BUS_MAX_DEVICES)
+    {
+        return enStatusInvArgs;
+    }
+
+    spiBusDevice[*id].useProfile = enBooleanFalse;
+    spiBusDevice[*id].urgent = enBooleanFalse;
+    return pfSpi0UnregisterDevice(id);
+}
+
+PFEnStatus spiBusChipSelect(PFbyte* id, PFbyte pinStatus)
+{
+    PFEnStatus status;
+
+    if (id == NULL || *id >= SPI_BUS_MAX_DEVICES)
+    {
+        return enStatusInvArgs;
+    }
+
+    if (pinStatus == 0)
+    {
+        return spiBusSelect(id);
+    }
+
+    status = spiBusDeselect(id);
+    if (spiBusInService != enBooleanTrue && __get_IPSR() == 0)
+    {
+        spiBusRunQueue(enBooleanFalse);
+    }
+    return status;
+}
+
+PFEnStatus spiBusExchangeByte(PFbyte* id, PFbyte data, PFbyte* rxData)
+{
+    PFEnStatus status;
+
+    status = pfSpi0ExchangeByte(id, data, rxData);
+    if (status == enStatusSuccess)
+    {
+        spiBusStats[*id].bytes++;
+    }
+    return status;
+}
+
+PFEnStatus spiBusWrite(PFbyte* id, PFbyte* data, PFdword size, PFcallback delayCallback)
+{
+    PFEnStatus status;
+
+    status = pfSpi0Write(id, data, size, delayCallback);
+    if (status == enStatusSuccess)
+    {
+        spiBusStats[*id].bytes += size;
+    }
+    return status;
+}
+
+PFEnStatus spiBusRead(PFbyte* id, PFbyte* data, PFdword size, PFdword* readBytes, PFcallback delayCallback)
+{
+    PFEnStatus status;
+
+    status = pfSpi0Read(id, data, size, readBytes, delayCallback);
+    if (status == enStatusSuccess && readBytes != NULL)
+    {
+        spiBusStats[*id].bytes += *readBytes;
+    }
+    return status;
+}
+
+PFEnStatus spiBusDmaTransfer(PFbyte* id, PFbyte* txData, PFbyte* rxData, PFdword size)
+{
+    PFEnStatus status;
+
+    if (id == NULL || *id >= SPI_BUS_MAX_DEVICES)
+    {
+        return enStatusInvArgs;
+    }
+    if (spiBusOwner != *id)
+    {
+        return enStatusInvState;
+    }
+
+    status = pfSpi0DmaTransfer(txData, rxData, size, spiBusConfig->dmaWaitCallback);
+    if (status == enStatusSuccess)
+    {
+        spiBusStats[*id].bytes += size;
+    }
+    return status;
+}
+
+PFEnStatus spiBusSubmit(SpiBusTransaction* transaction)
+{
+    PFdword primask;
+    PFbyte next;
+
+    if (transaction == NULL || transaction->id == NULL || *transaction->id >= SPI_BUS_MAX_DEVICES)
+    {
+        return enStatusInvArgs;
+    }
+
+    transaction->done = enBooleanFalse;
+    transaction->status = enStatusBusy;
+    transaction->submitTick = spiBusNow();
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    next = (spiBusQueueTail + 1) & SPI_BUS_QUEUE_MASK;
+    if (next == spiBusQueueHead)
+    {
+        __set_PRIMASK(primask);
+        return enStatusNoMem;
+    }
+    spiBusQueue[spiBusQueueTail] = transaction;
+    spiBusQueueTail = next;
+    __set_PRIMASK(primask);
+
+    return enStatusSuccess;
+}
+
+PFEnStatus spiBusService(void)
+{
+    if (spiBusInService == enBooleanTrue || __get_IPSR() != 0)
+    {
+        return enStatusInvState;
+    }
+    if (spiBusOwner != SPI_BUS_NO_OWNER)
+    {
+        return enStatusBusy;
+    }
+
+    spiBusRunQueue(enBooleanFalse);
+    return enStatusSuccess;
+}
+
+PFEnStatus spiBusYield(PFbyte* id)
+{
+    PFEnStatus status;
+    PFdword selectTick;
+
+    if (id == NULL || *id >= SPI_BUS_MAX_DEVICES)
+    {
+        return enStatusInvArgs;
+    }
+    if (spiBusOwner != *id || spiBusInService == enBooleanTrue)
+    {
+        return enStatusInvState;
+    }
+    if (spiBusQueueHead == spiBusQueueTail ||
+        spiBusDevice[*spiBusQueue[spiBusQueueHead]->id].urgent != enBooleanTrue)
+    {
+        return enStatusSuccess;
+    }
+
+    // The interrupted transfer counts as one hold of the bus
+    selectTick = spiBusSelectTick;
+    pfSpi0ChipSelect(id, 1);
+    spiBusOwner = SPI_BUS_NO_OWNER;
+    spiBusStats[*id].preemptions++;
+
+    spiBusRunQueue(enBooleanTrue);
+
+    spiBusApplyProfile(*id);
+    status = pfSpi0ChipSelect(id, 0);
+    spiBusOwner = *id;
+    spiBusSelectTick = selectTick;
+
+    return status;
+}
+
+PFEnStatus spiBusGetStats(PFbyte* id, SpiBusStats* stats)
+{
+    if (id == NULL || *id >= SPI_BUS_MAX_DEVICES || stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    *stats = spiBusStats[*id];
+    return enStatusSuccess;
+}
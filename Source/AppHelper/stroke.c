@@ -0,0 +1,364 @@
+/**
+ *  \file       stroke.c
+ *  \brief      Stroke engine for freehand drawing.
+ *
+ *  Samples pass through three stages:
+ *  1.  Jitter filter: a sample which moved less than minDistance from the previous accepted
+ *      sample is dropped.
+ *  2.  Streaming Douglas-Peucker: samples after the last vertex (the anchor) are kept in a small
+ *      window. When a new sample makes one of them deviate from the chord anchor->sample by more
+ *      than the tolerance, or makes the stroke turn back, the newest window sample becomes a vertex.
+ *      A full window also forces a vertex, which bounds both memory and drawing latency.
+ *  3.  Batched drawing: vertices are drawn as a polyline of Bresenham segments once a batch is full.
+ *      The pen square is stamped only once at the stroke start. Each Bresenham step fills just the
+ *      row and/or column of pixels the moving square uncovers, and adjacent fills of the same
+ *      height or width are merged before they reach the display.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "graphics.h"
+#include "stroke.h"
+
+/** Rectangle waiting to be merged with its neighbours before it is filled */
+typedef struct
+{
+    PFsdword x1;
+    PFsdword y1;
+    PFsdword x2;
+    PFsdword y2;
+    PFEnBoolean valid;
+}StrokeRect;
+
+static void strokeFillRect(Stroke* stroke, PFsdword x1, PFsdword y1, PFsdword x2, PFsdword y2)
+{
+    pCfgStroke cfg = stroke->config;
+
+    if (x1 < cfg->clipX1) x1 = cfg->clipX1;
+    if (y1 < cfg->clipY1) y1 = cfg->clipY1;
+    if (x2 > cfg->clipX2) x2 = cfg->clipX2;
+    if (y2 > cfg->clipY2) y2 = cfg->clipY2;
+    if (x1 > x2 || y1 > y2)
+    {
+        return;
+    }
+
+    if (cfg->fillArea != NULL)
+    {
+        cfg->fillArea(x1, y1, x2, y2, stroke->color);
+    }
+    else
+    {
+        gfxFillArea(x1, y1, x2, y2, stroke->color);
+    }
+    stroke->stats.fills++;
+    stroke->stats.pixelsWritten += (PFdword)((x2 - x1 + 1) * (y2 - y1 + 1));
+}
+
+static void strokeMergeRect(Stroke* stroke, StrokeRect* pending, PFsdword x1, PFsdword y1, PFsdword x2, PFsdword y2)
+{
+    if (pending->valid == enBooleanTrue)
+    {
+        if (y1 == pending->y1 && y2 == pending->y2)
+        {
+            if (x1 == pending->x2 + 1)
+            {
+                pending->x2 = x2;
+                return;
+            }
+            if (x2 == pending->x1 - 1)
+            {
+                pending->x1 = x1;
+                return;
+            }
+        }
+        if (x1 == pending->x1 && x2 == pending->x2)
+        {
+            if (y1 == pending->y2 + 1)
+            {
+                pending->y2 = y2;
+                return;
+            }
+            if (y2 == pending->y1 - 1)
+            {
+                pending->y1 = y1;
+                return;
+            }
+        }
+        strokeFillRect(stroke, pending->x1, pending->y1, pending->x2, pending->y2);
+    }
+    pending->x1 = x1;
+    pending->y1 = y1;
+    pending->x2 = x2;
+    pending->y2 = y2;
+    pending->valid = enBooleanTrue;
+}
+
+static void strokeSegment(Stroke* stroke, StrokePoint to)
+{
+    PFsdword x = stroke->pen.x, y = stroke->pen.y;
+    PFsdword dx = to.x - x, dy = to.y - y, sx = 1, sy = 1, err, e2;
+    PFsdword lo = -(PFsdword)(stroke->penSize / 2);
+    PFsdword hi = lo + stroke->penSize - 1;
+    PFEnBoolean stepX, stepY;
+    StrokeRect pending = {0, 0, 0, 0, enBooleanFalse};
+
+    if (dx < 0)
+    {
+        dx = -dx;
+        sx = -1;
+    }
+    if (dy > 0)
+    {
+        dy = -dy;
+    }
+    else
+    {
+        sy = -1;
+    }
+    err = dx + dy;
+
+    while (x != to.x || y != to.y)
+    {
+        e2 = 2 * err;
+        stepX = enBooleanFalse;
+        stepY = enBooleanFalse;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x += sx;
+            stepX = enBooleanTrue;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y += sy;
+            stepY = enBooleanTrue;
+        }
+
+        // Only the leading column and/or row of the pen square are new pixels
+        if (stepX == enBooleanTrue)
+        {
+            PFsdword cx = (sx > 0) ? x + hi : x + lo;
+            strokeMergeRect(stroke, &pending, cx, y + lo, cx, y + hi);
+        }
+        if (stepY == enBooleanTrue)
+        {
+            PFsdword ry = (sy > 0) ? y + hi : y + lo;
+            PFsdword rx1 = x + lo, rx2 = x + hi;
+            if (stepX == enBooleanTrue)
+            {
+                if (sx > 0)
+                {
+                    rx2--;
+                }
+                else
+                {
+                    rx1++;
+                }
+            }
+            if (rx1 <= rx2)
+            {
+                strokeMergeRect(stroke, &pending, rx1, ry, rx2, ry);
+            }
+        }
+    }
+
+    if (pending.valid == enBooleanTrue)
+    {
+        strokeFillRect(stroke, pending.x1, pending.y1, pending.x2, pending.y2);
+    }
+    stroke->pen = to;
+}
+
+static PFEnBoolean strokeWithinTolerance(Stroke* stroke, StrokePoint end)
+{
+    PFsdword ax = end.x - stroke->anchor.x, ay = end.y - stroke->anchor.y;
+    PFsdword len2 = ax * ax + ay * ay;
+    PFsdword tol2 = stroke->config->tolerance * stroke->config->tolerance;
+    PFbyte k;
+
+    for (k = 0; k < stroke->windowCount; k++)
+    {
+        PFsdword px = stroke->window[k].x - stroke->anchor.x;
+        PFsdword py = stroke->window[k].y - stroke->anchor.y;
+
+        if (len2 == 0)
+        {
+            // The stroke came back to the anchor, a chord of zero length only covers nearby points
+            if (px * px + py * py > tol2)
+            {
+                return enBooleanFalse;
+            }
+            continue;
+        }
+
+        // A sample projecting outside the chord means the stroke turned back or overshot
+        PFsdword dot = px * ax + py * ay;
+        if (dot < 0 || dot > len2)
+        {
+            return enBooleanFalse;
+        }
+
+        // distance^2 = cross^2 / len2, compared without division
+        PFsqword cross = (PFsqword)px * ay - (PFsqword)py * ax;
+        if (cross * cross > (PFsqword)tol2 * len2)
+        {
+            return enBooleanFalse;
+        }
+    }
+    return enBooleanTrue;
+}
+
+static void strokeEmitVertex(Stroke* stroke, StrokePoint vertex)
+{
+    stroke->anchor = vertex;
+    stroke->batch[stroke->batchCount++] = vertex;
+    stroke->stats.vertices++;
+    if (stroke->batchCount == STROKE_BATCH_SIZE)
+    {
+        strokeFlush(stroke);
+    }
+}
+
+PFEnStatus strokeBegin(Stroke* stroke, pCfgStroke config, PFdword x, PFdword y)
+{
+    PFsdword lo, hi;
+
+    if (stroke == NULL || config == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    stroke->config = config;
+    gfxGetColor(&stroke->color);
+    gfxGetPenSize(&stroke->penSize);
+    if (stroke->penSize == 0)
+    {
+        stroke->penSize = 1;
+    }
+    stroke->pen.x = (PFsword)x;
+    stroke->pen.y = (PFsword)y;
+    stroke->anchor = stroke->pen;
+    stroke->lastSample = stroke->pen;
+    stroke->windowCount = 0;
+    stroke->batchCount = 0;
+    stroke->stats.samples = 1;
+    stroke->stats.dropped = 0;
+    stroke->stats.vertices = 1;
+    stroke->stats.fills = 0;
+    stroke->stats.pixelsWritten = 0;
+    stroke->active = enBooleanTrue;
+
+    lo = -(PFsdword)(stroke->penSize / 2);
+    hi = lo + stroke->penSize - 1;
+    strokeFillRect(stroke, (PFsdword)x + lo, (PFsdword)y + lo, (PFsdword)x + hi, (PFsdword)y + hi);
+
+    return enStatusSuccess;
+}
+
+PFEnStatus strokeAddPoint(Stroke* stroke, PFdword x, PFdword y)
+{
+    StrokePoint point, ref;
+    PFsdword mx, my;
+
+    if (stroke == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (stroke->active != enBooleanTrue)
+    {
+        return enStatusInvState;
+    }
+
+    point.x = (PFsword)x;
+    point.y = (PFsword)y;
+    stroke->stats.samples++;
+    stroke->lastSample = point;
+
+    ref = (stroke->windowCount != 0) ? stroke->window[stroke->windowCount - 1] : stroke->anchor;
+    mx = point.x - ref.x;
+    my = point.y - ref.y;
+    if (mx < 0) mx = -mx;
+    if (my < 0) my = -my;
+    if (mx < stroke->config->minDistance && my < stroke->config->minDistance)
+    {
+        stroke->stats.dropped++;
+        return enStatusSuccess;
+    }
+
+    if (stroke->windowCount == STROKE_WINDOW_SIZE ||
+        strokeWithinTolerance(stroke, point) != enBooleanTrue)
+    {
+        strokeEmitVertex(stroke, stroke->window[stroke->windowCount - 1]);
+        stroke->windowCount = 0;
+    }
+    stroke->window[stroke->windowCount++] = point;
+
+    return enStatusSuccess;
+}
+
+PFEnStatus strokeFlush(Stroke* stroke)
+{
+    PFbyte k;
+
+    if (stroke == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    for (k = 0; k < stroke->batchCount; k++)
+    {
+        strokeSegment(stroke, stroke->batch[k]);
+    }
+    stroke->batchCount = 0;
+
+    return enStatusSuccess;
+}
+
+PFEnStatus strokeEnd(Stroke* stroke)
+{
+    if (stroke == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (stroke->active != enBooleanTrue)
+    {
+        return enStatusInvState;
+    }
+
+    if (stroke->windowCount != 0)
+    {
+        strokeEmitVertex(stroke, stroke->window[stroke->windowCount - 1]);
+        stroke->windowCount = 0;
+    }
+    // Samples dropped as jitter at the tail still decide where the stroke ends
+    if (stroke->lastSample.x != stroke->anchor.x || stroke->lastSample.y != stroke->anchor.y)
+    {
+        strokeEmitVertex(stroke, stroke->lastSample);
+    }
+    strokeFlush(stroke);
+    stroke->active = enBooleanFalse;
+
+    return enStatusSuccess;
+}
+
+PFEnStatus strokeGetStats(Stroke* stroke, StrokeStats* stats)
+{
+    if (stroke == NULL || stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    *stats = stroke->stats;
+
+    return enStatusSuccess;
+}
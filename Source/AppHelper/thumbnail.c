@@ -0,0 +1,606 @@
+/**
+ *  \file       thumbnail.c
+ *  \brief      Downscaled thumbnails of images on the SDcard and a gallery of them.
+ *
+ *  Each decoder delivers pixels top row first: the .pnt and QOI decoders as spans, BMP images row by
+ *  row through an open image handle. All of them feed thumbAdd(), which sums the channels of each
+ *  box into the accumulator row and averages it when the last image row of the box is added.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "bitmap.h"
+#include "bmpImage.h"
+#include "pntImage.h"
+#include "qoiImage.h"
+#include "thumbnail.h"
+
+#define THUMB_LCD_GRAM_WRITE        0x22    /* GRAM write register of the LCD controller */
+#define THUMB_READ_PIXELS           (BMP_IMAGE_READ_SIZE / 2)
+#define THUMB_BMP_MAP_FRAGMENTS     4       /* Fragments of a BMP file kept in the link map */
+
+static const PFbyte thumbMagic[3] = {'T', 'H', 'M'};
+
+/* Target of thumbDrawArea() */
+typedef struct
+{
+    PFword x;
+    PFword y;
+    PFword areaWidth;
+    PFword areaHeight;
+    FsFile* sidecar;
+}ThumbTarget;
+
+static ThumbDecoder thumbDecoder;
+static PntEncoder thumbEncoder;
+static BmpImage thumbImage;
+static PFdword thumbLinkMap[BMP_IMAGE_LINK_MAP_SIZE(THUMB_BMP_MAP_FRAGMENTS)];
+
+static PFEnStatus thumbStart(ThumbDecoder* thumb, PFbyte factor, PFdword imageWidth, PFdword imageHeight,
+                             ThumbRowWriter writer, void* context)
+{
+    if (factor == 0 || factor > THUMB_MAX_FACTOR || imageWidth / factor == 0 || imageHeight / factor == 0 ||
+        imageWidth / factor > THUMB_MAX_WIDTH)
+    {
+        return enStatusInvArgs;
+    }
+
+    thumb->factor = factor;
+    thumb->width = (PFword)(imageWidth / factor);
+    thumb->height = (PFword)(imageHeight / factor);
+    thumb->rowsDone = 0;
+    thumb->writer = writer;
+    thumb->context = context;
+    thumb->imageWidth = (PFword)imageWidth;
+    thumb->x = 0;
+    thumb->boxRows = 0;
+    pfMemSet(thumb->red, 0, sizeof(thumb->red));
+    pfMemSet(thumb->green, 0, sizeof(thumb->green));
+    pfMemSet(thumb->blue, 0, sizeof(thumb->blue));
+    return enStatusSuccess;
+}
+
+/* Averages the accumulators into a thumbnail row and passes it to the writer */
+static PFEnStatus thumbEmit(ThumbDecoder* thumb)
+{
+    PFEnStatus status;
+    PFword count = (PFword)thumb->factor * thumb->factor;
+    PFword index;
+
+    for (index = 0; index < thumb->width; index++)
+    {
+        thumb->row[index] = (PFword)((((thumb->red[index] + count / 2) / count) << 11) |
+                                     (((thumb->green[index] + count / 2) / count) << 5) |
+                                     ((thumb->blue[index] + count / 2) / count));
+        thumb->red[index] = 0;
+        thumb->green[index] = 0;
+        thumb->blue[index] = 0;
+    }
+
+    status = thumb->writer(thumb, thumb->row);
+    thumb->rowsDone++;
+    return status;
+}
+
+/* Span writer of the decoders, adds image pixels in row order to the accumulators */
+static PFEnStatus thumbAdd(void* context, PFword color, PFword length)
+{
+    ThumbDecoder* thumb = (ThumbDecoder*)context;
+    PFEnStatus status;
+    PFword column;
+
+    while (length-- != 0)
+    {
+        column = thumb->x / thumb->factor;
+        if (column < thumb->width && thumb->rowsDone < thumb->height)
+        {
+            thumb->red[column] += color >> 11;
+            thumb->green[column] += (color >> 5) & 0x3F;
+            thumb->blue[column] += color & 0x1F;
+        }
+
+        if (++thumb->x == thumb->imageWidth)
+        {
+            thumb->x = 0;
+            if (++thumb->boxRows == thumb->factor)
+            {
+                thumb->boxRows = 0;
+                if (thumb->rowsDone < thumb->height)
+                {
+                    status = thumbEmit(thumb);
+                    if (status != enStatusSuccess)
+                    {
+                        return status;
+                    }
+                }
+            }
+        }
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus thumbDecodeBmp(const PFchar* fileName, PFbyte factor, ThumbDecoder* thumb,
+                                 ThumbRowWriter writer, void* context)
+{
+    PFEnStatus status;
+    PFword pixels[THUMB_READ_PIXELS];
+    PFword x, y, count, index;
+
+    status = bmpImageOpen(&thumbImage, fileName, thumbLinkMap, BMP_IMAGE_LINK_MAP_SIZE(THUMB_BMP_MAP_FRAGMENTS));
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = thumbStart(thumb, factor, thumbImage.header.imageWidth, thumbImage.header.imageHeight, writer, context);
+
+    // Rows below the last whole box are not read
+    for (y = 0; y < thumb->height * factor && status == enStatusSuccess; y++)
+    {
+        for (x = 0; x < thumb->imageWidth && status == enStatusSuccess; x += count)
+        {
+            count = (thumb->imageWidth - x < THUMB_READ_PIXELS) ? thumb->imageWidth - x : THUMB_READ_PIXELS;
+            status = bmpImageReadPixels(&thumbImage, x, y, count, pixels);
+            for (index = 0; index < count && status == enStatusSuccess; index++)
+            {
+                status = thumbAdd(thumb, pixels[index], 1);
+            }
+        }
+    }
+
+    bmpImageClose(&thumbImage);
+    return status;
+}
+
+PFEnStatus thumbDecode(const PFchar* fileName, PFbyte factor, ThumbDecoder* thumb, ThumbRowWriter writer, void* context)
+{
+    PFEnStatus status;
+    FsFile file;
+    PntHeader pntHeader;
+    QoiHeader qoiHeader;
+    PFbyte signature[4];
+    PFdword read = 0;
+
+    if (fileName == NULL || thumb == NULL || writer == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsFileOpen(&file, fileName, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = fsFileRead(&file, signature, sizeof(signature), &read);
+    if (status == enStatusSuccess && read != sizeof(signature))
+    {
+        status = enStatusNotSupported;
+    }
+    if (status == enStatusSuccess && signature[0] == 'B' && signature[1] == 'M')
+    {
+        fsFileClose(&file);
+        return thumbDecodeBmp(fileName, factor, thumb, writer, context);
+    }
+    if (status == enStatusSuccess)
+    {
+        status = fsFileSeek(&file, 0);
+    }
+
+    if (status == enStatusSuccess && signature[0] == 'P')
+    {
+        status = pntReadHeader(&file, &pntHeader);
+        if (status == enStatusSuccess)
+        {
+            status = thumbStart(thumb, factor, pntHeader.width, pntHeader.height, writer, context);
+        }
+        if (status == enStatusSuccess)
+        {
+            status = pntDecode(&file, &pntHeader, thumbAdd, thumb);
+        }
+    }
+    else if (status == enStatusSuccess && signature[0] == 'q')
+    {
+        status = qoiReadHeader(&file, &qoiHeader);
+        if (status == enStatusSuccess)
+        {
+            status = thumbStart(thumb, factor, qoiHeader.width, qoiHeader.height, writer, context);
+        }
+        if (status == enStatusSuccess)
+        {
+            status = qoiDecode(&file, &qoiHeader, thumbAdd, thumb);
+        }
+    }
+    else if (status == enStatusSuccess)
+    {
+        status = enStatusNotSupported;
+    }
+
+    fsFileClose(&file);
+    return status;
+}
+
+/* Path of the sidecar: the extension of the image replaced by .THM */
+static PFEnStatus thumbSidecarName(const PFchar* fileName, PFchar* name)
+{
+    PFdword length = pfStrLen((const char*)fileName);
+    PFdword dot = length;
+    PFdword index;
+
+    if (length + 5 > THUMB_NAME_SIZE)
+    {
+        return enStatusInvArgs;
+    }
+    for (index = length; index != 0 && fileName[index - 1] != '/'; index--)
+    {
+        if (fileName[index - 1] == '.')
+        {
+            dot = index - 1;
+            break;
+        }
+    }
+    pfMemCopy(name, fileName, dot);
+    pfMemCopy(&name[dot], ".THM", 5);
+    return enStatusSuccess;
+}
+
+/* Origin of the thumbnail, centered in the area when it fits */
+static void thumbPlace(ThumbTarget* target, PFword width, PFword height)
+{
+    if (target->areaWidth > width)
+    {
+        target->x += (target->areaWidth - width) / 2;
+    }
+    if (target->areaHeight > height)
+    {
+        target->y += (target->areaHeight - height) / 2;
+    }
+}
+
+static PFEnStatus thumbLcdSpan(void* context, PFword color, PFword length)
+{
+    (void)context;
+    while (length-- != 0)
+    {
+        gfxWriteData(color);
+    }
+    return enStatusSuccess;
+}
+
+/* Row writer of thumbDrawArea(), draws the row and adds it to the sidecar */
+static PFEnStatus thumbLcdRow(ThumbDecoder* thumb, const PFword* pixels)
+{
+    ThumbTarget* target = (ThumbTarget*)thumb->context;
+    PFword index;
+
+    if (thumb->rowsDone == 0)
+    {
+        thumbPlace(target, thumb->width, thumb->height);
+        if (target->sidecar != NULL &&
+            pntEncodeStart(&thumbEncoder, target->sidecar, thumb->width, thumb->height, NULL, 0) != enStatusSuccess)
+        {
+            target->sidecar = NULL;
+        }
+    }
+
+    gfxSetWindow(target->x, target->y + thumb->rowsDone, target->x + thumb->width - 1, target->y + thumb->rowsDone);
+    gfxSetCursor(target->x, target->y + thumb->rowsDone);
+    gfxWriteCmd(THUMB_LCD_GRAM_WRITE);
+    for (index = 0; index < thumb->width; index++)
+    {
+        gfxWriteData(pixels[index]);
+    }
+
+    // The sidecar is dropped on the first error, the thumbnail is still drawn
+    if (target->sidecar != NULL && pntEncodeRows(&thumbEncoder, pixels, 1) != enStatusSuccess)
+    {
+        target->sidecar = NULL;
+    }
+    return enStatusSuccess;
+}
+
+/* Draws the sidecar if it was made from the same image with the same factor */
+static PFEnStatus thumbDrawSidecar(const PFchar* name, PFbyte factor, PFdword imageSize, const ThumbTarget* area,
+                                   PFword* width, PFword* height)
+{
+    PFEnStatus status;
+    ThumbTarget place = *area;
+    FsFile file;
+    PntHeader header;
+    PFbyte data[THUMB_SIDECAR_HEADER_SIZE];
+    PFdword read = 0;
+
+    status = fsFileOpen(&file, name, FA_READ);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    status = fsFileRead(&file, data, THUMB_SIDECAR_HEADER_SIZE, &read);
+    if (status == enStatusSuccess && (read != THUMB_SIDECAR_HEADER_SIZE ||
+        pfMemCompare(data, thumbMagic, sizeof(thumbMagic)) != enBooleanTrue || data[3] != factor ||
+        (data[4] | ((PFdword)data[5] << 8) | ((PFdword)data[6] << 16) | ((PFdword)data[7] << 24)) != imageSize))
+    {
+        status = enStatusInvalidObject;
+    }
+    if (status == enStatusSuccess)
+    {
+        status = pntReadHeader(&file, &header);
+    }
+    if (status == enStatusSuccess)
+    {
+        thumbPlace(&place, header.width, header.height);
+        gfxSetWindow(place.x, place.y, place.x + header.width - 1, place.y + header.height - 1);
+        gfxSetCursor(place.x, place.y);
+        gfxWriteCmd(THUMB_LCD_GRAM_WRITE);
+        status = pntDecode(&file, &header, thumbLcdSpan, NULL);
+        gfxSetAreaMax();
+        *width = header.width;
+        *height = header.height;
+    }
+
+    fsFileClose(&file);
+    return status;
+}
+
+static PFEnStatus thumbDrawArea(const PFchar* fileName, PFbyte factor, ThumbTarget* target, PFword* width, PFword* height)
+{
+    PFEnStatus status;
+    FsFileInfo info;
+    FsFile sidecar;
+    PFchar name[THUMB_NAME_SIZE];
+    PFbyte data[THUMB_SIDECAR_HEADER_SIZE];
+    PFdword written = 0;
+    PFword thumbWidth = 0, thumbHeight = 0;
+    PFEnBoolean sidecarOpen = enBooleanFalse;
+
+    status = fsGetFileStatus(fileName, &info);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    status = thumbSidecarName(fileName, name);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    if (thumbDrawSidecar(name, factor, info.fsize, target, &thumbWidth, &thumbHeight) != enStatusSuccess)
+    {
+        // Missing or out of date, made again from the image
+        target->sidecar = NULL;
+        if (fsFileOpen(&sidecar, name, FA_CREATE_ALWAYS | FA_WRITE) == enStatusSuccess)
+        {
+            pfMemCopy(data, thumbMagic, sizeof(thumbMagic));
+            data[3] = factor;
+            data[4] = (PFbyte)info.fsize;
+            data[5] = (PFbyte)(info.fsize >> 8);
+            data[6] = (PFbyte)(info.fsize >> 16);
+            data[7] = (PFbyte)(info.fsize >> 24);
+            if (fsFileWrite(&sidecar, data, THUMB_SIDECAR_HEADER_SIZE, &written) == enStatusSuccess &&
+                written == THUMB_SIDECAR_HEADER_SIZE)
+            {
+                target->sidecar = &sidecar;
+                sidecarOpen = enBooleanTrue;
+            }
+            else
+            {
+                fsFileClose(&sidecar);
+                fsFileDelete(name);
+            }
+        }
+
+        status = thumbDecode(fileName, factor, &thumbDecoder, thumbLcdRow, target);
+        gfxSetAreaMax();
+        if (status == enStatusSuccess)
+        {
+            thumbWidth = thumbDecoder.width;
+            thumbHeight = thumbDecoder.height;
+        }
+
+        if (sidecarOpen == enBooleanTrue)
+        {
+            // An incomplete sidecar would be taken as up to date
+            if (status != enStatusSuccess || target->sidecar == NULL || pntEncodeFinish(&thumbEncoder) != enStatusSuccess)
+            {
+                fsFileClose(&sidecar);
+                fsFileDelete(name);
+            }
+            else if (fsFileClose(&sidecar) != enStatusSuccess)
+            {
+                fsFileDelete(name);
+            }
+        }
+    }
+
+    if (width != NULL)
+    {
+        *width = thumbWidth;
+    }
+    if (height != NULL)
+    {
+        *height = thumbHeight;
+    }
+    return status;
+}
+
+PFEnStatus thumbDraw(const PFchar* fileName, PFbyte factor, PFword x, PFword y, PFword* width, PFword* height)
+{
+    ThumbTarget target;
+
+    if (fileName == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    target.x = x;
+    target.y = y;
+    target.areaWidth = 0;
+    target.areaHeight = 0;
+    return thumbDrawArea(fileName, factor, &target, width, height);
+}
+
+PFEnStatus thumbInvalidate(const PFchar* fileName)
+{
+    PFEnStatus status;
+    PFchar name[THUMB_NAME_SIZE];
+
+    if (fileName == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = thumbSidecarName(fileName, name);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    return fsFileDelete(name);
+}
+
+/* Checks the extension of a directory entry, names are in 8.3 format */
+static PFEnBoolean thumbIsImage(FsFileInfo* info)
+{
+    PFbyte index;
+
+    if ((info->fattrib & AM_DIR) != 0)
+    {
+        return enBooleanFalse;
+    }
+    for (index = 0; info->fname[index] != 0 && info->fname[index] != '.'; index++);
+    if (info->fname[index] == 0)
+    {
+        return enBooleanFalse;
+    }
+    return (pfMemCompare(&info->fname[index], ".BMP", 5) == enBooleanTrue ||
+            pfMemCompare(&info->fname[index], ".PNT", 5) == enBooleanTrue ||
+            pfMemCompare(&info->fname[index], ".QOI", 5) == enBooleanTrue) ? enBooleanTrue : enBooleanFalse;
+}
+
+static PFEnStatus thumbPath(pCfgThumbGallery config, FsFileInfo* info, PFchar* fileName)
+{
+    PFdword pathLength = pfStrLen((const char*)config->path);
+    PFdword nameLength = pfStrLen((const char*)info->fname);
+
+    if (pathLength + nameLength + 2 > THUMB_NAME_SIZE)
+    {
+        return enStatusInvArgs;
+    }
+    pfMemCopy(fileName, config->path, pathLength);
+    if (pathLength != 0)
+    {
+        fileName[pathLength++] = '/';
+    }
+    pfMemCopy(&fileName[pathLength], info->fname, nameLength + 1);
+    return enStatusSuccess;
+}
+
+PFEnStatus thumbGalleryDraw(pCfgThumbGallery config, PFword first, PFword* total)
+{
+    PFEnStatus status;
+    FsDir dir;
+    FsFileInfo info;
+    ThumbTarget target;
+    PFchar fileName[THUMB_NAME_SIZE];
+    PFword index = 0, cell;
+    PFword cells;
+
+    if (config == NULL || config->path == NULL || config->columns == 0 || config->rows == 0)
+    {
+        return enStatusInvArgs;
+    }
+    cells = (PFword)config->columns * config->rows;
+
+    status = fsDirOpen(&dir, config->path);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    // Files opened for the thumbnails share the window of the file system, the directory
+    // sector is loaded again by each read of an entry
+    for (;;)
+    {
+        status = fsDirReadEntry(&dir, &info);
+        if (status != enStatusSuccess || info.fname[0] == 0)
+        {
+            break;
+        }
+        if (thumbIsImage(&info) != enBooleanTrue)
+        {
+            continue;
+        }
+
+        if (index >= first && index - first < cells)
+        {
+            cell = index - first;
+            target.x = config->x + (cell % config->columns) * config->cellWidth;
+            target.y = config->y + (cell / config->columns) * config->cellHeight;
+            target.areaWidth = config->cellWidth;
+            target.areaHeight = config->cellHeight;
+            gfxFillArea(target.x, target.y, target.x + config->cellWidth - 1, target.y + config->cellHeight - 1,
+                        config->background);
+
+            // An image which can not be drawn leaves its cell empty
+            if (thumbPath(config, &info, fileName) == enStatusSuccess)
+            {
+                thumbDrawArea(fileName, config->factor, &target, NULL, NULL);
+            }
+        }
+        index++;
+    }
+
+    for (cell = (index > first) ? index - first : 0; cell < cells; cell++)
+    {
+        target.x = config->x + (cell % config->columns) * config->cellWidth;
+        target.y = config->y + (cell / config->columns) * config->cellHeight;
+        gfxFillArea(target.x, target.y, target.x + config->cellWidth - 1, target.y + config->cellHeight - 1,
+                    config->background);
+    }
+
+    if (total != NULL)
+    {
+        *total = index;
+    }
+    return status;
+}
+
+PFEnStatus thumbGalleryGetImage(pCfgThumbGallery config, PFword index, PFchar* fileName)
+{
+    PFEnStatus status;
+    FsDir dir;
+    FsFileInfo info;
+
+    if (config == NULL || config->path == NULL || fileName == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    status = fsDirOpen(&dir, config->path);
+    while (status == enStatusSuccess)
+    {
+        status = fsDirReadEntry(&dir, &info);
+        if (status != enStatusSuccess)
+        {
+            break;
+        }
+        if (info.fname[0] == 0)
+        {
+            return enStatusNotExist;
+        }
+        if (thumbIsImage(&info) == enBooleanTrue && index-- == 0)
+        {
+            return thumbPath(config, &info, fileName);
+        }
+    }
+    return status;
+}
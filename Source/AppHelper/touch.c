@@ -0,0 +1,280 @@
+/**
+ * \file    touch.c
+ * \brief   Touch panel driver for the 4-wire resistive panel controller of the EduARM board.
+ *
+ * A sample is one chip select cycle of the controller, read by a transaction of the SPI bus arbiter:
+ * TOUCH_SAMPLES conversions of the X and Y positions and of the Z1 and Z2 pressure channels. The
+ * median of each channel is taken, samples with a pressure too light for a stable position are
+ * dropped and the position is scaled to the LCD with the calibration of the panel.
+ *
+ * The transaction is submitted from the touch interrupt by touchSampleStart() or from
+ * touchGetCoordinates(). The touch profile of the arbiter is urgent, so while the SD card holds the bus
+ * for a multiple block write the sample is read between two data blocks instead of after the write.
+ *
+ * \copyright Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ * \par
+ *  For licensing information, see the file 'LICENSE' in the root folder of
+ *  this software module.
+ *
+ * Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_gpio.h"
+#include "prime_spi0.h"
+#include "touch.h"
+
+/* Control bytes: start bit, channel, 12 bit conversion, power down between conversions */
+#define TOUCH_CMD_X                 0xD0
+#define TOUCH_CMD_Y                 0x90
+#define TOUCH_CMD_Z1                0xB0
+#define TOUCH_CMD_Z2                0xC0
+#define TOUCH_CMD_8BIT              0x08
+#define TOUCH_CMD_SINGLE_ENDED      0x04
+
+#define TOUCH_CONVERSION_BYTES      3       /* Control byte, then the 12 bit result in the next two bytes */
+#define TOUCH_CHANNELS              4
+#define TOUCH_FRAME_BYTES           (TOUCH_SAMPLES * TOUCH_CHANNELS * TOUCH_CONVERSION_BYTES)
+
+/* Calibration of the panel, in 12 bit codes at the edges of the LCD */
+#define TOUCH_X_MIN                 2128
+#define TOUCH_X_MAX                 4048
+#define TOUCH_Y_MIN                 2240
+#define TOUCH_Y_MAX                 3984
+#define TOUCH_PRESSURE_MAX          2750    /* Touch resistance above which the position is not stable */
+#define TOUCH_LCD_WIDTH             240
+#define TOUCH_LCD_HEIGHT            320
+
+static CfgTouch touchConfig;
+static PFbyte touchSpiId;
+static PFEnBoolean touchInit = enBooleanFalse;
+static PFEnBoolean touch8bit = enBooleanFalse;
+
+static PFbyte touchTx[TOUCH_FRAME_BYTES];
+static PFbyte touchRx[TOUCH_FRAME_BYTES];
+static SpiBusTransaction touchTransaction;
+static volatile PFEnBoolean touchQueued = enBooleanFalse;
+static volatile PFEnBoolean touchSampleReady = enBooleanFalse;
+static PFdword touchSampleX, touchSampleY;
+static PFdword touchLastX, touchLastY;
+
+/* Result of the conversion of the channel at index in the sample, as read on this board, in 12 bit codes */
+static PFdword touchResult(PFdword sample, PFdword channel)
+{
+    PFbyte* rx = &touchRx[(sample * TOUCH_CHANNELS + channel) * TOUCH_CONVERSION_BYTES];
+
+    // An 8 bit result is the byte after the control byte, the calibration stays in 12 bit codes
+    if (touch8bit == enBooleanTrue)
+    {
+        return (PFdword)rx[1] << 4;
+    }
+    return ((PFdword)rx[1] << 4) | (rx[2] >> 4);
+}
+
+static PFdword touchMedian(PFdword* values)
+{
+    PFdword k, j, value;
+
+    for (k = 1; k < TOUCH_SAMPLES; k++)
+    {
+        value = values[k];
+        for (j = k; j > 0 && values[j - 1] > value; j--)
+        {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+    return values[TOUCH_SAMPLES / 2];
+}
+
+static PFdword touchScale(PFdword code, PFdword min, PFdword max, PFdword size)
+{
+    code = (code < min) ? min : ((code > max) ? max : code);
+    return (code - min) * size / (max - min);
+}
+
+/* Called by the arbiter in the main context once the frame is read */
+static void touchSampleDone(SpiBusTransaction* transaction)
+{
+    PFdword x[TOUCH_SAMPLES], y[TOUCH_SAMPLES], pressure[TOUCH_SAMPLES];
+    PFdword sample, z1, z2;
+
+    if (transaction->status == enStatusSuccess)
+    {
+        for (sample = 0; sample < TOUCH_SAMPLES; sample++)
+        {
+            x[sample] = touchResult(sample, 0);
+            y[sample] = touchResult(sample, 1);
+            z1 = touchResult(sample, 2);
+            z2 = touchResult(sample, 3);
+            // Touch resistance, proportional to X * (Z2 / Z1 - 1)
+            pressure[sample] = (z1 != 0 && z2 >= z1) ? x[sample] * (z2 - z1) / z1 : 0xFFFFFFFF;
+        }
+
+        if (touchMedian(pressure) <= TOUCH_PRESSURE_MAX)
+        {
+            touchSampleX = touchScale(touchMedian(x), TOUCH_X_MIN, TOUCH_X_MAX, TOUCH_LCD_WIDTH);
+            touchSampleY = TOUCH_LCD_HEIGHT - touchScale(touchMedian(y), TOUCH_Y_MIN, TOUCH_Y_MAX, TOUCH_LCD_HEIGHT);
+            touchSampleReady = enBooleanTrue;
+        }
+    }
+    touchQueued = enBooleanFalse;
+}
+
+PFEnStatus touchOpen(pCfgTouch config)
+{
+    PFEnStatus status;
+    PFdword sample;
+    PFbyte mode, *tx;
+
+    if (config == NULL || config->spiRegisterDevice == NULL || config->spiChipSelect == NULL ||
+        config->spiSubmit == NULL || config->spiService == NULL ||
+        (config->precsel != enTouchPrecision_8bit && config->precsel != enTouchPrecision_12bit))
+    {
+        return enStatusInvArgs;
+    }
+
+    pfMemCopy(&touchConfig, config, sizeof(CfgTouch));
+    status = touchConfig.spiRegisterDevice(&touchSpiId, &touchConfig.gpioTouchCsGpio);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    touchConfig.spiChipSelect(&touchSpiId, 1);
+
+    touch8bit = (touchConfig.precsel == enTouchPrecision_8bit) ? enBooleanTrue : enBooleanFalse;
+    mode = (touch8bit == enBooleanTrue) ? TOUCH_CMD_8BIT : 0;
+    mode |= (touchConfig.refsel == enTouchReferenceSelect_Single) ? TOUCH_CMD_SINGLE_ENDED : 0;
+    pfMemSet(touchTx, 0, sizeof(touchTx));
+    for (sample = 0, tx = touchTx; sample < TOUCH_SAMPLES; sample++, tx += TOUCH_CHANNELS * TOUCH_CONVERSION_BYTES)
+    {
+        tx[0] = TOUCH_CMD_X | mode;
+        tx[TOUCH_CONVERSION_BYTES] = TOUCH_CMD_Y | mode;
+        tx[2 * TOUCH_CONVERSION_BYTES] = TOUCH_CMD_Z1 | mode;
+        tx[3 * TOUCH_CONVERSION_BYTES] = TOUCH_CMD_Z2 | mode;
+    }
+
+    touchTransaction.id = &touchSpiId;
+    touchTransaction.txData = touchTx;
+    touchTransaction.rxData = touchRx;
+    touchTransaction.size = TOUCH_FRAME_BYTES;
+    touchTransaction.callback = touchSampleDone;
+    touchQueued = enBooleanFalse;
+    touchSampleReady = enBooleanFalse;
+    touchLastX = 0;
+    touchLastY = 0;
+    touchInit = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus touchSampleStart(void)
+{
+    PFEnStatus status;
+    PFdword primask;
+
+    if (touchInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    // The touch interrupt and the main context may both start a sample
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (touchQueued == enBooleanTrue)
+    {
+        __set_PRIMASK(primask);
+        return enStatusBusy;
+    }
+    touchQueued = enBooleanTrue;
+    __set_PRIMASK(primask);
+
+    status = touchConfig.spiSubmit(&touchTransaction);
+    if (status != enStatusSuccess)
+    {
+        touchQueued = enBooleanFalse;
+    }
+    return status;
+}
+
+PFEnStatus touchGetCoordinates(PFdword* x_pos, PFdword* y_pos)
+{
+    if (touchInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+    if (x_pos == NULL || y_pos == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    if (touchSampleReady != enBooleanTrue)
+    {
+        touchSampleStart();
+        // The bus is only held by another device inside its own transfer
+        if (touchConfig.spiService() != enStatusSuccess || touchQueued == enBooleanTrue)
+        {
+            return enStatusBusy;
+        }
+        if (touchSampleReady != enBooleanTrue)
+        {
+            return enStatusError;
+        }
+    }
+
+    touchSampleReady = enBooleanFalse;
+    touchLastX = touchSampleX;
+    touchLastY = touchSampleY;
+    *x_pos = touchLastX;
+    *y_pos = touchLastY;
+    return enStatusSuccess;
+}
+
+PFEnStatus touchDataAvailable(PFEnBoolean *data)
+{
+    if (touchInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+    if (data == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    // The interrupt output of the controller is low while the panel is touched
+    *data = ((PF_GPIO_PORT_READ(touchConfig.gpioTouchIntPin.port) & touchConfig.gpioTouchIntPin.pin) == 0) ?
+            enBooleanTrue : enBooleanFalse;
+    return enStatusSuccess;
+}
+
+PFEnBoolean touchAvailable(PFdword* xPos, PFdword* yPos)
+{
+    PFEnBoolean touched = enBooleanFalse;
+
+    if (touchSampleReady != enBooleanTrue &&
+        (touchDataAvailable(&touched) != enStatusSuccess || touched != enBooleanTrue))
+    {
+        return enBooleanFalse;
+    }
+
+    // A touch too light for a position keeps the last one, the panel is still touched
+    if (touchGetCoordinates(xPos, yPos) != enStatusSuccess)
+    {
+        *xPos = touchLastX;
+        *yPos = touchLastY;
+    }
+    return enBooleanTrue;
+}
+
+PFEnStatus touchClose(void)
+{
+    if (touchInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    touchInit = enBooleanFalse;
+    return touchConfig.spiChipSelect(&touchSpiId, 1);
+}
@@ -0,0 +1,190 @@
+/**
+ *  \file       trace.c
+ *  \brief      Binary trace logger.
+ *
+ *  A writer reserves the next record of the ring by moving traceHead with a compare and swap, which
+ *  the Cortex-M3 does with LDREX/STREX, so writers preempting each other get different records without
+ *  disabling interrupts. The record is filled and sync is written last. traceDrain() sends records in
+ *  order and stops at a reserved record whose sync is not written yet, then clears sync and moves
+ *  traceTail to give the record back to the writers.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "trace.h"
+
+#define TRACE_RING_MASK             (TRACE_BUFFER_SIZE - 1)
+
+/* Orders the fields of a record before its sync byte */
+#if defined(__GNUC__) && defined(__thumb2__)
+    #define TRACE_BARRIER()         PF_C_ASM volatile ("dmb" ::: "memory")
+#else
+    #define TRACE_BARRIER()         __sync_synchronize()
+#endif
+
+static TraceRecord traceRing[TRACE_BUFFER_SIZE];
+static volatile PFdword traceHead = 0;          // Records reserved
+static volatile PFdword traceTail = 0;          // Records drained
+static volatile PFdword traceDropped = 0;
+static PFdword traceDroppedSent = 0;
+static PFdword traceDrained = 0;
+static PFdword traceMaxUsed = 0;
+static CfgTrace traceConfig;
+static PFEnBoolean traceInit = enBooleanFalse;
+
+PF_C_STATIC_INLINE PFdword traceTimestamp(void)
+{
+    return (traceConfig.timestamp != NULL) ? traceConfig.timestamp() : DWT->CYCCNT;
+}
+
+PFEnStatus traceOpen(pCfgTrace config)
+{
+    if (config == NULL || config->write == NULL || config->getTxBufferSize == NULL || config->getTxBufferCount == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    traceInit = enBooleanFalse;
+    traceConfig = *config;
+    // Started for a timestamp function built on the cycle counter as well, such as pfIdleGetCycles()
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    if (traceConfig.timestamp == NULL)
+    {
+        DWT->CYCCNT = 0;
+    }
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    pfMemSet(traceRing, 0, sizeof(traceRing));
+    traceHead = 0;
+    traceTail = 0;
+    traceDropped = 0;
+    traceDroppedSent = 0;
+    traceDrained = 0;
+    traceMaxUsed = 0;
+    traceInit = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus traceEvent(PFword id, PFdword arg1, PFdword arg2)
+{
+    TraceRecord* record;
+    PFdword head;
+
+    if (traceInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    do
+    {
+        head = traceHead;
+        if (head - traceTail >= TRACE_BUFFER_SIZE)
+        {
+            __sync_fetch_and_add(&traceDropped, 1);
+            return enStatusNoMem;
+        }
+    } while (!__sync_bool_compare_and_swap(&traceHead, head, head + 1));
+
+    record = &traceRing[head & TRACE_RING_MASK];
+    record->sequence = (PFbyte)head;
+    record->id = id;
+    record->timestamp = traceTimestamp();
+    record->arg1 = arg1;
+    record->arg2 = arg2;
+    TRACE_BARRIER();
+    record->sync = TRACE_SYNC;
+    return enStatusSuccess;
+}
+
+PFEnStatus traceDrain(void)
+{
+    PFEnStatus status;
+    TraceRecord* record;
+    TraceRecord notice;
+    PFdword size = 0, count = 0, room, used, dropped;
+
+    if (traceInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    status = traceConfig.getTxBufferSize(&size);
+    if (status == enStatusSuccess)
+    {
+        status = traceConfig.getTxBufferCount(&count);
+    }
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    // One byte of the driver FIFO is always kept free
+    room = (size > count + 1) ? (size - count - 1) / sizeof(TraceRecord) : 0;
+
+    used = traceHead - traceTail;
+    if (used > traceMaxUsed)
+    {
+        traceMaxUsed = used;
+    }
+
+    dropped = traceDropped;
+    if (dropped != traceDroppedSent && room != 0)
+    {
+        notice.sync = TRACE_SYNC;
+        notice.sequence = 0;
+        notice.id = TRACE_ID_DROPPED;
+        notice.timestamp = traceTimestamp();
+        notice.arg1 = dropped - traceDroppedSent;
+        notice.arg2 = dropped;
+        status = traceConfig.write((PFbyte*)&notice, sizeof(TraceRecord));
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        traceDroppedSent = dropped;
+        room--;
+    }
+
+    while (room != 0 && traceTail != traceHead)
+    {
+        record = &traceRing[traceTail & TRACE_RING_MASK];
+        if (record->sync != TRACE_SYNC)
+        {
+            // Reserved by a writer which has not finished it yet
+            break;
+        }
+        TRACE_BARRIER();
+        status = traceConfig.write((PFbyte*)record, sizeof(TraceRecord));
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        record->sync = 0;
+        TRACE_BARRIER();
+        traceTail++;
+        traceDrained++;
+        room--;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus traceGetStats(TraceStats* stats)
+{
+    if (stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    stats->events = traceHead;
+    stats->dropped = traceDropped;
+    stats->drained = traceDrained;
+    stats->maxUsed = traceMaxUsed;
+    return enStatusSuccess;
+}
@@ -0,0 +1,373 @@
+/**
+ *  \file       popUpSave.c
+ *  \brief      Background save of PopUps for Phi Game Engine
+ *
+ *  Runs are appended to the buffer while the area is read back one row at a time. When the buffer is
+ *  full it is written to the temporary file as a whole and filled again, so the file holds the first
+ *  runs in order and the buffer the last ones. The restore writes the rest of the buffer to the file
+ *  and reads all the runs back a buffer at a time.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_tick.h"
+#include "prime_timer.h"
+#include "prime_gpio.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "gameEngine.h"
+#include "popUpSave.h"
+
+#define POPUP_SAVE_MAX_RUN          0xFFFF  /* Longest run of a row */
+
+/* Pixels of equal color in a row */
+typedef struct
+{
+    PFword count;
+    PFword color;
+}PopUpRun;
+
+static PopUpRun popUpRuns[POPUP_SAVE_BUFFER_SIZE];
+static PFword popUpRow[POPUP_SAVE_MAX_WIDTH + 1];
+static FsFile popUpFile;
+static PFword popUpX, popUpY, popUpWidth, popUpHeight;
+static PFword popUpFill = 0;
+static PFEnBoolean popUpSaved = enBooleanFalse;
+static PFEnBoolean popUpSpilled = enBooleanFalse;
+static PopUpSaveStats popUpStats;
+static PFTimer popUpTimer;
+static PopUpDrawn popUpShown;
+
+static void popUpDiscard(void)
+{
+    if (popUpSpilled == enBooleanTrue)
+    {
+        fsFileClose(&popUpFile);
+        fsFileDelete(POPUP_SAVE_FILE_NAME);
+    }
+    popUpSpilled = enBooleanFalse;
+    popUpSaved = enBooleanFalse;
+    popUpFill = 0;
+}
+
+/* Writes the buffer to the end of the temporary file, creating it first if needed */
+static PFEnStatus popUpSpill(void)
+{
+    PFEnStatus status;
+    PFdword written = 0;
+
+    if (popUpSpilled != enBooleanTrue)
+    {
+        status = fsFileOpen(&popUpFile, POPUP_SAVE_FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE | FA_READ);
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+        popUpSpilled = enBooleanTrue;
+    }
+
+    status = fsFileWrite(&popUpFile, popUpRuns, (PFdword)popUpFill * sizeof(PopUpRun), &written);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    if (written != (PFdword)popUpFill * sizeof(PopUpRun))
+    {
+        return enStatusError;
+    }
+
+    popUpStats.spilledBytes += written;
+    popUpFill = 0;
+    return enStatusSuccess;
+}
+
+static PFEnStatus popUpAddRun(PFword count, PFword color)
+{
+    PFEnStatus status;
+
+    if (popUpFill == POPUP_SAVE_BUFFER_SIZE)
+    {
+        status = popUpSpill();
+        if (status != enStatusSuccess)
+        {
+            return status;
+        }
+    }
+
+    popUpRuns[popUpFill].count = count;
+    popUpRuns[popUpFill].color = color;
+    popUpFill++;
+    popUpStats.runs++;
+    return enStatusSuccess;
+}
+
+static void popUpFillRow(PFword x1, PFword x2, PFword y, PFword color)
+{
+    gfxFillArea(x1, y, x2, y, color);
+    popUpStats.pixelsRestored += x2 - x1 + 1;
+}
+
+/* Draws the pixels of a run which the PopUp changed */
+static void popUpRestoreRun(PFword x1, PFword y, PFword count, PFword color, const PopUpDrawn* drawn)
+{
+    PFword x2 = x1 + count - 1;
+    PFword from, to;
+
+    if (drawn == NULL || color != drawn->fillColor ||
+        (drawn->border == enBooleanTrue && (y == popUpY || y == popUpY + popUpHeight - 1)))
+    {
+        popUpFillRow(x1, x2, y, color);
+        return;
+    }
+
+    if (drawn->border == enBooleanTrue)
+    {
+        if (x1 == popUpX)
+        {
+            popUpFillRow(x1, x1, y, color);
+        }
+        if (x2 == popUpX + popUpWidth - 1)
+        {
+            popUpFillRow(x2, x2, y, color);
+        }
+    }
+    if (y >= drawn->textY1 && y <= drawn->textY2)
+    {
+        from = (x1 > drawn->textX1) ? x1 : drawn->textX1;
+        to = (x2 < drawn->textX2) ? x2 : drawn->textX2;
+        if (from <= to)
+        {
+            popUpFillRow(from, to, y, color);
+        }
+    }
+}
+
+PFEnStatus popUpSaveArea(PFword x, PFword y, PFword width, PFword height)
+{
+    PFEnStatus status;
+    PFdword startTick;
+    PFword row, column, count;
+
+    if (width == 0 || height == 0 || width > POPUP_SAVE_MAX_WIDTH)
+    {
+        return enStatusInvArgs;
+    }
+
+    popUpDiscard();
+    pfMemSet(&popUpStats, 0, sizeof(PopUpSaveStats));
+    startTick = pfTickSetTimeoutMs(0);
+    popUpX = x;
+    popUpY = y;
+    popUpWidth = width;
+    popUpHeight = height;
+
+    for (row = 0; row < height; row++)
+    {
+        // Same readback call as saveImage()
+        readBackground(x + 1, y + row, width, 0, popUpRow, width);
+        count = 1;
+        for (column = 1; column <= width; column++)
+        {
+            if (column < width && popUpRow[column] == popUpRow[column - 1] && count < POPUP_SAVE_MAX_RUN)
+            {
+                count++;
+                continue;
+            }
+            status = popUpAddRun(count, popUpRow[column - 1]);
+            if (status != enStatusSuccess)
+            {
+                popUpDiscard();
+                return status;
+            }
+            count = 1;
+        }
+    }
+
+    popUpStats.pixels = (PFdword)width * height;
+    popUpStats.saveTicks = pfTickSetTimeoutMs(0) - startTick;
+    popUpSaved = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus popUpRestoreArea(const PopUpDrawn* drawn)
+{
+    PFEnStatus status = enStatusSuccess;
+    PFdword startTick, remaining, bytes, bytesRead = 0;
+    PFword index, x, y;
+
+    if (popUpSaved != enBooleanTrue)
+    {
+        return enStatusInvState;
+    }
+
+    startTick = pfTickSetTimeoutMs(0);
+    popUpStats.pixelsRestored = 0;
+    if (popUpSpilled == enBooleanTrue)
+    {
+        status = popUpSpill();
+        if (status == enStatusSuccess)
+        {
+            status = fsFileSeek(&popUpFile, 0);
+        }
+        if (status != enStatusSuccess)
+        {
+            popUpDiscard();
+            return status;
+        }
+    }
+
+    remaining = popUpStats.runs;
+    index = 0;
+    x = 0;
+    y = 0;
+    while (remaining != 0)
+    {
+        if (index == popUpFill)
+        {
+            // Only with spilled runs, the buffer was written to the file above
+            bytes = ((remaining < POPUP_SAVE_BUFFER_SIZE) ? remaining : POPUP_SAVE_BUFFER_SIZE) * sizeof(PopUpRun);
+            status = fsFileRead(&popUpFile, popUpRuns, bytes, &bytesRead);
+            if (status == enStatusSuccess && bytesRead != bytes)
+            {
+                status = enStatusError;
+            }
+            if (status != enStatusSuccess)
+            {
+                break;
+            }
+            popUpFill = (PFword)(bytesRead / sizeof(PopUpRun));
+            index = 0;
+        }
+
+        popUpRestoreRun(popUpX + x, popUpY + y, popUpRuns[index].count, popUpRuns[index].color, drawn);
+        x += popUpRuns[index].count;
+        if (x >= popUpWidth)
+        {
+            x = 0;
+            y++;
+        }
+        index++;
+        remaining--;
+    }
+
+    popUpStats.restoreTicks = pfTickSetTimeoutMs(0) - startTick;
+    popUpDiscard();
+    return status;
+}
+
+/* Restores the background of the PopUp shown by drawPopUpSaved() at the end of its duration */
+static void popUpTimeout(PFTimer* timer)
+{
+    (void)timer;
+    popUpRestoreArea(&popUpShown);
+}
+
+PFEnStatus drawPopUpSaved(PopUpCfg* config, char* displayString, PFword duration, PFword fontType, PFword fontColor)
+{
+    PFEnStatus status;
+    commAttributes* attr;
+    MsgConfig message;
+    PFword fontWidth, fontHeight, length, color = BLACK, penSize = 1;
+
+    if (config == NULL || displayString == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    switch (fontType)
+    {
+    case enGfxFont_8X8:
+        fontWidth = 8;
+        fontHeight = 8;
+        break;
+    case enGfxFont_8X16:
+        fontWidth = 8;
+        fontHeight = 16;
+        break;
+    case enGfxFont_16X24:
+        fontWidth = 16;
+        fontHeight = 24;
+        break;
+    default:
+        return enStatusInvArgs;
+    }
+
+    // Same limits and text position as drawPopUp()
+    attr = &config->popUpAttr;
+    length = (PFword)pfStrLen(displayString);
+    if ((PFdword)length * fontWidth > attr->size.width || attr->size.height < fontHeight)
+    {
+        return enStatusNoMem;
+    }
+
+    // A PopUp still shown is taken down first, the new one may cover a part of it
+    if (pfTimerIsRunning(&popUpTimer) == enBooleanTrue)
+    {
+        pfTimerStop(&popUpTimer);
+        popUpRestoreArea(&popUpShown);
+    }
+
+    popUpShown.fillColor = attr->backgroundColor;
+    popUpShown.textX1 = attr->topLeft.xValue;
+    popUpShown.textY1 = attr->topLeft.yValue + attr->size.height / 2 - (fontHeight / 2 - 1);
+    popUpShown.textX2 = popUpShown.textX1 + length * fontWidth - 1;
+    popUpShown.textY2 = popUpShown.textY1 + fontHeight - 1;
+    popUpShown.border = attr->border;
+
+    status = popUpSaveArea(attr->topLeft.xValue, attr->topLeft.yValue, attr->size.width, attr->size.height);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    gfxFillArea(attr->topLeft.xValue, attr->topLeft.yValue, attr->topLeft.xValue + attr->size.width - 1,
+                attr->topLeft.yValue + attr->size.height - 1, attr->backgroundColor);
+
+    message.topLeft.xValue = popUpShown.textX1;
+    message.topLeft.yValue = popUpShown.textY1;
+    message.message = displayString;
+    message.fontType = (EnGfxFonts)fontType;
+    message.fontColor = fontColor;
+    message.backColor = attr->backgroundColor;
+    drawMessage(&message);
+
+    if (attr->border == enBooleanTrue)
+    {
+        // One pixel black outline, whatever the pen of the application is
+        gfxGetColor(&color);
+        gfxGetPenSize(&penSize);
+        gfxSetColor(BLACK);
+        gfxSetPenSize(1);
+        gfxDrawRectangle(attr->topLeft.xValue, attr->topLeft.yValue, attr->topLeft.xValue + attr->size.width - 1,
+                         attr->topLeft.yValue + attr->size.height - 1);
+        gfxSetColor(color);
+        gfxSetPenSize(penSize);
+    }
+
+    // Without the timer service the background is restored after a busy wait
+    if (pfTimerStart(&popUpTimer, popUpTimeout, NULL, duration, enBooleanFalse) != enStatusSuccess)
+    {
+        pfTickDelayMs(duration);
+        return popUpRestoreArea(&popUpShown);
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus popUpSaveGetStats(PopUpSaveStats* stats)
+{
+    if (stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfMemCopy(stats, &popUpStats, sizeof(PopUpSaveStats));
+    return enStatusSuccess;
+}
@@ -0,0 +1,129 @@
+/**
+ *  \file       object.c
+ *  \brief      Object Manager for Phi Game Engine
+ *
+ *  The objects are entries of the gameObjects table, and the Id of an object is the index of its entry.
+ *  The Graphics Manager walks the table through getGameObjectsPtr() from 0 to getObjectCount() - 1,
+ *  checking the used flag of each entry, so an object is created in the lowest free entry, as the
+ *  prebuilt manager did. The free entries are the bits of objectFree, highest bit first, and the lowest
+ *  free entry of a word is its count of leading zeros, so an Id is taken with one CLZ per word.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "gameEngine.h"
+
+#define OBJECT_FREE_WORDS           ((MAX_OBJECT_NUM + 31) / 32)
+
+/* Entry of the object table, its layout is read by the Graphics Manager */
+typedef struct
+{
+    pObjectCfg config;
+    PFbyte id;
+    PFEnBoolean used;
+}GameObject;
+
+static GameObject gameObjects[MAX_OBJECT_NUM];
+static PFbyte objectCount = 0;
+static PFdword objectFree[OBJECT_FREE_WORDS];   // Bit 31 - n of word w is set when entry 32 * w + n is free
+static PFEnBoolean objectInit = enBooleanFalse;
+
+/* Marks every entry free */
+static void objectFreeInit(void)
+{
+    PFbyte word;
+
+    for (word = 0; word < OBJECT_FREE_WORDS; word++)
+    {
+        objectFree[word] = 0xFFFFFFFF;
+    }
+    // No bits for entries past the end of the table
+    if ((MAX_OBJECT_NUM % 32) != 0)
+    {
+        objectFree[OBJECT_FREE_WORDS - 1] = ~(0xFFFFFFFF >> (MAX_OBJECT_NUM % 32));
+    }
+    objectInit = enBooleanTrue;
+}
+
+/* Returns the entry of a created object */
+static GameObject* objectFind(PFbyte id)
+{
+    if (id >= MAX_OBJECT_NUM || gameObjects[id].used != enBooleanTrue)
+    {
+        return NULL;
+    }
+    return &gameObjects[id];
+}
+
+PFEnStatus createObject(PFbyte *id, pObjectCfg config)
+{
+    PFbyte word, index;
+
+    if (id == NULL || config == NULL || config->objProperties == NULL ||
+        (config->type == enDynamic && config->dynamicCfg == NULL))
+    {
+        return enStatusInvArgs;
+    }
+
+    // The table is static, the bitmap is set up on the first use
+    if (objectInit != enBooleanTrue)
+    {
+        objectFreeInit();
+    }
+
+    for (word = 0; word < OBJECT_FREE_WORDS; word++)
+    {
+        if (objectFree[word] != 0)
+        {
+            index = (PFbyte)(word * 32 + PF_CLZ(objectFree[word]));
+            objectFree[word] &= ~(0x80000000 >> (index % 32));
+            gameObjects[index].config = config;
+            gameObjects[index].id = index;
+            gameObjects[index].used = enBooleanTrue;
+            objectCount++;
+            *id = index;
+            return enStatusSuccess;
+        }
+    }
+    return enStatusNoMem;
+}
+
+PFEnStatus destroyObject(PFbyte id)
+{
+    GameObject* object = objectFind(id);
+
+    if (object == NULL)
+    {
+        return enStatusError;
+    }
+
+    object->used = enBooleanFalse;
+    objectFree[id / 32] |= 0x80000000 >> (id % 32);
+    objectCount--;
+    return enStatusSuccess;
+}
+
+pObjectCfg getObject(PFbyte id)
+{
+    GameObject* object = objectFind(id);
+
+    return (object != NULL) ? object->config : NULL;
+}
+
+GameObject* getGameObjectsPtr(PFbyte id)
+{
+    return &gameObjects[id];
+}
+
+PFbyte getObjectCount(void)
+{
+    return objectCount;
+}
@@ -0,0 +1,206 @@
+/**
+ *  \file       renderer.c
+ *  \brief      Renderer Manager for Phi Game Engine
+ *
+ *  The Graphics Manager and the GUI queue commands with renderGfx() while a frame is built, and
+ *  lcdRenderer(), called periodically, runs them once renderFrame() was called. A command which does
+ *  not fit in the RENDERER_COMMAND_INSTANCES entries of the frame is refused.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_string.h"
+#include "prime_prof.h"
+#include "graphics.h"
+#include "bitmap.h"
+#include "gameEngine.h"
+
+/* Command issued to the Renderer, its layout is shared with the Graphics Manager and the GUI */
+typedef struct
+{
+    PFbyte command;                     // EnGfxWrapper
+    union
+    {
+        struct
+        {
+            PFword x1, y1, x2, y2;
+        }line;
+        struct
+        {
+            PFword x, y, radius;
+        }circle;
+        struct
+        {
+            PFword x, y, width, height;
+        }rectangle;
+        struct
+        {
+            PFword x1, y1, x2, y2, x3, y3;
+        }triangle;
+        struct
+        {
+            PFword x, y, width, height;
+            PFword* image;
+        }image;
+        struct
+        {
+            PFword x, y;
+            PFchar* string;
+            EnGfxFonts font;
+            PFdword fontColor;
+            PFdword backColor;
+        }string;
+    }shape;
+    PFword color;
+}RendererCommand;
+
+typedef void (*RendererWrapper)(RendererCommand* cmd);
+
+static void drawLine(RendererCommand* cmd);
+static void drawCircle(RendererCommand* cmd);
+static void drawSolidCircle(RendererCommand* cmd);
+static void drawRectangle(RendererCommand* cmd);
+static void drawSolidRectangle(RendererCommand* cmd);
+static void drawTriangle(RendererCommand* cmd);
+static void drawImage(RendererCommand* cmd);
+static void fillRGB(RendererCommand* cmd);
+static void drawString(RendererCommand* cmd);
+static void fillArea(RendererCommand* cmd);
+
+/* Indexed by EnGfxWrapper */
+static RendererWrapper gfxWrapper[] =
+{
+    drawLine,
+    drawCircle,
+    drawSolidCircle,
+    drawRectangle,
+    drawSolidRectangle,
+    drawTriangle,
+    drawImage,
+    fillRGB,
+    drawString,
+    fillArea
+};
+
+static PFword background;
+static volatile PFbyte renderFrameFlag = 0;
+static RendererCommand rendCommands[RENDERER_COMMAND_INSTANCES];
+static PFbyte rendCount = 0;
+
+static void drawLine(RendererCommand* cmd)
+{
+    gfxSetColor(cmd->color);
+    gfxDrawLine(cmd->shape.line.x1, cmd->shape.line.y1, cmd->shape.line.x2, cmd->shape.line.y2);
+}
+
+static void drawCircle(RendererCommand* cmd)
+{
+    gfxSetColor(cmd->color);
+    gfxDrawCircle(cmd->shape.circle.x, cmd->shape.circle.y, cmd->shape.circle.radius);
+}
+
+static void drawSolidCircle(RendererCommand* cmd)
+{
+    gfxDrawSolidCircle(cmd->shape.circle.x, cmd->shape.circle.y, cmd->shape.circle.radius, cmd->color);
+}
+
+static void drawRectangle(RendererCommand* cmd)
+{
+    gfxSetColor(cmd->color);
+    gfxDrawRectangle(cmd->shape.rectangle.x, cmd->shape.rectangle.y,
+                     cmd->shape.rectangle.x + cmd->shape.rectangle.width,
+                     cmd->shape.rectangle.y + cmd->shape.rectangle.height);
+}
+
+static void drawSolidRectangle(RendererCommand* cmd)
+{
+    gfxDrawSolidRectangle(cmd->shape.rectangle.x, cmd->shape.rectangle.y,
+                          cmd->shape.rectangle.x + cmd->shape.rectangle.width,
+                          cmd->shape.rectangle.y + cmd->shape.rectangle.height, cmd->color);
+}
+
+static void drawTriangle(RendererCommand* cmd)
+{
+    gfxSetColor(cmd->color);
+    gfxDrawFilledTriangle(cmd->shape.triangle.x1, cmd->shape.triangle.y1, cmd->shape.triangle.x2,
+                          cmd->shape.triangle.y2, cmd->shape.triangle.x3, cmd->shape.triangle.y3);
+}
+
+static void drawImage(RendererCommand* cmd)
+{
+    bmpDrawLoadedBitmap(cmd->shape.image.image, cmd->shape.image.x, cmd->shape.image.y,
+                        cmd->shape.image.width, cmd->shape.image.height);
+}
+
+static void fillRGB(RendererCommand* cmd)
+{
+    background = cmd->color;
+    gfxFillRGB(background);
+}
+
+static void drawString(RendererCommand* cmd)
+{
+    gfxDrawString(cmd->shape.string.x, cmd->shape.string.y, (const char*)cmd->shape.string.string,
+                  cmd->shape.string.font, cmd->shape.string.fontColor, cmd->shape.string.backColor);
+}
+
+static void fillArea(RendererCommand* cmd)
+{
+    gfxFillArea(cmd->shape.rectangle.x, cmd->shape.rectangle.y,
+                (PFword)(cmd->shape.rectangle.x + cmd->shape.rectangle.width),
+                (PFword)(cmd->shape.rectangle.y + cmd->shape.rectangle.height), cmd->color);
+}
+
+PFEnStatus rendererInit(void)
+{
+    background = getBackgoundColor();
+    return enStatusSuccess;
+}
+
+PF_RAMFUNC void lcdRenderer(void)
+{
+    PFbyte index;
+
+    if (renderFrameFlag != 1)
+    {
+        return;
+    }
+
+    PF_PROF_SCOPE(lcdRenderer);
+    for (index = 0; index < rendCount; index++)
+    {
+        gfxWrapper[rendCommands[index].command](&rendCommands[index]);
+    }
+    rendCount = 0;
+    renderFrameFlag = 0;
+}
+
+/* Queues a command for the next frame, called by the Graphics Manager and the GUI */
+PFEnStatus renderGfx(void* cmd)
+{
+    if (rendCount >= RENDERER_COMMAND_INSTANCES)
+    {
+        return enStatusNoMem;
+    }
+
+    pfMemCopy(&rendCommands[rendCount++], cmd, sizeof(RendererCommand));
+    return enStatusSuccess;
+}
+
+PFEnBoolean lastFrameRendered(void)
+{
+    return (renderFrameFlag == 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+void renderFrame(void)
+{
+    renderFrameFlag = 1;
+}
@@ -0,0 +1,275 @@
+/**
+ *  \file       resource.c
+ *  \brief      Resource Manager for Phi Game Engine
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_tick.h"
+#include "prime_timer.h"
+#include "prime_gpio.h"
+#include "buzzer.h"
+#include "fatFs.h"
+#include "bitmap.h"
+#include "bmpImage.h"
+#include "pntImage.h"
+#include "qoiImage.h"
+#include "resource.h"
+
+#if (RESOURCE_USE_IMAGE_CACHE == 1)
+/* Cached image; the pixel data of all the entries is packed at the start of the pool */
+typedef struct
+{
+    PFbyte path[RESOURCE_CACHE_PATH_SIZE];
+    EnImageFormat format;
+    PFEnBoolean used;
+    PFdword offset;
+    PFdword size;
+    PFdword lastUse;
+}ResourceCacheEntry;
+
+static PFbyte resourceCachePool[RESOURCE_CACHE_POOL_SIZE] PF_AHB_NOINIT;
+static ResourceCacheEntry resourceCacheEntries[RESOURCE_CACHE_ENTRIES];
+static ResourceCacheStats resourceCacheStats;
+static PFdword resourceCacheClock = 0;
+
+static ResourceCacheEntry* resourceCacheFind(const PFbyte* path, EnImageFormat format)
+{
+    PFdword length = pfStrLen((const char*)path) + 1;
+    PFbyte index;
+
+    if (length > RESOURCE_CACHE_PATH_SIZE)
+    {
+        return NULL;
+    }
+    for (index = 0; index < RESOURCE_CACHE_ENTRIES; index++)
+    {
+        if (resourceCacheEntries[index].used == enBooleanTrue && resourceCacheEntries[index].format == format &&
+            pfMemCompare(resourceCacheEntries[index].path, path, length) == enBooleanTrue)
+        {
+            return &resourceCacheEntries[index];
+        }
+    }
+    return NULL;
+}
+
+/* Removes an entry and moves the data of the entries behind it down to keep the pool packed */
+static void resourceCacheRemove(ResourceCacheEntry* entry)
+{
+    PFdword end = entry->offset + entry->size;
+    PFbyte index;
+
+    if (end < resourceCacheStats.bytesUsed)
+    {
+        pfMemMove(&resourceCachePool[entry->offset], &resourceCachePool[end], resourceCacheStats.bytesUsed - end);
+    }
+    for (index = 0; index < RESOURCE_CACHE_ENTRIES; index++)
+    {
+        if (resourceCacheEntries[index].used == enBooleanTrue && resourceCacheEntries[index].offset > entry->offset)
+        {
+            resourceCacheEntries[index].offset -= entry->size;
+        }
+    }
+    resourceCacheStats.bytesUsed -= entry->size;
+    entry->used = enBooleanFalse;
+}
+
+/* Copies a loaded image of size bytes to the cache, evicting the least recently used images until it fits */
+static void resourceCacheInsert(pImageCfg imageConfig, PFdword size)
+{
+    ResourceCacheEntry* entry;
+    PFdword length = pfStrLen((const char*)imageConfig->imagePath) + 1;
+    PFbyte index;
+
+    if (length > RESOURCE_CACHE_PATH_SIZE || size == 0 || size > RESOURCE_CACHE_POOL_SIZE)
+    {
+        resourceCacheStats.uncached++;
+        return;
+    }
+
+    for (;;)
+    {
+        entry = NULL;
+        for (index = 0; index < RESOURCE_CACHE_ENTRIES; index++)
+        {
+            if (resourceCacheEntries[index].used != enBooleanTrue)
+            {
+                entry = &resourceCacheEntries[index];
+                break;
+            }
+        }
+        if (entry != NULL && resourceCacheStats.bytesUsed + size <= RESOURCE_CACHE_POOL_SIZE)
+        {
+            break;
+        }
+
+        entry = &resourceCacheEntries[0];
+        for (index = 1; index < RESOURCE_CACHE_ENTRIES; index++)
+        {
+            if (resourceCacheEntries[index].used == enBooleanTrue &&
+                (entry->used != enBooleanTrue || resourceCacheEntries[index].lastUse < entry->lastUse))
+            {
+                entry = &resourceCacheEntries[index];
+            }
+        }
+        resourceCacheRemove(entry);
+        resourceCacheStats.evictions++;
+    }
+
+    pfMemCopy(entry->path, imageConfig->imagePath, length);
+    entry->format = imageConfig->imageFormat;
+    entry->offset = resourceCacheStats.bytesUsed;
+    entry->size = size;
+    entry->lastUse = ++resourceCacheClock;
+    entry->used = enBooleanTrue;
+    pfMemCopy(&resourceCachePool[entry->offset], imageConfig->imageBuffer, size);
+    resourceCacheStats.bytesUsed += size;
+}
+#endif  // #if (RESOURCE_USE_IMAGE_CACHE == 1)
+
+/* Loads the rows of a bmp image top row first, the number of bytes loaded is taken from the open image */
+static PFEnStatus resourceLoadBmp(pImageCfg imageConfig, PFdword* size)
+{
+    PFEnStatus status;
+    BmpImage image;
+    PFword width, height, row;
+
+    status = bmpImageOpen(&image, (const PFchar*)imageConfig->imagePath, NULL, 0);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    width = (PFword)image.header.imageWidth;
+    height = (PFword)image.header.imageHeight;
+    for (row = 0; row < height && status == enStatusSuccess; row++)
+    {
+        status = bmpImageReadPixels(&image, 0, row, width, &imageConfig->imageBuffer[(PFdword)row * width]);
+    }
+    bmpImageClose(&image);
+    *size = (PFdword)width * height * sizeof(PFword);
+    return status;
+}
+
+PFEnStatus getImage(pImageCfg imageConfig)
+{
+    PFEnStatus status;
+    PFdword size = 0;
+#if (RESOURCE_USE_IMAGE_CACHE == 1)
+    ResourceCacheEntry* entry;
+#endif
+
+    if (imageConfig->imageSource != enSDCard)
+    {
+        return enStatusNotSupported;
+    }
+
+#if (RESOURCE_USE_IMAGE_CACHE == 1)
+    entry = resourceCacheFind(imageConfig->imagePath, imageConfig->imageFormat);
+    if (entry != NULL)
+    {
+        pfMemCopy(imageConfig->imageBuffer, &resourceCachePool[entry->offset], entry->size);
+        entry->lastUse = ++resourceCacheClock;
+        resourceCacheStats.hits++;
+        return enStatusSuccess;
+    }
+#endif
+
+    switch (imageConfig->imageFormat)
+    {
+        case enImageBmpFormat:
+            status = resourceLoadBmp(imageConfig, &size);
+            break;
+
+        case enImagePntFormat:
+            status = pntLoadImage((const PFchar*)imageConfig->imagePath, imageConfig->imageBuffer, &size);
+            break;
+
+        case enImageQoiFormat:
+            status = qoiLoadImage((const PFchar*)imageConfig->imagePath, imageConfig->imageBuffer, &size);
+            break;
+
+        default:
+            return enStatusNotSupported;
+    }
+
+#if (RESOURCE_USE_IMAGE_CACHE == 1)
+    if (status == enStatusSuccess)
+    {
+        resourceCacheStats.misses++;
+        resourceCacheInsert(imageConfig, size);
+    }
+#endif
+    return status;
+}
+
+PFEnStatus resourceCacheInvalidate(const PFbyte* imagePath)
+{
+#if (RESOURCE_USE_IMAGE_CACHE == 1)
+    PFEnStatus status = enStatusNotExist;
+    PFdword length;
+    PFbyte index;
+
+    if (imagePath == NULL)
+    {
+        pfMemSet(resourceCacheEntries, 0, sizeof(resourceCacheEntries));
+        resourceCacheStats.bytesUsed = 0;
+        return enStatusSuccess;
+    }
+
+    // The same file may be cached once per format
+    length = pfStrLen((const char*)imagePath) + 1;
+    for (index = 0; length <= RESOURCE_CACHE_PATH_SIZE && index < RESOURCE_CACHE_ENTRIES; index++)
+    {
+        if (resourceCacheEntries[index].used == enBooleanTrue &&
+            pfMemCompare(resourceCacheEntries[index].path, imagePath, length) == enBooleanTrue)
+        {
+            resourceCacheRemove(&resourceCacheEntries[index]);
+            status = enStatusSuccess;
+        }
+    }
+    return status;
+#else
+    return enStatusNotExist;
+#endif
+}
+
+PFEnStatus resourceCacheGetStats(ResourceCacheStats* stats)
+{
+    if (stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+#if (RESOURCE_USE_IMAGE_CACHE == 1)
+    pfMemCopy(stats, &resourceCacheStats, sizeof(ResourceCacheStats));
+#else
+    pfMemSet(stats, 0, sizeof(ResourceCacheStats));
+#endif
+    return enStatusSuccess;
+}
+
+static PFTimer resourceBuzzerTimer;
+
+static void resourceBuzzerOff(PFTimer* timer)
+{
+    (void)timer;
+    buzzerOFF();
+}
+
+void playBuzzer(PFword duration)
+{
+    buzzerON();
+    // Without the timer service the buzzer is turned off after a busy wait
+    if (pfTimerStart(&resourceBuzzerTimer, resourceBuzzerOff, NULL, duration, enBooleanFalse) != enStatusSuccess)
+    {
+        pfTickDelayMs(duration);
+        buzzerOFF();
+    }
+}
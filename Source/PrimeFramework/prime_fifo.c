@@ -0,0 +1,285 @@
+/**
+ *  \file       prime_fifo.c
+ *  \brief      Common FIFO API.
+ *
+ *  The FIFO is a ring of bytes between pBegin and pEnd, both included. pHead is the next byte to
+ *  pop and pTail the next byte to push; the FIFO is empty when they are equal and full when pTail
+ *  is one byte behind pHead. Each side reads the pointer of the other side, copies its bytes and
+ *  only then moves its own pointer, after a memory barrier, so no critical section is needed.
+ *
+ *  With PF_FIFO_OVERWRITE_ENABLE a push to a full FIFO drops the oldest byte, so the producer moves
+ *  pHead as well. Both sides then move pHead by compare and swap from the value they read: a consumer
+ *  whose bytes were dropped while it copied them fails the swap and reads again from the new head.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_utils.h"
+#include "prime_string.h"
+
+/* Orders the copy of the bytes before the move of the pointer which hands them over */
+#if defined(__GNUC__) && defined(__thumb2__)
+    #define FIFO_BARRIER()          PF_C_ASM volatile ("dmb" ::: "memory")
+#else
+    #define FIFO_BARRIER()          __sync_synchronize()
+#endif
+
+/* The fill level is given by the pointers, the count field is only a copy for the prebuilt drivers */
+#if PF_FIFO_COUNT_ENABLE
+    #define FIFO_COUNT_ADD(fifo, n) __sync_fetch_and_add(&(fifo)->count, (n))
+    #define FIFO_COUNT_SUB(fifo, n) __sync_fetch_and_sub(&(fifo)->count, (n))
+#else
+    #define FIFO_COUNT_ADD(fifo, n)
+    #define FIFO_COUNT_SUB(fifo, n)
+#endif
+
+/* Moves the head from the value read by the caller, fails if the other side has moved it since */
+#if PF_FIFO_OVERWRITE_ENABLE
+    #define FIFO_HEAD_MOVE(fifo, old, new)  __sync_bool_compare_and_swap(&(fifo)->pHead, (old), (new))
+#else
+    #define FIFO_HEAD_MOVE(fifo, old, new)  ((fifo)->pHead = (new), 1)
+#endif
+
+/* Bytes in the FIFO for the given head and tail */
+PF_C_STATIC_INLINE PFdword fifoUsed(const PFFifo* pFifo, const PFbyte* head, const PFbyte* tail)
+{
+    return (tail >= head) ? (PFdword)(tail - head) : pFifo->size - (PFdword)(head - tail);
+}
+
+/* Pointer moved forward by the given number of bytes, wrapping at the end of the buffer */
+PF_C_STATIC_INLINE PFbyte* fifoAdvance(const PFFifo* pFifo, PFbyte* ptr, PFdword num)
+{
+    ptr += num;
+    if (ptr > pFifo->pEnd)
+    {
+        ptr -= pFifo->size;
+    }
+    return ptr;
+}
+
+PFEnStatus pfFifoInit(PFpFifo pFifo, PFbyte* pBuf, PFdword uSize)
+{
+    if (pFifo == NULL || pBuf == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    pFifo->pBegin = pBuf;
+    pFifo->pHead = pBuf;
+    pFifo->pTail = pBuf;
+    pFifo->pEnd = pBuf + uSize - 1;
+    pFifo->size = uSize;
+    pFifo->count = 0;
+
+    // One byte is always kept free
+    return (uSize >= 2) ? enStatusSuccess : enStatusError;
+}
+
+PFdword pfFifoLength(PFpFifo pFifo)
+{
+    return pFifo->size;
+}
+
+PFEnBoolean pfFifoPush(PFpFifo pFifo, PFbyte c)
+{
+    PFbyte* tail = pFifo->pTail;
+    PFbyte* next = (tail == pFifo->pEnd) ? pFifo->pBegin : tail + 1;
+
+    if (next == pFifo->pHead)
+    {
+#if PF_FIFO_OVERWRITE_ENABLE
+        // Drop the oldest byte, unless the consumer has just popped it
+        if (FIFO_HEAD_MOVE(pFifo, next, (next == pFifo->pEnd) ? pFifo->pBegin : next + 1))
+        {
+            FIFO_COUNT_SUB(pFifo, 1);
+        }
+#else
+        return enBooleanFalse;
+#endif
+    }
+
+    *tail = c;
+    FIFO_BARRIER();
+    pFifo->pTail = next;
+    FIFO_COUNT_ADD(pFifo, 1);
+    return enBooleanTrue;
+}
+
+PFbyte pfFifoPop(PFpFifo pFifo)
+{
+    PFbyte* head;
+    PFbyte c;
+
+    do
+    {
+        head = pFifo->pHead;
+        if (head == pFifo->pTail)
+        {
+            return 0xFF;
+        }
+
+        FIFO_BARRIER();
+        c = *head;
+        FIFO_BARRIER();
+    } while (!FIFO_HEAD_MOVE(pFifo, head, (head == pFifo->pEnd) ? pFifo->pBegin : head + 1));
+    FIFO_COUNT_SUB(pFifo, 1);
+    return c;
+}
+
+void pfFifoFlush(PFpFifo pFifo)
+{
+    PFbyte* head;
+    PFbyte* tail;
+
+    do
+    {
+        head = pFifo->pHead;
+        tail = pFifo->pTail;
+    } while (!FIFO_HEAD_MOVE(pFifo, head, tail));
+    FIFO_COUNT_SUB(pFifo, fifoUsed(pFifo, head, tail));
+}
+
+PFEnBoolean pfFifoIsEmpty(const PFpFifo pFifo)
+{
+    return (pFifo->pHead == pFifo->pTail) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFEnBoolean pfFifoIsFull(const PFpFifo pFifo)
+{
+    return (fifoUsed(pFifo, pFifo->pHead, pFifo->pTail) == pFifo->size - 1) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFEnStatus pfFifoWrite(PFpFifo pFifo, const PFbyte* pData, PFdword size, PFdword* pWritten)
+{
+    PFbyte* tail;
+    PFdword free, chunk;
+
+    if (pFifo == NULL || pData == NULL || pWritten == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    tail = pFifo->pTail;
+    free = pFifo->size - 1 - fifoUsed(pFifo, pFifo->pHead, tail);
+    if (size > free)
+    {
+        size = free;
+    }
+
+    if (size != 0)
+    {
+        chunk = (PFdword)(pFifo->pEnd - tail) + 1;
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+        pfMemCopy(tail, pData, chunk);
+        if (size > chunk)
+        {
+            pfMemCopy(pFifo->pBegin, pData + chunk, size - chunk);
+        }
+        FIFO_BARRIER();
+        pFifo->pTail = fifoAdvance(pFifo, tail, size);
+        FIFO_COUNT_ADD(pFifo, size);
+    }
+
+    *pWritten = size;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfFifoRead(PFpFifo pFifo, PFbyte* pData, PFdword size, PFdword* pRead)
+{
+    PFbyte* head;
+    PFdword used, chunk, num;
+
+    if (pFifo == NULL || pData == NULL || pRead == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    do
+    {
+        head = pFifo->pHead;
+        used = fifoUsed(pFifo, head, pFifo->pTail);
+        num = (size > used) ? used : size;
+        if (num == 0)
+        {
+            break;
+        }
+
+        FIFO_BARRIER();
+        chunk = (PFdword)(pFifo->pEnd - head) + 1;
+        if (chunk > num)
+        {
+            chunk = num;
+        }
+        pfMemCopy(pData, head, chunk);
+        if (num > chunk)
+        {
+            pfMemCopy(pData + chunk, pFifo->pBegin, num - chunk);
+        }
+        FIFO_BARRIER();
+    } while (!FIFO_HEAD_MOVE(pFifo, head, fifoAdvance(pFifo, head, num)));
+    FIFO_COUNT_SUB(pFifo, num);
+
+    *pRead = num;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfFifoPeekContiguous(PFpFifo pFifo, PFbyte** ppData, PFdword* pSize)
+{
+    PFbyte* head;
+    PFbyte* tail;
+
+    if (pFifo == NULL || ppData == NULL || pSize == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    head = pFifo->pHead;
+    tail = pFifo->pTail;
+    *ppData = tail;
+    if (tail >= head)
+    {
+        // Up to the end of the buffer, less the free byte when the head is at the beginning
+        *pSize = (PFdword)(pFifo->pEnd - tail) + ((head == pFifo->pBegin) ? 0 : 1);
+    }
+    else
+    {
+        *pSize = (PFdword)(head - tail) - 1;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfFifoCommit(PFpFifo pFifo, PFdword size)
+{
+    PFbyte* data;
+    PFdword free;
+
+    if (pFifo == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfFifoPeekContiguous(pFifo, &data, &free);
+    if (size > free)
+    {
+        return enStatusInvArgs;
+    }
+
+    if (size != 0)
+    {
+        FIFO_BARRIER();
+        pFifo->pTail = fifoAdvance(pFifo, data, size);
+        FIFO_COUNT_ADD(pFifo, size);
+    }
+    return enStatusSuccess;
+}
@@ -0,0 +1,279 @@
+/**
+ *  \file       prime_gpdma.c
+ *  \brief      General Purpose DMA Controller Driver for LPC1768.
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_gpdma.h"
+
+#define GPDMA_CONFIG_ENABLE         0x01
+
+#define GPDMA_CH_CTRL_SBSIZE_SHIFT  12
+#define GPDMA_CH_CTRL_DBSIZE_SHIFT  15
+#define GPDMA_CH_CTRL_SWIDTH_SHIFT  18
+#define GPDMA_CH_CTRL_DWIDTH_SHIFT  21
+#define GPDMA_CH_CTRL_SI            BIT_MASK_26
+#define GPDMA_CH_CTRL_DI            BIT_MASK_27
+#define GPDMA_CH_CTRL_I             BIT_MASK_31
+
+#define GPDMA_CH_CFG_E              BIT_MASK_0
+#define GPDMA_CH_CFG_SRC_SHIFT      1
+#define GPDMA_CH_CFG_DEST_SHIFT     6
+#define GPDMA_CH_CFG_TYPE_SHIFT     11
+#define GPDMA_CH_CFG_IE             BIT_MASK_14
+#define GPDMA_CH_CFG_ITC            BIT_MASK_15
+
+#define GPDMA_AHBRAM_START          0x2007C000
+#define GPDMA_AHBRAM_END            0x20084000
+#define GPDMA_FLASH_END             0x00080000
+
+static GPDMACH_TypeDef* const gpdmaChannel[GPDMA_MAX_CHANNELS] =
+{
+    PERIPH_GPDMACH0, PERIPH_GPDMACH1, PERIPH_GPDMACH2, PERIPH_GPDMACH3,
+    PERIPH_GPDMACH4, PERIPH_GPDMACH5, PERIPH_GPDMACH6, PERIPH_GPDMACH7
+};
+
+static PFGpdmaCallback gpdmaCallback[GPDMA_MAX_CHANNELS];
+static PFbyte gpdmaAllocated = 0;
+static PFEnBoolean gpdmaInitFlag = enBooleanFalse;
+
+static PFdword gpdmaControlWord(PFpGpdmaTransfer transfer)
+{
+    PFdword control;
+
+    control = (transfer->size & GPDMA_MAX_TRANSFER_SIZE) |
+              ((PFdword)transfer->srcBurst << GPDMA_CH_CTRL_SBSIZE_SHIFT) |
+              ((PFdword)transfer->destBurst << GPDMA_CH_CTRL_DBSIZE_SHIFT) |
+              ((PFdword)transfer->srcWidth << GPDMA_CH_CTRL_SWIDTH_SHIFT) |
+              ((PFdword)transfer->destWidth << GPDMA_CH_CTRL_DWIDTH_SHIFT);
+    if (transfer->srcIncrement == enBooleanTrue)
+    {
+        control |= GPDMA_CH_CTRL_SI;
+    }
+    if (transfer->destIncrement == enBooleanTrue)
+    {
+        control |= GPDMA_CH_CTRL_DI;
+    }
+    // Interrupt only at the end of the chain
+    if (transfer->lli == NULL)
+    {
+        control |= GPDMA_CH_CTRL_I;
+    }
+    return control;
+}
+
+PFEnStatus pfGpdmaOpen(void)
+{
+    PFbyte channel;
+
+    POWER_ON(GPDMA);
+
+    GPDMA_CHANNEL->DMACConfig = 0;
+    for (channel = 0; channel < GPDMA_MAX_CHANNELS; channel++)
+    {
+        gpdmaChannel[channel]->DMACCConfig = 0;
+        gpdmaCallback[channel] = NULL;
+    }
+    GPDMA_CHANNEL->DMACIntTCClear = 0xFF;
+    GPDMA_CHANNEL->DMACIntErrClr = 0xFF;
+    gpdmaAllocated = 0;
+
+    // Little endian on both AHB masters
+    GPDMA_CHANNEL->DMACConfig = GPDMA_CONFIG_ENABLE;
+    if ((GPDMA_CHANNEL->DMACConfig & GPDMA_CONFIG_ENABLE) == 0)
+    {
+        return enStatusError;
+    }
+
+    NVIC_EnableIRQ(DMA_IRQn);
+    gpdmaInitFlag = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaClose(void)
+{
+    PFbyte channel;
+
+    NVIC_DisableIRQ(DMA_IRQn);
+    for (channel = 0; channel < GPDMA_MAX_CHANNELS; channel++)
+    {
+        gpdmaChannel[channel]->DMACCConfig = 0;
+        gpdmaCallback[channel] = NULL;
+    }
+    GPDMA_CHANNEL->DMACConfig = 0;
+    gpdmaAllocated = 0;
+    gpdmaInitFlag = enBooleanFalse;
+
+    POWER_OFF(GPDMA);
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaChannelAlloc(PFbyte* channel)
+{
+    PFdword primask;
+    PFbyte index;
+
+    if (channel == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (gpdmaInitFlag != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (index = 0; index < GPDMA_MAX_CHANNELS; index++)
+    {
+        if ((gpdmaAllocated & (1 << index)) == 0)
+        {
+            gpdmaAllocated |= (1 << index);
+            __set_PRIMASK(primask);
+            *channel = index;
+            return enStatusSuccess;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return enStatusNoMem;
+}
+
+PFEnStatus pfGpdmaChannelFree(PFbyte channel)
+{
+    if (channel >= GPDMA_MAX_CHANNELS)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfGpdmaStop(channel);
+    gpdmaCallback[channel] = NULL;
+    gpdmaAllocated &= ~(1 << channel);
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaLliSetup(PFGpdmaLli* lli, PFpGpdmaTransfer transfer)
+{
+    if (lli == NULL || transfer == NULL || transfer->size == 0 || transfer->size > GPDMA_MAX_TRANSFER_SIZE)
+    {
+        return enStatusInvArgs;
+    }
+
+    lli->srcAddr = transfer->srcAddr;
+    lli->destAddr = transfer->destAddr;
+    lli->nextLli = (PFdword)transfer->lli;
+    lli->control = gpdmaControlWord(transfer);
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaStart(PFbyte channel, PFpGpdmaTransfer transfer)
+{
+    GPDMACH_TypeDef* ch;
+    PFdword config;
+
+    if (channel >= GPDMA_MAX_CHANNELS || transfer == NULL ||
+        transfer->size == 0 || transfer->size > GPDMA_MAX_TRANSFER_SIZE)
+    {
+        return enStatusInvArgs;
+    }
+    if (gpdmaInitFlag != enBooleanTrue || (gpdmaAllocated & (1 << channel)) == 0)
+    {
+        return enStatusNotConfigured;
+    }
+
+    ch = gpdmaChannel[channel];
+    if ((ch->DMACCConfig & GPDMA_CH_CFG_E) != 0)
+    {
+        return enStatusBusy;
+    }
+
+    GPDMA_CHANNEL->DMACIntTCClear = (1 << channel);
+    GPDMA_CHANNEL->DMACIntErrClr = (1 << channel);
+    gpdmaCallback[channel] = transfer->callback;
+
+    ch->DMACCSrcAddr = transfer->srcAddr;
+    ch->DMACCDestAddr = transfer->destAddr;
+    ch->DMACCLLI = (PFdword)transfer->lli;
+    ch->DMACCControl = gpdmaControlWord(transfer);
+
+    config = GPDMA_CH_CFG_IE | GPDMA_CH_CFG_ITC | ((PFdword)transfer->transferType << GPDMA_CH_CFG_TYPE_SHIFT);
+    if (transfer->srcConn != enGpdmaConnMemory)
+    {
+        config |= ((PFdword)transfer->srcConn << GPDMA_CH_CFG_SRC_SHIFT);
+    }
+    if (transfer->destConn != enGpdmaConnMemory)
+    {
+        config |= ((PFdword)transfer->destConn << GPDMA_CH_CFG_DEST_SHIFT);
+    }
+    ch->DMACCConfig = config;
+    ch->DMACCConfig = config | GPDMA_CH_CFG_E;
+
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaStop(PFbyte channel)
+{
+    if (channel >= GPDMA_MAX_CHANNELS)
+    {
+        return enStatusInvArgs;
+    }
+
+    gpdmaChannel[channel]->DMACCConfig &= ~GPDMA_CH_CFG_E;
+    GPDMA_CHANNEL->DMACIntTCClear = (1 << channel);
+    GPDMA_CHANNEL->DMACIntErrClr = (1 << channel);
+    return enStatusSuccess;
+}
+
+PFEnBoolean pfGpdmaIsBusy(PFbyte channel)
+{
+    if (channel >= GPDMA_MAX_CHANNELS)
+    {
+        return enBooleanFalse;
+    }
+
+    return ((GPDMA_CHANNEL->DMACEnbldChns & (1 << channel)) != 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFEnBoolean pfGpdmaIsAccessible(const void* address, PFdword size)
+{
+    PFdword start = (PFdword)address;
+
+    if (start >= GPDMA_AHBRAM_START && start + size <= GPDMA_AHBRAM_END)
+    {
+        return enBooleanTrue;
+    }
+    if (start + size <= GPDMA_FLASH_END)
+    {
+        return enBooleanTrue;
+    }
+    return enBooleanFalse;
+}
+
+void GPDMA_INT_HANDLER(void)
+{
+    PFdword tcStat, errStat;
+    PFbyte channel;
+
+    tcStat = GPDMA_CHANNEL->DMACIntTCStat;
+    errStat = GPDMA_CHANNEL->DMACIntErrStat;
+    GPDMA_CHANNEL->DMACIntTCClear = tcStat;
+    GPDMA_CHANNEL->DMACIntErrClr = errStat;
+
+    // Channels are served in priority order
+    for (channel = 0; channel < GPDMA_MAX_CHANNELS; channel++)
+    {
+        if (((tcStat | errStat) & (1 << channel)) == 0 || gpdmaCallback[channel] == NULL)
+        {
+            continue;
+        }
+        gpdmaCallback[channel](channel, ((errStat & (1 << channel)) != 0) ? enStatusError : enStatusSuccess);
+    }
+}
@@ -0,0 +1,175 @@
+/**
+ *  \file       prime_idle.c
+ *  \brief      Tickless idle sleep.
+ *
+ *  The RIT counts from 0 up to its compare value and is reset by the match, which raises the tick
+ *  interrupt. A sleep of n ticks sets the compare value to n periods, so the next match comes at the end
+ *  of the last tick and its interrupt counts one tick; the n - 1 others are added here. If another
+ *  interrupt wakes the CPU first, the RIT is stopped while the counter is read: the whole periods it
+ *  holds are added as ticks and the counter keeps the part of the current one, which makes the next
+ *  match come at the same time as if the tick interrupts had run.
+ *
+ *  The DWT cycle counter stops with the CPU clock in the sleep, so the RIT counts of each sleep are also
+ *  kept as CPU cycles, which pfIdleGetCycles() adds to the counter.
+ *
+ *  RICTRL holds the interrupt flag, cleared by writing 1, so its other bits are changed with the flag
+ *  bit written as 0.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_tick.h"
+#include "prime_idle.h"
+
+#define IDLE_RIT_INT                0x01        // RICTRL: match interrupt flag
+#define IDLE_RIT_ENCLR              0x02        // RICTRL: counter reset on match
+#define IDLE_RIT_EN                 0x08        // RICTRL: counter enable
+
+static PFCfgIdle idleConfig;
+static PFdword idlePeriod = 0;
+static PFdword idleMaxTicks = 0;
+static PFdword idleSleeps = 0;
+static PFdword idleEarlyWakes = 0;
+static PFqword idleSleptCounts = 0;
+static PFdword idleCyclesPerCount = 0;
+static volatile PFdword idleSleptCycles = 0;
+static PFdword idleOpenTick = 0;
+static PFEnBoolean idleInit = enBooleanFalse;
+
+PF_C_STATIC_INLINE void idleRitEnable(PFEnBoolean enable)
+{
+    PFbyte ctrl = PERIPH_RIT->RICTRL & ~(IDLE_RIT_INT | IDLE_RIT_EN);
+
+    PERIPH_RIT->RICTRL = (enable == enBooleanTrue) ? (ctrl | IDLE_RIT_EN) : ctrl;
+}
+
+PFEnStatus pfIdleOpen(PFpCfgIdle config)
+{
+    if (config == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if ((PERIPH_RIT->RICTRL & IDLE_RIT_ENCLR) == 0)
+    {
+        return enStatusNotSupported;
+    }
+    if ((PERIPH_RIT->RICTRL & IDLE_RIT_EN) == 0 || PERIPH_RIT->RICOMPVAL == 0)
+    {
+        return enStatusNotConfigured;
+    }
+
+    idleConfig = *config;
+    idlePeriod = PERIPH_RIT->RICOMPVAL;
+    idleCyclesPerCount = pfSysGetCpuClock() / pfSysGetPclk(PCLK_DIV_RIT);
+    // The compare value of a sleep must fit in 32 bits
+    idleMaxTicks = 0xFFFFFFFF / idlePeriod;
+    if (idleConfig.maxSleepTicks != 0 && idleConfig.maxSleepTicks < idleMaxTicks)
+    {
+        idleMaxTicks = idleConfig.maxSleepTicks;
+    }
+    pfIdleResetStats();
+    idleInit = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+void pfIdleSleep(PFdword ticks)
+{
+    PFdword start, count, elapsed, slept;
+
+    if (idleInit != enBooleanTrue || ticks == 0 || (PERIPH_RIT->RICTRL & IDLE_RIT_INT) != 0)
+    {
+        return;
+    }
+    if (ticks > idleMaxTicks)
+    {
+        ticks = idleMaxTicks;
+    }
+
+    if (idleConfig.suspend != NULL)
+    {
+        idleConfig.suspend();
+    }
+
+    start = PERIPH_RIT->RICOUNTER;
+    if (ticks > 1)
+    {
+        PERIPH_RIT->RICOMPVAL = idlePeriod * ticks;
+    }
+    if ((PERIPH_RIT->RICTRL & IDLE_RIT_INT) != 0)
+    {
+        // Matched before the new compare value was written, the interrupt counts the tick
+        PERIPH_RIT->RICOMPVAL = idlePeriod;
+    }
+    else
+    {
+        __DSB();
+        __WFI();
+
+        idleRitEnable(enBooleanFalse);
+        count = PERIPH_RIT->RICOUNTER;
+        if ((PERIPH_RIT->RICTRL & IDLE_RIT_INT) != 0)
+        {
+            // Reset by the match at the end of the sleep, whose interrupt counts the last tick
+            pfTickAdd(ticks - 1);
+            slept = idlePeriod * ticks - start + count;
+        }
+        else
+        {
+            elapsed = count / idlePeriod;
+            PERIPH_RIT->RICOUNTER = count - elapsed * idlePeriod;
+            pfTickAdd(elapsed);
+            slept = count - start;
+            idleEarlyWakes++;
+        }
+        idleSleptCounts += slept;
+        idleSleptCycles += slept * idleCyclesPerCount;
+        PERIPH_RIT->RICOMPVAL = idlePeriod;
+        idleRitEnable(enBooleanTrue);
+        idleSleeps++;
+    }
+
+    if (idleConfig.resume != NULL)
+    {
+        idleConfig.resume();
+    }
+}
+
+PFdword pfIdleGetCycles(void)
+{
+    return DWT->CYCCNT + idleSleptCycles;
+}
+
+PFEnStatus pfIdleGetStats(PFIdleStats* stats)
+{
+    if (stats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (idleInit != enBooleanTrue)
+    {
+        return enStatusNotConfigured;
+    }
+
+    stats->sleeps = idleSleeps;
+    stats->earlyWakes = idleEarlyWakes;
+    stats->sleptTicks = (PFdword)(idleSleptCounts / idlePeriod);
+    stats->totalTicks = pfTickGet() - idleOpenTick;
+    return enStatusSuccess;
+}
+
+void pfIdleResetStats(void)
+{
+    idleSleeps = 0;
+    idleEarlyWakes = 0;
+    idleSleptCounts = 0;
+    idleOpenTick = pfTickGet();
+}
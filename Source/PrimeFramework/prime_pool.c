@@ -0,0 +1,185 @@
+/**
+ *  \file       prime_pool.c
+ *  \brief      Fixed-block memory pool.
+ *
+ *  The free blocks form a singly linked list through their first word, pFree being the head. An
+ *  allocation takes the head and a free puts the block back as the head, so the last block freed
+ *  is the next one allocated.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_utils.h"
+#include "prime_pool.h"
+
+/* Free block */
+typedef struct PoolLink
+{
+    struct PoolLink* pNext;
+}PoolLink;
+
+PF_C_STATIC_INLINE void poolCountAlloc(PFpPool pPool, PFdword used)
+{
+    // Not atomic, an interrupt may lower the high water mark by one
+    if (used > pPool->highWater)
+    {
+        pPool->highWater = used;
+    }
+}
+
+PF_C_STATIC_INLINE PFEnBoolean poolOwns(PFpPool pPool, const void* pBlock)
+{
+    const PFbyte* block = (const PFbyte*)pBlock;
+
+    return (block >= pPool->pBegin && block < pPool->pEnd &&
+            (PFdword)(block - pPool->pBegin) % pPool->blockSize == 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFEnStatus pfPoolInit(PFpPool pPool, void* pBuf, PFdword blockSize, PFdword blockCount)
+{
+    PoolLink* block;
+    PFdword index;
+
+    if (pPool == NULL || pBuf == NULL || blockCount == 0 ||
+        blockSize < sizeof(PoolLink) || blockSize % sizeof(PoolLink) != 0 ||
+        ((PFdword)pBuf & (sizeof(PoolLink) - 1)) != 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    pPool->pBegin = (PFbyte*)pBuf;
+    pPool->pEnd = pPool->pBegin + blockSize * blockCount;
+    pPool->blockSize = blockSize;
+    pPool->blockCount = blockCount;
+    pPool->used = 0;
+    pPool->highWater = 0;
+    pPool->failures = 0;
+
+    for (index = 0; index < blockCount; index++)
+    {
+        block = (PoolLink*)(pPool->pBegin + index * blockSize);
+        block->pNext = (index + 1 < blockCount) ? (PoolLink*)((PFbyte*)block + blockSize) : NULL;
+    }
+    pPool->pFree = pBuf;
+    return enStatusSuccess;
+}
+
+void* pfPoolAlloc(PFpPool pPool)
+{
+    PoolLink* block = (PoolLink*)pPool->pFree;
+
+    if (block == NULL)
+    {
+        pPool->failures++;
+        return NULL;
+    }
+
+    pPool->pFree = block->pNext;
+    poolCountAlloc(pPool, ++pPool->used);
+    return block;
+}
+
+PFEnStatus pfPoolFree(PFpPool pPool, void* pBlock)
+{
+    PoolLink* block = (PoolLink*)pBlock;
+
+    if (poolOwns(pPool, pBlock) != enBooleanTrue)
+    {
+        return enStatusInvArgs;
+    }
+
+    block->pNext = (PoolLink*)pPool->pFree;
+    pPool->pFree = block;
+    pPool->used--;
+    return enStatusSuccess;
+}
+
+void* pfPoolAllocIsr(PFpPool pPool)
+{
+    PoolLink* block;
+
+#if defined(__GNUC__) && defined(__thumb2__)
+    // The next pointer is read between LDREX and STREX, so the head cannot change in between unnoticed
+    do
+    {
+        block = (PoolLink*)PF_LDREXW((volatile PFdword*)&pPool->pFree);
+        if (block == NULL)
+        {
+            PF_CLREX();
+            __sync_fetch_and_add(&pPool->failures, 1);
+            return NULL;
+        }
+    } while (PF_STREXW((PFdword)block->pNext, (volatile PFdword*)&pPool->pFree) != 0);
+#else
+    // ABA prone: if the head is allocated and freed again before the swap, block->pNext is stale
+    do
+    {
+        block = (PoolLink*)pPool->pFree;
+        if (block == NULL)
+        {
+            __sync_fetch_and_add(&pPool->failures, 1);
+            return NULL;
+        }
+    } while (!__sync_bool_compare_and_swap(&pPool->pFree, block, block->pNext));
+#endif
+
+    poolCountAlloc(pPool, __sync_add_and_fetch(&pPool->used, 1));
+    return block;
+}
+
+PFEnStatus pfPoolFreeIsr(PFpPool pPool, void* pBlock)
+{
+    PoolLink* block = (PoolLink*)pBlock;
+
+    if (poolOwns(pPool, pBlock) != enBooleanTrue)
+    {
+        return enStatusInvArgs;
+    }
+
+#if defined(__GNUC__) && defined(__thumb2__)
+    do
+    {
+        block->pNext = (PoolLink*)PF_LDREXW((volatile PFdword*)&pPool->pFree);
+    } while (PF_STREXW((PFdword)block, (volatile PFdword*)&pPool->pFree) != 0);
+#else
+    do
+    {
+        block->pNext = (PoolLink*)pPool->pFree;
+    } while (!__sync_bool_compare_and_swap(&pPool->pFree, block->pNext, block));
+#endif
+
+    __sync_fetch_and_sub(&pPool->used, 1);
+    return enStatusSuccess;
+}
+
+PFdword pfPoolIndex(PFpPool pPool, const void* pBlock)
+{
+    return (PFdword)((const PFbyte*)pBlock - pPool->pBegin) / pPool->blockSize;
+}
+
+void* pfPoolBlock(PFpPool pPool, PFdword index)
+{
+    return (index < pPool->blockCount) ? pPool->pBegin + index * pPool->blockSize : NULL;
+}
+
+PFEnStatus pfPoolGetStats(PFpPool pPool, PFPoolStats* pStats)
+{
+    if (pPool == NULL || pStats == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    pStats->blockCount = pPool->blockCount;
+    pStats->used = pPool->used;
+    pStats->highWater = pPool->highWater;
+    pStats->failures = pPool->failures;
+    return enStatusSuccess;
+}
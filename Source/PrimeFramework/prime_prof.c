@@ -0,0 +1,245 @@
+/**
+ *  \file       prime_prof.c
+ *  \brief      Cycle counting profiler.
+ *
+ *  A section takes the next free entry on its first run and keeps its index in the static byte of
+ *  the macros, so later runs update the entry without looking for it. The counter is 32 bits wide,
+ *  so a section must last less than 2^32 counts, about 42 seconds at 100 MHz.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_string.h"
+#include "prime_prof.h"
+
+#if !defined(__arm__)
+#include <time.h>
+#endif
+
+#if defined(__arm__)
+    #define PROF_UNIT               "cycles"
+#else
+    #define PROF_UNIT               "ns"
+#endif
+
+#define PROF_LINE_SIZE              200
+#define PROF_NAME_MAX               32
+
+static PFProfEntry profEntries[PF_PROF_MAX_ENTRIES];
+static PFbyte profCount = 0;
+static PFdword profOverhead = 0;
+
+#if !defined(__arm__)
+PFdword pfProfCounter(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (PFdword)((PFqword)now.tv_sec * 1000000000ULL + (PFqword)now.tv_nsec);
+}
+#endif
+
+/* Appends a number in decimal and returns the end of the text */
+static char* profAppendNumber(char* text, PFqword value)
+{
+    char digits[20];
+    PFbyte count = 0;
+
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (count != 0)
+    {
+        *text++ = digits[--count];
+    }
+    return text;
+}
+
+/* Appends a string padded with spaces to the given width */
+static char* profAppendText(char* text, const char* str, PFbyte width)
+{
+    PFbyte length = 0;
+
+    while (str[length] != '\0' && length < PROF_NAME_MAX)
+    {
+        *text++ = str[length++];
+    }
+    for (; length < width; length++)
+    {
+        *text++ = ' ';
+    }
+    return text;
+}
+
+void pfProfInit(void)
+{
+    PFdword start, end, index;
+
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    // Shortest time between two reads of the counter, as taken by an empty section
+    profOverhead = 0xFFFFFFFF;
+    for (index = 0; index < 8; index++)
+    {
+        start = pfProfCounter();
+        end = pfProfCounter();
+        if (end - start < profOverhead)
+        {
+            profOverhead = end - start;
+        }
+    }
+    pfProfReset();
+}
+
+PFEnStatus pfProfRecord(PFbyte* pId, const char* name, PFdword duration)
+{
+    PFProfEntry* entry;
+#if PF_PROF_HISTOGRAM
+    PFbyte bin = 0;
+    PFdword bits;
+#endif
+
+    if (*pId == PF_PROF_NO_ENTRY)
+    {
+        if (profCount == PF_PROF_MAX_ENTRIES)
+        {
+            return enStatusNoMem;
+        }
+        entry = &profEntries[profCount];
+        pfMemSet(entry, 0, sizeof(PFProfEntry));
+        entry->name = name;
+        entry->min = 0xFFFFFFFF;
+        *pId = profCount++;
+    }
+    entry = &profEntries[*pId];
+
+    duration = (duration > profOverhead) ? duration - profOverhead : 0;
+    entry->count++;
+    entry->total += duration;
+    if (duration < entry->min)
+    {
+        entry->min = duration;
+    }
+    if (duration > entry->max)
+    {
+        entry->max = duration;
+    }
+#if PF_PROF_HISTOGRAM
+    for (bits = duration >> PF_PROF_HIST_SHIFT; bits != 0 && bin < PF_PROF_HIST_BINS - 1; bits >>= 1)
+    {
+        bin++;
+    }
+    entry->histogram[bin]++;
+#endif
+    return enStatusSuccess;
+}
+
+void pfProfScopeEnd(PFProfScope* scope)
+{
+    pfProfRecord(scope->pId, scope->name, pfProfCounter() - scope->start);
+}
+
+void pfProfReset(void)
+{
+    PFbyte index;
+
+    for (index = 0; index < profCount; index++)
+    {
+        profEntries[index].count = 0;
+        profEntries[index].min = 0xFFFFFFFF;
+        profEntries[index].max = 0;
+        profEntries[index].total = 0;
+#if PF_PROF_HISTOGRAM
+        pfMemSet(profEntries[index].histogram, 0, sizeof(profEntries[index].histogram));
+#endif
+    }
+}
+
+PFEnStatus pfProfGetEntry(PFbyte index, PFProfEntry* entry)
+{
+    if (index >= profCount || entry == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    pfMemCopy(entry, &profEntries[index], sizeof(PFProfEntry));
+    return enStatusSuccess;
+}
+
+PFbyte pfProfGetCount(void)
+{
+    return profCount;
+}
+
+PFEnStatus pfProfDump(PFProfWrite write)
+{
+    PFEnStatus status;
+    PFProfEntry* entry;
+    char line[PROF_LINE_SIZE];
+    char* text;
+    PFbyte index;
+#if PF_PROF_HISTOGRAM
+    PFbyte bin, last;
+#endif
+
+    if (write == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    text = profAppendText(line, "\r\nsection (" PROF_UNIT ")", 0);
+    text = profAppendText(text, "\r\n", 0);
+    status = write((PFbyte*)line, (PFdword)(text - line));
+
+    for (index = 0; index < profCount && status == enStatusSuccess; index++)
+    {
+        entry = &profEntries[index];
+        text = profAppendText(line, entry->name, 20);
+        text = profAppendText(text, " n=", 0);
+        text = profAppendNumber(text, entry->count);
+        if (entry->count != 0)
+        {
+            text = profAppendText(text, " min=", 0);
+            text = profAppendNumber(text, entry->min);
+            text = profAppendText(text, " avg=", 0);
+            text = profAppendNumber(text, entry->total / entry->count);
+            text = profAppendText(text, " max=", 0);
+            text = profAppendNumber(text, entry->max);
+            text = profAppendText(text, " total=", 0);
+            text = profAppendNumber(text, entry->total);
+        }
+        text = profAppendText(text, "\r\n", 0);
+        status = write((PFbyte*)line, (PFdword)(text - line));
+
+#if PF_PROF_HISTOGRAM
+        // Runs per bin, up to the last bin in use
+        if (status == enStatusSuccess && entry->count != 0)
+        {
+            for (last = PF_PROF_HIST_BINS - 1; last != 0 && entry->histogram[last] == 0; last--);
+            text = profAppendText(line, "  hist", 0);
+            for (bin = 0; bin <= last; bin++)
+            {
+                *text++ = ' ';
+                text = profAppendNumber(text, entry->histogram[bin]);
+            }
+            text = profAppendText(text, "\r\n", 0);
+            status = write((PFbyte*)line, (PFdword)(text - line));
+        }
+#endif
+    }
+    return status;
+}
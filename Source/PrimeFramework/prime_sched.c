@@ -0,0 +1,212 @@
+/**
+ *  \file       prime_sched.c
+ *  \brief      Cooperative task scheduler.
+ *
+ *  Tasks are kept in a fixed table in the order they were added. Each round walks the table once and
+ *  calls the tasks whose wake conditions hold; a task added or removed during a round takes effect in
+ *  the same round. The conditions are checked by the scheduler, so a waiting task costs no call.
+ *  A round which calls no task is followed by the idle function, if one is set.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_utils.h"
+#include "prime_tick.h"
+#include "prime_sched.h"
+
+static PFSchedTask* schedTasks[PF_SCHED_MAX_TASKS];
+static PFbyte schedCount = 0;
+static PFSchedIdleFunction schedIdle = NULL;
+
+/* Tells whether a task is to be called, and how late it is when woken by its timeout */
+static PFEnBoolean schedReady(PFSchedTask* task, PFdword* lateTicks)
+{
+    PFbyte wait = task->wait;
+
+    *lateTicks = 0;
+    if (wait == 0)
+    {
+        return enBooleanTrue;
+    }
+    if ((wait & PF_SCHED_WAIT_FLAGS) != 0 && (task->flags & task->wakeFlags) != 0)
+    {
+        return enBooleanTrue;
+    }
+    if ((wait & PF_SCHED_WAIT_FIFO) != 0 && pfFifoIsEmpty(task->wakeFifo) == enBooleanFalse)
+    {
+        return enBooleanTrue;
+    }
+    if ((wait & PF_SCHED_WAIT_TIMEOUT) != 0 && pfTickCheckTimeout(task->wakeTick) == enBooleanTrue)
+    {
+        *lateTicks = pfTickGet() - task->wakeTick;
+        return enBooleanTrue;
+    }
+    return enBooleanFalse;
+}
+
+/* Ticks to the nearest timeout of the waiting tasks, 0 if a task is ready */
+static PFdword schedIdleTicks(void)
+{
+    PFdword ticks = PF_SCHED_NO_TIMEOUT;
+    PFdword lateTicks, left;
+    PFbyte index;
+
+    for (index = 0; index < schedCount; index++)
+    {
+        if (schedReady(schedTasks[index], &lateTicks) == enBooleanTrue)
+        {
+            return 0;
+        }
+        if ((schedTasks[index]->wait & PF_SCHED_WAIT_TIMEOUT) != 0)
+        {
+            left = schedTasks[index]->wakeTick - pfTickGet();
+            if (left < ticks)
+            {
+                ticks = left;
+            }
+        }
+    }
+    return ticks;
+}
+
+PFEnStatus pfSchedAdd(PFSchedTask* task, PFSchedTaskFunction function, void* context)
+{
+    PFbyte index;
+
+    if (task == NULL || function == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    for (index = 0; index < schedCount; index++)
+    {
+        if (schedTasks[index] == task)
+        {
+            return enStatusInvState;
+        }
+    }
+    if (schedCount == PF_SCHED_MAX_TASKS)
+    {
+        return enStatusNoMem;
+    }
+
+    task->function = function;
+    task->context = context;
+    task->resume = 0;
+    task->wait = 0;
+    task->wakeTick = 0;
+    task->wakeFifo = NULL;
+    task->wakeFlags = 0;
+    task->flags = 0;
+    task->runs = 0;
+    task->maxLateTicks = 0;
+    schedTasks[schedCount++] = task;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSchedRemove(PFSchedTask* task)
+{
+    PFbyte index;
+
+    for (index = 0; index < schedCount; index++)
+    {
+        if (schedTasks[index] == task)
+        {
+            schedCount--;
+            for (; index < schedCount; index++)
+            {
+                schedTasks[index] = schedTasks[index + 1];
+            }
+            return enStatusSuccess;
+        }
+    }
+    return enStatusInvArgs;
+}
+
+void pfSchedWait(PFSchedTask* task, PFbyte wait, PFdword timeoutMs)
+{
+    if ((wait & PF_SCHED_WAIT_TIMEOUT) != 0)
+    {
+        task->wakeTick = pfTickSetTimeoutMs(timeoutMs);
+    }
+    task->wait = wait;
+}
+
+void pfSchedSetFlags(PFSchedTask* task, PFdword mask)
+{
+    __sync_fetch_and_or(&task->flags, mask);
+}
+
+PFdword pfSchedTakeFlags(PFSchedTask* task, PFdword mask)
+{
+    return __sync_fetch_and_and(&task->flags, ~mask) & mask;
+}
+
+PFEnBoolean pfSchedRunOnce(void)
+{
+    PFSchedTask* task;
+    PFEnBoolean ran = enBooleanFalse;
+    PFdword lateTicks;
+    PFbyte index = 0;
+
+    while (index < schedCount)
+    {
+        task = schedTasks[index];
+        if (schedReady(task, &lateTicks) != enBooleanTrue)
+        {
+            index++;
+            continue;
+        }
+
+        if (lateTicks > task->maxLateTicks)
+        {
+            task->maxLateTicks = lateTicks;
+        }
+        task->wait = 0;
+        task->runs++;
+        ran = enBooleanTrue;
+        if (task->function(task) == enSchedTaskDone)
+        {
+            pfSchedRemove(task);
+        }
+        // The task may have removed itself or others, go on from the task following it
+        if (index < schedCount && schedTasks[index] == task)
+        {
+            index++;
+        }
+    }
+    return ran;
+}
+
+void pfSchedSetIdle(PFSchedIdleFunction idle)
+{
+    schedIdle = idle;
+}
+
+void pfSchedRun(void)
+{
+    PFdword ticks;
+
+    while (1)
+    {
+        if (pfSchedRunOnce() == enBooleanTrue || schedIdle == NULL)
+        {
+            continue;
+        }
+
+        __disable_irq();
+        ticks = schedIdleTicks();
+        if (ticks != 0)
+        {
+            schedIdle(ticks);
+        }
+        __enable_irq();
+    }
+}
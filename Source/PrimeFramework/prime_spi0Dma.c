@@ -0,0 +1,231 @@
+/**
+ *  \file       prime_spi0Dma.c
+ *  \brief      DMA transfer mode of the SPI 0 Driver for LPC1768.
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_gpio.h"
+#include "prime_spi0.h"
+#include "prime_spi0Dma.h"
+
+#define SSP_SR_RNE                  0x04
+#define SSP_SR_BSY                  0x10
+#define SSP_ICR_RORIC               0x01
+#define SSP_DMACR_RXDMAE            0x01
+#define SSP_DMACR_TXDMAE            0x02
+
+static const PFbyte spi0DmaDummyTx = 0xFF;
+static PFbyte spi0DmaDummyRx PF_GPDMA_BUFFER;
+
+static PFbyte spi0DmaRxChannel = 0xFF, spi0DmaTxChannel = 0xFF;
+static PFcallback spi0DmaCallback = NULL;
+static volatile PFEnStatus spi0DmaStatus = enStatusSuccess;
+
+static void spi0DmaFinish(PFEnStatus status)
+{
+    SPI0_CHANNEL->DMACR = 0;
+    spi0DmaStatus = status;
+    if (spi0DmaCallback != NULL)
+    {
+        spi0DmaCallback();
+    }
+}
+
+static void spi0DmaRxDone(PFbyte channel, PFEnStatus status)
+{
+    (void)channel;
+    // The last frame has been received, so the transmit side is done as well
+    pfGpdmaStop(spi0DmaTxChannel);
+    spi0DmaFinish(status);
+}
+
+static void spi0DmaTxDone(PFbyte channel, PFEnStatus status)
+{
+    (void)channel;
+    if (status != enStatusSuccess)
+    {
+        pfGpdmaStop(spi0DmaRxChannel);
+        spi0DmaFinish(status);
+    }
+}
+
+PFEnStatus pfSpi0DmaOpen(void)
+{
+    PFEnStatus status;
+
+    if (spi0DmaRxChannel != 0xFF)
+    {
+        return enStatusSuccess;
+    }
+
+    // Receive channel is allocated first to get the higher priority
+    status = pfGpdmaChannelAlloc(&spi0DmaRxChannel);
+    if (status != enStatusSuccess)
+    {
+        spi0DmaRxChannel = 0xFF;
+        return status;
+    }
+    status = pfGpdmaChannelAlloc(&spi0DmaTxChannel);
+    if (status != enStatusSuccess)
+    {
+        pfGpdmaChannelFree(spi0DmaRxChannel);
+        spi0DmaRxChannel = 0xFF;
+        spi0DmaTxChannel = 0xFF;
+        return status;
+    }
+
+    spi0DmaStatus = enStatusSuccess;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSpi0DmaClose(void)
+{
+    if (spi0DmaRxChannel == 0xFF)
+    {
+        return enStatusNotConfigured;
+    }
+
+    SPI0_CHANNEL->DMACR = 0;
+    pfGpdmaChannelFree(spi0DmaTxChannel);
+    pfGpdmaChannelFree(spi0DmaRxChannel);
+    spi0DmaRxChannel = 0xFF;
+    spi0DmaTxChannel = 0xFF;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSpi0DmaStart(PFbyte* txData, PFbyte* rxData, PFdword size, PFcallback callback)
+{
+    PFGpdmaTransfer rx, tx;
+    PFEnStatus status;
+    volatile PFdword dummy;
+
+    if (spi0DmaRxChannel == 0xFF)
+    {
+        return enStatusNotConfigured;
+    }
+    if (size == 0 || size > GPDMA_MAX_TRANSFER_SIZE)
+    {
+        return enStatusInvArgs;
+    }
+    if ((txData != NULL && pfGpdmaIsAccessible(txData, size) != enBooleanTrue) ||
+        (rxData != NULL && pfGpdmaIsAccessible(rxData, size) != enBooleanTrue))
+    {
+        return enStatusNotSupported;
+    }
+    if (spi0DmaStatus == enStatusBusy)
+    {
+        return enStatusBusy;
+    }
+
+    // Frames left over from byte transfers would be taken as the first received bytes
+    while ((SPI0_CHANNEL->SR & SSP_SR_BSY) != 0);
+    while ((SPI0_CHANNEL->SR & SSP_SR_RNE) != 0)
+    {
+        dummy = SPI0_CHANNEL->DR;
+    }
+    (void)dummy;
+    SPI0_CHANNEL->ICR = SSP_ICR_RORIC;
+
+    rx.srcAddr = (PFdword)&SPI0_CHANNEL->DR;
+    rx.destAddr = (rxData != NULL) ? (PFdword)rxData : (PFdword)&spi0DmaDummyRx;
+    rx.size = size;
+    rx.transferType = enGpdmaPeriphToMem;
+    rx.srcConn = enGpdmaConnSsp0Rx;
+    rx.destConn = enGpdmaConnMemory;
+    rx.srcWidth = enGpdmaWidth_8;
+    rx.destWidth = enGpdmaWidth_8;
+    rx.srcBurst = enGpdmaBurst_4;
+    rx.destBurst = enGpdmaBurst_4;
+    rx.srcIncrement = enBooleanFalse;
+    rx.destIncrement = (rxData != NULL) ? enBooleanTrue : enBooleanFalse;
+    rx.lli = NULL;
+    rx.callback = spi0DmaRxDone;
+
+    tx.srcAddr = (txData != NULL) ? (PFdword)txData : (PFdword)&spi0DmaDummyTx;
+    tx.destAddr = (PFdword)&SPI0_CHANNEL->DR;
+    tx.size = size;
+    tx.transferType = enGpdmaMemToPeriph;
+    tx.srcConn = enGpdmaConnMemory;
+    tx.destConn = enGpdmaConnSsp0Tx;
+    tx.srcWidth = enGpdmaWidth_8;
+    tx.destWidth = enGpdmaWidth_8;
+    tx.srcBurst = enGpdmaBurst_4;
+    tx.destBurst = enGpdmaBurst_4;
+    tx.srcIncrement = (txData != NULL) ? enBooleanTrue : enBooleanFalse;
+    tx.destIncrement = enBooleanFalse;
+    tx.lli = NULL;
+    tx.callback = spi0DmaTxDone;
+
+    spi0DmaCallback = callback;
+    spi0DmaStatus = enStatusBusy;
+
+    status = pfGpdmaStart(spi0DmaRxChannel, &rx);
+    if (status == enStatusSuccess)
+    {
+        status = pfGpdmaStart(spi0DmaTxChannel, &tx);
+        if (status != enStatusSuccess)
+        {
+            pfGpdmaStop(spi0DmaRxChannel);
+        }
+    }
+    if (status != enStatusSuccess)
+    {
+        spi0DmaStatus = status;
+        return status;
+    }
+
+    SPI0_CHANNEL->DMACR = SSP_DMACR_RXDMAE | SSP_DMACR_TXDMAE;
+    return enStatusSuccess;
+}
+
+PFEnBoolean pfSpi0DmaIsBusy(void)
+{
+    return (spi0DmaStatus == enStatusBusy) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFEnStatus pfSpi0DmaGetStatus(void)
+{
+    return spi0DmaStatus;
+}
+
+PFEnStatus pfSpi0DmaTransfer(PFbyte* txData, PFbyte* rxData, PFdword size, PFcallback waitCallback)
+{
+    PFEnStatus status;
+    PFdword primask;
+
+    status = pfSpi0DmaStart(txData, rxData, size, NULL);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+
+    primask = __get_PRIMASK();
+    while (spi0DmaStatus == enStatusBusy)
+    {
+        if (waitCallback != NULL)
+        {
+            waitCallback();
+        }
+        else if (primask == 0)
+        {
+            // Sleeps until an interrupt, the one of the DMA completes the transfer. Interrupts are
+            // masked around the check so that the end of the transfer cannot come before the WFI.
+            __disable_irq();
+            if (spi0DmaStatus == enStatusBusy)
+            {
+                __WFI();
+            }
+            __enable_irq();
+        }
+    }
+    return spi0DmaStatus;
+}
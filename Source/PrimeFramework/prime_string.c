@@ -0,0 +1,518 @@
+/**
+ *  \file       prime_string.c
+ *  \brief      Prime Framework String Functions.
+ *
+ *  The memory functions move whole words once the destination is aligned. When the source is
+ *  aligned as well, copies are done in blocks of 16 bytes with LDM/STM; otherwise the source words
+ *  are loaded unaligned, which the Cortex-M3 does in hardware. Remaining bytes are moved one at a time.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_string.h"
+
+#define STRING_TOKEN_SIZE           256     /* Longest string pfStringTokenize() works on, including the terminating zero */
+#define STRING_WORD_MASK            0x03
+
+/* Word at any address */
+typedef struct
+{
+    PFdword value;
+}PF_C_PACKED StringUnalignedWord;
+
+static PFbyte tokString[STRING_TOKEN_SIZE];
+static PFword tokStart = 0;
+static PFword tokPosition = 0;
+static PFword tokLength = 0;
+
+/* Copies 16 bytes from an aligned source to an aligned destination, advancing both pointers */
+PF_C_STATIC_INLINE void stringCopyBlock(PFdword** dest, const PFdword** src)
+{
+#if defined(__GNUC__) && defined(__thumb2__)
+    PF_C_ASM volatile ("ldmia %1!, {r3-r6}\n\t"
+                       "stmia %0!, {r3-r6}"
+                       : "+r" (*dest), "+r" (*src) : : "r3", "r4", "r5", "r6", "memory");
+#else
+    (*dest)[0] = (*src)[0];
+    (*dest)[1] = (*src)[1];
+    (*dest)[2] = (*src)[2];
+    (*dest)[3] = (*src)[3];
+    *dest += 4;
+    *src += 4;
+#endif
+}
+
+/* Sets num bytes from an aligned destination to a word of the fill value, returns the bytes left over */
+static PFdword stringSetWords(PFdword** dest, PFdword value, PFdword num)
+{
+    PFdword* words = *dest;
+
+    while (num >= 16)
+    {
+        words[0] = value;
+        words[1] = value;
+        words[2] = value;
+        words[3] = value;
+        words += 4;
+        num -= 16;
+    }
+    while (num >= 4)
+    {
+        *words++ = value;
+        num -= 4;
+    }
+
+    *dest = words;
+    return num;
+}
+
+PFbyte* pfStringTokenize(char* str, const char* token)
+{
+    PFword strIndex = 0, tokIndex = 0, i;
+    PFEnBoolean found = enBooleanFalse;
+
+    if (token == NULL)
+    {
+        return NULL;
+    }
+
+    tokPosition++;
+    tokStart = tokPosition;
+    if (str != NULL)
+    {
+        tokLength = 0;
+        tokStart = 0;
+        tokPosition = 0;
+        while (str[tokLength] != 0 && tokLength < STRING_TOKEN_SIZE - 1)
+        {
+            tokString[tokLength] = str[tokLength];
+            tokLength++;
+        }
+        tokString[tokLength] = 0;
+    }
+
+    while (tokString[tokPosition] != 0)
+    {
+        tokIndex = 0;
+        strIndex = tokPosition;
+        while (tokString[strIndex] == (PFbyte)token[tokIndex])
+        {
+            tokIndex++;
+            strIndex++;
+            if (tokString[strIndex] == 0)
+            {
+                break;
+            }
+            if (token[tokIndex] == 0)
+            {
+                found = enBooleanTrue;
+                break;
+            }
+        }
+
+        if (found == enBooleanTrue)
+        {
+            for (i = 0; i < tokIndex; i++)
+            {
+                tokString[tokPosition + i] = 0;
+            }
+            return &tokString[tokStart];
+        }
+
+        tokPosition++;
+        if (tokPosition >= tokLength)
+        {
+            return &tokString[tokStart];
+        }
+    }
+    return NULL;
+}
+
+PFdword pfStrLen(const char* str)
+{
+    PFdword length = 0;
+
+    if (str == NULL)
+    {
+        return 0;
+    }
+    while (str[length] != 0)
+    {
+        length++;
+    }
+    return length;
+}
+
+PFdword pfStrCopy(char* dest, const char* src)
+{
+    PFdword count = 0;
+
+    if (dest == NULL || src == NULL)
+    {
+        return 0;
+    }
+    while (src[count] != 0)
+    {
+        dest[count] = src[count];
+        count++;
+    }
+    return count;
+}
+
+PFEnStatus pfStrReverse(char* str)
+{
+    PFbyte start = 0, end;
+    char temp;
+
+    if (str == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (str[0] == 0)
+    {
+        return enStatusSuccess;
+    }
+
+    end = (PFbyte)pfStrLen(str) - 1;
+    while (start < end)
+    {
+        temp = str[start];
+        str[start] = str[end];
+        str[end] = temp;
+        start++;
+        end--;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfMemCopy(void* dest, const void* src, PFdword num)
+{
+    PFbyte* destByte = (PFbyte*)dest;
+    const PFbyte* srcByte = (const PFbyte*)src;
+    PFdword* destWord;
+    const PFdword* srcWord;
+
+    if (src == NULL || dest == NULL || num == 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    while (((PFdword)destByte & STRING_WORD_MASK) != 0 && num != 0)
+    {
+        *destByte++ = *srcByte++;
+        num--;
+    }
+
+    destWord = (PFdword*)destByte;
+    if (((PFdword)srcByte & STRING_WORD_MASK) == 0)
+    {
+        srcWord = (const PFdword*)srcByte;
+        while (num >= 16)
+        {
+            stringCopyBlock(&destWord, &srcWord);
+            num -= 16;
+        }
+        while (num >= 4)
+        {
+            *destWord++ = *srcWord++;
+            num -= 4;
+        }
+        srcByte = (const PFbyte*)srcWord;
+    }
+    else
+    {
+        while (num >= 4)
+        {
+            *destWord++ = ((const StringUnalignedWord*)srcByte)->value;
+            srcByte += 4;
+            num -= 4;
+        }
+    }
+
+    destByte = (PFbyte*)destWord;
+    while (num != 0)
+    {
+        *destByte++ = *srcByte++;
+        num--;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfMemMove(void* dest, const void* src, PFdword num)
+{
+    PFbyte* destByte = (PFbyte*)dest;
+    const PFbyte* srcByte = (const PFbyte*)src;
+
+    if (src == NULL || dest == NULL || num == 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    // A forward copy reads every byte before it is overwritten unless the destination starts inside the source
+    if (destByte <= srcByte || destByte >= srcByte + num)
+    {
+        return pfMemCopy(dest, src, num);
+    }
+
+    destByte += num;
+    srcByte += num;
+    while (((PFdword)destByte & STRING_WORD_MASK) != 0 && num != 0)
+    {
+        *--destByte = *--srcByte;
+        num--;
+    }
+    while (num >= 4)
+    {
+        destByte -= 4;
+        srcByte -= 4;
+        *(PFdword*)destByte = ((const StringUnalignedWord*)srcByte)->value;
+        num -= 4;
+    }
+    while (num != 0)
+    {
+        *--destByte = *--srcByte;
+        num--;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfMemSet(void* ptr, PFbyte value, PFdword num)
+{
+    PFbyte* destByte = (PFbyte*)ptr;
+    PFdword* destWord;
+
+    if (ptr == NULL || num == 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    while (((PFdword)destByte & STRING_WORD_MASK) != 0 && num != 0)
+    {
+        *destByte++ = value;
+        num--;
+    }
+
+    destWord = (PFdword*)destByte;
+    num = stringSetWords(&destWord, value * 0x01010101UL, num);
+
+    destByte = (PFbyte*)destWord;
+    while (num != 0)
+    {
+        *destByte++ = value;
+        num--;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfMemSet16(void* ptr, PFword value, PFdword num)
+{
+    PFword* destHalf = (PFword*)ptr;
+    PFdword* destWord;
+
+    if (ptr == NULL || num == 0 || ((PFdword)ptr & 0x01) != 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    if (((PFdword)destHalf & STRING_WORD_MASK) != 0)
+    {
+        *destHalf++ = value;
+        num--;
+    }
+
+    destWord = (PFdword*)destHalf;
+    num = stringSetWords(&destWord, value | ((PFdword)value << 16), num * 2) / 2;
+
+    if (num != 0)
+    {
+        *(PFword*)destWord = value;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfMemSet32(void* ptr, PFdword value, PFdword num)
+{
+    PFdword* destWord = (PFdword*)ptr;
+
+    if (ptr == NULL || num == 0 || ((PFdword)ptr & STRING_WORD_MASK) != 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    stringSetWords(&destWord, value, num * 4);
+    return enStatusSuccess;
+}
+
+PFEnBoolean pfMemCompare(const void* ptr1, const void* ptr2, PFdword num)
+{
+    const PFbyte* byte1 = (const PFbyte*)ptr1;
+    const PFbyte* byte2 = (const PFbyte*)ptr2;
+    PFdword i;
+
+    if (ptr1 == NULL || ptr2 == NULL || num == 0)
+    {
+        return enBooleanFalse;
+    }
+    for (i = 0; i < num; i++)
+    {
+        if (byte1[i] != byte2[i])
+        {
+            return enBooleanFalse;
+        }
+    }
+    return enBooleanTrue;
+}
+
+PFEnStatus pfFtoA(PFfloat x, char* p)
+{
+    PFfloat value, fraction;
+    PFsdword whole, digits = 0, decimals = 0, written = 0, number, digit, i;
+
+    if (p == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    value = x;
+    whole = (PFsdword)x;
+    fraction = value - (PFfloat)whole;
+    if (whole == 0)
+    {
+        digits = 1;
+        p[0] = '0';
+    }
+    while (whole > 0)
+    {
+        x = x / 10;
+        whole = (PFsdword)x;
+        digits++;
+    }
+    p[digits] = '.';
+
+    while (written != digits)
+    {
+        number = (PFsdword)value;
+        for (i = 0; i <= digits - 2; i++)
+        {
+            number = number / 10;
+            p[digits - i - 2] = (char)(number % 10 + '0');
+        }
+        p[0] = (char)(number + '0');
+        p[digits - 1] = (char)((PFsdword)value % 10 + '0');
+        written = digits;
+    }
+
+    // Up to 3 decimals, at least 2
+    while (fraction != 0)
+    {
+        fraction = fraction * 10;
+        digit = (PFsdword)fraction;
+        fraction = fraction - (PFfloat)digit;
+        p[digits + decimals + 1] = (char)(digit + '0');
+        p[digits + decimals + 2] = '0';
+        p[digits + decimals + 3] = 0;
+        p[digits + decimals + 4] = 0;
+        decimals++;
+        if (decimals == 3)
+        {
+            fraction = 0;
+        }
+    }
+    if (decimals == 0)
+    {
+        for (decimals = 0; decimals <= 1; decimals++)
+        {
+            p[digits + decimals + 1] = '0';
+            p[digits + decimals + 3] = 0;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfAtoI(const char* str, PFdword* num)
+{
+    PFdword value = 0;
+
+    if (str == NULL || num == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    while (*str != 0)
+    {
+        value = value * 10 + (PFbyte)*str - '0';
+        str++;
+    }
+    *num = value;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfAtoF(const char* str, PFfloat* num)
+{
+    PFfloat value = 0;
+    PFword length = (PFword)pfStrLen(str);
+    PFbyte decimals = 0, i;
+
+    if (str == NULL || num == NULL)
+    {
+        return enStatusInvArgs;
+    }
+
+    i = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+    for (; i < length; i++)
+    {
+        if (str[i] == '.')
+        {
+            decimals = (PFbyte)(length - i - 1);
+        }
+        else
+        {
+            value = value * 10.0 + (str[i] - '0');
+        }
+    }
+    while (decimals-- != 0)
+    {
+        value = value / 10;
+    }
+    if (str[0] == '-')
+    {
+        value = -value;
+    }
+    *num = value;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfItoA(PFsdword num, char* str)
+{
+    PFsdword sign = num;
+    PFdword count = 0;
+
+    if (str == NULL || num == 0)
+    {
+        return enStatusInvArgs;
+    }
+
+    if (num < 0)
+    {
+        num = -num;
+    }
+    do
+    {
+        str[count++] = (char)(num % 10 + '0');
+        num = num / 10;
+    } while (num > 0);
+    if (sign < 0)
+    {
+        str[count++] = '-';
+    }
+    str[count] = 0;
+
+    return pfStrReverse(str);
+}
@@ -0,0 +1,91 @@
+/**
+ *  \file       prime_tick.c
+ *  \brief      Prime Framework Time Tick APIs
+ *
+ *  timeTick is incremented by pfTickUpdate() from the interrupt of the timer set up by the
+ *  application, and read by everything else. It is a single word, so reads need no lock.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_tick.h"
+
+static volatile PFdword timeTick = 0;
+static PFdword timerPeriodMs = 0;
+
+void pfTickSetTimerPeriod(PFdword timerPeriod)
+{
+    timerPeriodMs = timerPeriod;
+}
+
+void pfTickUpdate(void)
+{
+    timeTick++;
+}
+
+void pfTickAdd(PFdword ticks)
+{
+    timeTick += ticks;
+}
+
+void pfTickReset(void)
+{
+    timeTick = 0;
+}
+
+PFdword pfTickGet(void)
+{
+    return timeTick;
+}
+
+PFdword pfTickMsToTicks(PFdword time)
+{
+    if (timerPeriodMs == 0)
+    {
+        return 0;
+    }
+    // A timeout is at least one tick away
+    if (time < timerPeriodMs)
+    {
+        time = timerPeriodMs;
+    }
+    return time / timerPeriodMs;
+}
+
+PFdword pfTickSetTimeoutMs(PFdword time)
+{
+    if (timerPeriodMs == 0)
+    {
+        return 0;
+    }
+    return timeTick + pfTickMsToTicks(time);
+}
+
+PFEnBoolean pfTickCheckTimeout(PFdword timeoutTick)
+{
+    if (timerPeriodMs == 0)
+    {
+        return enBooleanTrue;
+    }
+    return (timeoutTick <= timeTick) ? enBooleanTrue : enBooleanFalse;
+}
+
+void pfTickDelayMs(PFdword delayMs)
+{
+    PFdword timeout;
+
+    if (timerPeriodMs == 0)
+    {
+        return;
+    }
+    timeout = pfTickSetTimeoutMs(delayMs);
+    while (pfTickCheckTimeout(timeout) == enBooleanFalse);
+}
@@ -0,0 +1,237 @@
+/**
+ *  \file       prime_timer.c
+ *  \brief      Software timers.
+ *
+ *  timerNow is the next tick the wheel handles. A timer expiring within PF_TIMER_SLOTS ticks of it is
+ *  in the level 0 slot of its expiry tick, otherwise in level n, in the slot given by the expiry tick
+ *  shifted by n * PF_TIMER_SLOT_BITS. When the index of level n - 1 goes back to 0, the current slot of
+ *  level n is emptied and its timers are put in again, which moves them down. Each slot is a doubly
+ *  linked list through the descriptors, so a timer is removed without looking for it.
+ *
+ *  The expired timers of a tick are moved to timerExpired before their callbacks are called, so a
+ *  callback can stop or start any timer, including one which is about to be called.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+#include "prime_utils.h"
+#include "prime_tick.h"
+#include "prime_timer.h"
+
+#define TIMER_SLOT_MASK             (PF_TIMER_SLOTS - 1)
+#define TIMER_SLOT(tick, level)     (((tick) >> (PF_TIMER_SLOT_BITS * (level))) & TIMER_SLOT_MASK)
+
+/* Ticks reached by the levels up to the given one */
+#define TIMER_RANGE(level)          (1UL << (PF_TIMER_SLOT_BITS * ((level) + 1)))
+
+static PFTimer* timerWheel[PF_TIMER_LEVELS][PF_TIMER_SLOTS];
+static PFTimer* timerExpired = NULL;
+static PFdword timerNow = 0;
+static PFEnBoolean timerInit = enBooleanFalse;
+static PFcallback timerNotify = NULL;
+
+PF_C_STATIC_INLINE void timerLink(PFTimer** ppHead, PFTimer* timer)
+{
+    timer->pNext = *ppHead;
+    if (timer->pNext != NULL)
+    {
+        timer->pNext->ppPrev = &timer->pNext;
+    }
+    timer->ppPrev = ppHead;
+    *ppHead = timer;
+}
+
+PF_C_STATIC_INLINE void timerUnlink(PFTimer* timer)
+{
+    *timer->ppPrev = timer->pNext;
+    if (timer->pNext != NULL)
+    {
+        timer->pNext->ppPrev = timer->ppPrev;
+    }
+    timer->ppPrev = NULL;
+}
+
+/* Puts a timer in the slot of its expiry tick */
+static void timerInsert(PFTimer* timer)
+{
+    PFdword delta = timer->expires - timerNow;
+    PFdword expires = timer->expires;
+    PFbyte level;
+
+    if ((PFsdword)delta < 0)
+    {
+        // Expired while the wheel was behind, handled with the next tick
+        delta = 0;
+        expires = timerNow;
+    }
+    for (level = 0; level < PF_TIMER_LEVELS - 1 && delta >= TIMER_RANGE(level); level++);
+    if (delta >= TIMER_RANGE(level))
+    {
+        // Out of the wheel, it is put in again when the top level reaches this slot
+        expires = timerNow + TIMER_RANGE(level) - 1;
+    }
+    timerLink(&timerWheel[level][TIMER_SLOT(expires, level)], timer);
+}
+
+/* Moves the timers of a slot to the levels below */
+static void timerCascade(PFbyte level, PFdword slot)
+{
+    PFTimer* timer = timerWheel[level][slot];
+    PFTimer* next;
+
+    timerWheel[level][slot] = NULL;
+    while (timer != NULL)
+    {
+        next = timer->pNext;
+        timerInsert(timer);
+        timer = next;
+    }
+}
+
+/* Tells whether a timer is in a level above 0 */
+static PFEnBoolean timerUpperUsed(void)
+{
+    PFbyte level;
+    PFdword slot;
+
+    for (level = 1; level < PF_TIMER_LEVELS; level++)
+    {
+        for (slot = 0; slot < PF_TIMER_SLOTS; slot++)
+        {
+            if (timerWheel[level][slot] != NULL)
+            {
+                return enBooleanTrue;
+            }
+        }
+    }
+    return enBooleanFalse;
+}
+
+void pfTimerInit(void)
+{
+    pfMemSet(timerWheel, 0, sizeof(timerWheel));
+    timerExpired = NULL;
+    timerNow = pfTickGet();
+    timerInit = enBooleanTrue;
+}
+
+PFEnStatus pfTimerStart(PFTimer* timer, PFTimerCallback callback, void* context, PFdword timeMs, PFEnBoolean periodic)
+{
+    PFdword ticks = pfTickMsToTicks(timeMs);
+
+    if (timer == NULL || callback == NULL)
+    {
+        return enStatusInvArgs;
+    }
+    if (timerInit != enBooleanTrue || ticks == 0)
+    {
+        return enStatusNotConfigured;
+    }
+
+    if (timer->ppPrev != NULL)
+    {
+        timerUnlink(timer);
+    }
+    timer->callback = callback;
+    timer->context = context;
+    timer->expires = pfTickGet() + ticks;
+    timer->period = (periodic == enBooleanTrue) ? ticks : 0;
+    timerInsert(timer);
+    if (timerNotify != NULL)
+    {
+        timerNotify();
+    }
+    return enStatusSuccess;
+}
+
+void pfTimerStop(PFTimer* timer)
+{
+    if (timer->ppPrev != NULL)
+    {
+        timerUnlink(timer);
+    }
+}
+
+PFEnBoolean pfTimerIsRunning(const PFTimer* timer)
+{
+    return (timer->ppPrev != NULL) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFdword pfTimerProcess(void)
+{
+    PFdword tick = pfTickGet();
+    PFdword fired = 0;
+    PFTimer** ppSlot;
+    PFTimer* timer;
+    PFbyte level;
+
+    if (timerInit != enBooleanTrue)
+    {
+        return 0;
+    }
+
+    while ((PFsdword)(tick - timerNow) >= 0)
+    {
+        for (level = 1; level < PF_TIMER_LEVELS && TIMER_SLOT(timerNow, level - 1) == 0; level++)
+        {
+            timerCascade(level, TIMER_SLOT(timerNow, level));
+        }
+
+        ppSlot = &timerWheel[0][TIMER_SLOT(timerNow, 0)];
+        timerExpired = *ppSlot;
+        if (timerExpired != NULL)
+        {
+            timerExpired->ppPrev = &timerExpired;
+        }
+        *ppSlot = NULL;
+        timerNow++;
+
+        while ((timer = timerExpired) != NULL)
+        {
+            timerUnlink(timer);
+            if (timer->period != 0)
+            {
+                timer->expires += timer->period;
+                timerInsert(timer);
+            }
+            timer->callback(timer);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+PFdword pfTimerGetIdleTicks(void)
+{
+    PFdword tick = pfTickGet();
+    PFdword next, slot;
+
+    if (timerInit != enBooleanTrue)
+    {
+        return PF_TIMER_NO_EXPIRY;
+    }
+
+    // Level 0 holds the timers of the next PF_TIMER_SLOTS ticks, and the others move down at its slot 0
+    for (next = timerNow; next != timerNow + PF_TIMER_SLOTS; next++)
+    {
+        slot = TIMER_SLOT(next, 0);
+        if (timerWheel[0][slot] != NULL || (slot == 0 && timerUpperUsed() == enBooleanTrue))
+        {
+            return ((PFsdword)(next - tick) > 0) ? next - tick : 0;
+        }
+    }
+    return PF_TIMER_NO_EXPIRY;
+}
+
+void pfTimerSetNotify(PFcallback notify)
+{
+    timerNotify = notify;
+}
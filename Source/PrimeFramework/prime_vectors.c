@@ -0,0 +1,184 @@
+/**
+ *  \file       prime_vectors.c
+ *  \brief      Vector table and startup code of the LPC17xx.
+ *
+ *  ResetHandler sets the vector table address, initializes the RAM sections and calls main(). The
+ *  sections are given by the copy and zero tables which the linker script builds in flash, so a new
+ *  initialized or cleared section is added in the linker script only. The copy table holds .data and
+ *  the .ramfunc functions of PF_RAMFUNC, the zero table .bss and the .ahbbss variables of PF_AHB_BSS.
+ *
+ *  The handlers of this file are weak, an interrupt without a handler in the application stops in an
+ *  endless loop of its own, which the debugger shows by name.
+ *
+ *  \copyright  Copyright (c) 2014 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include "prime_framework.h"
+
+/* Copy table entry, a section loaded in flash and run in RAM */
+typedef struct
+{
+    const PFdword* load;
+    PFdword* start;
+    PFdword* end;
+}VectorsCopyEntry;
+
+/* Zero table entry, a section cleared in RAM */
+typedef struct
+{
+    PFdword* start;
+    PFdword* end;
+}VectorsZeroEntry;
+
+/* Symbols of the linker script */
+extern PFdword _stext;
+extern PFdword _estack;
+extern const VectorsCopyEntry __copy_table_start__[];
+extern const VectorsCopyEntry __copy_table_end__[];
+extern const VectorsZeroEntry __zero_table_start__[];
+extern const VectorsZeroEntry __zero_table_end__[];
+
+int main(void);
+
+#define VECTORS_DEFAULT_HANDLER(name)   void __attribute__((weak)) name(void) { while(1); }
+
+VECTORS_DEFAULT_HANDLER(NMI_Handler)
+VECTORS_DEFAULT_HANDLER(HardFault_Handler)
+VECTORS_DEFAULT_HANDLER(MemManage_Handler)
+VECTORS_DEFAULT_HANDLER(BusFault_Handler)
+VECTORS_DEFAULT_HANDLER(UsageFault_Handler)
+VECTORS_DEFAULT_HANDLER(SVC_Handler)
+VECTORS_DEFAULT_HANDLER(DebugMon_Handler)
+VECTORS_DEFAULT_HANDLER(PendSV_Handler)
+VECTORS_DEFAULT_HANDLER(SysTick_Handler)
+VECTORS_DEFAULT_HANDLER(WDT_IRQHandler)
+VECTORS_DEFAULT_HANDLER(TIMER0_IRQHandler)
+VECTORS_DEFAULT_HANDLER(TIMER1_IRQHandler)
+VECTORS_DEFAULT_HANDLER(TIMER2_IRQHandler)
+VECTORS_DEFAULT_HANDLER(TIMER3_IRQHandler)
+VECTORS_DEFAULT_HANDLER(UART0_IRQHandler)
+VECTORS_DEFAULT_HANDLER(UART1_IRQHandler)
+VECTORS_DEFAULT_HANDLER(UART2_IRQHandler)
+VECTORS_DEFAULT_HANDLER(UART3_IRQHandler)
+VECTORS_DEFAULT_HANDLER(PWM_IRQHandler)
+VECTORS_DEFAULT_HANDLER(I2C0_IRQHandler)
+VECTORS_DEFAULT_HANDLER(I2C1_IRQHandler)
+VECTORS_DEFAULT_HANDLER(I2C2_IRQHandler)
+VECTORS_DEFAULT_HANDLER(SPI_IRQHandler)
+VECTORS_DEFAULT_HANDLER(SSP0_IRQHandler)
+VECTORS_DEFAULT_HANDLER(SSP1_IRQHandler)
+VECTORS_DEFAULT_HANDLER(PLL0_IRQHandler)
+VECTORS_DEFAULT_HANDLER(RTC_IRQHandler)
+VECTORS_DEFAULT_HANDLER(EINT0_IRQHandler)
+VECTORS_DEFAULT_HANDLER(EINT1_IRQHandler)
+VECTORS_DEFAULT_HANDLER(EINT2_IRQHandler)
+VECTORS_DEFAULT_HANDLER(EINT3_IRQHandler)
+VECTORS_DEFAULT_HANDLER(ADC_IRQHandler)
+VECTORS_DEFAULT_HANDLER(BOD_IRQHandler)
+VECTORS_DEFAULT_HANDLER(USB_IRQHandler)
+VECTORS_DEFAULT_HANDLER(CAN_IRQHandler)
+VECTORS_DEFAULT_HANDLER(DMA_IRQHandler)
+VECTORS_DEFAULT_HANDLER(I2S_IRQHandler)
+VECTORS_DEFAULT_HANDLER(ENET_IRQHandler)
+VECTORS_DEFAULT_HANDLER(RIT_IRQHandler)
+VECTORS_DEFAULT_HANDLER(MCPWM_IRQHandler)
+VECTORS_DEFAULT_HANDLER(QEI_IRQHandler)
+
+/* The checksum entry is written by the flash programming tool */
+const PFcallback gVectors[] __attribute__((section(".vectors"), used)) =
+{
+    (PFcallback)&_estack,       // Initial stack pointer
+    ResetHandler,
+    NMI_Handler,
+    HardFault_Handler,
+    MemManage_Handler,
+    BusFault_Handler,
+    UsageFault_Handler,
+    0,                          // Checksum of the first 8 entries
+    0,
+    0,
+    0,
+    SVC_Handler,
+    DebugMon_Handler,
+    0,
+    PendSV_Handler,
+    SysTick_Handler,
+    WDT_IRQHandler,
+    TIMER0_IRQHandler,
+    TIMER1_IRQHandler,
+    TIMER2_IRQHandler,
+    TIMER3_IRQHandler,
+    UART0_IRQHandler,
+    UART1_IRQHandler,
+    UART2_IRQHandler,
+    UART3_IRQHandler,
+    PWM_IRQHandler,
+    I2C0_IRQHandler,
+    I2C1_IRQHandler,
+    I2C2_IRQHandler,
+    SPI_IRQHandler,
+    SSP0_IRQHandler,
+    SSP1_IRQHandler,
+    PLL0_IRQHandler,
+    RTC_IRQHandler,
+    EINT0_IRQHandler,
+    EINT1_IRQHandler,
+    EINT2_IRQHandler,
+    EINT3_IRQHandler,
+    ADC_IRQHandler,
+    BOD_IRQHandler,
+    USB_IRQHandler,
+    CAN_IRQHandler,
+    DMA_IRQHandler,
+    I2S_IRQHandler,
+    ENET_IRQHandler,
+    RIT_IRQHandler,
+    MCPWM_IRQHandler,
+    QEI_IRQHandler
+};
+
+/* Copies the sections of a copy table from flash to RAM */
+static void vectorsCopy(const VectorsCopyEntry* entry, const VectorsCopyEntry* end)
+{
+    const PFdword* src;
+    PFdword* dest;
+
+    for (; entry < end; entry++)
+    {
+        src = entry->load;
+        for (dest = entry->start; dest < entry->end; dest++)
+        {
+            *dest = *src++;
+        }
+    }
+}
+
+/* Clears the sections of a zero table */
+static void vectorsZero(const VectorsZeroEntry* entry, const VectorsZeroEntry* end)
+{
+    PFdword* dest;
+
+    for (; entry < end; entry++)
+    {
+        for (dest = entry->start; dest < entry->end; dest++)
+        {
+            *dest = 0;
+        }
+    }
+}
+
+void ResetHandler(void)
+{
+    SCB->VTOR = (PFdword)&_stext;
+    vectorsCopy(__copy_table_start__, __copy_table_end__);
+    vectorsZero(__zero_table_start__, __zero_table_end__);
+    main();
+    while(1);
+}
@@ -13,7 +13,18 @@ int main()
   gfxSetWindow(0,0,239,319);
   gfxFillRGB(WHITE);
   gfxDrawString(20,30, "Welcome to Phi Education\n",enGfxFont_8X16,BLACK, WHITE);
+  bootMarkFirstFrame();
 
-  while(1);
+  //SDcard and accelerometer, after the first frame
+  while(bootRunBackground() == enStatusBusy);
+
+  //Sleeps with WFI until an interrupt or the next software timer, a touch wakes the CPU
+  while(1)
+  {
+    pfTimerProcess();
+    __disable_irq();
+    pfIdleSleep(pfTimerGetIdleTicks());
+    __enable_irq();
+  }
   return 0;
 }
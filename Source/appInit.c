@@ -5,21 +5,24 @@
  *  Call appInit() function in your application program in the beginning to initialize the peripherals
  *  required in the project.
  *
- *  appInit() function initializes the following peripherals:
- *  1.  System Clock
- *  2.  UART for debugging purpose
- *  3.  RIT timer and Tick module for delay generation
- *  4.  Timer0 for Renderer Manager periodic callback
- *  5.  SPI0 for SDcard and Touch panel
- *  6.  I2C0 for Accelerometer device
- *  7.  Buzzer
- *  8.  LCD
- *  9.  Touch panel
- *  10. Accelerometer(MMA7660) device
- *	11. External interrupt for Touch panel
- *	12. Keypad
- *	13. SDcard
- *	14. Fat file system for storing files on the SDcard
+ *  appInit() function initializes the system clock, the GPIO pins, UART and trace logger for debugging
+ *  purpose, then the other peripherals in boot stages of the boot manager:
+ *  1.  RIT timer, Tick module for delay generation, software timers and tickless idle sleep
+ *  2.  LCD
+ *  3.  Timer0 for Renderer Manager periodic callback
+ *  4.  SPI0, SPI0 bus arbiter and GPDMA for SDcard and Touch panel
+ *  5.  Touch panel and its external interrupt
+ *  6.  SDcard and Fat file system for storing files on the SDcard, in the background
+ *  7.  I2C0 and Accelerometer(MMA7660) device, in the background
+ *  8.  Keypad
+ *  9.  Buzzer
+ *  A failure of stages 1 to 5 stops the program. The other stages are optional, the application checks
+ *  them with bootRequire() before using their devices. The keypad and the buzzer only set up GPIO
+ *  pins, so they are run with the foreground stages and are ready for the Game Engine, which does
+ *  not know the boot stages.
+ *
+ *  Touch panel and SDcard share SPI0 through the SPI bus arbiter, which switches the SPI0 clock
+ *  rate and mode to the profile of the selected device.
  */
 
 #include "appInit.h"
@@ -38,6 +41,20 @@ void extIntTouchCallback(void);
 */
 void lcdRenderer(void);
 
+/*
+*  \brief Tells whether the commands of the last frame were run by lcdRenderer().
+*/
+PFEnBoolean lastFrameRendered(void);
+
+/*
+ * \brief Idle suspend and resume callbacks. Timer0 is masked while the CPU sleeps if there is no frame to
+ * render, so that it does not wake the CPU every 8ms for nothing.
+ */
+static void idleSuspend(void);
+static void idleResume(void);
+
+PFcallback appTouchHook = NULL;
+
 /*********************************Clock Configuration******************************************/
 PFCfgClk clkConfig = 
 {
@@ -57,6 +74,14 @@ PFCfgRit ritConfig =
 	enBooleanTrue			// Reset on match
 };
 
+/*********************************Idle sleep Configuration***********************************/
+PFCfgIdle idleConfig =
+{
+	1000,					// Sleep at most 1s, the RIT compare value stays small
+	idleSuspend,			// Masks Timer0 when no frame is waiting
+	idleResume				// Unmasks Timer0
+};
+
 /*******************************TIMER0 Configuration*******************************************/
 PFCfgTimer0 timer0Config =
 {
@@ -74,11 +99,20 @@ PFCfgTimer0 timer0Config =
 PFCfgUart0 uart0Config = 
 {
 	enPclkDiv_4, 			// PCLK divider, PCLK_peripheral = CCLK/4
-	enUart0Baudrate_9600, 	// 9600 baudrate
+	enUart0Baudrate_115200, // 115200 baudrate
 	enUart0Databits_8, 		// 8 data bits
 	enUart0ParityNone, 		// No parity
 	enUart0StopBits_1,		// 1 stop bit
-	enUart0IntNone			// No interrupt
+	enUart0IntTx			// Transmit interrupt, writes only fill the transmit buffer
+};
+
+/*******************************Trace logger Configuration************************************/
+CfgTrace traceConfig =
+{
+	pfUart0Write,				// Records are written to the UART0 transmit buffer
+	pfUart0GetTxBufferSize,
+	pfUart0GetTxBufferCount,
+	pfIdleGetCycles				// Timestamps in CPU cycles, going on while the scheduler idle function sleeps
 };
 
 /*******************************SPI Configuration for SDcard and Touch panel*********************/
@@ -92,6 +126,22 @@ PFCfgSpi0 spi0Cfg =
 	enSpi0IntNone			// No interrupt
 };
 
+/*******************************SPI0 bus arbiter profiles for SDcard and Touch panel*************/
+SpiBusProfile spiBusProfiles[2] =
+{
+	// Touch controller, slow clock. Its queued reads may preempt SDcard transfers between blocks.
+	{{EDUARM_TOUCH_SSP_0_SSEL_PORT, EDUARM_TOUCH_SSP_0_SSEL_PIN}, 2000000, enSpi0Mode_0, enBooleanTrue},
+	// SDcard, fastest clock of the SSP0 channel
+	{{EDUARM_SDCARD_SSP_0_SSEL_PORT, EDUARM_SDCARD_SSP_0_SSEL_PIN}, 25000000, enSpi0Mode_0, enBooleanFalse}
+};
+
+CfgSpiBus spiBusCfg =
+{
+	spiBusProfiles,			// Device profiles
+	2,						// Number of device profiles
+	NULL					// Sleep until the DMA interrupt ends a block transfer
+};
+
 /******************************I2C Configuration for Accelerometer device *********************/
 #define 	EDUARM_MMA_I2C_0_SDA_PORT		GPIO_PORT_0
 #define 	EDUARM_MMA_I2C_0_SDA_PIN		GPIO_PIN_27
@@ -174,10 +224,10 @@ CfgTouch touchConfig =
 	{EDUARM_TOUCH_SSP_0_SSEL_PORT, EDUARM_TOUCH_SSP_0_SSEL_PIN},	// Touch chip select pin
 	enTouchReferenceSelect_Differential,							// Differential reference select
 	enTouchPrecision_12bit,											// 12 bit precision
-	pfSpi0RegisterDevice,				// Function pointer for SPI register device
-	pfSpi0ChipSelect,					// Function pointer for SPI chip select
-	pfSpi0Write,						// Function pointer for SPI write
-	pfSpi0Read							// Function pointer for SPI read
+	spiBusRegisterDevice,				// Function pointer for SPI register device
+	spiBusChipSelect,					// Function pointer for SPI chip select
+	spiBusSubmit,						// Function pointer for SPI transaction submit, a sample is one urgent transaction
+	spiBusService						// Function pointer for SPI service, runs the sample if the bus is free
 };
 
 /******************************EINT1(Touch) Configuration**********************************/
@@ -207,12 +257,14 @@ CfgMmc mmcCfg =
 	 {0,0},			                    								// GPIO pin used for device detection
 	enBooleanFalse,					    // Power control option for MMC card
 	enBooleanFalse,						// Card detect option for MMC card
-	pfSpi0RegisterDevice,				// Function pointer to SPI register device
-	pfSpi0UnregisterDevice,				// Function pointer to SPI unregister device
-	pfSpi0ChipSelect,					// Function pointer to SPI chip select
-	pfSpi0ExchangeByte,					// Function pointer to SPI exchange byte
-	pfSpi0Write,						// Function pointer to SPI read
-	pfSpi0Read							// Function pointer to SPI write
+	spiBusRegisterDevice,				// Function pointer to SPI register device
+	spiBusUnregisterDevice,				// Function pointer to SPI unregister device
+	spiBusChipSelect,					// Function pointer to SPI chip select
+	spiBusExchangeByte,					// Function pointer to SPI exchange byte
+	spiBusWrite,						// Function pointer to SPI read
+	spiBusRead,							// Function pointer to SPI write
+	spiBusYield,						// Function pointer to SPI yield, lets touch reads in between SDcard data blocks
+	spiBusDmaTransfer					// Function pointer to SPI DMA block transfer, used for sectors in AHB RAM
 };
 
 /****************************DISKIO  Configuration****************************************/
@@ -228,13 +280,47 @@ CfgDisk diskCfg =
 	enBooleanTrue						// Set device IO control permission
 };
 
-/** File system object structure */
-static FatFs fat;
+/** File system object structure, placed in AHB RAM so that its sector window is read and written by DMA */
+static FatFs fat PF_GPDMA_BUFFER;
+
+/*****************************Boot stages************************************************/
+static PFEnStatus bootTickStage(void);
+static PFEnStatus bootLcdStage(void);
+static PFEnStatus bootTimer0Stage(void);
+static PFEnStatus bootSpiStage(void);
+static PFEnStatus bootTouchStage(void);
+static PFEnStatus bootSdcardStage(void);
+static PFEnStatus bootAccelStage(void);
+static PFEnStatus bootKeypadStage(void);
+static PFEnStatus bootBuzzerStage(void);
+static void bootStageDone(PFbyte stage, PFEnStatus status, PFdword duration);
+
+// Indexed by AppBootStage
+const BootStage appBootStages[enAppBootCount] =
+{
+	{bootTickStage,		enBootModeForeground,	enBooleanTrue},		// Delays of the LCD driver need the tick
+	{bootLcdStage,		enBootModeForeground,	enBooleanTrue},
+	{bootTimer0Stage,	enBootModeForeground,	enBooleanTrue},
+	{bootSpiStage,		enBootModeForeground,	enBooleanTrue},
+	{bootTouchStage,	enBootModeForeground,	enBooleanTrue},
+	{bootSdcardStage,	enBootModeBackground,	enBooleanFalse},	// Card start up and mount take the longest
+	{bootAccelStage,	enBootModeBackground,	enBooleanFalse},
+	{bootKeypadStage,	enBootModeForeground,	enBooleanFalse},	// GPIO pins only, ready when the Game Engine starts
+	{bootBuzzerStage,	enBootModeForeground,	enBooleanFalse}
+};
+
+CfgBoot bootConfig =
+{
+	appBootStages,			// Stage table
+	enAppBootCount,			// Number of stages
+	pfIdleGetCycles,		// Times in CPU cycles, with the time asleep in the scheduler idle function
+	bootStageDone			// Records the time of each stage in the trace
+};
 
 void appInit(void)
 {
 	PFEnStatus status;
-	PFbyte diskId;
+	PFbyte stage;
 	
 	//CPU clock initialization
 	pfSysSetCpuClock(&clkConfig);
@@ -255,163 +341,246 @@ void appInit(void)
 	{
 		while(1);
 	}
+	traceOpen(&traceConfig);
+	DEBUG_TRACE(enTraceBoot, pfSysGetCpuClock(), 0);
+
+	//The other devices are initialized in stages. The foreground stages are run now, and the application
+	//runs the background stages after its first frame with bootRunBackground().
+	bootOpen(&bootConfig);
+	status = bootRunForeground(&stage);
+	if(status != enStatusSuccess)
+	{
+		//The application cannot run without this device
+		DEBUG_TRACE(enTraceBootFailed, stage, status);
+		traceDrain();
+		while(1);
+	}
+    
+	DEBUG_TRACE(enTraceBootDone, pfTickSetTimeoutMs(0), 0);
+	DEBUG_WRITE("\n\nWelcome to Phi Education.\n");
+	traceDrain();
+}
+
+static PFEnStatus bootTickStage(void)
+{
+	PFEnStatus status;
 
 	//RIT Peripheral initialization
 	status = pfRitOpen(&ritConfig);
 	if(status != enStatusSuccess)
 	{
 		DEBUG_WRITE("\nRIT initialization failed.");
-		while(1);
+		return status;
 	}
-	else
-	{
-		DEBUG_WRITE("\nRIT initialized.");
-	}		
+	DEBUG_TRACE(enTraceRitInit, 0, 0);
     pfRitStart();								//Starting RIT timer
 
     //Initializing tick module. It is used for generating delay in the program.
     //Use pfTickDelayMs(delayMs) function to generate delay in the program. Pass delayMs value in milliseconds.
     pfTickSetTimerPeriod(1);					//Set tick timer period to 1ms
-	
+    pfTimerInit();								//Software timers, advanced by pfTimerProcess() from the main loop
+    status = pfIdleOpen(&idleConfig);			//Tick correction for the sleep of the scheduler idle function
+	if(status != enStatusSuccess)
+	{
+		DEBUG_WRITE("\nIdle initialization failed.");
+	}
+#if PF_PROF_ENABLE
+    pfProfInit();								//Cycle counter of the profiler sections
+#endif
+	return enStatusSuccess;
+}
+
+static PFEnStatus bootLcdStage(void)
+{
+	PFEnStatus status;
+
+	//LCD initialization
+	status  = gfxOpen(&lcdDisplayConfig);
+	if(status != enStatusSuccess)
+	{
+		DEBUG_WRITE("\nLCD initialization failed.");
+		return status;
+	}
+	DEBUG_TRACE(enTraceLcdInit, 0, 0);
+	return enStatusSuccess;
+}
+
+static PFEnStatus bootTimer0Stage(void)
+{
+	PFEnStatus status;
+
 	//Timer Peripheral initialization
     status = pfTimer0Open(&timer0Config);
 	if(status != enStatusSuccess)
 	{
 		DEBUG_WRITE("\nTimer0 initialization failed.");
-		while(1);
-	}
-	else
-	{
-		DEBUG_WRITE("\nTimer0 initialized.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceTimer0Init, 0, 0);
 	pfTimer0Start();							//Starting Timer0
+	return enStatusSuccess;
+}
+
+static PFEnStatus bootSpiStage(void)
+{
+	PFEnStatus status;
 
 	//SPI0 initialization
 	status = pfSpi0Open((PFpCfgSpi0)&spi0Cfg);
 	if(status != enStatusSuccess)
 	{
 		DEBUG_WRITE("\nSPI0 initialization failed.");
-		while(1);
-	}
-	else
-	{
-		DEBUG_WRITE("\nSPI0 initialized.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceSpi0Init, 0, 0);
 
-	//I2C0 initialization
-	status = pfI2c0Open((PFpCfgI2c0)&i2c0Cfg);
+	//SPI0 bus arbiter initialization, must be done before Touch panel and SDcard register on the bus
+	status = spiBusOpen(&spiBusCfg);
 	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nI2C0 initialization failed.");
-		while(1);
-	}
-	else
-	{
-		DEBUG_WRITE("\nI2C0 initialized.");
+		DEBUG_WRITE("\nSPI0 bus arbiter initialization failed.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceSpiBusInit, 0, 0);
 
-	//Buzzer initialization
-	status = buzzerOpen(&buzzerConfig);
+	//GPDMA initialization
+	status = pfGpdmaOpen();
 	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nBuzzer initialization failed.");
-		while(1);
-	}
-	else
-	{
-		DEBUG_WRITE("\nBuzzer initialized.");
+		DEBUG_WRITE("\nGPDMA initialization failed.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceGpdmaInit, 0, 0);
 
-	//LCD initialization
-	status  = gfxOpen(&lcdDisplayConfig);
+	//SPI0 DMA mode initialization, used by SDcard for sector data
+	status = pfSpi0DmaOpen();
 	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nLCD initialization failed.");
-		while(1);
+		DEBUG_WRITE("\nSPI0 DMA initialization failed.");
+		return status;
 	}
-	else
-	{
-		DEBUG_WRITE("\nLCD initialized.");
-	}
-		
+	DEBUG_TRACE(enTraceSpi0DmaInit, 0, 0);
+	return enStatusSuccess;
+}
+
+static PFEnStatus bootTouchStage(void)
+{
+	PFEnStatus status;
+
 	//Touch panel initialization
 	status = touchOpen(&touchConfig);
 	if(status != enStatusSuccess)
 	{
 		DEBUG_WRITE("\nTouch panel initialization failed.");
-		while(1);
+		return status;
 	}
-	else
+	DEBUG_TRACE(enTraceTouchInit, 0, 0);
+
+	//External Interrupt initialization
+	//External interrupt is initialized but the interrupt is disabled right now.
+	//Use pfEint1Enable() function to enable the interrupt. After enabling this interrupt whenever
+	//a touch is detected on the touch panel, extIntTouchCallback() function gets called, which
+	//calls appTouchHook. The interrupt also wakes the CPU from the idle sleep.
+    status = pfEint1Open(&extIntTouchConfig);
+	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nTouch panel initialized.");
+		DEBUG_WRITE("\nTouch External interrupt initialization failed.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceEint1Init, 0, 0);
+	NVIC_SetPriority (EINT1_IRQn, 1);
+	return enStatusSuccess;
+}
 
-	//Accelerometer initialization
-	status = mma7660Open(&accelConfig);
+static PFEnStatus bootSdcardStage(void)
+{
+	PFEnStatus status;
+	PFbyte diskId;
+
+	//SDcard initialization
+	status = diskOpen(&diskId, (pCfgDisk)&diskCfg);
 	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nAccelerometer initialization failed.");
-		while(1);
+		DEBUG_WRITE("\nDiskIO initialization failed.");
+		return status;
 	}
-	else
+	DEBUG_TRACE(enTraceDiskInit, 0, 0);
+
+	//FAT file system initialization
+	status = fsMount(DRIVE_NUM, &fat);
+	if(status!= enStatusSuccess)
 	{
-		DEBUG_WRITE("\nAcceleromter initialized.");
+		DEBUG_WRITE("\nFatFS initialization failed.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceFatInit, 0, 0);
+	return enStatusSuccess;
+}
 
-	//External Interrupt initialization
-	//External interrupt is initialized but the interrupt is disabled right now.
-	//Use pfEint1Enable() function to enable the interrupt. After enabling this interrupt whenever
-	//a touch is detected on the touch panel, extIntTouchCallback() function gets called.
-	//Call touchAvailable() function in the callback to get touch coordinates.
-    status = pfEint1Open(&extIntTouchConfig);
+static PFEnStatus bootAccelStage(void)
+{
+	PFEnStatus status;
+
+	//I2C0 initialization
+	status = pfI2c0Open((PFpCfgI2c0)&i2c0Cfg);
 	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nTouch External interrupt initialization failed.");
-		while(1);
+		DEBUG_WRITE("\nI2C0 initialization failed.");
+		return status;
 	}
-	else
+	DEBUG_TRACE(enTraceI2c0Init, 0, 0);
+
+	//Accelerometer initialization
+	status = mma7660Open(&accelConfig);
+	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nTouch External interrupt initialized.");
+		DEBUG_WRITE("\nAccelerometer initialization failed.");
+		return status;
 	}
-	NVIC_SetPriority (EINT1_IRQn, 1);
+	DEBUG_TRACE(enTraceAccelInit, 0, 0);
+	return enStatusSuccess;
+}
+
+static PFEnStatus bootKeypadStage(void)
+{
+	PFEnStatus status;
 
 	//Keypad initialization
     status = keypadKeyOpen(keypadKeyPortPin, 5);
 	if(status != enStatusSuccess)
 	{
 		DEBUG_WRITE("\nKeypad initialization failed.");
-		while(1);
-	}
-	else
-	{
-		DEBUG_WRITE("\nKeypad initialized.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceKeypadInit, 0, 0);
+	return enStatusSuccess;
+}
 
-	//SDcard initialization
-	status = diskOpen(&diskId, (pCfgDisk)&diskCfg);
+static PFEnStatus bootBuzzerStage(void)
+{
+	PFEnStatus status;
+
+	//Buzzer initialization
+	status = buzzerOpen(&buzzerConfig);
 	if(status != enStatusSuccess)
 	{
-		DEBUG_WRITE("\nDiskIO initialization failed.");
-		while(1);
-	}
-	else
-	{
-		DEBUG_WRITE("\nDiskIO initialized.");
+		DEBUG_WRITE("\nBuzzer initialization failed.");
+		return status;
 	}
+	DEBUG_TRACE(enTraceBuzzerInit, 0, 0);
+	return enStatusSuccess;
+}
 
-	//FAT file system initialization
-	status = fsMount(DRIVE_NUM, &fat);
-	if(status!= enStatusSuccess)
+static void bootStageDone(PFbyte stage, PFEnStatus status, PFdword duration)
+{
+	if(status == enStatusSuccess)
 	{
-		DEBUG_WRITE("\nFatFS initialization failed.");
-		while(1);
+		DEBUG_TRACE(enTraceBootStage, stage, duration);
 	}
 	else
 	{
-		DEBUG_WRITE("\nFatFS initialized.");
+		DEBUG_TRACE(enTraceBootFailed, stage, status);
 	}
-    
-	DEBUG_WRITE("\n\nWelcome to Phi Education.\n");
 }
 
 //This function gets called when there is a touch detected on the LCD screen and the
@@ -419,4 +588,21 @@ void appInit(void)
 void extIntTouchCallback(void)
 {
 	//DEBUG_WRITE("\nExtTouchInt");
+	if(appTouchHook != NULL)
+	{
+		appTouchHook();
+	}
+}
+
+static void idleSuspend(void)
+{
+	if(lastFrameRendered() == enBooleanTrue)
+	{
+		NVIC_DisableIRQ(TIMER0_IRQn);
+	}
+}
+
+static void idleResume(void)
+{
+	NVIC_EnableIRQ(TIMER0_IRQn);
 }
@@ -0,0 +1,64 @@
+/**
+ *  \file       test.h
+ *  \brief      Assertions of the host tests.
+ *
+ *  Each test is one program built with the native gcc, see Test/makefile. A failed check prints its
+ *  location and the test goes on, TEST_EXIT() gives the exit code of the program.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+#pragma once
+
+#include <stdio.h>
+
+static int testChecks = 0;
+static int testFailures = 0;
+
+/** Checks that a condition is true */
+#define TEST_ASSERT(cond)                                                                       \
+    do                                                                                          \
+    {                                                                                           \
+        testChecks++;                                                                           \
+        if (!(cond))                                                                            \
+        {                                                                                       \
+            testFailures++;                                                                     \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                     \
+        }                                                                                       \
+    } while (0)
+
+/** Checks that two integer values are equal */
+#define TEST_ASSERT_EQUAL(expected, actual)                                                     \
+    do                                                                                          \
+    {                                                                                           \
+        long long testExpected = (long long)(expected), testActual = (long long)(actual);       \
+        testChecks++;                                                                           \
+        if (testExpected != testActual)                                                         \
+        {                                                                                       \
+            testFailures++;                                                                     \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual,           \
+                   testActual, testExpected);                                                   \
+        }                                                                                       \
+    } while (0)
+
+/** Runs a test function */
+#define TEST_RUN(test)                                                                          \
+    do                                                                                          \
+    {                                                                                           \
+        printf("- %s\n", #test);                                                                \
+        test();                                                                                 \
+    } while (0)
+
+/** Prints the result and returns the exit code, to be used at the end of main() */
+#define TEST_EXIT()                                                                             \
+    do                                                                                          \
+    {                                                                                           \
+        printf("%s: %d checks, %d failed\n", __FILE__, testChecks, testFailures);               \
+        return (testFailures != 0) ? 1 : 0;                                                     \
+    } while (0)
@@ -0,0 +1,464 @@
+/**
+ *  \file       testBmpSave.c
+ *  \brief      Host test and benchmark of the incremental BMP save.
+ *
+ *  The LCD is a screen in memory and the files of the file system are temporary files of the host,
+ *  the FatFs module itself only being built for the board. A save is run by bmpSaveStart() and
+ *  bmpSaveStep() to completion while touch strokes are drawn on the toolbar between the steps, as the
+ *  main loop does, and the file is compared byte for byte with a BMP written by the test. Every write
+ *  but the last has to be a whole chunk at a chunk boundary. A write which fails is retried by the
+ *  next step, the name of the file is the first free image_<n>.bmp and an aborted save deletes its
+ *  file. The time of the save and of its longest step is printed.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "prime_tick.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "bmpSave.h"
+#include "test.h"
+
+#define TEST_WIDTH              240
+#define TEST_HEIGHT             320
+#define TEST_TOOLBAR_HEIGHT     45
+#define TEST_FILES              4
+#define TEST_FILE_SIZE          (BMP_SAVE_HEADER_SIZE + TEST_HEIGHT * (TEST_WIDTH * 2 + 4))
+#define TEST_STROKES_PER_STEP   3
+
+/* File of the file system */
+typedef struct
+{
+    char name[BMP_SAVE_NAME_SIZE];
+    FILE* host;
+    PFdword size;
+}TestFile;
+
+static PFword testScreen[TEST_HEIGHT][TEST_WIDTH];
+static TestFile testFiles[TEST_FILES];
+static TestFile* testOpenFile;
+static PFdword testExpandSize;
+static PFdword testWrites, testOddWrites, testFailWrite = 0xFFFFFFFF;
+static PFdword testStrokes;
+static PFbyte testExpected[TEST_FILE_SIZE];
+static PFbyte testWritten[TEST_FILE_SIZE];
+
+// LCD
+
+/* The board reads the row from one pixel left of xValue, bmpSaveStep() passes x + 1 */
+PFEnStatus readBackground(PFword xValue, PFword yValue, PFword width, PFword height, PFword* backgroundData, PFword size)
+{
+    PFword x, y;
+    PFdword index = 0;
+
+    if ((PFdword)width * height > size)
+    {
+        return enStatusNoMem;
+    }
+    for (y = yValue; y <= yValue + height; y++)
+    {
+        for (x = xValue; x <= xValue + width; x++)
+        {
+            backgroundData[index++] = (x - 1 < TEST_WIDTH) ? testScreen[y][x - 1] : 0;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFdword pfSprintf(PFchar* outstr, const PFchar* fmt, ...)
+{
+    va_list args;
+    int length;
+
+    va_start(args, fmt);
+    length = vsprintf((char*)outstr, (const char*)fmt, args);
+    va_end(args);
+    return (PFdword)length;
+}
+
+// File system
+
+static TestFile* testFind(const XCHAR* path)
+{
+    PFdword k;
+
+    for (k = 0; k < TEST_FILES; k++)
+    {
+        if (testFiles[k].host != NULL && strcmp(testFiles[k].name, (const char*)path) == 0)
+        {
+            return &testFiles[k];
+        }
+    }
+    return NULL;
+}
+
+static TestFile* testCreate(const char* name)
+{
+    TestFile* file = testFind((const XCHAR*)name);
+    PFdword k;
+
+    for (k = 0; file == NULL && k < TEST_FILES; k++)
+    {
+        if (testFiles[k].host == NULL)
+        {
+            file = &testFiles[k];
+        }
+    }
+    if (file == NULL)
+    {
+        return NULL;
+    }
+    if (file->host != NULL)
+    {
+        fclose(file->host);
+    }
+    strncpy(file->name, name, BMP_SAVE_NAME_SIZE - 1);
+    file->host = tmpfile();
+    file->size = 0;
+    return (file->host != NULL) ? file : NULL;
+}
+
+static void testRemoveAll(void)
+{
+    PFdword k;
+
+    for (k = 0; k < TEST_FILES; k++)
+    {
+        if (testFiles[k].host != NULL)
+        {
+            fclose(testFiles[k].host);
+        }
+    }
+    memset(testFiles, 0, sizeof(testFiles));
+}
+
+PFEnStatus fsFileOpen(FsFile* fp, const XCHAR* path, PFbyte mode)
+{
+    TestFile* file = testFind(path);
+
+    if (testOpenFile != NULL)
+    {
+        return enStatusBusy;
+    }
+    if (file == NULL || (mode & FA_CREATE_ALWAYS) != 0)
+    {
+        file = testCreate((const char*)path);
+        if (file == NULL)
+        {
+            return enStatusAccessDenied;
+        }
+    }
+    memset(fp, 0, sizeof(FsFile));
+    fp->flag = mode & (FA_READ | FA_WRITE);
+    fp->fsize = file->size;
+    testOpenFile = file;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileWrite(FsFile* fp, const void* pBuf, PFdword btw, PFdword* bw)
+{
+    *bw = 0;
+    if (testOpenFile == NULL)
+    {
+        return enStatusInvalidObject;
+    }
+    // A failed write may leave part of the data written and the file pointer moved
+    if (testWrites++ == testFailWrite)
+    {
+        fseek(testOpenFile->host, (long)fp->fptr, SEEK_SET);
+        fwrite(pBuf, 1, btw / 2, testOpenFile->host);
+        fp->fptr += btw / 2;
+        return enStatusDiskError;
+    }
+    if ((fp->fptr % BMP_SAVE_CHUNK_SIZE) != 0 || btw != BMP_SAVE_CHUNK_SIZE)
+    {
+        testOddWrites++;
+    }
+    fseek(testOpenFile->host, (long)fp->fptr, SEEK_SET);
+    *bw = (PFdword)fwrite(pBuf, 1, btw, testOpenFile->host);
+    fp->fptr += *bw;
+    if (fp->fptr > fp->fsize)
+    {
+        fp->fsize = fp->fptr;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeek(FsFile* fp, PFdword ofs)
+{
+    fp->fptr = ofs;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileExpand(FsFile* fp, PFdword size)
+{
+    (void)fp;
+    testExpandSize = size;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileClose(FsFile* fp)
+{
+    if (testOpenFile == NULL)
+    {
+        return enStatusInvalidObject;
+    }
+    if (fp->fsize > testOpenFile->size)
+    {
+        testOpenFile->size = fp->fsize;
+    }
+    fflush(testOpenFile->host);
+    testOpenFile = NULL;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileDelete(const XCHAR* path)
+{
+    TestFile* file = testFind(path);
+
+    if (file == NULL)
+    {
+        return enStatusNoFile;
+    }
+    fclose(file->host);
+    memset(file, 0, sizeof(TestFile));
+    return enStatusSuccess;
+}
+
+// Test
+
+static void testStore32(PFbyte* ptr, PFdword value)
+{
+    ptr[0] = (PFbyte)value;
+    ptr[1] = (PFbyte)(value >> 8);
+    ptr[2] = (PFbyte)(value >> 16);
+    ptr[3] = (PFbyte)(value >> 24);
+}
+
+/* BMP of the area as saveImage() writes it: 16 bit pixels, bottom row first, rows padded to 4 bytes */
+static PFdword testMakeBmp(PFword x, PFword y, PFword width, PFword height)
+{
+    PFdword rowSize = ((PFdword)width * 2 + 3) & ~3UL, size = BMP_SAVE_HEADER_SIZE + rowSize * height;
+    PFbyte* ptr = &testExpected[BMP_SAVE_HEADER_SIZE];
+    PFword row, column;
+
+    memset(testExpected, 0, size);
+    testExpected[0] = 'B';
+    testExpected[1] = 'M';
+    testStore32(&testExpected[2], size);
+    testStore32(&testExpected[10], BMP_SAVE_HEADER_SIZE);
+    testStore32(&testExpected[14], 40);
+    testStore32(&testExpected[18], width);
+    testStore32(&testExpected[22], height);
+    testExpected[26] = 1;
+    testExpected[28] = 16;
+    testStore32(&testExpected[34], rowSize * height);
+    for (row = y + height; row-- != y;)
+    {
+        for (column = 0; column < width; column++)
+        {
+            ptr[2 * column] = (PFbyte)testScreen[row][x + column];
+            ptr[2 * column + 1] = (PFbyte)(testScreen[row][x + column] >> 8);
+        }
+        ptr += rowSize;
+    }
+    return size;
+}
+
+/* A canvas with strokes and a toolbar of colored boxes */
+static void testFillScreen(void)
+{
+    PFword x, y;
+
+    for (y = 0; y < TEST_HEIGHT; y++)
+    {
+        for (x = 0; x < TEST_WIDTH; x++)
+        {
+            testScreen[y][x] = (y < TEST_TOOLBAR_HEIGHT) ? (PFword)(x / 30 * 0x1111) :
+                               ((rand() % 8) == 0) ? (PFword)rand() : 0xFFFF;
+        }
+    }
+}
+
+/* Touch work of the main loop between two steps, a point of a stroke on the toolbar */
+static void testTouch(void)
+{
+    PFword x = rand() % TEST_WIDTH, y = rand() % TEST_TOOLBAR_HEIGHT;
+
+    testScreen[y][x] = (PFword)rand();
+    testStrokes++;
+}
+
+static PFEnBoolean testSameFile(const char* name, PFdword size)
+{
+    TestFile* file = testFind((const XCHAR*)name);
+
+    if (file == NULL || file->size != size)
+    {
+        return enBooleanFalse;
+    }
+    rewind(file->host);
+    return (fread(testWritten, 1, size, file->host) == size && memcmp(testWritten, testExpected, size) == 0) ?
+           enBooleanTrue : enBooleanFalse;
+}
+
+static double testSeconds(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Saves the area with touch work between the steps, returns the file size */
+static PFdword testSave(BmpSaveJob* job, CfgBmpSave* config)
+{
+    struct timespec start, stepStart, end;
+    PFEnStatus status;
+    PFdword steps = 0, k, size;
+    double longest = 0, step;
+
+    size = testMakeBmp(config->x, config->y, config->width, config->height);
+    testWrites = 0;
+    testOddWrites = 0;
+    testStrokes = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpSaveStart(job, config));
+    do
+    {
+        clock_gettime(CLOCK_MONOTONIC, &stepStart);
+        status = bmpSaveStep(job);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        step = testSeconds(&stepStart, &end);
+        longest = (step > longest) ? step : longest;
+        steps++;
+        for (k = 0; k < TEST_STROKES_PER_STEP; k++)
+        {
+            testTouch();
+        }
+    } while (status == enStatusBusy);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, status);
+    TEST_ASSERT(job->state == enBmpSaveDone);
+    TEST_ASSERT(testOpenFile == NULL);
+    TEST_ASSERT_EQUAL(size, testExpandSize);
+    TEST_ASSERT(testSameFile((const char*)job->fileName, size) == enBooleanTrue);
+    // Only the last write is not a whole chunk
+    TEST_ASSERT(testOddWrites <= 1);
+    TEST_ASSERT_EQUAL((size + BMP_SAVE_CHUNK_SIZE - 1) / BMP_SAVE_CHUNK_SIZE, testWrites);
+    TEST_ASSERT_EQUAL(steps * TEST_STROKES_PER_STEP, testStrokes);
+    printf("  %3ux%-3u %2u rows per step: %6u bytes in %3u steps, %7.1f us, longest step %5.1f us\n",
+           config->width, config->height, config->rowsPerStep, (unsigned)size, (unsigned)steps,
+           testSeconds(&start, &end) * 1e6, longest * 1e6);
+    return size;
+}
+
+static void testCanvas(void)
+{
+    static BmpSaveJob job;
+    static const PFword rowsPerStep[] = {1, 4, 16, 275};
+    CfgBmpSave config = {0, TEST_TOOLBAR_HEIGHT, TEST_WIDTH, TEST_HEIGHT - TEST_TOOLBAR_HEIGHT, 1,
+                         (const PFchar*)"canvas.bmp", NULL};
+    PFdword k;
+
+    testRemoveAll();
+    for (k = 0; k < sizeof(rowsPerStep) / sizeof(rowsPerStep[0]); k++)
+    {
+        testFillScreen();
+        config.rowsPerStep = rowsPerStep[k];
+        testSave(&job, &config);
+    }
+
+    // Odd widths have padded rows
+    config.x = 3;
+    config.width = 101;
+    config.height = 77;
+    config.rowsPerStep = 5;
+    testSave(&job, &config);
+    config.width = 1;
+    testSave(&job, &config);
+}
+
+/* A write which fails is done again by the next step from the start of the chunk */
+static void testRetry(void)
+{
+    static BmpSaveJob job;
+    CfgBmpSave config = {0, TEST_TOOLBAR_HEIGHT, TEST_WIDTH, TEST_HEIGHT - TEST_TOOLBAR_HEIGHT, 8,
+                         (const PFchar*)"retry.bmp", NULL};
+    PFEnStatus status;
+    PFdword size, failures = 0;
+
+    testRemoveAll();
+    testFillScreen();
+    size = testMakeBmp(config.x, config.y, config.width, config.height);
+    testWrites = 0;
+    testFailWrite = 20;
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpSaveStart(&job, &config));
+    do
+    {
+        status = bmpSaveStep(&job);
+        failures += (status == enStatusDiskError);
+    } while (status == enStatusBusy || status == enStatusDiskError);
+    testFailWrite = 0xFFFFFFFF;
+    TEST_ASSERT_EQUAL(enStatusSuccess, status);
+    TEST_ASSERT_EQUAL(1, failures);
+    TEST_ASSERT(testSameFile("retry.bmp", size) == enBooleanTrue);
+}
+
+/* The first free image_<n>.bmp is used, an aborted save deletes its file */
+static void testNames(void)
+{
+    static BmpSaveJob job;
+    CfgBmpSave config = {0, 0, 20, 10, 2, NULL, NULL};
+    TestFile* file;
+
+    testRemoveAll();
+    testFillScreen();
+    file = testCreate("image_0.bmp");
+    file->size = 100;
+    testCreate("image_1.bmp");
+    testSave(&job, &config);
+    TEST_ASSERT(strcmp((const char*)job.fileName, "image_1.bmp") == 0);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpSaveStart(&job, &config));
+    TEST_ASSERT(strcmp((const char*)job.fileName, "image_2.bmp") == 0);
+    TEST_ASSERT_EQUAL(enStatusBusy, bmpSaveStep(&job));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpSaveAbort(&job));
+    TEST_ASSERT(testFind((const XCHAR*)"image_2.bmp") == NULL);
+    TEST_ASSERT(testOpenFile == NULL);
+    TEST_ASSERT_EQUAL(enStatusInvState, bmpSaveStep(&job));
+}
+
+static void testInvalid(void)
+{
+    static BmpSaveJob job;
+    CfgBmpSave config = {0, 0, BMP_SAVE_MAX_WIDTH + 1, 10, 2, (const PFchar*)"bad.bmp", NULL};
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bmpSaveStart(&job, &config));
+    config.width = 10;
+    config.rowsPerStep = 0;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bmpSaveStart(&job, &config));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bmpSaveStep(NULL));
+}
+
+int main(void)
+{
+    srand(1);
+    pfTickSetTimerPeriod(1);
+    TEST_RUN(testCanvas);
+    TEST_RUN(testRetry);
+    TEST_RUN(testNames);
+    TEST_RUN(testInvalid);
+    testRemoveAll();
+    TEST_EXIT();
+}
@@ -0,0 +1,425 @@
+/**
+ *  \file       testBmpStream.c
+ *  \brief      Host test and benchmark of the BMP image streamer.
+ *
+ *  The image file is a buffer in memory and fsFileForward() passes it to the streamer a sector at a
+ *  time from the sector window, as the tiny FatFs does, so with a data offset which is not a multiple
+ *  of the pixel size pixels are split between two calls. The LCD is a screen in memory with the
+ *  window, the address counter and the entry mode of the controller, written by a counting
+ *  gfxWriteData(). Images of 16 and 24 bit pixels, stored bottom row first and top row first, are drawn
+ *  and compared pixel by pixel with the image. The time of a draw and the high water of the stack below
+ *  the draw, of the carry of a split pixel and of the data passed at once are printed.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "test.h"
+
+#define TEST_WIDTH              240
+#define TEST_HEIGHT             320
+#define TEST_SECTOR_SIZE        512
+#define TEST_FILE_SIZE          (128 + TEST_HEIGHT * (TEST_WIDTH * 3 + 4))
+#define TEST_BACKGROUND         0x5AA5
+
+// LCD
+
+static PFword testScreen[TEST_HEIGHT][TEST_WIDTH];
+static PFword testX1, testY1, testX2, testY2, testCursorX, testCursorY;
+static PFword testEntryMode = 0x1030;
+static EnGfxOrientation testOrientation = enGfxOrientation_0;
+static PFdword testWrites, testOutside;
+static char* testStackTop;
+static PFdword testStackDepth;
+
+PFEnStatus gfxGetOrientation(EnGfxOrientation* orient)
+{
+    *orient = testOrientation;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetWidth(PFword* width)
+{
+    *width = TEST_WIDTH;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetHeight(PFword* height)
+{
+    *height = TEST_HEIGHT;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetWindow(PFword x1, PFword y1, PFword x2, PFword y2)
+{
+    testX1 = x1;
+    testY1 = y1;
+    testX2 = x2;
+    testY2 = y2;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetAreaMax(void)
+{
+    return gfxSetWindow(0, 0, TEST_WIDTH - 1, TEST_HEIGHT - 1);
+}
+
+PFEnStatus gfxSetCursor(PFword x, PFword y)
+{
+    testCursorX = x;
+    testCursorY = y;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxCommand(PFword reg, PFword data)
+{
+    if (reg == 0x03)
+    {
+        testEntryMode = data;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxWriteCmd(PFword reg)
+{
+    (void)reg;
+    return enStatusSuccess;
+}
+
+/* Writes at the address counter, which runs right and then down or, with bit 5 of the mode clear, up */
+PFEnStatus gfxWriteData(PFword data)
+{
+    PFdword depth = (PFdword)(testStackTop - (char*)__builtin_frame_address(0));
+
+    testStackDepth = (depth > testStackDepth) ? depth : testStackDepth;
+    testWrites++;
+    if (testCursorX < testX1 || testCursorX > testX2 || testCursorY < testY1 || testCursorY > testY2)
+    {
+        testOutside++;
+        return enStatusSuccess;
+    }
+    testScreen[testCursorY][testCursorX] = data;
+    if (testCursorX++ == testX2)
+    {
+        testCursorX = testX1;
+        if ((testEntryMode & 0x0020) != 0)
+        {
+            testCursorY = (testCursorY == testY2) ? testY1 : testCursorY + 1;
+        }
+        else
+        {
+            testCursorY = (testCursorY == testY1) ? testY2 : testCursorY - 1;
+        }
+    }
+    return enStatusSuccess;
+}
+
+/* Swaps the red and blue fields of a 16 bit pixel */
+PFword bgrToRgb(PFword color)
+{
+    return (PFword)(((color & 0x001F) << 11) | (color & 0x07E0) | (color >> 11));
+}
+
+#include "../Source/AppHelper/bmpImage.c"
+
+// File system
+
+static PFbyte testFile[TEST_FILE_SIZE];
+static PFdword testFileSize;
+static PFdword testForwardLargest, testCarryLargest, testLinkMaps;
+
+PFEnStatus fsFileOpen(FsFile* fp, const XCHAR* path, PFbyte mode)
+{
+    (void)path;
+    memset(fp, 0, sizeof(FsFile));
+    fp->flag = mode;
+    fp->fsize = testFileSize;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileRead(FsFile* fp, void* pBuf, PFdword btr, PFdword* br)
+{
+    *br = (fp->fptr + btr > fp->fsize) ? fp->fsize - fp->fptr : btr;
+    memcpy(pBuf, &testFile[fp->fptr], *br);
+    fp->fptr += *br;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeek(FsFile* fp, PFdword ofs)
+{
+    fp->fptr = (ofs > fp->fsize) ? fp->fsize : ofs;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeekFast(FsFile* fp, const PFdword* map, PFdword ofs)
+{
+    (void)map;
+    return fsFileSeek(fp, ofs);
+}
+
+PFEnStatus fsFileLinkMap(FsFile* fp, PFdword* map)
+{
+    (void)fp;
+    map[1] = 1;
+    testLinkMaps++;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileClose(FsFile* fp)
+{
+    (void)fp;
+    return enStatusSuccess;
+}
+
+/* Passes the data up to the end of the sector of the file pointer at a time, after asking if the stream is ready */
+PFEnStatus fsFileForward(FsFile* fp, PFdword (*func)(const PFbyte*, PFdword), PFdword btr, PFdword* bf)
+{
+    PFdword count, done;
+
+    *bf = 0;
+    if (btr > fp->fsize - fp->fptr)
+    {
+        btr = fp->fsize - fp->fptr;
+    }
+    while (btr != 0 && func(NULL, 0) != 0)
+    {
+        count = TEST_SECTOR_SIZE - fp->fptr % TEST_SECTOR_SIZE;
+        count = (count > btr) ? btr : count;
+        done = func(&testFile[fp->fptr], count);
+        testForwardLargest = (done > testForwardLargest) ? done : testForwardLargest;
+        testCarryLargest = (bmpImageStream.carryCount > testCarryLargest) ? bmpImageStream.carryCount :
+                           testCarryLargest;
+        fp->fptr += done;
+        *bf += done;
+        btr -= done;
+        if (done != count)
+        {
+            break;
+        }
+    }
+    return enStatusSuccess;
+}
+
+// Test
+
+static PFword testImage[TEST_HEIGHT][TEST_WIDTH];
+
+static void testStore32(PFbyte* ptr, PFdword value)
+{
+    ptr[0] = (PFbyte)value;
+    ptr[1] = (PFbyte)(value >> 8);
+    ptr[2] = (PFbyte)(value >> 16);
+    ptr[3] = (PFbyte)(value >> 24);
+}
+
+/* Random image in the file and its pixels in RGB format in testImage, a negative height is stored top row first */
+static void testMakeBmp(PFword width, PFsdword height, PFword bits, PFdword offset)
+{
+    PFword rows = (PFword)((height < 0) ? -height : height), bytes = bits / 8, row, column, y;
+    PFdword rowSize = ((PFdword)width * bytes + 3) & ~3UL;
+    PFbyte* ptr = &testFile[offset];
+
+    memset(testFile, 0, sizeof(testFile));
+    testFile[0] = 'B';
+    testFile[1] = 'M';
+    testFileSize = offset + rowSize * rows;
+    testStore32(&testFile[2], testFileSize);
+    testStore32(&testFile[10], offset);
+    testStore32(&testFile[14], 40);
+    testStore32(&testFile[18], width);
+    testStore32(&testFile[22], (PFdword)height);
+    testFile[26] = 1;
+    testFile[28] = (PFbyte)bits;
+    for (row = 0; row < rows; row++, ptr += rowSize)
+    {
+        y = (height < 0) ? row : rows - 1 - row;
+        for (column = 0; column < width; column++)
+        {
+            ptr[bytes * column] = (PFbyte)rand();
+            ptr[bytes * column + 1] = (PFbyte)rand();
+            if (bytes == 2)
+            {
+                // BGR 565 in the file
+                testImage[y][column] = bgrToRgb((PFword)(ptr[2 * column] | (ptr[2 * column + 1] << 8)));
+            }
+            else
+            {
+                ptr[3 * column + 2] = (PFbyte)rand();
+                testImage[y][column] = (PFword)(((ptr[3 * column + 2] & 0xF8) << 8) |
+                                                ((ptr[3 * column + 1] & 0xFC) << 3) | (ptr[3 * column] >> 3));
+            }
+        }
+        // Padding which should not reach the LCD
+        memset(&ptr[bytes * width], 0xEE, rowSize - bytes * width);
+    }
+}
+
+static double testSeconds(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Draws the image at x, y and compares the whole screen, returns the draw time in seconds */
+static double testDraw(PFword x, PFword y, PFword width, PFsdword height, PFword bits, PFdword offset)
+{
+    static PFdword linkMap[BMP_IMAGE_LINK_MAP_SIZE(1)];
+    struct timespec start, end;
+    BmpImage image;
+    PFword rows = (PFword)((height < 0) ? -height : height), row, column;
+    PFdword wrong = 0;
+    char top;
+
+    testMakeBmp(width, height, bits, offset);
+    for (row = 0; row < TEST_HEIGHT; row++)
+    {
+        for (column = 0; column < TEST_WIDTH; column++)
+        {
+            testScreen[row][column] = TEST_BACKGROUND;
+        }
+    }
+    testWrites = 0;
+    testOutside = 0;
+    testStackTop = &top;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpImageOpen(&image, (const PFchar*)"image.bmp", linkMap,
+                                                    BMP_IMAGE_LINK_MAP_SIZE(1)));
+    TEST_ASSERT((image.topDown == enBooleanTrue) == (height < 0));
+    TEST_ASSERT_EQUAL(rows, image.header.imageHeight);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpImageDraw(&image, x, y));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    TEST_ASSERT_EQUAL((PFdword)width * rows, testWrites);
+    TEST_ASSERT_EQUAL(0, testOutside);
+    TEST_ASSERT_EQUAL(0x1030, testEntryMode);
+    TEST_ASSERT(testX1 == 0 && testY1 == 0 && testX2 == TEST_WIDTH - 1 && testY2 == TEST_HEIGHT - 1);
+    for (row = 0; row < TEST_HEIGHT; row++)
+    {
+        for (column = 0; column < TEST_WIDTH; column++)
+        {
+            if (row >= y && row < y + rows && column >= x && column < x + width)
+            {
+                wrong += (testScreen[row][column] != testImage[row - y][column - x]);
+            }
+            else
+            {
+                wrong += (testScreen[row][column] != TEST_BACKGROUND);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(0, wrong);
+
+    // Random access reads the same rows
+    row = (PFword)(rand() % rows);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpImagePickColor(&image, width - 1, row, &column));
+    TEST_ASSERT_EQUAL(testImage[row][width - 1], column);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpImageClose(&image));
+    return testSeconds(&start, &end);
+}
+
+/* Every pixel format and row order, at data offsets which split pixels between sectors */
+static void testFormats(void)
+{
+    static const PFword bits[] = {16, 24};
+    static const PFsdword order[] = {1, -1};
+    static const PFdword offsets[] = {54, 66, 70};
+    static const PFword sizes[][2] = {{1, 1}, {3, 5}, {101, 77}, {239, 13}, {TEST_WIDTH, TEST_HEIGHT}};
+    PFdword b, o, f, s;
+
+    testLinkMaps = 0;
+    for (b = 0; b < 2; b++)
+    {
+        for (o = 0; o < 2; o++)
+        {
+            for (f = 0; f < sizeof(offsets) / sizeof(offsets[0]); f++)
+            {
+                for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+                {
+                    testDraw((PFword)((TEST_WIDTH - sizes[s][0]) / 2), (PFword)(TEST_HEIGHT - sizes[s][1]),
+                             sizes[s][0], order[o] * sizes[s][1], bits[b], offsets[f]);
+                }
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(2 * 2 * 3 * 5, testLinkMaps);
+    TEST_ASSERT_EQUAL(TEST_SECTOR_SIZE, testForwardLargest);
+    // A 24 bit pixel is carried with two of its bytes at most
+    TEST_ASSERT_EQUAL(2, testCarryLargest);
+}
+
+/* Time of a full screen draw */
+static void testBenchmark(void)
+{
+    static const PFword bits[] = {16, 24};
+    static const PFsdword order[] = {1, -1};
+    PFdword b, o, k;
+    double seconds, best;
+
+    testStackDepth = 0;
+    for (b = 0; b < 2; b++)
+    {
+        for (o = 0; o < 2; o++)
+        {
+            best = 1e9;
+            for (k = 0; k < 5; k++)
+            {
+                seconds = testDraw(0, 0, TEST_WIDTH, order[o] * TEST_HEIGHT, bits[b], 54);
+                best = (seconds < best) ? seconds : best;
+            }
+            printf("  %ux%u %u bit %-9s: %7.1f us, %6.1f MB/s of file, %5.1f ns per pixel\n", TEST_WIDTH,
+                   TEST_HEIGHT, bits[b], (order[o] > 0) ? "bottom up" : "top down", best * 1e6,
+                   (testFileSize - 54) / best / 1e6, best * 1e9 / (TEST_WIDTH * TEST_HEIGHT));
+        }
+    }
+    printf("  high water: stack %u bytes below the draw, carry %u bytes, forward %u bytes at once\n",
+           (unsigned)testStackDepth, (unsigned)testCarryLargest, (unsigned)testForwardLargest);
+}
+
+static void testInvalid(void)
+{
+    BmpImage image;
+
+    // 8 bit pixels and an empty image are not streamed
+    testMakeBmp(10, 10, 16, 54);
+    testFile[28] = 8;
+    TEST_ASSERT_EQUAL(enStatusNotSupported, bmpImageOpen(&image, (const PFchar*)"image.bmp", NULL, 0));
+    testMakeBmp(10, 10, 16, 54);
+    testStore32(&testFile[22], 0);
+    TEST_ASSERT_EQUAL(enStatusNotSupported, bmpImageOpen(&image, (const PFchar*)"image.bmp", NULL, 0));
+    testFile[0] = 'X';
+    TEST_ASSERT_EQUAL(enStatusNotSupported, bmpImageOpen(&image, (const PFchar*)"image.bmp", NULL, 0));
+
+    // The image should fit and the screen should not be rotated
+    testMakeBmp(10, -10, 24, 54);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpImageOpen(&image, (const PFchar*)"image.bmp", NULL, 0));
+    testWrites = 0;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bmpImageDraw(&image, TEST_WIDTH - 9, 0));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bmpImageDraw(&image, 0, TEST_HEIGHT - 9));
+    testOrientation = enGfxOrientation_90;
+    TEST_ASSERT_EQUAL(enStatusNotSupported, bmpImageDraw(&image, 0, 0));
+    testOrientation = enGfxOrientation_0;
+    TEST_ASSERT_EQUAL(0, testWrites);
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bmpImageDraw(NULL, 0, 0));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bmpImageClose(&image));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testFormats);
+    TEST_RUN(testBenchmark);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
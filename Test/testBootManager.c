@@ -0,0 +1,528 @@
+/**
+ *  \file       testBootManager.c
+ *  \brief      Host test of the stages of the boot manager.
+ *
+ *  The boot manager is given the stage table of appInit() with its devices replaced by stub drivers,
+ *  each one taking a latency of its own on a clock of the test in microseconds, which is the timestamp
+ *  hook of CfgBoot. The main loop of the application is played: foreground stages, first frame, then
+ *  one background stage per round. The time to the first frame has to be the foreground latencies plus
+ *  the frame, whatever the background latencies, and is printed against a boot running every stage
+ *  before the first frame. A required stage which fails has to stop the boot, an optional stage which
+ *  fails has to leave the application running without its device, and bootRequire() of a background
+ *  stage which has not run yet has to run it once, right away.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "bootManager.h"
+#include "test.h"
+
+#define TEST_ROUNDS             1000
+#define TEST_FRAME_US           25000       // Home screen, window, widgets and canvas border
+#define TEST_LOOP_US            500         // Round of the main loop between two background stages
+#define TEST_MAX_LOOPS          100
+
+/* Core stand-in */
+static DWT_Type testDwt;
+static CoreDebug_Type testCoreDebug;
+
+#undef DWT
+#undef CoreDebug
+#define DWT                     (&testDwt)
+#define CoreDebug               (&testCoreDebug)
+
+#include "../Source/AppHelper/bootManager.c"
+
+/* Stages of appInit(), see AppBootStage, with a lazy stage added */
+typedef enum
+{
+    enTestBootTick = 0,
+    enTestBootLcd,
+    enTestBootTimer0,
+    enTestBootSpi,
+    enTestBootTouch,
+    enTestBootSdcard,
+    enTestBootAccel,
+    enTestBootKeypad,
+    enTestBootBuzzer,
+    enTestBootLazy,
+    enTestBootCount
+}TestBootStage;
+
+/* Latencies of the stub drivers in microseconds, close to the board */
+static const PFdword testBoardLatency[enTestBootCount] =
+{
+    40,         // RIT and tick
+    120000,     // LCD reset and register delays
+    10,         // Timer0
+    300,        // SPI0 and GPDMA
+    2000,       // Touch panel
+    450000,     // SDcard start up and mount
+    15000,      // I2C0 and accelerometer
+    20,         // Keypad GPIO
+    20,         // Buzzer GPIO
+    5000        // Lazy device
+};
+
+static PFdword testClock;
+static PFdword testLatency[enTestBootCount];
+static PFEnStatus testResult[enTestBootCount];
+static PFdword testCalls[enTestBootCount];
+static PFbyte testOrder[enTestBootCount * 2];
+static PFbyte testOrderCount;
+static PFdword testDoneCount;
+static PFEnBoolean testFrameDrawn;
+static PFdword testEarlyStages;
+
+// Stub drivers
+
+static PFEnStatus testInit(PFbyte stage)
+{
+    testCalls[stage]++;
+    testOrder[testOrderCount++] = stage;
+    testClock += testLatency[stage];
+    return testResult[stage];
+}
+
+#define TEST_STAGE(name, id)    static PFEnStatus name(void) { return testInit(id); }
+
+TEST_STAGE(testTickInit, enTestBootTick)
+TEST_STAGE(testLcdInit, enTestBootLcd)
+TEST_STAGE(testTimer0Init, enTestBootTimer0)
+TEST_STAGE(testSpiInit, enTestBootSpi)
+TEST_STAGE(testTouchInit, enTestBootTouch)
+TEST_STAGE(testSdcardInit, enTestBootSdcard)
+TEST_STAGE(testAccelInit, enTestBootAccel)
+TEST_STAGE(testKeypadInit, enTestBootKeypad)
+TEST_STAGE(testBuzzerInit, enTestBootBuzzer)
+TEST_STAGE(testLazyInit, enTestBootLazy)
+
+/* Modes and requirements of appBootStages */
+static const BootStage testStages[enTestBootCount] =
+{
+    {testTickInit,      enBootModeForeground,   enBooleanTrue},
+    {testLcdInit,       enBootModeForeground,   enBooleanTrue},
+    {testTimer0Init,    enBootModeForeground,   enBooleanTrue},
+    {testSpiInit,       enBootModeForeground,   enBooleanTrue},
+    {testTouchInit,     enBootModeForeground,   enBooleanTrue},
+    {testSdcardInit,    enBootModeBackground,   enBooleanFalse},
+    {testAccelInit,     enBootModeBackground,   enBooleanFalse},
+    {testKeypadInit,    enBootModeForeground,   enBooleanFalse},
+    {testBuzzerInit,    enBootModeForeground,   enBooleanFalse},
+    {testLazyInit,      enBootModeLazy,         enBooleanFalse}
+};
+
+/* Same stages, all of them before the first frame */
+static BootStage testSerialStages[enTestBootCount];
+
+static PFdword testTimestamp(void)
+{
+    return testClock;
+}
+
+static void testStageDone(PFbyte stage, PFEnStatus status, PFdword duration)
+{
+    testDoneCount++;
+    TEST_ASSERT(stage < enTestBootCount);
+    TEST_ASSERT_EQUAL(testResult[stage], status);
+    TEST_ASSERT_EQUAL(testLatency[stage], duration);
+    testEarlyStages += (testFrameDrawn != enBooleanTrue && testStages[stage].mode != enBootModeForeground);
+}
+
+static CfgBoot testConfig =
+{
+    testStages,
+    enTestBootCount,
+    testTimestamp,
+    testStageDone
+};
+
+// Helpers
+
+/* Sets the board latencies, or random ones, and a success for every stage */
+static void testReset(PFEnBoolean random)
+{
+    PFbyte stage;
+
+    for (stage = 0; stage < enTestBootCount; stage++)
+    {
+        testLatency[stage] = (random == enBooleanTrue) ? (PFdword)rand() % (2 * testBoardLatency[stage] + 1) :
+                             testBoardLatency[stage];
+        testResult[stage] = enStatusSuccess;
+        testCalls[stage] = 0;
+    }
+    testClock = (PFdword)rand();
+    testOrderCount = 0;
+    testDoneCount = 0;
+    testFrameDrawn = enBooleanFalse;
+    testEarlyStages = 0;
+}
+
+/* Sum of the latencies of the stages of a mode */
+static PFdword testModeLatency(BootMode mode)
+{
+    PFdword latency = 0;
+    PFbyte stage;
+
+    for (stage = 0; stage < enTestBootCount; stage++)
+    {
+        latency += (testStages[stage].mode == mode) ? testLatency[stage] : 0;
+    }
+    return latency;
+}
+
+/* Main loop of the application: foreground stages, first frame, background stages one per round */
+static PFEnStatus testBoot(pCfgBoot config, PFbyte* failedStage)
+{
+    PFEnStatus status;
+    PFdword loops = 0;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(config));
+    status = bootRunForeground(failedStage);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    testClock += TEST_FRAME_US;
+    testFrameDrawn = enBooleanTrue;
+    bootMarkFirstFrame();
+
+    while (bootRunBackground() == enStatusBusy && loops++ < TEST_MAX_LOOPS)
+    {
+        testClock += TEST_LOOP_US;
+    }
+    TEST_ASSERT(loops < TEST_MAX_LOOPS);
+    return enStatusSuccess;
+}
+
+/* Checks the record of a stage against the latency of its stub */
+static void testCheckStage(PFbyte stage, BootState state)
+{
+    BootStageInfo info;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootGetStageInfo(stage, &info));
+    TEST_ASSERT_EQUAL(state, info.state);
+    if (state != enBootStatePending)
+    {
+        TEST_ASSERT_EQUAL(testResult[stage], info.status);
+        TEST_ASSERT_EQUAL(testLatency[stage], info.duration);
+        TEST_ASSERT_EQUAL(1, testCalls[stage]);
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL(0, testCalls[stage]);
+    }
+    TEST_ASSERT_EQUAL(state == enBootStateReady, bootIsReady(stage));
+}
+
+// Tests
+
+/* The first frame waits for the foreground stages only */
+static void testFirstFrame(void)
+{
+    BootTimes times;
+    BootStageInfo info;
+    PFdword round, expected, serial = 0, staged = 0;
+    PFbyte stage;
+    int failed = 0;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testReset((round == 0) ? enBooleanFalse : enBooleanTrue);
+        TEST_ASSERT_EQUAL(enStatusSuccess, testBoot(&testConfig, NULL));
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+
+        expected = testModeLatency(enBootModeForeground);
+        failed += (times.foreground != expected);
+        failed += (times.firstFrame != expected + TEST_FRAME_US);
+        // Background stages in table order, one per round of the main loop
+        failed += (times.background != expected + TEST_FRAME_US + testModeLatency(enBootModeBackground) +
+                   TEST_LOOP_US * 2);
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootGetStageInfo(enTestBootSdcard, &info));
+        failed += (info.start != times.firstFrame);
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootGetStageInfo(enTestBootAccel, &info));
+        failed += (info.start != times.firstFrame + testLatency[enTestBootSdcard] + TEST_LOOP_US);
+
+        for (stage = 0; stage < enTestBootCount; stage++)
+        {
+            testCheckStage(stage, (testStages[stage].mode == enBootModeLazy) ? enBootStatePending :
+                                  enBootStateReady);
+        }
+        TEST_ASSERT_EQUAL(enTestBootCount - 1, testDoneCount);
+        TEST_ASSERT_EQUAL(0, testEarlyStages);
+        // Foreground stages in table order, then the background ones
+        TEST_ASSERT_EQUAL(enTestBootTick, testOrder[0]);
+        TEST_ASSERT_EQUAL(enTestBootTouch, testOrder[4]);
+        TEST_ASSERT_EQUAL(enTestBootBuzzer, testOrder[6]);
+        TEST_ASSERT_EQUAL(enTestBootSdcard, testOrder[7]);
+        TEST_ASSERT_EQUAL(enTestBootAccel, testOrder[8]);
+        staged += times.firstFrame;
+
+        // Same latencies with every stage before the first frame
+        for (stage = 0; stage < enTestBootCount; stage++)
+        {
+            testCalls[stage] = 0;
+        }
+        testFrameDrawn = enBooleanTrue;
+        testConfig.stages = testSerialStages;
+        TEST_ASSERT_EQUAL(enStatusSuccess, testBoot(&testConfig, NULL));
+        testConfig.stages = testStages;
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+        failed += (times.firstFrame != expected + testModeLatency(enBootModeBackground) + TEST_FRAME_US);
+        serial += times.firstFrame;
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    printf("  first frame after %lu.%03lu ms staged, %lu.%03lu ms with every stage in the foreground\n",
+           (unsigned long)(staged / TEST_ROUNDS / 1000), (unsigned long)(staged / TEST_ROUNDS % 1000),
+           (unsigned long)(serial / TEST_ROUNDS / 1000), (unsigned long)(serial / TEST_ROUNDS % 1000));
+}
+
+/* A required stage which fails stops the boot before the first frame */
+static void testRequiredFailure(void)
+{
+    BootTimes times;
+    PFbyte stage, failedStage, next;
+
+    for (stage = 0; stage < enTestBootCount; stage++)
+    {
+        if (testStages[stage].required != enBooleanTrue)
+        {
+            continue;
+        }
+        testReset(enBooleanTrue);
+        testResult[stage] = enStatusError;
+        failedStage = 0xFF;
+        TEST_ASSERT_EQUAL(enStatusError, testBoot(&testConfig, &failedStage));
+        TEST_ASSERT_EQUAL(stage, failedStage);
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+        TEST_ASSERT_EQUAL(0, times.foreground);
+        TEST_ASSERT_EQUAL(0, times.firstFrame);
+
+        for (next = 0; next < enTestBootCount; next++)
+        {
+            if (next < stage && testStages[next].mode == enBootModeForeground)
+            {
+                testCheckStage(next, enBootStateReady);
+            }
+            else if (next == stage)
+            {
+                testCheckStage(next, enBootStateFailed);
+            }
+            else
+            {
+                testCheckStage(next, enBootStatePending);
+            }
+        }
+
+        // Not run again
+        TEST_ASSERT_EQUAL(enStatusError, bootRunForeground(&failedStage));
+        TEST_ASSERT_EQUAL(enStatusError, bootRequire(stage));
+        TEST_ASSERT_EQUAL(1, testCalls[stage]);
+    }
+}
+
+/* An optional stage which fails leaves the application running without its device */
+static void testOptionalFailure(void)
+{
+    BootTimes times;
+    PFbyte stage, failedStage, next, saves;
+    PFdword saved;
+
+    for (stage = 0; stage < enTestBootCount; stage++)
+    {
+        if (testStages[stage].required == enBooleanTrue)
+        {
+            continue;
+        }
+        testReset(enBooleanTrue);
+        testResult[stage] = enStatusTimeout;
+        failedStage = 0xFF;
+        TEST_ASSERT_EQUAL(enStatusSuccess, testBoot(&testConfig, &failedStage));
+        TEST_ASSERT_EQUAL(0xFF, failedStage);
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+        TEST_ASSERT_EQUAL(testModeLatency(enBootModeForeground) + TEST_FRAME_US, times.firstFrame);
+        TEST_ASSERT(times.background != 0);
+
+        // The save button of the application checks the device each time, the stage is not run again
+        for (saves = 0, saved = 0; saves < 10; saves++)
+        {
+            saved += (bootRequire(stage) == enStatusSuccess);
+        }
+        TEST_ASSERT_EQUAL(0, saved);
+        TEST_ASSERT_EQUAL(enStatusTimeout, bootRequire(stage));
+        TEST_ASSERT_EQUAL(enStatusSuccess, bootRunBackground());
+
+        for (next = 0; next < enTestBootCount; next++)
+        {
+            if (next == stage)
+            {
+                testCheckStage(next, enBootStateFailed);
+            }
+            else
+            {
+                testCheckStage(next, (testStages[next].mode == enBootModeLazy) ? enBootStatePending :
+                                     enBootStateReady);
+            }
+        }
+    }
+}
+
+/* bootRequire() runs a pending background stage once, right away */
+static void testRequirePending(void)
+{
+    BootTimes times;
+    BootStageInfo info;
+    PFdword clock;
+
+    // The gallery is opened before the boot task has mounted the SDcard
+    testReset(enBooleanTrue);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(&testConfig));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunForeground(NULL));
+    bootMarkFirstFrame();
+    TEST_ASSERT_EQUAL(enBooleanFalse, bootIsReady(enTestBootSdcard));
+    clock = testClock;
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRequire(enTestBootSdcard));
+    TEST_ASSERT_EQUAL(clock + testLatency[enTestBootSdcard], testClock);
+    testCheckStage(enTestBootSdcard, enBootStateReady);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRequire(enTestBootSdcard));
+
+    // The boot task passes it over and runs the accelerometer
+    TEST_ASSERT_EQUAL(enStatusBusy, bootRunBackground());
+    testCheckStage(enTestBootAccel, enBootStateReady);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunBackground());
+    TEST_ASSERT_EQUAL(1, testCalls[enTestBootSdcard]);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+    TEST_ASSERT_EQUAL(testClock - (clock - testModeLatency(enBootModeForeground)), times.background);
+
+    // Between two rounds of the boot task
+    testReset(enBooleanTrue);
+    clock = testClock;
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(&testConfig));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunForeground(NULL));
+    TEST_ASSERT_EQUAL(enStatusBusy, bootRunBackground());
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRequire(enTestBootAccel));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunBackground());
+    TEST_ASSERT_EQUAL(1, testCalls[enTestBootSdcard]);
+    TEST_ASSERT_EQUAL(1, testCalls[enTestBootAccel]);
+
+    // Lazy stages are only run by bootRequire(), which also runs foreground stages early
+    testCheckStage(enTestBootLazy, enBootStatePending);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRequire(enTestBootLazy));
+    testCheckStage(enTestBootLazy, enBootStateReady);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootGetStageInfo(enTestBootLazy, &info));
+    TEST_ASSERT_EQUAL(testClock - testLatency[enTestBootLazy] - clock, info.start);
+
+    testReset(enBooleanTrue);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(&testConfig));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRequire(enTestBootTouch));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunForeground(NULL));
+    TEST_ASSERT_EQUAL(1, testCalls[enTestBootTouch]);
+    TEST_ASSERT_EQUAL(enTestBootTouch, testOrder[0]);
+}
+
+/* Timestamps of the DWT cycle counter when no hook is given */
+static void testCycleCounter(void)
+{
+    BootTimes times;
+    BootStageInfo info;
+    CfgBoot config = testConfig;
+    PFbyte failedStage;
+
+    config.timestamp = NULL;
+    config.stageDone = NULL;
+    testReset(enBooleanFalse);
+    memset(&testDwt, 0, sizeof(testDwt));
+    memset(&testCoreDebug, 0, sizeof(testCoreDebug));
+    testDwt.CYCCNT = 0xFFFFFF00;    // Wraps during the boot
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(&config));
+    TEST_ASSERT(testCoreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+    TEST_ASSERT(testDwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    testDwt.CYCCNT += 0x1000;
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunForeground(&failedStage));
+    bootMarkFirstFrame();
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+    TEST_ASSERT_EQUAL(0x1000, times.foreground);
+    TEST_ASSERT_EQUAL(0x1000, times.firstFrame);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootGetStageInfo(enTestBootTick, &info));
+    TEST_ASSERT_EQUAL(0x1000, info.start);
+    TEST_ASSERT_EQUAL(0, info.duration);
+}
+
+/* Invalid arguments and calls before bootOpen() */
+static void testInvalid(void)
+{
+    BootStage stages[enTestBootCount];
+    CfgBoot config = testConfig;
+    BootStageInfo info;
+    BootTimes times;
+
+    bootInit = enBooleanFalse;
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, bootRunForeground(NULL));
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, bootRunBackground());
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, bootRequire(enTestBootTick));
+    TEST_ASSERT_EQUAL(enBooleanFalse, bootIsReady(enTestBootTick));
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootOpen(NULL));
+    config.stages = NULL;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootOpen(&config));
+    config.stages = testStages;
+    config.stageCount = BOOT_MAX_STAGES + 1;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootOpen(&config));
+    memcpy(stages, testStages, sizeof(stages));
+    stages[enTestBootAccel].init = NULL;
+    config.stages = stages;
+    config.stageCount = enTestBootCount;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootOpen(&config));
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, bootRunForeground(NULL));
+
+    testReset(enBooleanFalse);
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(&testConfig));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootRequire(enTestBootCount));
+    TEST_ASSERT_EQUAL(enBooleanFalse, bootIsReady(enTestBootCount));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootGetStageInfo(enTestBootCount, &info));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootGetStageInfo(enTestBootTick, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, bootGetTimes(NULL));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootGetTimes(&times));
+    TEST_ASSERT_EQUAL(0, times.firstFrame);
+
+    // An empty table boots at once
+    config.stageCount = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootOpen(&config));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunForeground(NULL));
+    TEST_ASSERT_EQUAL(enStatusSuccess, bootRunBackground());
+    TEST_ASSERT_EQUAL(0, testOrderCount);
+}
+
+int main(void)
+{
+    PFbyte stage;
+
+    for (stage = 0; stage < enTestBootCount; stage++)
+    {
+        testSerialStages[stage] = testStages[stage];
+        if (testSerialStages[stage].mode == enBootModeBackground)
+        {
+            testSerialStages[stage].mode = enBootModeForeground;
+        }
+    }
+
+    srand(1);
+    TEST_RUN(testInvalid);
+    TEST_RUN(testFirstFrame);
+    TEST_RUN(testRequiredFailure);
+    TEST_RUN(testOptionalFailure);
+    TEST_RUN(testRequirePending);
+    TEST_RUN(testCycleCounter);
+    TEST_EXIT();
+}
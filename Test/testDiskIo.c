@@ -0,0 +1,369 @@
+/**
+ *  \file       testDiskIo.c
+ *  \brief      Host test of the disk layer and its sector cache on a device backed by a file.
+ *
+ *  The device functions read and write the sectors of a temporary file. A copy of the disk in
+ *  memory is kept with every write of the test, after a CTRL_SYNC the file has to match it. The
+ *  cache is also checked to keep the file untouched by single sector writes until it is synced,
+ *  to write runs of sectors as one request and to keep dirty sectors over diskInit().
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "diskIo.h"
+#include "test.h"
+
+#define TEST_SECTORS            256
+#define TEST_FAT_FIRST          4
+#define TEST_FAT_SIZE           8
+#define TEST_MAX_RUN            8
+
+static FILE* testImage;
+static PFbyte testDrive;
+static PFbyte testDisk[TEST_SECTORS][DISK_SECTOR_SIZE];
+static PFEnStatus testDeviceStatus;
+static PFdword testDeviceIoCtrls;
+static PFdword testDeviceWrites;
+
+static PFEnStatus testDeviceOpen(PFbyte* deviceId, pCfgMmc cfg)
+{
+    (void)cfg;
+    *deviceId = 0;
+    return enStatusSuccess;
+}
+
+static PFEnStatus testDeviceGetStatus(PFbyte deviceId)
+{
+    (void)deviceId;
+    return testDeviceStatus;
+}
+
+static PFEnStatus testDeviceRead(PFbyte deviceId, PFbyte* data, PFdword sector, PFdword count)
+{
+    (void)deviceId;
+    if (testDeviceStatus != enStatusSuccess || sector + count > TEST_SECTORS)
+    {
+        return enStatusError;
+    }
+    fseek(testImage, (long)sector * DISK_SECTOR_SIZE, SEEK_SET);
+    return (fread(data, DISK_SECTOR_SIZE, count, testImage) == count) ? enStatusSuccess : enStatusError;
+}
+
+static PFEnStatus testDeviceWrite(PFbyte deviceId, const PFbyte* data, PFdword sector, PFdword count)
+{
+    (void)deviceId;
+    if (testDeviceStatus != enStatusSuccess || sector + count > TEST_SECTORS)
+    {
+        return enStatusError;
+    }
+    testDeviceWrites++;
+    fseek(testImage, (long)sector * DISK_SECTOR_SIZE, SEEK_SET);
+    return (fwrite(data, DISK_SECTOR_SIZE, count, testImage) == count) ? enStatusSuccess : enStatusError;
+}
+
+static PFEnStatus testDeviceIoCtrl(PFbyte deviceId, PFbyte cmd, void* arg)
+{
+    (void)deviceId;
+    (void)cmd;
+    (void)arg;
+    testDeviceIoCtrls++;
+    return enStatusSuccess;
+}
+
+static CfgDisk testConfig =
+{
+    NULL,
+    testDeviceOpen,
+    testDeviceGetStatus,
+    testDeviceRead,
+    testDeviceWrite,
+    testDeviceIoCtrl,
+    enBooleanTrue,
+    enBooleanTrue
+};
+
+/* Fills the image with a FAT16 boot sector and a pattern of the sector numbers */
+static void testFormat(void)
+{
+    PFdword sector, k;
+
+    for (sector = 0; sector < TEST_SECTORS; sector++)
+    {
+        for (k = 0; k < DISK_SECTOR_SIZE; k++)
+        {
+            testDisk[sector][k] = (PFbyte)(sector * 7 + k);
+        }
+    }
+    memset(testDisk[0], 0, DISK_SECTOR_SIZE);
+    testDisk[0][14] = TEST_FAT_FIRST;               // Reserved sectors
+    testDisk[0][16] = 2;                            // Number of FATs
+    testDisk[0][22] = TEST_FAT_SIZE / 2;            // Sectors per FAT
+    memcpy(&testDisk[0][54], "FAT16", 5);
+    testDisk[0][510] = 0x55;
+    testDisk[0][511] = 0xAA;
+
+    rewind(testImage);
+    fwrite(testDisk, DISK_SECTOR_SIZE, TEST_SECTORS, testImage);
+    fflush(testImage);
+}
+
+/* Checks that every sector of the file matches the copy of the test */
+static PFEnBoolean testImageMatches(void)
+{
+    PFbyte data[DISK_SECTOR_SIZE];
+    PFdword sector;
+
+    fflush(testImage);
+    for (sector = 0; sector < TEST_SECTORS; sector++)
+    {
+        fseek(testImage, (long)sector * DISK_SECTOR_SIZE, SEEK_SET);
+        if (fread(data, DISK_SECTOR_SIZE, 1, testImage) != 1 || memcmp(data, testDisk[sector], DISK_SECTOR_SIZE) != 0)
+        {
+            printf("  sector %u differs\n", (unsigned)sector);
+            return enBooleanFalse;
+        }
+    }
+    return enBooleanTrue;
+}
+
+static void testFill(PFbyte* data, PFdword count, PFbyte seed)
+{
+    PFdword k;
+
+    for (k = 0; k < count * DISK_SECTOR_SIZE; k++)
+    {
+        data[k] = (PFbyte)(seed + k * 13);
+    }
+}
+
+static void testStats(PFbyte drive, DiskCacheStats* stats)
+{
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskCacheGetStats(drive, stats));
+}
+
+/* Starts a test on a new medium, the cache of the last test holds no dirty sector */
+static PFbyte testOpen(void)
+{
+    testFormat();
+    testDeviceStatus = enStatusSuccess;
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskInit(testDrive));
+    return testDrive;
+}
+
+static void testWriteBack(void)
+{
+    PFbyte drive = testOpen();
+    PFbyte data[DISK_SECTOR_SIZE], check[DISK_SECTOR_SIZE];
+    DiskCacheStats before, after;
+    PFdword sector;
+
+    // Single sector writes stay in the cache
+    testDeviceWrites = 0;
+    for (sector = 100; sector < 104; sector++)
+    {
+        testFill(data, 1, (PFbyte)sector);
+        memcpy(testDisk[sector], data, DISK_SECTOR_SIZE);
+        TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, data, sector, 1));
+    }
+    TEST_ASSERT_EQUAL(0, testDeviceWrites);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, check, 102, 1));
+    TEST_ASSERT(memcmp(check, testDisk[102], DISK_SECTOR_SIZE) == 0);
+
+    // The run of dirty sectors is written with one request
+    testStats(drive, &before);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskIoCtrl(drive, CTRL_SYNC, NULL));
+    testStats(drive, &after);
+    TEST_ASSERT_EQUAL(1, after.devWrites - before.devWrites);
+    TEST_ASSERT_EQUAL(4, after.devSectorsWritten - before.devSectorsWritten);
+    TEST_ASSERT(testImageMatches() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskIoCtrl(drive, CTRL_SYNC, NULL));
+    testStats(drive, &before);
+    TEST_ASSERT_EQUAL(after.devWrites, before.devWrites);
+}
+
+static void testMultipleCoherent(void)
+{
+    PFbyte drive = testOpen();
+    PFbyte data[DISK_SECTOR_SIZE], block[4 * DISK_SECTOR_SIZE];
+
+    // A multiple sector read sees the dirty cached sector
+    testFill(data, 1, 0x31);
+    memcpy(testDisk[41], data, DISK_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, data, 41, 1));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, block, 40, 4));
+    TEST_ASSERT(memcmp(block, testDisk[40], sizeof(block)) == 0);
+
+    // A multiple sector write replaces the cached copies, which are no more dirty
+    testFill(block, 4, 0x52);
+    memcpy(testDisk[40], block, sizeof(block));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, block, 40, 4));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, 41, 1));
+    TEST_ASSERT(memcmp(data, testDisk[41], DISK_SECTOR_SIZE) == 0);
+    testDeviceWrites = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskIoCtrl(drive, CTRL_SYNC, NULL));
+    TEST_ASSERT_EQUAL(0, testDeviceWrites);
+    TEST_ASSERT(testImageMatches() == enBooleanTrue);
+}
+
+static void testEviction(void)
+{
+    PFbyte drive = testOpen();
+    PFbyte data[DISK_SECTOR_SIZE];
+    DiskCacheStats before, after;
+    PFdword sector;
+
+    // More dirty sectors than entries, the oldest ones are written back to make room
+    testStats(drive, &before);
+    for (sector = 0; sector < 3 * DISK_CACHE_SECTORS; sector++)
+    {
+        testFill(data, 1, (PFbyte)(sector + 9));
+        memcpy(testDisk[150 + 2 * sector], data, DISK_SECTOR_SIZE);
+        TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, data, 150 + 2 * sector, 1));
+    }
+    testStats(drive, &after);
+    TEST_ASSERT(after.evictions - before.evictions >= 2 * DISK_CACHE_SECTORS - 1);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskIoCtrl(drive, CTRL_SYNC, NULL));
+    TEST_ASSERT(testImageMatches() == enBooleanTrue);
+}
+
+static void testPinnedFat(void)
+{
+    PFbyte drive = testOpen();
+    PFbyte data[DISK_SECTOR_SIZE];
+    DiskCacheStats before, after;
+    PFdword sector;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, TEST_FAT_FIRST, 1));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, TEST_FAT_FIRST + 1, 1));
+    // File data passing through the cache does not push the FAT out
+    for (sector = 60; sector < 60 + 4 * DISK_CACHE_SECTORS; sector++)
+    {
+        TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, sector, 1));
+        TEST_ASSERT(memcmp(data, testDisk[sector], DISK_SECTOR_SIZE) == 0);
+    }
+    testStats(drive, &before);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, TEST_FAT_FIRST, 1));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, TEST_FAT_FIRST + 1, 1));
+    testStats(drive, &after);
+    TEST_ASSERT_EQUAL(2, after.readHits - before.readHits);
+    TEST_ASSERT_EQUAL(0, after.devReads - before.devReads);
+}
+
+static void testInitKeepsDirty(void)
+{
+    PFbyte drive = testOpen();
+    PFbyte data[DISK_SECTOR_SIZE];
+
+    testFill(data, 1, 0x77);
+    memcpy(testDisk[120], data, DISK_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, data, 120, 1));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskInit(drive));
+    TEST_ASSERT(testImageMatches() == enBooleanTrue);
+
+    // A device which is not ready any more cannot take them, they go with the old medium
+    testFill(data, 1, 0x78);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, data, 121, 1));
+    testDeviceStatus = enStatusNotExist;
+    testDeviceWrites = 0;
+    diskInit(drive);
+    TEST_ASSERT_EQUAL(0, testDeviceWrites);
+    testDeviceStatus = enStatusSuccess;
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, data, 121, 1));
+    TEST_ASSERT(memcmp(data, testDisk[121], DISK_SECTOR_SIZE) == 0);
+    TEST_ASSERT(testImageMatches() == enBooleanTrue);
+}
+
+static void testSyncWithoutIoCtrl(void)
+{
+    PFbyte drive;
+    PFbyte data[DISK_SECTOR_SIZE];
+
+    testFormat();
+    testDeviceStatus = enStatusSuccess;
+    testConfig.allowIoCtrl = enBooleanFalse;
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskOpen(&drive, &testConfig));
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskInit(drive));
+    testConfig.allowIoCtrl = enBooleanTrue;
+
+    testFill(data, 1, 0x19);
+    memcpy(testDisk[130], data, DISK_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, data, 130, 1));
+    testDeviceIoCtrls = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskIoCtrl(drive, CTRL_SYNC, NULL));
+    TEST_ASSERT(testImageMatches() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(enStatusNotSupported, diskIoCtrl(drive, GET_SECTOR_COUNT, NULL));
+    TEST_ASSERT_EQUAL(0, testDeviceIoCtrls);
+}
+
+/* Random reads and writes of one to TEST_MAX_RUN sectors, synced from time to time */
+static void testRandom(void)
+{
+    PFbyte drive = testOpen();
+    static PFbyte block[TEST_MAX_RUN * DISK_SECTOR_SIZE];
+    PFdword step, sector, count;
+    PFEnBoolean readsMatch = enBooleanTrue;
+
+    srand(1);
+    for (step = 0; step < 20000; step++)
+    {
+        count = (rand() % 4 == 0) ? 1 + rand() % TEST_MAX_RUN : 1;
+        // Most requests go to the FAT and directory area at the start of the disk
+        sector = (rand() % 2 == 0) ? rand() % 24 : rand() % TEST_SECTORS;
+        if (sector + count > TEST_SECTORS)
+        {
+            sector = TEST_SECTORS - count;
+        }
+
+        if (rand() % 2 == 0)
+        {
+            testFill(block, count, (PFbyte)step);
+            memcpy(testDisk[sector], block, count * DISK_SECTOR_SIZE);
+            TEST_ASSERT_EQUAL(enStatusSuccess, diskWrite(drive, block, sector, count));
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL(enStatusSuccess, diskRead(drive, block, sector, count));
+            if (memcmp(block, testDisk[sector], count * DISK_SECTOR_SIZE) != 0)
+            {
+                readsMatch = enBooleanFalse;
+            }
+        }
+        if (step % 1000 == 999)
+        {
+            TEST_ASSERT_EQUAL(enStatusSuccess, diskIoCtrl(drive, CTRL_SYNC, NULL));
+            TEST_ASSERT(testImageMatches() == enBooleanTrue);
+        }
+    }
+    TEST_ASSERT(readsMatch == enBooleanTrue);
+}
+
+int main(void)
+{
+    testImage = tmpfile();
+    if (testImage == NULL)
+    {
+        printf("testDiskIo: no temporary file\n");
+        return 1;
+    }
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, diskOpen(&testDrive, &testConfig));
+    TEST_RUN(testWriteBack);
+    TEST_RUN(testMultipleCoherent);
+    TEST_RUN(testEviction);
+    TEST_RUN(testPinnedFat);
+    TEST_RUN(testInitKeepsDirty);
+    TEST_RUN(testSyncWithoutIoCtrl);
+    TEST_RUN(testRandom);
+    fclose(testImage);
+    TEST_EXIT();
+}
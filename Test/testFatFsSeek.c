@@ -0,0 +1,449 @@
+/**
+ *  \file       testFatFsSeek.c
+ *  \brief      Host test of the cluster link map and of the fast seek of fatFsExt.
+ *
+ *  A file system object is set up on a FAT in memory, FAT12, FAT16 and FAT32 in turn, with
+ *  fragmented cluster chains made at random. The link map is checked against the chain, and
+ *  fsFileSeekFast against a model of fsFileSeek which follows the chain from the start of the file,
+ *  at every offset of the file. The fast seek has to find the cluster without reading the disk.
+ *  fsFileExpand is checked on runs of free clusters around the cluster where the search starts, and
+ *  the time and the FAT sector writes of the pre-allocation of a saved BMP are printed.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "diskIo.h"
+#include "fatFs.h"
+#include "test.h"
+
+#define TEST_FAT_BASE           1
+#define TEST_FAT_SECTORS        4
+#define TEST_CLUSTER_SECTORS    2
+#define TEST_MAX_CLUST          400
+#define TEST_DISK_SECTORS       (TEST_FAT_BASE + TEST_FAT_SECTORS)
+#define TEST_MAX_CHAIN          64
+#define TEST_MAP_SIZE           (2 * TEST_MAX_CHAIN + 2)
+#define TEST_BMP_SIZE           (240UL * 320 * 3 + 54)
+#define TEST_EXPAND_ROUNDS      1000
+
+static PFbyte testDisk[TEST_DISK_SECTORS][DISK_SECTOR_SIZE];
+static PFdword testDiskReads;
+static PFdword testFatWrites;
+static FatFs testFs;
+static PFdword testChain[TEST_MAX_CHAIN];
+static PFdword testChainLength;
+
+PFEnStatus diskRead(PFbyte drive, PFbyte* buff, PFdword sector, PFdword count)
+{
+    (void)drive;
+    if (sector + count > TEST_DISK_SECTORS)
+    {
+        return enStatusError;
+    }
+    testDiskReads++;
+    memcpy(buff, testDisk[sector], count * DISK_SECTOR_SIZE);
+    return enStatusSuccess;
+}
+
+PFEnStatus diskWrite(PFbyte drive, const PFbyte* buff, PFdword sector, PFdword count)
+{
+    (void)drive;
+    if (sector + count > TEST_DISK_SECTORS)
+    {
+        return enStatusError;
+    }
+    testFatWrites += (sector >= TEST_FAT_BASE && sector < TEST_FAT_BASE + TEST_FAT_SECTORS);
+    memcpy(testDisk[sector], buff, count * DISK_SECTOR_SIZE);
+    return enStatusSuccess;
+}
+
+/* Writes a FAT entry of the disk in memory */
+static void testSetFat(PFdword clust, PFdword val)
+{
+    PFbyte* fat = testDisk[TEST_FAT_BASE];
+    PFdword offset;
+
+    switch (testFs.fs_type)
+    {
+        case FS_FAT12:
+            offset = clust + clust / 2;
+            if ((clust & 1) != 0)
+            {
+                fat[offset] = (PFbyte)((fat[offset] & 0x0F) | (val << 4));
+                fat[offset + 1] = (PFbyte)(val >> 4);
+            }
+            else
+            {
+                fat[offset] = (PFbyte)val;
+                fat[offset + 1] = (PFbyte)((fat[offset + 1] & 0xF0) | ((val >> 8) & 0x0F));
+            }
+            break;
+
+        case FS_FAT16:
+            fat[clust * 2] = (PFbyte)val;
+            fat[clust * 2 + 1] = (PFbyte)(val >> 8);
+            break;
+
+        default:
+            fat[clust * 4] = (PFbyte)val;
+            fat[clust * 4 + 1] = (PFbyte)(val >> 8);
+            fat[clust * 4 + 2] = (PFbyte)(val >> 16);
+            fat[clust * 4 + 3] = (PFbyte)((val >> 24) & 0x0F);
+            break;
+    }
+}
+
+static void testMount(PFbyte type)
+{
+    memset(testDisk, 0, sizeof(testDisk));
+    memset(&testFs, 0, sizeof(testFs));
+    testFs.fs_type = type;
+    testFs.csize = TEST_CLUSTER_SECTORS;
+    testFs.n_fats = 1;
+    testFs.id = 1;
+    testFs.sects_fat = TEST_FAT_SECTORS;
+    testFs.max_clust = TEST_MAX_CLUST;
+    testFs.fatbase = TEST_FAT_BASE;
+    testFs.database = 100;
+    testFs.winsect = 0xFFFFFFFF;
+}
+
+/* Links a chain of fragments with random lengths and gaps */
+static void testMakeChain(PFdword fragments)
+{
+    PFdword clust = 2 + rand() % 20, length, k;
+
+    memset(testDisk[TEST_FAT_BASE], 0, TEST_FAT_SECTORS * DISK_SECTOR_SIZE);
+    testChainLength = 0;
+    while (fragments-- != 0)
+    {
+        length = 1 + rand() % 4;
+        for (k = 0; k < length && testChainLength < TEST_MAX_CHAIN; k++)
+        {
+            testChain[testChainLength++] = clust++;
+        }
+        clust += 1 + rand() % 9;
+    }
+    for (k = 0; k + 1 < testChainLength; k++)
+    {
+        testSetFat(testChain[k], testChain[k + 1]);
+    }
+    // End of chain mark
+    testSetFat(testChain[testChainLength - 1], (testFs.fs_type == FS_FAT12) ? 0xFFF :
+                                               (testFs.fs_type == FS_FAT16) ? 0xFFFF : 0x0FFFFFFF);
+    // The window of the file system may hold a FAT sector of the last chain
+    testFs.winsect = 0xFFFFFFFF;
+}
+
+static void testOpenFile(FsFile* file, PFdword size)
+{
+    memset(file, 0, sizeof(FsFile));
+    file->fs = &testFs;
+    file->id = testFs.id;
+    file->flag = FA_READ;
+    file->org_clust = (size != 0) ? testChain[0] : 0;
+    file->fsize = size;
+    file->csect = 255;
+}
+
+/* File state left by fsFileSeek, which follows the chain from the first cluster */
+static void testModelSeek(FsFile* file, PFdword ofs)
+{
+    PFdword clustSize = TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE, index = 0;
+
+    if (ofs > file->fsize)
+    {
+        ofs = file->fsize;
+    }
+    file->fptr = 0;
+    file->csect = 255;
+    if (ofs == 0)
+    {
+        return;
+    }
+    file->curr_clust = testChain[0];
+    while (ofs > clustSize)
+    {
+        file->curr_clust = testChain[++index];
+        file->fptr += clustSize;
+        ofs -= clustSize;
+    }
+    file->fptr += ofs;
+    file->csect = (PFbyte)(ofs / DISK_SECTOR_SIZE);
+    if ((ofs % DISK_SECTOR_SIZE) != 0)
+    {
+        file->dsect = (file->curr_clust - 2) * TEST_CLUSTER_SECTORS + testFs.database + file->csect;
+        file->csect++;
+    }
+}
+
+static PFEnBoolean testSameState(const FsFile* a, const FsFile* b)
+{
+    if (a->fptr != b->fptr || a->csect != b->csect)
+    {
+        return enBooleanFalse;
+    }
+    // The cluster is set once the pointer has moved, the sector when it is inside a sector
+    if (a->fptr != 0 && a->curr_clust != b->curr_clust)
+    {
+        return enBooleanFalse;
+    }
+    if ((a->fptr % DISK_SECTOR_SIZE) != 0 && a->dsect != b->dsect)
+    {
+        return enBooleanFalse;
+    }
+    return enBooleanTrue;
+}
+
+static void testLinkMap(PFbyte type)
+{
+    FsFile file;
+    PFdword map[TEST_MAP_SIZE], fragments = 0, k, *entry;
+
+    testMount(type);
+    testMakeChain(6);
+    testOpenFile(&file, testChainLength * TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE);
+    map[0] = TEST_MAP_SIZE;
+    TEST_ASSERT_EQUAL(enStatusSuccess, fsFileLinkMap(&file, map));
+
+    // Fragments of the map cover the chain in order
+    entry = &map[1];
+    k = 0;
+    while (entry[0] != 0)
+    {
+        TEST_ASSERT_EQUAL(testChain[k], entry[1]);
+        TEST_ASSERT(k == 0 || testChain[k] != testChain[k - 1] + 1);
+        k += entry[0];
+        TEST_ASSERT(k <= testChainLength);
+        TEST_ASSERT(k == testChainLength || testChain[k] != testChain[k - 1] + 1);
+        fragments++;
+        entry += 2;
+    }
+    TEST_ASSERT_EQUAL(testChainLength, k);
+    TEST_ASSERT_EQUAL(2 * fragments + 2, map[0]);
+
+    // A buffer too small gives the size needed
+    map[0] = 2 * fragments;
+    TEST_ASSERT_EQUAL(enStatusNoMem, fsFileLinkMap(&file, map));
+    TEST_ASSERT_EQUAL(2 * fragments + 2, map[0]);
+
+    // An empty file has an empty map
+    testOpenFile(&file, 0);
+    map[0] = TEST_MAP_SIZE;
+    TEST_ASSERT_EQUAL(enStatusSuccess, fsFileLinkMap(&file, map));
+    TEST_ASSERT_EQUAL(2, map[0]);
+    TEST_ASSERT_EQUAL(0, map[1]);
+}
+
+static void testBrokenChain(void)
+{
+    FsFile file;
+    PFdword map[TEST_MAP_SIZE];
+
+    testMount(FS_FAT16);
+    testMakeChain(3);
+    testSetFat(testChain[1], 0);
+    testFs.winsect = 0xFFFFFFFF;
+    testOpenFile(&file, testChainLength * TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE);
+    map[0] = TEST_MAP_SIZE;
+    TEST_ASSERT_EQUAL(enStatusInternalError, fsFileLinkMap(&file, map));
+}
+
+static void testSeek(PFbyte type)
+{
+    FsFile fast, model;
+    PFdword map[TEST_MAP_SIZE], round, size, ofs;
+    PFEnBoolean same = enBooleanTrue;
+
+    testMount(type);
+    for (round = 0; round < 20; round++)
+    {
+        testMakeChain(1 + rand() % 12);
+        // The last cluster is partly used
+        size = testChainLength * TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE - rand() % (TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE);
+        testOpenFile(&fast, size);
+        map[0] = TEST_MAP_SIZE;
+        TEST_ASSERT_EQUAL(enStatusSuccess, fsFileLinkMap(&fast, map));
+
+        testDiskReads = 0;
+        for (ofs = 0; ofs <= size + 1; ofs++)
+        {
+            TEST_ASSERT_EQUAL(enStatusSuccess, fsFileSeekFast(&fast, map, ofs));
+            model = fast;
+            testModelSeek(&model, ofs);
+            if (testSameState(&fast, &model) != enBooleanTrue)
+            {
+                printf("  offset %u of %u differs\n", (unsigned)ofs, (unsigned)size);
+                same = enBooleanFalse;
+                break;
+            }
+        }
+        TEST_ASSERT_EQUAL(0, testDiskReads);
+    }
+    TEST_ASSERT(same == enBooleanTrue);
+}
+
+static void testFat12(void)
+{
+    testLinkMap(FS_FAT12);
+    testSeek(FS_FAT12);
+}
+
+static void testFat16(void)
+{
+    testLinkMap(FS_FAT16);
+    testSeek(FS_FAT16);
+}
+
+static void testFat32(void)
+{
+    testLinkMap(FS_FAT32);
+    testSeek(FS_FAT32);
+}
+
+/* Marks all clusters used but the free run, the search for a run starts after the last cluster */
+static void testMountExpand(PFdword freeFirst, PFdword freeCount, PFdword last)
+{
+    PFdword clust;
+
+    testMount(FS_FAT16);
+    for (clust = 2; clust < TEST_MAX_CLUST; clust++)
+    {
+        testSetFat(clust, (clust >= freeFirst && clust < freeFirst + freeCount) ? 0 : 0xFFFF);
+    }
+    testFs.last_clust = last;
+    testFs.free_clust = freeCount;
+}
+
+static PFEnStatus testExpandFile(FsFile* file, PFdword clusters)
+{
+    memset(file, 0, sizeof(FsFile));
+    file->fs = &testFs;
+    file->id = testFs.id;
+    file->flag = FA_READ | FA_WRITE;
+    return fsFileExpand(file, clusters * TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE);
+}
+
+/* The run of the file is one fragment of the link map */
+static PFEnBoolean testIsRun(FsFile* file, PFdword first, PFdword clusters)
+{
+    PFdword map[TEST_MAP_SIZE];
+
+    map[0] = TEST_MAP_SIZE;
+    return (fsFileLinkMap(file, map) == enStatusSuccess && map[0] == 4 &&
+            map[1] == clusters && map[2] == first) ? enBooleanTrue : enBooleanFalse;
+}
+
+static void testExpand(void)
+{
+    FsFile file;
+    PFdword free, last, clusters, failed = 0;
+
+    // Runs of 10 free clusters before, across and after the start of the search at cluster 100
+    for (free = 85; free <= 115; free++)
+    {
+        testMountExpand(free, 10, 99);
+        failed += (testExpandFile(&file, 10) != enStatusSuccess || testIsRun(&file, free, 10) != enBooleanTrue);
+        testMountExpand(free, 10, 99);
+        failed += (testExpandFile(&file, 11) != enStatusAccessDenied);
+        if (failed != 0)
+        {
+            printf("  free run at %u differs\n", (unsigned)free);
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+
+    // Runs at both ends of the FAT, with the search starting anywhere
+    for (last = 0; last < TEST_MAX_CLUST && failed == 0; last += 7)
+    {
+        for (clusters = 1; clusters <= 3; clusters++)
+        {
+            testMountExpand(2, clusters, last);
+            failed += (testExpandFile(&file, clusters) != enStatusSuccess || testIsRun(&file, 2, clusters) != enBooleanTrue);
+            testMountExpand(TEST_MAX_CLUST - clusters, clusters, last);
+            failed += (testExpandFile(&file, clusters) != enStatusSuccess ||
+                       testIsRun(&file, TEST_MAX_CLUST - clusters, clusters) != enBooleanTrue);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+
+    // Only an empty file is expanded
+    testMountExpand(2, 20, 0);
+    TEST_ASSERT_EQUAL(enStatusSuccess, testExpandFile(&file, 4));
+    TEST_ASSERT_EQUAL(enStatusInvState, fsFileExpand(&file, DISK_SECTOR_SIZE));
+}
+
+/* Pre-allocation of the BMP written by bmpSave, against a file grown cluster by cluster */
+static void testExpandWrites(void)
+{
+    FsFile file;
+    struct timespec start, end;
+    PFdword clustSize = TEST_CLUSTER_SECTORS * DISK_SECTOR_SIZE, clusters, round, writes = 0;
+    double seconds = 0;
+
+    clusters = (TEST_BMP_SIZE + clustSize - 1) / clustSize;
+    for (round = 0; round < TEST_EXPAND_ROUNDS; round++)
+    {
+        testMountExpand(2, TEST_MAX_CLUST - 2, 0);
+        testFatWrites = 0;
+        memset(&file, 0, sizeof(FsFile));
+        file.fs = &testFs;
+        file.id = testFs.id;
+        file.flag = FA_READ | FA_WRITE;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        TEST_ASSERT_EQUAL(enStatusSuccess, fsFileExpand(&file, TEST_BMP_SIZE));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        // The window still holds the last FAT sector, it is written at sync
+        writes += testFatWrites + testFs.wflag;
+    }
+    TEST_ASSERT(testIsRun(&file, 2, clusters) == enBooleanTrue);
+
+    // The tiny module writes partial sectors through the window, so each new cluster writes its FAT sector back
+    printf("  %lu byte BMP, %u clusters: expand %.1f us and %.1f FAT sector writes, cluster by cluster %u writes\n",
+           TEST_BMP_SIZE, (unsigned)clusters, seconds / TEST_EXPAND_ROUNDS * 1e6,
+           (double)writes / TEST_EXPAND_ROUNDS, (unsigned)clusters);
+}
+
+static void testInvalid(void)
+{
+    FsFile file;
+    PFdword map[TEST_MAP_SIZE];
+
+    testMount(FS_FAT16);
+    testMakeChain(2);
+    testOpenFile(&file, DISK_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL(enStatusInvalidObject, fsFileLinkMap(&file, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvalidObject, fsFileSeekFast(&file, NULL, 0));
+    file.id = testFs.id + 1;
+    map[0] = TEST_MAP_SIZE;
+    TEST_ASSERT_EQUAL(enStatusInvalidObject, fsFileLinkMap(&file, map));
+    file.id = testFs.id;
+    file.flag |= FA__ERROR;
+    TEST_ASSERT_EQUAL(enStatusInternalError, fsFileSeekFast(&file, map, 0));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testFat12);
+    TEST_RUN(testFat16);
+    TEST_RUN(testFat32);
+    TEST_RUN(testBrokenChain);
+    TEST_RUN(testExpand);
+    TEST_RUN(testExpandWrites);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
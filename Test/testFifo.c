@@ -0,0 +1,431 @@
+/**
+ *  \file       testFifo.c
+ *  \brief      Host stress test of the single producer, single consumer FIFO.
+ *
+ *  A model run pushes and pops at random with every function of the FIFO, on small buffers so that
+ *  the pointers wrap often, and checks the bytes, the fill state and the count field against a
+ *  model of the queue. The stress run has a producer thread and a consumer thread working on the
+ *  same FIFO without locks, the consumer has to get the stream of the producer in order and
+ *  complete. The throughput of the byte and of the block functions is printed. The overwrite run has
+ *  the producer push into a full FIFO while the consumer pops, the bytes which are not dropped have
+ *  to come out in order.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "prime_fifo.h"
+#include "test.h"
+
+#define TEST_MODEL_ROUNDS       200000
+#define TEST_MODEL_MAX_SIZE     40
+#define TEST_STREAM_BYTES       (4UL * 1024 * 1024)
+#define TEST_STREAM_FIFO_SIZE   61
+#define TEST_BLOCK_SIZE         64
+
+static PFFifo testFifo;
+static PFbyte testStorage[4096];
+
+// Model run
+
+static PFbyte testModel[TEST_MODEL_MAX_SIZE];
+static PFdword testModelHead, testModelCount;
+
+static void testModelPush(PFbyte value, PFdword size)
+{
+    testModel[(testModelHead + testModelCount) % size] = value;
+    testModelCount++;
+}
+
+static PFbyte testModelPop(PFdword size)
+{
+    PFbyte value = testModel[testModelHead];
+
+    testModelHead = (testModelHead + 1) % size;
+    testModelCount--;
+    return value;
+}
+
+static void testModelRun(void)
+{
+    PFdword round, size = 2, capacity, n, k, done, failed = 0, contiguous;
+    PFbyte data[TEST_MODEL_MAX_SIZE], *free;
+    PFbyte value = 0;
+
+    for (round = 0; round < TEST_MODEL_ROUNDS; round++)
+    {
+        if ((round % 1000) == 0)
+        {
+            size = 2 + rand() % (TEST_MODEL_MAX_SIZE - 1);
+            TEST_ASSERT_EQUAL(enStatusSuccess, pfFifoInit(&testFifo, testStorage, size));
+            testModelHead = 0;
+            testModelCount = 0;
+        }
+        capacity = size - 1;
+
+        switch (rand() % 7)
+        {
+            case 0:
+#if PF_FIFO_OVERWRITE_ENABLE
+                // A push to a full FIFO drops the oldest byte
+                failed += (pfFifoPush(&testFifo, value) != enBooleanTrue);
+                if (testModelCount == capacity)
+                {
+                    testModelPop(size);
+                }
+                testModelPush(value++, size);
+#else
+                // A push to a full FIFO fails and leaves it unchanged
+                if (pfFifoPush(&testFifo, value) == enBooleanTrue)
+                {
+                    failed += (testModelCount == capacity);
+                    testModelPush(value++, size);
+                }
+                else
+                {
+                    failed += (testModelCount != capacity);
+                }
+#endif
+                break;
+
+            case 1:
+                if (testModelCount != 0)
+                {
+                    failed += (pfFifoPop(&testFifo) != testModelPop(size));
+                }
+                break;
+
+            case 2:
+                n = rand() % (size + 2);
+                n = (n < TEST_MODEL_MAX_SIZE) ? n : TEST_MODEL_MAX_SIZE;
+                for (k = 0; k < n; k++)
+                {
+                    data[k] = (PFbyte)(value + k);
+                }
+                pfFifoWrite(&testFifo, data, n, &done);
+                failed += (done != ((n < capacity - testModelCount) ? n : capacity - testModelCount));
+                for (k = 0; k < done; k++)
+                {
+                    testModelPush(value++, size);
+                }
+                break;
+
+            case 3:
+                n = rand() % (size + 2);
+                n = (n < TEST_MODEL_MAX_SIZE) ? n : TEST_MODEL_MAX_SIZE;
+                pfFifoRead(&testFifo, data, n, &done);
+                failed += (done != ((n < testModelCount) ? n : testModelCount));
+                for (k = 0; k < done; k++)
+                {
+                    failed += (data[k] != testModelPop(size));
+                }
+                break;
+
+            case 4:
+                // The contiguous space ends at the end of the buffer or one byte before the head
+                pfFifoPeekContiguous(&testFifo, &free, &contiguous);
+                failed += (contiguous > capacity - testModelCount);
+                failed += (free != &testStorage[(testModelHead + testModelCount) % size]);
+                failed += (free + contiguous > &testStorage[size]);
+                failed += ((contiguous == 0) != (testModelCount == capacity));
+                n = (contiguous != 0) ? rand() % (contiguous + 1) : 0;
+                for (k = 0; k < n; k++)
+                {
+                    free[k] = value;
+                    testModelPush(value++, size);
+                }
+                TEST_ASSERT_EQUAL(enStatusSuccess, pfFifoCommit(&testFifo, n));
+                TEST_ASSERT_EQUAL(enStatusInvArgs, pfFifoCommit(&testFifo, capacity + 1));
+                break;
+
+            case 5:
+                if ((rand() % 50) == 0)
+                {
+                    pfFifoFlush(&testFifo);
+                    testModelHead = (testModelHead + testModelCount) % size;
+                    testModelCount = 0;
+                }
+                break;
+
+            default:
+                // A pop of an empty FIFO gives 0xFF
+                if (testModelCount == 0)
+                {
+                    failed += (pfFifoPop(&testFifo) != 0xFF);
+                }
+                break;
+        }
+
+#if PF_FIFO_COUNT_ENABLE
+        failed += (testFifo.count != testModelCount);
+#endif
+        failed += ((pfFifoIsEmpty(&testFifo) == enBooleanTrue) != (testModelCount == 0));
+        failed += ((pfFifoIsFull(&testFifo) == enBooleanTrue) != (testModelCount == capacity));
+        if (failed != 0)
+        {
+            printf("  round %u size %u count %u differs\n", (unsigned)round, (unsigned)size, (unsigned)testModelCount);
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+// Stress run
+
+static volatile PFEnBoolean testBlocks;
+static PFdword testStreamErrors;
+
+/* Pushes the stream, a byte counter, by bytes or by blocks of random size */
+static void* testProducer(void* arg)
+{
+    PFbyte block[TEST_BLOCK_SIZE], *free;
+    PFdword sent = 0, n, k, done;
+    unsigned seed = 2;
+
+    (void)arg;
+    while (sent < TEST_STREAM_BYTES)
+    {
+        if (testBlocks != enBooleanTrue)
+        {
+            // A push to a full FIFO would drop a byte of the stream
+            if (pfFifoIsFull(&testFifo) != enBooleanTrue && pfFifoPush(&testFifo, (PFbyte)sent) == enBooleanTrue)
+            {
+                sent++;
+            }
+            else
+            {
+                // On a single core the consumer runs only when the producer gives up its time slice
+                sched_yield();
+            }
+            continue;
+        }
+
+        n = 1 + rand_r(&seed) % TEST_BLOCK_SIZE;
+        if (n > TEST_STREAM_BYTES - sent)
+        {
+            n = TEST_STREAM_BYTES - sent;
+        }
+        if ((n & 1) != 0)
+        {
+            for (k = 0; k < n; k++)
+            {
+                block[k] = (PFbyte)(sent + k);
+            }
+            pfFifoWrite(&testFifo, block, n, &done);
+        }
+        else
+        {
+            // Filled in place like a DMA channel
+            pfFifoPeekContiguous(&testFifo, &free, &done);
+            done = (done < n) ? done : n;
+            for (k = 0; k < done; k++)
+            {
+                free[k] = (PFbyte)(sent + k);
+            }
+            pfFifoCommit(&testFifo, done);
+        }
+        sent += done;
+        if (done == 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void* testConsumer(void* arg)
+{
+    PFbyte block[TEST_BLOCK_SIZE];
+    PFdword received = 0, n, k, done;
+    unsigned seed = 3;
+
+    (void)arg;
+    while (received < TEST_STREAM_BYTES)
+    {
+        if (testBlocks != enBooleanTrue)
+        {
+            if (pfFifoIsEmpty(&testFifo) != enBooleanTrue)
+            {
+                testStreamErrors += (pfFifoPop(&testFifo) != (PFbyte)received);
+                received++;
+            }
+            else
+            {
+                sched_yield();
+            }
+            continue;
+        }
+
+        n = 1 + rand_r(&seed) % TEST_BLOCK_SIZE;
+        pfFifoRead(&testFifo, block, n, &done);
+        for (k = 0; k < done; k++)
+        {
+            testStreamErrors += (block[k] != (PFbyte)(received + k));
+        }
+        received += done;
+        if (done == 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void testStream(PFEnBoolean blocks, const char* name)
+{
+    pthread_t producer, consumer;
+    struct timespec start, end;
+    double seconds;
+
+    pfFifoInit(&testFifo, testStorage, TEST_STREAM_FIFO_SIZE);
+    testBlocks = blocks;
+    testStreamErrors = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(0, pthread_create(&consumer, NULL, testConsumer, NULL));
+    TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, testProducer, NULL));
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    TEST_ASSERT_EQUAL(0, testStreamErrors);
+    TEST_ASSERT(pfFifoIsEmpty(&testFifo) == enBooleanTrue);
+#if PF_FIFO_COUNT_ENABLE
+    TEST_ASSERT_EQUAL(0, testFifo.count);
+#endif
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("  %-6s %lu bytes through %u byte FIFO, %.1f MB/s\n", name, TEST_STREAM_BYTES,
+           TEST_STREAM_FIFO_SIZE, TEST_STREAM_BYTES / seconds / 1e6);
+}
+
+static void testStress(void)
+{
+    testStream(enBooleanFalse, "bytes");
+    testStream(enBooleanTrue, "blocks");
+}
+
+#if PF_FIFO_OVERWRITE_ENABLE
+// Overwrite run
+
+#define TEST_OVERWRITE_ROUNDS   20000
+#define TEST_OVERWRITE_SIZE     8
+
+static volatile PFEnBoolean testOverwriteDone;
+
+/* Pushes 0 to 254 without waiting for the consumer, so most bytes are dropped */
+static void* testOverwriteProducer(void* arg)
+{
+    PFdword k;
+
+    (void)arg;
+    for (k = 0; k < 255; k++)
+    {
+        pfFifoPush(&testFifo, (PFbyte)k);
+        if ((k % 16) == 0)
+        {
+            // Lets the consumer in on a single core
+            sched_yield();
+        }
+    }
+    testOverwriteDone = enBooleanTrue;
+    return NULL;
+}
+
+/* The consumer races the producer for the head, the bytes it gets must still rise strictly */
+static void testOverwrite(void)
+{
+    pthread_t producer;
+    PFdword round, failed = 0, popped = 0, last;
+    PFbyte block[4], c;
+    PFdword k, done;
+
+    for (round = 0; round < TEST_OVERWRITE_ROUNDS; round++)
+    {
+        pfFifoInit(&testFifo, testStorage, TEST_OVERWRITE_SIZE);
+        testOverwriteDone = enBooleanFalse;
+        last = 0xFFFFFFFF;
+        TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, testOverwriteProducer, NULL));
+        while (testOverwriteDone != enBooleanTrue || pfFifoIsEmpty(&testFifo) != enBooleanTrue)
+        {
+            if ((round & 1) != 0)
+            {
+                pfFifoRead(&testFifo, block, sizeof(block), &done);
+            }
+            else if (pfFifoIsEmpty(&testFifo) != enBooleanTrue)
+            {
+                block[0] = pfFifoPop(&testFifo);
+                done = 1;
+            }
+            else
+            {
+                done = 0;
+            }
+            if (done == 0)
+            {
+                sched_yield();
+            }
+            for (k = 0; k < done; k++)
+            {
+                c = block[k];
+                failed += (last != 0xFFFFFFFF && c <= last);
+                last = c;
+            }
+            popped += done;
+        }
+        pthread_join(producer, NULL);
+        failed += (last != 254);
+    }
+    if (failed != 0)
+    {
+        printf("  %u bytes out of order or last byte lost\n", failed);
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    printf("  %u rounds, %.1f of 255 bytes popped per round\n", TEST_OVERWRITE_ROUNDS,
+           (double)popped / TEST_OVERWRITE_ROUNDS);
+}
+#endif
+
+static void testInvalid(void)
+{
+    PFbyte data[4];
+    PFdword done;
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfFifoInit(NULL, testStorage, 8));
+    TEST_ASSERT_EQUAL(enStatusError, pfFifoInit(&testFifo, testStorage, 1));
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfFifoInit(&testFifo, testStorage, 2));
+    TEST_ASSERT(pfFifoPush(&testFifo, 1) == enBooleanTrue);
+#if PF_FIFO_OVERWRITE_ENABLE
+    TEST_ASSERT(pfFifoPush(&testFifo, 2) == enBooleanTrue);
+    TEST_ASSERT_EQUAL(2, pfFifoPop(&testFifo));
+#else
+    TEST_ASSERT(pfFifoPush(&testFifo, 2) == enBooleanFalse);
+    TEST_ASSERT_EQUAL(1, pfFifoPop(&testFifo));
+#endif
+    TEST_ASSERT_EQUAL(0xFF, pfFifoPop(&testFifo));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfFifoWrite(&testFifo, NULL, 1, &done));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfFifoRead(&testFifo, data, 1, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfFifoCommit(NULL, 0));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testModelRun);
+    TEST_RUN(testStress);
+#if PF_FIFO_OVERWRITE_ENABLE
+    TEST_RUN(testOverwrite);
+#endif
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
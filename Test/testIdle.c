@@ -0,0 +1,311 @@
+/**
+ *  \file       testIdle.c
+ *  \brief      Host test of the tick compensation of the idle sleep on a simulated RIT.
+ *
+ *  The module source is built with the RIT registers replaced by variables of the test, and WFI by a
+ *  function which runs the simulated RIT up to the wake up: the compare match of the sleep, a few
+ *  counts late as an interrupt entry, or an earlier interrupt at a random time. The tick interrupt
+ *  pending after the sleep is taken by the test. After every sleep the tick value and the RIT counter
+ *  have to be the ones of a RIT which never stopped, a tick per period, so that the next tick comes
+ *  on time, and the slept time has to be counted in the statistics and in pfIdleGetCycles().
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_tick.h"
+#include "prime_sched.h"
+#include "prime_idle.h"
+#include "test.h"
+
+#define TEST_PERIOD             25000           // RIT counts per tick, 1 ms at PCLK = 25 MHz
+#define TEST_CPU_CLOCK          100000000
+#define TEST_RIT_CLOCK          25000000
+#define TEST_ROUNDS             20000
+#define TEST_MAX_TICKS          500
+
+#define TEST_RIT_INT            0x01
+#define TEST_RIT_ENCLR          0x02
+#define TEST_RIT_EN             0x08
+
+/* Core and RIT stand-in */
+static RIT_TypeDef testRit;
+static DWT_Type testDwt;
+static PFqword testNow;                         // RIT counts since the start of the test
+static PFdword testWakeAfter;                   // Counts to the interrupt which ends the sleep early
+static PFdword testWfiCount;
+static PFEnBoolean testRitInt;                  // Match interrupt flag, cleared only by the tick interrupt
+
+/* Tick module stand-in */
+static PFdword testTicks;
+static PFdword testSuspends, testResumes;
+
+PFdword pfSysGetCpuClock(void)
+{
+    return TEST_CPU_CLOCK;
+}
+
+PFdword pfSysGetPclk(PFdword peripheral)
+{
+    (void)peripheral;
+    return TEST_RIT_CLOCK;
+}
+
+void pfTickAdd(PFdword ticks)
+{
+    testTicks += ticks;
+}
+
+PFdword pfTickGet(void)
+{
+    return testTicks;
+}
+
+/* Runs the RIT until the wake up, the match with a delay of a few counts or another interrupt */
+static void testWfi(void)
+{
+    PFdword toMatch, run;
+
+    testWfiCount++;
+    TEST_ASSERT(testRit.RICTRL & TEST_RIT_EN);
+    TEST_ASSERT(testRit.RICOUNTER < testRit.RICOMPVAL);
+    toMatch = testRit.RICOMPVAL - testRit.RICOUNTER;
+    if (testWakeAfter < toMatch)
+    {
+        run = testWakeAfter;
+        testRit.RICOUNTER += run;
+    }
+    else
+    {
+        // Reset by the match, the counter goes on while the core wakes up
+        run = toMatch + rand() % 4;
+        testRit.RICOUNTER = run - toMatch;
+        testRitInt = enBooleanTrue;
+    }
+    testNow += run;
+}
+
+static void testDsb(void)
+{
+}
+
+/* The interrupt flag of RICTRL is cleared by writing 1, a write of 0 leaves it set */
+static RIT_TypeDef* testRitAccess(void)
+{
+    testRit.RICTRL = (testRitInt == enBooleanTrue) ? (testRit.RICTRL | TEST_RIT_INT) : (testRit.RICTRL & ~TEST_RIT_INT);
+    return &testRit;
+}
+
+#undef DWT
+#undef PERIPH_RIT
+#define DWT                     (&testDwt)
+#define PERIPH_RIT              testRitAccess()
+#define __WFI                   testWfi
+#define __DSB                   testDsb
+
+#include "../Source/PrimeFramework/prime_idle.c"
+
+static void testSuspend(void)
+{
+    testSuspends++;
+}
+
+static void testResume(void)
+{
+    testResumes++;
+}
+
+/* The tick interrupt, taken once the interrupts are enabled again */
+static void testTickInterrupt(void)
+{
+    if (testRitInt == enBooleanTrue)
+    {
+        testRitInt = enBooleanFalse;
+        testTicks++;
+    }
+}
+
+/* Runs the RIT while the core is awake, with the tick interrupts */
+static void testRun(PFdword counts)
+{
+    PFdword step;
+
+    while (counts != 0)
+    {
+        step = testRit.RICOMPVAL - testRit.RICOUNTER;
+        if (counts < step)
+        {
+            testRit.RICOUNTER += counts;
+            testNow += counts;
+            return;
+        }
+        testRit.RICOUNTER = 0;
+        testRitInt = enBooleanTrue;
+        testTickInterrupt();
+        testNow += step;
+        counts -= step;
+    }
+}
+
+static void testOpen(PFdword maxSleepTicks)
+{
+    PFCfgIdle config = {maxSleepTicks, testSuspend, testResume};
+
+    memset(&testRit, 0, sizeof(testRit));
+    memset(&testDwt, 0, sizeof(testDwt));
+    testRit.RICOMPVAL = TEST_PERIOD;
+    testRit.RICTRL = TEST_RIT_ENCLR | TEST_RIT_EN;
+    testRitInt = enBooleanFalse;
+    testNow = 0;
+    testTicks = 0;
+    testWfiCount = 0;
+    testSuspends = 0;
+    testResumes = 0;
+    idleSleptCycles = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfIdleOpen(&config));
+}
+
+/* The ticks and the counter of a RIT which has run without stopping */
+static PFEnBoolean testOnTime(void)
+{
+    return (testTicks == testNow / TEST_PERIOD && testRit.RICOUNTER == testNow % TEST_PERIOD &&
+            testRit.RICOMPVAL == TEST_PERIOD && (testRit.RICTRL & TEST_RIT_EN) != 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+static void testMatch(void)
+{
+    PFIdleStats stats;
+
+    testOpen(0);
+    testRun(1000);
+    testWakeAfter = 0xFFFFFFFF;
+    pfIdleSleep(10);
+    TEST_ASSERT_EQUAL(1, testWfiCount);
+    TEST_ASSERT(testRitInt == enBooleanTrue);
+    testTickInterrupt();
+    TEST_ASSERT_EQUAL(10, testTicks);
+    TEST_ASSERT(testOnTime() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(1, testSuspends);
+    TEST_ASSERT_EQUAL(1, testResumes);
+
+    // A sleep of one tick keeps the compare value
+    testRun(TEST_PERIOD / 2);
+    pfIdleSleep(1);
+    testTickInterrupt();
+    TEST_ASSERT_EQUAL(11, testTicks);
+    TEST_ASSERT(testOnTime() == enBooleanTrue);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfIdleGetStats(&stats));
+    TEST_ASSERT_EQUAL(2, stats.sleeps);
+    TEST_ASSERT_EQUAL(0, stats.earlyWakes);
+    TEST_ASSERT_EQUAL(11, stats.totalTicks);
+}
+
+static void testEarlyWake(void)
+{
+    PFIdleStats stats;
+
+    testOpen(0);
+    testRun(3000);
+    // Woken in the fourth tick, the remainder of the period is kept in the counter
+    testWakeAfter = 3 * TEST_PERIOD + 500;
+    pfIdleSleep(10);
+    TEST_ASSERT(testRitInt == enBooleanFalse);
+    TEST_ASSERT_EQUAL(3, testTicks);
+    TEST_ASSERT_EQUAL(3500, testRit.RICOUNTER);
+    TEST_ASSERT(testOnTime() == enBooleanTrue);
+
+    // The next tick comes a period after the last one
+    testRun(TEST_PERIOD - 3500 - 1);
+    TEST_ASSERT_EQUAL(3, testTicks);
+    testRun(1);
+    TEST_ASSERT_EQUAL(4, testTicks);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfIdleGetStats(&stats));
+    TEST_ASSERT_EQUAL(1, stats.earlyWakes);
+    TEST_ASSERT_EQUAL(3, stats.sleptTicks);
+}
+
+/* Random sleeps, wakes and awake times */
+static void testRandom(void)
+{
+    PFIdleStats stats;
+    PFqword slept = 0, before;
+    PFdword round, failed = 0;
+
+    testOpen(TEST_MAX_TICKS);
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testRun(rand() % (3 * TEST_PERIOD));
+        testWakeAfter = (rand() & 1) ? 0xFFFFFFFF : (PFdword)rand() % (TEST_MAX_TICKS * TEST_PERIOD);
+        before = testNow;
+        pfIdleSleep((rand() % 8 == 0) ? PF_SCHED_NO_TIMEOUT : 1 + (PFdword)rand() % (2 * TEST_MAX_TICKS));
+        slept += testNow - before;
+        testTickInterrupt();
+        if (testOnTime() != enBooleanTrue && failed++ == 0)
+        {
+            printf("  round %u: ticks %u counter %u at %llu\n", (unsigned)round, (unsigned)testTicks,
+                   (unsigned)testRit.RICOUNTER, (unsigned long long)testNow);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    TEST_ASSERT_EQUAL(TEST_ROUNDS, testWfiCount);
+
+    // The longest sleep is maxSleepTicks
+    TEST_ASSERT(slept <= (PFqword)TEST_ROUNDS * (TEST_MAX_TICKS * TEST_PERIOD + 4));
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfIdleGetStats(&stats));
+    TEST_ASSERT_EQUAL(slept / TEST_PERIOD, stats.sleptTicks);
+    TEST_ASSERT_EQUAL(testTicks, stats.totalTicks);
+    TEST_ASSERT_EQUAL((PFdword)(slept * (TEST_CPU_CLOCK / TEST_RIT_CLOCK)), pfIdleGetCycles());
+}
+
+/* A pending tick interrupt is taken before any sleep */
+static void testPending(void)
+{
+    testOpen(0);
+    testRun(TEST_PERIOD - 1);
+    testRit.RICOUNTER = 0;
+    testRitInt = enBooleanTrue;
+    pfIdleSleep(10);
+    TEST_ASSERT_EQUAL(0, testWfiCount);
+    TEST_ASSERT_EQUAL(0, testSuspends);
+    TEST_ASSERT_EQUAL(TEST_PERIOD, testRit.RICOMPVAL);
+    pfIdleSleep(0);
+    TEST_ASSERT_EQUAL(0, testWfiCount);
+}
+
+static void testInvalid(void)
+{
+    PFCfgIdle config = {0, NULL, NULL};
+    PFIdleStats stats;
+
+    testRit.RICTRL = TEST_RIT_EN;
+    TEST_ASSERT_EQUAL(enStatusNotSupported, pfIdleOpen(&config));
+    testRit.RICTRL = TEST_RIT_ENCLR;
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, pfIdleOpen(&config));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfIdleOpen(NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfIdleGetStats(NULL));
+    idleInit = enBooleanFalse;
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, pfIdleGetStats(&stats));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testMatch);
+    TEST_RUN(testEarlyWake);
+    TEST_RUN(testRandom);
+    TEST_RUN(testPending);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
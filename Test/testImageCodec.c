@@ -0,0 +1,434 @@
+/**
+ *  \file       testImageCodec.c
+ *  \brief      Host round trip test and size benchmark of the .pnt and QOI image codecs.
+ *
+ *  The codecs write to and read from a file in memory. Every image is encoded, in bands of rows or
+ *  chunks of pixels of varying size as the save functions give them, decoded back and compared pixel
+ *  by pixel. The encoded sizes of both formats are printed next to the size of the raw pixels. The
+ *  encode and decode throughput of .pnt and QOI is printed next to a 16 bit BMP, written as bmpSave does.
+ *  Decoding a truncated file has to fail without writing past the image.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "pntImage.h"
+#include "qoiImage.h"
+#include "test.h"
+
+#define TEST_WIDTH              240
+#define TEST_HEIGHT             320
+#define TEST_PIXELS             (TEST_WIDTH * TEST_HEIGHT)
+#define TEST_FILE_SIZE          (4 * TEST_PIXELS)
+#define TEST_BAND_ROWS          24
+#define TEST_TIME_ROUNDS        10
+
+#define TEST_RGB565(r, g, b)    ((PFword)((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3)))
+
+typedef struct
+{
+    PFword* next;
+    PFword* end;
+}TestTarget;
+
+static FsFile testFsFile;
+static PFbyte testFile[TEST_FILE_SIZE];
+static PFdword testFileSize;
+static PFdword testFilePos;
+static PFword testImage[TEST_PIXELS];
+static PFword testDecoded[TEST_PIXELS + 1];
+static struct timespec testStart;
+static double testEncodeTime, testDecodeTime;
+
+PFEnStatus fsFileWrite(FsFile* fp, const void* pBuf, PFdword btw, PFdword* bw)
+{
+    (void)fp;
+    if (testFilePos + btw > TEST_FILE_SIZE)
+    {
+        btw = TEST_FILE_SIZE - testFilePos;
+    }
+    memcpy(&testFile[testFilePos], pBuf, btw);
+    testFilePos += btw;
+    if (testFilePos > testFileSize)
+    {
+        testFileSize = testFilePos;
+    }
+    *bw = btw;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileRead(FsFile* fp, void* pBuf, PFdword btr, PFdword* br)
+{
+    (void)fp;
+    if (btr > testFileSize - testFilePos)
+    {
+        btr = testFileSize - testFilePos;
+    }
+    memcpy(pBuf, &testFile[testFilePos], btr);
+    testFilePos += btr;
+    *br = btr;
+    return enStatusSuccess;
+}
+
+static void testTimeStart(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &testStart);
+}
+
+static double testTimeEnd(void)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - testStart.tv_sec) + (end.tv_nsec - testStart.tv_nsec) / 1e9;
+}
+
+static void testRewind(PFdword size)
+{
+    testFileSize = size;
+    testFilePos = 0;
+}
+
+static PFEnStatus testWriter(void* context, PFword color, PFword length)
+{
+    TestTarget* target = (TestTarget*)context;
+
+    if (length > target->end - target->next)
+    {
+        return enStatusNoMem;
+    }
+    while (length-- != 0)
+    {
+        *target->next++ = color;
+    }
+    return enStatusSuccess;
+}
+
+/* Test images, drawn in testImage */
+static void testNoise(PFword width, PFword height)
+{
+    PFdword k;
+
+    for (k = 0; k < (PFdword)width * height; k++)
+    {
+        testImage[k] = (PFword)rand();
+    }
+}
+
+static void testFlat(PFword width, PFword height)
+{
+    PFdword k;
+
+    for (k = 0; k < (PFdword)width * height; k++)
+    {
+        testImage[k] = 0xFFFF;
+    }
+}
+
+static void testGradient(PFword width, PFword height)
+{
+    PFword x, y;
+
+    for (y = 0; y < height; y++)
+    {
+        for (x = 0; x < width; x++)
+        {
+            testImage[y * width + x] = TEST_RGB565(x, y, (x + y) / 2);
+        }
+    }
+}
+
+/* White canvas with strokes and shapes of a few colors, as drawn by the paint application */
+static void testDrawing(PFword width, PFword height)
+{
+    static const PFword colors[] = {0x0000, 0xF800, 0x07E0, 0x001F, 0xFFE0};
+    PFword x, y, k, cx, cy, r, color;
+
+    testFlat(width, height);
+    for (k = 0; k < 12; k++)
+    {
+        cx = rand() % width;
+        cy = rand() % height;
+        r = 3 + rand() % 30;
+        color = colors[rand() % 5];
+        for (y = (cy > r) ? cy - r : 0; y < height && y <= cy + r; y++)
+        {
+            for (x = (cx > r) ? cx - r : 0; x < width && x <= cx + r; x++)
+            {
+                if ((k & 1) != 0 || (x - cx) * (x - cx) + (y - cy) * (y - cy) <= r * r)
+                {
+                    testImage[y * width + x] = color;
+                }
+            }
+        }
+    }
+}
+
+/* Encodes testImage in bands of rows, decodes it back and compares, returns the encoded size */
+static PFdword testPnt(PFword width, PFword height, PntFormat expected)
+{
+    static PntEncoder encoder;
+    PntHeader header;
+    PFword palette[PNT_MAX_PALETTE];
+    PFbyte paletteSize = 0;
+    PFword row, rows;
+    TestTarget target;
+    PFdword size;
+
+    if (pntBuildPalette(testImage, (PFdword)width * height, palette, &paletteSize) != enStatusSuccess)
+    {
+        paletteSize = 0;
+    }
+    testRewind(0);
+    testTimeStart();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntEncodeStart(&encoder, &testFsFile, width, height,
+                                                      (paletteSize != 0) ? palette : NULL, paletteSize));
+    for (row = 0; row < height; row += rows)
+    {
+        rows = 1 + rand() % TEST_BAND_ROWS;
+        if (rows > height - row)
+        {
+            rows = height - row;
+        }
+        TEST_ASSERT_EQUAL(enStatusSuccess, pntEncodeRows(&encoder, &testImage[row * width], rows));
+    }
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntEncodeFinish(&encoder));
+    testEncodeTime = testTimeEnd();
+    size = testFileSize;
+
+    testRewind(size);
+    testDecoded[(PFdword)width * height] = 0x1234;
+    target.next = testDecoded;
+    target.end = &testDecoded[(PFdword)width * height];
+    testTimeStart();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntReadHeader(&testFsFile, &header));
+    TEST_ASSERT_EQUAL(width, header.width);
+    TEST_ASSERT_EQUAL(height, header.height);
+    TEST_ASSERT_EQUAL(expected, header.format);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntDecode(&testFsFile, &header, testWriter, &target));
+    testDecodeTime = testTimeEnd();
+    TEST_ASSERT(target.next == target.end);
+    TEST_ASSERT(memcmp(testDecoded, testImage, (PFdword)width * height * 2) == 0);
+
+    // A truncated file is an error, pixels are only written inside the image
+    testRewind(size - 1 - rand() % (size - PNT_HEADER_SIZE));
+    target.next = testDecoded;
+    if (pntReadHeader(&testFsFile, &header) == enStatusSuccess)
+    {
+        TEST_ASSERT(pntDecode(&testFsFile, &header, testWriter, &target) != enStatusSuccess);
+    }
+    TEST_ASSERT_EQUAL(0x1234, testDecoded[(PFdword)width * height]);
+    return size;
+}
+
+/* Encodes testImage in chunks of pixels, decodes it back and compares, returns the encoded size */
+static PFdword testQoi(PFword width, PFword height)
+{
+    static QoiEncoder encoder;
+    QoiHeader header;
+    PFdword done, count, total = (PFdword)width * height, size;
+    TestTarget target;
+
+    testRewind(0);
+    testTimeStart();
+    TEST_ASSERT_EQUAL(enStatusSuccess, qoiEncodeStart(&encoder, &testFsFile, width, height));
+    for (done = 0; done < total; done += count)
+    {
+        count = 1 + rand() % (TEST_BAND_ROWS * width);
+        if (count > total - done)
+        {
+            count = total - done;
+        }
+        TEST_ASSERT_EQUAL(enStatusSuccess, qoiEncodePixels(&encoder, &testImage[done], count));
+    }
+    TEST_ASSERT_EQUAL(enStatusSuccess, qoiEncodeFinish(&encoder));
+    testEncodeTime = testTimeEnd();
+    size = testFileSize;
+
+    testRewind(size);
+    testDecoded[total] = 0x1234;
+    target.next = testDecoded;
+    target.end = &testDecoded[total];
+    testTimeStart();
+    TEST_ASSERT_EQUAL(enStatusSuccess, qoiReadHeader(&testFsFile, &header));
+    TEST_ASSERT_EQUAL(width, header.width);
+    TEST_ASSERT_EQUAL(height, header.height);
+    TEST_ASSERT_EQUAL(enStatusSuccess, qoiDecode(&testFsFile, &header, testWriter, &target));
+    testDecodeTime = testTimeEnd();
+    TEST_ASSERT(target.next == target.end);
+    TEST_ASSERT(memcmp(testDecoded, testImage, total * 2) == 0);
+
+    // The end marker is not needed for the pixels, cut into the pixel data
+    testRewind(QOI_HEADER_SIZE + rand() % (size - QOI_HEADER_SIZE - QOI_END_MARKER_SIZE));
+    target.next = testDecoded;
+    if (qoiReadHeader(&testFsFile, &header) == enStatusSuccess)
+    {
+        TEST_ASSERT(qoiDecode(&testFsFile, &header, testWriter, &target) != enStatusSuccess);
+    }
+    TEST_ASSERT_EQUAL(0x1234, testDecoded[total]);
+    return size;
+}
+
+/* 16 bit BMP as written by bmpSave, bottom row first and rows padded to 4 bytes, read back row by row */
+static void testBmp(PFword width, PFword height)
+{
+    static const PFbyte padding[4] = {0};
+    PFword row, x;
+    PFdword rowBytes = (PFdword)width * 2, pad = (4 - rowBytes % 4) % 4, done;
+    PFword line[TEST_WIDTH + 2];
+    TestTarget target;
+
+    testRewind(0);
+    testTimeStart();
+    for (row = height; row-- != 0;)
+    {
+        fsFileWrite(&testFsFile, &testImage[row * width], rowBytes, &done);
+        fsFileWrite(&testFsFile, padding, pad, &done);
+    }
+    testEncodeTime = testTimeEnd();
+
+    testRewind(testFileSize);
+    testTimeStart();
+    for (row = height; row-- != 0;)
+    {
+        fsFileRead(&testFsFile, line, rowBytes + pad, &done);
+        target.next = &testDecoded[row * width];
+        target.end = target.next + width;
+        for (x = 0; x < width; x++)
+        {
+            testWriter(&target, line[x], 1);
+        }
+    }
+    testDecodeTime = testTimeEnd();
+    TEST_ASSERT(memcmp(testDecoded, testImage, (PFdword)width * height * 2) == 0);
+}
+
+static void testImageRoundTrip(const char* name, void (*draw)(PFword, PFword), PFword width, PFword height,
+                               PntFormat format)
+{
+    PFdword pnt, qoi;
+
+    draw(width, height);
+    pnt = testPnt(width, height, format);
+    qoi = testQoi(width, height);
+    printf("  %-10s %3ux%-3u %8u %8u %5.1f%% %8u %5.1f%%\n", name, width, height, (unsigned)(width * height * 2),
+           (unsigned)pnt, 100.0 * pnt / (width * height * 2), (unsigned)qoi, 100.0 * qoi / (width * height * 2));
+}
+
+static void testRoundTrip(void)
+{
+    printf("  %-10s %7s %8s %8s %6s %8s %6s\n", "image", "size", "raw", "pnt", "", "qoi", "");
+    testImageRoundTrip("flat", testFlat, TEST_WIDTH, TEST_HEIGHT, enPntPalette);
+    testImageRoundTrip("drawing", testDrawing, TEST_WIDTH, TEST_HEIGHT, enPntPalette);
+    testImageRoundTrip("gradient", testGradient, TEST_WIDTH, TEST_HEIGHT, enPntRle565);
+    testImageRoundTrip("noise", testNoise, TEST_WIDTH, TEST_HEIGHT, enPntRle565);
+    testImageRoundTrip("thumbnail", testDrawing, 60, 80, enPntPalette);
+    testImageRoundTrip("row", testGradient, 300, 1, enPntRle565);
+    testImageRoundTrip("column", testNoise, 1, 300, enPntRle565);
+    testImageRoundTrip("pixel", testNoise, 1, 1, enPntPalette);
+}
+
+/* Encode and decode throughput in MB of raw pixels per second, best of a few rounds */
+static void testImageThroughput(const char* name, void (*draw)(PFword, PFword), PntFormat format)
+{
+    double raw = TEST_PIXELS * 2 / 1e6, bmpEncode = 1e9, bmpDecode = 1e9, pntEncode = 1e9, pntDecode = 1e9;
+    double qoiEncode = 1e9, qoiDecode = 1e9;
+    PFdword round;
+
+    draw(TEST_WIDTH, TEST_HEIGHT);
+    for (round = 0; round < TEST_TIME_ROUNDS; round++)
+    {
+        testBmp(TEST_WIDTH, TEST_HEIGHT);
+        bmpEncode = (testEncodeTime < bmpEncode) ? testEncodeTime : bmpEncode;
+        bmpDecode = (testDecodeTime < bmpDecode) ? testDecodeTime : bmpDecode;
+        testPnt(TEST_WIDTH, TEST_HEIGHT, format);
+        pntEncode = (testEncodeTime < pntEncode) ? testEncodeTime : pntEncode;
+        pntDecode = (testDecodeTime < pntDecode) ? testDecodeTime : pntDecode;
+        testQoi(TEST_WIDTH, TEST_HEIGHT);
+        qoiEncode = (testEncodeTime < qoiEncode) ? testEncodeTime : qoiEncode;
+        qoiDecode = (testDecodeTime < qoiDecode) ? testDecodeTime : qoiDecode;
+    }
+    printf("  %-10s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, raw / bmpEncode, raw / bmpDecode, raw / pntEncode,
+           raw / pntDecode, raw / qoiEncode, raw / qoiDecode);
+}
+
+static void testThroughput(void)
+{
+    printf("  %-10s %8s %8s %8s %8s %8s %8s   MB/s of %ux%u RGB565\n", "image", "bmp enc", "bmp dec", "pnt enc",
+           "pnt dec", "qoi enc", "qoi dec", TEST_WIDTH, TEST_HEIGHT);
+    testImageThroughput("flat", testFlat, enPntPalette);
+    testImageThroughput("drawing", testDrawing, enPntPalette);
+    testImageThroughput("gradient", testGradient, enPntRle565);
+    testImageThroughput("noise", testNoise, enPntRle565);
+}
+
+/* Every RGB565 color survives the conversion to RGB888 and back of the QOI codec */
+static void testQoiColors(void)
+{
+    PFdword k;
+
+    for (k = 0; k < 0x10000; k++)
+    {
+        testImage[k] = (PFword)k;
+    }
+    testQoi(256, 256);
+}
+
+static void testPalette(void)
+{
+    PFword pixels[PNT_MAX_PALETTE + 1], palette[PNT_MAX_PALETTE];
+    PFbyte paletteSize = 0;
+    PFword k;
+    static PntEncoder encoder;
+
+    for (k = 0; k <= PNT_MAX_PALETTE; k++)
+    {
+        pixels[k] = k * 3;
+    }
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntBuildPalette(pixels, PNT_MAX_PALETTE, palette, &paletteSize));
+    TEST_ASSERT_EQUAL(PNT_MAX_PALETTE, paletteSize);
+    // Colors already in the palette are not added again
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntBuildPalette(pixels, 4, palette, &paletteSize));
+    TEST_ASSERT_EQUAL(PNT_MAX_PALETTE, paletteSize);
+    TEST_ASSERT_EQUAL(enStatusNoMem, pntBuildPalette(pixels, PNT_MAX_PALETTE + 1, palette, &paletteSize));
+
+    // A pixel which is not in the palette can not be encoded
+    testRewind(0);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pntEncodeStart(&encoder, &testFsFile, 2, 1, palette, 4));
+    pixels[1] = 0xFFFF;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pntEncodeRows(&encoder, pixels, 1));
+}
+
+static void testNotImage(void)
+{
+    PntHeader pnt;
+    QoiHeader qoi;
+
+    memset(testFile, 0, 64);
+    memcpy(testFile, "BM", 2);
+    testRewind(64);
+    TEST_ASSERT_EQUAL(enStatusNotSupported, pntReadHeader(&testFsFile, &pnt));
+    testRewind(64);
+    TEST_ASSERT_EQUAL(enStatusNotSupported, qoiReadHeader(&testFsFile, &qoi));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testRoundTrip);
+    TEST_RUN(testThroughput);
+    TEST_RUN(testQoiColors);
+    TEST_RUN(testPalette);
+    TEST_RUN(testNotImage);
+    TEST_EXIT();
+}
@@ -0,0 +1,533 @@
+/**
+ *  \file       testMmc.c
+ *  \brief      Host test of the multiple block transfers of the MMC/SDC driver on a simulated card.
+ *
+ *  The driver is built with the SPI functions of its configuration given by the test, which answers
+ *  as an SDHC card in SPI mode does: the command responses, the data tokens after a random number of
+ *  idle bytes, the data response of a written block and a random busy time after it. A megabyte is
+ *  written and read back in runs of 1 to 128 sectors. A run of more than one sector has to be one
+ *  CMD18 read, or one ACMD23 and CMD25 write, and never single block commands. The commands, the
+ *  busy polls and the token polls per megabyte of mmcGetStats() are printed for each run length.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "prime_gpio.h"
+#include "prime_tick.h"
+#include "diskIo.h"
+#include "mmc.h"
+#include "test.h"
+
+#define TEST_SECTOR_SIZE        512
+#define TEST_CARD_SECTORS       2048        /* One megabyte */
+#define TEST_QUEUE_SIZE         1024
+#define TEST_LOG_SIZE           8192
+#define TEST_MAX_GAP            8           /* Idle bytes before a data token at most */
+#define TEST_MAX_BUSY           40          /* Busy bytes after a written block at most */
+#define TEST_STOP_BUSY          60          /* Busy bytes after the stop token */
+#define TEST_ACMD(n)            (0x80 + (n))
+
+/* Receive state of the card */
+typedef enum
+{
+    enCardCommand,                      /* Waiting for a command */
+    enCardWriteWait,                    /* Waiting for the start token of a written block */
+    enCardWriteData                     /* Receiving a written block and its CRC */
+}EnCardState;
+
+static PFbyte testCard[TEST_CARD_SECTORS][TEST_SECTOR_SIZE];
+static PFbyte testData[TEST_CARD_SECTORS * TEST_SECTOR_SIZE];
+static PFbyte testRead[TEST_CARD_SECTORS * TEST_SECTOR_SIZE];
+
+/* Card */
+static PFEnBoolean testSelected = enBooleanFalse;
+static PFbyte testQueue[TEST_QUEUE_SIZE];
+static PFdword testQueueHead, testQueueCount;
+static PFdword testBusy;
+static PFbyte testCmd[6];
+static PFdword testCmdBytes;
+static EnCardState testState = enCardCommand;
+static PFEnBoolean testIdle, testAppCmd, testMultiWrite, testStreaming;
+static PFdword testInitPolls, testSector, testPreErase;
+static PFbyte testBlock[TEST_SECTOR_SIZE + 2];
+static PFdword testBlockBytes;
+static PFdword testRejectBlock = 0xFFFFFFFF;
+static PFdword testCardErrors;
+
+/* Commands received by the card, ACMD<n> as TEST_ACMD(n), CMD55 is not logged */
+static PFbyte testLog[TEST_LOG_SIZE];
+static PFdword testLogCount;
+
+static void testOut(PFbyte data)
+{
+    if (testQueueCount == TEST_QUEUE_SIZE)
+    {
+        testCardErrors++;
+        return;
+    }
+    testQueue[(testQueueHead + testQueueCount++) % TEST_QUEUE_SIZE] = data;
+}
+
+/* A data block as read by CMD17 and CMD18: idle bytes, start token, data and CRC */
+static void testOutBlock(void)
+{
+    PFdword k, gap = 1 + rand() % TEST_MAX_GAP;
+
+    for (k = 0; k < gap; k++)
+    {
+        testOut(0xFF);
+    }
+    if (testSector >= TEST_CARD_SECTORS)
+    {
+        // Out of range error token
+        testOut(0x08);
+        testStreaming = enBooleanFalse;
+        return;
+    }
+    testOut(0xFE);
+    for (k = 0; k < TEST_SECTOR_SIZE; k++)
+    {
+        testOut(testCard[testSector][k]);
+    }
+    testOut(0x12);
+    testOut(0x34);
+    testSector++;
+}
+
+/* Byte the card drives on DO */
+static PFbyte testCardOut(void)
+{
+    PFbyte data;
+
+    if (testSelected != enBooleanTrue)
+    {
+        return 0xFF;
+    }
+    if (testQueueCount == 0 && testBusy == 0 && testStreaming == enBooleanTrue)
+    {
+        testOutBlock();
+    }
+    if (testQueueCount != 0)
+    {
+        data = testQueue[testQueueHead];
+        testQueueHead = (testQueueHead + 1) % TEST_QUEUE_SIZE;
+        testQueueCount--;
+        return data;
+    }
+    if (testBusy != 0)
+    {
+        testBusy--;
+        return 0x00;
+    }
+    return 0xFF;
+}
+
+static void testExecute(void)
+{
+    PFbyte cmd = testCmd[0] & 0x3F;
+    PFdword arg = ((PFdword)testCmd[1] << 24) | ((PFdword)testCmd[2] << 16) | ((PFdword)testCmd[3] << 8) | testCmd[4];
+    PFbyte logged = (testAppCmd == enBooleanTrue) ? TEST_ACMD(cmd) : cmd;
+
+    testAppCmd = enBooleanFalse;
+    if (cmd != 55 && testLogCount < TEST_LOG_SIZE)
+    {
+        testLog[testLogCount++] = logged;
+    }
+
+    // One byte of response time
+    testOut(0xFF);
+    switch (logged)
+    {
+        case 0:
+            testIdle = enBooleanTrue;
+            testInitPolls = 0;
+            testOut(0x01);
+            break;
+
+        case 8:
+            testOut(testIdle);
+            testOut(0x00);
+            testOut(0x00);
+            testOut(0x01);
+            testOut((PFbyte)arg);
+            break;
+
+        case 55:
+            testAppCmd = enBooleanTrue;
+            testOut(testIdle);
+            break;
+
+        case TEST_ACMD(41):
+            // The card leaves the idle state at the third poll
+            if (++testInitPolls >= 3)
+            {
+                testIdle = enBooleanFalse;
+            }
+            testOut(testIdle);
+            break;
+
+        case 58:
+            // Powered up, high capacity
+            testOut(testIdle);
+            testOut(0xC0);
+            testOut(0xFF);
+            testOut(0x80);
+            testOut(0x00);
+            break;
+
+        case 12:
+            testStreaming = enBooleanFalse;
+            testOut(0x00);
+            testBusy = 2;
+            break;
+
+        case 17:
+        case 18:
+            testOut(0x00);
+            testSector = arg;
+            if (logged == 17)
+            {
+                testOutBlock();
+            }
+            else
+            {
+                testStreaming = enBooleanTrue;
+            }
+            break;
+
+        case 24:
+        case 25:
+            testOut((arg < TEST_CARD_SECTORS) ? 0x00 : 0x20);
+            testSector = arg;
+            testMultiWrite = (logged == 25) ? enBooleanTrue : enBooleanFalse;
+            testState = (arg < TEST_CARD_SECTORS) ? enCardWriteWait : enCardCommand;
+            break;
+
+        case TEST_ACMD(23):
+            testPreErase = arg;
+            testOut(0x00);
+            break;
+
+        default:
+            // Illegal command
+            testOut(0x04);
+            break;
+    }
+}
+
+/* Byte the host sends on DI */
+static void testCardIn(PFbyte data)
+{
+    if (testSelected != enBooleanTrue)
+    {
+        return;
+    }
+
+    switch (testState)
+    {
+        case enCardWriteData:
+            testBlock[testBlockBytes++] = data;
+            if (testBlockBytes == TEST_SECTOR_SIZE + 2)
+            {
+                if (testSector == testRejectBlock || testSector >= TEST_CARD_SECTORS)
+                {
+                    // Write error response
+                    testOut(0xED);
+                }
+                else
+                {
+                    memcpy(testCard[testSector], testBlock, TEST_SECTOR_SIZE);
+                    testOut(0xE5);
+                }
+                testSector++;
+                testBusy = 1 + rand() % TEST_MAX_BUSY;
+                testState = (testMultiWrite == enBooleanTrue) ? enCardWriteWait : enCardCommand;
+            }
+            return;
+
+        case enCardWriteWait:
+            if (data == 0xFF)
+            {
+                return;
+            }
+            if (data == ((testMultiWrite == enBooleanTrue) ? 0xFC : 0xFE))
+            {
+                testState = enCardWriteData;
+                testBlockBytes = 0;
+                return;
+            }
+            if (data == 0xFD && testMultiWrite == enBooleanTrue)
+            {
+                testBusy = TEST_STOP_BUSY;
+                testState = enCardCommand;
+                return;
+            }
+            testCardErrors++;
+            testState = enCardCommand;
+            break;
+
+        default:
+            break;
+    }
+
+    if (testCmdBytes == 0)
+    {
+        if ((data & 0xC0) != 0x40)
+        {
+            return;
+        }
+        // A command ends the data stream of CMD18 at once
+        testStreaming = enBooleanFalse;
+        testQueueCount = 0;
+    }
+    testCmd[testCmdBytes++] = data;
+    if (testCmdBytes == sizeof(testCmd))
+    {
+        testCmdBytes = 0;
+        testExecute();
+    }
+}
+
+// SPI functions of the driver configuration
+
+static PFEnStatus testSpiRegister(PFbyte* id, PFpGpioPortPin chipSelect)
+{
+    (void)chipSelect;
+    *id = 0;
+    return enStatusSuccess;
+}
+
+static PFEnStatus testSpiUnregister(PFbyte* id)
+{
+    (void)id;
+    return enStatusSuccess;
+}
+
+static PFEnStatus testSpiChipSelect(PFbyte* id, PFbyte pinStatus)
+{
+    (void)id;
+    testSelected = (pinStatus == 0) ? enBooleanTrue : enBooleanFalse;
+    if (testSelected != enBooleanTrue)
+    {
+        testQueueCount = 0;
+        testCmdBytes = 0;
+        testStreaming = enBooleanFalse;
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus testSpiExchangeByte(PFbyte* id, PFbyte data, PFbyte* rxData)
+{
+    (void)id;
+    *rxData = testCardOut();
+    testCardIn(data);
+    return enStatusSuccess;
+}
+
+static PFEnStatus testSpiWrite(PFbyte* id, PFbyte* data, PFdword size, PFcallback delayCallback)
+{
+    PFbyte rxData;
+    PFdword k;
+
+    (void)delayCallback;
+    for (k = 0; k < size; k++)
+    {
+        testSpiExchangeByte(id, data[k], &rxData);
+    }
+    return enStatusSuccess;
+}
+
+static PFEnStatus testSpiRead(PFbyte* id, PFbyte* data, PFdword size, PFdword* readBytes, PFcallback delayCallback)
+{
+    PFdword k;
+
+    (void)delayCallback;
+    for (k = 0; k < size; k++)
+    {
+        testSpiExchangeByte(id, 0xFF, &data[k]);
+    }
+    *readBytes = size;
+    return enStatusSuccess;
+}
+
+static CfgMmc testConfig =
+{
+    {GPIO_PORT_0, GPIO_PIN_16},
+    {GPIO_PORT_0, GPIO_PIN_17},
+    {GPIO_PORT_0, GPIO_PIN_18},
+    enBooleanFalse,
+    enBooleanFalse,
+    testSpiRegister,
+    testSpiUnregister,
+    testSpiChipSelect,
+    testSpiExchangeByte,
+    testSpiWrite,
+    testSpiRead,
+    NULL,
+    NULL
+};
+
+static PFbyte testDevice;
+
+static void testOpen(void)
+{
+    PFbyte type = 0;
+
+    // The tick does not move, no timeout of the driver expires
+    pfTickSetTimerPeriod(1);
+    TEST_ASSERT_EQUAL(enStatusSuccess, mmcOpen(&testDevice, &testConfig));
+    TEST_ASSERT_EQUAL(enStatusSuccess, mmcGetStatus(testDevice));
+    TEST_ASSERT_EQUAL(enStatusSuccess, mmcIoCtrl(testDevice, MMC_GET_TYPE, &type));
+    TEST_ASSERT_EQUAL(CT_SD2 | CT_BLOCK, type);
+    TEST_ASSERT_EQUAL(0, testCardErrors);
+}
+
+/* Counts the commands of the log since first */
+static PFdword testLogged(PFdword first, PFbyte cmd)
+{
+    PFdword k, count = 0;
+
+    for (k = first; k < testLogCount; k++)
+    {
+        count += (testLog[k] == cmd);
+    }
+    return count;
+}
+
+static void testPrintStats(const char* name, PFdword run, const MmcStats* before, const MmcStats* after)
+{
+    printf("  %-5s runs of %3u: %6u commands, %7u busy polls, %7u token polls per MB\n", name, (unsigned)run,
+           (unsigned)(after->commands - before->commands), (unsigned)(after->busyPolls - before->busyPolls),
+           (unsigned)(after->tokenPolls - before->tokenPolls));
+}
+
+/* Writes and reads back the card in runs of the given number of sectors */
+static void testRuns(PFdword run)
+{
+    MmcStats before, after;
+    PFdword sector, runs = TEST_CARD_SECTORS / run, log, k;
+
+    for (k = 0; k < sizeof(testData); k++)
+    {
+        testData[k] = (PFbyte)rand();
+    }
+
+    mmcGetStats(testDevice, &before);
+    log = testLogCount;
+    for (sector = 0; sector < TEST_CARD_SECTORS; sector += run)
+    {
+        TEST_ASSERT_EQUAL(enStatusSuccess, mmcWrite(testDevice, &testData[sector * TEST_SECTOR_SIZE], sector, run));
+    }
+    mmcGetStats(testDevice, &after);
+    TEST_ASSERT(memcmp(testCard, testData, sizeof(testData)) == 0);
+    TEST_ASSERT_EQUAL(TEST_CARD_SECTORS, after.blocksWritten - before.blocksWritten);
+    if (run > 1)
+    {
+        TEST_ASSERT_EQUAL(runs, after.multiWrites - before.multiWrites);
+        TEST_ASSERT_EQUAL(runs, testLogged(log, 25));
+        TEST_ASSERT_EQUAL(runs, testLogged(log, TEST_ACMD(23)));
+        TEST_ASSERT_EQUAL(0, testLogged(log, 24));
+        TEST_ASSERT_EQUAL(run, testPreErase);
+        // ACMD23 is CMD55 and CMD23
+        TEST_ASSERT_EQUAL(3 * runs, after.commands - before.commands);
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL(TEST_CARD_SECTORS, testLogged(log, 24));
+        TEST_ASSERT_EQUAL(0, testLogged(log, 25));
+    }
+    testPrintStats("write", run, &before, &after);
+
+    memset(testRead, 0, sizeof(testRead));
+    mmcGetStats(testDevice, &before);
+    log = testLogCount;
+    for (sector = 0; sector < TEST_CARD_SECTORS; sector += run)
+    {
+        TEST_ASSERT_EQUAL(enStatusSuccess, mmcRead(testDevice, &testRead[sector * TEST_SECTOR_SIZE], sector, run));
+    }
+    mmcGetStats(testDevice, &after);
+    TEST_ASSERT(memcmp(testRead, testData, sizeof(testData)) == 0);
+    TEST_ASSERT_EQUAL(TEST_CARD_SECTORS, after.blocksRead - before.blocksRead);
+    if (run > 1)
+    {
+        TEST_ASSERT_EQUAL(runs, after.multiReads - before.multiReads);
+        TEST_ASSERT_EQUAL(runs, testLogged(log, 18));
+        TEST_ASSERT_EQUAL(runs, testLogged(log, 12));
+        TEST_ASSERT_EQUAL(0, testLogged(log, 17));
+        TEST_ASSERT_EQUAL(2 * runs, after.commands - before.commands);
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL(TEST_CARD_SECTORS, testLogged(log, 17));
+        TEST_ASSERT_EQUAL(0, testLogged(log, 18));
+    }
+    testPrintStats("read", run, &before, &after);
+    TEST_ASSERT_EQUAL(0, testCardErrors);
+}
+
+static void testMultipleBlocks(void)
+{
+    static const PFdword runs[] = {1, 2, 8, 32, 128};
+    PFdword k;
+
+    testOpen();
+    for (k = 0; k < sizeof(runs) / sizeof(runs[0]); k++)
+    {
+        testLogCount = 0;
+        testRuns(runs[k]);
+    }
+}
+
+/* A block refused by the card ends the write with the stop token, the blocks before it are written */
+static void testWriteError(void)
+{
+    MmcStats before, after;
+
+    testOpen();
+    memset(testCard, 0, sizeof(testCard));
+    mmcGetStats(testDevice, &before);
+    testRejectBlock = 102;
+    TEST_ASSERT_EQUAL(enStatusDiskError, mmcWrite(testDevice, testData, 100, 8));
+    testRejectBlock = 0xFFFFFFFF;
+    mmcGetStats(testDevice, &after);
+    TEST_ASSERT_EQUAL(2, after.blocksWritten - before.blocksWritten);
+    TEST_ASSERT(memcmp(testCard[100], testData, 2 * TEST_SECTOR_SIZE) == 0);
+    TEST_ASSERT(testCard[102][0] == 0 && testCard[102][1] == 0);
+
+    // The card is back in the command state
+    TEST_ASSERT_EQUAL(enStatusSuccess, mmcRead(testDevice, testRead, 100, 2));
+    TEST_ASSERT(memcmp(testRead, testData, 2 * TEST_SECTOR_SIZE) == 0);
+
+    // A read past the end of the card
+    TEST_ASSERT_EQUAL(enStatusDiskError, mmcRead(testDevice, testRead, TEST_CARD_SECTORS - 1, 2));
+    TEST_ASSERT_EQUAL(0, testCardErrors);
+}
+
+static void testInvalid(void)
+{
+    MmcStats stats;
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, mmcRead(testDevice, NULL, 0, 1));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, mmcWrite(testDevice, testData, 0, 0));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, mmcGetStats(MMC_MAX_DEVICE_SUPPORTED, &stats));
+    TEST_ASSERT_EQUAL(enStatusDiskNotReady, mmcRead(testDevice + 1, testRead, 0, 1));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testMultipleBlocks);
+    TEST_RUN(testWriteError);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
@@ -0,0 +1,153 @@
+/**
+ *  \file       testObject.c
+ *  \brief      Host test and benchmark of the object table of the Game Engine.
+ *
+ *  The Object Manager source is built with a table of more than two bitmap words. Objects are created
+ *  and destroyed at random and every Id has to be the lowest free entry, as the Graphics Manager walks
+ *  the table from 0 to getObjectCount() - 1. The time of a create and destroy pair is printed for a
+ *  table nearly full, where the free entry is found in the last word.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+
+#define MAX_OBJECT_NUM          70
+#define TEST_ROUNDS             200000
+#define TEST_BENCH_PAIRS        2000000
+
+#include "fatFs.h"
+#include "gameEngine.h"
+#include "test.h"
+
+/* CLZ instruction stand-in */
+#undef PF_CLZ
+#define PF_CLZ(value)           ((PFbyte)__builtin_clz(value))
+
+#include "../Source/GameEngine/Object/object.c"
+
+static ObjectCfg testConfigs[MAX_OBJECT_NUM];
+static RectangleProperties testProperties;
+static PFEnBoolean testUsed[MAX_OBJECT_NUM];
+
+static PFbyte testLowestFree(void)
+{
+    PFbyte index;
+
+    for (index = 0; index < MAX_OBJECT_NUM && testUsed[index] == enBooleanTrue; index++);
+    return index;
+}
+
+static void testRandom(void)
+{
+    PFdword round, failed = 0, count = 0;
+    PFbyte id, expected;
+
+    for (id = 0; id < MAX_OBJECT_NUM; id++)
+    {
+        testConfigs[id].objProperties = &testProperties;
+        testConfigs[id].type = enStatic;
+    }
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        // More creates than destroys while the table is mostly empty, and the other way round
+        if ((PFdword)(rand() % MAX_OBJECT_NUM) >= count)
+        {
+            expected = testLowestFree();
+            if (expected == MAX_OBJECT_NUM)
+            {
+                failed += (createObject(&id, &testConfigs[0]) != enStatusNoMem);
+                continue;
+            }
+            failed += (createObject(&id, &testConfigs[expected]) != enStatusSuccess);
+            failed += (id != expected);
+            testUsed[id] = enBooleanTrue;
+            count++;
+        }
+        else
+        {
+            do
+            {
+                id = (PFbyte)(rand() % MAX_OBJECT_NUM);
+            } while (testUsed[id] != enBooleanTrue);
+            failed += (destroyObject(id) != enStatusSuccess);
+            failed += (destroyObject(id) != enStatusError);
+            testUsed[id] = enBooleanFalse;
+            count--;
+        }
+
+        failed += (getObjectCount() != count);
+        id = (PFbyte)(rand() % MAX_OBJECT_NUM);
+        failed += (getObject(id) != ((testUsed[id] == enBooleanTrue) ? &testConfigs[id] : NULL));
+        failed += (getGameObjectsPtr(id)->used != testUsed[id]);
+        if (failed != 0)
+        {
+            printf("  round %u count %u differs\n", (unsigned)round, (unsigned)count);
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static void testBenchmark(void)
+{
+    struct timespec start, end;
+    PFdword pair;
+    PFbyte id, last;
+    double seconds;
+
+    // All entries used but the last one
+    while (createObject(&id, &testConfigs[0]) == enStatusSuccess);
+    last = MAX_OBJECT_NUM - 1;
+    TEST_ASSERT_EQUAL(enStatusSuccess, destroyObject(last));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (pair = 0; pair < TEST_BENCH_PAIRS; pair++)
+    {
+        createObject(&id, &testConfigs[0]);
+        destroyObject(id);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST_ASSERT_EQUAL(last, id);
+    TEST_ASSERT_EQUAL(MAX_OBJECT_NUM - 1, getObjectCount());
+
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("  create and destroy of entry %u of %u: %.1f ns\n", (unsigned)last, (unsigned)MAX_OBJECT_NUM,
+           seconds * 1e9 / TEST_BENCH_PAIRS);
+}
+
+static void testInvalid(void)
+{
+    ObjectCfg config;
+    PFbyte id;
+
+    memset(&config, 0, sizeof(config));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, createObject(NULL, &testConfigs[0]));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, createObject(&id, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, createObject(&id, &config));
+    config.objProperties = &testProperties;
+    config.type = enDynamic;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, createObject(&id, &config));
+    TEST_ASSERT_EQUAL(enStatusError, destroyObject(MAX_OBJECT_NUM));
+    TEST_ASSERT(getObject(MAX_OBJECT_NUM) == NULL);
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testRandom);
+    TEST_RUN(testBenchmark);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
@@ -0,0 +1,176 @@
+/**
+ *  \file       testPool.c
+ *  \brief      Host test and benchmark of the fixed-block pool.
+ *
+ *  Blocks are allocated and freed at random, with the main loop and the interrupt functions mixed, and
+ *  checked against a model of the blocks in use: a block is never given twice, stays inside the buffer
+ *  on a block boundary, and the statistics follow the model. The time of an allocation and free pair
+ *  is printed next to the one of malloc() and free() of the C library.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "prime_pool.h"
+#include "test.h"
+
+#define TEST_BLOCK_SIZE         PF_POOL_BLOCK_SIZE(20)
+#define TEST_BLOCK_COUNT        50
+#define TEST_ROUNDS             200000
+#define TEST_BENCH_PAIRS        5000000
+
+static PFPool testPool;
+static PFbyte testStorage[TEST_BLOCK_SIZE * TEST_BLOCK_COUNT] __attribute__((aligned(8)));
+static void* testBlocks[TEST_BLOCK_COUNT];
+static PFdword testUsedCount;
+
+/* Index of a block in the list of the blocks in use, TEST_BLOCK_COUNT if it is not there */
+static PFdword testFind(void* block)
+{
+    PFdword index;
+
+    for (index = 0; index < testUsedCount && testBlocks[index] != block; index++);
+    return (index < testUsedCount) ? index : TEST_BLOCK_COUNT;
+}
+
+static void testInitOrder(void)
+{
+    PFdword index;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfPoolInit(&testPool, testStorage, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT));
+    // The blocks come in the order of the buffer, a freed block is the next one given
+    for (index = 0; index < TEST_BLOCK_COUNT; index++)
+    {
+        testBlocks[index] = pfPoolAlloc(&testPool);
+        TEST_ASSERT(testBlocks[index] == pfPoolBlock(&testPool, index));
+        TEST_ASSERT_EQUAL(index, pfPoolIndex(&testPool, testBlocks[index]));
+    }
+    TEST_ASSERT(pfPoolAlloc(&testPool) == NULL);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfPoolFree(&testPool, testBlocks[7]));
+    TEST_ASSERT(pfPoolAlloc(&testPool) == testBlocks[7]);
+    TEST_ASSERT(pfPoolBlock(&testPool, TEST_BLOCK_COUNT) == NULL);
+}
+
+static void testRandom(void)
+{
+    PFPoolStats stats;
+    PFdword round, index, highWater = 0, failures = 0, failed = 0;
+    PFbyte* block;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfPoolInit(&testPool, testStorage, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT));
+    testUsedCount = 0;
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        // Phases filling the pool up to the failures and phases emptying it
+        if (testUsedCount == 0 || ((((round / 5000) & 1) == 0) ? (rand() % 4 != 0) : (rand() % 4 == 0)))
+        {
+            block = (rand() & 1) ? pfPoolAlloc(&testPool) : pfPoolAllocIsr(&testPool);
+            if (testUsedCount == TEST_BLOCK_COUNT)
+            {
+                failed += (block != NULL);
+                failures++;
+                continue;
+            }
+            failed += (block == NULL || testFind(block) != TEST_BLOCK_COUNT);
+            failed += (block < testStorage || block >= testStorage + sizeof(testStorage));
+            failed += ((PFdword)(block - testStorage) % TEST_BLOCK_SIZE != 0);
+            // The whole block belongs to the caller
+            memset(block, (PFbyte)round, TEST_BLOCK_SIZE);
+            testBlocks[testUsedCount++] = block;
+            highWater = (testUsedCount > highWater) ? testUsedCount : highWater;
+        }
+        else
+        {
+            index = rand() % testUsedCount;
+            block = testBlocks[index];
+            failed += (((rand() & 1) ? pfPoolFree(&testPool, block) : pfPoolFreeIsr(&testPool, block)) != enStatusSuccess);
+            testBlocks[index] = testBlocks[--testUsedCount];
+        }
+
+        if (failed != 0)
+        {
+            printf("  round %u with %u blocks used differs\n", (unsigned)round, (unsigned)testUsedCount);
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfPoolGetStats(&testPool, &stats));
+    TEST_ASSERT_EQUAL(TEST_BLOCK_COUNT, stats.blockCount);
+    TEST_ASSERT_EQUAL(testUsedCount, stats.used);
+    TEST_ASSERT_EQUAL(highWater, stats.highWater);
+    TEST_ASSERT_EQUAL(failures, stats.failures);
+    TEST_ASSERT(failures != 0);
+}
+
+static void testBenchmark(void)
+{
+    struct timespec start, end;
+    volatile PFdword sink = 0;
+    PFdword pair;
+    void* block;
+    double poolNs, mallocNs;
+
+    pfPoolInit(&testPool, testStorage, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (pair = 0; pair < TEST_BENCH_PAIRS; pair++)
+    {
+        block = pfPoolAlloc(&testPool);
+        sink += (PFdword)(size_t)block;
+        pfPoolFree(&testPool, block);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    poolNs = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / TEST_BENCH_PAIRS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (pair = 0; pair < TEST_BENCH_PAIRS; pair++)
+    {
+        block = malloc(TEST_BLOCK_SIZE);
+        sink += (PFdword)(size_t)block;
+        free(block);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    mallocNs = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / TEST_BENCH_PAIRS;
+
+    TEST_ASSERT_EQUAL(0, testPool.used);
+    printf("  alloc and free of %u bytes: pool %.1f ns, malloc %.1f ns\n", (unsigned)TEST_BLOCK_SIZE, poolNs, mallocNs);
+}
+
+static void testInvalid(void)
+{
+    PFPoolStats stats;
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolInit(NULL, testStorage, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolInit(&testPool, NULL, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolInit(&testPool, testStorage, TEST_BLOCK_SIZE, 0));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolInit(&testPool, testStorage, sizeof(void*) + 1, TEST_BLOCK_COUNT));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolInit(&testPool, &testStorage[1], TEST_BLOCK_SIZE, TEST_BLOCK_COUNT));
+
+    // Pointers which are not blocks of the pool are refused
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfPoolInit(&testPool, testStorage, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolFree(&testPool, &testStorage[1]));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolFree(&testPool, testStorage + sizeof(testStorage)));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolFreeIsr(&testPool, &testStorage[TEST_BLOCK_SIZE + 4]));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfPoolGetStats(&testPool, NULL));
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfPoolGetStats(&testPool, &stats));
+    TEST_ASSERT_EQUAL(0, stats.used);
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testInitOrder);
+    TEST_RUN(testRandom);
+    TEST_RUN(testBenchmark);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
@@ -0,0 +1,419 @@
+/**
+ *  \file       testPopUpSave.c
+ *  \brief      Host test and size benchmark of the PopUp background save.
+ *
+ *  The LCD is a screen in memory and the temporary file a file in memory. Backgrounds of several kinds
+ *  are saved, drawn over and restored, the screen has to be the same as before, with and without runs
+ *  spilled to the file. The size of the saved runs is printed next to the size of the pixels, which
+ *  drawPopUp() keeps in its buffer, with the time of the save and of the restore. drawPopUpSaved() has to return at once and restore the background
+ *  when its timer expires.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "prime_timer.h"
+#include "fatFs.h"
+#include "gameEngine.h"
+#include "popUpSave.h"
+#include "test.h"
+
+#define TEST_WIDTH              240
+#define TEST_HEIGHT             320
+#define TEST_FILE_SIZE          (4 * TEST_WIDTH * TEST_HEIGHT)
+#define TEST_TIME_ROUNDS        20
+
+static PFword testScreen[TEST_HEIGHT][TEST_WIDTH];
+static PFword testBefore[TEST_HEIGHT][TEST_WIDTH];
+static PFbyte testFile[TEST_FILE_SIZE];
+static PFdword testFileSize, testFilePos;
+static PFEnBoolean testFileOpen = enBooleanFalse;
+static PFEnBoolean testTimerService = enBooleanTrue;
+static PFTimerCallback testTimerCallback = NULL;
+static PFdword testDelays;
+
+// LCD
+
+/* The board reads the row from one pixel left of xValue, saveImage() and popUpSaveArea() pass x + 1 */
+PFEnStatus readBackground(PFword xValue, PFword yValue, PFword width, PFword height, PFword* backgroundData, PFword size)
+{
+    PFword x, y;
+    PFdword index = 0;
+
+    if ((PFdword)width * height > size)
+    {
+        return enStatusNoMem;
+    }
+    for (y = yValue; y <= yValue + height; y++)
+    {
+        for (x = xValue; x <= xValue + width; x++)
+        {
+            backgroundData[index++] = (x - 1 < TEST_WIDTH) ? testScreen[y][x - 1] : 0;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxFillArea(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color)
+{
+    PFword x, y;
+
+    for (y = yStart; y <= yEnd; y++)
+    {
+        for (x = xStart; x <= xEnd; x++)
+        {
+            testScreen[y][x] = color;
+        }
+    }
+    return enStatusSuccess;
+}
+
+/* Every pixel of the text box is drawn, alternating the font and the back color */
+PFEnStatus drawMessage(MsgConfig* msgAttributes)
+{
+    PFword length = (PFword)pfStrLen(msgAttributes->message);
+    PFword fontWidth = (msgAttributes->fontType == enGfxFont_16X24) ? 16 : 8;
+    PFword fontHeight = (msgAttributes->fontType == enGfxFont_8X8) ? 8 : (msgAttributes->fontType == enGfxFont_8X16) ? 16 : 24;
+    PFword x, y;
+
+    for (y = 0; y < fontHeight; y++)
+    {
+        for (x = 0; x < length * fontWidth; x++)
+        {
+            testScreen[msgAttributes->topLeft.yValue + y][msgAttributes->topLeft.xValue + x] =
+                (PFword)(((x + y) & 1) ? msgAttributes->fontColor : msgAttributes->backColor);
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxDrawRectangle(const PFdword x1, const PFdword y1, const PFdword x2, const PFdword y2)
+{
+    gfxFillArea(x1, y1, x2, y1, BLACK);
+    gfxFillArea(x1, y2, x2, y2, BLACK);
+    gfxFillArea(x1, y1, x1, y2, BLACK);
+    gfxFillArea(x2, y1, x2, y2, BLACK);
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetColor(PFword* color)
+{
+    *color = BLACK;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetPenSize(PFword* size)
+{
+    *size = 2;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetColor(const PFdword color)
+{
+    (void)color;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetPenSize(const PFdword size)
+{
+    (void)size;
+    return enStatusSuccess;
+}
+
+// File system
+
+PFEnStatus fsFileOpen(FsFile* fp, const XCHAR* path, PFbyte mode)
+{
+    (void)fp;
+    (void)path;
+    (void)mode;
+    testFileOpen = enBooleanTrue;
+    testFileSize = 0;
+    testFilePos = 0;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileWrite(FsFile* fp, const void* pBuf, PFdword btw, PFdword* bw)
+{
+    (void)fp;
+    if (testFilePos + btw > TEST_FILE_SIZE)
+    {
+        btw = TEST_FILE_SIZE - testFilePos;
+    }
+    memcpy(&testFile[testFilePos], pBuf, btw);
+    testFilePos += btw;
+    if (testFilePos > testFileSize)
+    {
+        testFileSize = testFilePos;
+    }
+    *bw = btw;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileRead(FsFile* fp, void* pBuf, PFdword btr, PFdword* br)
+{
+    (void)fp;
+    if (btr > testFileSize - testFilePos)
+    {
+        btr = testFileSize - testFilePos;
+    }
+    memcpy(pBuf, &testFile[testFilePos], btr);
+    testFilePos += btr;
+    *br = btr;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeek(FsFile* fp, PFdword ofs)
+{
+    (void)fp;
+    testFilePos = (ofs < testFileSize) ? ofs : testFileSize;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileClose(FsFile* fp)
+{
+    (void)fp;
+    testFileOpen = enBooleanFalse;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileDelete(const XCHAR* path)
+{
+    (void)path;
+    testFileSize = 0;
+    return enStatusSuccess;
+}
+
+// Tick and timer services
+
+PFdword pfTickSetTimeoutMs(PFdword time)
+{
+    return time;
+}
+
+void pfTickDelayMs(PFdword delayMs)
+{
+    (void)delayMs;
+    testDelays++;
+}
+
+PFEnStatus pfTimerStart(PFTimer* timer, PFTimerCallback callback, void* context, PFdword timeMs, PFEnBoolean periodic)
+{
+    (void)context;
+    (void)timeMs;
+    (void)periodic;
+    if (testTimerService != enBooleanTrue)
+    {
+        return enStatusNotEnabled;
+    }
+    testTimerCallback = callback;
+    timer->ppPrev = &timer->pNext;
+    return enStatusSuccess;
+}
+
+void pfTimerStop(PFTimer* timer)
+{
+    timer->ppPrev = NULL;
+}
+
+PFEnBoolean pfTimerIsRunning(const PFTimer* timer)
+{
+    return (timer->ppPrev != NULL) ? enBooleanTrue : enBooleanFalse;
+}
+
+/* Calls the callback of the running timer, as pfTimerProcess() does at its expiry */
+static void testTimerExpire(PFTimer* timer)
+{
+    TEST_ASSERT(pfTimerIsRunning(timer) == enBooleanTrue);
+    pfTimerStop(timer);
+    testTimerCallback(timer);
+}
+
+#include "../Source/GameEngine/Graphics/popUpSave.c"
+
+// Backgrounds
+
+typedef enum
+{
+    enTestFlat = 0,
+    enTestToolbar,
+    enTestDrawing,
+    enTestNoise,
+    enTestKinds
+}EnTestKind;
+
+static const char* testKindName[enTestKinds] = {"flat", "toolbar", "drawing", "noise"};
+
+static void testFillScreen(EnTestKind kind)
+{
+    PFword x, y, k;
+
+    gfxFillArea(0, 0, TEST_WIDTH - 1, TEST_HEIGHT - 1, WHITE);
+    switch (kind)
+    {
+        case enTestToolbar:
+            // Buttons with a border and an icon, like the toolbar of the paint application
+            for (x = 0; x < TEST_WIDTH; x += 34)
+            {
+                gfxDrawRectangle(x, 0, (x + 33 < TEST_WIDTH) ? x + 33 : TEST_WIDTH - 1, 42);
+                gfxFillArea(x + 8, 10, x + 24 < TEST_WIDTH ? x + 24 : TEST_WIDTH - 1, 32, (PFword)(x * 97));
+            }
+            break;
+
+        case enTestDrawing:
+            // Strokes of a pen 2 pixels wide in a few colors
+            for (k = 0; k < 40; k++)
+            {
+                x = (PFword)(rand() % (TEST_WIDTH - 60));
+                y = (PFword)(rand() % (TEST_HEIGHT - 60));
+                gfxFillArea(x, y, x + 1 + rand() % 58, y + 1, (k & 1) ? BLACK : RED);
+                gfxFillArea(x, y, x + 1, y + 1 + rand() % 58, BLUE);
+            }
+            break;
+
+        case enTestNoise:
+            for (y = 0; y < TEST_HEIGHT; y++)
+            {
+                for (x = 0; x < TEST_WIDTH; x++)
+                {
+                    testScreen[y][x] = (PFword)rand();
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+    memcpy(testBefore, testScreen, sizeof(testScreen));
+}
+
+static PFEnBoolean testScreenRestored(void)
+{
+    return (memcmp(testBefore, testScreen, sizeof(testScreen)) == 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+static double testSeconds(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void testRoundTrip(void)
+{
+    static const PFword areas[][4] = {{95, 150, 50, 20}, {0, 0, 240, 43}, {20, 100, 200, 60}, {0, 45, 240, 275},
+                                      {0, 0, 240, 320}};
+    PopUpSaveStats stats;
+    struct timespec start, saved, end;
+    PFdword kind, area, round;
+    double saveTime, restoreTime;
+
+    // Sizes in bytes, raw is the buffer drawPopUp() needs for the area, times in us
+    printf("  %-8s %-9s %7s %7s %7s %7s %9s %7s %7s\n", "kind", "area", "pixels", "raw", "runs", "spilled", "restored",
+           "save", "restore");
+    for (kind = 0; kind < enTestKinds; kind++)
+    {
+        for (area = 0; area < sizeof(areas) / sizeof(areas[0]); area++)
+        {
+            testFillScreen((EnTestKind)kind);
+            saveTime = 0;
+            restoreTime = 0;
+            for (round = 0; round < TEST_TIME_ROUNDS; round++)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                TEST_ASSERT_EQUAL(enStatusSuccess, popUpSaveArea(areas[area][0], areas[area][1], areas[area][2], areas[area][3]));
+                clock_gettime(CLOCK_MONOTONIC, &saved);
+                gfxFillArea(areas[area][0], areas[area][1], areas[area][0] + areas[area][2] - 1,
+                            areas[area][1] + areas[area][3] - 1, GREEN);
+                saveTime += testSeconds(&start, &saved);
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                TEST_ASSERT_EQUAL(enStatusSuccess, popUpRestoreArea(NULL));
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                restoreTime += testSeconds(&start, &end);
+                TEST_ASSERT(testScreenRestored() == enBooleanTrue);
+                TEST_ASSERT(testFileOpen == enBooleanFalse);
+            }
+
+            popUpSaveGetStats(&stats);
+            TEST_ASSERT_EQUAL((PFdword)areas[area][2] * areas[area][3], stats.pixels);
+            TEST_ASSERT_EQUAL(stats.pixels, stats.pixelsRestored);
+            TEST_ASSERT_EQUAL((stats.runs > POPUP_SAVE_BUFFER_SIZE) ? stats.runs * sizeof(PopUpRun) : 0, stats.spilledBytes);
+            printf("  %-8s %3ux%-5u %7u %7u %7u %7u %9u %7.1f %7.1f\n", testKindName[kind], areas[area][2], areas[area][3],
+                   (unsigned)stats.pixels, (unsigned)(stats.pixels * sizeof(PFword)),
+                   (unsigned)(stats.runs * sizeof(PopUpRun)), (unsigned)stats.spilledBytes, (unsigned)stats.pixelsRestored,
+                   saveTime / TEST_TIME_ROUNDS * 1e6, restoreTime / TEST_TIME_ROUNDS * 1e6);
+        }
+    }
+}
+
+/* Pixels the PopUp left as filled are not written again */
+static void testSkipFill(void)
+{
+    PopUpCfg config = {{"test", {20, 100}, {200, 60}, WHITE, enBooleanTrue}};
+    PopUpSaveStats stats;
+
+    testFillScreen(enTestFlat);
+    testTimerService = enBooleanFalse;
+    testDelays = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, drawPopUpSaved(&config, "SAVED", 1000, enGfxFont_8X16, BLACK));
+    TEST_ASSERT_EQUAL(1, testDelays);
+    TEST_ASSERT(testScreenRestored() == enBooleanTrue);
+    popUpSaveGetStats(&stats);
+    // The border and the text box, 5 characters of 8x16
+    TEST_ASSERT_EQUAL(2 * 200 + 2 * 58 + 5 * 8 * 16, stats.pixelsRestored);
+    testTimerService = enBooleanTrue;
+}
+
+/* drawPopUpSaved() returns with the PopUp shown, the timer restores the background */
+static void testTimer(void)
+{
+    PopUpCfg first = {{"first", {0, 0}, {240, 43}, WHITE, enBooleanTrue}};
+    PopUpCfg second = {{"second", {20, 30}, {200, 60}, YELLOW, enBooleanFalse}};
+
+    testFillScreen(enTestToolbar);
+    testDelays = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, drawPopUpSaved(&first, "Saved image_1.bmp", 2000, enGfxFont_8X16, BLACK));
+    TEST_ASSERT_EQUAL(0, testDelays);
+    TEST_ASSERT(testScreenRestored() == enBooleanFalse);
+    testTimerExpire(&popUpTimer);
+    TEST_ASSERT(testScreenRestored() == enBooleanTrue);
+    TEST_ASSERT(pfTimerIsRunning(&popUpTimer) == enBooleanFalse);
+
+    // A second PopUp over the first one, the first is taken down before its background is saved
+    TEST_ASSERT_EQUAL(enStatusSuccess, drawPopUpSaved(&first, "Saved image_2.bmp", 2000, enGfxFont_8X16, BLACK));
+    TEST_ASSERT_EQUAL(enStatusSuccess, drawPopUpSaved(&second, "NO SDCARD", 2000, enGfxFont_16X24, RED));
+    TEST_ASSERT(testScreenRestored() == enBooleanFalse);
+    testTimerExpire(&popUpTimer);
+    TEST_ASSERT(testScreenRestored() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(0, testDelays);
+}
+
+static void testInvalid(void)
+{
+    PopUpCfg config = {{"test", {0, 0}, {40, 20}, WHITE, enBooleanTrue}};
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, popUpSaveArea(0, 0, 0, 10));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, popUpSaveArea(0, 0, POPUP_SAVE_MAX_WIDTH + 1, 10));
+    TEST_ASSERT_EQUAL(enStatusInvState, popUpRestoreArea(NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, drawPopUpSaved(NULL, "A", 10, enGfxFont_8X16, BLACK));
+    TEST_ASSERT_EQUAL(enStatusNoMem, drawPopUpSaved(&config, "TOO LONG", 10, enGfxFont_8X16, BLACK));
+    TEST_ASSERT(pfTimerIsRunning(&popUpTimer) == enBooleanFalse);
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testRoundTrip);
+    TEST_RUN(testSkipFill);
+    TEST_RUN(testTimer);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
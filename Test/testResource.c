@@ -0,0 +1,570 @@
+/**
+ *  \file       testResource.c
+ *  \brief      Host test and benchmark of the image cache of the resource manager.
+ *
+ *  The images are 16 bit BMP files of a file system in memory which counts the files opened and the
+ *  bytes read, the FatFs module itself only being built for the board. getImage() is called as the
+ *  windows of an application load their images on every switch, and after each call the statistics
+ *  of the cache are compared with a model of its least recently used policy, the image with the
+ *  file, the reads with the misses and the pool with the images it should hold: packed from its start
+ *  in the order of the offsets, so the data moved down by the removal of an image has its offset moved
+ *  with it. An image changed on the card is loaded again after it is invalidated. The reads and the
+ *  time per window switch are printed with and without the cache.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "test.h"
+
+#define TEST_FILES              16
+#define TEST_BMP_HEADER_SIZE    54
+#define TEST_MAX_PIXELS         (64 * 80)
+#define TEST_SWITCHES           400
+
+// File system
+
+/* File of the file system, a 16 bit BMP stored bottom row first */
+typedef struct
+{
+    const char* name;
+    PFword width;
+    PFword height;
+    PFdword version;
+    PFbyte* data;
+    PFdword size;
+}TestFile;
+
+static TestFile testFiles[TEST_FILES] =
+{
+    {"icon/pen.bmp", 16, 16, 0, NULL, 0},
+    {"icon/eraser.bmp", 16, 16, 0, NULL, 0},
+    {"icon/fill.bmp", 15, 17, 0, NULL, 0},
+    {"icon/save.bmp", 16, 16, 0, NULL, 0},
+    {"icon/open.bmp", 16, 16, 0, NULL, 0},
+    {"menu/bar.bmp", 120, 8, 0, NULL, 0},
+    {"menu/ok.bmp", 31, 20, 0, NULL, 0},
+    {"menu/cancel.bmp", 31, 20, 0, NULL, 0},
+    {"game/ball.bmp", 20, 20, 0, NULL, 0},
+    {"game/paddle.bmp", 40, 10, 0, NULL, 0},
+    {"game/brick.bmp", 24, 12, 0, NULL, 0},
+    {"game/back.bmp", 64, 40, 0, NULL, 0},
+    {"game/title.bmp", 64, 64, 0, NULL, 0},
+    {"gallery/frame.bmp", 48, 48, 0, NULL, 0},
+    {"gallery/big.bmp", 64, 80, 0, NULL, 0},
+    {"gallery/a_very_long_name.bmp", 8, 8, 0, NULL, 0}
+};
+
+static TestFile* testOpenFile;
+static PFdword testOpens, testReads, testBytesRead;
+
+/* Pixel of an image in RGB format, the version changes when the file is written again */
+static PFword testPixel(const TestFile* file, PFword x, PFword y)
+{
+    return (PFword)((file - testFiles) * 0x0841 + file->version * 0x1234 + y * 0x0101 + x * 0x0020);
+}
+
+static PFword testBgr(PFword color)
+{
+    return (PFword)(((color & 0x001F) << 11) | (color & 0x07E0) | (color >> 11));
+}
+
+PFword bgrToRgb(PFword color)
+{
+    return testBgr(color);
+}
+
+static void testStore32(PFbyte* ptr, PFdword value)
+{
+    ptr[0] = (PFbyte)value;
+    ptr[1] = (PFbyte)(value >> 8);
+    ptr[2] = (PFbyte)(value >> 16);
+    ptr[3] = (PFbyte)(value >> 24);
+}
+
+static void testWriteFile(TestFile* file)
+{
+    PFdword rowSize = ((PFdword)file->width * 2 + 3) & ~3UL;
+    PFbyte* ptr;
+    PFword x, y;
+
+    file->size = TEST_BMP_HEADER_SIZE + rowSize * file->height;
+    free(file->data);
+    file->data = calloc(1, file->size);
+    file->data[0] = 'B';
+    file->data[1] = 'M';
+    testStore32(&file->data[2], file->size);
+    testStore32(&file->data[10], TEST_BMP_HEADER_SIZE);
+    testStore32(&file->data[14], 40);
+    testStore32(&file->data[18], file->width);
+    testStore32(&file->data[22], file->height);
+    file->data[26] = 1;
+    file->data[28] = 16;
+    for (y = 0; y < file->height; y++)
+    {
+        ptr = &file->data[TEST_BMP_HEADER_SIZE + (file->height - 1 - y) * rowSize];
+        for (x = 0; x < file->width; x++)
+        {
+            ptr[2 * x] = (PFbyte)testBgr(testPixel(file, x, y));
+            ptr[2 * x + 1] = (PFbyte)(testBgr(testPixel(file, x, y)) >> 8);
+        }
+    }
+}
+
+PFEnStatus fsFileOpen(FsFile* fp, const XCHAR* path, PFbyte mode)
+{
+    PFdword k;
+
+    if (testOpenFile != NULL)
+    {
+        return enStatusBusy;
+    }
+    for (k = 0; k < TEST_FILES; k++)
+    {
+        if (strcmp(testFiles[k].name, (const char*)path) == 0)
+        {
+            memset(fp, 0, sizeof(FsFile));
+            fp->flag = mode;
+            fp->fsize = testFiles[k].size;
+            testOpenFile = &testFiles[k];
+            testOpens++;
+            return enStatusSuccess;
+        }
+    }
+    return enStatusNoFile;
+}
+
+PFEnStatus fsFileRead(FsFile* fp, void* pBuf, PFdword btr, PFdword* br)
+{
+    if (testOpenFile == NULL)
+    {
+        return enStatusInvalidObject;
+    }
+    *br = (fp->fptr + btr > fp->fsize) ? fp->fsize - fp->fptr : btr;
+    memcpy(pBuf, &testOpenFile->data[fp->fptr], *br);
+    fp->fptr += *br;
+    testReads++;
+    testBytesRead += *br;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeek(FsFile* fp, PFdword ofs)
+{
+    fp->fptr = (ofs > fp->fsize) ? fp->fsize : ofs;
+    return enStatusSuccess;
+}
+
+/* The images are opened without a link map */
+PFEnStatus fsFileSeekFast(FsFile* fp, const PFdword* map, PFdword ofs)
+{
+    (void)map;
+    return fsFileSeek(fp, ofs);
+}
+
+PFEnStatus fsFileLinkMap(FsFile* fp, PFdword* map)
+{
+    (void)fp;
+    (void)map;
+    return enStatusNotSupported;
+}
+
+PFEnStatus fsFileClose(FsFile* fp)
+{
+    (void)fp;
+    testOpenFile = NULL;
+    return enStatusSuccess;
+}
+
+#include "../Source/GameEngine/Resource/resource.c"
+
+// Model of the cache
+
+/* Cached files, least recently used first */
+static PFdword testModel[RESOURCE_CACHE_ENTRIES];
+static PFdword testModelCount;
+static ResourceCacheStats testModelStats;
+
+static PFdword testSize(PFdword file)
+{
+    return (PFdword)testFiles[file].width * testFiles[file].height * sizeof(PFword);
+}
+
+static void testModelRemove(PFdword position)
+{
+    testModelStats.bytesUsed -= testSize(testModel[position]);
+    memmove(&testModel[position], &testModel[position + 1], (testModelCount - position - 1) * sizeof(PFdword));
+    testModelCount--;
+}
+
+static void testModelGet(PFdword file)
+{
+    PFdword k;
+
+    for (k = 0; k < testModelCount; k++)
+    {
+        if (testModel[k] == file)
+        {
+            testModelRemove(k);
+            testModel[testModelCount++] = file;
+            testModelStats.bytesUsed += testSize(file);
+            testModelStats.hits++;
+            return;
+        }
+    }
+    testModelStats.misses++;
+    if (strlen(testFiles[file].name) + 1 > RESOURCE_CACHE_PATH_SIZE || testSize(file) > RESOURCE_CACHE_POOL_SIZE)
+    {
+        testModelStats.uncached++;
+        return;
+    }
+    while (testModelCount == RESOURCE_CACHE_ENTRIES ||
+           testModelStats.bytesUsed + testSize(file) > RESOURCE_CACHE_POOL_SIZE)
+    {
+        testModelRemove(0);
+        testModelStats.evictions++;
+    }
+    testModel[testModelCount++] = file;
+    testModelStats.bytesUsed += testSize(file);
+}
+
+static void testModelInvalidate(PFdword file)
+{
+    PFdword k;
+
+    for (k = 0; k < testModelCount; k++)
+    {
+        if (testModel[k] == file)
+        {
+            testModelRemove(k);
+            return;
+        }
+    }
+}
+
+// Test
+
+static PFword testBuffer[TEST_MAX_PIXELS];
+
+static PFEnBoolean testSameImage(PFdword file, const PFword* pixels)
+{
+    PFword x, y;
+
+    for (y = 0; y < testFiles[file].height; y++)
+    {
+        for (x = 0; x < testFiles[file].width; x++)
+        {
+            if (*pixels++ != testPixel(&testFiles[file], x, y))
+            {
+                return enBooleanFalse;
+            }
+        }
+    }
+    return enBooleanTrue;
+}
+
+static ResourceCacheEntry* testEntry(PFdword file)
+{
+    return resourceCacheFind((const PFbyte*)testFiles[file].name, enImageBmpFormat);
+}
+
+/* The pool holds the images of the model packed from its start, each entry with the data of its file */
+static PFdword testCheckPool(void)
+{
+    PFdword failed = 0, k, offset = 0;
+    ResourceCacheEntry* entry;
+    PFbyte index, used = 0;
+
+    for (k = 0; k < testModelCount; k++)
+    {
+        entry = testEntry(testModel[k]);
+        failed += (entry == NULL || entry->size != testSize(testModel[k]) ||
+                   testSameImage(testModel[k], (const PFword*)&resourceCachePool[entry->offset]) != enBooleanTrue);
+    }
+    // Walking the entries in the order of their offsets covers the used part of the pool without a gap
+    for (;;)
+    {
+        for (index = 0; index < RESOURCE_CACHE_ENTRIES; index++)
+        {
+            if (resourceCacheEntries[index].used == enBooleanTrue && resourceCacheEntries[index].offset == offset)
+            {
+                break;
+            }
+        }
+        if (index == RESOURCE_CACHE_ENTRIES)
+        {
+            break;
+        }
+        offset += resourceCacheEntries[index].size;
+        used++;
+    }
+    failed += (used != testModelCount || offset != testModelStats.bytesUsed);
+    return failed;
+}
+
+/* Loads an image and checks it, the statistics, the reads and the pool against the model */
+static PFdword testGet(PFdword file)
+{
+    ImageCfg config = {enSDCard, enImageBmpFormat, (PFbyte*)testFiles[file].name, testBuffer};
+    ResourceCacheStats stats;
+    PFdword failed = 0, opens = testOpens, hits = testModelStats.hits;
+
+    memset(testBuffer, 0, sizeof(testBuffer));
+    failed += (getImage(&config) != enStatusSuccess);
+    failed += (testSameImage(file, testBuffer) != enBooleanTrue);
+    testModelGet(file);
+    resourceCacheGetStats(&stats);
+    failed += (memcmp(&stats, &testModelStats, sizeof(stats)) != 0);
+    // Only a miss reads the card
+    failed += (testOpens - opens != ((testModelStats.hits != hits) ? 0U : 1U));
+    failed += testCheckPool();
+    return failed;
+}
+
+static void testReset(void)
+{
+    resourceCacheInvalidate(NULL);
+    memset(&resourceCacheStats, 0, sizeof(resourceCacheStats));
+    memset(&testModelStats, 0, sizeof(testModelStats));
+    testModelCount = 0;
+    testOpens = 0;
+    testReads = 0;
+    testBytesRead = 0;
+}
+
+/* Hits, misses and the least recently used image evicted with the pool compacted behind it */
+static void testEviction(void)
+{
+    PFdword failed = 0;
+
+    testReset();
+    // Back, bar and pen take 7552 bytes of the pool
+    failed += testGet(11);
+    failed += testGet(5);
+    failed += testGet(0);
+    TEST_ASSERT_EQUAL(7552, resourceCacheStats.bytesUsed);
+    TEST_ASSERT_EQUAL(7040, testEntry(0)->offset);
+    failed += testGet(11);
+    failed += testGet(0);
+    TEST_ASSERT_EQUAL(3, testOpens);
+    TEST_ASSERT_EQUAL(2, resourceCacheStats.hits);
+
+    // The bar is the least recently used, the pen is moved down over it and the ok button goes behind
+    failed += testGet(6);
+    TEST_ASSERT_EQUAL(1, resourceCacheStats.evictions);
+    TEST_ASSERT(testEntry(5) == NULL);
+    TEST_ASSERT_EQUAL(0, testEntry(11)->offset);
+    TEST_ASSERT_EQUAL(5120, testEntry(0)->offset);
+    TEST_ASSERT_EQUAL(5632, testEntry(6)->offset);
+    TEST_ASSERT_EQUAL(6872, resourceCacheStats.bytesUsed);
+
+    // The title takes the whole pool
+    failed += testGet(12);
+    TEST_ASSERT_EQUAL(4, resourceCacheStats.evictions);
+    TEST_ASSERT_EQUAL(RESOURCE_CACHE_POOL_SIZE, resourceCacheStats.bytesUsed);
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+/* The oldest image is evicted when all the entries are used, even if the pool has room */
+static void testEntries(void)
+{
+    static const PFdword files[] = {0, 1, 2, 3, 4, 8, 9, 10};
+    PFdword failed = 0, k;
+
+    testReset();
+    for (k = 0; k < RESOURCE_CACHE_ENTRIES; k++)
+    {
+        failed += testGet(files[k]);
+    }
+    TEST_ASSERT_EQUAL(0, resourceCacheStats.evictions);
+    TEST_ASSERT(resourceCacheStats.bytesUsed + testSize(6) <= RESOURCE_CACHE_POOL_SIZE);
+    failed += testGet(files[0]);
+    failed += testGet(6);
+    TEST_ASSERT_EQUAL(1, resourceCacheStats.evictions);
+    TEST_ASSERT(testEntry(files[0]) != NULL);
+    TEST_ASSERT(testEntry(files[1]) == NULL);
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+/* An image larger than the pool or with a long path is loaded every time */
+static void testUncached(void)
+{
+    PFdword failed = 0;
+
+    testReset();
+    failed += testGet(0);
+    failed += testGet(14);
+    failed += testGet(15);
+    failed += testGet(14);
+    failed += testGet(15);
+    TEST_ASSERT_EQUAL(5, testOpens);
+    TEST_ASSERT_EQUAL(4, resourceCacheStats.uncached);
+    TEST_ASSERT_EQUAL(0, resourceCacheStats.evictions);
+    TEST_ASSERT(testEntry(0) != NULL);
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+/* A changed file is loaded again once invalidated, the images behind it are moved down */
+static void testInvalidate(void)
+{
+    ImageCfg config = {enSDCard, enImageBmpFormat, (PFbyte*)testFiles[1].name, testBuffer};
+    PFdword failed = 0;
+
+    testReset();
+    failed += testGet(0);
+    failed += testGet(1);
+    failed += testGet(2);
+
+    // The cache does not know the file changed
+    testFiles[1].version++;
+    testWriteFile(&testFiles[1]);
+    TEST_ASSERT_EQUAL(enStatusSuccess, getImage(&config));
+    TEST_ASSERT(testSameImage(1, testBuffer) != enBooleanTrue);
+    testModelGet(1);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, resourceCacheInvalidate((const PFbyte*)testFiles[1].name));
+    testModelInvalidate(1);
+    failed += testCheckPool();
+    TEST_ASSERT_EQUAL(512, testEntry(2)->offset);
+    TEST_ASSERT_EQUAL(enStatusNotExist, resourceCacheInvalidate((const PFbyte*)testFiles[1].name));
+    TEST_ASSERT_EQUAL(enStatusNotExist, resourceCacheInvalidate((const PFbyte*)testFiles[15].name));
+    failed += testGet(1);
+    TEST_ASSERT_EQUAL(4, testOpens);
+
+    // The cache is keyed by the format too, a bmp file is not a pnt image
+    config.imageFormat = enImagePntFormat;
+    TEST_ASSERT(getImage(&config) != enStatusSuccess);
+    TEST_ASSERT_EQUAL(1, resourceCacheStats.hits);
+    config.imageSource = (EnStorage)1;
+    TEST_ASSERT_EQUAL(enStatusNotSupported, getImage(&config));
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, resourceCacheInvalidate(NULL));
+    testModelCount = 0;
+    testModelStats.bytesUsed = 0;
+    failed += testCheckPool();
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static double testSeconds(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Images of the windows of the application, each window loads its images when it is shown */
+static const PFdword testWindows[][7] =
+{
+    {0, 1, 2, 3, 4, 5, TEST_FILES},                 // Paint
+    {5, 6, 7, TEST_FILES},                          // Menu
+    {8, 9, 10, 11, TEST_FILES},                     // Game
+    {12, 6, TEST_FILES},                            // Title
+    {13, 14, 0, 3, TEST_FILES}                      // Gallery
+};
+
+#define TEST_WINDOWS    (sizeof(testWindows) / sizeof(testWindows[0]))
+
+/* Random window switches, with a file changed and invalidated now and then */
+static void testSwitches(void)
+{
+    static PFdword sequence[TEST_SWITCHES];
+    struct timespec start, end;
+    ImageCfg config = {enSDCard, enImageBmpFormat, NULL, testBuffer};
+    PFdword failed = 0, k, j, file, images = 0, bytes = 0, reads = 0;
+    double cached, uncached;
+
+    for (k = 0; k < TEST_SWITCHES; k++)
+    {
+        // The menu is opened from every window
+        sequence[k] = ((k % 2) == 1) ? 1 : (PFdword)(rand() % TEST_WINDOWS);
+    }
+
+    testReset();
+    for (k = 0; k < TEST_SWITCHES; k++)
+    {
+        for (j = 0; testWindows[sequence[k]][j] != TEST_FILES; j++)
+        {
+            failed += testGet(testWindows[sequence[k]][j]);
+            images++;
+        }
+        if ((rand() % 20) == 0)
+        {
+            file = (PFdword)(rand() % TEST_FILES);
+            testFiles[file].version++;
+            testWriteFile(&testFiles[file]);
+            TEST_ASSERT_EQUAL((testEntry(file) != NULL) ? enStatusSuccess : enStatusNotExist,
+                              resourceCacheInvalidate((const PFbyte*)testFiles[file].name));
+            testModelInvalidate(file);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    TEST_ASSERT_EQUAL(images, resourceCacheStats.hits + resourceCacheStats.misses);
+    TEST_ASSERT(resourceCacheStats.evictions != 0);
+
+    // Same switches timed without the checks, with the cache and with it emptied before every image
+    for (j = 0; j < 2; j++)
+    {
+        testReset();
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (k = 0; k < TEST_SWITCHES; k++)
+        {
+            for (file = 0; testWindows[sequence[k]][file] != TEST_FILES; file++)
+            {
+                if (j == 1)
+                {
+                    resourceCacheInvalidate(NULL);
+                }
+                config.imagePath = (PFbyte*)testFiles[testWindows[sequence[k]][file]].name;
+                failed += (getImage(&config) != enStatusSuccess);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (j == 0)
+        {
+            cached = testSeconds(&start, &end);
+            bytes = testBytesRead;
+            reads = testReads;
+            printf("  %u switches, %u images: %u hits, %u misses, %u evictions, %u uncached\n", TEST_SWITCHES,
+                   (unsigned)images, (unsigned)resourceCacheStats.hits, (unsigned)resourceCacheStats.misses,
+                   (unsigned)resourceCacheStats.evictions, (unsigned)resourceCacheStats.uncached);
+            printf("  cache:    %5.2f files opened, %6.1f reads of %6.0f bytes, %5.1f us per switch\n",
+                   (double)testOpens / TEST_SWITCHES, (double)reads / TEST_SWITCHES, (double)bytes / TEST_SWITCHES,
+                   cached * 1e6 / TEST_SWITCHES);
+        }
+        else
+        {
+            uncached = testSeconds(&start, &end);
+            printf("  no cache: %5.2f files opened, %6.1f reads of %6.0f bytes, %5.1f us per switch\n",
+                   (double)testOpens / TEST_SWITCHES, (double)testReads / TEST_SWITCHES,
+                   (double)testBytesRead / TEST_SWITCHES, uncached * 1e6 / TEST_SWITCHES);
+            TEST_ASSERT(testBytesRead > bytes);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+int main(void)
+{
+    PFdword k;
+
+    srand(1);
+    for (k = 0; k < TEST_FILES; k++)
+    {
+        testWriteFile(&testFiles[k]);
+    }
+    TEST_RUN(testEviction);
+    TEST_RUN(testEntries);
+    TEST_RUN(testUncached);
+    TEST_RUN(testInvalidate);
+    TEST_RUN(testSwitches);
+    TEST_EXIT();
+}
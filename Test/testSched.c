@@ -0,0 +1,289 @@
+/**
+ *  \file       testSched.c
+ *  \brief      Host test of the cooperative scheduler on a simulated tick clock.
+ *
+ *  The scheduler source is built with the tick module, whose ticks are advanced by the test in place
+ *  of the RIT interrupt. Periodic tasks with random periods sleep with PF_TASK_SLEEP_MS(), and the
+ *  test plays the role of pfSchedRun(): a round which calls no task is followed by an idle sleep of
+ *  the ticks given by the scheduler, cut short at random as by another interrupt. Every task has to
+ *  run once per period, on the tick of its timeout. The wake on event flags and FIFO, the order of
+ *  the tasks and their removal during a round are tested as well.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "prime_tick.h"
+#include "prime_fifo.h"
+#include "prime_sched.h"
+#include "test.h"
+
+#define TEST_SIM_TICKS          200000
+#define TEST_SIM_TASKS          PF_SCHED_MAX_TASKS
+#define TEST_MAX_PERIOD         97
+
+/* Core stand-in for pfSchedRun(), which the test replaces */
+static void testDisableIrq(void)
+{
+}
+
+static void testEnableIrq(void)
+{
+}
+
+#define __disable_irq           testDisableIrq
+#define __enable_irq            testEnableIrq
+
+#include "../Source/PrimeFramework/prime_sched.c"
+
+/* Record of a periodic task, its context */
+typedef struct
+{
+    PFdword period;
+    PFdword nextTick;
+    PFdword runs;
+    PFdword lateRuns;
+}TestPeriodic;
+
+static TestPeriodic testPeriodic[TEST_SIM_TASKS];
+static PFSchedTask testTasks[PF_SCHED_MAX_TASKS + 1];
+static char testLog[64];
+static PFdword testLogLength;
+
+static void testClear(void)
+{
+    while (schedCount != 0)
+    {
+        pfSchedRemove(schedTasks[0]);
+    }
+    pfTickReset();
+    pfTickSetTimerPeriod(1);
+    memset(testTasks, 0, sizeof(testTasks));
+    testLogLength = 0;
+}
+
+static void testTickRun(PFdword ticks)
+{
+    pfTickAdd(ticks);
+}
+
+static PFEnSchedTaskState testPeriodicTask(PFSchedTask* task)
+{
+    TestPeriodic* record = (TestPeriodic*)task->context;
+
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        record->runs++;
+        record->lateRuns += (pfTickGet() != record->nextTick);
+        record->nextTick = pfTickGet() + record->period;
+        PF_TASK_SLEEP_MS(task, record->period);
+    }
+    PF_TASK_END(task);
+}
+
+/* pfSchedRun() with the idle sleep on the simulated clock */
+static void testSimulation(void)
+{
+    PFdword index, ticks, wakes = 0, sleeps = 0, late = 0, maxLate = 0;
+
+    testClear();
+    for (index = 0; index < TEST_SIM_TASKS; index++)
+    {
+        testPeriodic[index].period = 1 + rand() % TEST_MAX_PERIOD;
+        testPeriodic[index].nextTick = 0;
+        testPeriodic[index].runs = 0;
+        testPeriodic[index].lateRuns = 0;
+        TEST_ASSERT_EQUAL(enStatusSuccess, pfSchedAdd(&testTasks[index], testPeriodicTask, &testPeriodic[index]));
+    }
+
+    while (pfTickGet() < TEST_SIM_TICKS)
+    {
+        if (pfSchedRunOnce() == enBooleanTrue)
+        {
+            continue;
+        }
+        ticks = schedIdleTicks();
+        TEST_ASSERT(ticks != 0 && ticks <= TEST_MAX_PERIOD);
+        // An interrupt other than the tick ends one sleep of four early
+        if ((rand() % 4) == 0)
+        {
+            ticks = rand() % ticks;
+            wakes++;
+        }
+        testTickRun(ticks);
+        sleeps++;
+    }
+
+    for (index = 0; index < TEST_SIM_TASKS; index++)
+    {
+        // Runs at 0, period, 2 period... up to the last tick of the simulation
+        TEST_ASSERT(testPeriodic[index].runs >= TEST_SIM_TICKS / testPeriodic[index].period);
+        TEST_ASSERT(testPeriodic[index].runs <= TEST_SIM_TICKS / testPeriodic[index].period + 1);
+        late += testPeriodic[index].lateRuns;
+        if (testTasks[index].maxLateTicks > maxLate)
+        {
+            maxLate = testTasks[index].maxLateTicks;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, late);
+    TEST_ASSERT_EQUAL(0, maxLate);
+    TEST_ASSERT(wakes != 0);
+    printf("  %u tasks, %u ticks in %u sleeps, %u early wakes\n", (unsigned)TEST_SIM_TASKS,
+           (unsigned)TEST_SIM_TICKS, (unsigned)sleeps, (unsigned)wakes);
+}
+
+/* A task called late has the delay from its timeout tick */
+static void testLate(void)
+{
+    TestPeriodic record = {10, 0, 0, 0};
+
+    testClear();
+    pfSchedAdd(&testTasks[0], testPeriodicTask, &record);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(10, testTasks[0].wakeTick);
+    testTickRun(9);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanFalse);
+    TEST_ASSERT_EQUAL(1, schedIdleTicks());
+    testTickRun(4);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(3, testTasks[0].maxLateTicks);
+    TEST_ASSERT_EQUAL(2, record.runs);
+}
+
+static PFEnSchedTaskState testFlagsTask(PFSchedTask* task)
+{
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        PF_TASK_WAIT_FLAGS(task, 0x06, 50);
+        testLog[testLogLength++] = (pfSchedTakeFlags(task, 0x06) != 0) ? 'F' : 'T';
+    }
+    PF_TASK_END(task);
+}
+
+static PFEnSchedTaskState testFifoTask(PFSchedTask* task)
+{
+    PF_TASK_BEGIN(task);
+    while (1)
+    {
+        PF_TASK_WAIT_FIFO(task, (PFpFifo)task->context, 0);
+        testLog[testLogLength++] = (char)pfFifoPop((PFpFifo)task->context);
+    }
+    PF_TASK_END(task);
+}
+
+static void testWakeConditions(void)
+{
+    PFFifo fifo;
+    PFbyte storage[8];
+
+    testClear();
+    pfFifoInit(&fifo, storage, sizeof(storage));
+    pfSchedAdd(&testTasks[0], testFlagsTask, NULL);
+    pfSchedAdd(&testTasks[1], testFifoTask, &fifo);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanFalse);
+    // Only the task with a timeout bounds the sleep
+    TEST_ASSERT_EQUAL(50, schedIdleTicks());
+
+    // A flag outside the mask does not wake the task
+    pfSchedSetFlags(&testTasks[0], 0x01);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanFalse);
+    pfSchedSetFlags(&testTasks[0], 0x04);
+    TEST_ASSERT_EQUAL(0, schedIdleTicks());
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(0x01, testTasks[0].flags);
+
+    pfFifoPush(&fifo, 'a');
+    pfFifoPush(&fifo, 'b');
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanFalse);
+
+    testTickRun(50);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    testLog[testLogLength] = 0;
+    TEST_ASSERT(strcmp(testLog, "FabT") == 0);
+
+    pfSchedRemove(&testTasks[0]);
+    TEST_ASSERT_EQUAL(PF_SCHED_NO_TIMEOUT, schedIdleTicks());
+}
+
+static PFEnSchedTaskState testOrderTask(PFSchedTask* task)
+{
+    PFdword index = (PFdword)(size_t)task->context;
+
+    PF_TASK_BEGIN(task);
+    testLog[testLogLength++] = (char)('0' + index);
+    // The first task removes the third one, the second one ends, the fourth adds a fifth
+    if (index == 0)
+    {
+        pfSchedRemove(&testTasks[2]);
+    }
+    if (index == 3)
+    {
+        pfSchedAdd(&testTasks[4], testOrderTask, (void*)4);
+    }
+    if (index != 1)
+    {
+        PF_TASK_YIELD(task);
+        testLog[testLogLength++] = (char)('a' + index);
+    }
+    PF_TASK_END(task);
+}
+
+static void testOrder(void)
+{
+    PFdword index;
+
+    testClear();
+    for (index = 0; index < 4; index++)
+    {
+        pfSchedAdd(&testTasks[index], testOrderTask, (void*)(size_t)index);
+    }
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanTrue);
+    TEST_ASSERT(pfSchedRunOnce() == enBooleanFalse);
+    testLog[testLogLength] = 0;
+    // A task added during a round runs in the same round
+    TEST_ASSERT(strcmp(testLog, "0134ade") == 0);
+    TEST_ASSERT_EQUAL(0, schedCount);
+}
+
+static void testInvalid(void)
+{
+    PFdword index;
+
+    testClear();
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfSchedAdd(NULL, testFlagsTask, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfSchedAdd(&testTasks[0], NULL, NULL));
+    for (index = 0; index < PF_SCHED_MAX_TASKS; index++)
+    {
+        TEST_ASSERT_EQUAL(enStatusSuccess, pfSchedAdd(&testTasks[index], testFlagsTask, NULL));
+    }
+    TEST_ASSERT_EQUAL(enStatusInvState, pfSchedAdd(&testTasks[0], testFlagsTask, NULL));
+    TEST_ASSERT_EQUAL(enStatusNoMem, pfSchedAdd(&testTasks[PF_SCHED_MAX_TASKS], testFlagsTask, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfSchedRemove(&testTasks[PF_SCHED_MAX_TASKS]));
+    testClear();
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testSimulation);
+    TEST_RUN(testLate);
+    TEST_RUN(testWakeConditions);
+    TEST_RUN(testOrder);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
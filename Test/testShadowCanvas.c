@@ -0,0 +1,541 @@
+/**
+ *  \file       testShadowCanvas.c
+ *  \brief      Host test of the shadow canvas against the LCD.
+ *
+ *  The LCD is a screen in memory, drawn by the rasterizers of the graphics library written here after
+ *  the library. Random sequences of the tools of the paint application are drawn through the shadow
+ *  canvas: pen and eraser strokes of the stroke engine, lines, rectangles, circles and fills in the
+ *  colors of the palette, crossing the edge of the canvas into the toolbar. After every tool the
+ *  canvas read from the shadow has to be the same as the drawing area of the LCD. A PopUp drawn over
+ *  the canvas is taken down by shadowRedraw(), and a color which is not in the palette makes the
+ *  shadow invalid until it is captured again from the LCD. The time of a redraw and of a read of the
+ *  whole canvas is printed.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "graphics.h"
+#include "stroke.h"
+#include "shadowCanvas.h"
+#include "test.h"
+
+#define TEST_WIDTH              240
+#define TEST_HEIGHT             320
+#define TEST_CANVAS_Y           45
+#define TEST_SEQUENCES          20
+#define TEST_TOOLS_PER_SEQUENCE 60
+#define TEST_MARGIN             8
+
+static PFword testScreen[TEST_HEIGHT][TEST_WIDTH];
+static PFword testColor = BLACK, testPenSize = 1;
+static PFword testX1, testY1, testX2, testY2, testCursorX, testCursorY;
+
+// LCD
+
+static void testPlot(PFsdword x, PFsdword y, PFword color)
+{
+    if (x >= 0 && y >= 0 && x < TEST_WIDTH && y < TEST_HEIGHT)
+    {
+        testScreen[y][x] = color;
+    }
+}
+
+PFEnStatus gfxFillArea(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color)
+{
+    PFword x, y;
+
+    for (y = yStart; y <= yEnd && y < TEST_HEIGHT; y++)
+    {
+        for (x = xStart; x <= xEnd && x < TEST_WIDTH; x++)
+        {
+            testScreen[y][x] = color;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetColor(const PFdword color)
+{
+    testColor = (PFword)color;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetColor(PFword* color)
+{
+    *color = testColor;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetPenSize(const PFdword size)
+{
+    testPenSize = (PFword)size;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetPenSize(PFword* size)
+{
+    *size = testPenSize;
+    return enStatusSuccess;
+}
+
+/* Square of the pen size, the extra pixel of an even size is on the right and below */
+PFEnStatus gfxPixels(const PFdword xPos, const PFdword yPos, const PFdword size, PFword color)
+{
+    PFsdword offset = (size != 0) ? (PFsdword)size - 1 : 0;
+    PFsdword x, y;
+
+    for (x = (PFsdword)xPos - offset / 2; x <= (PFsdword)xPos + (offset - offset / 2); x++)
+    {
+        for (y = (PFsdword)yPos - offset / 2; y <= (PFsdword)yPos + (offset - offset / 2); y++)
+        {
+            testPlot(x, y, color);
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxDrawLine(PFsdword x1, PFsdword y1, const PFsdword x2, const PFsdword y2)
+{
+    PFsdword offset = (testPenSize != 0) ? testPenSize - 1 : 0;
+    PFsdword dx, dy, sx, sy, err, e2;
+
+    if (x1 == x2 || y1 == y2)
+    {
+        return gfxFillArea((PFword)(((x1 < x2) ? x1 : x2) - ((x1 == x2) ? offset / 2 : 0)),
+                           (PFword)(((y1 < y2) ? y1 : y2) - ((y1 == y2) ? offset / 2 : 0)),
+                           (PFword)(((x1 < x2) ? x2 : x1) + ((x1 == x2) ? offset - offset / 2 : 0)),
+                           (PFword)(((y1 < y2) ? y2 : y1) + ((y1 == y2) ? offset - offset / 2 : 0)), testColor);
+    }
+
+    dx = abs(x2 - x1);
+    sx = (x1 < x2) ? 1 : -1;
+    dy = -abs(y2 - y1);
+    sy = (y1 < y2) ? 1 : -1;
+    err = dx + dy;
+    for (;;)
+    {
+        gfxPixels(x1, y1, testPenSize, testColor);
+        if (x1 == x2 && y1 == y2)
+        {
+            break;
+        }
+        e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x1 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y1 += sy;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxDrawRectangle(const PFdword x1, const PFdword y1, const PFdword x2, const PFdword y2)
+{
+    gfxDrawLine(x1, y1, x2, y1);
+    gfxDrawLine(x2, y1, x2, y2);
+    gfxDrawLine(x1, y2, x2, y2);
+    return gfxDrawLine(x1, y1, x1, y2);
+}
+
+PFEnStatus gfxDrawCircle(const PFsdword xc, const PFsdword yc, PFsdword radius)
+{
+    PFsdword x = -radius, y = 0, err = 2 - 2 * radius, step;
+
+    do
+    {
+        gfxPixels(xc - x, yc + y, testPenSize, testColor);
+        gfxPixels(xc - y, yc - x, testPenSize, testColor);
+        gfxPixels(xc + x, yc - y, testPenSize, testColor);
+        gfxPixels(xc + y, yc + x, testPenSize, testColor);
+        step = err;
+        if (step <= y)
+        {
+            y++;
+            err += y * 2 + 1;
+        }
+        if (step > x || err > y)
+        {
+            x++;
+            err += x * 2 + 1;
+        }
+    } while (x < 0);
+    return enStatusSuccess;
+}
+
+/* The board reads the row from one pixel left of xValue, shadowCapture() passes x + 1 */
+PFEnStatus readBackground(PFword xValue, PFword yValue, PFword width, PFword height, PFword* backgroundData, PFword size)
+{
+    PFword x, y;
+    PFdword index = 0;
+
+    if ((PFdword)width * height > size)
+    {
+        return enStatusNoMem;
+    }
+    for (y = yValue; y <= yValue + height; y++)
+    {
+        for (x = xValue; x <= xValue + width; x++)
+        {
+            backgroundData[index++] = (x - 1 < TEST_WIDTH) ? testScreen[y][x - 1] : 0;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetWindow(PFword x1, PFword y1, PFword x2, PFword y2)
+{
+    testX1 = x1;
+    testY1 = y1;
+    testX2 = x2;
+    testY2 = y2;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetAreaMax(void)
+{
+    return gfxSetWindow(0, 0, TEST_WIDTH - 1, TEST_HEIGHT - 1);
+}
+
+PFEnStatus gfxSetCursor(PFword x, PFword y)
+{
+    testCursorX = x;
+    testCursorY = y;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxWriteCmd(PFword reg)
+{
+    (void)reg;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxWriteData(PFword data)
+{
+    testScreen[testCursorY][testCursorX] = data;
+    if (testCursorX++ == testX2)
+    {
+        testCursorX = testX1;
+        testCursorY = (testCursorY == testY2) ? testY1 : testCursorY + 1;
+    }
+    return enStatusSuccess;
+}
+
+/* long_call is an attribute of the ARM target only */
+#undef PF_RAMFUNC
+#define PF_RAMFUNC      __attribute__((section(".ramfunc"), noinline))
+#include "../Source/AppHelper/shadowCanvas.c"
+
+// Test
+
+typedef enum
+{
+    enTestPen = 0,
+    enTestEraser,
+    enTestLine,
+    enTestRectangle,
+    enTestCircle,
+    enTestFill,
+    enTestClear,
+    enTestPopUp,
+    enTestOffPalette,
+    enTestTools
+}EnTestTool;
+
+static const char* testToolName[enTestTools] = {"pen", "eraser", "line", "rectangle", "circle", "fill", "clear",
+                                                "popup", "off palette"};
+static const PFword testPalette[] = {WHITE, BLACK, RED, BLUE};
+static CfgShadow testShadow = {0, TEST_CANVAS_Y, testPalette, 4, 0};
+static CfgStroke testStroke = {0, TEST_CANVAS_Y, TEST_WIDTH - 1, TEST_HEIGHT - 1, STROKE_DEFAULT_TOLERANCE,
+                               STROKE_DEFAULT_MIN_DISTANCE, shadowFillArea};
+static PFdword testToolCount[enTestTools];
+
+/* Pixels of the drawing area which differ from the shadow, or the whole canvas if it can not be read */
+static PFdword testCompare(void)
+{
+    PFword row[SHADOW_WIDTH];
+    PFdword wrong = 0;
+    PFword x, y;
+
+    for (y = 0; y < SHADOW_HEIGHT; y++)
+    {
+        if (shadowReadPixels(0, TEST_CANVAS_Y + y, SHADOW_WIDTH, row) != enStatusSuccess)
+        {
+            return SHADOW_WIDTH * SHADOW_HEIGHT;
+        }
+        for (x = 0; x < SHADOW_WIDTH; x++)
+        {
+            wrong += (row[x] != testScreen[TEST_CANVAS_Y + y][x]);
+        }
+    }
+    return wrong;
+}
+
+/* Coordinate which keeps a pen square on the screen, from the toolbar down to the bottom of the canvas */
+static PFsdword testCoord(PFsdword size)
+{
+    return TEST_MARGIN + rand() % (size - 2 * TEST_MARGIN);
+}
+
+static void testPen(PFword color, PFword size)
+{
+    Stroke stroke;
+    PFsdword x = testCoord(TEST_WIDTH), y = TEST_CANVAS_Y + rand() % SHADOW_HEIGHT;
+    PFdword samples = 5 + rand() % 40, k;
+
+    gfxSetColor(color);
+    gfxSetPenSize(size);
+    strokeBegin(&stroke, &testStroke, (PFdword)x, (PFdword)y);
+    for (k = 0; k < samples; k++)
+    {
+        x += rand() % 13 - 6;
+        y += rand() % 13 - 6;
+        x = (x < 0) ? 0 : (x >= TEST_WIDTH) ? TEST_WIDTH - 1 : x;
+        y = (y < TEST_CANVAS_Y) ? TEST_CANVAS_Y : (y >= TEST_HEIGHT) ? TEST_HEIGHT - 1 : y;
+        strokeAddPoint(&stroke, (PFdword)x, (PFdword)y);
+    }
+    strokeEnd(&stroke);
+}
+
+/* Draws a tool, returns the pixels which differ afterwards */
+static PFdword testTool(EnTestTool tool)
+{
+    PFsdword x1 = testCoord(TEST_WIDTH), y1 = testCoord(TEST_HEIGHT), x2 = testCoord(TEST_WIDTH);
+    PFsdword y2 = testCoord(TEST_HEIGHT), radius;
+    PFword color = testPalette[rand() % 4];
+    PFdword wrong = 0;
+
+    gfxSetColor(color);
+    gfxSetPenSize((PFword)(1 + rand() % 6));
+    switch (tool)
+    {
+        case enTestPen:
+            testPen(color, (PFword)(1 + rand() % 4));
+            break;
+
+        case enTestEraser:
+            testPen(testPalette[testShadow.background], 8);
+            break;
+
+        case enTestLine:
+            // Straight lines are filled as rectangles
+            if ((rand() % 3) == 0)
+            {
+                y2 = y1;
+            }
+            shadowDrawLine(x1, y1, x2, y2);
+            break;
+
+        case enTestRectangle:
+            shadowDrawRectangle((PFdword)x1, (PFdword)y1, (PFdword)x2, (PFdword)y2);
+            break;
+
+        case enTestCircle:
+            radius = x1 - TEST_MARGIN;
+            radius = (TEST_WIDTH - 1 - TEST_MARGIN - x1 < radius) ? TEST_WIDTH - 1 - TEST_MARGIN - x1 : radius;
+            radius = (y1 - TEST_MARGIN < radius) ? y1 - TEST_MARGIN : radius;
+            radius = (TEST_HEIGHT - 1 - TEST_MARGIN - y1 < radius) ? TEST_HEIGHT - 1 - TEST_MARGIN - y1 : radius;
+            shadowDrawCircle(x1, y1, 1 + rand() % (radius + 1));
+            break;
+
+        case enTestFill:
+            shadowFillArea((PFword)((x1 < x2) ? x1 : x2), (PFword)((y1 < y2) ? y1 : y2),
+                           (PFword)((x1 < x2) ? x2 : x1), (PFword)((y1 < y2) ? y2 : y1), color);
+            break;
+
+        case enTestClear:
+            shadowFillArea(0, TEST_CANVAS_Y, TEST_WIDTH - 1, TEST_HEIGHT - 1, testPalette[testShadow.background]);
+            break;
+
+        case enTestPopUp:
+            // Drawn over the canvas without the shadow, then taken down from it
+            x1 = 20 + rand() % 40;
+            y1 = 60 + rand() % 150;
+            gfxFillArea((PFword)x1, (PFword)y1, (PFword)(x1 + 160), (PFword)(y1 + 60), GREEN);
+            wrong += (testCompare() == 0);
+            TEST_ASSERT_EQUAL(enStatusSuccess, shadowRedraw((PFword)x1, (PFword)y1, (PFword)(x1 + 160),
+                                                            (PFword)(y1 + 60)));
+            break;
+
+        case enTestOffPalette:
+            // The shadow can not hold the color, once the line is drawn over in a color of the palette
+            // the canvas is captured from the LCD again
+            gfxSetColor(GREEN);
+            shadowDrawLine(x1, TEST_CANVAS_Y + y1 % SHADOW_HEIGHT, x2, TEST_CANVAS_Y + y2 % SHADOW_HEIGHT);
+            wrong += (shadowIsValid() != enBooleanFalse);
+            wrong += (testCompare() != SHADOW_WIDTH * SHADOW_HEIGHT);
+            wrong += (shadowCapture() != enStatusInvState);
+            gfxSetColor(color);
+            gfxDrawLine(x1, TEST_CANVAS_Y + y1 % SHADOW_HEIGHT, x2, TEST_CANVAS_Y + y2 % SHADOW_HEIGHT);
+            wrong += (shadowCapture() != enStatusSuccess);
+            break;
+
+        default:
+            break;
+    }
+    testToolCount[tool]++;
+    return wrong + testCompare();
+}
+
+static void testToolbar(void)
+{
+    PFword x;
+
+    gfxFillArea(0, 0, TEST_WIDTH - 1, TEST_CANVAS_Y - 1, YELLOW);
+    for (x = 0; x < TEST_WIDTH; x += 34)
+    {
+        gfxFillArea(x + 8, 10, (x + 24 < TEST_WIDTH) ? x + 24 : TEST_WIDTH - 1, 32, (PFword)(x * 97));
+    }
+}
+
+/* Random sequences of tools, each started on a cleared canvas */
+static void testSequences(void)
+{
+    PFdword failed = 0, sequence, k;
+    EnTestTool tool;
+
+    memset(testToolCount, 0, sizeof(testToolCount));
+    for (sequence = 0; sequence < TEST_SEQUENCES; sequence++)
+    {
+        testToolbar();
+        gfxFillArea(0, TEST_CANVAS_Y, TEST_WIDTH - 1, TEST_HEIGHT - 1, testPalette[testShadow.background]);
+        TEST_ASSERT_EQUAL(enStatusSuccess, shadowOpen(&testShadow));
+        TEST_ASSERT_EQUAL(0, testCompare());
+        for (k = 0; k < TEST_TOOLS_PER_SEQUENCE; k++)
+        {
+            // The canvas is rarely cleared and colors out of the palette are rare
+            tool = (EnTestTool)(rand() % enTestTools);
+            if ((tool == enTestClear || tool == enTestOffPalette) && (rand() % 4) != 0)
+            {
+                tool = enTestPen;
+            }
+            failed += testTool(tool);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    for (k = 0; k < enTestTools; k++)
+    {
+        TEST_ASSERT(testToolCount[k] != 0);
+        printf("  %-12s %4u\n", testToolName[k], (unsigned)testToolCount[k]);
+    }
+}
+
+/* Shapes wider than the screen and pens of the largest sizes at the corners of the canvas */
+static void testEdges(void)
+{
+    PFdword failed = 0;
+    PFword size;
+
+    testToolbar();
+    gfxFillArea(0, TEST_CANVAS_Y, TEST_WIDTH - 1, TEST_HEIGHT - 1, WHITE);
+    TEST_ASSERT_EQUAL(enStatusSuccess, shadowOpen(&testShadow));
+    for (size = 1; size <= 6; size++)
+    {
+        gfxSetPenSize(size);
+        gfxSetColor(testPalette[size % 4]);
+        shadowDrawLine(3, TEST_CANVAS_Y, TEST_WIDTH - 4, TEST_CANVAS_Y);
+        shadowDrawLine(3, TEST_HEIGHT - 4, TEST_WIDTH - 4, TEST_HEIGHT - 4);
+        shadowDrawLine(3, 3, 3, TEST_HEIGHT - 4);
+        shadowDrawLine(TEST_WIDTH - 4, TEST_CANVAS_Y - 5, 3, TEST_HEIGHT - 4);
+        shadowDrawRectangle(3 + size, TEST_CANVAS_Y - 3, TEST_WIDTH - 4 - size, TEST_HEIGHT - 4 - size);
+        shadowDrawCircle(TEST_WIDTH / 2, TEST_CANVAS_Y, 30 + size);
+        failed += testCompare();
+    }
+    // Fills covering the toolbar and ending on every pixel of a byte
+    for (size = 0; size < 8; size++)
+    {
+        shadowFillArea(size, TEST_CANVAS_Y - 10 + size, 100 + size, TEST_CANVAS_Y + 10 + size, testPalette[size % 4]);
+        failed += testCompare();
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static double testSeconds(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* The whole canvas drawn again from the shadow, and read from it and from the LCD */
+static void testRedraw(void)
+{
+    static PFword before[SHADOW_HEIGHT][TEST_WIDTH];
+    PFword row[SHADOW_WIDTH + 1];
+    struct timespec start, end;
+    PFword y;
+    double redraw, shadowRead, lcdRead;
+
+    memcpy(before, testScreen[TEST_CANVAS_Y], sizeof(before));
+    gfxFillArea(0, TEST_CANVAS_Y, TEST_WIDTH - 1, TEST_HEIGHT - 1, GREEN);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(enStatusSuccess, shadowRedraw(0, TEST_CANVAS_Y, TEST_WIDTH - 1, TEST_HEIGHT - 1));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    redraw = testSeconds(&start, &end);
+    TEST_ASSERT(memcmp(before, testScreen[TEST_CANVAS_Y], sizeof(before)) == 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (y = 0; y < SHADOW_HEIGHT; y++)
+    {
+        shadowReadPixels(0, TEST_CANVAS_Y + y, SHADOW_WIDTH, row);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    shadowRead = testSeconds(&start, &end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (y = 0; y < SHADOW_HEIGHT; y++)
+    {
+        readBackground(1, TEST_CANVAS_Y + y, SHADOW_WIDTH, 0, row, SHADOW_WIDTH);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    lcdRead = testSeconds(&start, &end);
+    printf("  canvas %ux%u: redraw %.1f us, read from the shadow %.1f us, from the screen in memory %.1f us\n",
+           SHADOW_WIDTH, SHADOW_HEIGHT, redraw * 1e6, shadowRead * 1e6, lcdRead * 1e6);
+
+    // An invalid shadow is not drawn or read
+    shadowInvalidate();
+    TEST_ASSERT_EQUAL(enStatusInvState, shadowRedraw(0, TEST_CANVAS_Y, 10, TEST_CANVAS_Y + 10));
+    TEST_ASSERT_EQUAL(enStatusInvState, shadowReadPixels(0, TEST_CANVAS_Y, 10, row));
+    TEST_ASSERT_EQUAL(enStatusSuccess, shadowCapture());
+    TEST_ASSERT_EQUAL(0, testCompare());
+}
+
+static void testInvalid(void)
+{
+    CfgShadow config = testShadow;
+    PFword row[4];
+
+    config.background = 4;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowOpen(&config));
+    config.background = 0;
+    config.paletteSize = SHADOW_PALETTE_SIZE + 1;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowOpen(&config));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowOpen(NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowReadPixels(0, TEST_CANVAS_Y - 1, 4, row));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowReadPixels(TEST_WIDTH - 3, TEST_CANVAS_Y, 4, row));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowRedraw(0, TEST_CANVAS_Y - 1, 10, TEST_CANVAS_Y + 10));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, shadowRedraw(10, TEST_CANVAS_Y, 9, TEST_CANVAS_Y + 10));
+}
+
+int main(void)
+{
+    srand(1);
+    gfxSetAreaMax();
+    TEST_RUN(testSequences);
+    TEST_RUN(testEdges);
+    TEST_RUN(testRedraw);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
@@ -0,0 +1,303 @@
+/**
+ *  \file       testSpi0Dma.c
+ *  \brief      Host test of the DMA transfer mode of SPI0 on a mock of the SSP0 registers.
+ *
+ *  The driver source is built with SPI0_CHANNEL pointing at a register block of the test. The GPDMA
+ *  functions record the transfers they are given and the test ends them by calling their callbacks,
+ *  as the DMA interrupt does. The interrupt mask and WFI are replaced by functions which check that
+ *  the core only sleeps with interrupts masked and while the transfer runs.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <string.h>
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_gpio.h"
+#include "prime_spi0.h"
+#include "prime_spi0Dma.h"
+#include "test.h"
+
+#define SSP_DMACR_RXDMAE        0x01
+#define SSP_DMACR_TXDMAE        0x02
+#define SSP_ICR_RORIC           0x01
+
+static SSP_TypeDef testSsp;
+
+/* GPDMA stand-in */
+static PFbyte testChannelsAllocated;
+static PFbyte testChannelsFree;
+static PFEnBoolean testAccessible = enBooleanTrue;
+static PFGpdmaTransfer testTransfer[2];
+static PFEnBoolean testRunning[2];
+static PFdword testStops[2];
+
+/* Core stand-in */
+static PFdword testPrimask;
+static PFdword testWfiCount;
+static PFbyte testCompleteOnMask;
+static PFdword testWaitCalls;
+static PFdword testCompleteAfterWaits;
+static PFdword testCallbacks;
+
+PFEnStatus pfGpdmaChannelAlloc(PFbyte* channel)
+{
+    if (testChannelsAllocated == 2)
+    {
+        return enStatusNoMem;
+    }
+    *channel = testChannelsAllocated++;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaChannelFree(PFbyte channel)
+{
+    (void)channel;
+    testChannelsFree++;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaStart(PFbyte channel, PFpGpdmaTransfer transfer)
+{
+    testTransfer[channel] = *transfer;
+    testRunning[channel] = enBooleanTrue;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfGpdmaStop(PFbyte channel)
+{
+    testRunning[channel] = enBooleanFalse;
+    testStops[channel]++;
+    return enStatusSuccess;
+}
+
+PFEnBoolean pfGpdmaIsAccessible(const void* address, PFdword size)
+{
+    (void)address;
+    (void)size;
+    return testAccessible;
+}
+
+/* The DMA interrupt of the receive channel, the last frame has been received */
+static void testDmaRxInterrupt(PFEnStatus status)
+{
+    testRunning[0] = enBooleanFalse;
+    testTransfer[0].callback(0, status);
+}
+
+static PFdword testGetPrimask(void)
+{
+    return testPrimask;
+}
+
+static void testDisableIrq(void)
+{
+    // The interrupt arrives just before the mask is set
+    if (testCompleteOnMask != 0 && --testCompleteOnMask == 0)
+    {
+        testDmaRxInterrupt(enStatusSuccess);
+    }
+    testPrimask = 1;
+}
+
+static void testEnableIrq(void)
+{
+    testPrimask = 0;
+}
+
+/* Sleeps until the DMA interrupt, which is taken once the mask is cleared */
+static void testWfi(void)
+{
+    TEST_ASSERT_EQUAL(1, testPrimask);
+    TEST_ASSERT(pfSpi0DmaIsBusy() == enBooleanTrue);
+    testWfiCount++;
+    testDmaRxInterrupt(enStatusSuccess);
+}
+
+#undef SPI0_CHANNEL
+#define SPI0_CHANNEL            (&testSsp)
+#define __get_PRIMASK           testGetPrimask
+#define __disable_irq           testDisableIrq
+#define __enable_irq            testEnableIrq
+#define __WFI                   testWfi
+
+#include "../Source/PrimeFramework/prime_spi0Dma.c"
+
+static void testUserCallback(void)
+{
+    testCallbacks++;
+}
+
+static void testWaitCallback(void)
+{
+    testWaitCalls++;
+    if (testWaitCalls == testCompleteAfterWaits)
+    {
+        testDmaRxInterrupt(enStatusSuccess);
+    }
+}
+
+static void testReset(void)
+{
+    memset(&testSsp, 0, sizeof(testSsp));
+    memset(testTransfer, 0, sizeof(testTransfer));
+    memset(testRunning, 0, sizeof(testRunning));
+    memset(testStops, 0, sizeof(testStops));
+    testAccessible = enBooleanTrue;
+    testPrimask = 0;
+    testWfiCount = 0;
+    testCompleteOnMask = 0;
+    testWaitCalls = 0;
+    testCompleteAfterWaits = 0;
+    testCallbacks = 0;
+}
+
+static void testOpen(void)
+{
+    PFbyte rx[16], tx[16];
+
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, pfSpi0DmaStart(tx, rx, sizeof(rx), NULL));
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, pfSpi0DmaClose());
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaOpen());
+    TEST_ASSERT_EQUAL(2, testChannelsAllocated);
+    // The receive channel is allocated first, it has the higher priority
+    TEST_ASSERT_EQUAL(0, spi0DmaRxChannel);
+    TEST_ASSERT_EQUAL(1, spi0DmaTxChannel);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaOpen());
+    TEST_ASSERT_EQUAL(2, testChannelsAllocated);
+}
+
+static void testStart(void)
+{
+    PFbyte rx[512], tx[512];
+
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaStart(tx, rx, sizeof(rx), testUserCallback));
+
+    TEST_ASSERT_EQUAL(SSP_DMACR_RXDMAE | SSP_DMACR_TXDMAE, testSsp.DMACR);
+    TEST_ASSERT_EQUAL(SSP_ICR_RORIC, testSsp.ICR);
+    TEST_ASSERT(testRunning[0] == enBooleanTrue && testRunning[1] == enBooleanTrue);
+
+    TEST_ASSERT_EQUAL((PFdword)&testSsp.DR, testTransfer[0].srcAddr);
+    TEST_ASSERT_EQUAL((PFdword)rx, testTransfer[0].destAddr);
+    TEST_ASSERT_EQUAL(sizeof(rx), testTransfer[0].size);
+    TEST_ASSERT_EQUAL(enGpdmaPeriphToMem, testTransfer[0].transferType);
+    TEST_ASSERT_EQUAL(enGpdmaConnSsp0Rx, testTransfer[0].srcConn);
+    TEST_ASSERT_EQUAL(enBooleanFalse, testTransfer[0].srcIncrement);
+    TEST_ASSERT_EQUAL(enBooleanTrue, testTransfer[0].destIncrement);
+
+    TEST_ASSERT_EQUAL((PFdword)tx, testTransfer[1].srcAddr);
+    TEST_ASSERT_EQUAL((PFdword)&testSsp.DR, testTransfer[1].destAddr);
+    TEST_ASSERT_EQUAL(enGpdmaMemToPeriph, testTransfer[1].transferType);
+    TEST_ASSERT_EQUAL(enGpdmaConnSsp0Tx, testTransfer[1].destConn);
+    TEST_ASSERT_EQUAL(enBooleanTrue, testTransfer[1].srcIncrement);
+    TEST_ASSERT_EQUAL(enBooleanFalse, testTransfer[1].destIncrement);
+
+    TEST_ASSERT(pfSpi0DmaIsBusy() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(enStatusBusy, pfSpi0DmaStart(tx, rx, sizeof(rx), NULL));
+
+    testDmaRxInterrupt(enStatusSuccess);
+    TEST_ASSERT(pfSpi0DmaIsBusy() == enBooleanFalse);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaGetStatus());
+    TEST_ASSERT_EQUAL(0, testSsp.DMACR);
+    TEST_ASSERT_EQUAL(1, testStops[1]);
+    TEST_ASSERT_EQUAL(1, testCallbacks);
+}
+
+static void testDummyBuffers(void)
+{
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaStart(NULL, NULL, 10, NULL));
+    TEST_ASSERT_EQUAL((PFdword)&spi0DmaDummyRx, testTransfer[0].destAddr);
+    TEST_ASSERT_EQUAL(enBooleanFalse, testTransfer[0].destIncrement);
+    TEST_ASSERT_EQUAL((PFdword)&spi0DmaDummyTx, testTransfer[1].srcAddr);
+    TEST_ASSERT_EQUAL(enBooleanFalse, testTransfer[1].srcIncrement);
+    testDmaRxInterrupt(enStatusSuccess);
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaGetStatus());
+}
+
+static void testInvalid(void)
+{
+    PFbyte rx[16];
+
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfSpi0DmaStart(NULL, rx, 0, NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfSpi0DmaStart(NULL, rx, GPDMA_MAX_TRANSFER_SIZE + 1, NULL));
+    testAccessible = enBooleanFalse;
+    TEST_ASSERT_EQUAL(enStatusNotSupported, pfSpi0DmaStart(NULL, rx, sizeof(rx), NULL));
+    TEST_ASSERT_EQUAL(enStatusNotSupported, pfSpi0DmaTransfer(NULL, rx, sizeof(rx), NULL));
+    TEST_ASSERT(testRunning[0] == enBooleanFalse && testRunning[1] == enBooleanFalse);
+    TEST_ASSERT_EQUAL(0, testSsp.DMACR);
+    TEST_ASSERT(pfSpi0DmaIsBusy() == enBooleanFalse);
+}
+
+static void testTxError(void)
+{
+    PFbyte rx[16];
+
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaStart(NULL, rx, sizeof(rx), testUserCallback));
+    testTransfer[1].callback(1, enStatusError);
+    TEST_ASSERT_EQUAL(1, testStops[0]);
+    TEST_ASSERT_EQUAL(enStatusError, pfSpi0DmaGetStatus());
+    TEST_ASSERT_EQUAL(0, testSsp.DMACR);
+    TEST_ASSERT_EQUAL(1, testCallbacks);
+}
+
+static void testTransferSleeps(void)
+{
+    PFbyte rx[512];
+
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaTransfer(NULL, rx, sizeof(rx), NULL));
+    TEST_ASSERT_EQUAL(1, testWfiCount);
+    TEST_ASSERT_EQUAL(0, testPrimask);
+
+    // Ended by the interrupt just before the check, the core does not sleep
+    testReset();
+    testCompleteOnMask = 1;
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaTransfer(NULL, rx, sizeof(rx), NULL));
+    TEST_ASSERT_EQUAL(0, testWfiCount);
+    TEST_ASSERT_EQUAL(0, testPrimask);
+}
+
+static void testTransferWaitCallback(void)
+{
+    PFbyte rx[512];
+
+    testReset();
+    testCompleteAfterWaits = 3;
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaTransfer(NULL, rx, sizeof(rx), testWaitCallback));
+    TEST_ASSERT_EQUAL(3, testWaitCalls);
+    TEST_ASSERT_EQUAL(0, testWfiCount);
+}
+
+static void testClose(void)
+{
+    testReset();
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfSpi0DmaClose());
+    TEST_ASSERT_EQUAL(2, testChannelsFree);
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, pfSpi0DmaTransfer(NULL, NULL, 1, NULL));
+}
+
+int main(void)
+{
+    TEST_RUN(testOpen);
+    TEST_RUN(testStart);
+    TEST_RUN(testDummyBuffers);
+    TEST_RUN(testInvalid);
+    TEST_RUN(testTxError);
+    TEST_RUN(testTransferSleeps);
+    TEST_RUN(testTransferWaitCallback);
+    TEST_RUN(testClose);
+    TEST_EXIT();
+}
@@ -0,0 +1,588 @@
+/**
+ *  \file       testSpiBus.c
+ *  \brief      Host test of the SPI bus arbiter with the touch panel driver on a simulated SPI0 bus.
+ *
+ *  The arbiter and the touch driver sources are built with the SPI0 driver replaced by a bus of the
+ *  test, which times every byte at the clock rate set in the SSP0 registers and answers as the touch
+ *  controller and the SD card do. The SD card writes of the test hold the bus for random numbers of
+ *  data blocks and yield between them. The touch interrupt comes at random bytes of the writes: its
+ *  sample has to be read at the next yield, within one data block, and give the position of the
+ *  panel, while the SD card receives its data unchanged. Light touches, transactions of devices which
+ *  are not urgent and a bus held by the SD card are tested as well.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "prime_sysClk.h"
+#include "prime_gpio.h"
+#include "prime_spi0.h"
+#include "prime_spi0Dma.h"
+#include "prime_tick.h"
+#include "test.h"
+
+#define TEST_PCLK               25000000
+#define TEST_TICK_NS            10000       /* A tick of the test is 10 us */
+#define TEST_BLOCK_SIZE         512
+#define TEST_MAX_BLOCKS         16
+#define TEST_ROUNDS             2000
+#define TEST_INT_CHANCE         3000        /* One touch interrupt every TEST_INT_CHANCE bytes of the SD card */
+#define TEST_NO_DEVICE          0xFF
+
+#define TEST_TOUCH_BAUD         2000000
+#define TEST_SD_BAUD            25000000
+#define TEST_CR0_DEFAULT        (0x07 | (3 << 8))   /* 8 bit frames, SCR 3 */
+#define TEST_CPSR_DEFAULT       2
+
+/* Pins of the devices on the bus */
+#define TEST_TOUCH_CS_PORT      GPIO_PORT_0
+#define TEST_TOUCH_CS_PIN       GPIO_PIN_20
+#define TEST_TOUCH_INT_PORT     GPIO_PORT_2
+#define TEST_TOUCH_INT_PIN      GPIO_PIN_11
+#define TEST_SD_CS_PORT         GPIO_PORT_0
+#define TEST_SD_CS_PIN          GPIO_PIN_16
+#define TEST_FLASH_CS_PORT      GPIO_PORT_1
+#define TEST_FLASH_CS_PIN       GPIO_PIN_6
+
+static SSP_TypeDef testSsp;
+
+/* Core stand-in, a non zero IPSR is the touch interrupt */
+static PFdword testIpsr;
+static PFdword testPrimask;
+static PFEnBoolean testPenDown = enBooleanFalse;
+
+static PFdword testGetIpsr(void)
+{
+    return testIpsr;
+}
+
+static PFdword testGetPrimask(void)
+{
+    return testPrimask;
+}
+
+static void testSetPrimask(PFdword primask)
+{
+    testPrimask = primask;
+}
+
+static void testDisableIrq(void)
+{
+    testPrimask = 1;
+}
+
+/* The interrupt output of the touch controller, low while the panel is touched */
+static PFdword testPortRead(PFdword port)
+{
+    return (port == TEST_TOUCH_INT_PORT && testPenDown == enBooleanTrue) ? 0 : TEST_TOUCH_INT_PIN;
+}
+
+#undef SPI0_CHANNEL
+#define SPI0_CHANNEL            (&testSsp)
+#define __get_IPSR              testGetIpsr
+#define __get_PRIMASK           testGetPrimask
+#define __set_PRIMASK           testSetPrimask
+#define __disable_irq           testDisableIrq
+#undef PF_GPIO_PORT_READ
+#define PF_GPIO_PORT_READ(port) testPortRead(port)
+
+#include "../Source/AppHelper/spiBus.c"
+#include "../Source/AppHelper/touch.c"
+
+/* Bus of the test */
+static PFGpioPortPin testPins[SPI_BUS_MAX_DEVICES];
+static PFdword testBaud[SPI_BUS_MAX_DEVICES];
+static PFbyte testRegistered;
+static PFbyte testSelected = TEST_NO_DEVICE;
+static PFdword testNs;
+static PFdword testBusErrors, testProfileErrors;
+
+/* Touch panel */
+static PFdword testCodeX, testCodeY, testResistance;
+static PFdword testConversion, testResult, testResultBytes;
+static PFdword testOutlier;
+static PFdword testInterruptTick, testMaxLatency, testInterrupts, testSamplesRead;
+static PFEnBoolean testSamplePending;
+
+/* SD card */
+static PFbyte testSdData[TEST_MAX_BLOCKS * TEST_BLOCK_SIZE];
+static PFbyte testSdReceived[TEST_MAX_BLOCKS * TEST_BLOCK_SIZE];
+static PFdword testSdCount;
+
+static PFbyte testTouchId, testSdId, testFlashId;
+static SpiBusProfile testProfiles[2] =
+{
+    {{TEST_TOUCH_CS_PORT, TEST_TOUCH_CS_PIN}, TEST_TOUCH_BAUD, enSpi0Mode_0, enBooleanTrue},
+    {{TEST_SD_CS_PORT, TEST_SD_CS_PIN}, TEST_SD_BAUD, enSpi0Mode_0, enBooleanFalse}
+};
+static CfgSpiBus testBusConfig = {testProfiles, 2, NULL};
+static CfgTouch testTouchConfig =
+{
+    {TEST_TOUCH_INT_PORT, TEST_TOUCH_INT_PIN},
+    {GPIO_PORT_0, GPIO_PIN_19},
+    {TEST_TOUCH_CS_PORT, TEST_TOUCH_CS_PIN},
+    enTouchReferenceSelect_Differential,
+    enTouchPrecision_12bit,
+    spiBusRegisterDevice,
+    spiBusChipSelect,
+    spiBusSubmit,
+    spiBusService
+};
+
+PFdword pfSysGetPclk(PFdword peripheral)
+{
+    (void)peripheral;
+    return TEST_PCLK;
+}
+
+PFEnStatus pfSpi0RegisterDevice(PFbyte* id, PFpGpioPortPin chipSelect)
+{
+    PFdword baud = 0;
+
+    if (testRegistered == SPI_BUS_MAX_DEVICES)
+    {
+        return enStatusNoMem;
+    }
+    if (chipSelect->port == TEST_TOUCH_CS_PORT && chipSelect->pin == TEST_TOUCH_CS_PIN)
+    {
+        baud = TEST_TOUCH_BAUD;
+    }
+    else if (chipSelect->port == TEST_SD_CS_PORT && chipSelect->pin == TEST_SD_CS_PIN)
+    {
+        baud = TEST_SD_BAUD;
+    }
+    *id = testRegistered++;
+    testPins[*id] = *chipSelect;
+    testBaud[*id] = baud;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSpi0UnregisterDevice(PFbyte* id)
+{
+    (void)id;
+    return enStatusSuccess;
+}
+
+static PFEnBoolean testIs(PFbyte id, PFdword port, PFdword pin)
+{
+    return (id < testRegistered && testPins[id].port == port && testPins[id].pin == pin) ? enBooleanTrue : enBooleanFalse;
+}
+
+PFEnStatus pfSpi0ChipSelect(PFbyte* id, PFbyte pinStatus)
+{
+    if (pinStatus == 0)
+    {
+        // Only one chip select may be low
+        if (testSelected != TEST_NO_DEVICE && testSelected != *id)
+        {
+            testBusErrors++;
+            return enStatusBusy;
+        }
+        testSelected = *id;
+        if (testIs(*id, TEST_TOUCH_CS_PORT, TEST_TOUCH_CS_PIN) == enBooleanTrue)
+        {
+            testConversion = 0;
+            testResultBytes = 0;
+            testOutlier = rand() % TOUCH_SAMPLES;
+            if (testSamplePending == enBooleanTrue)
+            {
+                testSamplePending = enBooleanFalse;
+                if (pfTickGet() - testInterruptTick > testMaxLatency)
+                {
+                    testMaxLatency = pfTickGet() - testInterruptTick;
+                }
+            }
+        }
+    }
+    else if (testSelected == *id)
+    {
+        testSelected = TEST_NO_DEVICE;
+    }
+    return enStatusSuccess;
+}
+
+/* 12 bit code of the touch controller for a channel, one sample of the frame has a wrong position */
+static PFdword testTouchCode(PFbyte command)
+{
+    PFdword sample = testConversion / TOUCH_CHANNELS, z1 = 1000;
+
+    switch (command & 0x70)
+    {
+        case 0x50:
+            return (sample == testOutlier) ? (PFdword)rand() % 4096 : testCodeX;
+        case 0x10:
+            return (sample == testOutlier) ? (PFdword)rand() % 4096 : testCodeY;
+        case 0x30:
+            return z1;
+        case 0x40:
+            // Resistance of the touch = X * (Z2 / Z1 - 1)
+            return z1 + z1 * testResistance / testCodeX;
+        default:
+            testBusErrors++;
+            return 0;
+    }
+}
+
+static void testTouchInterrupt(void)
+{
+    testIpsr = 1;
+    if (touchSampleStart() == enStatusSuccess)
+    {
+        testInterruptTick = pfTickGet();
+        testSamplePending = enBooleanTrue;
+        testInterrupts++;
+    }
+    testIpsr = 0;
+}
+
+/* Time of a byte at the rate set in the channel, the rate has to be the one of the selected device */
+static void testClock(void)
+{
+    PFdword rate;
+
+    rate = TEST_PCLK / (testSsp.CPSR * (((testSsp.CR0 >> 8) & 0xFF) + 1));
+    if (testBaud[testSelected] != 0)
+    {
+        testProfileErrors += (rate > testBaud[testSelected] || rate < testBaud[testSelected] / 2);
+    }
+    else
+    {
+        testProfileErrors += (testSsp.CR0 != TEST_CR0_DEFAULT || testSsp.CPSR != TEST_CPSR_DEFAULT);
+    }
+
+    testNs += 8000000000ULL / rate;
+    pfTickAdd(testNs / TEST_TICK_NS);
+    testNs %= TEST_TICK_NS;
+}
+
+PFEnStatus pfSpi0ExchangeByte(PFbyte* id, PFbyte data, PFbyte* rxData)
+{
+    if (*id != testSelected)
+    {
+        testBusErrors++;
+        return enStatusInvState;
+    }
+    testClock();
+    *rxData = 0;
+
+    if (testIs(*id, TEST_TOUCH_CS_PORT, TEST_TOUCH_CS_PIN) == enBooleanTrue)
+    {
+        // The result follows the control byte, the upper 8 bits then the lower 4 bits
+        if (testResultBytes == 1)
+        {
+            *rxData = (PFbyte)(testResult << 4);
+        }
+        else if (testResultBytes == 2)
+        {
+            *rxData = (PFbyte)(testResult >> 4);
+        }
+        testResultBytes -= (testResultBytes != 0);
+        if ((data & 0x80) != 0)
+        {
+            // An 8 bit conversion gives the upper 8 bits of the code
+            testResult = testTouchCode(data) & (((data & 0x08) != 0) ? 0xFF0 : 0xFFF);
+            testResultBytes = 2;
+            testConversion++;
+        }
+    }
+    else if (testIs(*id, TEST_SD_CS_PORT, TEST_SD_CS_PIN) == enBooleanTrue)
+    {
+        testSdReceived[testSdCount++ % sizeof(testSdReceived)] = data;
+        if (testPenDown == enBooleanTrue && rand() % TEST_INT_CHANCE == 0)
+        {
+            testTouchInterrupt();
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSpi0Write(PFbyte* id, PFbyte* data, PFdword size, PFcallback delayCallback)
+{
+    PFbyte rx;
+    PFdword k;
+
+    (void)delayCallback;
+    for (k = 0; k < size; k++)
+    {
+        pfSpi0ExchangeByte(id, data[k], &rx);
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSpi0Read(PFbyte* id, PFbyte* data, PFdword size, PFdword* readBytes, PFcallback delayCallback)
+{
+    PFdword k;
+
+    (void)delayCallback;
+    for (k = 0; k < size; k++)
+    {
+        pfSpi0ExchangeByte(id, 0xFF, &data[k]);
+    }
+    *readBytes = size;
+    return enStatusSuccess;
+}
+
+PFEnStatus pfSpi0DmaTransfer(PFbyte* txData, PFbyte* rxData, PFdword size, PFcallback waitCallback)
+{
+    (void)txData;
+    (void)rxData;
+    (void)size;
+    (void)waitCallback;
+    return enStatusNotSupported;
+}
+
+static void testOpen(void)
+{
+    memset(&testSsp, 0, sizeof(testSsp));
+    testSsp.CR0 = TEST_CR0_DEFAULT;
+    testSsp.CPSR = TEST_CPSR_DEFAULT;
+    testRegistered = 0;
+    testSelected = TEST_NO_DEVICE;
+    testPenDown = enBooleanFalse;
+    pfTickSetTimerPeriod(1);
+    pfTickReset();
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusOpen(&testBusConfig));
+    TEST_ASSERT_EQUAL(enStatusSuccess, touchOpen(&testTouchConfig));
+    testTouchId = touchSpiId;
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusRegisterDevice(&testSdId, &testProfiles[1].chipSelect));
+}
+
+/* Touch at a random position of the LCD, as codes of the panel */
+static void testTouch(PFdword resistance, PFdword* x, PFdword* y)
+{
+    testCodeX = TOUCH_X_MIN + rand() % (TOUCH_X_MAX - TOUCH_X_MIN + 1);
+    testCodeY = TOUCH_Y_MIN + rand() % (TOUCH_Y_MAX - TOUCH_Y_MIN + 1);
+    testResistance = resistance;
+    testPenDown = enBooleanTrue;
+    *x = (testCodeX - TOUCH_X_MIN) * TOUCH_LCD_WIDTH / (TOUCH_X_MAX - TOUCH_X_MIN);
+    *y = TOUCH_LCD_HEIGHT - (testCodeY - TOUCH_Y_MIN) * TOUCH_LCD_HEIGHT / (TOUCH_Y_MAX - TOUCH_Y_MIN);
+}
+
+/* Multiple block write of the SD card, yielding between the data blocks as mmc.c does */
+static PFEnStatus testSdWrite(PFdword blocks)
+{
+    PFdword block;
+
+    if (spiBusChipSelect(&testSdId, 0) != enStatusSuccess)
+    {
+        return enStatusBusy;
+    }
+    for (block = 0; block < blocks; block++)
+    {
+        spiBusWrite(&testSdId, &testSdData[block * TEST_BLOCK_SIZE], TEST_BLOCK_SIZE, NULL);
+        if (block + 1 < blocks)
+        {
+            spiBusYield(&testSdId);
+        }
+    }
+    return spiBusChipSelect(&testSdId, 1);
+}
+
+/* Touches during SD card writes, the samples are read between the data blocks */
+static void testTouchDuringWrites(void)
+{
+    SpiBusStats touchStats, sdStats;
+    PFdword round, blocks, k, x, y, readX, readY, wrongPositions = 0, wrongData = 0, lost = 0;
+    PFdword blockTicks;
+
+    memset(&touchStats, 0, sizeof(touchStats));
+    memset(&sdStats, 0, sizeof(sdStats));
+    testOpen();
+    testMaxLatency = 0;
+    testInterrupts = 0;
+    testSamplesRead = 0;
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testTouch(1000, &x, &y);
+        blocks = 1 + rand() % TEST_MAX_BLOCKS;
+        for (k = 0; k < blocks * TEST_BLOCK_SIZE; k++)
+        {
+            testSdData[k] = (PFbyte)rand();
+        }
+        testSdCount = 0;
+        TEST_ASSERT_EQUAL(enStatusSuccess, testSdWrite(blocks));
+        wrongData += (testSdCount != blocks * TEST_BLOCK_SIZE ||
+                      memcmp(testSdReceived, testSdData, blocks * TEST_BLOCK_SIZE) != 0);
+
+        // The touch task of the main loop
+        if (touchSampleReady == enBooleanTrue)
+        {
+            testSamplesRead++;
+        }
+        lost += (testSamplePending == enBooleanTrue);
+        if (touchAvailable(&readX, &readY) != enBooleanTrue || readX != x || readY != y)
+        {
+            if (wrongPositions++ == 0)
+            {
+                printf("  round %u reads %u, %u for %u, %u\n", (unsigned)round, (unsigned)readX,
+                       (unsigned)readY, (unsigned)x, (unsigned)y);
+            }
+        }
+        testPenDown = enBooleanFalse;
+        TEST_ASSERT(touchAvailable(&readX, &readY) == enBooleanFalse);
+    }
+
+    TEST_ASSERT_EQUAL(0, wrongPositions);
+    TEST_ASSERT_EQUAL(0, wrongData);
+    TEST_ASSERT_EQUAL(0, lost);
+    TEST_ASSERT_EQUAL(0, testBusErrors);
+    TEST_ASSERT_EQUAL(0, testProfileErrors);
+    TEST_ASSERT(testInterrupts > TEST_ROUNDS / 4);
+
+    // A sample waits at most one data block for the bus
+    blockTicks = (PFdword)(8ULL * TEST_BLOCK_SIZE * 1000000000ULL / (TEST_SD_BAUD / 2) / TEST_TICK_NS) + 1;
+    TEST_ASSERT(testMaxLatency <= blockTicks);
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusGetStats(&testTouchId, &touchStats));
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusGetStats(&testSdId, &sdStats));
+    TEST_ASSERT(touchStats.maxWaitTicks <= blockTicks + 1);
+    TEST_ASSERT(sdStats.preemptions != 0 && sdStats.preemptions <= testInterrupts);
+    // A sample of the interrupt is used by the main loop, otherwise the main loop reads one
+    TEST_ASSERT_EQUAL(testInterrupts + TEST_ROUNDS - testSamplesRead, touchStats.transactions);
+    TEST_ASSERT_EQUAL(touchStats.transactions * TOUCH_FRAME_BYTES, touchStats.bytes);
+    printf("  %u touch interrupts, %u preempted writes, longest wait %u of %u ticks for a block\n",
+           (unsigned)testInterrupts, (unsigned)sdStats.preemptions, (unsigned)touchStats.maxWaitTicks,
+           (unsigned)blockTicks);
+    TEST_ASSERT(testSamplesRead != 0);
+}
+
+/* A touch too light for a position keeps the last point while the panel is touched */
+static void testLightTouch(void)
+{
+    PFdword x, y, readX, readY;
+
+    testOpen();
+    testTouch(1000, &x, &y);
+    TEST_ASSERT_EQUAL(enStatusSuccess, touchGetCoordinates(&readX, &readY));
+    TEST_ASSERT(readX == x && readY == y);
+
+    testTouch(TOUCH_PRESSURE_MAX * 2, &readX, &readY);
+    TEST_ASSERT_EQUAL(enStatusError, touchGetCoordinates(&readX, &readY));
+    TEST_ASSERT(touchAvailable(&readX, &readY) == enBooleanTrue);
+    TEST_ASSERT(readX == x && readY == y);
+    testPenDown = enBooleanFalse;
+}
+
+/* A sample asked for while the SD card holds the bus is read when the card releases it */
+static void testBusHeld(void)
+{
+    PFdword x, y, readX, readY;
+
+    testOpen();
+    testTouch(1000, &x, &y);
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusChipSelect(&testSdId, 0));
+    TEST_ASSERT_EQUAL(enStatusBusy, touchGetCoordinates(&readX, &readY));
+    TEST_ASSERT_EQUAL(enStatusBusy, touchSampleStart());
+    TEST_ASSERT_EQUAL(enStatusBusy, spiBusChipSelect(&testTouchId, 0));
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusChipSelect(&testSdId, 1));
+
+    // The panel is released before the sample is taken by the main loop
+    testPenDown = enBooleanFalse;
+    TEST_ASSERT(touchAvailable(&readX, &readY) == enBooleanTrue);
+    TEST_ASSERT(readX == x && readY == y);
+    TEST_ASSERT(touchAvailable(&readX, &readY) == enBooleanFalse);
+    TEST_ASSERT_EQUAL(0, testBusErrors);
+}
+
+/* A device which is not urgent waits until the SD card deselects, it does not preempt it */
+static void testNotUrgent(void)
+{
+    PFGpioPortPin flashPin = {TEST_FLASH_CS_PORT, TEST_FLASH_CS_PIN};
+    SpiBusTransaction transaction;
+    SpiBusStats stats;
+    PFbyte rx[8];
+
+    testOpen();
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusRegisterDevice(&testFlashId, &flashPin));
+    memset(&stats, 0, sizeof(stats));
+    memset(&transaction, 0, sizeof(transaction));
+    transaction.id = &testFlashId;
+    transaction.rxData = rx;
+    transaction.size = sizeof(rx);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusChipSelect(&testSdId, 0));
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusSubmit(&transaction));
+    TEST_ASSERT_EQUAL(enStatusBusy, spiBusService());
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusYield(&testSdId));
+    TEST_ASSERT(transaction.done == enBooleanFalse);
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusChipSelect(&testSdId, 1));
+    TEST_ASSERT(transaction.done == enBooleanTrue);
+    TEST_ASSERT_EQUAL(enStatusSuccess, transaction.status);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusGetStats(&testSdId, &stats));
+    TEST_ASSERT_EQUAL(0, stats.preemptions);
+    TEST_ASSERT_EQUAL(1, stats.transactions);
+    TEST_ASSERT_EQUAL(enStatusSuccess, spiBusGetStats(&testFlashId, &stats));
+    TEST_ASSERT_EQUAL(1, stats.transactions);
+    TEST_ASSERT_EQUAL(sizeof(rx), stats.bytes);
+    TEST_ASSERT_EQUAL(0, testBusErrors);
+    TEST_ASSERT_EQUAL(0, testProfileErrors);
+}
+
+/* 8 bit conversions drop the lower 4 bits of the codes */
+static void testPrecision(void)
+{
+    PFdword x, y, readX, readY;
+
+    testTouchConfig.precsel = enTouchPrecision_8bit;
+    testOpen();
+    testTouch(1000, &x, &y);
+    x = ((testCodeX & 0xFF0) - TOUCH_X_MIN) * TOUCH_LCD_WIDTH / (TOUCH_X_MAX - TOUCH_X_MIN);
+    y = TOUCH_LCD_HEIGHT - ((testCodeY & 0xFF0) - TOUCH_Y_MIN) * TOUCH_LCD_HEIGHT / (TOUCH_Y_MAX - TOUCH_Y_MIN);
+    TEST_ASSERT_EQUAL(enStatusSuccess, touchGetCoordinates(&readX, &readY));
+    TEST_ASSERT(readX == x && readY == y);
+    testPenDown = enBooleanFalse;
+
+    testTouchConfig.precsel = (EnTouchPrecision)1;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, touchOpen(&testTouchConfig));
+    testTouchConfig.precsel = enTouchPrecision_12bit;
+    TEST_ASSERT_EQUAL(0, testBusErrors);
+}
+
+static void testInvalid(void)
+{
+    SpiBusTransaction transaction;
+    PFbyte id = SPI_BUS_MAX_DEVICES;
+    PFdword x, y;
+
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, touchSampleStart());
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, touchGetCoordinates(&x, &y));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, touchOpen(NULL));
+
+    testOpen();
+    memset(&transaction, 0, sizeof(transaction));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, spiBusSubmit(NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, spiBusSubmit(&transaction));
+    transaction.id = &id;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, spiBusSubmit(&transaction));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, spiBusYield(&id));
+    TEST_ASSERT_EQUAL(enStatusInvState, spiBusYield(&testSdId));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, touchGetCoordinates(NULL, &y));
+
+    testIpsr = 1;
+    TEST_ASSERT_EQUAL(enStatusInvState, spiBusService());
+    testIpsr = 0;
+    TEST_ASSERT_EQUAL(enStatusSuccess, touchClose());
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, touchClose());
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testInvalid);
+    TEST_RUN(testTouchDuringWrites);
+    TEST_RUN(testLightTouch);
+    TEST_RUN(testBusHeld);
+    TEST_RUN(testNotUrgent);
+    TEST_RUN(testPrecision);
+    TEST_EXIT();
+}
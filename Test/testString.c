@@ -0,0 +1,209 @@
+/**
+ *  \file       testString.c
+ *  \brief      Host fuzz test of the memory functions of prime_string.
+ *
+ *  pfMemCopy, pfMemMove, pfMemSet, pfMemSet16, pfMemSet32 and pfMemCompare are run on random
+ *  alignments of the source and the destination and random lengths, which go through the byte
+ *  head, the blocks of 16 bytes, the words and the byte tail. The result is compared with the one of
+ *  the C library on a copy of the buffer, so bytes written outside the block are found as well.
+ *  pfMemMove is also run on overlapping blocks in both directions.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "prime_string.h"
+#include "test.h"
+
+#define TEST_BUFFER_SIZE        1024
+#define TEST_MAX_LENGTH         300
+#define TEST_ROUNDS             20000
+
+static PFbyte testBuffer[TEST_BUFFER_SIZE] __attribute__((aligned(8)));
+static PFbyte testExpected[TEST_BUFFER_SIZE] __attribute__((aligned(8)));
+static PFbyte testSource[TEST_BUFFER_SIZE] __attribute__((aligned(8)));
+
+static void testRandomFill(PFbyte* buffer)
+{
+    PFdword index;
+
+    for (index = 0; index < TEST_BUFFER_SIZE; index++)
+    {
+        buffer[index] = (PFbyte)rand();
+    }
+}
+
+/* Fills the buffer and the expected copy with the same random bytes */
+static void testPrepare(void)
+{
+    testRandomFill(testBuffer);
+    memcpy(testExpected, testBuffer, TEST_BUFFER_SIZE);
+}
+
+static PFEnBoolean testSame(void)
+{
+    return (memcmp(testBuffer, testExpected, TEST_BUFFER_SIZE) == 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+static PFdword testLength(void)
+{
+    // Short blocks are the ones with the most branches
+    return (rand() & 1) ? 1 + rand() % 40 : 1 + rand() % TEST_MAX_LENGTH;
+}
+
+static void testCopy(void)
+{
+    PFdword round, dest, src, num, failed = 0;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testPrepare();
+        testRandomFill(testSource);
+        num = testLength();
+        dest = 8 + rand() % 8;
+        src = rand() % 8;
+        TEST_ASSERT_EQUAL(enStatusSuccess, pfMemCopy(&testBuffer[dest], &testSource[src], num));
+        memcpy(&testExpected[dest], &testSource[src], num);
+        if (testSame() != enBooleanTrue && failed++ == 0)
+        {
+            printf("  pfMemCopy dest %u src %u num %u differs\n", (unsigned)dest, (unsigned)src, (unsigned)num);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static void testMove(void)
+{
+    PFdword round, dest, src, num, failed = 0;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testPrepare();
+        num = testLength();
+        src = 24 + rand() % 64;
+        // Destination below, inside or above the source, most of the time overlapping it
+        dest = (PFdword)((PFsdword)src + (rand() % 41) - 20);
+        if ((rand() % 4) == 0)
+        {
+            dest = 8 + rand() % 64;
+        }
+        TEST_ASSERT_EQUAL(enStatusSuccess, pfMemMove(&testBuffer[dest], &testBuffer[src], num));
+        memmove(&testExpected[dest], &testExpected[src], num);
+        if (testSame() != enBooleanTrue && failed++ == 0)
+        {
+            printf("  pfMemMove dest %u src %u num %u differs\n", (unsigned)dest, (unsigned)src, (unsigned)num);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static void testSet(void)
+{
+    PFdword round, dest, num, index, failed = 0;
+    PFword value16;
+    PFdword value32;
+    PFbyte value;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testPrepare();
+        num = testLength();
+        dest = 8 + rand() % 8;
+        value = (PFbyte)rand();
+        TEST_ASSERT_EQUAL(enStatusSuccess, pfMemSet(&testBuffer[dest], value, num));
+        memset(&testExpected[dest], value, num);
+
+        // Halfwords on any even address, words on any aligned address
+        num = testLength() / 2;
+        dest = 8 + 2 * (rand() % 4);
+        value16 = (PFword)rand();
+        if (num != 0)
+        {
+            TEST_ASSERT_EQUAL(enStatusSuccess, pfMemSet16(&testBuffer[dest], value16, num));
+            for (index = 0; index < num; index++)
+            {
+                memcpy(&testExpected[dest + 2 * index], &value16, sizeof(PFword));
+            }
+        }
+
+        num = testLength() / 4;
+        dest = 8 + 4 * (rand() % 2);
+        value32 = (PFdword)rand() * 65599;
+        if (num != 0)
+        {
+            TEST_ASSERT_EQUAL(enStatusSuccess, pfMemSet32(&testBuffer[dest], value32, num));
+            for (index = 0; index < num; index++)
+            {
+                memcpy(&testExpected[dest + 4 * index], &value32, sizeof(PFdword));
+            }
+        }
+
+        if (testSame() != enBooleanTrue && failed++ == 0)
+        {
+            printf("  pfMemSet round %u differs\n", (unsigned)round);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static void testCompare(void)
+{
+    PFdword round, first, second, num, index, failed = 0;
+    PFEnBoolean expected;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testRandomFill(testSource);
+        num = testLength();
+        first = rand() % 8;
+        second = 8 + num + rand() % 8;
+        memcpy(&testSource[second], &testSource[first], num);
+        // Half of the blocks differ in one byte
+        expected = enBooleanTrue;
+        if (rand() & 1)
+        {
+            index = rand() % num;
+            testSource[second + index] ^= (PFbyte)(1 + rand() % 255);
+            expected = enBooleanFalse;
+        }
+        if (pfMemCompare(&testSource[first], &testSource[second], num) != expected)
+        {
+            failed++;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+static void testInvalid(void)
+{
+    PFbyte block[8] = {0};
+
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfMemCopy(NULL, block, 4));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfMemCopy(block, NULL, 4));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfMemMove(block, &block[1], 0));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfMemSet(NULL, 0, 4));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfMemSet16(&testBuffer[1], 0, 4));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfMemSet32(&testBuffer[2], 0, 4));
+    TEST_ASSERT(pfMemCompare(block, block, 0) == enBooleanFalse);
+    TEST_ASSERT(pfMemCompare(NULL, block, 4) == enBooleanFalse);
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testCopy);
+    TEST_RUN(testMove);
+    TEST_RUN(testSet);
+    TEST_RUN(testCompare);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
@@ -0,0 +1,407 @@
+/**
+ *  \file       testStroke.c
+ *  \brief      Host test and benchmark of the stroke engine.
+ *
+ *  Strokes are drawn on a canvas in memory which counts the writes to every pixel. For each trace
+ *  the stroke engine is compared with drawing one pen square per raw sample, the former freehand
+ *  tool: pixels written, overdraw and gaps, a gap being a break between two 8-connected parts of
+ *  the stroke.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <string.h>
+#include "prime_framework.h"
+#include "graphics.h"
+#include "stroke.h"
+#include "test.h"
+
+#define CANVAS_WIDTH        240
+#define CANVAS_HEIGHT       320
+#define MAX_SAMPLES         512
+
+static PFbyte canvas[CANVAS_HEIGHT][CANVAS_WIDTH];
+static PFword testPenSize = 3;
+
+typedef struct
+{
+    PFdword samples;
+    PFdword pixelsWritten;
+    PFdword pixels;
+    PFdword gaps;
+}TraceResult;
+
+typedef struct
+{
+    const char* name;
+    PFword count;
+    StrokePoint points[MAX_SAMPLES];
+}Trace;
+
+PFEnStatus gfxFillArea(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color)
+{
+    PFword x, y;
+
+    (void)color;
+    for (y = yStart; y <= yEnd; y++)
+    {
+        for (x = xStart; x <= xEnd; x++)
+        {
+            canvas[y][x]++;
+        }
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetPenSize(PFword* size)
+{
+    *size = testPenSize;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxGetColor(PFword* color)
+{
+    *color = 0;
+    return enStatusSuccess;
+}
+
+static CfgStroke strokeConfig =
+{
+    0, 0, CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1,
+    STROKE_DEFAULT_TOLERANCE, STROKE_DEFAULT_MIN_DISTANCE, NULL
+};
+
+/* Pseudo random numbers, the same on every run */
+static PFdword randomState;
+
+static PFsdword randomRange(PFsdword lo, PFsdword hi)
+{
+    randomState = randomState * 1103515245 + 12345;
+    return lo + (PFsdword)((randomState >> 16) % (PFdword)(hi - lo + 1));
+}
+
+static void traceAdd(Trace* trace, PFsdword x, PFsdword y)
+{
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x >= CANVAS_WIDTH) x = CANVAS_WIDTH - 1;
+    if (y >= CANVAS_HEIGHT) y = CANVAS_HEIGHT - 1;
+    if (trace->count < MAX_SAMPLES)
+    {
+        trace->points[trace->count].x = (PFsword)x;
+        trace->points[trace->count].y = (PFsword)y;
+        trace->count++;
+    }
+}
+
+/* Straight line sampled every step pixels, with a touch panel jitter of +-jitter pixels */
+static void traceLine(Trace* trace, PFsdword x1, PFsdword y1, PFsdword x2, PFsdword y2, PFsdword step, PFsdword jitter)
+{
+    PFsdword dx = x2 - x1, dy = y2 - y1;
+    PFsdword len = (dx < 0 ? -dx : dx) > (dy < 0 ? -dy : dy) ? (dx < 0 ? -dx : dx) : (dy < 0 ? -dy : dy);
+    PFsdword k;
+
+    for (k = 0; k <= len; k += step)
+    {
+        traceAdd(trace, x1 + dx * k / len + randomRange(-jitter, jitter), y1 + dy * k / len + randomRange(-jitter, jitter));
+    }
+}
+
+static void traceMake(Trace* traces)
+{
+    static const PFsword circle[16][2] =
+    {
+        {200, 160}, {194, 190}, {177, 216}, {151, 233}, {120, 240}, {89, 233}, {63, 216}, {46, 190},
+        {40, 160}, {46, 130}, {63, 104}, {89, 87}, {120, 80}, {151, 87}, {177, 104}, {194, 130}
+    };
+    PFsdword k, x, y;
+
+    randomState = 1;
+    memset(traces, 0, 5 * sizeof(Trace));
+
+    traces[0].name = "slow line";
+    traceLine(&traces[0], 20, 20, 200, 120, 1, 1);
+
+    traces[1].name = "fast line";
+    traceLine(&traces[1], 20, 300, 220, 40, 17, 0);
+
+    traces[2].name = "fast circle";
+    for (k = 0; k <= 16; k++)
+    {
+        traceAdd(&traces[2], circle[k % 16][0], circle[k % 16][1]);
+    }
+
+    traces[3].name = "zigzag";
+    for (k = 0; k < 6; k++)
+    {
+        traceLine(&traces[3], 30, 40 + k * 40, 210, 60 + k * 40, 6, 1);
+    }
+
+    traces[4].name = "scribble";
+    x = 120;
+    y = 160;
+    for (k = 0; k < 200; k++)
+    {
+        x += randomRange(-12, 12);
+        y += randomRange(-12, 12);
+        x = (x < 10) ? 10 : (x > 230) ? 230 : x;
+        y = (y < 10) ? 10 : (y > 310) ? 310 : y;
+        traceAdd(&traces[4], x, y);
+    }
+}
+
+/* Counts the 8-connected parts of the drawn pixels, a stroke without gaps is one part */
+static PFdword canvasParts(void)
+{
+    static PFbyte seen[CANVAS_HEIGHT][CANVAS_WIDTH];
+    static PFword stack[CANVAS_WIDTH * CANVAS_HEIGHT][2];
+    PFdword parts = 0, top;
+    PFsdword x, y, px, py, nx, ny, dx, dy;
+
+    memset(seen, 0, sizeof(seen));
+    for (y = 0; y < CANVAS_HEIGHT; y++)
+    {
+        for (x = 0; x < CANVAS_WIDTH; x++)
+        {
+            if (canvas[y][x] == 0 || seen[y][x] != 0)
+            {
+                continue;
+            }
+            parts++;
+            seen[y][x] = 1;
+            stack[0][0] = (PFword)x;
+            stack[0][1] = (PFword)y;
+            top = 1;
+            while (top != 0)
+            {
+                top--;
+                px = stack[top][0];
+                py = stack[top][1];
+                for (dy = -1; dy <= 1; dy++)
+                {
+                    for (dx = -1; dx <= 1; dx++)
+                    {
+                        nx = px + dx;
+                        ny = py + dy;
+                        if (nx < 0 || ny < 0 || nx >= CANVAS_WIDTH || ny >= CANVAS_HEIGHT ||
+                            canvas[ny][nx] == 0 || seen[ny][nx] != 0)
+                        {
+                            continue;
+                        }
+                        seen[ny][nx] = 1;
+                        stack[top][0] = (PFword)nx;
+                        stack[top][1] = (PFword)ny;
+                        top++;
+                    }
+                }
+            }
+        }
+    }
+    return parts;
+}
+
+static void canvasMeasure(TraceResult* result)
+{
+    PFsdword x, y;
+
+    result->pixels = 0;
+    result->pixelsWritten = 0;
+    for (y = 0; y < CANVAS_HEIGHT; y++)
+    {
+        for (x = 0; x < CANVAS_WIDTH; x++)
+        {
+            result->pixelsWritten += canvas[y][x];
+            result->pixels += (canvas[y][x] != 0);
+        }
+    }
+    result->gaps = canvasParts() - 1;
+}
+
+/* Former freehand tool: one pen square at every raw sample */
+static void drawSamples(const Trace* trace, TraceResult* result)
+{
+    PFsdword lo = -(PFsdword)(testPenSize / 2), hi = lo + testPenSize - 1;
+    PFword k;
+
+    memset(canvas, 0, sizeof(canvas));
+    for (k = 0; k < trace->count; k++)
+    {
+        PFsdword x1 = trace->points[k].x + lo, y1 = trace->points[k].y + lo;
+        PFsdword x2 = trace->points[k].x + hi, y2 = trace->points[k].y + hi;
+        gfxFillArea(x1 < 0 ? 0 : x1, y1 < 0 ? 0 : y1, x2 >= CANVAS_WIDTH ? CANVAS_WIDTH - 1 : x2,
+                    y2 >= CANVAS_HEIGHT ? CANVAS_HEIGHT - 1 : y2, 0);
+    }
+    result->samples = trace->count;
+    canvasMeasure(result);
+}
+
+static void drawStroke(const Trace* trace, TraceResult* result, StrokeStats* stats)
+{
+    Stroke stroke;
+    PFword k;
+
+    memset(canvas, 0, sizeof(canvas));
+    TEST_ASSERT_EQUAL(enStatusSuccess, strokeBegin(&stroke, &strokeConfig, trace->points[0].x, trace->points[0].y));
+    for (k = 1; k < trace->count; k++)
+    {
+        TEST_ASSERT_EQUAL(enStatusSuccess, strokeAddPoint(&stroke, trace->points[k].x, trace->points[k].y));
+    }
+    TEST_ASSERT_EQUAL(enStatusSuccess, strokeEnd(&stroke));
+    TEST_ASSERT_EQUAL(enStatusSuccess, strokeGetStats(&stroke, stats));
+    result->samples = trace->count;
+    canvasMeasure(result);
+}
+
+/* Every raw sample must be near the drawn stroke: the tolerance plus the jitter filter */
+static PFEnBoolean strokeCoversSamples(const Trace* trace)
+{
+    PFsdword reach = strokeConfig.tolerance + strokeConfig.minDistance;
+    PFsdword x, y;
+    PFword k;
+
+    for (k = 0; k < trace->count; k++)
+    {
+        PFEnBoolean found = enBooleanFalse;
+        for (y = trace->points[k].y - reach; y <= trace->points[k].y + reach && found == enBooleanFalse; y++)
+        {
+            for (x = trace->points[k].x - reach; x <= trace->points[k].x + reach; x++)
+            {
+                if (x >= 0 && y >= 0 && x < CANVAS_WIDTH && y < CANVAS_HEIGHT && canvas[y][x] != 0)
+                {
+                    found = enBooleanTrue;
+                    break;
+                }
+            }
+        }
+        if (found != enBooleanTrue)
+        {
+            return enBooleanFalse;
+        }
+    }
+    return enBooleanTrue;
+}
+
+static void testTraces(void)
+{
+    static Trace traces[5];
+    TraceResult before, after;
+    StrokeStats stats;
+    PFbyte k;
+
+    traceMake(traces);
+    printf("  %-12s %7s %8s | %8s %8s %5s | %8s %8s %8s %5s\n", "trace", "samples", "vertices",
+           "written", "overdraw", "gaps", "written", "overdraw", "fills", "gaps");
+    for (k = 0; k < 5; k++)
+    {
+        drawSamples(&traces[k], &before);
+        drawStroke(&traces[k], &after, &stats);
+        printf("  %-12s %7lu %8lu | %8lu %8.2f %5lu | %8lu %8.2f %8lu %5lu\n", traces[k].name,
+               (unsigned long)after.samples, (unsigned long)stats.vertices,
+               (unsigned long)before.pixelsWritten, (double)before.pixelsWritten / before.pixels, (unsigned long)before.gaps,
+               (unsigned long)after.pixelsWritten, (double)after.pixelsWritten / after.pixels,
+               (unsigned long)stats.fills, (unsigned long)after.gaps);
+
+        TEST_ASSERT_EQUAL(0, after.gaps);
+        TEST_ASSERT_EQUAL(after.pixelsWritten, stats.pixelsWritten);
+        // Overdraw comes from the corners of the polyline only
+        TEST_ASSERT(after.pixelsWritten <= after.pixels * 2);
+        TEST_ASSERT(strokeCoversSamples(&traces[k]) == enBooleanTrue);
+    }
+}
+
+/* A collinear stroke keeps only its end points, whatever the number of samples */
+static void testCollinear(void)
+{
+    Stroke stroke;
+    StrokeStats stats;
+    PFword k;
+
+    memset(canvas, 0, sizeof(canvas));
+    strokeBegin(&stroke, &strokeConfig, 10, 10);
+    for (k = 1; k <= 100; k++)
+    {
+        strokeAddPoint(&stroke, 10 + k, 10 + k / 2);
+    }
+    strokeEnd(&stroke);
+    strokeGetStats(&stroke, &stats);
+    TEST_ASSERT(stats.vertices <= 100 / STROKE_WINDOW_SIZE + 3);
+    TEST_ASSERT_EQUAL(1, canvasParts());
+}
+
+/* Samples which move less than minDistance do not add vertices, the last one, one pixel to the right,
+   still ends the stroke */
+static void testJitter(void)
+{
+    Stroke stroke;
+    StrokeStats stats;
+    PFword k;
+
+    memset(canvas, 0, sizeof(canvas));
+    strokeBegin(&stroke, &strokeConfig, 50, 50);
+    for (k = 0; k < 20; k++)
+    {
+        strokeAddPoint(&stroke, 50 + (k & 1), 50);
+    }
+    strokeEnd(&stroke);
+    strokeGetStats(&stroke, &stats);
+    TEST_ASSERT_EQUAL(20, stats.dropped);
+    TEST_ASSERT_EQUAL(2, stats.vertices);
+    TEST_ASSERT_EQUAL(testPenSize * (testPenSize + 1), stats.pixelsWritten);
+}
+
+/* The pen square is clipped to the drawing area */
+static void testClip(void)
+{
+    Stroke stroke;
+    CfgStroke config = strokeConfig;
+    PFsdword x, y;
+
+    config.clipX1 = 100;
+    config.clipX2 = 150;
+    memset(canvas, 0, sizeof(canvas));
+    strokeBegin(&stroke, &config, 80, 100);
+    strokeAddPoint(&stroke, 170, 100);
+    strokeEnd(&stroke);
+    for (y = 0; y < CANVAS_HEIGHT; y++)
+    {
+        for (x = 0; x < CANVAS_WIDTH; x++)
+        {
+            if (canvas[y][x] != 0)
+            {
+                TEST_ASSERT(x >= 100 && x <= 150);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(51 * testPenSize, stroke.stats.pixelsWritten);
+}
+
+static void testInvalid(void)
+{
+    Stroke stroke;
+
+    stroke.active = enBooleanFalse;
+    TEST_ASSERT_EQUAL(enStatusInvArgs, strokeBegin(NULL, &strokeConfig, 0, 0));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, strokeBegin(&stroke, NULL, 0, 0));
+    TEST_ASSERT_EQUAL(enStatusInvState, strokeAddPoint(&stroke, 0, 0));
+    TEST_ASSERT_EQUAL(enStatusInvState, strokeEnd(&stroke));
+}
+
+int main(void)
+{
+    TEST_RUN(testTraces);
+    testPenSize = 1;
+    TEST_RUN(testTraces);
+    testPenSize = 3;
+    TEST_RUN(testCollinear);
+    TEST_RUN(testJitter);
+    TEST_RUN(testClip);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
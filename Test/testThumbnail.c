@@ -0,0 +1,646 @@
+/**
+ *  \file       testThumbnail.c
+ *  \brief      Host benchmark of opening the gallery of saved images.
+ *
+ *  The SDcard is a disk image in memory, the FatFs module itself only being built for the board. Its
+ *  files are contiguous and the file system is modeled as FatFs built with FS_TINY: every access goes
+ *  through the sector window, a sector is read when it is not in the window, and a changed window is
+ *  written when another sector is loaded or a written file is closed. The reads and writes of the FAT
+ *  are not counted.
+ *
+ *  50 canvases are saved to the image as BMP, .pnt and QOI files, with a few files which are not
+ *  images. The pages of the gallery are drawn on an LCD in memory the first time, when every sidecar
+ *  misses and is written, and again when they all hit, then after two images are changed. Every cell
+ *  is compared with a reference box filter of the image. The time and the sectors read and written to
+ *  open the gallery, its first page, and to draw a page are printed.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "graphics.h"
+#include "fatFs.h"
+#include "bmpImage.h"
+#include "pntImage.h"
+#include "qoiImage.h"
+#include "thumbnail.h"
+#include "test.h"
+
+#define TEST_LCD_WIDTH          240
+#define TEST_LCD_HEIGHT         320
+#define TEST_IMAGE_WIDTH        240     /* Canvas below the toolbar, as saved by the application */
+#define TEST_IMAGE_HEIGHT       275
+#define TEST_IMAGES             50
+#define TEST_FACTOR             3
+#define TEST_COLUMNS            3
+#define TEST_ROWS               3
+#define TEST_CELL_WIDTH         80
+#define TEST_CELL_HEIGHT        91
+#define TEST_GALLERY_Y          45
+#define TEST_BACKGROUND         0x4208
+
+#define TEST_SECTOR_SIZE        512
+#define TEST_DIR_SECTOR         100
+#define TEST_DIR_ENTRIES        128     /* 32 byte entries, 16 in a sector */
+#define TEST_DATA_SECTOR        (TEST_DIR_SECTOR + TEST_DIR_ENTRIES / 16)
+#define TEST_DISK_SECTORS       24000
+#define TEST_RECTS              12
+
+// LCD
+
+static PFword testLcd[TEST_LCD_HEIGHT][TEST_LCD_WIDTH];
+static PFword testX1, testY1, testX2, testY2, testCursorX, testCursorY;
+
+PFEnStatus gfxSetWindow(PFword x1, PFword y1, PFword x2, PFword y2)
+{
+    testX1 = x1;
+    testY1 = y1;
+    testX2 = x2;
+    testY2 = y2;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxSetAreaMax(void)
+{
+    return gfxSetWindow(0, 0, TEST_LCD_WIDTH - 1, TEST_LCD_HEIGHT - 1);
+}
+
+PFEnStatus gfxSetCursor(PFword x, PFword y)
+{
+    testCursorX = x;
+    testCursorY = y;
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxWriteCmd(PFword reg)
+{
+    (void)reg;
+    return enStatusSuccess;
+}
+
+/* Writes at the address counter, which runs right and then down in the window */
+PFEnStatus gfxWriteData(PFword data)
+{
+    testLcd[testCursorY][testCursorX] = data;
+    if (testCursorX++ == testX2)
+    {
+        testCursorX = testX1;
+        testCursorY = (testCursorY == testY2) ? testY1 : testCursorY + 1;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus gfxFillArea(PFword xStart, PFword yStart, PFword xEnd, PFword yEnd, PFword color)
+{
+    PFword x, y;
+
+    for (y = yStart; y <= yEnd; y++)
+    {
+        for (x = xStart; x <= xEnd; x++)
+        {
+            testLcd[y][x] = color;
+        }
+    }
+    return enStatusSuccess;
+}
+
+/* Swaps the red and blue fields of a 16 bit pixel */
+PFword bgrToRgb(PFword color)
+{
+    return (PFword)(((color & 0x001F) << 11) | (color & 0x07E0) | (color >> 11));
+}
+
+// Disk image
+
+/* Directory entry, the data of a file is contiguous from its first sector */
+typedef struct
+{
+    char path[THUMB_NAME_SIZE];
+    PFbyte attrib;
+    PFdword sector;
+    PFdword size;
+}TestEntry;
+
+static PFbyte testDisk[TEST_DISK_SECTORS][TEST_SECTOR_SIZE];
+static TestEntry testDir[TEST_DIR_ENTRIES];
+static PFdword testNextSector = TEST_DATA_SECTOR;
+static PFdword testWindow = 0xFFFFFFFF;
+static PFEnBoolean testWindowDirty = enBooleanFalse;
+static PFdword testSectorReads, testSectorWrites, testSidecarsWritten;
+
+/* Loads a sector into the window of the file system, writing the window back first if it changed */
+static void testAccess(PFdword sector, PFEnBoolean write)
+{
+    if (sector != testWindow)
+    {
+        testSectorWrites += (testWindowDirty == enBooleanTrue);
+        testSectorReads++;
+        testWindow = sector;
+        testWindowDirty = enBooleanFalse;
+    }
+    if (write == enBooleanTrue)
+    {
+        testWindowDirty = enBooleanTrue;
+    }
+}
+
+static void testSync(void)
+{
+    testSectorWrites += (testWindowDirty == enBooleanTrue);
+    testWindowDirty = enBooleanFalse;
+}
+
+/* Looks a path up, reading the directory sectors up to its entry */
+static PFdword testFind(const XCHAR* path)
+{
+    PFdword index;
+
+    for (index = 0; index < TEST_DIR_ENTRIES; index++)
+    {
+        if ((index % 16) == 0)
+        {
+            testAccess(TEST_DIR_SECTOR + index / 16, enBooleanFalse);
+        }
+        if (testDir[index].path[0] != 0 && strcmp(testDir[index].path, (const char*)path) == 0)
+        {
+            return index;
+        }
+    }
+    return TEST_DIR_ENTRIES;
+}
+
+static void testFileInfo(PFdword index, FsFileInfo* info)
+{
+    const char* name = strrchr(testDir[index].path, '/');
+
+    memset(info, 0, sizeof(FsFileInfo));
+    info->fsize = testDir[index].size;
+    info->fattrib = testDir[index].attrib;
+    strncpy((char*)info->fname, (name != NULL) ? name + 1 : testDir[index].path, sizeof(info->fname) - 1);
+}
+
+/* The entry index is kept in the start cluster of the file object */
+PFEnStatus fsFileOpen(FsFile* fp, const XCHAR* path, PFbyte mode)
+{
+    PFdword index = testFind(path);
+
+    if (index == TEST_DIR_ENTRIES && (mode & FA_CREATE_ALWAYS) != 0)
+    {
+        for (index = 0; index < TEST_DIR_ENTRIES && testDir[index].path[0] != 0; index++);
+        if (index == TEST_DIR_ENTRIES)
+        {
+            return enStatusAccessDenied;
+        }
+        strncpy(testDir[index].path, (const char*)path, THUMB_NAME_SIZE - 1);
+    }
+    if (index == TEST_DIR_ENTRIES)
+    {
+        return enStatusNoFile;
+    }
+    if ((mode & FA_CREATE_ALWAYS) != 0)
+    {
+        // Written files are put at the end of the data, only one is written at a time
+        testDir[index].attrib = 0;
+        testDir[index].sector = testNextSector;
+        testDir[index].size = 0;
+        testAccess(TEST_DIR_SECTOR + index / 16, enBooleanTrue);
+        testSidecarsWritten += (strstr(testDir[index].path, ".THM") != NULL);
+    }
+
+    memset(fp, 0, sizeof(FsFile));
+    fp->flag = mode & (FA_READ | FA_WRITE);
+    fp->fsize = testDir[index].size;
+    fp->org_clust = index;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileRead(FsFile* fp, void* pBuf, PFdword btr, PFdword* br)
+{
+    TestEntry* entry = &testDir[fp->org_clust];
+    PFbyte* data = (PFbyte*)pBuf;
+    PFdword count;
+
+    *br = 0;
+    btr = (btr > fp->fsize - fp->fptr) ? fp->fsize - fp->fptr : btr;
+    while (btr != 0)
+    {
+        count = TEST_SECTOR_SIZE - fp->fptr % TEST_SECTOR_SIZE;
+        count = (count > btr) ? btr : count;
+        testAccess(entry->sector + fp->fptr / TEST_SECTOR_SIZE, enBooleanFalse);
+        memcpy(data, &testDisk[entry->sector + fp->fptr / TEST_SECTOR_SIZE][fp->fptr % TEST_SECTOR_SIZE], count);
+        data += count;
+        fp->fptr += count;
+        *br += count;
+        btr -= count;
+    }
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileWrite(FsFile* fp, const void* pBuf, PFdword btw, PFdword* bw)
+{
+    TestEntry* entry = &testDir[fp->org_clust];
+    const PFbyte* data = (const PFbyte*)pBuf;
+    PFdword count;
+
+    *bw = 0;
+    if ((fp->flag & FA_WRITE) == 0)
+    {
+        return enStatusAccessDenied;
+    }
+    if (entry->sector + (fp->fptr + btw + TEST_SECTOR_SIZE - 1) / TEST_SECTOR_SIZE > TEST_DISK_SECTORS)
+    {
+        return enStatusDiskError;
+    }
+    while (btw != 0)
+    {
+        count = TEST_SECTOR_SIZE - fp->fptr % TEST_SECTOR_SIZE;
+        count = (count > btw) ? btw : count;
+        testAccess(entry->sector + fp->fptr / TEST_SECTOR_SIZE, enBooleanTrue);
+        memcpy(&testDisk[entry->sector + fp->fptr / TEST_SECTOR_SIZE][fp->fptr % TEST_SECTOR_SIZE], data, count);
+        data += count;
+        fp->fptr += count;
+        *bw += count;
+        btw -= count;
+    }
+    fp->fsize = (fp->fptr > fp->fsize) ? fp->fptr : fp->fsize;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeek(FsFile* fp, PFdword ofs)
+{
+    fp->fptr = (ofs > fp->fsize) ? fp->fsize : ofs;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileSeekFast(FsFile* fp, const PFdword* map, PFdword ofs)
+{
+    (void)map;
+    return fsFileSeek(fp, ofs);
+}
+
+/* A contiguous file is one fragment */
+PFEnStatus fsFileLinkMap(FsFile* fp, PFdword* map)
+{
+    (void)fp;
+    map[1] = 1;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileClose(FsFile* fp)
+{
+    TestEntry* entry = &testDir[fp->org_clust];
+
+    if ((fp->flag & FA_WRITE) != 0)
+    {
+        entry->size = fp->fsize;
+        testNextSector = entry->sector + (entry->size + TEST_SECTOR_SIZE - 1) / TEST_SECTOR_SIZE;
+        testAccess(TEST_DIR_SECTOR + fp->org_clust / 16, enBooleanTrue);
+        testSync();
+    }
+    fp->flag = 0;
+    return enStatusSuccess;
+}
+
+PFEnStatus fsFileDelete(const XCHAR* path)
+{
+    PFdword index = testFind(path);
+
+    if (index == TEST_DIR_ENTRIES)
+    {
+        return enStatusNoFile;
+    }
+    memset(&testDir[index], 0, sizeof(TestEntry));
+    testAccess(TEST_DIR_SECTOR + index / 16, enBooleanTrue);
+    testSync();
+    return enStatusSuccess;
+}
+
+PFEnStatus fsGetFileStatus(const XCHAR* path, FsFileInfo* fno)
+{
+    PFdword index = testFind(path);
+
+    if (index == TEST_DIR_ENTRIES)
+    {
+        return enStatusNoFile;
+    }
+    testFileInfo(index, fno);
+    return enStatusSuccess;
+}
+
+/* The directory is kept in the path of the entries, the index counts the entries read */
+PFEnStatus fsDirOpen(FsDir* dj, const XCHAR* path)
+{
+    memset(dj, 0, sizeof(FsDir));
+    dj->fn = (PFbyte*)path;
+    testAccess(TEST_DIR_SECTOR, enBooleanFalse);
+    return enStatusSuccess;
+}
+
+PFEnStatus fsDirReadEntry(FsDir* dj, FsFileInfo* fno)
+{
+    PFdword length = strlen((const char*)dj->fn);
+
+    memset(fno, 0, sizeof(FsFileInfo));
+    for (; dj->index < TEST_DIR_ENTRIES; dj->index++)
+    {
+        testAccess(TEST_DIR_SECTOR + dj->index / 16, enBooleanFalse);
+        if (strncmp(testDir[dj->index].path, (const char*)dj->fn, length) == 0 &&
+            testDir[dj->index].path[length] == '/' && strchr(&testDir[dj->index].path[length + 1], '/') == NULL)
+        {
+            testFileInfo(dj->index++, fno);
+            break;
+        }
+    }
+    return enStatusSuccess;
+}
+
+// Images
+
+/* Strokes and shapes of a canvas as rectangles of color, over a white canvas with a gradient band */
+static PFword testRects[TEST_IMAGES][TEST_RECTS][5];
+static PFword testVersion[TEST_IMAGES];
+static PFword testRow[TEST_IMAGE_WIDTH];
+
+static PFword testPixel(PFdword image, PFword x, PFword y)
+{
+    PFdword k;
+    PFword band = (PFword)(image * 5 % (TEST_IMAGE_HEIGHT - 20));
+
+    // An image saved again has rows of noise at the top
+    if (y < testVersion[image])
+    {
+        return (PFword)((x * 0x9E37) ^ (y * 0x79B9));
+    }
+    for (k = TEST_RECTS; k-- != 0;)
+    {
+        if (x >= testRects[image][k][0] && x < testRects[image][k][2] &&
+            y >= testRects[image][k][1] && y < testRects[image][k][3])
+        {
+            return testRects[image][k][4];
+        }
+    }
+    if (y >= band && y < band + 20)
+    {
+        return (PFword)(((x * 31 / TEST_IMAGE_WIDTH) << 11) | (((y - band) * 3) << 5) |
+                        (31 - x * 31 / TEST_IMAGE_WIDTH));
+    }
+    return WHITE;
+}
+
+static void testPath(PFdword image, PFchar* path)
+{
+    static const char* extensions[] = {"BMP", "PNT", "QOI"};
+
+    sprintf((char*)path, "PAINT/IMG%05u.%s", (unsigned)image, extensions[image % 3]);
+}
+
+static void testStore32(PFbyte* ptr, PFdword value)
+{
+    ptr[0] = (PFbyte)value;
+    ptr[1] = (PFbyte)(value >> 8);
+    ptr[2] = (PFbyte)(value >> 16);
+    ptr[3] = (PFbyte)(value >> 24);
+}
+
+/* Saves an image in the format of its extension */
+static PFEnStatus testSaveImage(PFdword image)
+{
+    static PntEncoder pnt;
+    static QoiEncoder qoi;
+    PFEnStatus status;
+    PFchar path[THUMB_NAME_SIZE];
+    PFbyte header[54] = {'B', 'M'};
+    PFdword rowSize = TEST_IMAGE_WIDTH * 2, written;
+    FsFile file;
+    PFword x, y;
+
+    testPath(image, path);
+    status = fsFileOpen(&file, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (status != enStatusSuccess)
+    {
+        return status;
+    }
+    switch (image % 3)
+    {
+        case 0:
+            // 16 bit rows bottom row first
+            testStore32(&header[2], sizeof(header) + rowSize * TEST_IMAGE_HEIGHT);
+            testStore32(&header[10], sizeof(header));
+            testStore32(&header[14], 40);
+            testStore32(&header[18], TEST_IMAGE_WIDTH);
+            testStore32(&header[22], TEST_IMAGE_HEIGHT);
+            header[26] = 1;
+            header[28] = 16;
+            status = fsFileWrite(&file, header, sizeof(header), &written);
+            for (y = TEST_IMAGE_HEIGHT; y-- != 0 && status == enStatusSuccess;)
+            {
+                for (x = 0; x < TEST_IMAGE_WIDTH; x++)
+                {
+                    testRow[x] = bgrToRgb(testPixel(image, x, y));
+                }
+                status = fsFileWrite(&file, testRow, rowSize, &written);
+            }
+            break;
+
+        case 1:
+            status = pntEncodeStart(&pnt, &file, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, NULL, 0);
+            for (y = 0; y < TEST_IMAGE_HEIGHT && status == enStatusSuccess; y++)
+            {
+                for (x = 0; x < TEST_IMAGE_WIDTH; x++)
+                {
+                    testRow[x] = testPixel(image, x, y);
+                }
+                status = pntEncodeRows(&pnt, testRow, 1);
+            }
+            status = (status == enStatusSuccess) ? pntEncodeFinish(&pnt) : status;
+            break;
+
+        default:
+            status = qoiEncodeStart(&qoi, &file, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+            for (y = 0; y < TEST_IMAGE_HEIGHT && status == enStatusSuccess; y++)
+            {
+                for (x = 0; x < TEST_IMAGE_WIDTH; x++)
+                {
+                    testRow[x] = testPixel(image, x, y);
+                }
+                status = qoiEncodePixels(&qoi, testRow, TEST_IMAGE_WIDTH);
+            }
+            status = (status == enStatusSuccess) ? qoiEncodeFinish(&qoi) : status;
+            break;
+    }
+    fsFileClose(&file);
+    return status;
+}
+
+static void testMakeCard(void)
+{
+    PFdword image, k;
+    FsFile file;
+    PFdword written;
+    PFword* rect;
+
+    for (image = 0; image < TEST_IMAGES; image++)
+    {
+        for (k = 0; k < TEST_RECTS; k++)
+        {
+            rect = testRects[image][k];
+            rect[0] = (PFword)(rand() % TEST_IMAGE_WIDTH);
+            rect[1] = (PFword)(rand() % TEST_IMAGE_HEIGHT);
+            // Thin strokes and a few filled shapes
+            rect[2] = (PFword)(rect[0] + ((k % 4 == 0) ? 10 + rand() % 80 : 1 + rand() % 4));
+            rect[3] = (PFword)(rect[1] + ((k % 4 == 0) ? 10 + rand() % 80 : 20 + rand() % 100));
+            rect[4] = (PFword)rand();
+        }
+        TEST_ASSERT_EQUAL(enStatusSuccess, testSaveImage(image));
+        if (image == 20)
+        {
+            // Files which are not images are skipped
+            fsFileOpen(&file, (const XCHAR*)"PAINT/NOTES.TXT", FA_CREATE_ALWAYS | FA_WRITE);
+            fsFileWrite(&file, "notes", 5, &written);
+            fsFileClose(&file);
+            strcpy(testDir[TEST_DIR_ENTRIES - 1].path, "PAINT/OLD.BMP");
+            testDir[TEST_DIR_ENTRIES - 1].attrib = AM_DIR;
+        }
+    }
+}
+
+// Test
+
+static CfgThumbGallery testGallery = {(const PFchar*)"PAINT", 0, TEST_GALLERY_Y, TEST_CELL_WIDTH, TEST_CELL_HEIGHT,
+                                      TEST_COLUMNS, TEST_ROWS, TEST_FACTOR, TEST_BACKGROUND};
+
+/* Reference downscale of a pixel: the rounded average of each channel over the box */
+static PFword testReference(PFdword image, PFword x, PFword y)
+{
+    PFdword red = 0, green = 0, blue = 0, count = TEST_FACTOR * TEST_FACTOR;
+    PFword color, j, k;
+
+    for (j = 0; j < TEST_FACTOR; j++)
+    {
+        for (k = 0; k < TEST_FACTOR; k++)
+        {
+            color = testPixel(image, (PFword)(x * TEST_FACTOR + k), (PFword)(y * TEST_FACTOR + j));
+            red += color >> 11;
+            green += (color >> 5) & 0x3F;
+            blue += color & 0x1F;
+        }
+    }
+    return (PFword)((((red + count / 2) / count) << 11) | (((green + count / 2) / count) << 5) |
+                    ((blue + count / 2) / count));
+}
+
+/* Compares the cells of a page with the reference thumbnails, unused cells are cleared */
+static PFdword testCheckPage(PFword first)
+{
+    PFdword wrong = 0, cell, image;
+    PFword x, y, x0, y0, expected;
+
+    for (cell = 0; cell < TEST_COLUMNS * TEST_ROWS; cell++)
+    {
+        image = first + cell;
+        x0 = (PFword)(cell % TEST_COLUMNS * TEST_CELL_WIDTH);
+        y0 = (PFword)(TEST_GALLERY_Y + cell / TEST_COLUMNS * TEST_CELL_HEIGHT);
+        for (y = 0; y < TEST_CELL_HEIGHT; y++)
+        {
+            for (x = 0; x < TEST_CELL_WIDTH; x++)
+            {
+                // The thumbnail of a canvas fills its cell
+                expected = (image < TEST_IMAGES) ? testReference(image, x, y) : TEST_BACKGROUND;
+                wrong += (testLcd[y0 + y][x0 + x] != expected);
+            }
+        }
+    }
+    return wrong;
+}
+
+static double testSeconds(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Opens the gallery and pages through it, checking every page, and prints the cost */
+static void testOpen(const char* name, PFdword sidecars)
+{
+    struct timespec start, end;
+    PFdword reads, writes, firstReads = 0, firstWrites = 0, wrong = 0;
+    PFword first, total = 0, pages = 0;
+    double seconds = 0, firstSeconds = 0;
+
+    testSectorReads = 0;
+    testSectorWrites = 0;
+    testSidecarsWritten = 0;
+    testWindow = 0xFFFFFFFF;
+    for (first = 0; first < TEST_IMAGES; first += TEST_COLUMNS * TEST_ROWS)
+    {
+        memset(testLcd, 0, sizeof(testLcd));
+        reads = testSectorReads;
+        writes = testSectorWrites;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        TEST_ASSERT_EQUAL(enStatusSuccess, thumbGalleryDraw(&testGallery, first, &total));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds += testSeconds(&start, &end);
+        if (first == 0)
+        {
+            firstSeconds = testSeconds(&start, &end);
+            firstReads = testSectorReads - reads;
+            firstWrites = testSectorWrites - writes;
+        }
+        TEST_ASSERT_EQUAL(TEST_IMAGES, total);
+        wrong += testCheckPage(first);
+        pages++;
+    }
+    TEST_ASSERT_EQUAL(0, wrong);
+    TEST_ASSERT_EQUAL(sidecars, testSidecarsWritten);
+    printf("  %-13s first page %7.1f us, %5u sectors read, %4u written; per page %7.1f us, %5u read, %4u written\n",
+           name, firstSeconds * 1e6, (unsigned)firstReads, (unsigned)firstWrites, seconds * 1e6 / pages,
+           (unsigned)(testSectorReads / pages), (unsigned)(testSectorWrites / pages));
+}
+
+/* Opening the gallery when the sidecars miss, hit, and after two images are changed */
+static void testGalleryOpen(void)
+{
+    PFchar path[THUMB_NAME_SIZE];
+    PFword width = 0, height = 0;
+
+    testMakeCard();
+    testOpen("sidecar miss:", TEST_IMAGES);
+    testOpen("sidecar hit:", 0);
+
+    // An image saved again with another size makes its sidecar out of date, one of the same size is invalidated
+    testVersion[4] = 7;
+    TEST_ASSERT_EQUAL(enStatusSuccess, testSaveImage(4));
+    testVersion[30] = 3;
+    TEST_ASSERT_EQUAL(enStatusSuccess, testSaveImage(30));
+    testPath(30, path);
+    TEST_ASSERT_EQUAL(enStatusSuccess, thumbInvalidate(path));
+    testOpen("2 changed:", 2);
+
+    // A single thumbnail, from its sidecar
+    testPath(17, path);
+    TEST_ASSERT_EQUAL(enStatusSuccess, thumbDraw(path, TEST_FACTOR, 0, 0, &width, &height));
+    TEST_ASSERT_EQUAL(TEST_IMAGE_WIDTH / TEST_FACTOR, width);
+    TEST_ASSERT_EQUAL(TEST_IMAGE_HEIGHT / TEST_FACTOR, height);
+    TEST_ASSERT_EQUAL(testReference(17, width - 1, height - 1), testLcd[height - 1][width - 1]);
+    TEST_ASSERT_EQUAL(enStatusSuccess, thumbGalleryGetImage(&testGallery, 49, path));
+    TEST_ASSERT(strcmp((const char*)path, "PAINT/IMG00049.PNT") == 0);
+    TEST_ASSERT_EQUAL(enStatusNotExist, thumbGalleryGetImage(&testGallery, 50, path));
+}
+
+int main(void)
+{
+    srand(1);
+    gfxSetAreaMax();
+    TEST_RUN(testGalleryOpen);
+    TEST_EXIT();
+}
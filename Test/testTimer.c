@@ -0,0 +1,265 @@
+/**
+ *  \file       testTimer.c
+ *  \brief      Host test of the timing wheel of the software timers.
+ *
+ *  The timer source is built with the tick module, whose ticks are advanced by the test in steps of
+ *  random length, as a main loop calling pfTimerProcess() late would see them. Timers with random
+ *  times, one shot or periodic, are started, stopped and restarted at random against a model of their
+ *  expiry ticks: each one has to fire once per expiry, in the tick of its expiry, whatever the level of
+ *  the wheel it started in. Timers beyond the reach of the wheel, the wrap of the tick counter and the
+ *  idle ticks given to the scheduler are tested as well. The time of pfTimerProcess() per tick is
+ *  printed for wheels of 1 to 5000 periodic timers.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "prime_framework.h"
+#include "prime_tick.h"
+#include "prime_timer.h"
+#include "test.h"
+
+#define TEST_TIMERS             200
+#define TEST_ROUNDS             20000
+#define TEST_WHEEL_TICKS        (1UL << (PF_TIMER_SLOT_BITS * PF_TIMER_LEVELS))
+#define TEST_BENCH_TIMERS       5000
+#define TEST_BENCH_TICKS        200000
+
+#include "../Source/PrimeFramework/prime_timer.c"
+
+/* Model of a timer */
+typedef struct
+{
+    PFdword expires;
+    PFdword period;
+    PFEnBoolean running;
+    PFdword fires;
+}TestModel;
+
+static PFTimer testTimers[TEST_TIMERS];
+static TestModel testModels[TEST_TIMERS];
+static PFdword testLateFires, testFires;
+
+/* Checks the expiry against the model, the wheel has just handled the tick before timerNow */
+static void testCallback(PFTimer* timer)
+{
+    TestModel* model = (TestModel*)timer->context;
+
+    testFires++;
+    model->fires++;
+    testLateFires += (model->running != enBooleanTrue || timerNow - 1 != model->expires);
+    if (model->period != 0)
+    {
+        model->expires += model->period;
+    }
+    else
+    {
+        model->running = enBooleanFalse;
+    }
+}
+
+static void testStart(PFdword index, PFdword ticks, PFEnBoolean periodic)
+{
+    TEST_ASSERT_EQUAL(enStatusSuccess, pfTimerStart(&testTimers[index], testCallback, &testModels[index], ticks, periodic));
+    testModels[index].expires = pfTickGet() + ticks;
+    testModels[index].period = (periodic == enBooleanTrue) ? ticks : 0;
+    testModels[index].running = enBooleanTrue;
+}
+
+static void testReset(PFdword startTick)
+{
+    pfTickSetTimerPeriod(1);
+    pfTickReset();
+    pfTickAdd(startTick);
+    memset(testTimers, 0, sizeof(testTimers));
+    memset(testModels, 0, sizeof(testModels));
+    testLateFires = 0;
+    testFires = 0;
+    pfTimerInit();
+}
+
+/* Random times, mostly within the first two levels, some up to the top level */
+static PFdword testRandomTicks(void)
+{
+    switch (rand() % 8)
+    {
+        case 0:
+            return 1 + rand() % 4;
+        case 1:
+            return 1 + rand() % 1000000;
+        default:
+            return 1 + rand() % 5000;
+    }
+}
+
+static void testRandomRun(PFdword startTick)
+{
+    PFdword round, index, failed = 0;
+
+    testReset(startTick);
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        index = rand() % TEST_TIMERS;
+        switch (rand() % 4)
+        {
+            case 0:
+                pfTimerStop(&testTimers[index]);
+                testModels[index].running = enBooleanFalse;
+                break;
+            default:
+                // Starts a stopped timer or restarts a running one
+                testStart(index, testRandomTicks(), (rand() % 3 == 0) ? enBooleanTrue : enBooleanFalse);
+                break;
+        }
+
+        // The main loop is late by a random number of ticks
+        pfTickAdd(rand() % 40);
+        pfTimerProcess();
+        for (index = 0; index < TEST_TIMERS; index++)
+        {
+            failed += (pfTimerIsRunning(&testTimers[index]) != testModels[index].running);
+        }
+        if (failed != 0 || testLateFires != 0)
+        {
+            printf("  round %u at tick %u differs\n", (unsigned)round, (unsigned)pfTickGet());
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+    TEST_ASSERT_EQUAL(0, testLateFires);
+    TEST_ASSERT(testFires > TEST_ROUNDS / 4);
+}
+
+static void testRandomTimers(void)
+{
+    testRandomRun(0);
+}
+
+/* The tick counter wraps while the timers run */
+static void testWrap(void)
+{
+    testRandomRun(0xFFFFFFFF - 200000);
+    TEST_ASSERT(pfTickGet() < 0x80000000);
+}
+
+/* A timer beyond the wheel goes down from the top level more than once */
+static void testBeyondWheel(void)
+{
+    PFdword step;
+
+    testReset(12345);
+    testStart(0, TEST_WHEEL_TICKS + 7777, enBooleanFalse);
+    testStart(1, 3 * TEST_WHEEL_TICKS / 2, enBooleanFalse);
+    for (step = 0; step < 3 * TEST_WHEEL_TICKS / 2 + 10; step += 1000)
+    {
+        pfTickAdd(1000);
+        pfTimerProcess();
+    }
+    TEST_ASSERT_EQUAL(1, testModels[0].fires);
+    TEST_ASSERT_EQUAL(1, testModels[1].fires);
+    TEST_ASSERT_EQUAL(0, testLateFires);
+    TEST_ASSERT(pfTimerIsRunning(&testTimers[0]) == enBooleanFalse);
+}
+
+static void testStopOther(PFTimer* timer)
+{
+    (void)timer;
+    pfTimerStop(&testTimers[1]);
+    testFires++;
+}
+
+/* Idle ticks, and a callback stopping a timer of the same tick */
+static void testIdleTicks(void)
+{
+    testReset(100);
+    TEST_ASSERT_EQUAL(PF_TIMER_NO_EXPIRY, pfTimerGetIdleTicks());
+    testStart(0, 30, enBooleanFalse);
+    TEST_ASSERT_EQUAL(30, pfTimerGetIdleTicks());
+    pfTickAdd(45);
+    TEST_ASSERT_EQUAL(0, pfTimerGetIdleTicks());
+    TEST_ASSERT_EQUAL(1, pfTimerProcess());
+    TEST_ASSERT_EQUAL(PF_TIMER_NO_EXPIRY, pfTimerGetIdleTicks());
+
+    // The cascade from the upper level is work as well, at the next turn of level 0
+    testStart(0, 1000, enBooleanFalse);
+    TEST_ASSERT_EQUAL(PF_TIMER_SLOTS - TIMER_SLOT(pfTickGet(), 0), pfTimerGetIdleTicks());
+
+    // The timers of a tick fire the last started first
+    testReset(0);
+    testStart(1, 10, enBooleanFalse);
+    pfTimerStart(&testTimers[0], testStopOther, NULL, 10, enBooleanFalse);
+    pfTickAdd(10);
+    TEST_ASSERT_EQUAL(1, pfTimerProcess());
+    TEST_ASSERT(pfTimerIsRunning(&testTimers[1]) == enBooleanFalse);
+    TEST_ASSERT_EQUAL(0, testModels[1].fires);
+}
+
+static PFTimer testBenchTimers[TEST_BENCH_TIMERS];
+
+static void testBenchCallback(PFTimer* timer)
+{
+    (void)timer;
+    testFires++;
+}
+
+/* Periodic timers of 1 ms to 5 s, pfTimerProcess() called at every tick as the main loop does */
+static void testBenchmark(void)
+{
+    static const PFdword counts[] = {1, 10, 100, 1000, TEST_BENCH_TIMERS};
+    struct timespec start, end;
+    PFdword k, index, tick;
+    double seconds;
+
+    for (k = 0; k < sizeof(counts) / sizeof(counts[0]); k++)
+    {
+        testReset(0);
+        memset(testBenchTimers, 0, sizeof(testBenchTimers));
+        for (index = 0; index < counts[k]; index++)
+        {
+            pfTimerStart(&testBenchTimers[index], testBenchCallback, NULL, testRandomTicks() % 5000 + 1, enBooleanTrue);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (tick = 0; tick < TEST_BENCH_TICKS; tick++)
+        {
+            pfTickAdd(1);
+            pfTimerProcess();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        TEST_ASSERT(testFires >= counts[k] * (TEST_BENCH_TICKS / 5000));
+        printf("  %4u timers: %6.1f ns per tick, %.2f fires per tick\n", (unsigned)counts[k],
+               seconds / TEST_BENCH_TICKS * 1e9, (double)testFires / TEST_BENCH_TICKS);
+    }
+}
+
+static void testInvalid(void)
+{
+    testReset(0);
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfTimerStart(NULL, testCallback, NULL, 10, enBooleanFalse));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, pfTimerStart(&testTimers[0], NULL, NULL, 10, enBooleanFalse));
+    pfTickSetTimerPeriod(0);
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, pfTimerStart(&testTimers[0], testCallback, NULL, 10, enBooleanFalse));
+    pfTickSetTimerPeriod(1);
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testRandomTimers);
+    TEST_RUN(testWrap);
+    TEST_RUN(testBeyondWheel);
+    TEST_RUN(testIdleTicks);
+    TEST_RUN(testBenchmark);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
@@ -0,0 +1,268 @@
+/**
+ *  \file       testTrace.c
+ *  \brief      Host flood test of the ring of the trace logger.
+ *
+ *  The logger source is built with the DWT registers replaced by variables of the test, and the serial
+ *  driver by a transmit buffer of the test whose free room is set by each test. Events are recorded
+ *  faster than they are drained, the ring fills up and the drops are reported by a notice record. The
+ *  bytes sent have to hold every recorded event once, in order, with the sequence numbers following
+ *  each other, and the events recorded plus the events dropped have to give the events made.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "trace.h"
+#include "test.h"
+
+#define TEST_TX_SIZE            (64 * sizeof(TraceRecord))
+#define TEST_FLOOD_ROUNDS       2000
+#define TEST_EVENT_ID           0x1234
+
+/* Core stand-in */
+static DWT_Type testDwt;
+static CoreDebug_Type testCoreDebug;
+
+#undef DWT
+#undef CoreDebug
+#define DWT                     (&testDwt)
+#define CoreDebug               (&testCoreDebug)
+
+#include "../Source/AppHelper/trace.c"
+
+/* Serial driver stand-in, the records written since the last testSerialReset() */
+static TraceRecord testSent[TEST_TX_SIZE / sizeof(TraceRecord)];
+static PFdword testSentCount;
+static PFdword testTxCount;
+static PFdword testTimestamp;
+
+static PFEnStatus testWrite(PFbyte* data, PFdword size)
+{
+    if (size != sizeof(TraceRecord) || testTxCount + size >= TEST_TX_SIZE)
+    {
+        return enStatusError;
+    }
+    memcpy(&testSent[testSentCount++], data, size);
+    testTxCount += size;
+    return enStatusSuccess;
+}
+
+static PFEnStatus testGetTxBufferSize(PFdword* size)
+{
+    *size = TEST_TX_SIZE;
+    return enStatusSuccess;
+}
+
+static PFEnStatus testGetTxBufferCount(PFdword* count)
+{
+    *count = testTxCount;
+    return enStatusSuccess;
+}
+
+static PFdword testGetTimestamp(void)
+{
+    return ++testTimestamp;
+}
+
+/* Empties the transmit buffer but for the given number of bytes */
+static void testSerialReset(PFdword count)
+{
+    testSentCount = 0;
+    testTxCount = count;
+}
+
+static void testOpen(PFdword (*timestamp)(void))
+{
+    CfgTrace config = {testWrite, testGetTxBufferSize, testGetTxBufferCount, timestamp};
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceOpen(&config));
+    testTimestamp = 0;
+    testSerialReset(0);
+}
+
+static void testFlood(void)
+{
+    TraceStats stats;
+    PFdword index;
+
+    testOpen(testGetTimestamp);
+    for (index = 0; index < TRACE_BUFFER_SIZE; index++)
+    {
+        TEST_ASSERT_EQUAL(enStatusSuccess, traceEvent(TEST_EVENT_ID, index, ~index));
+    }
+    for (index = 0; index < 10; index++)
+    {
+        TEST_ASSERT_EQUAL(enStatusNoMem, traceEvent(TEST_EVENT_ID, 0, 0));
+    }
+
+    // The notice comes first, then the ring in order, as much as the transmit buffer takes
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+    TEST_ASSERT_EQUAL(TEST_TX_SIZE / sizeof(TraceRecord) - 1, testSentCount);
+    TEST_ASSERT_EQUAL(TRACE_SYNC, testSent[0].sync);
+    TEST_ASSERT_EQUAL(TRACE_ID_DROPPED, testSent[0].id);
+    TEST_ASSERT_EQUAL(10, testSent[0].arg1);
+    TEST_ASSERT_EQUAL(10, testSent[0].arg2);
+    for (index = 1; index < testSentCount; index++)
+    {
+        TEST_ASSERT_EQUAL(TRACE_SYNC, testSent[index].sync);
+        TEST_ASSERT_EQUAL((PFbyte)(index - 1), testSent[index].sequence);
+        TEST_ASSERT_EQUAL(TEST_EVENT_ID, testSent[index].id);
+        TEST_ASSERT_EQUAL(index, testSent[index].timestamp);
+        TEST_ASSERT_EQUAL(index - 1, testSent[index].arg1);
+        TEST_ASSERT_EQUAL(~(index - 1), testSent[index].arg2);
+    }
+
+    // The rest on the next drain, the notice is not sent again
+    testSerialReset(0);
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+    TEST_ASSERT_EQUAL(2, testSentCount);
+    TEST_ASSERT_EQUAL(TRACE_BUFFER_SIZE - 2, testSent[0].sequence);
+    TEST_ASSERT_EQUAL(TRACE_BUFFER_SIZE - 1, testSent[1].arg1);
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceGetStats(&stats));
+    TEST_ASSERT_EQUAL(TRACE_BUFFER_SIZE, stats.events);
+    TEST_ASSERT_EQUAL(10, stats.dropped);
+    TEST_ASSERT_EQUAL(TRACE_BUFFER_SIZE, stats.drained);
+    TEST_ASSERT_EQUAL(TRACE_BUFFER_SIZE, stats.maxUsed);
+}
+
+/* Bursts of events of random length between drains into a transmit buffer of random room */
+static void testFloodRounds(void)
+{
+    TraceStats stats;
+    TraceRecord last;
+    PFdword round, burst, index, made = 0, received = 0, dropped = 0, failed = 0;
+    PFbyte sequence = 0;
+
+    testOpen(testGetTimestamp);
+    for (round = 0; round < TEST_FLOOD_ROUNDS; round++)
+    {
+        burst = rand() % (2 * TRACE_BUFFER_SIZE);
+        for (index = 0; index < burst; index++)
+        {
+            traceEvent(TEST_EVENT_ID, made++, 0);
+        }
+
+        testSerialReset(rand() % TEST_TX_SIZE);
+        TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+        for (index = 0; index < testSentCount; index++)
+        {
+            if (testSent[index].id == TRACE_ID_DROPPED)
+            {
+                dropped += testSent[index].arg1;
+                continue;
+            }
+            // The records of the events made between drops follow each other
+            failed += (testSent[index].sequence != sequence++);
+            failed += (received != 0 && testSent[index].arg1 <= last.arg1);
+            failed += (received != 0 && testSent[index].timestamp <= last.timestamp);
+            last = testSent[index];
+            received++;
+        }
+        if (failed != 0)
+        {
+            printf("  round %u differs\n", (unsigned)round);
+            break;
+        }
+    }
+
+    // Whatever is left
+    do
+    {
+        testSerialReset(0);
+        TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+        for (index = 0; index < testSentCount; index++)
+        {
+            if (testSent[index].id == TRACE_ID_DROPPED)
+            {
+                dropped += testSent[index].arg1;
+                continue;
+            }
+            failed += (testSent[index].sequence != sequence++);
+            received++;
+        }
+    } while (testSentCount != 0);
+
+    TEST_ASSERT_EQUAL(0, failed);
+    TEST_ASSERT(dropped != 0);
+    TEST_ASSERT_EQUAL(made, received + dropped);
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceGetStats(&stats));
+    TEST_ASSERT_EQUAL(received, stats.events);
+    TEST_ASSERT_EQUAL(received, stats.drained);
+    TEST_ASSERT_EQUAL(dropped, stats.dropped);
+    TEST_ASSERT_EQUAL(TRACE_BUFFER_SIZE, stats.maxUsed);
+}
+
+/* A record reserved by a writer which has not finished it stops the drain */
+static void testUnfinished(void)
+{
+    testOpen(testGetTimestamp);
+    traceEvent(TEST_EVENT_ID, 0, 0);
+    traceEvent(TEST_EVENT_ID, 1, 0);
+    traceEvent(TEST_EVENT_ID, 2, 0);
+    traceRing[1].sync = 0;
+
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+    TEST_ASSERT_EQUAL(1, testSentCount);
+    TEST_ASSERT_EQUAL(0, testSent[0].arg1);
+
+    traceRing[1].sync = TRACE_SYNC;
+    testSerialReset(0);
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+    TEST_ASSERT_EQUAL(2, testSentCount);
+    TEST_ASSERT_EQUAL(1, testSent[0].arg1);
+    TEST_ASSERT_EQUAL(2, testSent[1].arg1);
+}
+
+/* The cycle counter is started for any timestamp, and reset only when it gives the timestamps */
+static void testTimestamps(void)
+{
+    memset(&testDwt, 0, sizeof(testDwt));
+    memset(&testCoreDebug, 0, sizeof(testCoreDebug));
+    testDwt.CYCCNT = 1000;
+    testOpen(testGetTimestamp);
+    TEST_ASSERT(testCoreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+    TEST_ASSERT(testDwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    TEST_ASSERT_EQUAL(1000, testDwt.CYCCNT);
+
+    testOpen(NULL);
+    TEST_ASSERT_EQUAL(0, testDwt.CYCCNT);
+    testDwt.CYCCNT = 5000;
+    traceEvent(TEST_EVENT_ID, 0, 0);
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceDrain());
+    TEST_ASSERT_EQUAL(5000, testSent[0].timestamp);
+}
+
+static void testInvalid(void)
+{
+    CfgTrace config = {testWrite, testGetTxBufferSize, NULL, NULL};
+    TraceStats stats;
+
+    traceInit = enBooleanFalse;
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, traceEvent(TEST_EVENT_ID, 0, 0));
+    TEST_ASSERT_EQUAL(enStatusNotConfigured, traceDrain());
+    TEST_ASSERT_EQUAL(enStatusInvArgs, traceOpen(&config));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, traceOpen(NULL));
+    TEST_ASSERT_EQUAL(enStatusInvArgs, traceGetStats(NULL));
+    TEST_ASSERT_EQUAL(enStatusSuccess, traceGetStats(&stats));
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testFlood);
+    TEST_RUN(testFloodRounds);
+    TEST_RUN(testUnfinished);
+    TEST_RUN(testTimestamps);
+    TEST_RUN(testInvalid);
+    TEST_EXIT();
+}
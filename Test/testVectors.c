@@ -0,0 +1,192 @@
+/**
+ *  \file       testVectors.c
+ *  \brief      Host test of the copy and zero tables walked by the startup code.
+ *
+ *  The startup source is built with tables of the test in place of the ones of the linker script.
+ *  As in lpc1768_flash.ld, the load images of the copied sections follow one another in one flash
+ *  image and the sections lie in two RAM arrays, some of them empty. Every word of a copied section
+ *  has to be the one of its load image, every word of a cleared section 0, and the words around the
+ *  sections have to be left as they were. Random layouts are tested as well.
+ *
+ *  \copyright  Copyright (c) 2016 <br> PhiRobotics Research Pvt Ltd
+ *
+ *  \par
+ *   For licensing information, see the file 'LICENSE' in the root folder of
+ *   this software module.
+ *
+ *  Review status: NO
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "prime_framework.h"
+#include "test.h"
+
+#define TEST_FLASH_WORDS        512
+#define TEST_RAM_WORDS          256
+#define TEST_MAX_ENTRIES        4
+#define TEST_ROUNDS             20000
+#define TEST_GUARD              0xA5A5A5A5
+
+#include "../Source/PrimeFramework/prime_vectors.c"
+
+/* Symbols of the linker script, ResetHandler is not called by the test */
+PFdword _stext;
+PFdword _estack;
+const VectorsCopyEntry __copy_table_start__[1];
+const VectorsCopyEntry __copy_table_end__[1];
+const VectorsZeroEntry __zero_table_start__[1];
+const VectorsZeroEntry __zero_table_end__[1];
+
+static PFdword testFlash[TEST_FLASH_WORDS];
+static PFdword testRam1[TEST_RAM_WORDS];
+static PFdword testRam2[TEST_RAM_WORDS];
+static PFdword testExpected1[TEST_RAM_WORDS];
+static PFdword testExpected2[TEST_RAM_WORDS];
+static VectorsCopyEntry testCopyTable[TEST_MAX_ENTRIES];
+static VectorsZeroEntry testZeroTable[TEST_MAX_ENTRIES];
+
+static void testFill(void)
+{
+    PFdword index;
+
+    for (index = 0; index < TEST_FLASH_WORDS; index++)
+    {
+        testFlash[index] = ((PFdword)rand() << 16) ^ (PFdword)rand();
+    }
+    for (index = 0; index < TEST_RAM_WORDS; index++)
+    {
+        testRam1[index] = TEST_GUARD;
+        testRam2[index] = TEST_GUARD;
+    }
+    memcpy(testExpected1, testRam1, sizeof(testRam1));
+    memcpy(testExpected2, testRam2, sizeof(testRam2));
+}
+
+/* The expected RAM arrays after the tables */
+static void testModelCopy(PFdword* expected, PFdword start, PFdword end, PFdword load)
+{
+    memcpy(&expected[start], &testFlash[load], (end - start) * sizeof(PFdword));
+}
+
+static void testModelZero(PFdword* expected, PFdword start, PFdword end)
+{
+    memset(&expected[start], 0, (end - start) * sizeof(PFdword));
+}
+
+static PFEnBoolean testRamMatches(void)
+{
+    return (memcmp(testRam1, testExpected1, sizeof(testRam1)) == 0 &&
+            memcmp(testRam2, testExpected2, sizeof(testRam2)) == 0) ? enBooleanTrue : enBooleanFalse;
+}
+
+/* The layout of lpc1768_flash.ld: .data in RAM2 and .ramfunc in RAM1, .bss in RAM1 and .ahbbss in RAM2 */
+static void testScriptLayout(void)
+{
+    testFill();
+    // .data, loaded at the end of .text, then .ramfunc, loaded after it
+    testCopyTable[0].load = &testFlash[100];
+    testCopyTable[0].start = &testRam2[0];
+    testCopyTable[0].end = &testRam2[40];
+    testCopyTable[1].load = &testFlash[140];
+    testCopyTable[1].start = &testRam1[0];
+    testCopyTable[1].end = &testRam1[64];
+    testZeroTable[0].start = &testRam1[64];
+    testZeroTable[0].end = &testRam1[200];
+    testZeroTable[1].start = &testRam2[40];
+    testZeroTable[1].end = &testRam2[90];
+
+    vectorsCopy(testCopyTable, testCopyTable + 2);
+    vectorsZero(testZeroTable, testZeroTable + 2);
+    testModelCopy(testExpected2, 0, 40, 100);
+    testModelCopy(testExpected1, 0, 64, 140);
+    testModelZero(testExpected1, 64, 200);
+    testModelZero(testExpected2, 40, 90);
+    TEST_ASSERT(testRamMatches() == enBooleanTrue);
+    TEST_ASSERT_EQUAL(TEST_GUARD, testRam1[200]);
+    TEST_ASSERT_EQUAL(TEST_GUARD, testRam2[90]);
+}
+
+/* Sections without any variable, and tables without any entry */
+static void testEmpty(void)
+{
+    testFill();
+    testCopyTable[0].load = &testFlash[100];
+    testCopyTable[0].start = &testRam2[10];
+    testCopyTable[0].end = &testRam2[10];
+    testCopyTable[1].load = &testFlash[100];
+    testCopyTable[1].start = &testRam1[0];
+    testCopyTable[1].end = &testRam1[3];
+    testZeroTable[0].start = &testRam1[3];
+    testZeroTable[0].end = &testRam1[3];
+
+    vectorsCopy(testCopyTable, testCopyTable + 2);
+    vectorsZero(testZeroTable, testZeroTable + 1);
+    testModelCopy(testExpected1, 0, 3, 100);
+    TEST_ASSERT(testRamMatches() == enBooleanTrue);
+
+    vectorsCopy(testCopyTable, testCopyTable);
+    vectorsZero(testZeroTable, testZeroTable);
+    TEST_ASSERT(testRamMatches() == enBooleanTrue);
+}
+
+/* Random sections, one after the other in each RAM array as the linker places them */
+static void testRandom(void)
+{
+    PFdword round, entry, copies, zeros, load, next1, next2, size, failed = 0;
+    PFdword* ram;
+    PFdword* expected;
+    PFdword* next;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        testFill();
+        copies = rand() % (TEST_MAX_ENTRIES + 1);
+        zeros = rand() % (TEST_MAX_ENTRIES + 1);
+        load = rand() % 16;
+        next1 = rand() % 8;
+        next2 = rand() % 8;
+        for (entry = 0; entry < copies + zeros; entry++)
+        {
+            ram = (rand() & 1) ? testRam1 : testRam2;
+            expected = (ram == testRam1) ? testExpected1 : testExpected2;
+            next = (ram == testRam1) ? &next1 : &next2;
+            size = (rand() % 4 == 0) ? 0 : (PFdword)rand() % (TEST_RAM_WORDS / (4 * TEST_MAX_ENTRIES));
+            if (entry < copies)
+            {
+                testCopyTable[entry].load = &testFlash[load];
+                testCopyTable[entry].start = &ram[*next];
+                testCopyTable[entry].end = &ram[*next + size];
+                testModelCopy(expected, *next, *next + size, load);
+                load += size;
+            }
+            else
+            {
+                testZeroTable[entry - copies].start = &ram[*next];
+                testZeroTable[entry - copies].end = &ram[*next + size];
+                testModelZero(expected, *next, *next + size);
+            }
+            // Sections are word aligned, with a gap at times
+            *next += size + rand() % 2;
+        }
+
+        vectorsCopy(testCopyTable, testCopyTable + copies);
+        vectorsZero(testZeroTable, testZeroTable + zeros);
+        if (testRamMatches() != enBooleanTrue && failed++ == 0)
+        {
+            printf("  round %u with %u copies and %u zeros differs\n", (unsigned)round, (unsigned)copies,
+                   (unsigned)zeros);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failed);
+}
+
+int main(void)
+{
+    srand(1);
+    TEST_RUN(testScriptLayout);
+    TEST_RUN(testEmpty);
+    TEST_RUN(testRandom);
+    TEST_EXIT();
+}
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Reports the use of the memories and of the placement sections from the map file of the linker.
+
+The sections are the ones of lpc1768_flash.ld: .ramfunc holds the functions marked PF_RAMFUNC, run
+from RAM1, .ahbbss and .ahbram the variables marked PF_AHB_BSS and PF_AHB_NOINIT in RAM2, .stack
+the room kept for the stack at the end of RAM2. The
+contents of .ramfunc are listed by object file and symbol, static functions only show in the size
+of their object file. Sections loaded from flash, .data and .ramfunc, are counted in FLASH too.
+
+    make mapreport
+    python3 Tools/mapReport.py "Paint Application/UserInterface/Build/Hex/Debug/userInterface.map"
+"""
+
+import argparse
+import re
+import sys
+
+REPORT_SECTIONS = (".text", ".ramfunc", ".data", ".bss", ".ahbbss", ".ahbram", ".heap", ".stack")
+LISTED_SECTIONS = (".ramfunc",)
+# Sections of the map which do not take memory of the target
+NOT_ALLOCATED = re.compile(r"^\.(debug|comment|stab|ARM\.attributes)")
+
+REGION = re.compile(r"^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT_SECTION = re.compile(r"^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?")
+INPUT_SECTION = re.compile(r"^ (\.\S+|COMMON)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_]\w*)\s*$")
+
+
+def join_lines(lines):
+    """Joins the lines of section names too long for their column with the line that follows."""
+    joined = []
+    pending = None
+    for line in lines:
+        line = line.rstrip("\r\n")
+        if pending is not None:
+            line = pending + " " + line.lstrip()
+            pending = None
+        elif re.match(r"^ ?(\.\S+|COMMON)$", line):
+            pending = line
+            continue
+        joined.append(line)
+    return joined
+
+
+def parse_map(lines):
+    """Returns the memory regions and the output sections, with the input sections and symbols of the listed ones."""
+    regions = []
+    sections = {}
+    state = None
+    current = None
+    for line in join_lines(lines):
+        if line.startswith("Memory Configuration"):
+            state = "memory"
+            continue
+        if line.startswith("Linker script and memory map"):
+            state = "map"
+            continue
+        if state == "memory":
+            match = REGION.match(line)
+            if match and match.group(1) != "Name":
+                regions.append((match.group(1), int(match.group(2), 16), int(match.group(3), 16)))
+            continue
+        if state != "map":
+            continue
+
+        match = OUTPUT_SECTION.match(line)
+        if match:
+            name = match.group(1)
+            load = int(match.group(4), 16) if match.group(4) else None
+            current = {"address": int(match.group(2), 16), "size": int(match.group(3), 16), "load": load,
+                       "inputs": [], "symbols": []}
+            sections.setdefault(name, current)
+            current = current if name in LISTED_SECTIONS else None
+            continue
+        if current is None:
+            continue
+        match = INPUT_SECTION.match(line)
+        if match:
+            if int(match.group(3), 16) != 0:
+                current["inputs"].append((match.group(4).strip(), int(match.group(3), 16)))
+            continue
+        match = SYMBOL.match(line)
+        if match:
+            current["symbols"].append((int(match.group(1), 16), match.group(2)))
+    return regions, sections
+
+
+def region_usage(regions, sections):
+    """Returns the bytes used in each region, by run address and by load address."""
+    usage = dict((name, 0) for name, _, _ in regions)
+    for name, section in sections.items():
+        if NOT_ALLOCATED.match(name) or section["size"] == 0:
+            continue
+        addresses = [section["address"]]
+        if section["load"] is not None and section["load"] != section["address"]:
+            addresses.append(section["load"])
+        for address in addresses:
+            for region, origin, length in regions:
+                if region != "*default*" and origin <= address < origin + length:
+                    usage[region] += section["size"]
+                    break
+    return usage
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", help="map file written by the linker (-Wl,-Map=...)")
+    args = parser.parse_args()
+
+    try:
+        with open(args.map) as mapfile:
+            regions, sections = parse_map(mapfile)
+    except IOError as error:
+        sys.exit("mapReport: %s" % error)
+    if not regions:
+        sys.exit("mapReport: %s has no memory configuration, is it a GNU ld map file?" % args.map)
+
+    print("%-10s %10s %10s %8s" % ("Memory", "Used", "Size", "Use"))
+    usage = region_usage(regions, sections)
+    for region, origin, length in regions:
+        if region == "*default*":
+            continue
+        print("%-10s %10u %10u %7.1f%%" % (region, usage[region], length, 100.0 * usage[region] / length))
+
+    print("")
+    print("%-14s %10s %8s %10s" % ("Section", "Address", "Size", "Load"))
+    for name in REPORT_SECTIONS:
+        section = sections.get(name)
+        if section is None:
+            print("%-14s %10s" % (name, "-"))
+            continue
+        load = "0x%08x" % section["load"] if section["load"] is not None else ""
+        print("%-14s 0x%08x %8u %10s" % (name, section["address"], section["size"], load))
+
+    for name in LISTED_SECTIONS:
+        section = sections.get(name)
+        if section is None or section["size"] == 0:
+            continue
+        print("")
+        print("%s contents:" % name)
+        for source, size in section["inputs"]:
+            print("  %8u  %s" % (size, source))
+        for address, symbol in sorted(section["symbols"]):
+            print("  0x%08x  %s" % (address, symbol))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Decodes the binary trace records sent by the trace logger (Source/AppHelper/trace.c).
+
+The event table is generated from the TRACE_EVENT() lines of Include/traceEvents.h, ids being
+numbered in the order of the lines. Bytes which are not part of a record, such as DEBUG_WRITE
+messages, are printed as text.
+
+    stty -F /dev/ttyUSB0 115200 raw && python3 Tools/traceDecode.py /dev/ttyUSB0
+    python3 Tools/traceDecode.py capture.bin --clock 100000000
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+TRACE_SYNC = 0xA5
+TRACE_ID_DROPPED = 0xFFFF
+RECORD = struct.Struct("<BBHIII")
+
+EVENTS_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Include", "traceEvents.h")
+
+
+def load_events(path):
+    """Returns the list of (name, format) in id order."""
+    with open(path) as header:
+        text = header.read()
+    return re.findall(r'TRACE_EVENT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)
+
+
+def format_event(events, event_id, arg1, arg2):
+    if event_id == TRACE_ID_DROPPED:
+        return "%u events dropped, %u in total" % (arg1, arg2)
+    if event_id >= len(events):
+        return "unknown event %u (%u, %u)" % (event_id, arg1, arg2)
+    name, fmt = events[event_id]
+    # Formats take up to two integer arguments
+    count = len(re.findall(r"%[^%]", fmt.replace("%%", "")))
+    return "%s: %s" % (name, fmt % (arg1, arg2)[:count])
+
+
+def decode(stream, events, clock, out):
+    pending = b""
+    text = bytearray()
+    last_sequence = None
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        pending += chunk
+        while len(pending) >= RECORD.size:
+            if pending[0] != TRACE_SYNC:
+                text.append(pending[0])
+                pending = pending[1:]
+                continue
+            sync, sequence, event_id, timestamp, arg1, arg2 = RECORD.unpack_from(pending)
+            if event_id != TRACE_ID_DROPPED and event_id >= len(events):
+                # A sync byte inside text
+                text.append(pending[0])
+                pending = pending[1:]
+                continue
+            if text:
+                out.write(text.decode("ascii", "replace").rstrip("\n") + "\n")
+                text.clear()
+            if event_id != TRACE_ID_DROPPED:
+                if last_sequence is not None and sequence != (last_sequence + 1) & 0xFF:
+                    out.write("-- %u records lost --\n" % ((sequence - last_sequence - 1) & 0xFF))
+                last_sequence = sequence
+            out.write("%12.6f  %s\n" % (timestamp / clock, format_event(events, event_id, arg1, arg2)))
+            out.flush()
+            pending = pending[RECORD.size:]
+    text += pending
+    if text:
+        out.write(text.decode("ascii", "replace") + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode trace logger records")
+    parser.add_argument("input", help="serial device or capture file, - for stdin")
+    parser.add_argument("--events", default=EVENTS_HEADER, help="event table header (default: %(default)s)")
+    parser.add_argument("--clock", type=float, default=100e6, help="timestamp ticks per second (default: CPU clock)")
+    args = parser.parse_args()
+
+    events = load_events(args.events)
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb", buffering=0)
+    try:
+        decode(stream, events, args.clock, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()